@@ -0,0 +1,67 @@
+import { createAnalyticsTask } from '../src/tasks/analytics';
+
+const SAMPLES = 600_000;
+
+// Welford, as the native reduction does it.
+const welford = (values: Float64Array | Float32Array | number[]) => {
+  let mean = 0;
+  let m2 = 0;
+  for (let i = 0; i < values.length; i++) {
+    const delta = values[i] - mean;
+    mean += delta / (i + 1);
+    m2 += delta * (values[i] - mean);
+  }
+  const count = values.length;
+  return {
+    count,
+    mean,
+    variance: m2 / count,
+    sampleVariance: m2 / (count - 1),
+    stdDev: Math.sqrt(m2 / count),
+  };
+};
+
+describe('createAnalyticsTask', () => {
+  afterEach(() => {
+    globalThis.nativeStats = undefined;
+    globalThis.reportProgress = undefined;
+  });
+
+  it('reduces with nativeStats.moments when the worker provides it', () => {
+    const moments = jest.fn(welford);
+    globalThis.nativeStats = { sum: jest.fn(), moments };
+
+    const summary = createAnalyticsTask()();
+
+    expect(moments).toHaveBeenCalledTimes(1);
+    const [values] = moments.mock.calls[0];
+    expect(values).toBeInstanceOf(Float64Array);
+    expect(values.length).toBe(SAMPLES);
+    expect(summary).toMatch(/^📊 mean=-?\d+\.\d{4} σ=\d+\.\d{4} drift=\d+\.\d{2}$/);
+
+    // The JS fallback computes the same summary.
+    globalThis.nativeStats = undefined;
+    expect(createAnalyticsTask()()).toBe(summary);
+  });
+
+  it('reports progress up to completion on the fallback path', () => {
+    const progress: number[] = [];
+    globalThis.reportProgress = (value) => progress.push(value);
+
+    createAnalyticsTask()();
+
+    expect(progress[progress.length - 1]).toBe(1);
+    expect([...progress].sort((a, b) => a - b)).toEqual(progress);
+  });
+
+  it('ships a worker source that matches the function', () => {
+    const task = createAnalyticsTask();
+    const source = task.__threadforgeSource;
+    expect(source).toContain('globalThis.nativeStats.moments(values)');
+
+    // Release builds run this text in the worker instead of fn.toString().
+    const fromSource = (0, eval)(`(${source})`) as () => string;
+    globalThis.nativeStats = { sum: jest.fn(), moments: jest.fn(welford) };
+    expect(fromSource()).toBe(task());
+  });
+});
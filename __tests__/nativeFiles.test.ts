@@ -0,0 +1,171 @@
+import '../src/tasks/threadHelpers';
+
+type NativeFiles = NonNullable<typeof globalThis.nativeFiles>;
+
+// An in-memory nativeFiles with the declared shape. Like the native reader, lines() may hand out
+// short batches (it stops at each mapping window), so callers must loop until an empty batch.
+const createMemoryFiles = (entries: Record<string, string>, window = 3): NativeFiles => {
+  const files = new Map(Object.entries(entries));
+  const encoder = new TextEncoder();
+  const resolve = (path: string) => {
+    const resolved = path.startsWith('/') ? path : `/documents/${path}`;
+    if (!resolved.startsWith('/documents/') && !resolved.startsWith('/cache/')) {
+      throw new Error(`'${path}' is outside the app's file roots`);
+    }
+    return resolved;
+  };
+  const read = (path: string) => {
+    const text = files.get(resolve(path));
+    if (text === undefined) {
+      throw new Error(`${path}: No such file or directory`);
+    }
+    return text;
+  };
+  const asText = (data: string | ArrayBuffer | ArrayBufferView) =>
+    typeof data === 'string'
+      ? data
+      : ArrayBuffer.isView(data)
+        ? Buffer.from(data.buffer, data.byteOffset, data.byteLength).toString()
+        : Buffer.from(data).toString();
+
+  return {
+    roots: { documents: '/documents', cache: '/cache' },
+    resolve,
+    stat: path => {
+      const text = files.get(resolve(path));
+      return { exists: text !== undefined, directory: false, size: text?.length ?? 0, modified: 0 };
+    },
+    map: path => encoder.encode(read(path)).slice().buffer,
+    readText: read,
+    lines: path => {
+      const text = read(path);
+      const all = text === '' ? [] : text.replace(/\n$/, '').split(/\r?\n/);
+      let next = 0;
+      return {
+        size: text.length,
+        position: () => Math.min(text.length, all.slice(0, next).join('\n').length + next),
+        next: (count = 1024) => {
+          const batch = all.slice(next, next + Math.min(count, window));
+          next += batch.length;
+          return batch;
+        },
+        close: () => undefined,
+      };
+    },
+    chunks: (path, chunkSize = 1 << 20) => {
+      const bytes = encoder.encode(read(path));
+      let offset = 0;
+      return {
+        size: bytes.length,
+        position: () => offset,
+        next: () => {
+          if (offset >= bytes.length) {
+            return null;
+          }
+          const chunk = bytes.subarray(offset, offset + chunkSize);
+          offset += chunk.length;
+          return chunk;
+        },
+        close: () => undefined,
+      };
+    },
+    writeFile: (path, data) => {
+      files.set(resolve(path), asText(data));
+      return asText(data).length;
+    },
+    appendFile: (path, data) => {
+      files.set(resolve(path), (files.get(resolve(path)) ?? '') + asText(data));
+      return asText(data).length;
+    },
+    createWriter: (path, options) => {
+      const existing = options?.append ? files.get(resolve(path)) ?? '' : '';
+      let pending = '';
+      let open = true;
+      // Counts only this writer's bytes, like the native writer.
+      return {
+        write: data => {
+          pending += asText(data);
+          return pending.length;
+        },
+        commit: () => {
+          if (open) {
+            files.set(resolve(path), existing + pending);
+            open = false;
+          }
+          return pending.length;
+        },
+        abandon: () => {
+          open = false;
+        },
+      };
+    },
+  };
+};
+
+// The worker-side patterns from the README's "Worker file access" section.
+const countErrors = () => {
+  const lines = globalThis.nativeFiles!.lines('logs/app.log');
+  let errors = 0;
+  try {
+    for (let batch = lines.next(5000); batch.length > 0; batch = lines.next(5000)) {
+      errors += batch.filter(line => line.startsWith('ERROR')).length;
+    }
+  } finally {
+    lines.close();
+  }
+  return errors;
+};
+
+const checksum = (path: string, chunkSize: number) => {
+  const chunks = globalThis.nativeFiles!.chunks(path, chunkSize);
+  let sum = 0;
+  for (let chunk = chunks.next(); chunk; chunk = chunks.next()) {
+    sum = chunk.reduce((total, byte) => (total + byte) % 65521, sum);
+  }
+  return sum;
+};
+
+describe('nativeFiles worker surface', () => {
+  afterEach(() => {
+    globalThis.nativeFiles = undefined;
+  });
+
+  it('reads every line even when batches come back short', () => {
+    const log = Array.from({ length: 20 }, (_, i) => (i % 4 === 0 ? `ERROR ${i}` : `INFO ${i}`)).join('\r\n');
+    globalThis.nativeFiles = createMemoryFiles({ '/documents/logs/app.log': `${log}\n` });
+    expect(countErrors()).toBe(5);
+  });
+
+  it('walks chunks until next() returns null', () => {
+    const text = 'abcdefghij'.repeat(7);
+    globalThis.nativeFiles = createMemoryFiles({ '/cache/blob.bin': text });
+    const expected = Array.from(Buffer.from(text)).reduce((total, byte) => (total + byte) % 65521, 0);
+    expect(checksum('/cache/blob.bin', 16)).toBe(expected);
+    expect(checksum('/cache/blob.bin', 1000)).toBe(expected);
+  });
+
+  it('replaces a file only when the writer commits', () => {
+    const files = createMemoryFiles({ '/documents/report.csv': 'old\n' });
+    globalThis.nativeFiles = files;
+
+    const abandoned = files.createWriter('report.csv');
+    abandoned.write('id,total\n');
+    abandoned.abandon();
+    expect(files.readText('report.csv')).toBe('old\n');
+
+    const out = files.createWriter('report.csv', { append: true });
+    out.write('id,total\n');
+    expect(out.write(new Uint8Array(Buffer.from('1,2\n')))).toBe(13);
+    expect(out.commit()).toBe(13);
+    expect(files.readText('report.csv')).toBe('old\nid,total\n1,2\n');
+    expect(files.writeFile('summary.json', JSON.stringify({ ok: true }))).toBe(11);
+    expect(files.stat('summary.json')).toMatchObject({ exists: true, size: 11 });
+  });
+
+  it('keeps paths inside the roots', () => {
+    const files = createMemoryFiles({});
+    expect(files.resolve('a/b.txt')).toBe(`${files.roots.documents}/a/b.txt`);
+    expect(() => files.resolve('/etc/passwd')).toThrow("outside the app's file roots");
+    expect(files.stat('missing.txt').exists).toBe(false);
+  });
+});
@@ -0,0 +1,88 @@
+import { createHash, type Hash } from 'crypto';
+
+import '../src/tasks/threadHelpers';
+
+type NativeHash = NonNullable<typeof globalThis.nativeHash>;
+type FileData = Parameters<NativeHash['hash']>[1];
+
+// Compile-time checks: `tsc` fails if the declared overloads drift from the documented encodings.
+const expectType = <T>(value: T) => value;
+
+const toBuffer = (data: FileData) =>
+  typeof data === 'string'
+    ? Buffer.from(data)
+    : ArrayBuffer.isView(data)
+      ? Buffer.from(data.buffer, data.byteOffset, data.byteLength)
+      : Buffer.from(data);
+
+// SHA-256 from Node's crypto, behind the nativeHash surface. Hashers copy their state for digest(),
+// which leaves the stream open as the native hashers do.
+const createSha256Hash = (): NativeHash => {
+  const encode = (hash: Hash, encoding?: 'hex' | 'bytes') =>
+    encoding === 'bytes' ? new Uint8Array(hash.digest()) : hash.digest('hex');
+  const createHasher = () => {
+    let state = createHash('sha256');
+    return {
+      update(data: FileData) {
+        state.update(toBuffer(data));
+        return this;
+      },
+      digest: (options?: { encoding?: 'hex' | 'bytes' }) => encode(state.copy(), options?.encoding),
+      reset: () => {
+        state = createHash('sha256');
+      },
+    };
+  };
+  return {
+    hash: (_algorithm: string, data: FileData, options?: { encoding?: 'hex' | 'bytes' }) =>
+      encode(createHash('sha256').update(toBuffer(data)), options?.encoding),
+    hashFile: () => {
+      throw new Error('no files in this test');
+    },
+    createHasher,
+    implementation: () => 'portable',
+  } as unknown as NativeHash;
+};
+
+const ABC_SHA256 = 'ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad';
+
+describe('nativeHash worker surface', () => {
+  afterEach(() => {
+    globalThis.nativeHash = undefined;
+  });
+
+  it('returns hex by default and bytes on request', () => {
+    const hash = createSha256Hash();
+    const hex = expectType<string>(hash.hash('sha256', 'abc'));
+    const bytes = expectType<Uint8Array>(hash.hash('sha256', new TextEncoder().encode('abc'), { encoding: 'bytes' }));
+    expect(hex).toBe(ABC_SHA256);
+    expect(bytes).toHaveLength(32);
+    // Big-endian digests: the hex form is the bytes in order.
+    expect(Buffer.from(bytes).toString('hex')).toBe(hex);
+    expect(hash.hash('sha256', new TextEncoder().encode('xabcx').subarray(1, 4))).toBe(ABC_SHA256);
+
+    expectType<string>(hash.hash('xxh64', 'abc', { seed: 7 }));
+    expectType<'sse4.2' | 'armv8-crc' | 'sha-ni' | 'armv8-sha2' | 'portable'>(hash.implementation('crc32c'));
+    // @ts-expect-error md5 is not offered.
+    expect(() => hash.hashFile('md5', 'a.bin')).toThrow();
+  });
+
+  it('streams chunks into a hasher that stays open after digest()', () => {
+    globalThis.nativeHash = createSha256Hash();
+    const text = 'threadforge '.repeat(1000);
+    const bytes = new TextEncoder().encode(text);
+
+    // The README's chunked pattern, with 4 KiB views over one buffer.
+    const hasher = globalThis.nativeHash.createHasher('sha256');
+    for (let offset = 0; offset < bytes.length; offset += 4096) {
+      expectType<ReturnType<NativeHash['createHasher']>>(hasher.update(bytes.subarray(offset, offset + 4096)));
+    }
+    const digest = expectType<Uint8Array>(hasher.digest({ encoding: 'bytes' }));
+    expect(Buffer.from(digest).toString('hex')).toBe(globalThis.nativeHash.hash('sha256', text));
+
+    hasher.update('!');
+    expect(hasher.digest()).toBe(globalThis.nativeHash.hash('sha256', `${text}!`));
+    hasher.reset();
+    expect(hasher.update('abc').digest()).toBe(ABC_SHA256);
+  });
+});
@@ -0,0 +1,168 @@
+import '../src/tasks/threadHelpers';
+
+type NativeIO = NonNullable<typeof globalThis.nativeIO>;
+type ReadRequest = string | { path: string; offset?: number; length?: number };
+
+// A scripted nativeIO. Requests finish in reverse order, one per tick(), and the results stay in
+// request order, as in the native engine. wait() throws for failures and hands out results once.
+const createScriptedIO = (files: Record<string, string>, events: string[]) => {
+  const pending: Array<() => void> = [];
+  const tick = () => pending.pop()?.();
+
+  const batch = <Item>(count: number, run: (index: number) => Item) => {
+    const results: Array<Item | Error | undefined> = new Array(count);
+    let left = count;
+    let taken = false;
+    for (let i = 0; i < count; ++i) {
+      pending.push(() => {
+        try {
+          results[i] = run(i);
+        } catch (error) {
+          results[i] = error as Error;
+        }
+        left -= 1;
+      });
+    }
+    const finish = (timeoutMs?: number) => {
+      while (left > 0 && timeoutMs === undefined) {
+        tick();
+      }
+      if (left > 0) {
+        return undefined;
+      }
+      if (taken) {
+        throw new Error("nativeIO: this batch's results were already taken");
+      }
+      return results as Array<Item | Error>;
+    };
+    return {
+      size: count,
+      done: () => left === 0,
+      wait: (timeoutMs?: number) => {
+        const settled = finish(timeoutMs);
+        const failures = settled?.filter(result => result instanceof Error) ?? [];
+        if (failures.length > 0) {
+          const more = failures.length > 1 ? ` (and ${failures.length - 1} more failures)` : '';
+          throw new Error(`nativeIO: ${failures[0]!.message}${more}`);
+        }
+        taken = settled !== undefined;
+        return settled as Item[] | undefined;
+      },
+      settle: (timeoutMs?: number) => {
+        const settled = finish(timeoutMs);
+        taken = settled !== undefined;
+        return settled;
+      },
+    };
+  };
+
+  const readOne = (request: ReadRequest) => {
+    const { path, offset = 0, length } = typeof request === 'string' ? { path: request } : request;
+    events.push(`read ${path}`);
+    const text = files[path];
+    if (text === undefined) {
+      throw new Error(`cannot open ${path}: No such file or directory`);
+    }
+    return text.slice(offset, length === undefined ? undefined : offset + length);
+  };
+
+  const io = {
+    backend: () => 'threads' as const,
+    read: (requests: ReadRequest[], options?: { text: true }) => {
+      events.push(`submit ${requests.length}`);
+      return options?.text
+        ? batch(requests.length, i => readOne(requests[i]!))
+        : batch(requests.length, i => new Uint8Array(Buffer.from(readOne(requests[i]!))));
+    },
+    write: (requests: Parameters<NativeIO['write']>[0]) =>
+      batch(requests.length, i => {
+        const { path, data, mode = 'replace' } = requests[i]!;
+        const text = typeof data === 'string' ? data : Buffer.from(data as Uint8Array).toString();
+        events.push(`write ${path}`);
+        files[path] = mode === 'append' ? (files[path] ?? '') + text : text;
+        return text.length;
+      }),
+  };
+  return { io: io as unknown as NativeIO, tick };
+};
+
+// The README's prefetch loop: the next day's read is in flight while the current day is summarized.
+const summarizeDays = (paths: string[]) => {
+  const io = globalThis.nativeIO!;
+  let [current] = io.read([paths[0]!], { text: true }).wait()!;
+  const totals: number[] = [];
+  for (let day = 0; day < paths.length; ++day) {
+    const next = day + 1 < paths.length ? io.read([paths[day + 1]!], { text: true }) : undefined;
+    totals.push((JSON.parse(current!) as number[]).reduce((sum, value) => sum + value, 0));
+    if (next) {
+      [current] = next.wait()!;
+    }
+  }
+  io.write([
+    { path: 'summary.json', data: JSON.stringify(totals) },
+    { path: 'log.csv', data: `${paths.length}\n`, mode: 'append' },
+  ]).wait();
+  return totals;
+};
+
+describe('nativeIO worker surface', () => {
+  afterEach(() => {
+    globalThis.nativeIO = undefined;
+  });
+
+  it('overlaps the next read with the current computation', () => {
+    const files: Record<string, string> = {
+      'day-1.json': '[1,2,3]',
+      'day-2.json': '[10]',
+      'day-3.json': '[]',
+      'log.csv': 'days\n',
+    };
+    const events: string[] = [];
+    globalThis.nativeIO = createScriptedIO(files, events).io;
+    const parse = JSON.parse;
+    const spy = jest.spyOn(JSON, 'parse').mockImplementation((text: string) => {
+      events.push('summarize');
+      return parse(text);
+    });
+
+    try {
+      expect(summarizeDays(['day-1.json', 'day-2.json', 'day-3.json'])).toEqual([6, 10, 0]);
+    } finally {
+      spy.mockRestore();
+    }
+    expect(files['summary.json']).toBe('[6,10,0]');
+    expect(files['log.csv']).toBe('days\n3\n');
+    expect(events.slice(0, 9)).toEqual([
+      'submit 1',
+      'read day-1.json',
+      'submit 1',
+      'summarize',
+      'read day-2.json',
+      'submit 1',
+      'summarize',
+      'read day-3.json',
+      'summarize',
+    ]);
+  });
+
+  it('keeps results in request order and reports failures per request', () => {
+    const { io, tick } = createScriptedIO({ 'a.txt': 'alpha', 'b.txt': 'bravo' }, []);
+
+    const reads = io.read(['a.txt', { path: 'b.txt', offset: 1, length: 3 }, 'c.txt', 'd.txt'], { text: true });
+    expect(reads.size).toBe(4);
+    expect(reads.wait(0)).toBeUndefined();
+    tick();
+    expect(reads.done()).toBe(false);
+    expect(() => reads.wait()).toThrow('nativeIO: cannot open c.txt: No such file or directory (and 1 more failures)');
+
+    const settled = reads.settle()!;
+    expect(settled.slice(0, 2)).toEqual(['alpha', 'rav']);
+    expect(settled[2]).toBeInstanceOf(Error);
+    expect((settled[3] as Error).message).toContain('d.txt');
+    expect(() => reads.settle()).toThrow('already taken');
+
+    const bytes = io.read(['a.txt']).wait()!;
+    expect(bytes[0]).toBeInstanceOf(Uint8Array);
+    expect(Buffer.from(bytes[0]!).toString()).toBe('alpha');
+  });
+});
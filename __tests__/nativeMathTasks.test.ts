@@ -0,0 +1,77 @@
+import { createAnalyticsTask } from '../src/tasks/analytics';
+import { createHeavyMathTask } from '../src/tasks/heavyMath';
+import { createImageProcessingTask } from '../src/tasks/imageProcessing';
+
+type Input = Float64Array | Float32Array | number;
+
+// Evaluates the expressions the demo tasks use with plain Math, element by
+// element, so the native path can be compared with the JS fallback.
+const compile = (expression: string) =>
+  new Function(
+    'x',
+    `return ${expression.replace(/\b(sin|cos|tan|sqrt|exp|log|abs|floor|min|max)\(/g, 'Math.$1(')};`,
+  ) as (x: number) => number;
+
+const valueAt = (input: Input, k: number) => (typeof input === 'number' ? k : input[k]);
+const lengthOf = (input: Input) => (typeof input === 'number' ? input : input.length);
+
+const installNativeMath = () => {
+  const map = jest.fn((expression: string, input: Input) => {
+    const f = compile(expression);
+    const out = new Float64Array(lengthOf(input));
+    for (let k = 0; k < out.length; k++) {
+      out[k] = f(valueAt(input, k));
+    }
+    return out;
+  });
+  const sum = jest.fn((expression: string, input: Input) => {
+    const f = compile(expression);
+    let total = 0;
+    for (let k = 0; k < lengthOf(input); k++) {
+      total += f(valueAt(input, k));
+    }
+    return total;
+  });
+  globalThis.nativeMath = { map, sum } as unknown as typeof globalThis.nativeMath;
+  return { map, sum };
+};
+
+const runFromSource = <T>(task: { __threadforgeSource?: string }): T =>
+  ((0, eval)(`(${task.__threadforgeSource})`) as () => T)();
+
+describe('demo tasks on nativeMath', () => {
+  afterEach(() => {
+    globalThis.nativeMath = undefined;
+  });
+
+  it('reduces the heavy math series over an index range', () => {
+    const fallback = createHeavyMathTask()();
+    const { sum, map } = installNativeMath();
+
+    const task = createHeavyMathTask();
+    expect(task()).toBe(fallback);
+    expect(sum).toHaveBeenCalledWith('sqrt(x)', 5_000_000);
+    expect(map).not.toHaveBeenCalled();
+    expect(runFromSource<string>(task)).toBe(fallback);
+  });
+
+  it('scores the image without materializing pixels', () => {
+    const fallback = createImageProcessingTask()();
+    const { sum, map } = installNativeMath();
+
+    const task = createImageProcessingTask();
+    expect(task()).toBe(fallback);
+    expect(sum).toHaveBeenCalledWith('sin(x) * cos(x / 10)', 2_000_000);
+    expect(map).not.toHaveBeenCalled();
+    expect(runFromSource<string>(task)).toBe(fallback);
+  });
+
+  it('generates the analytics waveform with map()', () => {
+    const fallback = createAnalyticsTask()();
+    const { map } = installNativeMath();
+
+    expect(createAnalyticsTask()()).toBe(fallback);
+    expect(map).toHaveBeenCalledTimes(1);
+    expect(map).toHaveBeenCalledWith('sin(x / 40) + cos(x / 23)', 600_000);
+  });
+});
@@ -0,0 +1,65 @@
+import { createSqliteHeavyOperationsTask } from '../src/tasks/sqlite';
+
+type Query = Parameters<NonNullable<typeof globalThis.nativeColumns>['aggregate']>[0];
+
+// Single-key group-by with sum / or, in row order, like the native engine's
+// output: one entry per non-empty group, ascending by key.
+const aggregateInJs = (query: Query) => {
+  const [groupBy] = query.groupBy ?? [];
+  const keyColumn = query.columns[groupBy!] as ArrayLike<number>;
+  const groups = new Map<number, Record<string, number>>();
+  for (let row = 0; row < keyColumn.length; row++) {
+    const key = keyColumn[row]!;
+    const group = groups.get(key) ?? {};
+    for (const [name, spec] of Object.entries(query.aggregates)) {
+      const [kind, column] = spec as [string, string];
+      const value = (query.columns[column] as ArrayLike<number>)[row]!;
+      group[name] = kind === 'or' ? (group[name] ?? 0) | value : (group[name] ?? 0) + value;
+    }
+    groups.set(key, group);
+  }
+  const keys = [...groups.keys()].sort((a, b) => a - b);
+  const values: Record<string, Float64Array> = {};
+  for (const name of Object.keys(query.aggregates)) {
+    values[name] = Float64Array.from(keys, (key) => groups.get(key)![name]!);
+  }
+  return { groups: keys.length, keys: { [groupBy!]: Float64Array.from(keys) }, values };
+};
+
+describe('createSqliteHeavyOperationsTask', () => {
+  afterEach(() => {
+    globalThis.nativeColumns = undefined;
+  });
+
+  it('aggregates typed columns with nativeColumns and matches the JS loops', () => {
+    const fallback = createSqliteHeavyOperationsTask()();
+    expect(fallback).toMatch(/^🏬 Categories: .+ \| 🏢 Segments: .+ \| 📅 Peak month: M\d+ \(\d+\) \| 🔁 Repeat: /);
+
+    const aggregate = jest.fn(aggregateInJs);
+    globalThis.nativeColumns = { aggregate } as unknown as typeof globalThis.nativeColumns;
+    expect(createSqliteHeavyOperationsTask()()).toBe(fallback);
+
+    expect(aggregate.mock.calls.map(([query]) => [query.groupBy, query.aggregates])).toEqual([
+      [['category'], { total: ['sum', 'amount'] }],
+      [['segment'], { total: ['sum', 'margin'] }],
+      [['month'], { total: ['sum', 'amount'] }],
+      [['customer'], { mask: ['or', 'monthBit'] }],
+    ]);
+    // Columns cross into the engine as typed arrays, never as row objects.
+    const { columns } = aggregate.mock.calls[0]![0];
+    for (const column of Object.values(columns)) {
+      expect(ArrayBuffer.isView(column)).toBe(true);
+      expect((column as ArrayLike<number>).length).toBe(120_000);
+    }
+  });
+
+  it('ships a worker source that takes the same native path', () => {
+    const task = createSqliteHeavyOperationsTask();
+    const aggregate = jest.fn(aggregateInJs);
+    globalThis.nativeColumns = { aggregate } as unknown as typeof globalThis.nativeColumns;
+
+    const fromSource = (0, eval)(`(${task.__threadforgeSource})`) as () => string;
+    expect(fromSource()).toBe(task());
+    expect(aggregate).toHaveBeenCalledTimes(8);
+  });
+});
@@ -0,0 +1,79 @@
+import { createSqliteOrderBatchTask, type SqliteOrderRow } from '../src/tasks/sqlite';
+
+const INSERT_SQL =
+  'INSERT INTO orders (orderId, customerId, category, segment, createdMonth, amount, margin) VALUES (?, ?, ?, ?, ?, ?, ?)';
+
+const installNativeSqlite = (runBatch: jest.Mock = jest.fn()) => {
+  const statement = { runBatch };
+  const db = { prepare: jest.fn(() => statement), close: jest.fn() };
+  const open = jest.fn(() => db);
+  globalThis.nativeSqlite = { open } as unknown as typeof globalThis.nativeSqlite;
+  return { open, db, runBatch };
+};
+
+const options = { batchSize: 250, batchIndex: 2, totalBatches: 8 };
+
+describe('createSqliteOrderBatchTask', () => {
+  afterEach(() => {
+    globalThis.nativeSqlite = undefined;
+  });
+
+  it('returns row objects without a database', () => {
+    const rows = createSqliteOrderBatchTask(options)() as SqliteOrderRow[];
+
+    expect(rows).toHaveLength(250);
+    expect(rows[0]!.orderId).toBe(501);
+    expect(rows[249]!.orderId).toBe(750);
+    expect(createSqliteOrderBatchTask(options)()).toEqual(rows);
+  });
+
+  it('inserts the same rows from the worker through nativeSqlite', () => {
+    const rows = createSqliteOrderBatchTask(options)() as SqliteOrderRow[];
+    const { open, db, runBatch } = installNativeSqlite();
+
+    expect(createSqliteOrderBatchTask({ ...options, database: 'orders.db' })()).toEqual({ inserted: 250 });
+
+    expect(open).toHaveBeenCalledWith('orders.db');
+    expect(db.prepare).toHaveBeenCalledWith(INSERT_SQL);
+    expect(runBatch).toHaveBeenCalledTimes(1);
+    // One positional parameter set per row, in column order, in a single batch.
+    expect(runBatch.mock.calls[0][0]).toEqual(
+      rows.map((row) => [
+        row.orderId,
+        row.customerId,
+        row.category,
+        row.segment,
+        row.createdMonth,
+        row.amount,
+        row.margin,
+      ]),
+    );
+    expect(db.close).toHaveBeenCalledTimes(1);
+  });
+
+  it('closes the connection when the batch fails', () => {
+    const { db } = installNativeSqlite(
+      jest.fn(() => {
+        throw new Error('UNIQUE constraint failed: orders.orderId');
+      }),
+    );
+
+    expect(() => createSqliteOrderBatchTask({ ...options, database: 'orders.db' })()).toThrow('UNIQUE constraint');
+    expect(db.close).toHaveBeenCalledTimes(1);
+  });
+
+  it('falls back to returning rows when the worker has no nativeSqlite', () => {
+    expect(createSqliteOrderBatchTask({ ...options, database: 'orders.db' })()).toHaveLength(250);
+  });
+
+  it('embeds the database name in the worker source', () => {
+    const task = createSqliteOrderBatchTask({ ...options, database: "it's.db" });
+    expect(task.__threadforgeSource).toContain(`const database = "it's.db";`);
+    const { open, runBatch } = installNativeSqlite();
+
+    const fromSource = (0, eval)(`(${task.__threadforgeSource})`) as () => unknown;
+    expect(fromSource()).toEqual({ inserted: 250 });
+    expect(open).toHaveBeenCalledWith("it's.db");
+    expect(runBatch.mock.calls[0][0]).toHaveLength(250);
+  });
+});
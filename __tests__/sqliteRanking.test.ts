@@ -0,0 +1,49 @@
+import { createSqliteHeavyOperationsTask } from '../src/tasks/sqlite';
+
+// nativeSort.topK semantics: the k largest first unless { descending: false },
+// NaN last, ties in index order.
+const topKInJs = (values: ArrayLike<number>, k: number, options?: { descending?: boolean }) => {
+  const descending = options?.descending ?? true;
+  const rank = (value: number) => (Number.isNaN(value) ? Infinity : descending ? -value : value);
+  const order = Array.from(values, (_, index) => index).sort((a, b) => rank(values[a]!) - rank(values[b]!));
+  return Uint32Array.from(order.slice(0, k));
+};
+
+describe('SQLite analytics ranking', () => {
+  afterEach(() => {
+    globalThis.nativeSort = undefined;
+  });
+
+  it('stubs topK faithfully', () => {
+    expect(Array.from(topKInJs([3, NaN, 9, 3, 1], 3))).toEqual([2, 0, 3]);
+    expect(Array.from(topKInJs([3, NaN, 9, 3, 1], 3, { descending: false }))).toEqual([4, 0, 3]);
+    expect(Array.from(topKInJs([NaN, 2], 5))).toEqual([1, 0]);
+  });
+
+  it('ranks categories and segments with nativeSort.topK', () => {
+    const fallback = createSqliteHeavyOperationsTask()();
+
+    const topK = jest.fn(topKInJs);
+    globalThis.nativeSort = { topK } as unknown as typeof globalThis.nativeSort;
+    expect(createSqliteHeavyOperationsTask()()).toBe(fallback);
+
+    // Plain number arrays, k = 3, relying on topK's descending default.
+    expect(topK).toHaveBeenCalledTimes(2);
+    const [[categoryTotals, categoryK, categoryOptions], [segmentTotals, segmentK]] = topK.mock.calls;
+    expect(Array.isArray(categoryTotals)).toBe(true);
+    expect(categoryTotals).toHaveLength(6);
+    expect(segmentTotals).toHaveLength(4);
+    expect([categoryK, segmentK]).toEqual([3, 3]);
+    expect(categoryOptions).toBeUndefined();
+  });
+
+  it('keeps the ranking in the shipped worker source', () => {
+    const task = createSqliteHeavyOperationsTask();
+    const topK = jest.fn(topKInJs);
+    globalThis.nativeSort = { topK } as unknown as typeof globalThis.nativeSort;
+
+    const fromSource = (0, eval)(`(${task.__threadforgeSource})`) as () => string;
+    expect(fromSource()).toBe(task());
+    expect(topK).toHaveBeenCalledTimes(4);
+  });
+});
@@ -12,9 +12,17 @@ jest.mock('react-native', () => {
         runFunction: jest
           .fn()
           .mockResolvedValue(JSON.stringify({ status: 'ok', value: 42 })),
+        runKernel: jest
+          .fn()
+          .mockResolvedValue(JSON.stringify({ status: 'ok', value: [1, 2, 3] })),
         cancelTask: jest.fn().mockResolvedValue(true),
         getStats: jest.fn().mockResolvedValue({ threadCount: 4, pending: 0, active: 0 }),
         shutdown: jest.fn().mockResolvedValue(true),
+        setIdle: jest.fn().mockResolvedValue(true),
+        installBindings: jest.fn().mockReturnValue(false),
+        trimMemory: jest.fn().mockResolvedValue(
+          JSON.stringify({ bytesFreed: 2097152, workersReleased: 2, resultsDropped: 0, lowPriorityPaused: true }),
+        ),
       },
     },
     NativeEventEmitter: jest.fn().mockImplementation(() => ({
@@ -34,7 +42,7 @@ jest.mock('react-native', () => {
 
 const { NativeModules, __listeners } = jest.requireMock('react-native');
 
-import { threadForge, TaskPriority, ThreadForgeCancelledError } from '../src';
+import { threadForge, TaskPriority, ThreadForgeCancelledError, ThreadForgeTable } from '../src';
 
 describe('threadForge', () => {
   beforeEach(async () => {
@@ -55,6 +63,46 @@ describe('threadForge', () => {
     );
   });
 
+  it('forwards numeric priority levels clamped to 0-255', async () => {
+    await threadForge.runFunction('custom', () => 1, 200);
+    await threadForge.runFunction('above', () => 1, 300);
+    await threadForge.runFunction('idle', () => 1, TaskPriority.IDLE);
+
+    const priorities = NativeModules.ThreadForge.runFunction.mock.calls.map((call: any[]) => call[1]);
+    expect(priorities).toEqual([200, 255, TaskPriority.IDLE]);
+  });
+
+  it('keeps the numeric scale monotonic, with no aliases for the 1.1.x values 0, 1 and 2', async () => {
+    await expect(threadForge.runFunction('one', () => 21 * 2, 1)).resolves.toBe(42);
+    await threadForge.runFunction('zero', () => 1, 0);
+    await threadForge.runFunction('two', () => 1, 2);
+    await threadForge.runFunction('three', () => 1, 3);
+    await threadForge.runFunction('below-range', () => 1, -4);
+    await threadForge.runFunction('fraction', () => 1, 2.9);
+    await threadForge.runKernel('kernel', 'demo.sort', null, 1);
+
+    const priorities = NativeModules.ThreadForge.runFunction.mock.calls.map((call: any[]) => call[1]);
+    expect(priorities).toEqual([1, 0, 2, 3, 0, 2]);
+    expect(NativeModules.ThreadForge.runKernel.mock.calls[0][1]).toBe(1);
+  });
+
+  it('runs native kernels with JSON arguments', async () => {
+    const result = await threadForge.runKernel('sort', 'demo.sort', { values: [3, 1, 2] }, TaskPriority.HIGH);
+    expect(result).toEqual([1, 2, 3]);
+    expect(NativeModules.ThreadForge.runKernel).toHaveBeenCalledWith(
+      'sort',
+      TaskPriority.HIGH,
+      'demo.sort',
+      JSON.stringify({ values: [3, 1, 2] }),
+    );
+
+    NativeModules.ThreadForge.runKernel.mockResolvedValueOnce(
+      JSON.stringify({ status: 'error', message: 'Unknown ThreadForge kernel: missing' }),
+    );
+    await expect(threadForge.runKernel('missing', 'missing')).rejects.toThrow('Unknown ThreadForge kernel');
+    await expect(threadForge.runKernel('blank', ' ')).rejects.toThrow('kernel name');
+  });
+
   it('throws typed cancellation errors', async () => {
     NativeModules.ThreadForge.runFunction.mockResolvedValueOnce(
       JSON.stringify({ status: 'cancelled', message: 'stopped' }),
@@ -64,6 +112,54 @@ describe('threadForge', () => {
     );
   });
 
+  it('surfaces partial results on cancellation errors', async () => {
+    NativeModules.ThreadForge.runFunction.mockResolvedValueOnce(
+      JSON.stringify({ status: 'cancelled', message: 'stopped', partial: { best: 17 } }),
+    );
+    const error = await threadForge.runFunction('partial', () => 0).catch((err) => err);
+    expect(error).toBeInstanceOf(ThreadForgeCancelledError);
+    expect(error.hasPartialResult).toBe(true);
+    expect(error.partialResult).toEqual({ best: 17 });
+  });
+
+  it('decodes packed table results into row views', async () => {
+    const base64 = (array: ArrayBufferView) =>
+      Buffer.from(array.buffer, array.byteOffset, array.byteLength).toString('base64');
+    NativeModules.ThreadForge.runFunction.mockResolvedValueOnce(
+      JSON.stringify({
+        status: 'ok',
+        value: {
+          __threadforgeTable: 1,
+          length: 3,
+          columns: [
+            { name: 'id', type: 'Uint32Array', data: base64(new Uint32Array([7, 8, 70000])) },
+            { name: 'amount', type: 'Float64Array', data: base64(new Float64Array([1.5, -2, 0.1])) },
+            { name: 'kind', type: 'Uint8Array', data: base64(new Uint8Array([1, 0, 1])), dictionary: ['a', 'b'] },
+          ],
+        },
+      }),
+    );
+
+    const table = (await threadForge.runFunction('table', () => 0)) as unknown as ThreadForgeTable<{
+      id: number;
+      amount: number;
+      kind: string;
+    }>;
+    expect(table).toBeInstanceOf(ThreadForgeTable);
+    expect(table.length).toBe(3);
+    expect(table.row(2).id).toBe(70000);
+    expect(table.row(1).kind).toBe('a');
+    expect(table.column('amount')).toEqual(new Float64Array([1.5, -2, 0.1]));
+    expect(table.dictionary('kind')).toEqual(['a', 'b']);
+    expect(table.toArray()).toEqual([
+      { id: 7, amount: 1.5, kind: 'b' },
+      { id: 8, amount: -2, kind: 'a' },
+      { id: 70000, amount: 0.1, kind: 'b' },
+    ]);
+    expect(JSON.parse(JSON.stringify(Array.from(table)))).toEqual(table.toArray());
+    expect(() => table.row(3)).toThrow(RangeError);
+  });
+
   it('throws native errors with stack information', async () => {
     NativeModules.ThreadForge.runFunction.mockResolvedValueOnce(
       JSON.stringify({ status: 'error', message: 'boom', stack: 'trace' }),
@@ -119,6 +215,16 @@ describe('threadForge', () => {
     expect(stats).toEqual({ threadCount: 1, pending: 2, active: 3 });
   });
 
+  it('forwards bounded shutdown options and parses the report', async () => {
+    NativeModules.ThreadForge.shutdown.mockResolvedValueOnce(
+      '{"completed":1,"cancelled":2,"interrupted":1,"timedOut":true}',
+    );
+    const report = await threadForge.shutdown({ drainMs: 250, mode: 'interrupt' });
+    expect(NativeModules.ThreadForge.shutdown).toHaveBeenCalledWith(250, 2);
+    expect(report).toEqual({ completed: 1, cancelled: 2, interrupted: 1, timedOut: true });
+    expect(threadForge.isInitialized()).toBe(false);
+  });
+
   it('records package metadata for npm distribution', () => {
     // eslint-disable-next-line @typescript-eslint/no-var-requires
     const pkg = require('../package.json');
@@ -132,6 +238,109 @@ describe('threadForge', () => {
 
     await threadForge.initialize(Number.NaN, { progressThrottleMs: -10 });
 
-    expect(NativeModules.ThreadForge.initialize).toHaveBeenCalledWith(4, 0);
+    expect(NativeModules.ThreadForge.initialize).toHaveBeenCalledWith(
+      4,
+      0,
+      JSON.stringify({ persistQueue: false }),
+    );
+  });
+
+  it('forwards the persistent queue option to native code', async () => {
+    await threadForge.shutdown();
+    NativeModules.ThreadForge.initialize.mockClear();
+
+    await threadForge.initialize(2, { persistQueue: true });
+
+    expect(NativeModules.ThreadForge.initialize).toHaveBeenCalledWith(
+      2,
+      100,
+      JSON.stringify({ persistQueue: true }),
+    );
+  });
+
+  it('reconfigures a running engine without shutting it down', async () => {
+    await threadForge.initialize(2);
+    NativeModules.ThreadForge.initialize.mockClear();
+    NativeModules.ThreadForge.shutdown.mockClear();
+
+    await threadForge.initialize(6, { progressThrottleMs: 50, queueLimit: 32.7 });
+
+    expect(NativeModules.ThreadForge.shutdown).not.toHaveBeenCalled();
+    expect(NativeModules.ThreadForge.initialize).toHaveBeenCalledWith(
+      6,
+      50,
+      JSON.stringify({ persistQueue: false, queueLimit: 32 }),
+    );
+    expect(threadForge.isInitialized()).toBe(true);
+  });
+
+  it('forwards idle windows and frame budgets to native code', async () => {
+    await threadForge.initialize(2);
+
+    await threadForge.setIdle(true, { budgetMs: 12.8 });
+    await threadForge.setIdle(true);
+    await threadForge.setIdle(false, { budgetMs: 5 });
+
+    expect(NativeModules.ThreadForge.setIdle).toHaveBeenNthCalledWith(1, true, 12);
+    expect(NativeModules.ThreadForge.setIdle).toHaveBeenNthCalledWith(2, true, -1);
+    expect(NativeModules.ThreadForge.setIdle).toHaveBeenNthCalledWith(3, false, -1);
+  });
+
+  it('maps trim levels to native code and parses the report', async () => {
+    await threadForge.initialize(2);
+
+    const report = await threadForge.trimMemory('critical');
+
+    expect(NativeModules.ThreadForge.trimMemory).toHaveBeenCalledWith(3);
+    expect(report).toEqual({
+      bytesFreed: 2097152,
+      workersReleased: 2,
+      resultsDropped: 0,
+      lowPriorityPaused: true,
+    });
+  });
+
+  it('forwards CPU quotas and reports throttled time', async () => {
+    await threadForge.shutdown();
+    NativeModules.ThreadForge.initialize.mockClear();
+
+    await threadForge.initialize(2, { cpuQuotas: { low: { coreShare: 0.3, periodMs: 100 } } });
+
+    expect(NativeModules.ThreadForge.initialize).toHaveBeenCalledWith(
+      2,
+      100,
+      JSON.stringify({ persistQueue: false, cpuQuotas: { low: { coreShare: 0.3, periodMs: 100 } } }),
+    );
+
+    NativeModules.ThreadForge.getStats.mockResolvedValueOnce(
+      '{"threadCount":2,"pending":1,"active":1,"throttledMs":420}',
+    );
+    expect(await threadForge.getStats()).toEqual({ threadCount: 2, pending: 1, active: 1, throttledMs: 420 });
+  });
+
+  it('asks native code to size the pool from the CPU topology', async () => {
+    await threadForge.shutdown();
+    NativeModules.ThreadForge.initialize.mockClear();
+
+    await threadForge.initialize('auto', { minThreads: 2 });
+
+    expect(NativeModules.ThreadForge.initialize).toHaveBeenCalledWith(
+      0,
+      100,
+      JSON.stringify({ persistQueue: false, minThreads: 2 }),
+    );
+  });
+
+  it('forwards lazy worker options clamped to the thread count', async () => {
+    await threadForge.shutdown();
+    NativeModules.ThreadForge.initialize.mockClear();
+
+    await threadForge.initialize(3, { minThreads: 8, idleTimeoutMs: -5 });
+
+    expect(NativeModules.ThreadForge.initialize).toHaveBeenCalledWith(
+      3,
+      100,
+      JSON.stringify({ persistQueue: false, minThreads: 3, idleTimeoutMs: 0 }),
+    );
   });
 });
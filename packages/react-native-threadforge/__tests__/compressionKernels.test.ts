@@ -0,0 +1,79 @@
+jest.mock('react-native', () => ({
+  NativeModules: {
+    ThreadForge: {
+      initialize: jest.fn().mockResolvedValue(true),
+      installBindings: jest.fn().mockReturnValue(false),
+      runKernel: jest.fn(),
+    },
+  },
+  NativeEventEmitter: jest.fn().mockImplementation(() => ({ addListener: jest.fn() })),
+}));
+
+const { NativeModules } = jest.requireMock('react-native');
+
+import { TaskPriority, ThreadForgeCancelledError, ThreadForgeEngine } from '../src';
+
+type FileStats = { inputBytes: number; outputBytes: number };
+
+// Payloads as serializeTaskResult() writes them for the compression.* kernels.
+const ok = (stats: FileStats) => JSON.stringify({ status: 'ok', value: stats });
+const failed = (message: string) => JSON.stringify({ status: 'error', message });
+const cancelled = JSON.stringify({ status: 'cancelled', message: 'Task cancelled' });
+
+describe('compression file kernels', () => {
+  let engine: ThreadForgeEngine;
+
+  beforeEach(async () => {
+    NativeModules.ThreadForge.runKernel.mockReset();
+    engine = new ThreadForgeEngine();
+    await engine.initialize(2);
+  });
+
+  it('sends { source, destination, codec?, level? } and returns the byte counts', async () => {
+    NativeModules.ThreadForge.runKernel.mockResolvedValueOnce(ok({ inputBytes: 9437184, outputBytes: 1210034 }));
+
+    const stats = await engine.runKernel<FileStats>(
+      'pack-logs',
+      'compression.compressFile',
+      { source: 'logs/app.log', destination: 'logs/app.log.gz', level: 9 },
+      TaskPriority.LOW,
+    );
+    expect(stats).toEqual({ inputBytes: 9437184, outputBytes: 1210034 });
+
+    const [id, priority, name, argsJson] = NativeModules.ThreadForge.runKernel.mock.calls[0];
+    expect([id, priority, name]).toEqual(['pack-logs', TaskPriority.LOW, 'compression.compressFile']);
+    // Omitted options stay out of the JSON, so the kernel applies gzip and level 6 itself.
+    expect(JSON.parse(argsJson)).toEqual({ source: 'logs/app.log', destination: 'logs/app.log.gz', level: 9 });
+  });
+
+  it('drops undefined options instead of sending null', async () => {
+    NativeModules.ThreadForge.runKernel.mockResolvedValueOnce(ok({ inputBytes: 10, outputBytes: 30 }));
+    await engine.runKernel('unpack', 'compression.decompressFile', {
+      source: 'cache/model.bin.lz4',
+      destination: 'cache/model.bin',
+      codec: 'lz4',
+      level: undefined,
+    });
+    expect(NativeModules.ThreadForge.runKernel.mock.calls[0][3]).toBe(
+      '{"source":"cache/model.bin.lz4","destination":"cache/model.bin","codec":"lz4"}',
+    );
+  });
+
+  it('surfaces kernel errors and cancellation', async () => {
+    NativeModules.ThreadForge.runKernel
+      .mockResolvedValueOnce(failed('compression.decompressFile: gzip data is truncated'))
+      .mockResolvedValueOnce(failed('compression.compressFile expects { source, destination, codec?, level? }'))
+      .mockResolvedValueOnce(cancelled);
+
+    await expect(
+      engine.runKernel('bad-input', 'compression.decompressFile', { source: 'a.gz', destination: 'a' }),
+    ).rejects.toThrow('gzip data is truncated');
+    await expect(engine.runKernel('no-args', 'compression.compressFile')).rejects.toThrow(
+      'expects { source, destination',
+    );
+    await expect(
+      engine.runKernel('stopped', 'compression.compressFile', { source: 'big.bin', destination: 'big.bin.gz' }),
+    ).rejects.toBeInstanceOf(ThreadForgeCancelledError);
+    expect(JSON.parse(NativeModules.ThreadForge.runKernel.mock.calls[1][3])).toBeNull();
+  });
+});
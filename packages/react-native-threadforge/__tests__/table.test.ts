@@ -0,0 +1,174 @@
+import type { PackedTable, ThreadForgeTable as Table } from '../src/table';
+
+jest.mock('react-native', () => ({
+  NativeModules: {
+    ThreadForge: {
+      installBindings: jest.fn().mockReturnValue(false),
+    },
+  },
+}));
+
+const { NativeModules } = jest.requireMock('react-native');
+
+type TableModule = typeof import('../src/table');
+type Order = { id: number; amount: number; kind: string };
+
+// Each test gets a fresh module, since the JSI decoder install is attempted once per module.
+const loadTable = (): TableModule => {
+  let loaded: TableModule | undefined;
+  jest.isolateModules(() => {
+    loaded = require('../src/table');
+  });
+  return loaded!;
+};
+
+const base64 = (array: ArrayBufferView) =>
+  Buffer.from(array.buffer, array.byteOffset, array.byteLength).toString('base64');
+
+const orders = (): PackedTable<Order> => ({
+  __threadforgeTable: 1,
+  length: 3,
+  columns: [
+    { name: 'id', type: 'Uint32Array', data: base64(new Uint32Array([7, 8, 70_000])) },
+    { name: 'amount', type: 'Float64Array', data: base64(new Float64Array([1.5, -2, 0.1])) },
+    { name: 'kind', type: 'Uint8Array', data: base64(new Uint8Array([1, 0, 1])), dictionary: ['retail', 'online'] },
+  ],
+});
+
+describe('ThreadForgeTable', () => {
+  const globals = globalThis as { atob?: unknown; __threadforgeDecodeColumn?: unknown };
+  const originalAtob = globals.atob;
+
+  afterEach(() => {
+    globals.atob = originalAtob;
+    delete globals.__threadforgeDecodeColumn;
+    NativeModules.ThreadForge.installBindings.mockReset().mockReturnValue(false);
+  });
+
+  it.each([
+    ['atob', true],
+    ['the built-in base64 decoder', false],
+  ])('decodes columns with %s', (_, withAtob) => {
+    if (!withAtob) {
+      delete globals.atob;
+    }
+    const { ThreadForgeTable } = loadTable();
+    const table: Table<Order> = ThreadForgeTable.from(orders());
+
+    expect(table.length).toBe(3);
+    expect(table.columnNames).toEqual(['id', 'amount', 'kind']);
+    expect(table.column('id')).toEqual(new Uint32Array([7, 8, 70_000]));
+    expect(table.column('amount')).toBeInstanceOf(Float64Array);
+    expect(table.column('kind')).toEqual(new Uint8Array([1, 0, 1]));
+    expect(table.dictionary('kind')).toEqual(['retail', 'online']);
+    expect(table.dictionary('amount')).toBeUndefined();
+    expect(table.toArray()).toEqual([
+      { id: 7, amount: 1.5, kind: 'online' },
+      { id: 8, amount: -2, kind: 'retail' },
+      { id: 70_000, amount: 0.1, kind: 'online' },
+    ]);
+  });
+
+  it('reads row views lazily from the columns', () => {
+    const { ThreadForgeTable } = loadTable();
+    const table = ThreadForgeTable.from(orders());
+
+    const row = table.row(1);
+    expect(Object.keys(row)).toEqual([]);
+    expect(row.kind).toBe('retail');
+    // Views share the decoded columns, so writes to a column show through.
+    (table.column('amount') as Float64Array)[1] = 42;
+    expect(row.amount).toBe(42);
+    expect(JSON.stringify(row)).toBe('{"id":8,"amount":42,"kind":"retail"}');
+    expect([...table].map((view) => view.id)).toEqual([7, 8, 70_000]);
+
+    expect(() => table.row(3)).toThrow(RangeError);
+    expect(() => table.row(0.5)).toThrow('Row 0.5 is out of range for a table of 3 rows');
+    expect(() => table.column('missing' as keyof Order & string)).toThrow("ThreadForge table has no column 'missing'");
+  });
+
+  it('reads the missing-string code of a columns.ingest result as null', () => {
+    const { ThreadForgeTable } = loadTable();
+    // columns.ingest packs codes into the narrowest type and keeps its all-ones value for missing strings.
+    const packed: PackedTable<{ city: string | null; visits: number; rating: number }> = {
+      __threadforgeTable: 1,
+      length: 3,
+      columns: [
+        { name: 'city', type: 'Uint8Array', data: base64(new Uint8Array([0, 0xff, 1])), dictionary: ['Oslo', ''] },
+        { name: 'visits', type: 'Int32Array', data: base64(new Int32Array([3, -1, 0])) },
+        { name: 'rating', type: 'Float32Array', data: base64(new Float32Array([0.5, NaN, 2])) },
+      ],
+    };
+    const table = ThreadForgeTable.from(packed);
+
+    expect(table.row(1).city).toBeNull();
+    expect(table.value(2, 'city')).toBe('');
+    expect(table.row(1).rating).toBeNaN();
+    expect(table.toArray()).toEqual([
+      { city: 'Oslo', visits: 3, rating: 0.5 },
+      { city: null, visits: -1, rating: NaN },
+      { city: '', visits: 0, rating: 2 },
+    ]);
+    expect(JSON.stringify(table.row(1))).toBe('{"city":null,"visits":-1,"rating":null}');
+  });
+
+  it('rejects malformed columns', () => {
+    delete globals.atob;
+    const { ThreadForgeTable } = loadTable();
+    const withColumn = (column: PackedTable['columns'][number], length = 2): PackedTable => ({
+      __threadforgeTable: 1,
+      length,
+      columns: [column],
+    });
+
+    expect(() => ThreadForgeTable.from(withColumn({ name: 'a', type: 'BigInt64Array', data: '' }))).toThrow(
+      'Malformed ThreadForge table column of type BigInt64Array',
+    );
+    expect(() => ThreadForgeTable.from(withColumn({ name: 'a', type: 'Uint8Array', data: 'AAE' }))).toThrow(
+      'Malformed ThreadForge table column of type Uint8Array',
+    );
+    expect(() => ThreadForgeTable.from(withColumn({ name: 'a', type: 'Uint8Array', data: 'AA!=' }))).toThrow(
+      'Malformed ThreadForge table column of type Uint8Array',
+    );
+    expect(() => ThreadForgeTable.from(withColumn({ name: 'a', type: 'Uint16Array', data: 'AAAA' }))).toThrow(
+      'Malformed ThreadForge table column of type Uint16Array',
+    );
+    expect(() =>
+      ThreadForgeTable.from(withColumn({ name: 'a', type: 'Uint8Array', data: base64(new Uint8Array([1, 2, 3])) })),
+    ).toThrow("ThreadForge table column 'a' has 3 rows, expected 2");
+  });
+
+  it('decodes through the JSI helper once installBindings() installs it', () => {
+    const decode = jest.fn((data: string, type: string) => {
+      expect(type).toBe('Float64Array');
+      const bytes = Buffer.from(data, 'base64');
+      return new Float64Array(bytes.buffer.slice(bytes.byteOffset, bytes.byteOffset + bytes.length));
+    });
+    NativeModules.ThreadForge.installBindings.mockImplementation(() => {
+      globals.__threadforgeDecodeColumn = decode;
+      return true;
+    });
+    const { ThreadForgeTable } = loadTable();
+    const packed: PackedTable<{ x: number }> = {
+      __threadforgeTable: 1,
+      length: 2,
+      columns: [{ name: 'x', type: 'Float64Array', data: base64(new Float64Array([3, 4])) }],
+    };
+
+    expect(ThreadForgeTable.from(packed).toArray()).toEqual([{ x: 3 }, { x: 4 }]);
+    expect(ThreadForgeTable.from(packed).row(1).x).toBe(4);
+    expect(NativeModules.ThreadForge.installBindings).toHaveBeenCalledTimes(1);
+    expect(decode).toHaveBeenCalledTimes(2);
+  });
+
+  it('only settles values that are packed tables', () => {
+    const { settleTable, ThreadForgeTable } = loadTable();
+
+    expect(settleTable(orders())).toBeInstanceOf(ThreadForgeTable);
+    const lookalikes = [null, 3, 'table', [], { __threadforgeTable: 2, columns: [] }, { __threadforgeTable: 1 }];
+    for (const value of lookalikes) {
+      expect(settleTable(value)).toBe(value);
+    }
+    expect(NativeModules.ThreadForge.installBindings).toHaveBeenCalledTimes(1);
+  });
+});
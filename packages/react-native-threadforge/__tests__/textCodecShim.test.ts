@@ -0,0 +1,119 @@
+import { readFileSync } from 'fs';
+import { join } from 'path';
+import { TextDecoder as NodeTextDecoder, TextEncoder as NodeTextEncoder } from 'util';
+
+// The TextEncoder / TextDecoder shim that EncodingBindings.cpp evaluates in worker runtimes that
+// lack them, run here against a codec with the native one's shape.
+const shimSource = (): string => {
+  const bindings = readFileSync(join(__dirname, '../cpp/EncodingBindings.cpp'), 'utf8');
+  const match = /kTextCodecSource = R"JS\(([\s\S]*?)\)JS";/.exec(bindings);
+  if (!match) {
+    throw new Error('kTextCodecSource not found in EncodingBindings.cpp');
+  }
+  return match[1]!;
+};
+
+type Installer = (codec: object, global: Record<string, unknown>) => void;
+
+const createCodec = () => {
+  const calls: string[] = [];
+  const encoder = new NodeTextEncoder();
+  const codec = {
+    encode: (text: string) => encoder.encode(text),
+    encodeInto: (text: string, destination: Uint8Array) => encoder.encodeInto(text, destination),
+    createDecoder: (label: string, fatal: boolean, ignoreBOM: boolean) => {
+      calls.push(`createDecoder ${label} ${fatal} ${ignoreBOM}`);
+      const decoder = new NodeTextDecoder(label, { fatal, ignoreBOM });
+      return {
+        encoding: decoder.encoding,
+        fatal,
+        ignoreBOM,
+        decode: (input: ArrayBufferView | ArrayBuffer | undefined, stream: boolean) => {
+          calls.push(`decode ${input === undefined ? 'undefined' : input.constructor.name} ${stream}`);
+          return decoder.decode(input, { stream });
+        },
+      };
+    },
+  };
+  return { codec, calls };
+};
+
+const install = (global: Record<string, unknown>) => {
+  const { codec, calls } = createCodec();
+  // eslint-disable-next-line no-eval
+  const installer = (0, eval)(shimSource()) as Installer;
+  installer(codec, global);
+  return calls;
+};
+
+type Shim = {
+  TextEncoder: new () => {
+    encoding: string;
+    encode(input?: unknown): Uint8Array;
+    encodeInto: NodeTextEncoder['encodeInto'];
+  };
+  TextDecoder: new (
+    label?: string,
+    options?: { fatal?: boolean; ignoreBOM?: boolean },
+  ) => { encoding: string; fatal: boolean; ignoreBOM: boolean; decode(input?: unknown, options?: object): string };
+};
+
+describe('TextEncoder / TextDecoder shim', () => {
+  it('installs both classes only where they are missing', () => {
+    const empty: Record<string, unknown> = {};
+    install(empty);
+    expect(typeof empty.TextEncoder).toBe('function');
+    expect(typeof empty.TextDecoder).toBe('function');
+
+    const existing = function ExistingTextEncoder() {};
+    const partial: Record<string, unknown> = { TextEncoder: existing };
+    install(partial);
+    expect(partial.TextEncoder).toBe(existing);
+    expect(typeof partial.TextDecoder).toBe('function');
+  });
+
+  it('encodes strings through the codec', () => {
+    const global: Record<string, unknown> = {};
+    install(global);
+    const { TextEncoder } = global as unknown as Shim;
+
+    const encoder = new TextEncoder();
+    expect(encoder.encoding).toBe('utf-8');
+    expect(Array.from(encoder.encode('é€'))).toEqual([0xc3, 0xa9, 0xe2, 0x82, 0xac]);
+    expect(encoder.encode()).toHaveLength(0);
+    expect(Array.from(encoder.encode(42))).toEqual([0x34, 0x32]);
+    expect(encoder.encodeInto('ab€', new Uint8Array(4))).toEqual({ read: 2, written: 2 });
+    expect(() => (TextEncoder as unknown as () => void)()).toThrow("requires 'new'");
+  });
+
+  it('forwards labels, options and streaming to the native decoder', () => {
+    const global: Record<string, unknown> = {};
+    const calls = install(global);
+    const { TextDecoder } = global as unknown as Shim;
+
+    const decoder = new TextDecoder();
+    expect([decoder.encoding, decoder.fatal, decoder.ignoreBOM]).toEqual(['utf-8', false, false]);
+    expect(decoder.decode(new Uint8Array([0xf0, 0x9f]), { stream: true })).toBe('');
+    expect(decoder.decode(new Uint8Array([0x98, 0x80]))).toBe('😀');
+
+    // DataViews are passed on as Uint8Array views of the same bytes.
+    const bytes = new Uint8Array([0x78, 0x68, 0x69, 0x78]);
+    expect(decoder.decode(new DataView(bytes.buffer, 1, 2))).toBe('hi');
+    expect(decoder.decode()).toBe('');
+
+    const strict = new TextDecoder('utf-16le', { fatal: true, ignoreBOM: true });
+    expect([strict.encoding, strict.fatal, strict.ignoreBOM]).toEqual(['utf-16le', true, true]);
+    expect(strict.decode(new Uint8Array([0x68, 0x00, 0x69, 0x00]))).toBe('hi');
+    expect(() => (TextDecoder as unknown as () => void)()).toThrow("requires 'new'");
+
+    expect(calls).toEqual([
+      'createDecoder utf-8 false false',
+      'decode Uint8Array true',
+      'decode Uint8Array false',
+      'decode Uint8Array false',
+      'decode undefined false',
+      'createDecoder utf-16le true true',
+      'decode Uint8Array false',
+    ]);
+  });
+});
@@ -7,7 +7,13 @@
 #include <mutex>
 #include <string>
 
+#include "EngineConfig.h"
+#include "Files.h"
 #include "FunctionExecutor.h"
+#include "KernelRegistry.h"
+#include "PackedTableBindings.h"
+#include "SharedPool.h"
+#include "SqliteBindings.h"
 #include "TaskResult.h"
 #include "ThreadPool.h"
 #include "nlohmann/json.hpp"
@@ -19,7 +25,6 @@ namespace {
 std::chrono::milliseconds g_progressThrottle = std::chrono::milliseconds(100);
 std::mutex g_configMutex;
 
-ThreadPool* g_threadPool = nullptr;
 JavaVM* g_vm = nullptr;
 jclass g_moduleClass = nullptr;
 jmethodID g_emitProgress = nullptr;
@@ -69,14 +74,7 @@ private:
 };
 
 TaskPriority toTaskPriority(jint priority) {
-    switch (priority) {
-        case 2:
-            return TaskPriority::HIGH;
-        case 0:
-            return TaskPriority::LOW;
-        default:
-            return TaskPriority::NORMAL;
-    }
+    return toPriorityLevel(static_cast<int>(priority));
 }
 
 void dispatchProgress(const std::string& taskId, double progress) {
@@ -107,20 +105,107 @@ void dispatchProgress(const std::string& taskId, double progress) {
     }
 }
 
-void ensureThreadPool(size_t threadCount) {
-    if (g_threadPool) {
-        g_threadPool->shutdown();
-        delete g_threadPool;
-        g_threadPool = nullptr;
-    }
-    g_threadPool = new ThreadPool(threadCount);
-}
-
 std::chrono::milliseconds currentProgressThrottle() {
     std::lock_guard<std::mutex> lock(g_configMutex);
     return g_progressThrottle;
 }
 
+TaskFunction makeFunctionWork(const std::string& taskIdStr, const std::string& sourceStr) {
+    return [taskIdStr, sourceStr](const ProgressCallback& progressCallback,
+                                  const std::function<bool()>& isCancelled) {
+        ScopedJniEnv envScope(g_vm);
+        if (!envScope.valid()) {
+            return makeErrorResult("Unable to retrieve JNIEnv*.");
+        }
+        const auto throttle = currentProgressThrottle();
+        return runSerializedFunction(taskIdStr,
+                                     sourceStr,
+                                     progressCallback,
+                                     throttle,
+                                     isCancelled);
+    };
+}
+
+TaskFunction makeJniKernelWork(const std::string& name, const std::string& argsJson) {
+    return [name, argsJson](const ProgressCallback& progressCallback,
+                            const std::function<bool()>& isCancelled) {
+        return makeKernelWork(name, argsJson, currentProgressThrottle())(progressCallback, isCancelled);
+    };
+}
+
+std::string readJString(JNIEnv* env, jstring value) {
+    if (!value) {
+        return std::string();
+    }
+    const char* chars = env->GetStringUTFChars(value, nullptr);
+    std::string result(chars ? chars : "");
+    env->ReleaseStringUTFChars(value, chars);
+    return result;
+}
+
+ShutdownOptions toShutdownOptions(jint drainMs, jint mode) {
+    ShutdownOptions options;
+    options.drainTimeout = std::chrono::milliseconds(drainMs);
+    switch (mode) {
+        case 1:
+            options.mode = ShutdownMode::CANCEL_QUEUED;
+            break;
+        case 2:
+            options.mode = ShutdownMode::INTERRUPT_RUNNING;
+            break;
+        default:
+            options.mode = ShutdownMode::DRAIN;
+            break;
+    }
+    return options;
+}
+
+MemoryTrimLevel toMemoryTrimLevel(jint level) {
+    switch (level) {
+        case 3:
+            return MemoryTrimLevel::CRITICAL;
+        case 2:
+            return MemoryTrimLevel::LOW;
+        default:
+            return MemoryTrimLevel::MODERATE;
+    }
+}
+
+ShutdownReport shutdownThreadPool(const ShutdownOptions& options) {
+    ShutdownReport report;
+    auto pool = sharedThreadPool();
+    setSharedThreadPool(nullptr);
+    if (!pool) {
+        return report;
+    }
+
+    // A pool whose workers missed the deadline is never reused; dropping it here
+    // detaches them after a short grace period rather than waiting them out.
+    return pool->shutdown(options);
+}
+
+void ensureThreadPool(size_t threadCount, const EngineConfig& config) {
+    // Re-initializing reconfigures the live pool so queued and running tasks survive.
+    auto pool = sharedThreadPool();
+    if (!pool) {
+        pool = makeThreadPool(threadCount, config);
+        setSharedThreadPool(pool);
+    }
+
+    configureThreadPool(*pool, threadCount, config, [](const JournalEntry& entry) -> TaskFunction {
+        std::string source;
+        if (readFunctionJournalPayload(entry.payload, source)) {
+            return makeFunctionWork(entry.taskId, source);
+        }
+        std::string kernelName;
+        std::string argsJson;
+        if (readKernelJournalPayload(entry.payload, kernelName, argsJson)) {
+            return makeJniKernelWork(kernelName, argsJson);
+        }
+        return nullptr;
+    });
+}
+
 void setProgressThrottle(int throttleMs) {
     const int clamped = std::max(0, throttleMs);
     std::lock_guard<std::mutex> lock(g_configMutex);
@@ -128,13 +213,15 @@ void setProgressThrottle(int throttleMs) {
 }
 
 std::string makeStatsPayload() {
-    if (!g_threadPool) {
+    const auto pool = sharedThreadPool();
+    if (!pool) {
         return std::string("{\"threadCount\":0,\"pending\":0,\"active\":0}");
     }
     nlohmann::json json;
-    json["threadCount"] = g_threadPool->getThreadCount();
-    json["pending"] = g_threadPool->getPendingTaskCount();
-    json["active"] = g_threadPool->getActiveTaskCount();
+    json["threadCount"] = pool->getThreadCount();
+    json["pending"] = pool->getPendingTaskCount();
+    json["active"] = pool->getActiveTaskCount();
+    json["throttledMs"] = pool->getThrottledTime().count();
     return json.dump();
 }
 
@@ -152,29 +239,71 @@ Java_com_threadforge_ThreadForgeModule_nativeInitialize(
     JNIEnv* env,
     jobject,
     jint threadCount,
-    jint progressThrottleMs) {
+    jint progressThrottleMs,
+    jstring optionsJson,
+    jstring storageDirectory,
+    jstring databaseDirectory,
+    jstring cacheDirectory) {
     if (!g_vm && env) {
         JavaVM* vm = nullptr;
         if (env->GetJavaVM(&vm) == JNI_OK) {
             g_vm = vm;
         }
     }
+
+    const char* optionsChars = env->GetStringUTFChars(optionsJson, nullptr);
+    const char* storageChars = env->GetStringUTFChars(storageDirectory, nullptr);
+    const auto config = parseEngineConfig(optionsChars ? optionsChars : "",
+                                          storageChars ? storageChars : "");
+    env->ReleaseStringUTFChars(optionsJson, optionsChars);
+    env->ReleaseStringUTFChars(storageDirectory, storageChars);
+    const char* databaseChars = env->GetStringUTFChars(databaseDirectory, nullptr);
+    setSqliteDatabaseDirectory(databaseChars ? databaseChars : "");
+    env->ReleaseStringUTFChars(databaseDirectory, databaseChars);
+    // nativeFiles may touch the app's files and cache directories; relative
+    // paths land in the former.
+    const char* filesChars = env->GetStringUTFChars(storageDirectory, nullptr);
+    const char* cacheChars = env->GetStringUTFChars(cacheDirectory, nullptr);
+    files::setRoots({
+        {"documents", filesChars ? filesChars : ""},
+        {"cache", cacheChars ? cacheChars : ""},
+    });
+    env->ReleaseStringUTFChars(storageDirectory, filesChars);
+    env->ReleaseStringUTFChars(cacheDirectory, cacheChars);
+
     setProgressThrottle(static_cast<int>(progressThrottleMs));
-    ensureThreadPool(static_cast<size_t>(std::max(1, threadCount)));
+    // A thread count of 0 lets the CPU topology pick one.
+    ensureThreadPool(static_cast<size_t>(std::max(0, threadCount)), config);
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_threadforge_ThreadForgeModule_nativeShutdown(JNIEnv* env, jobject, jint drainMs, jint mode) {
+    const auto report = shutdownThreadPool(toShutdownOptions(drainMs, mode));
+    const auto payload = serializeShutdownReport(report);
+    return env->NewStringUTF(payload.c_str());
 }
 
 JNIEXPORT void JNICALL
-Java_com_threadforge_ThreadForgeModule_nativeShutdown(JNIEnv*, jobject) {
-    if (g_threadPool) {
-        g_threadPool->shutdown();
-        delete g_threadPool;
-        g_threadPool = nullptr;
+Java_com_threadforge_ThreadForgeModule_nativeSetIdle(JNIEnv*, jobject, jboolean idle, jint windowMs) {
+    if (const auto pool = sharedThreadPool()) {
+        pool->setIdle(idle == JNI_TRUE, std::chrono::milliseconds(windowMs));
     }
 }
 
+JNIEXPORT jstring JNICALL
+Java_com_threadforge_ThreadForgeModule_nativeTrimMemory(JNIEnv* env, jobject, jint level) {
+    MemoryTrimReport report;
+    if (const auto pool = sharedThreadPool()) {
+        report = pool->trimMemory(toMemoryTrimLevel(level));
+    }
+    const auto payload = serializeMemoryTrimReport(report);
+    return env->NewStringUTF(payload.c_str());
+}
+
 JNIEXPORT jstring JNICALL
 Java_com_threadforge_ThreadForgeModule_nativeRunFunction(JNIEnv* env, jobject, jstring taskId, jint priority, jstring source) {
-    if (!g_threadPool) {
+    const auto pool = sharedThreadPool();
+    if (!pool) {
         auto error = serializeTaskResult(makeErrorResult("ThreadForge is not initialized"));
         return env->NewStringUTF(error.c_str());
     }
@@ -194,23 +323,14 @@ Java_com_threadforge_ThreadForgeModule_nativeRunFunction(JNIEnv* env, jobject, j
             const double clamped = std::max(0.0, std::min(1.0, value));
             dispatchProgress(taskIdStr, clamped);
         };
-        auto work = [taskIdStr, sourceStr](const ProgressCallback& progressCallback,
-                                           const std::function<bool()>& isCancelled) {
-            ScopedJniEnv envScope(g_vm);
-            if (!envScope.valid()) {
-                return makeErrorResult("Unable to retrieve JNIEnv*.");
-            }
-            const auto throttle = currentProgressThrottle();
-            return runSerializedFunction(taskIdStr,
-                                         sourceStr,
-                                         progressCallback,
-                                         throttle,
-                                         isCancelled);
-        };
-        result = g_threadPool->submitTask(taskIdStr,
-                                          toTaskPriority(priority),
-                                          std::move(work),
-                                          progress);
+        auto journalPayload = pool->isJournaling()
+            ? makeFunctionJournalPayload(sourceStr)
+            : std::string();
+        result = pool->submitTask(taskIdStr,
+                                  toTaskPriority(priority),
+                                  makeFunctionWork(taskIdStr, sourceStr),
+                                  progress,
+                                  std::move(journalPayload));
     } catch (const std::exception& ex) {
         result = makeErrorResult(ex.what());
     } catch (...) {
@@ -221,9 +341,51 @@ Java_com_threadforge_ThreadForgeModule_nativeRunFunction(JNIEnv* env, jobject, j
     return env->NewStringUTF(payload.c_str());
 }
 
+JNIEXPORT jstring JNICALL
+Java_com_threadforge_ThreadForgeModule_nativeRunKernel(JNIEnv* env,
+                                                       jobject,
+                                                       jstring taskId,
+                                                       jint priority,
+                                                       jstring name,
+                                                       jstring argsJson) {
+    const auto pool = sharedThreadPool();
+    if (!pool) {
+        auto error = serializeTaskResult(makeErrorResult("ThreadForge is not initialized"));
+        return env->NewStringUTF(error.c_str());
+    }
+
+    const auto taskIdStr = readJString(env, taskId);
+    const auto nameStr = readJString(env, name);
+    const auto argsStr = readJString(env, argsJson);
+
+    TaskResult result;
+    try {
+        auto progress = [taskIdStr](double value) {
+            dispatchProgress(taskIdStr, std::max(0.0, std::min(1.0, value)));
+        };
+        auto journalPayload = pool->isJournaling()
+            ? makeKernelJournalPayload(nameStr, argsStr)
+            : std::string();
+        // No JNIEnv is attached here: kernels never call back into Java.
+        result = pool->submitTask(taskIdStr,
+                                  toTaskPriority(priority),
+                                  makeJniKernelWork(nameStr, argsStr),
+                                  progress,
+                                  std::move(journalPayload));
+    } catch (const std::exception& ex) {
+        result = makeErrorResult(ex.what());
+    } catch (...) {
+        result = makeErrorResult("Unknown error while executing ThreadForge kernel");
+    }
+
+    const auto payload = serializeTaskResult(result);
+    return env->NewStringUTF(payload.c_str());
+}
+
 JNIEXPORT jboolean JNICALL
 Java_com_threadforge_ThreadForgeModule_nativeCancelTask(JNIEnv* env, jobject, jstring taskId) {
-    if (!g_threadPool) {
+    const auto pool = sharedThreadPool();
+    if (!pool) {
         return JNI_FALSE;
     }
 
@@ -231,7 +393,7 @@ Java_com_threadforge_ThreadForgeModule_nativeCancelTask(JNIEnv* env, jobject, js
     std::string taskIdStr(taskIdChars ? taskIdChars : "");
     env->ReleaseStringUTFChars(taskId, taskIdChars);
 
-    return g_threadPool->cancelTask(taskIdStr) ? JNI_TRUE : JNI_FALSE;
+    return pool->cancelTask(taskIdStr) ? JNI_TRUE : JNI_FALSE;
 }
 
 JNIEXPORT jstring JNICALL
@@ -240,6 +402,12 @@ Java_com_threadforge_ThreadForgeModule_nativeGetStats(JNIEnv* env, jobject) {
     return env->NewStringUTF(payload.c_str());
 }
 
+JNIEXPORT void JNICALL
+Java_com_threadforge_ThreadForgeModule_nativeInstallBindings(JNIEnv*, jobject, jlong runtimePointer) {
+    // Called synchronously from the JS thread, the only thread allowed to touch the runtime.
+    installPackedTableDecoder(*reinterpret_cast<facebook::jsi::Runtime*>(runtimePointer));
+}
+
 JNIEXPORT void JNICALL
 Java_com_threadforge_ThreadForgeModule_nativeSetEventEmitter(JNIEnv* env, jobject thiz) {
     std::lock_guard<std::mutex> lock(g_emitterMutex);
@@ -1,6 +1,8 @@
 // Author: Abhishek Kumar <alexrus28996@gmail.com>
 package com.threadforge
 
+import android.content.ComponentCallbacks2
+import android.content.res.Configuration
 import android.os.Handler
 import android.os.Looper
 import android.util.Log
@@ -21,10 +23,27 @@ class ThreadForgeModule(private val appContext: ReactApplicationContext) :
 
     private val executor: ExecutorService = Executors.newCachedThreadPool()
     private val mainHandler = Handler(Looper.getMainLooper())
+    private val memoryCallbacks = object : ComponentCallbacks2 {
+        override fun onTrimMemory(level: Int) {
+            val trimLevel = toTrimLevel(level)
+            executor.execute { nativeTrimMemory(trimLevel) }
+        }
+
+        override fun onLowMemory() {
+            executor.execute { nativeTrimMemory(TRIM_LEVEL_CRITICAL) }
+        }
+
+        override fun onConfigurationChanged(newConfig: Configuration) = Unit
+    }
 
     companion object {
         const val NAME = "ThreadForge"
         private const val PROGRESS_EVENT = "threadforge_progress"
+        private const val SHUTDOWN_MODE_INTERRUPT = 2
+        private const val INVALIDATE_DRAIN_MS = 500
+        private const val TRIM_LEVEL_MODERATE = 1
+        private const val TRIM_LEVEL_LOW = 2
+        private const val TRIM_LEVEL_CRITICAL = 3
 
         private var reactContext: ReactApplicationContext? = null
         private val hermesCheckLock = Any()
@@ -76,6 +95,15 @@ class ThreadForgeModule(private val appContext: ReactApplicationContext) :
             }
         }
 
+        @Suppress("DEPRECATION")
+        private fun toTrimLevel(level: Int): Int = when {
+            level >= ComponentCallbacks2.TRIM_MEMORY_MODERATE ||
+                level == ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL -> TRIM_LEVEL_CRITICAL
+            level >= ComponentCallbacks2.TRIM_MEMORY_BACKGROUND ||
+                level == ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW -> TRIM_LEVEL_LOW
+            else -> TRIM_LEVEL_MODERATE
+        }
+
         @JvmStatic
         fun setReactContext(context: ReactApplicationContext?) {
             reactContext = context
@@ -99,6 +127,10 @@ class ThreadForgeModule(private val appContext: ReactApplicationContext) :
 
     override fun invalidate() {
         super.invalidate()
+        appContext.unregisterComponentCallbacks(memoryCallbacks)
+        // The JS context is going away, so nobody is left to receive results:
+        // interrupt running work and tear the pool down within a bounded time.
+        nativeShutdown(INVALIDATE_DRAIN_MS, SHUTDOWN_MODE_INTERRUPT)
         executor.shutdownNow()
         mainHandler.removeCallbacksAndMessages(null)
         nativeClearEventEmitter()
@@ -109,15 +141,24 @@ class ThreadForgeModule(private val appContext: ReactApplicationContext) :
         requireHermes()
         setReactContext(appContext)
         nativeSetEventEmitter()
+        appContext.registerComponentCallbacks(memoryCallbacks)
     }
 
     @ReactMethod
-    fun initialize(threadCount: Int, progressThrottleMs: Int, promise: Promise) {
+    fun initialize(threadCount: Int, progressThrottleMs: Int, optionsJson: String?, promise: Promise) {
         try {
             requireHermes()
-            val sanitizedThreadCount = if (threadCount < 1) 1 else threadCount
+            // 0 asks native code to size the pool from the CPU topology.
+            val sanitizedThreadCount = if (threadCount < 0) 0 else threadCount
             val sanitizedThrottle = if (progressThrottleMs < 0) 0 else progressThrottleMs
-            nativeInitialize(sanitizedThreadCount, sanitizedThrottle)
+            nativeInitialize(
+                sanitizedThreadCount,
+                sanitizedThrottle,
+                optionsJson ?: "{}",
+                appContext.filesDir.absolutePath,
+                databaseDirectory(),
+                appContext.cacheDir.absolutePath,
+            )
             promise.resolve(true)
         } catch (e: Exception) {
             promise.reject("INIT_ERROR", e.message, e)
@@ -137,6 +178,18 @@ class ThreadForgeModule(private val appContext: ReactApplicationContext) :
         }
     }
 
+    @ReactMethod
+    fun runKernel(taskId: String, priority: Int, name: String, argsJson: String?, promise: Promise) {
+        executor.execute {
+            try {
+                val result = nativeRunKernel(taskId, priority, name, argsJson ?: "null")
+                deliverPromise { promise.resolve(result) }
+            } catch (e: Exception) {
+                deliverPromise { promise.reject("TASK_ERROR", e.message, e) }
+            }
+        }
+    }
+
     @ReactMethod
     fun cancelTask(taskId: String, promise: Promise) {
         try {
@@ -156,6 +209,7 @@ class ThreadForgeModule(private val appContext: ReactApplicationContext) :
                 putInt("threadCount", json.optInt("threadCount"))
                 putInt("pending", json.optInt("pending"))
                 putInt("active", json.optInt("active"))
+                putDouble("throttledMs", json.optDouble("throttledMs", 0.0))
             }
             promise.resolve(map)
         } catch (e: Exception) {
@@ -164,15 +218,55 @@ class ThreadForgeModule(private val appContext: ReactApplicationContext) :
     }
 
     @ReactMethod
-    fun shutdown(promise: Promise) {
+    fun shutdown(drainMs: Int, mode: Int, promise: Promise) {
+        // Without a deadline the drain lasts as long as the queue, so it must not
+        // hold the native-module thread.
+        executor.execute {
+            try {
+                val report = nativeShutdown(drainMs, mode)
+                deliverPromise { promise.resolve(report) }
+            } catch (e: Exception) {
+                deliverPromise { promise.reject("SHUTDOWN_ERROR", e.message, e) }
+            }
+        }
+    }
+
+    @ReactMethod
+    fun setIdle(idle: Boolean, windowMs: Int, promise: Promise) {
         try {
-            nativeShutdown()
+            nativeSetIdle(idle, windowMs)
             promise.resolve(true)
         } catch (e: Exception) {
-            promise.reject("SHUTDOWN_ERROR", e.message, e)
+            promise.reject("IDLE_ERROR", e.message, e)
         }
     }
 
+    @ReactMethod
+    fun trimMemory(level: Int, promise: Promise) {
+        executor.execute {
+            try {
+                val report = nativeTrimMemory(level)
+                deliverPromise { promise.resolve(report) }
+            } catch (e: Exception) {
+                deliverPromise { promise.reject("TRIM_ERROR", e.message, e) }
+            }
+        }
+    }
+
+    /**
+     * Installs the JSI helpers the JS side uses to decode packed table results. Runs on the JS
+     * thread; returns false when the runtime is not reachable (e.g. remote debugging).
+     */
+    @ReactMethod(isBlockingSynchronousMethod = true)
+    fun installBindings(): Boolean {
+        val runtimePointer = appContext.javaScriptContextHolder?.get() ?: 0L
+        if (runtimePointer == 0L) {
+            return false
+        }
+        nativeInstallBindings(runtimePointer)
+        return true
+    }
+
     @ReactMethod
     fun addListener(eventName: String) {
         // Required for RN EventEmitter compatibility. No-op because events are
@@ -184,6 +278,13 @@ class ThreadForgeModule(private val appContext: ReactApplicationContext) :
         // Required for RN EventEmitter compatibility.
     }
 
+    // Where react-native-sqlite-storage keeps its databases, so nativeSqlite opens the same files by name.
+    private fun databaseDirectory(): String {
+        val directory = appContext.getDatabasePath("threadforge").parentFile ?: return ""
+        directory.mkdirs()
+        return directory.absolutePath
+    }
+
     private fun deliverPromise(action: () -> Unit) {
         val deliver = Runnable {
             try {
@@ -199,11 +300,27 @@ class ThreadForgeModule(private val appContext: ReactApplicationContext) :
         }
     }
 
-    private external fun nativeInitialize(threadCount: Int, progressThrottleMs: Int)
+    private external fun nativeInitialize(
+        threadCount: Int,
+        progressThrottleMs: Int,
+        optionsJson: String,
+        storageDirectory: String,
+        databaseDirectory: String,
+        cacheDirectory: String,
+    )
     private external fun nativeRunFunction(taskId: String, priority: Int, source: String): String
+    private external fun nativeRunKernel(
+        taskId: String,
+        priority: Int,
+        name: String,
+        argsJson: String,
+    ): String
     private external fun nativeCancelTask(taskId: String): Boolean
     private external fun nativeGetStats(): String
+    private external fun nativeInstallBindings(runtimePointer: Long)
     private external fun nativeSetEventEmitter()
     private external fun nativeClearEventEmitter()
-    private external fun nativeShutdown()
+    private external fun nativeShutdown(drainMs: Int, mode: Int): String
+    private external fun nativeTrimMemory(level: Int): String
+    private external fun nativeSetIdle(idle: Boolean, windowMs: Int)
 }
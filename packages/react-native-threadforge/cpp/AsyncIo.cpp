@@ -0,0 +1,525 @@
+#include "AsyncIo.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define THREADFORGE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__ANDROID__)
+#include <android/api-level.h>
+#endif
+#else
+#define THREADFORGE_IO_URING 0
+#endif
+
+namespace threadforge::io {
+
+namespace {
+
+// One request moves at most this much, which keeps every transfer within the
+// int an io_uring completion reports.
+constexpr uint64_t kMaxTransfer = uint64_t{1} << 30;
+constexpr size_t kIoThreads = 4;
+constexpr unsigned kRingEntries = 128;
+
+std::atomic<bool> gUringDisabled{false};
+
+// Opens the request's file and sizes its read buffer. -1 once the request has
+// been failed instead.
+int openRequest(Batch& batch, size_t index) {
+    auto& request = batch.request(index);
+    if (request.operation == Operation::WRITE) {
+        int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+        if (request.mode == WriteMode::REPLACE) {
+            flags |= O_TRUNC;
+        } else if (request.mode == WriteMode::APPEND) {
+            flags |= O_APPEND;
+        }
+        const int fd = ::open(request.path.c_str(), flags, 0644);
+        if (fd < 0) {
+            batch.fail(index, errno, "cannot write");
+        } else if (request.data.size() > kMaxTransfer) {
+            ::close(fd);
+            batch.fail(index, EFBIG, "cannot write");
+            return -1;
+        }
+        return fd;
+    }
+    const int fd = ::open(request.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        batch.fail(index, errno, "cannot open");
+        return -1;
+    }
+    struct stat status {};
+    if (::fstat(fd, &status) != 0) {
+        const int error = errno;
+        ::close(fd);
+        batch.fail(index, error, "cannot stat");
+        return -1;
+    }
+    const auto size = static_cast<uint64_t>(status.st_size);
+    const uint64_t available = size > request.offset ? size - request.offset : 0;
+    const uint64_t wanted = request.length == 0 ? available : std::min(request.length, available);
+    if (wanted > kMaxTransfer) {
+        ::close(fd);
+        batch.fail(index, EFBIG, "cannot read");
+        return -1;
+    }
+    batch.result(index).data.resize(static_cast<size_t>(wanted));
+    return fd;
+}
+
+// Where the request's bytes start in the file.
+uint64_t startPosition(const Request& request) {
+    if (request.operation == Operation::READ || request.mode == WriteMode::OVERWRITE) {
+        return request.offset;
+    }
+    return 0;
+}
+
+class Engine {
+public:
+    virtual ~Engine() = default;
+    virtual const char* name() const = 0;
+    virtual void start(const std::shared_ptr<Batch>& batch) = 0;
+};
+
+// Blocking pread/pwrite on a few threads of its own, so slow storage never
+// occupies compute workers.
+class ThreadEngine : public Engine {
+public:
+    explicit ThreadEngine(size_t threads) {
+        for (size_t i = 0; i < threads; ++i) {
+            std::thread([this] { run(); }).detach();
+        }
+    }
+
+    const char* name() const override {
+        return "threads";
+    }
+
+    void start(const std::shared_ptr<Batch>& batch) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t i = 0; i < batch->requests().size(); ++i) {
+                queue_.emplace_back(batch, i);
+            }
+        }
+        condition_.notify_all();
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            condition_.wait(lock, [this] { return !queue_.empty(); });
+            auto [batch, index] = std::move(queue_.front());
+            queue_.pop_front();
+            lock.unlock();
+            perform(*batch, index);
+            lock.lock();
+        }
+    }
+
+    static void perform(Batch& batch, size_t index) {
+        const int fd = openRequest(batch, index);
+        if (fd < 0) {
+            return;
+        }
+        const auto& request = batch.request(index);
+        auto& result = batch.result(index);
+        const bool reading = request.operation == Operation::READ;
+        const size_t size = reading ? result.data.size() : request.data.size();
+        const uint64_t start = startPosition(request);
+        while (result.transferred < size) {
+            const auto done = static_cast<size_t>(result.transferred);
+            const auto position = static_cast<off_t>(start + done);
+            ssize_t count;
+            if (reading) {
+                count = ::pread(fd, result.data.data() + done, size - done, position);
+            } else if (request.mode == WriteMode::APPEND) {
+                count = ::write(fd, request.data.data() + done, size - done);
+            } else {
+                count = ::pwrite(fd, request.data.data() + done, size - done, position);
+            }
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count < 0 || (count == 0 && !reading)) {
+                const int error = count < 0 ? errno : EIO;
+                ::close(fd);
+                batch.fail(index, error, reading ? "cannot read" : "cannot write");
+                return;
+            }
+            if (count == 0) {
+                // The file shrank since it was opened.
+                result.data.resize(static_cast<size_t>(result.transferred));
+                break;
+            }
+            result.transferred += static_cast<uint64_t>(count);
+        }
+        ::close(fd);
+        batch.settle(index);
+    }
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<std::pair<std::shared_ptr<Batch>, size_t>> queue_;
+};
+
+#if THREADFORGE_IO_URING
+
+bool uringAllowed() {
+#if defined(__ANDROID__)
+    // Older releases' app seccomp filter kills the process on io_uring_setup
+    // instead of failing it.
+    return android_get_device_api_level() >= 31;
+#else
+    return true;
+#endif
+}
+
+int uringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int uringEnter(int fd, unsigned submit, unsigned wait, unsigned flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, submit, wait, flags, nullptr, 0));
+}
+
+// One ring for the process. Submitters queue requests and push as many as
+// the ring has room for; a reaper thread waits for completions, resubmits
+// short transfers and tops the ring up from the queue. Requests in flight are
+// capped at the submission queue size, so neither queue can overflow.
+class UringEngine : public Engine {
+public:
+    static UringEngine* create(unsigned entries) {
+        io_uring_params params{};
+        const int fd = uringSetup(entries, &params);
+        if (fd < 0) {
+            return nullptr;
+        }
+        auto* engine = new UringEngine(fd, params);
+        if (!engine->mapped()) {
+            delete engine;
+            return nullptr;
+        }
+        std::thread([engine] { engine->reap(); }).detach();
+        return engine;
+    }
+
+    ~UringEngine() override {
+        if (sqRing_ != MAP_FAILED) {
+            ::munmap(sqRing_, sqRingSize_);
+        }
+        if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_) {
+            ::munmap(cqRing_, cqRingSize_);
+        }
+        if (sqes_ != MAP_FAILED) {
+            ::munmap(sqes_, sqesSize_);
+        }
+        ::close(fd_);
+    }
+
+    const char* name() const override {
+        return "io_uring";
+    }
+
+    void start(const std::shared_ptr<Batch>& batch) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < batch->requests().size(); ++i) {
+            pending_.emplace_back(batch, i);
+        }
+        pump();
+        flush();
+    }
+
+private:
+    struct InFlight {
+        std::shared_ptr<Batch> batch;
+        size_t index;
+        int fd;
+        iovec vector;
+        uint64_t position;
+    };
+
+    UringEngine(int fd, const io_uring_params& params)
+        : fd_(fd),
+          capacity_(params.sq_entries),
+          sqRingSize_(params.sq_off.array + params.sq_entries * sizeof(unsigned)),
+          cqRingSize_(params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe)),
+          sqesSize_(params.sq_entries * sizeof(io_uring_sqe)) {
+        const bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) {
+            sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+        }
+        sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        cqRing_ = single || sqRing_ == MAP_FAILED
+            ? sqRing_
+            : ::mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        sqes_ = ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (!mapped()) {
+            return;
+        }
+        auto* sq = static_cast<uint8_t*>(sqRing_);
+        sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        auto* cq = static_cast<uint8_t*>(cqRing_);
+        cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    bool mapped() const {
+        return sqRing_ != MAP_FAILED && cqRing_ != MAP_FAILED && sqes_ != MAP_FAILED;
+    }
+
+    // Opens queued requests while the ring has room. Caller holds mutex_.
+    void pump() {
+        while (!pending_.empty() && inFlight_ < capacity_) {
+            auto [batch, index] = std::move(pending_.front());
+            pending_.pop_front();
+            const int fd = openRequest(*batch, index);
+            if (fd < 0) {
+                continue;
+            }
+            auto& request = batch->request(index);
+            const bool reading = request.operation == Operation::READ;
+            auto& bytes = reading ? batch->result(index).data : request.data;
+            if (bytes.empty()) {
+                ::close(fd);
+                batch->settle(index);
+                continue;
+            }
+            auto* operation = new InFlight{batch, index, fd, {bytes.data(), bytes.size()}, startPosition(request)};
+            push(operation);
+            ++inFlight_;
+        }
+    }
+
+    // Queues one submission entry. Caller holds mutex_.
+    void push(InFlight* operation) {
+        const unsigned tail = *sqTail_;
+        const unsigned slot = tail & sqMask_;
+        auto& sqe = static_cast<io_uring_sqe*>(sqes_)[slot];
+        std::memset(&sqe, 0, sizeof(sqe));
+        const bool reading = operation->batch->request(operation->index).operation == Operation::READ;
+        sqe.opcode = reading ? IORING_OP_READV : IORING_OP_WRITEV;
+        sqe.fd = operation->fd;
+        sqe.addr = reinterpret_cast<uint64_t>(&operation->vector);
+        sqe.len = 1;
+        sqe.off = operation->position;
+        sqe.user_data = reinterpret_cast<uint64_t>(operation);
+        sqArray_[slot] = slot;
+        __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+        ++unsubmitted_;
+    }
+
+    // Hands queued entries to the kernel. Caller holds mutex_.
+    void flush() {
+        while (unsubmitted_ > 0) {
+            const int submitted = uringEnter(fd_, unsubmitted_, 0, 0);
+            if (submitted < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                // EAGAIN / EBUSY: the reaper retries after its next completion.
+                return;
+            }
+            unsubmitted_ -= static_cast<unsigned>(submitted);
+        }
+    }
+
+    void reap() {
+        std::vector<io_uring_cqe> completions;
+        while (true) {
+            if (uringEnter(fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            unsigned head = *cqHead_;
+            const unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+            completions.clear();
+            for (; head != tail; ++head) {
+                completions.push_back(cqes_[head & cqMask_]);
+            }
+            __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+            if (completions.empty()) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& completion : completions) {
+                complete(reinterpret_cast<InFlight*>(completion.user_data), completion.res);
+            }
+            pump();
+            flush();
+        }
+    }
+
+    // Caller holds mutex_.
+    void complete(InFlight* operation, int result) {
+        auto& batch = *operation->batch;
+        const auto index = operation->index;
+        const bool reading = batch.request(index).operation == Operation::READ;
+        if (result == -EINTR || result == -EAGAIN) {
+            push(operation);
+            return;
+        }
+        if (result < 0 || (result == 0 && !reading)) {
+            ::close(operation->fd);
+            batch.fail(index, result < 0 ? -result : EIO, reading ? "cannot read" : "cannot write");
+        } else {
+            auto& transferred = batch.result(index).transferred;
+            transferred += static_cast<uint64_t>(result);
+            if (result > 0 && static_cast<size_t>(result) < operation->vector.iov_len) {
+                // Short transfer: carry on from where it stopped.
+                operation->vector.iov_base = static_cast<uint8_t*>(operation->vector.iov_base) + result;
+                operation->vector.iov_len -= static_cast<size_t>(result);
+                operation->position += static_cast<uint64_t>(result);
+                push(operation);
+                return;
+            }
+            if (result == 0) {
+                // The file shrank since it was opened.
+                batch.result(index).data.resize(static_cast<size_t>(transferred));
+            }
+            ::close(operation->fd);
+            batch.settle(index);
+        }
+        delete operation;
+        --inFlight_;
+    }
+
+    int fd_;
+    unsigned capacity_;
+    size_t sqRingSize_;
+    size_t cqRingSize_;
+    size_t sqesSize_;
+    void* sqRing_{MAP_FAILED};
+    void* cqRing_{MAP_FAILED};
+    void* sqes_{MAP_FAILED};
+    unsigned* sqHead_{nullptr};
+    unsigned* sqTail_{nullptr};
+    unsigned sqMask_{0};
+    unsigned* sqArray_{nullptr};
+    unsigned* cqHead_{nullptr};
+    unsigned* cqTail_{nullptr};
+    unsigned cqMask_{0};
+    io_uring_cqe* cqes_{nullptr};
+
+    std::mutex mutex_;
+    std::deque<std::pair<std::shared_ptr<Batch>, size_t>> pending_;
+    unsigned inFlight_{0};
+    unsigned unsubmitted_{0};
+};
+
+#endif // THREADFORGE_IO_URING
+
+Engine& engine() {
+    // Leaked on purpose: the I/O threads outlive static destruction.
+    static Engine* instance = []() -> Engine* {
+#if THREADFORGE_IO_URING
+        if (!gUringDisabled.load() && uringAllowed()) {
+            if (auto* uring = UringEngine::create(kRingEntries)) {
+                return uring;
+            }
+        }
+#endif
+        return new ThreadEngine(kIoThreads);
+    }();
+    return *instance;
+}
+
+} // namespace
+
+Batch::Batch(std::vector<Request> requests)
+    : requests_(std::move(requests)),
+      results_(requests_.size()),
+      remaining_(requests_.size()),
+      done_(requests_.empty()) {}
+
+bool Batch::isDone() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return done_;
+}
+
+void Batch::wait() const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this] { return done_; });
+}
+
+bool Batch::waitFor(std::chrono::milliseconds timeout) const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return condition_.wait_for(lock, timeout, [this] { return done_; });
+}
+
+WaitStatus Batch::waitFor(std::chrono::milliseconds timeout, const std::function<bool()>& isCancelled) const {
+    const bool bounded = timeout != std::chrono::milliseconds::max();
+    const auto deadline = std::chrono::steady_clock::now() + (bounded ? timeout : std::chrono::milliseconds(0));
+    while (true) {
+        auto slice = kCancelPoll;
+        if (bounded) {
+            const auto left =
+                std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            slice = std::clamp(left, std::chrono::milliseconds(0), kCancelPoll);
+        }
+        if (waitFor(slice)) {
+            return WaitStatus::DONE;
+        }
+        if (isCancelled && isCancelled()) {
+            return WaitStatus::CANCELLED;
+        }
+        if (bounded && std::chrono::steady_clock::now() >= deadline) {
+            return WaitStatus::TIMED_OUT;
+        }
+    }
+}
+
+void Batch::settle(size_t) {
+    if (remaining_.fetch_sub(1) == 1) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_ = true;
+        }
+        condition_.notify_all();
+    }
+}
+
+void Batch::fail(size_t index, int error, const std::string& action) {
+    auto& result = results_[index];
+    result.error = error;
+    result.message = action + " " + requests_[index].path + ": " + std::strerror(error);
+    result.data.clear();
+    settle(index);
+}
+
+std::shared_ptr<Batch> submit(std::vector<Request> requests) {
+    auto batch = std::make_shared<Batch>(std::move(requests));
+    if (!batch->requests().empty()) {
+        engine().start(batch);
+    }
+    return batch;
+}
+
+const char* backend() {
+    return engine().name();
+}
+
+void disableUring() {
+    gUringDisabled.store(true);
+}
+
+} // namespace threadforge::io
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace threadforge::io {
+
+enum class Operation : uint8_t {
+    READ,
+    WRITE
+};
+
+enum class WriteMode : uint8_t {
+    // Truncate (or create) the file and write from the start.
+    REPLACE,
+    // Write at the end of the file, creating it if needed.
+    APPEND,
+    // Write at offset without truncating.
+    OVERWRITE
+};
+
+// How often a cancellable wait looks at its cancellation flag.
+constexpr std::chrono::milliseconds kCancelPoll{20};
+
+// How a cancellable wait ended.
+enum class WaitStatus : uint8_t {
+    DONE,
+    TIMED_OUT,
+    CANCELLED
+};
+
+struct Request {
+    Operation operation{Operation::READ};
+    std::string path;
+    // READ: first byte. WRITE: where OVERWRITE starts.
+    uint64_t offset{0};
+    // READ: bytes wanted, 0 = to the end of the file.
+    uint64_t length{0};
+    // WRITE: the bytes to write.
+    std::vector<uint8_t> data;
+    WriteMode mode{WriteMode::REPLACE};
+};
+
+struct Result {
+    // errno of the failure, 0 on success; message names the path.
+    int error{0};
+    std::string message;
+    // READ: the bytes read, short only when the file ends first.
+    std::vector<uint8_t> data;
+    uint64_t transferred{0};
+};
+
+// Requests submitted together. Each one settles on its own; the batch is done
+// once all of them have.
+class Batch {
+public:
+    explicit Batch(std::vector<Request> requests);
+
+    bool isDone() const;
+    void wait() const;
+    // False when the batch is still running after timeout.
+    bool waitFor(std::chrono::milliseconds timeout) const;
+    // Also gives up once isCancelled() returns true, checked every kCancelPoll.
+    // milliseconds::max() waits without a deadline. The requests keep running
+    // either way; only the wait ends.
+    WaitStatus waitFor(std::chrono::milliseconds timeout, const std::function<bool()>& isCancelled) const;
+
+    // Read only once isDone(); results() may then be moved from.
+    const std::vector<Request>& requests() const {
+        return requests_;
+    }
+    std::vector<Result>& results() {
+        return results_;
+    }
+
+    // Used by the engines.
+    Request& request(size_t index) {
+        return requests_[index];
+    }
+    Result& result(size_t index) {
+        return results_[index];
+    }
+    void settle(size_t index);
+    void fail(size_t index, int error, const std::string& action);
+
+private:
+    std::vector<Request> requests_;
+    std::vector<Result> results_;
+    std::atomic<size_t> remaining_;
+    mutable std::mutex mutex_;
+    mutable std::condition_variable condition_;
+    bool done_{false};
+};
+
+// Queues requests and returns at once; the I/O runs while the caller keeps
+// computing. Linux kernels that allow io_uring (Android S+ where the app's
+// SELinux policy permits it) get one ring shared by the process, so a batch
+// of reads costs a few io_uring_enter calls instead of a syscall each. Other
+// systems, and Linux when io_uring is refused, use a small pool of I/O
+// threads. Files are opened and closed per request either way.
+std::shared_ptr<Batch> submit(std::vector<Request> requests);
+
+// "io_uring" or "threads".
+const char* backend();
+
+// Keeps submit() on the thread pool even where io_uring works. Only effective
+// before the first submit().
+void disableUring();
+
+} // namespace threadforge::io
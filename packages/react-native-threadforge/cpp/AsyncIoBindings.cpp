@@ -0,0 +1,240 @@
+#include "AsyncIoBindings.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <jsi/jsi.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "AsyncIo.h"
+#include "BindingHelpers.h"
+#include "Files.h"
+#include "ThreadPool.h"
+
+namespace threadforge {
+
+namespace {
+
+using facebook::jsi::Array;
+using facebook::jsi::ArrayBuffer;
+using facebook::jsi::JSError;
+using facebook::jsi::Object;
+using facebook::jsi::Runtime;
+using facebook::jsi::String;
+using facebook::jsi::Value;
+
+constexpr double kMaxSafeInteger = 9007199254740991.0;
+
+struct BatchState {
+    std::shared_ptr<io::Batch> batch;
+    bool text{false};
+    bool taken{false};
+};
+
+uint64_t offsetProperty(Runtime& rt, const Object& object, const char* name) {
+    const auto value = object.getProperty(rt, name);
+    if (value.isUndefined()) {
+        return 0;
+    }
+    if (!value.isNumber() || value.getNumber() < 0 || std::trunc(value.getNumber()) != value.getNumber() ||
+        value.getNumber() > kMaxSafeInteger) {
+        throw std::invalid_argument(std::string(name) + " must be a non-negative integer");
+    }
+    return static_cast<uint64_t>(value.getNumber());
+}
+
+std::string pathProperty(Runtime& rt, const Value& value, size_t index) {
+    if (!value.isString()) {
+        throw std::invalid_argument("request " + std::to_string(index) + " needs a path");
+    }
+    return files::resolvePath(value.getString(rt).utf8(rt));
+}
+
+std::vector<uint8_t> bytesOf(Runtime& rt, const Value& data, size_t index) {
+    try {
+        return withBytes(rt, data, true, [](const uint8_t* bytes, size_t size) {
+            return std::vector<uint8_t>(bytes, bytes + size);
+        });
+    } catch (const std::invalid_argument&) {
+        throw std::invalid_argument("request " + std::to_string(index) +
+                                    " needs data as a string, typed array or ArrayBuffer");
+    }
+}
+
+io::WriteMode writeMode(Runtime& rt, const Object& item, size_t index) {
+    const auto mode = item.getProperty(rt, "mode");
+    if (mode.isUndefined()) {
+        return io::WriteMode::REPLACE;
+    }
+    const auto name = mode.isString() ? mode.getString(rt).utf8(rt) : std::string();
+    if (name == "replace") {
+        return io::WriteMode::REPLACE;
+    }
+    if (name == "append") {
+        return io::WriteMode::APPEND;
+    }
+    if (name == "overwrite") {
+        return io::WriteMode::OVERWRITE;
+    }
+    throw std::invalid_argument("request " + std::to_string(index) + " has mode '" + name +
+                                "'; use 'replace', 'append' or 'overwrite'");
+}
+
+Array requestArray(Runtime& rt, const Value& value, const char* method) {
+    if (!value.isObject() || !value.getObject(rt).isArray(rt)) {
+        throw JSError(rt, std::string("nativeIO.") + method + " expects an array of requests");
+    }
+    return value.getObject(rt).getArray(rt);
+}
+
+std::vector<io::Request> readRequests(Runtime& rt, const Value& value) {
+    const auto items = requestArray(rt, value, "read");
+    std::vector<io::Request> requests(items.size(rt));
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const auto item = items.getValueAtIndex(rt, i);
+        auto& request = requests[i];
+        if (item.isObject()) {
+            const auto object = item.getObject(rt);
+            request.path = pathProperty(rt, object.getProperty(rt, "path"), i);
+            request.offset = offsetProperty(rt, object, "offset");
+            request.length = offsetProperty(rt, object, "length");
+        } else {
+            request.path = pathProperty(rt, item, i);
+        }
+    }
+    return requests;
+}
+
+std::vector<io::Request> writeRequests(Runtime& rt, const Value& value) {
+    const auto items = requestArray(rt, value, "write");
+    std::vector<io::Request> requests(items.size(rt));
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const auto item = items.getValueAtIndex(rt, i);
+        if (!item.isObject()) {
+            throw std::invalid_argument("request " + std::to_string(i) + " must be { path, data }");
+        }
+        const auto object = item.getObject(rt);
+        auto& request = requests[i];
+        request.operation = io::Operation::WRITE;
+        request.path = pathProperty(rt, object.getProperty(rt, "path"), i);
+        request.data = bytesOf(rt, object.getProperty(rt, "data"), i);
+        request.mode = writeMode(rt, object, i);
+        request.offset = offsetProperty(rt, object, "offset");
+    }
+    return requests;
+}
+
+// Blocks until the batch settles. False when timeout (a number of ms) runs
+// out first; throws once the calling task is cancelled.
+bool awaitBatch(Runtime& rt, const io::Batch& batch, const Value& timeout) {
+    const auto limit = timeout.isNumber() && timeout.getNumber() >= 0
+        ? std::chrono::milliseconds(static_cast<int64_t>(timeout.getNumber()))
+        : std::chrono::milliseconds::max();
+    const auto task = ThreadPool::currentTask();
+    const auto status = batch.waitFor(limit, [&task] {
+        return task && task->cancelled.load();
+    });
+    if (status == io::WaitStatus::CANCELLED) {
+        throw JSError(rt, "nativeIO: the task was cancelled while waiting for I/O");
+    }
+    return status == io::WaitStatus::DONE;
+}
+
+// The batch's results as JS values. Failures throw unless settle, which
+// puts an Error in their place instead.
+Value collect(Runtime& rt, BatchState& state, bool settle) {
+    if (state.taken) {
+        throw JSError(rt, "nativeIO: this batch's results were already taken");
+    }
+    auto& batch = *state.batch;
+    auto& results = batch.results();
+    if (!settle) {
+        const auto failed = std::count_if(results.begin(), results.end(), [](const io::Result& result) {
+            return result.error != 0;
+        });
+        if (failed > 0) {
+            const auto first = std::find_if(results.begin(), results.end(), [](const io::Result& result) {
+                return result.error != 0;
+            });
+            throw JSError(rt,
+                          "nativeIO: " + first->message +
+                              (failed > 1 ? " (and " + std::to_string(failed - 1) + " more failures)" : std::string()));
+        }
+    }
+    state.taken = true;
+    auto errorConstructor = rt.global().getPropertyAsFunction(rt, "Error");
+    auto bytesConstructor = rt.global().getPropertyAsFunction(rt, "Uint8Array");
+    Array values(rt, results.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        auto& result = results[i];
+        if (result.error != 0) {
+            values.setValueAtIndex(rt, i, errorConstructor.callAsConstructor(rt, String::createFromUtf8(rt, result.message)));
+        } else if (batch.requests()[i].operation == io::Operation::WRITE) {
+            values.setValueAtIndex(rt, i, static_cast<double>(result.transferred));
+        } else if (state.text) {
+            values.setValueAtIndex(rt, i, String::createFromUtf8(rt, result.data.data(), result.data.size()));
+        } else {
+            ArrayBuffer buffer(rt, std::make_shared<OwnedBuffer>(std::move(result.data)));
+            values.setValueAtIndex(rt, i, bytesConstructor.callAsConstructor(rt, buffer));
+        }
+    }
+    return Value(std::move(values));
+}
+
+Object makeBatch(Runtime& rt, std::shared_ptr<io::Batch> batch, bool text) {
+    auto state = std::make_shared<BatchState>();
+    state->batch = std::move(batch);
+    state->text = text;
+
+    Object object(rt);
+    object.setProperty(rt, "size", static_cast<double>(state->batch->requests().size()));
+    setFunction(rt, object, "done", 0, [state](Runtime&, const Value&, const Value*, size_t) {
+        return Value(state->batch->isDone());
+    });
+    setFunction(rt, object, "wait", 1, [state](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        if (!awaitBatch(runtime, *state->batch, argumentAt(args, count, 0))) {
+            return Value::undefined();
+        }
+        return collect(runtime, *state, false);
+    });
+    setFunction(rt, object, "settle", 1, [state](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        if (!awaitBatch(runtime, *state->batch, argumentAt(args, count, 0))) {
+            return Value::undefined();
+        }
+        return collect(runtime, *state, true);
+    });
+    return object;
+}
+
+} // namespace
+
+void installAsyncIoBindings(Runtime& rt) {
+    Object nativeIO(rt);
+    // A function so the engine (and its threads) starts on first use only.
+    setFunction(rt, nativeIO, "backend", 0, [](Runtime& runtime, const Value&, const Value*, size_t) {
+        return Value(String::createFromAscii(runtime, io::backend()));
+    });
+
+    setFunction(rt, nativeIO, "read", 2, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        auto requests = readRequests(runtime, argumentAt(args, count, 0));
+        const auto& options = argumentAt(args, count, 1);
+        bool text = false;
+        if (options.isObject()) {
+            const auto value = options.getObject(runtime).getProperty(runtime, "text");
+            text = value.isBool() && value.getBool();
+        }
+        return Value(makeBatch(runtime, io::submit(std::move(requests)), text));
+    });
+
+    setFunction(rt, nativeIO, "write", 1, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        return Value(makeBatch(runtime, io::submit(writeRequests(runtime, argumentAt(args, count, 0))), false));
+    });
+
+    rt.global().setProperty(rt, "nativeIO", nativeIO);
+}
+
+} // namespace threadforge
@@ -0,0 +1,28 @@
+#pragma once
+
+namespace facebook::jsi {
+class Runtime;
+} // namespace facebook::jsi
+
+namespace threadforge {
+
+// Installs the global `nativeIO` object in a worker runtime, a front end for
+// AsyncIo.h. Worker functions are synchronous, so instead of promises a
+// submission returns a batch handle: start the I/O, compute, then collect.
+//
+//     const batch = nativeIO.read(['a.json', { path: 'b.bin', offset: 4096, length: 512 }]);
+//     ... compute while the files load ...
+//     const [a, b] = batch.wait();                         // Uint8Arrays; throws if any failed
+//     nativeIO.read(paths, { text: true }).wait();         // UTF-8 strings
+//     nativeIO.write([{ path: 'out.csv', data, mode?: 'replace' | 'append' | 'overwrite', offset? }]).wait();
+//     batch.done();                                        // non-blocking
+//     batch.settle(timeoutMs?);                            // failures as Error objects
+//     nativeIO.backend();                                  // 'io_uring' or 'threads'
+//
+// wait() and settle() return undefined when timeoutMs elapses first and give
+// up with an error once the task is cancelled. A batch's results are handed
+// out once; read buffers become the returned Uint8Arrays without a copy. Paths
+// go through files::resolvePath() like nativeFiles.
+void installAsyncIoBindings(facebook::jsi::Runtime& runtime);
+
+} // namespace threadforge
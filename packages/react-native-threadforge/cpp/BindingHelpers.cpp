@@ -0,0 +1,47 @@
+#include "BindingHelpers.h"
+
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace threadforge {
+
+namespace {
+
+using facebook::jsi::ArrayBuffer;
+using facebook::jsi::Function;
+using facebook::jsi::HostFunctionType;
+using facebook::jsi::JSError;
+using facebook::jsi::Object;
+using facebook::jsi::PropNameID;
+using facebook::jsi::Runtime;
+using facebook::jsi::Value;
+
+} // namespace
+
+void setFunction(Runtime& rt, Object& target, const char* name, unsigned length, HostFunctionType body) {
+    auto function = Function::createFromHostFunction(
+        rt,
+        PropNameID::forAscii(rt, name),
+        length,
+        [body = std::move(body)](Runtime& runtime, const Value& thisValue, const Value* args, size_t count) -> Value {
+            try {
+                return body(runtime, thisValue, args, count);
+            } catch (const std::invalid_argument& ex) {
+                throw JSError(runtime, ex.what());
+            }
+        });
+    target.setProperty(rt, name, function);
+}
+
+const Value& argumentAt(const Value* args, size_t count, size_t index) {
+    static const Value undefinedValue;
+    return index < count ? args[index] : undefinedValue;
+}
+
+Value bytesValue(Runtime& rt, std::vector<uint8_t> bytes) {
+    ArrayBuffer buffer(rt, std::make_shared<OwnedBuffer>(std::move(bytes)));
+    return rt.global().getPropertyAsFunction(rt, "Uint8Array").callAsConstructor(rt, buffer);
+}
+
+} // namespace threadforge
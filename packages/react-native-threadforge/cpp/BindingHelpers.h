@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <jsi/jsi.h>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "PackedTable.h"
+#include "TypedArrayView.h"
+
+namespace threadforge {
+
+// Defines target[name] as a host function. std::invalid_argument thrown by
+// body (the native cores validate their inputs that way) becomes a JS Error
+// with the same message.
+void setFunction(facebook::jsi::Runtime& runtime,
+                 facebook::jsi::Object& target,
+                 const char* name,
+                 unsigned length,
+                 facebook::jsi::HostFunctionType body);
+
+// args[index], or undefined past the end.
+const facebook::jsi::Value& argumentAt(const facebook::jsi::Value* args, size_t count, size_t index);
+
+// Native bytes handed to the runtime as an ArrayBuffer's storage, without a copy.
+class OwnedBuffer : public facebook::jsi::MutableBuffer {
+public:
+    explicit OwnedBuffer(std::vector<uint8_t> bytes)
+        : bytes_(std::move(bytes)) {}
+
+    size_t size() const override {
+        return bytes_.size();
+    }
+    uint8_t* data() override {
+        return bytes_.data();
+    }
+
+private:
+    std::vector<uint8_t> bytes_;
+};
+
+// Calls body(const uint8_t*, size_t) with the bytes of a typed array or
+// ArrayBuffer, and of a string (as UTF-8) when allowStrings, and returns what
+// body returns. The pointer is only valid during the call.
+template <typename Body>
+auto withBytes(facebook::jsi::Runtime& rt, const facebook::jsi::Value& data, bool allowStrings, Body&& body) {
+    if (allowStrings && data.isString()) {
+        const auto text = data.getString(rt).utf8(rt);
+        return body(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+    }
+    if (data.isObject()) {
+        const auto view = typedArrayView(rt, data);
+        if (view.valid()) {
+            return body(view.data, view.length * typedArrayElementSize(view.type));
+        }
+        const auto object = data.getObject(rt);
+        if (object.isArrayBuffer(rt)) {
+            const auto buffer = object.getArrayBuffer(rt);
+            return body(buffer.data(rt), buffer.size(rt));
+        }
+    }
+    throw std::invalid_argument(allowStrings ? "data must be a string, typed array or ArrayBuffer"
+                                             : "data must be a typed array or ArrayBuffer");
+}
+
+// A new Uint8Array over bytes.
+facebook::jsi::Value bytesValue(facebook::jsi::Runtime& runtime, std::vector<uint8_t> bytes);
+
+} // namespace threadforge
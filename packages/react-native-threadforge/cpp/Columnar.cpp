@@ -0,0 +1,496 @@
+#include "Columnar.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "ParallelFor.h"
+
+namespace threadforge::columnar {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+// Rows are filtered, keyed and aggregated a block at a time: every column is
+// decoded into a small double buffer once per block instead of switching on
+// its type per row.
+constexpr size_t kBlock = 256;
+
+// Key spaces up to kDirectLimit always get direct-indexed tables; larger ones
+// only while every chunk's table together stays within kDirectBudget
+// accumulators (8 MB). Sparse or huge key spaces go through hash tables.
+constexpr uint64_t kDirectLimit = 1 << 12;
+constexpr double kDirectBudget = 1 << 20;
+
+// Chunks per query at most, which bounds the memory spent on private tables.
+constexpr size_t kMaxChunks = 16;
+
+// selected lists the block's rows that passed the filters, relative to base;
+// null means all count rows from base, which keeps the loops vectorizable.
+template <typename T>
+void gatherAs(const T* data, size_t base, const uint32_t* selected, size_t count, double* out) {
+    if (selected == nullptr) {
+        for (size_t j = 0; j < count; ++j) {
+            out[j] = static_cast<double>(data[base + j]);
+        }
+        return;
+    }
+    for (size_t j = 0; j < count; ++j) {
+        out[j] = static_cast<double>(data[base + selected[j]]);
+    }
+}
+
+// Calls fn with the column's data as a pointer to its element type.
+template <typename Fn>
+void visitColumn(const Column& column, Fn&& fn) {
+    switch (column.type) {
+    case ColumnType::FLOAT64:
+        return fn(static_cast<const double*>(column.data));
+    case ColumnType::FLOAT32:
+        return fn(static_cast<const float*>(column.data));
+    case ColumnType::INT32:
+        return fn(static_cast<const int32_t*>(column.data));
+    case ColumnType::UINT32:
+        return fn(static_cast<const uint32_t*>(column.data));
+    case ColumnType::INT16:
+        return fn(static_cast<const int16_t*>(column.data));
+    case ColumnType::UINT16:
+        return fn(static_cast<const uint16_t*>(column.data));
+    case ColumnType::INT8:
+        return fn(static_cast<const int8_t*>(column.data));
+    case ColumnType::UINT8:
+        return fn(static_cast<const uint8_t*>(column.data));
+    }
+}
+
+void gather(const Column& column, size_t base, const uint32_t* selected, size_t count, double* out) {
+    visitColumn(column, [&](const auto* data) {
+        gatherAs(data, base, selected, count, out);
+    });
+}
+
+// keys[j] += key * stride; keyCardinality() has already validated the values.
+void addKeys(const Column& column, size_t base, const uint32_t* selected, size_t count, uint64_t stride, uint64_t* keys) {
+    visitColumn(column, [&](const auto* data) {
+        if (selected == nullptr) {
+            for (size_t j = 0; j < count; ++j) {
+                keys[j] += static_cast<uint64_t>(static_cast<int64_t>(data[base + j])) * stride;
+            }
+            return;
+        }
+        for (size_t j = 0; j < count; ++j) {
+            keys[j] += static_cast<uint64_t>(static_cast<int64_t>(data[base + selected[j]])) * stride;
+        }
+    });
+}
+
+bool matches(Compare op, double value, double operand) {
+    switch (op) {
+    case Compare::EQ:
+        return value == operand;
+    case Compare::NE:
+        return value != operand;
+    case Compare::LT:
+        return value < operand;
+    case Compare::LE:
+        return value <= operand;
+    case Compare::GT:
+        return value > operand;
+    case Compare::GE:
+        return value >= operand;
+    }
+    return false;
+}
+
+// ToUint32 as in JS: truncate, wrap modulo 2^32, and 0 for NaN and infinities.
+uint32_t bitsOf(double value) {
+    return std::fabs(value) < 9.0e18 ? static_cast<uint32_t>(static_cast<int64_t>(value)) : 0;
+}
+
+double identityOf(Aggregate kind) {
+    return kind == Aggregate::MIN || kind == Aggregate::MAX ? kNaN : 0.0;
+}
+
+// Folds value into acc; also used to merge two partial accumulators. MIN and
+// MAX start from NaN, which `value < acc` can never replace, hence the check.
+template <Aggregate kKind>
+void fold(double& acc, double value) {
+    if constexpr (kKind == Aggregate::COUNT || kKind == Aggregate::SUM) {
+        acc += value;
+    } else if constexpr (kKind == Aggregate::MIN) {
+        if (value < acc || (std::isnan(acc) && !std::isnan(value))) {
+            acc = value;
+        }
+    } else if constexpr (kKind == Aggregate::MAX) {
+        if (value > acc || (std::isnan(acc) && !std::isnan(value))) {
+            acc = value;
+        }
+    } else {
+        acc = static_cast<double>(bitsOf(acc) | bitsOf(value));
+    }
+}
+
+// Calls fn with the aggregate kind as a compile-time constant, so the loops
+// inside it are specialized. COUNT folds like SUM.
+template <typename Fn>
+void withKind(Aggregate kind, Fn&& fn) {
+    switch (kind) {
+    case Aggregate::COUNT:
+    case Aggregate::SUM:
+        return fn(std::integral_constant<Aggregate, Aggregate::SUM>());
+    case Aggregate::MIN:
+        return fn(std::integral_constant<Aggregate, Aggregate::MIN>());
+    case Aggregate::MAX:
+        return fn(std::integral_constant<Aggregate, Aggregate::MAX>());
+    case Aggregate::OR:
+        return fn(std::integral_constant<Aggregate, Aggregate::OR>());
+    }
+}
+
+// Validated query plus the composite-key layout: a group's key is
+// sum(key[k] * strides[k]), so ascending composites are ascending keys.
+struct Plan {
+    const Query& query;
+    size_t rows{0};
+    std::vector<uint64_t> cardinalities;
+    std::vector<uint64_t> strides;
+    uint64_t keySpace{1};
+    bool direct{true};
+};
+
+// Per-chunk tables. Direct plans index slots by composite key; hash plans
+// append a slot per new key, remember the key in slotKeys and find it again
+// through a linear-probing index (keys are dense integers, so a multiplicative
+// hash spreads them well enough).
+struct Partial {
+    static constexpr uint32_t kEmpty = UINT32_MAX;
+
+    std::vector<uint64_t> counts;
+    std::vector<double> accumulators;
+    std::vector<uint64_t> slotKeys;
+    std::vector<uint32_t> index;
+
+    void addSlots(size_t count, const std::vector<Aggregation>& aggregations) {
+        counts.resize(counts.size() + count, 0);
+        for (size_t s = 0; s < count; ++s) {
+            for (const auto& aggregation : aggregations) {
+                accumulators.push_back(identityOf(aggregation.kind));
+            }
+        }
+    }
+
+    uint32_t slotFor(uint64_t key, const std::vector<Aggregation>& aggregations) {
+        if ((slotKeys.size() + 1) * 2 > index.size()) {
+            rehash(std::max<size_t>(64, index.size() * 2));
+        }
+        const size_t mask = index.size() - 1;
+        for (size_t probe = bucketOf(key, mask);; probe = (probe + 1) & mask) {
+            const uint32_t slot = index[probe];
+            if (slot == kEmpty) {
+                index[probe] = static_cast<uint32_t>(slotKeys.size());
+                slotKeys.push_back(key);
+                addSlots(1, aggregations);
+                return index[probe];
+            }
+            if (slotKeys[slot] == key) {
+                return slot;
+            }
+        }
+    }
+
+private:
+    static size_t bucketOf(uint64_t key, size_t mask) {
+        return static_cast<size_t>((key * 0x9e3779b97f4a7c15ULL) >> 32) & mask;
+    }
+
+    void rehash(size_t buckets) {
+        index.assign(buckets, kEmpty);
+        for (uint32_t slot = 0; slot < slotKeys.size(); ++slot) {
+            size_t probe = bucketOf(slotKeys[slot], buckets - 1);
+            while (index[probe] != kEmpty) {
+                probe = (probe + 1) & (buckets - 1);
+            }
+            index[probe] = slot;
+        }
+    }
+};
+
+template <typename T>
+bool isKey(T value) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return value >= 0 && value < 4294967296.0 && static_cast<T>(static_cast<int64_t>(value)) == value;
+    } else {
+        return value >= 0;
+    }
+}
+
+uint64_t keyCardinality(const Column& column, size_t rows) {
+    uint64_t maxKey = 0;
+    visitColumn(column, [&](const auto* data) {
+        bool valid = true;
+        std::decay_t<decltype(*data)> largest = 0;
+        for (size_t i = 0; i < rows; ++i) {
+            valid &= isKey(data[i]);
+            largest = std::max(largest, data[i]);
+        }
+        if (!valid) {
+            throw std::invalid_argument("group-by columns must hold non-negative integers below 2^32");
+        }
+        maxKey = static_cast<uint64_t>(largest);
+    });
+    return maxKey + 1;
+}
+
+Plan makePlan(const Query& query) {
+    Plan plan{query, 0, {}, {}, 1, true};
+    plan.rows = query.columns.empty() ? 0 : query.columns.front().size;
+    for (const auto& column : query.columns) {
+        if (column.size != plan.rows || (column.data == nullptr && column.size > 0)) {
+            throw std::invalid_argument("columns must all have the same length");
+        }
+    }
+    const auto checkColumn = [&query](size_t column) {
+        if (column >= query.columns.size()) {
+            throw std::invalid_argument("column index out of range");
+        }
+    };
+    for (const auto& filter : query.filters) {
+        checkColumn(filter.column);
+    }
+    for (const auto& aggregation : query.aggregations) {
+        if (aggregation.kind == Aggregate::COUNT) {
+            continue;
+        }
+        checkColumn(aggregation.column);
+    }
+
+    plan.cardinalities.resize(query.groupBy.size());
+    plan.strides.resize(query.groupBy.size());
+    for (size_t k = query.groupBy.size(); k-- > 0;) {
+        checkColumn(query.groupBy[k]);
+        const auto cardinality = keyCardinality(query.columns[query.groupBy[k]], plan.rows);
+        if (static_cast<double>(plan.keySpace) * static_cast<double>(cardinality) > 9.0e18) {
+            throw std::invalid_argument("group-by key space is too large");
+        }
+        plan.cardinalities[k] = cardinality;
+        plan.strides[k] = plan.keySpace;
+        plan.keySpace *= cardinality;
+    }
+    return plan;
+}
+
+void accumulateRange(const Plan& plan, size_t begin, size_t end, Partial& partial) {
+    const auto& query = plan.query;
+    const auto& aggregations = query.aggregations;
+    const size_t width = aggregations.size();
+    uint32_t selection[kBlock];
+    double values[kBlock];
+    uint64_t keys[kBlock];
+    uint32_t slots[kBlock];
+
+    for (size_t base = begin; base < end; base += kBlock) {
+        size_t count = std::min(kBlock, end - base);
+        const uint32_t* selected = nullptr;
+        if (!query.filters.empty()) {
+            for (size_t j = 0; j < count; ++j) {
+                selection[j] = static_cast<uint32_t>(j);
+            }
+            for (const auto& filter : query.filters) {
+                gather(query.columns[filter.column], base, selection, count, values);
+                size_t kept = 0;
+                for (size_t j = 0; j < count; ++j) {
+                    if (matches(filter.op, values[j], filter.value)) {
+                        selection[kept++] = selection[j];
+                    }
+                }
+                count = kept;
+            }
+            if (count == 0) {
+                continue;
+            }
+            selected = selection;
+        }
+
+        std::fill(keys, keys + count, 0);
+        for (size_t k = 0; k < query.groupBy.size(); ++k) {
+            addKeys(query.columns[query.groupBy[k]], base, selected, count, plan.strides[k], keys);
+        }
+        if (plan.direct) {
+            for (size_t j = 0; j < count; ++j) {
+                slots[j] = static_cast<uint32_t>(keys[j]);
+            }
+        } else {
+            for (size_t j = 0; j < count; ++j) {
+                slots[j] = partial.slotFor(keys[j], aggregations);
+            }
+        }
+        for (size_t j = 0; j < count; ++j) {
+            ++partial.counts[slots[j]];
+        }
+
+        for (size_t a = 0; a < width; ++a) {
+            const auto kind = aggregations[a].kind;
+            if (kind == Aggregate::COUNT) {
+                continue;
+            }
+            gather(query.columns[aggregations[a].column], base, selected, count, values);
+            double* accumulators = partial.accumulators.data() + a;
+            withKind(kind, [&](auto k) {
+                for (size_t j = 0; j < count; ++j) {
+                    fold<k()>(accumulators[slots[j] * width], values[j]);
+                }
+            });
+        }
+    }
+}
+
+// Folds from's slots into into's: slot for slot on direct plans, by key on
+// hash plans.
+void merge(const Plan& plan, Partial& into, const Partial& from) {
+    const auto& aggregations = plan.query.aggregations;
+    const size_t width = aggregations.size();
+    if (plan.direct) {
+        for (size_t slot = 0; slot < into.counts.size(); ++slot) {
+            into.counts[slot] += from.counts[slot];
+        }
+        for (size_t a = 0; a < width; ++a) {
+            withKind(aggregations[a].kind, [&](auto k) {
+                for (size_t i = a; i < into.accumulators.size(); i += width) {
+                    fold<k()>(into.accumulators[i], from.accumulators[i]);
+                }
+            });
+        }
+        return;
+    }
+    for (size_t slot = 0; slot < from.slotKeys.size(); ++slot) {
+        const size_t target = into.slotFor(from.slotKeys[slot], aggregations);
+        into.counts[target] += from.counts[slot];
+        for (size_t a = 0; a < width; ++a) {
+            withKind(aggregations[a].kind, [&](auto k) {
+                fold<k()>(into.accumulators[target * width + a], from.accumulators[slot * width + a]);
+            });
+        }
+    }
+}
+
+} // namespace
+
+bool parseCompare(const std::string& name, Compare& compare) {
+    if (name == "==" || name == "===") {
+        compare = Compare::EQ;
+    } else if (name == "!=" || name == "!==") {
+        compare = Compare::NE;
+    } else if (name == "<") {
+        compare = Compare::LT;
+    } else if (name == "<=") {
+        compare = Compare::LE;
+    } else if (name == ">") {
+        compare = Compare::GT;
+    } else if (name == ">=") {
+        compare = Compare::GE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parseAggregate(const std::string& name, Aggregate& aggregate) {
+    if (name == "count") {
+        aggregate = Aggregate::COUNT;
+    } else if (name == "sum") {
+        aggregate = Aggregate::SUM;
+    } else if (name == "min") {
+        aggregate = Aggregate::MIN;
+    } else if (name == "max") {
+        aggregate = Aggregate::MAX;
+    } else if (name == "or") {
+        aggregate = Aggregate::OR;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool aggregate(const Query& query, GroupedResult& result, const std::function<bool()>& isCancelled) {
+    auto plan = makePlan(query);
+    const auto& aggregations = query.aggregations;
+    const size_t grain = std::max(kParallelThreshold / 2, (plan.rows + kMaxChunks - 1) / kMaxChunks);
+    const size_t chunks = plan.rows < kParallelThreshold ? 1 : (plan.rows + grain - 1) / grain;
+    plan.direct = plan.keySpace <= kDirectLimit ||
+        static_cast<double>(plan.keySpace) * static_cast<double>((aggregations.size() + 1) * chunks) <= kDirectBudget;
+
+    const auto newPartial = [&plan, &aggregations]() {
+        Partial partial;
+        if (plan.direct) {
+            partial.addSlots(static_cast<size_t>(plan.keySpace), aggregations);
+        }
+        return partial;
+    };
+
+    std::vector<Partial> partials;
+    if (plan.rows < kParallelThreshold) {
+        if (isCancelled && isCancelled()) {
+            return false;
+        }
+        partials.push_back(newPartial());
+        accumulateRange(plan, 0, plan.rows, partials.back());
+    } else {
+        partials.resize((plan.rows + grain - 1) / grain);
+        const bool completed = parallelFor(
+            plan.rows,
+            grain,
+            [&](size_t begin, size_t end) {
+                auto partial = newPartial();
+                accumulateRange(plan, begin, end, partial);
+                partials[begin / grain] = std::move(partial);
+            },
+            isCancelled);
+        if (!completed) {
+            return false;
+        }
+    }
+
+    // Merge in chunk order, then list the non-empty groups by ascending key.
+    Partial merged = std::move(partials.front());
+    for (size_t p = 1; p < partials.size(); ++p) {
+        merge(plan, merged, partials[p]);
+    }
+    std::vector<std::pair<uint64_t, uint32_t>> order;
+    if (plan.direct) {
+        for (size_t slot = 0; slot < merged.counts.size(); ++slot) {
+            if (merged.counts[slot] > 0 || query.groupBy.empty()) {
+                order.emplace_back(slot, static_cast<uint32_t>(slot));
+            }
+        }
+    } else {
+        for (size_t slot = 0; slot < merged.slotKeys.size(); ++slot) {
+            order.emplace_back(merged.slotKeys[slot], static_cast<uint32_t>(slot));
+        }
+        std::sort(order.begin(), order.end());
+    }
+
+    GroupedResult grouped;
+    grouped.groups = order.size();
+    grouped.keys.assign(query.groupBy.size(), std::vector<uint32_t>(order.size()));
+    grouped.values.assign(aggregations.size(), std::vector<double>(order.size()));
+    const size_t width = aggregations.size();
+    for (size_t g = 0; g < order.size(); ++g) {
+        const auto [key, slot] = order[g];
+        for (size_t k = 0; k < query.groupBy.size(); ++k) {
+            grouped.keys[k][g] = static_cast<uint32_t>(key / plan.strides[k] % plan.cardinalities[k]);
+        }
+        for (size_t a = 0; a < width; ++a) {
+            grouped.values[a][g] = aggregations[a].kind == Aggregate::COUNT
+                ? static_cast<double>(merged.counts[slot])
+                : merged.accumulators[slot * width + a];
+        }
+    }
+    result = std::move(grouped);
+    return true;
+}
+
+} // namespace threadforge::columnar
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace threadforge::columnar {
+
+// Row counts from which aggregate() splits the rows across the shared pool.
+constexpr size_t kParallelThreshold = 1 << 15;
+
+enum class ColumnType : uint8_t {
+    FLOAT64,
+    FLOAT32,
+    INT32,
+    UINT32,
+    INT16,
+    UINT16,
+    INT8,
+    UINT8
+};
+
+// Borrowed typed storage for one column. Dictionary-encoded string columns are
+// passed as their integer codes; mapping codes back to strings is the caller's
+// business.
+struct Column {
+    ColumnType type{ColumnType::FLOAT64};
+    const void* data{nullptr};
+    size_t size{0};
+};
+
+enum class Compare : uint8_t {
+    EQ,
+    NE,
+    LT,
+    LE,
+    GT,
+    GE
+};
+
+// Parses "==" / "!=" / "<" / "<=" / ">" / ">=" ("===" and "!==" too).
+bool parseCompare(const std::string& name, Compare& compare);
+
+// Keeps rows where columns[column] <op> value. NaN only passes "!=".
+struct Filter {
+    size_t column{0};
+    Compare op{Compare::EQ};
+    double value{0.0};
+};
+
+enum class Aggregate : uint8_t {
+    COUNT,
+    SUM,
+    MIN,
+    MAX,
+    // Bitwise OR of the values as uint32, like JS `|` (fractions truncate).
+    OR
+};
+
+// Parses "count" / "sum" / "min" / "max" / "or".
+bool parseAggregate(const std::string& name, Aggregate& aggregate);
+
+struct Aggregation {
+    Aggregate kind{Aggregate::COUNT};
+    // Ignored for COUNT.
+    size_t column{0};
+};
+
+// filter -> group by -> aggregate over columns of equal length. Filters are
+// ANDed. Group-by columns must hold non-negative integers below 2^32
+// (dictionary codes, months, ids); no group-by yields a single group.
+struct Query {
+    std::vector<Column> columns;
+    std::vector<Filter> filters;
+    std::vector<size_t> groupBy;
+    std::vector<Aggregation> aggregations;
+};
+
+// One entry per non-empty group, ordered by key with groupBy[0] most
+// significant. MIN and MAX skip NaN and give NaN for groups without a value.
+struct GroupedResult {
+    size_t groups{0};
+    // keys[k][g] is group g's value of groupBy[k].
+    std::vector<std::vector<uint32_t>> keys;
+    // values[a][g] is aggregation a over group g.
+    std::vector<std::vector<double>> values;
+};
+
+// Throws std::invalid_argument for malformed queries (column index out of
+// range, length mismatch, bad key values). Returns false, leaving result
+// untouched, when isCancelled fires first.
+//
+// Dense key spaces are aggregated into direct-indexed tables, sparse ones into
+// hash tables; either way each chunk of rows gets private tables that are
+// merged in chunk order, so results do not depend on scheduling.
+bool aggregate(const Query& query, GroupedResult& result, const std::function<bool()>& isCancelled = nullptr);
+
+} // namespace threadforge::columnar
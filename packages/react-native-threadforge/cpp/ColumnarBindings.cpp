@@ -0,0 +1,376 @@
+#include "ColumnarBindings.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <jsi/jsi.h>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BindingHelpers.h"
+#include "Columnar.h"
+#include "IngestBindings.h"
+#include "KernelRegistry.h"
+#include "PackedTableBindings.h"
+#include "TypedArrayView.h"
+#include "nlohmann/json.hpp"
+
+namespace threadforge {
+
+namespace {
+
+using facebook::jsi::Array;
+using facebook::jsi::JSError;
+using facebook::jsi::Object;
+using facebook::jsi::Runtime;
+using facebook::jsi::String;
+using facebook::jsi::Value;
+
+// Named columns of one query. Dictionary-encoded columns keep their
+// dictionary so string filters and keys can be translated.
+struct TableColumn {
+    std::string name;
+    columnar::Column column;
+    bool encoded{false};
+    std::vector<std::string> dictionary;
+};
+
+struct Table {
+    std::vector<TableColumn> columns;
+
+    size_t indexOf(const std::string& name) const {
+        for (size_t i = 0; i < columns.size(); ++i) {
+            if (columns[i].name == name) {
+                return i;
+            }
+        }
+        throw std::invalid_argument("unknown column '" + name + "'");
+    }
+};
+
+const std::string& stringAt(const nlohmann::json& value, const char* what) {
+    if (!value.is_string()) {
+        throw std::invalid_argument(std::string(what) + " must be a column name");
+    }
+    return value.get_ref<const std::string&>();
+}
+
+// Builds the query for { where?, groupBy?, aggregates } against table, and
+// lists the output name of each aggregation.
+columnar::Query buildQuery(const Table& table, const nlohmann::json& spec, std::vector<std::string>& outputs) {
+    if (!spec.is_object()) {
+        throw std::invalid_argument("query must be an object");
+    }
+    columnar::Query query;
+    for (const auto& column : table.columns) {
+        query.columns.push_back(column.column);
+    }
+
+    for (const auto& clause : spec.value("where", nlohmann::json::array())) {
+        if (!clause.is_array() || clause.size() != 3 || !clause[1].is_string()) {
+            throw std::invalid_argument("where clauses look like [column, '>=', value]");
+        }
+        columnar::Filter filter;
+        filter.column = table.indexOf(stringAt(clause[0], "where clauses"));
+        if (!columnar::parseCompare(clause[1].get<std::string>(), filter.op)) {
+            throw std::invalid_argument("unknown comparison '" + clause[1].get<std::string>() + "'");
+        }
+        const auto& value = clause[2];
+        if (value.is_number()) {
+            filter.value = value.get<double>();
+        } else if (value.is_string()) {
+            const auto& column = table.columns[filter.column];
+            if (!column.encoded || (filter.op != columnar::Compare::EQ && filter.op != columnar::Compare::NE)) {
+                throw std::invalid_argument("strings can only be compared with == or != on dictionary-encoded columns");
+            }
+            // A string missing from the dictionary matches no code.
+            const auto found = std::find(column.dictionary.begin(), column.dictionary.end(), value.get<std::string>());
+            filter.value = found == column.dictionary.end()
+                ? -1.0
+                : static_cast<double>(found - column.dictionary.begin());
+        } else {
+            throw std::invalid_argument("where values must be numbers or strings");
+        }
+        query.filters.push_back(filter);
+    }
+
+    for (const auto& name : spec.value("groupBy", nlohmann::json::array())) {
+        query.groupBy.push_back(table.indexOf(stringAt(name, "groupBy entries")));
+    }
+
+    const auto aggregates = spec.value("aggregates", nlohmann::json::object());
+    if (!aggregates.is_object() || aggregates.empty()) {
+        throw std::invalid_argument("aggregates must map output names to 'count' or [kind, column]");
+    }
+    for (const auto& item : aggregates.items()) {
+        const auto& definition = item.value();
+        const auto& kind = definition.is_array() && !definition.empty() ? definition[0] : definition;
+        columnar::Aggregation aggregation;
+        if (!kind.is_string() || !columnar::parseAggregate(kind.get<std::string>(), aggregation.kind)) {
+            throw std::invalid_argument("aggregate '" + item.key() + "' must be count, sum, min, max or or");
+        }
+        if (aggregation.kind != columnar::Aggregate::COUNT) {
+            if (!definition.is_array() || definition.size() != 2) {
+                throw std::invalid_argument("aggregate '" + item.key() + "' needs a column: [kind, column]");
+            }
+            aggregation.column = table.indexOf(stringAt(definition[1], "aggregate columns"));
+        }
+        query.aggregations.push_back(aggregation);
+        outputs.push_back(item.key());
+    }
+    return query;
+}
+
+Table readTable(Runtime& rt, const Value& value) {
+    if (!value.isObject()) {
+        throw JSError(rt, "nativeColumns.aggregate expects { columns: { name: TypedArray } }");
+    }
+    Table table;
+    const auto columns = value.getObject(rt);
+    const auto names = columns.getPropertyNames(rt);
+    for (size_t i = 0; i < names.size(rt); ++i) {
+        TableColumn column;
+        column.name = names.getValueAtIndex(rt, i).getString(rt).utf8(rt);
+        const auto item = columns.getProperty(rt, column.name.c_str());
+        auto view = typedArrayView(rt, item);
+        if (!view.valid() && item.isObject()) {
+            // { codes, dictionary }
+            const auto encoded = item.getObject(rt);
+            view = typedArrayView(rt, encoded.getProperty(rt, "codes"));
+            const auto dictionary = encoded.getProperty(rt, "dictionary");
+            if (!view.valid() || !dictionary.isObject() || !dictionary.getObject(rt).isArray(rt)) {
+                throw JSError(rt, "column '" + column.name + "' must be a typed array or { codes, dictionary }");
+            }
+            const auto words = dictionary.getObject(rt).getArray(rt);
+            column.encoded = true;
+            for (size_t w = 0; w < words.size(rt); ++w) {
+                column.dictionary.push_back(words.getValueAtIndex(rt, w).toString(rt).utf8(rt));
+            }
+        } else if (!view.valid()) {
+            throw JSError(rt, "column '" + column.name + "' must be a typed array or { codes, dictionary }");
+        }
+        column.column = columnFromTypedArray(view, column.name);
+        table.columns.push_back(std::move(column));
+    }
+    return table;
+}
+
+// JSON.stringify of the small part of the query, so JSI and runKernel share
+// one parser.
+nlohmann::json readSpec(Runtime& rt, const Object& query) {
+    Object spec(rt);
+    for (const char* name : {"where", "groupBy", "aggregates"}) {
+        spec.setProperty(rt, name, query.getProperty(rt, name));
+    }
+    auto stringify = rt.global().getPropertyAsObject(rt, "JSON").getPropertyAsFunction(rt, "stringify");
+    return nlohmann::json::parse(stringify.call(rt, spec).getString(rt).utf8(rt), nullptr, false);
+}
+
+Value keysValue(Runtime& rt, const TableColumn& column, const std::vector<uint32_t>& keys) {
+    if (column.encoded) {
+        Array strings(rt, keys.size());
+        for (size_t g = 0; g < keys.size(); ++g) {
+            strings.setValueAtIndex(
+                rt,
+                g,
+                keys[g] < column.dictionary.size() ? Value(String::createFromUtf8(rt, column.dictionary[keys[g]]))
+                                                   : Value::null());
+        }
+        return Value(std::move(strings));
+    }
+    FloatArrayView view;
+    auto array = makeFloatArray(rt, false, keys.size(), view);
+    std::copy(keys.begin(), keys.end(), view.f64);
+    return array;
+}
+
+Value valuesValue(Runtime& rt, const std::vector<double>& values) {
+    FloatArrayView view;
+    auto array = makeFloatArray(rt, false, values.size(), view);
+    std::copy(values.begin(), values.end(), view.f64);
+    return array;
+}
+
+nlohmann::json finiteOrNull(double value) {
+    return std::isfinite(value) ? nlohmann::json(value) : nlohmann::json(nullptr);
+}
+
+TaskResult runAggregateKernel(const std::string& argsJson,
+                              const ProgressCallback&,
+                              const std::function<bool()>& isCancelled) {
+    const auto args = nlohmann::json::parse(argsJson, nullptr, false);
+    if (!args.is_object() || !args.contains("columns") || !args["columns"].is_object()) {
+        return makeErrorResult("columns.aggregate expects { columns: { name: values[] }, aggregates }");
+    }
+
+    // Storage for the JSON columns; deques keep element addresses stable.
+    std::deque<std::vector<double>> numbers;
+    std::deque<std::vector<uint32_t>> codes;
+    Table table;
+    std::vector<std::string> outputs;
+    columnar::Query query;
+    columnar::GroupedResult grouped;
+    try {
+        for (const auto& item : args["columns"].items()) {
+            const auto& values = item.value();
+            if (!values.is_array()) {
+                throw std::invalid_argument("column '" + item.key() + "' must be an array");
+            }
+            TableColumn column;
+            column.name = item.key();
+            if (!values.empty() && values[0].is_string()) {
+                std::unordered_map<std::string, uint32_t> lookup;
+                auto& encoded = codes.emplace_back();
+                encoded.reserve(values.size());
+                for (const auto& value : values) {
+                    const auto inserted = lookup.emplace(stringAt(value, "dictionary columns"), lookup.size());
+                    if (inserted.second) {
+                        column.dictionary.push_back(inserted.first->first);
+                    }
+                    encoded.push_back(inserted.first->second);
+                }
+                column.encoded = true;
+                column.column = columnar::Column{columnar::ColumnType::UINT32, encoded.data(), encoded.size()};
+            } else {
+                auto& decoded = numbers.emplace_back();
+                decoded.reserve(values.size());
+                for (const auto& value : values) {
+                    decoded.push_back(value.is_number() ? value.get<double>() : NAN);
+                }
+                column.column = columnar::Column{columnar::ColumnType::FLOAT64, decoded.data(), decoded.size()};
+            }
+            table.columns.push_back(std::move(column));
+        }
+        query = buildQuery(table, args, outputs);
+        if (!columnar::aggregate(query, grouped, isCancelled)) {
+            return makeCancelledResult();
+        }
+    } catch (const std::exception& ex) {
+        return makeErrorResult(std::string("columns.aggregate: ") + ex.what());
+    }
+
+    nlohmann::json result;
+    result["groups"] = grouped.groups;
+    result["keys"] = nlohmann::json::object();
+    result["values"] = nlohmann::json::object();
+    for (size_t k = 0; k < query.groupBy.size(); ++k) {
+        const auto& column = table.columns[query.groupBy[k]];
+        auto& keys = result["keys"][column.name] = nlohmann::json::array();
+        for (const uint32_t key : grouped.keys[k]) {
+            keys.push_back(column.encoded ? nlohmann::json(column.dictionary[key]) : nlohmann::json(key));
+        }
+    }
+    for (size_t a = 0; a < outputs.size(); ++a) {
+        auto& values = result["values"][outputs[a]] = nlohmann::json::array();
+        for (const double value : grouped.values[a]) {
+            values.push_back(finiteOrNull(value));
+        }
+    }
+    return makeSuccessResult(result.dump());
+}
+
+THREADFORGE_REGISTER_KERNEL("columns.aggregate", runAggregateKernel);
+
+} // namespace
+
+columnar::Column columnFromTypedArray(const TypedArrayView& view, const std::string& name) {
+    static const std::pair<const char*, columnar::ColumnType> kTypes[] = {
+        {"Float64Array", columnar::ColumnType::FLOAT64},
+        {"Float32Array", columnar::ColumnType::FLOAT32},
+        {"Int32Array", columnar::ColumnType::INT32},
+        {"Uint32Array", columnar::ColumnType::UINT32},
+        {"Int16Array", columnar::ColumnType::INT16},
+        {"Uint16Array", columnar::ColumnType::UINT16},
+        {"Int8Array", columnar::ColumnType::INT8},
+        {"Uint8Array", columnar::ColumnType::UINT8},
+        {"Uint8ClampedArray", columnar::ColumnType::UINT8},
+    };
+    for (const auto& [type, columnType] : kTypes) {
+        if (view.type == type) {
+            return columnar::Column{columnType, view.data, view.length};
+        }
+    }
+    throw std::invalid_argument("column '" + name + "' has unsupported type " + view.type);
+}
+
+void installColumnarBindings(Runtime& rt) {
+    Object nativeColumns(rt);
+
+    setFunction(rt, nativeColumns, "aggregate", 1, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto& queryValue = argumentAt(args, count, 0);
+        if (!queryValue.isObject()) {
+            throw JSError(runtime, "nativeColumns.aggregate expects a query object");
+        }
+        const auto queryObject = queryValue.getObject(runtime);
+        const auto table = readTable(runtime, queryObject.getProperty(runtime, "columns"));
+        const auto spec = readSpec(runtime, queryObject);
+        std::vector<std::string> outputs;
+        const auto query = buildQuery(table, spec, outputs);
+        columnar::GroupedResult grouped;
+        columnar::aggregate(query, grouped);
+
+        Object keys(runtime);
+        for (size_t k = 0; k < query.groupBy.size(); ++k) {
+            const auto& column = table.columns[query.groupBy[k]];
+            keys.setProperty(runtime, column.name.c_str(), keysValue(runtime, column, grouped.keys[k]));
+        }
+        Object values(runtime);
+        for (size_t a = 0; a < outputs.size(); ++a) {
+            values.setProperty(runtime, outputs[a].c_str(), valuesValue(runtime, grouped.values[a]));
+        }
+        Object result(runtime);
+        result.setProperty(runtime, "groups", static_cast<double>(grouped.groups));
+        result.setProperty(runtime, "keys", keys);
+        result.setProperty(runtime, "values", values);
+        return Value(std::move(result));
+    });
+
+    setFunction(rt, nativeColumns, "encode", 1, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto& input = argumentAt(args, count, 0);
+        if (!input.isObject() || !input.getObject(runtime).isArray(runtime)) {
+            throw JSError(runtime, "nativeColumns.encode expects an array of strings");
+        }
+        const auto strings = input.getObject(runtime).getArray(runtime);
+        const size_t length = strings.size(runtime);
+        TypedArrayView view;
+        auto codes = makeTypedArray(runtime, "Uint32Array", length, view);
+        auto* out = reinterpret_cast<uint32_t*>(view.data);
+        std::unordered_map<std::string, uint32_t> lookup;
+        std::vector<const std::string*> order;
+        for (size_t i = 0; i < length; ++i) {
+            const auto inserted = lookup.emplace(
+                strings.getValueAtIndex(runtime, i).toString(runtime).utf8(runtime), static_cast<uint32_t>(lookup.size()));
+            if (inserted.second) {
+                order.push_back(&inserted.first->first);
+            }
+            out[i] = inserted.first->second;
+        }
+        Array dictionary(runtime, order.size());
+        for (size_t d = 0; d < order.size(); ++d) {
+            dictionary.setValueAtIndex(runtime, d, String::createFromUtf8(runtime, *order[d]));
+        }
+        Object result(runtime);
+        result.setProperty(runtime, "codes", codes);
+        result.setProperty(runtime, "dictionary", dictionary);
+        return Value(std::move(result));
+    });
+
+    setFunction(rt, nativeColumns, "table", 1, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        return packTable(runtime, argumentAt(args, count, 0));
+    });
+
+    setFunction(rt, nativeColumns, "readCsv", 2, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        return ingestTable(runtime, ingest::Format::CSV, argumentAt(args, count, 0), argumentAt(args, count, 1));
+    });
+
+    setFunction(
+        rt, nativeColumns, "readNdjson", 2, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+            return ingestTable(runtime, ingest::Format::NDJSON, argumentAt(args, count, 0), argumentAt(args, count, 1));
+        });
+
+    rt.global().setProperty(rt, "nativeColumns", nativeColumns);
+}
+
+} // namespace threadforge
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+
+#include "Columnar.h"
+#include "TypedArrayView.h"
+
+namespace facebook::jsi {
+class Runtime;
+} // namespace facebook::jsi
+
+namespace threadforge {
+
+// Installs the global `nativeColumns` object in a worker runtime, a front end
+// for columnar::aggregate() (Columnar.h). Columns are typed arrays read in
+// place, or dictionary-encoded strings as { codes, dictionary }:
+//
+//     nativeColumns.aggregate({
+//       columns: { category: { codes: categoryCodes, dictionary: categories }, amount, month },
+//       where: [['amount', '>=', 100], ['category', '!=', 'Books']],   // optional, ANDed
+//       groupBy: ['category', 'month'],                                 // optional
+//       aggregates: { orders: 'count', revenue: ['sum', 'amount'], first: ['min', 'month'] },
+//     })
+//     // => { groups, keys: { category: string[], month: Float64Array }, values: { orders, revenue, first } }
+//
+//     nativeColumns.encode(strings)       // { codes: Uint32Array, dictionary: string[] }
+//     nativeColumns.table({ id, amount, category })   // packed result, see PackedTableBindings.h
+//     nativeColumns.readCsv('orders.csv', { types: { id: 'int32' } })   // { rows, columns }, see IngestBindings.h
+//     nativeColumns.readNdjson(bytes)
+//
+// The same query runs as the "columns.aggregate" kernel for runKernel(), with
+// columns given as plain JSON arrays; arrays of strings are dictionary-encoded.
+void installColumnarBindings(facebook::jsi::Runtime& runtime);
+
+// The column a typed array view holds; name only labels the error thrown
+// (std::invalid_argument) for unsupported types.
+columnar::Column columnFromTypedArray(const TypedArrayView& view, const std::string& name);
+
+} // namespace threadforge
@@ -0,0 +1,803 @@
+#include "Compression.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <zlib.h>
+
+#include "Files.h"
+#include "Hashing.h"
+#include "ParallelFor.h"
+
+namespace threadforge::compression {
+
+namespace {
+
+using hashing::Xxh32;
+
+// Input per parallel deflate chunk, and the history each chunk is primed with.
+constexpr size_t kDeflateChunk = 256u << 10;
+constexpr size_t kDeflateWindow = 32u << 10;
+// LZ4 frame block size (the 1 MiB "BD" setting) and the history a linked
+// block may reach into.
+constexpr size_t kLz4Block = 1u << 20;
+constexpr size_t kLz4Window = 64u << 10;
+constexpr uint32_t kLz4Magic = 0x184D2204;
+// How much of a file goes through the codec at a time.
+constexpr size_t kFileSlice = 8u << 20;
+
+void forEachChunk(size_t count, const std::function<void(size_t)>& body) {
+    parallelFor(count, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            body(i);
+        }
+    });
+}
+
+void append(std::vector<uint8_t>& out, const uint8_t* data, size_t size) {
+    out.insert(out.end(), data, data + size);
+}
+
+void appendLe32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+uint32_t readLe32(const uint8_t* data) {
+    return static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 |
+        static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+}
+
+uint64_t readLe64(const uint8_t* data) {
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+// Keeps the last limit bytes of window followed by data in window.
+void slideWindow(std::vector<uint8_t>& window, const uint8_t* data, size_t size, size_t limit) {
+    if (size >= limit) {
+        window.assign(data + size - limit, data + size);
+        return;
+    }
+    append(window, data, size);
+    if (window.size() > limit) {
+        window.erase(window.begin(), window.end() - static_cast<ptrdiff_t>(limit));
+    }
+}
+
+// --- LZ4 blocks ---
+
+constexpr size_t kMinMatch = 4;
+// The format's end-of-block rules: the last 5 bytes are literals and the
+// last match starts at least 12 bytes before the end.
+constexpr size_t kLastLiterals = 5;
+constexpr size_t kMatchFindLimit = 12;
+constexpr int kHashBits = 16;
+
+size_t lz4Bound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+void writeLength(uint8_t*& op, size_t length) {
+    for (; length >= 255; length -= 255) {
+        *op++ = 255;
+    }
+    *op++ = static_cast<uint8_t>(length);
+}
+
+// Greedy single-pass LZ4 block compressor. dst holds lz4Bound(size) bytes.
+size_t compressBlock(const uint8_t* src, size_t size, uint8_t* dst) {
+    uint8_t* op = dst;
+    size_t anchor = 0;
+    if (size > kMatchFindLimit) {
+        std::vector<uint32_t> table(size_t{1} << kHashBits, 0);
+        const size_t matchLimit = size - kLastLiterals;
+        const size_t searchLimit = size - kMatchFindLimit;
+        size_t ip = 0;
+        unsigned misses = 0;
+        while (ip < searchLimit) {
+            const uint32_t sequence = readLe32(src + ip);
+            const uint32_t hash = (sequence * 2654435761u) >> (32 - kHashBits);
+            const uint32_t candidate = table[hash];
+            table[hash] = static_cast<uint32_t>(ip + 1);
+            if (candidate == 0 || ip - (candidate - 1) > 65535 || readLe32(src + candidate - 1) != sequence) {
+                ip += 1 + (misses++ >> 6);
+                continue;
+            }
+            misses = 0;
+            size_t match = candidate - 1;
+            while (ip > anchor && match > 0 && src[ip - 1] == src[match - 1]) {
+                --ip;
+                --match;
+            }
+            size_t length = kMinMatch;
+            while (ip + length + 8 <= matchLimit) {
+                const uint64_t difference = readLe64(src + ip + length) ^ readLe64(src + match + length);
+                if (difference != 0) {
+                    length += static_cast<size_t>(__builtin_ctzll(difference)) / 8;
+                    goto matched;
+                }
+                length += 8;
+            }
+            while (ip + length < matchLimit && src[ip + length] == src[match + length]) {
+                ++length;
+            }
+        matched:
+            const size_t literals = ip - anchor;
+            uint8_t* token = op++;
+            *token = static_cast<uint8_t>(std::min<size_t>(literals, 15) << 4);
+            if (literals >= 15) {
+                writeLength(op, literals - 15);
+            }
+            std::memcpy(op, src + anchor, literals);
+            op += literals;
+            const size_t offset = ip - match;
+            *op++ = static_cast<uint8_t>(offset);
+            *op++ = static_cast<uint8_t>(offset >> 8);
+            const size_t extra = length - kMinMatch;
+            *token |= static_cast<uint8_t>(std::min<size_t>(extra, 15));
+            if (extra >= 15) {
+                writeLength(op, extra - 15);
+            }
+            ip += length;
+            anchor = ip;
+            if (ip >= 2 && ip < searchLimit) {
+                // Index a position inside the match so runs keep finding each other.
+                table[(readLe32(src + ip - 2) * 2654435761u) >> (32 - kHashBits)] = static_cast<uint32_t>(ip - 1);
+            }
+        }
+    }
+    const size_t literals = size - anchor;
+    uint8_t* token = op++;
+    *token = static_cast<uint8_t>(std::min<size_t>(literals, 15) << 4);
+    if (literals >= 15) {
+        writeLength(op, literals - 15);
+    }
+    std::memcpy(op, src + anchor, literals);
+    op += literals;
+    return static_cast<size_t>(op - dst);
+}
+
+[[noreturn]] void corrupt(const char* codec) {
+    throw std::invalid_argument(std::string("input is not valid ") + codec + " data");
+}
+
+// Decodes one block onto the end of out. Matches may reach back to
+// windowStart, which is where the block's history begins in out.
+void decompressBlock(const uint8_t* src, size_t size, std::vector<uint8_t>& out, size_t windowStart, size_t maxSize) {
+    const size_t start = out.size();
+    out.resize(start + maxSize);
+    uint8_t* const base = out.data();
+    uint8_t* op = base + start;
+    uint8_t* const end = op + maxSize;
+    const uint8_t* ip = src;
+    const uint8_t* const inputEnd = src + size;
+    const auto readLength = [&](size_t length) {
+        if (length == 15) {
+            uint8_t byte;
+            do {
+                if (ip >= inputEnd) {
+                    corrupt("lz4");
+                }
+                byte = *ip++;
+                length += byte;
+            } while (byte == 255);
+        }
+        return length;
+    };
+    while (true) {
+        if (ip >= inputEnd) {
+            corrupt("lz4");
+        }
+        const uint8_t token = *ip++;
+        const size_t literals = readLength(token >> 4);
+        if (literals > static_cast<size_t>(inputEnd - ip) || literals > static_cast<size_t>(end - op)) {
+            corrupt("lz4");
+        }
+        std::memcpy(op, ip, literals);
+        op += literals;
+        ip += literals;
+        if (ip == inputEnd) {
+            break;
+        }
+        if (inputEnd - ip < 2) {
+            corrupt("lz4");
+        }
+        const size_t offset = static_cast<size_t>(ip[0]) | static_cast<size_t>(ip[1]) << 8;
+        ip += 2;
+        const size_t length = readLength(token & 15) + kMinMatch;
+        if (offset == 0 || offset > static_cast<size_t>(op - (base + windowStart)) ||
+            length > static_cast<size_t>(end - op)) {
+            corrupt("lz4");
+        }
+        const uint8_t* match = op - offset;
+        if (offset >= length) {
+            std::memcpy(op, match, length);
+            op += length;
+        } else {
+            for (size_t i = 0; i < length; ++i) {
+                *op++ = *match++;
+            }
+        }
+    }
+    out.resize(static_cast<size_t>(op - base));
+}
+
+// --- Compressors ---
+
+// The deflate family, compressed pigz-style: every chunk but the last ends
+// with a sync flush so the pieces concatenate into one stream.
+class DeflateCompressor : public Compressor {
+public:
+    DeflateCompressor(Codec codec, int level)
+        : codec_(codec),
+          level_(std::clamp(level, 0, 9)),
+          check_(codec == Codec::ZLIB ? adler32(0, nullptr, 0) : crc32(0, nullptr, 0)) {}
+
+    void write(const uint8_t* data, size_t size, std::vector<uint8_t>& out) override {
+        writeHeader(out);
+        if (!pending_.empty()) {
+            const size_t take = std::min(size, kDeflateChunk - pending_.size());
+            append(pending_, data, take);
+            data += take;
+            size -= take;
+            if (pending_.size() == kDeflateChunk) {
+                emit(pending_.data(), 1, out);
+                pending_.clear();
+            }
+        }
+        const size_t chunks = size / kDeflateChunk;
+        if (chunks > 0) {
+            emit(data, chunks, out);
+            data += chunks * kDeflateChunk;
+            size -= chunks * kDeflateChunk;
+        }
+        append(pending_, data, size);
+    }
+
+    void finish(std::vector<uint8_t>& out) override {
+        writeHeader(out);
+        auto last = deflateChunk(pending_.data(), pending_.size(), window_.data(), window_.size(), true);
+        append(out, last.data(), last.size());
+        check_ = checksum(check_, pending_.data(), pending_.size());
+        total_ += pending_.size();
+        pending_.clear();
+        if (codec_ == Codec::GZIP) {
+            appendLe32(out, static_cast<uint32_t>(check_));
+            appendLe32(out, static_cast<uint32_t>(total_));
+        } else if (codec_ == Codec::ZLIB) {
+            for (int shift = 24; shift >= 0; shift -= 8) {
+                out.push_back(static_cast<uint8_t>(check_ >> shift));
+            }
+        }
+    }
+
+private:
+    void writeHeader(std::vector<uint8_t>& out) {
+        if (headerWritten_) {
+            return;
+        }
+        headerWritten_ = true;
+        if (codec_ == Codec::GZIP) {
+            const uint8_t extra = level_ == 9 ? 2 : level_ == 1 ? 4 : 0;
+            const uint8_t header[] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, extra, 3};
+            append(out, header, sizeof(header));
+        } else if (codec_ == Codec::ZLIB) {
+            const int flevel = level_ < 2 ? 0 : level_ < 6 ? 1 : level_ == 6 ? 2 : 3;
+            uint8_t flags = static_cast<uint8_t>(flevel << 6);
+            flags += static_cast<uint8_t>(31 - (0x78 * 256 + flags) % 31);
+            out.push_back(0x78);
+            out.push_back(flags);
+        }
+    }
+
+    uLong checksum(uLong check, const uint8_t* data, size_t size) const {
+        if (size == 0) {
+            // A null buffer would make zlib return the initial value instead.
+            return check;
+        }
+        return codec_ == Codec::ZLIB ? adler32(check, data, static_cast<uInt>(size))
+                                     : crc32(check, data, static_cast<uInt>(size));
+    }
+
+    std::vector<uint8_t> deflateChunk(const uint8_t* data, size_t size, const uint8_t* dictionary,
+                                      size_t dictionarySize, bool last) const {
+        z_stream stream{};
+        if (deflateInit2(&stream, level_, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw std::runtime_error("deflateInit2 failed");
+        }
+        if (dictionarySize > 0) {
+            deflateSetDictionary(&stream, dictionary, static_cast<uInt>(dictionarySize));
+        }
+        // A sync flush adds an empty stored block on top of deflateBound().
+        std::vector<uint8_t> out(deflateBound(&stream, static_cast<uLong>(size)) + 16);
+        stream.next_in = const_cast<Bytef*>(data);
+        stream.avail_in = static_cast<uInt>(size);
+        stream.next_out = out.data();
+        stream.avail_out = static_cast<uInt>(out.size());
+        const int result = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+        out.resize(stream.total_out);
+        deflateEnd(&stream);
+        if (result != (last ? Z_STREAM_END : Z_OK)) {
+            throw std::runtime_error("deflate failed");
+        }
+        return out;
+    }
+
+    // Compresses count whole chunks starting at data, in parallel.
+    void emit(const uint8_t* data, size_t count, std::vector<uint8_t>& out) {
+        std::vector<std::vector<uint8_t>> pieces(count);
+        std::vector<uLong> checks(count);
+        forEachChunk(count, [&](size_t i) {
+            const uint8_t* chunk = data + i * kDeflateChunk;
+            pieces[i] = i == 0 ? deflateChunk(chunk, kDeflateChunk, window_.data(), window_.size(), false)
+                               : deflateChunk(chunk, kDeflateChunk, chunk - kDeflateWindow, kDeflateWindow, false);
+            checks[i] = checksum(codec_ == Codec::ZLIB ? adler32(0, nullptr, 0) : crc32(0, nullptr, 0), chunk,
+                                 kDeflateChunk);
+        });
+        for (size_t i = 0; i < count; ++i) {
+            append(out, pieces[i].data(), pieces[i].size());
+            check_ = codec_ == Codec::ZLIB ? adler32_combine(check_, checks[i], kDeflateChunk)
+                                           : crc32_combine(check_, checks[i], kDeflateChunk);
+        }
+        total_ += count * kDeflateChunk;
+        slideWindow(window_, data, count * kDeflateChunk, kDeflateWindow);
+    }
+
+    Codec codec_;
+    int level_;
+    uLong check_;
+    uint64_t total_{0};
+    bool headerWritten_{false};
+    std::vector<uint8_t> pending_;
+    // The last 32 KiB of input already compressed.
+    std::vector<uint8_t> window_;
+};
+
+// LZ4 frames with independent 1 MiB blocks and a content checksum.
+class Lz4Compressor : public Compressor {
+public:
+    void write(const uint8_t* data, size_t size, std::vector<uint8_t>& out) override {
+        writeHeader(out);
+        content_.update(data, size);
+        if (!pending_.empty()) {
+            const size_t take = std::min(size, kLz4Block - pending_.size());
+            append(pending_, data, take);
+            data += take;
+            size -= take;
+            if (pending_.size() == kLz4Block) {
+                emit(pending_.data(), pending_.size(), out);
+                pending_.clear();
+            }
+        }
+        const size_t whole = size / kLz4Block * kLz4Block;
+        if (whole > 0) {
+            emit(data, whole, out);
+        }
+        append(pending_, data + whole, size - whole);
+    }
+
+    void finish(std::vector<uint8_t>& out) override {
+        writeHeader(out);
+        if (!pending_.empty()) {
+            emit(pending_.data(), pending_.size(), out);
+            pending_.clear();
+        }
+        appendLe32(out, 0);
+        appendLe32(out, content_.digest());
+    }
+
+private:
+    void writeHeader(std::vector<uint8_t>& out) {
+        if (headerWritten_) {
+            return;
+        }
+        headerWritten_ = true;
+        appendLe32(out, kLz4Magic);
+        // Version 1, independent blocks, content checksum; 1 MiB blocks.
+        const uint8_t descriptor[] = {0x64, 0x60};
+        append(out, descriptor, sizeof(descriptor));
+        out.push_back(static_cast<uint8_t>(Xxh32::of(descriptor, sizeof(descriptor)) >> 8));
+    }
+
+    // Compresses [data, data + size) as blocks, in parallel.
+    void emit(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+        const size_t count = (size + kLz4Block - 1) / kLz4Block;
+        std::vector<std::vector<uint8_t>> blocks(count);
+        forEachChunk(count, [&](size_t i) {
+            const size_t begin = i * kLz4Block;
+            const size_t length = std::min(kLz4Block, size - begin);
+            auto& block = blocks[i];
+            block.resize(4 + lz4Bound(length));
+            size_t stored = compressBlock(data + begin, length, block.data() + 4);
+            uint32_t header = static_cast<uint32_t>(stored);
+            if (stored >= length) {
+                // Incompressible: keep the bytes as they are.
+                std::memcpy(block.data() + 4, data + begin, length);
+                stored = length;
+                header = static_cast<uint32_t>(length) | 0x80000000u;
+            }
+            for (int b = 0; b < 4; ++b) {
+                block[b] = static_cast<uint8_t>(header >> (8 * b));
+            }
+            block.resize(4 + stored);
+        });
+        for (const auto& block : blocks) {
+            append(out, block.data(), block.size());
+        }
+    }
+
+    bool headerWritten_{false};
+    Xxh32 content_;
+    std::vector<uint8_t> pending_;
+};
+
+// --- Decompressors ---
+
+class Inflater : public Decompressor {
+public:
+    Inflater(Codec codec, uint64_t maxSize)
+        : codec_(codec),
+          maxSize_(maxSize) {
+        const int bits = codec == Codec::GZIP ? 16 + 15 : codec == Codec::ZLIB ? 15 : -15;
+        if (inflateInit2(&stream_, bits) != Z_OK) {
+            throw std::runtime_error("inflateInit2 failed");
+        }
+    }
+
+    ~Inflater() override {
+        inflateEnd(&stream_);
+    }
+
+    void write(const uint8_t* data, size_t size, std::vector<uint8_t>& out) override {
+        // avail_in is 32-bit, so very large inputs go through in pieces.
+        constexpr size_t kMaxPiece = 1u << 30;
+        for (size_t offset = 0; offset < size; offset += kMaxPiece) {
+            inflatePiece(data + offset, std::min(kMaxPiece, size - offset), out);
+        }
+    }
+
+    void finish(std::vector<uint8_t>&) override {
+        if (!ended_) {
+            throw std::invalid_argument(std::string(codecName(codec_)) + " data is truncated");
+        }
+    }
+
+private:
+    void inflatePiece(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+        constexpr size_t kRoom = 64u << 10;
+        stream_.next_in = const_cast<Bytef*>(data);
+        stream_.avail_in = static_cast<uInt>(size);
+        while (true) {
+            if (ended_ && stream_.avail_in > 0) {
+                // Concatenated gzip members decode as one stream; anything
+                // else after the end is garbage.
+                if (codec_ != Codec::GZIP) {
+                    corrupt(codecName(codec_));
+                }
+                inflateReset(&stream_);
+                ended_ = false;
+            }
+            const size_t start = out.size();
+            out.resize(start + kRoom);
+            stream_.next_out = out.data() + start;
+            stream_.avail_out = static_cast<uInt>(kRoom);
+            const int result = inflate(&stream_, Z_NO_FLUSH);
+            const size_t wrote = kRoom - stream_.avail_out;
+            out.resize(start + wrote);
+            produced_ += wrote;
+            if (produced_ > maxSize_) {
+                throw std::invalid_argument("decompressed data exceeds " + std::to_string(maxSize_) + " bytes");
+            }
+            if (result == Z_STREAM_END) {
+                ended_ = true;
+                if (stream_.avail_in == 0) {
+                    return;
+                }
+            } else if (result == Z_BUF_ERROR) {
+                return;
+            } else if (result != Z_OK) {
+                corrupt(codecName(codec_));
+            } else if (stream_.avail_in == 0 && stream_.avail_out > 0) {
+                return;
+            }
+        }
+    }
+
+    Codec codec_;
+    uint64_t maxSize_;
+    z_stream stream_{};
+    uint64_t produced_{0};
+    bool ended_{false};
+};
+
+// Frame parser fed in arbitrary pieces: buffers until the next header or
+// block is complete, then decodes it.
+class Lz4Decompressor : public Decompressor {
+public:
+    explicit Lz4Decompressor(uint64_t maxSize)
+        : maxSize_(maxSize) {}
+
+    void write(const uint8_t* data, size_t size, std::vector<uint8_t>& out) override {
+        append(input_, data, size);
+        size_t offset = 0;
+        while (true) {
+            const size_t available = input_.size() - offset;
+            const uint8_t* at = input_.data() + offset;
+            const size_t used = step(at, available, out);
+            if (used == 0) {
+                break;
+            }
+            offset += used;
+        }
+        input_.erase(input_.begin(), input_.begin() + static_cast<ptrdiff_t>(offset));
+    }
+
+    void finish(std::vector<uint8_t>&) override {
+        if (state_ != State::MAGIC || !input_.empty() || !sawFrame_) {
+            throw std::invalid_argument("lz4 data is truncated");
+        }
+    }
+
+private:
+    enum class State : uint8_t {
+        MAGIC,
+        DESCRIPTOR,
+        BLOCK,
+        CHECKSUM,
+        SKIP
+    };
+
+    // Consumes one unit from data; 0 when more input is needed.
+    size_t step(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+        switch (state_) {
+        case State::MAGIC: {
+            if (size < 4) {
+                return 0;
+            }
+            const uint32_t magic = readLe32(data);
+            if ((magic & 0xFFFFFFF0u) == 0x184D2A50u) {
+                if (size < 8) {
+                    return 0;
+                }
+                skip_ = readLe32(data + 4);
+                state_ = skip_ > 0 ? State::SKIP : State::MAGIC;
+                return 8;
+            }
+            if (magic != kLz4Magic) {
+                corrupt("lz4");
+            }
+            state_ = State::DESCRIPTOR;
+            return 4;
+        }
+        case State::DESCRIPTOR: {
+            if (size < 2) {
+                return 0;
+            }
+            const uint8_t flags = data[0];
+            const uint8_t blockDescriptor = data[1];
+            if ((flags >> 6) != 1 || (flags & 0x02) != 0 || (blockDescriptor & 0x8F) != 0) {
+                corrupt("lz4");
+            }
+            if (flags & 0x01) {
+                throw std::invalid_argument("lz4 frames with a dictionary are not supported");
+            }
+            const size_t length = 2 + ((flags & 0x08) ? 8 : 0) + 1;
+            if (size < length) {
+                return 0;
+            }
+            if (static_cast<uint8_t>(Xxh32::of(data, length - 1) >> 8) != data[length - 1]) {
+                corrupt("lz4");
+            }
+            const int sizeCode = (blockDescriptor >> 4) & 7;
+            if (sizeCode < 4) {
+                corrupt("lz4");
+            }
+            independent_ = (flags & 0x20) != 0;
+            blockChecksum_ = (flags & 0x10) != 0;
+            contentChecksum_ = (flags & 0x04) != 0;
+            blockMax_ = size_t{1} << (8 + 2 * sizeCode);
+            content_ = Xxh32();
+            history_.clear();
+            sawFrame_ = true;
+            state_ = State::BLOCK;
+            return length;
+        }
+        case State::BLOCK: {
+            if (size < 4) {
+                return 0;
+            }
+            const uint32_t header = readLe32(data);
+            if (header == 0) {
+                state_ = contentChecksum_ ? State::CHECKSUM : State::MAGIC;
+                return 4;
+            }
+            const size_t stored = header & 0x7FFFFFFFu;
+            const size_t length = 4 + stored + (blockChecksum_ ? 4 : 0);
+            if (stored > blockMax_) {
+                corrupt("lz4");
+            }
+            if (size < length) {
+                return 0;
+            }
+            const uint8_t* block = data + 4;
+            if (blockChecksum_ && Xxh32::of(block, stored) != readLe32(block + stored)) {
+                corrupt("lz4");
+            }
+            if (independent_) {
+                history_.clear();
+            }
+            const size_t start = history_.size();
+            if (header & 0x80000000u) {
+                append(history_, block, stored);
+            } else {
+                decompressBlock(block, stored, history_, 0, blockMax_);
+            }
+            const size_t produced = history_.size() - start;
+            produced_ += produced;
+            if (produced_ > maxSize_) {
+                throw std::invalid_argument("decompressed data exceeds " + std::to_string(maxSize_) + " bytes");
+            }
+            append(out, history_.data() + start, produced);
+            if (contentChecksum_) {
+                content_.update(history_.data() + start, produced);
+            }
+            if (!independent_ && history_.size() > kLz4Window) {
+                history_.erase(history_.begin(), history_.end() - static_cast<ptrdiff_t>(kLz4Window));
+            }
+            return length;
+        }
+        case State::CHECKSUM:
+            if (size < 4) {
+                return 0;
+            }
+            if (readLe32(data) != content_.digest()) {
+                throw std::invalid_argument("lz4 content checksum mismatch");
+            }
+            state_ = State::MAGIC;
+            return 4;
+        case State::SKIP: {
+            const size_t used = static_cast<size_t>(std::min<uint64_t>(skip_, size));
+            skip_ -= used;
+            if (skip_ == 0) {
+                state_ = State::MAGIC;
+            }
+            return used;
+        }
+        }
+        return 0;
+    }
+
+    uint64_t maxSize_;
+    State state_{State::MAGIC};
+    std::vector<uint8_t> input_;
+    // Decoded output the next linked block may refer to.
+    std::vector<uint8_t> history_;
+    Xxh32 content_;
+    uint64_t produced_{0};
+    uint64_t skip_{0};
+    size_t blockMax_{0};
+    bool independent_{true};
+    bool blockChecksum_{false};
+    bool contentChecksum_{false};
+    bool sawFrame_{false};
+};
+
+} // namespace
+
+bool parseCodec(const std::string& name, Codec& codec) {
+    if (name == "gzip") {
+        codec = Codec::GZIP;
+    } else if (name == "zlib") {
+        codec = Codec::ZLIB;
+    } else if (name == "deflate") {
+        codec = Codec::DEFLATE;
+    } else if (name == "lz4") {
+        codec = Codec::LZ4;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* codecName(Codec codec) {
+    switch (codec) {
+    case Codec::GZIP:
+        return "gzip";
+    case Codec::ZLIB:
+        return "zlib";
+    case Codec::DEFLATE:
+        return "deflate";
+    case Codec::LZ4:
+        return "lz4";
+    }
+    return "unknown";
+}
+
+std::unique_ptr<Compressor> Compressor::create(Codec codec, int level) {
+    if (codec == Codec::LZ4) {
+        return std::make_unique<Lz4Compressor>();
+    }
+    return std::make_unique<DeflateCompressor>(codec, level);
+}
+
+std::unique_ptr<Decompressor> Decompressor::create(Codec codec, uint64_t maxSize) {
+    if (codec == Codec::LZ4) {
+        return std::make_unique<Lz4Decompressor>(maxSize);
+    }
+    return std::make_unique<Inflater>(codec, maxSize);
+}
+
+std::vector<uint8_t> compress(Codec codec, int level, const uint8_t* data, size_t size) {
+    std::vector<uint8_t> out;
+    out.reserve(size / 2 + 64);
+    auto compressor = Compressor::create(codec, level);
+    compressor->write(data, size, out);
+    compressor->finish(out);
+    return out;
+}
+
+std::vector<uint8_t> decompress(Codec codec, const uint8_t* data, size_t size, uint64_t maxSize) {
+    std::vector<uint8_t> out;
+    out.reserve(std::min<uint64_t>(static_cast<uint64_t>(size) * 4, maxSize));
+    auto decompressor = Decompressor::create(codec, maxSize);
+    decompressor->write(data, size, out);
+    decompressor->finish(out);
+    return out;
+}
+
+namespace {
+
+template <typename Write, typename Finish>
+bool streamFile(const std::string& source, const std::string& destination, FileStats& stats,
+                const std::function<bool()>& isCancelled, Write&& write, Finish&& finish) {
+    files::FileReader reader(source);
+    files::FileWriter writer(destination, false);
+    std::vector<uint8_t> out;
+    while (auto slice = reader.nextChunk(kFileSlice)) {
+        if (isCancelled && isCancelled()) {
+            writer.abandon();
+            return false;
+        }
+        write(slice->data(), slice->size(), out);
+        stats.inputBytes += slice->size();
+        writer.write(out.data(), out.size());
+        stats.outputBytes += out.size();
+        out.clear();
+    }
+    finish(out);
+    writer.write(out.data(), out.size());
+    stats.outputBytes += out.size();
+    writer.commit();
+    return true;
+}
+
+} // namespace
+
+bool compressFile(Codec codec, int level, const std::string& source, const std::string& destination,
+                  FileStats& stats, const std::function<bool()>& isCancelled) {
+    auto compressor = Compressor::create(codec, level);
+    return streamFile(
+        source,
+        destination,
+        stats,
+        isCancelled,
+        [&](const uint8_t* data, size_t size, std::vector<uint8_t>& out) { compressor->write(data, size, out); },
+        [&](std::vector<uint8_t>& out) { compressor->finish(out); });
+}
+
+bool decompressFile(Codec codec, const std::string& source, const std::string& destination, FileStats& stats,
+                    const std::function<bool()>& isCancelled, uint64_t maxSize) {
+    auto decompressor = Decompressor::create(codec, maxSize);
+    return streamFile(
+        source,
+        destination,
+        stats,
+        isCancelled,
+        [&](const uint8_t* data, size_t size, std::vector<uint8_t>& out) { decompressor->write(data, size, out); },
+        [&](std::vector<uint8_t>& out) { decompressor->finish(out); });
+}
+
+} // namespace threadforge::compression
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace threadforge::compression {
+
+enum class Codec : uint8_t {
+    // RFC 1952, what Content-Encoding: gzip and .gz files use.
+    GZIP,
+    // RFC 1950, deflate with a two-byte header and Adler-32.
+    ZLIB,
+    // RFC 1951 without any wrapper.
+    DEFLATE,
+    // The LZ4 frame format, readable by the lz4 command-line tool.
+    LZ4
+};
+
+// "gzip", "zlib", "deflate" or "lz4". False for anything else.
+bool parseCodec(const std::string& name, Codec& codec);
+const char* codecName(Codec codec);
+
+// Levels run 0 (stored) to 9 for the deflate family, default 6. LZ4 has a
+// single level and ignores it.
+constexpr int kDefaultLevel = 6;
+
+// Compresses a stream. Input is cut into independent chunks that compress in
+// parallel on the shared pool: deflate chunks are primed with the previous
+// 32 KiB so the ratio stays close to a serial stream (the pigz scheme), LZ4
+// chunks are the frame's independent blocks. Output is one standard stream.
+class Compressor {
+public:
+    static std::unique_ptr<Compressor> create(Codec codec, int level = kDefaultLevel);
+    virtual ~Compressor() = default;
+
+    // Appends whatever output is ready to out. Input is buffered until a
+    // whole chunk is available.
+    virtual void write(const uint8_t* data, size_t size, std::vector<uint8_t>& out) = 0;
+    // Flushes the rest and closes the stream; the compressor is spent after.
+    virtual void finish(std::vector<uint8_t>& out) = 0;
+};
+
+// Decompresses a stream fed in arbitrary pieces. Concatenated gzip members
+// and LZ4 frames decode as one stream. Throws std::invalid_argument on
+// corrupt input and when the output would exceed maxSize.
+class Decompressor {
+public:
+    static std::unique_ptr<Decompressor> create(Codec codec, uint64_t maxSize = kDefaultMaxSize);
+    virtual ~Decompressor() = default;
+
+    virtual void write(const uint8_t* data, size_t size, std::vector<uint8_t>& out) = 0;
+    // Throws when the input stopped in the middle of a stream.
+    virtual void finish(std::vector<uint8_t>& out) = 0;
+
+    static constexpr uint64_t kDefaultMaxSize = uint64_t{1} << 30;
+};
+
+// One-shot forms of the above.
+std::vector<uint8_t> compress(Codec codec, int level, const uint8_t* data, size_t size);
+std::vector<uint8_t> decompress(Codec codec, const uint8_t* data, size_t size,
+                                uint64_t maxSize = Decompressor::kDefaultMaxSize);
+
+struct FileStats {
+    uint64_t inputBytes{0};
+    uint64_t outputBytes{0};
+};
+
+// Streams source through a compressor / decompressor into destination, which
+// is replaced atomically once complete. Memory stays bounded by the chunk
+// size regardless of file size. False when isCancelled stopped it first
+// (destination is left untouched then).
+bool compressFile(Codec codec, int level, const std::string& source, const std::string& destination,
+                  FileStats& stats, const std::function<bool()>& isCancelled = nullptr);
+bool decompressFile(Codec codec, const std::string& source, const std::string& destination, FileStats& stats,
+                    const std::function<bool()>& isCancelled = nullptr,
+                    uint64_t maxSize = UINT64_MAX);
+
+} // namespace threadforge::compression
@@ -0,0 +1,284 @@
+#include "CompressionBindings.h"
+
+#include <cmath>
+#include <jsi/jsi.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BindingHelpers.h"
+#include "Compression.h"
+#include "Files.h"
+#include "KernelRegistry.h"
+#include "ThreadPool.h"
+#include "nlohmann/json.hpp"
+
+namespace threadforge {
+
+namespace {
+
+using facebook::jsi::HostFunctionType;
+using facebook::jsi::JSError;
+using facebook::jsi::Object;
+using facebook::jsi::Runtime;
+using facebook::jsi::String;
+using facebook::jsi::Value;
+
+constexpr double kMaxSafeInteger = 9007199254740991.0;
+
+struct Options {
+    compression::Codec codec{compression::Codec::GZIP};
+    int level{compression::kDefaultLevel};
+    uint64_t maxSize{compression::Decompressor::kDefaultMaxSize};
+    bool text{false};
+};
+
+Options readOptions(Runtime& rt, const Value& value) {
+    Options options;
+    if (!value.isObject()) {
+        return options;
+    }
+    const auto object = value.getObject(rt);
+    const auto codec = object.getProperty(rt, "codec");
+    if (!codec.isUndefined()) {
+        const auto name = codec.isString() ? codec.getString(rt).utf8(rt) : std::string();
+        if (!compression::parseCodec(name, options.codec)) {
+            throw std::invalid_argument("unknown codec '" + name + "'; use 'gzip', 'zlib', 'deflate' or 'lz4'");
+        }
+    }
+    const auto level = object.getProperty(rt, "level");
+    if (!level.isUndefined()) {
+        if (!level.isNumber() || level.getNumber() < 0 || level.getNumber() > 9 ||
+            std::trunc(level.getNumber()) != level.getNumber()) {
+            throw std::invalid_argument("level must be an integer from 0 to 9");
+        }
+        options.level = static_cast<int>(level.getNumber());
+    }
+    const auto maxSize = object.getProperty(rt, "maxSize");
+    if (!maxSize.isUndefined()) {
+        if (!maxSize.isNumber() || maxSize.getNumber() < 0 || maxSize.getNumber() > kMaxSafeInteger) {
+            throw std::invalid_argument("maxSize must be a non-negative number");
+        }
+        options.maxSize = static_cast<uint64_t>(maxSize.getNumber());
+    }
+    const auto text = object.getProperty(rt, "text");
+    options.text = text.isBool() && text.getBool();
+    return options;
+}
+
+// setFunction() for calls that touch files: failed system calls become JS
+// errors too.
+void setCompressionFunction(Runtime& rt, Object& target, const char* name, unsigned length, HostFunctionType body) {
+    setFunction(rt,
+                target,
+                name,
+                length,
+                [body = std::move(body)](Runtime& runtime, const Value& thisValue, const Value* args, size_t count) {
+                    try {
+                        return body(runtime, thisValue, args, count);
+                    } catch (const files::Error& ex) {
+                        throw JSError(runtime, ex.what());
+                    }
+                });
+}
+
+std::string pathArgument(Runtime& rt, const Value* args, size_t count, size_t index, const char* method) {
+    const auto& path = argumentAt(args, count, index);
+    if (!path.isString()) {
+        throw JSError(rt, std::string("nativeCompression.") + method + " expects a source and a destination path");
+    }
+    return files::resolvePath(path.getString(rt).utf8(rt));
+}
+
+bool taskCancelled() {
+    const auto task = ThreadPool::currentTask();
+    return task && task->cancelled.load();
+}
+
+Value fileStats(Runtime& rt, const compression::FileStats& stats) {
+    Object result(rt);
+    result.setProperty(rt, "inputBytes", static_cast<double>(stats.inputBytes));
+    result.setProperty(rt, "outputBytes", static_cast<double>(stats.outputBytes));
+    return Value(std::move(result));
+}
+
+template <typename Stream>
+struct StreamState {
+    std::unique_ptr<Stream> stream;
+    std::string name;
+    bool finished{false};
+};
+
+// write()/finish() over a Compressor or Decompressor.
+template <typename Stream>
+Object makeStream(Runtime& rt, std::unique_ptr<Stream> stream, const char* name) {
+    auto state = std::make_shared<StreamState<Stream>>();
+    state->stream = std::move(stream);
+    state->name = name;
+
+    Object object(rt);
+    setFunction(rt, object, "write", 1, [state](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        if (state->finished) {
+            throw JSError(runtime, state->name + ": write() after finish()");
+        }
+        std::vector<uint8_t> out;
+        withBytes(runtime, argumentAt(args, count, 0), true, [&](const uint8_t* data, size_t size) {
+            state->stream->write(data, size, out);
+        });
+        return bytesValue(runtime, std::move(out));
+    });
+    setFunction(rt, object, "finish", 0, [state](Runtime& runtime, const Value&, const Value*, size_t) {
+        if (state->finished) {
+            throw JSError(runtime, state->name + ": finish() was already called");
+        }
+        state->finished = true;
+        std::vector<uint8_t> out;
+        state->stream->finish(out);
+        return bytesValue(runtime, std::move(out));
+    });
+    return object;
+}
+
+// { source, destination, codec?, level? } for the file kernels.
+bool readFileArgs(const nlohmann::json& args, std::string& source, std::string& destination,
+                  compression::Codec& codec, int& level) {
+    if (!args.is_object() || !args.contains("source") || !args["source"].is_string() ||
+        !args.contains("destination") || !args["destination"].is_string()) {
+        return false;
+    }
+    source = files::resolvePath(args["source"].get<std::string>());
+    destination = files::resolvePath(args["destination"].get<std::string>());
+    codec = compression::Codec::GZIP;
+    if (args.contains("codec") &&
+        (!args["codec"].is_string() || !compression::parseCodec(args["codec"].get<std::string>(), codec))) {
+        throw std::invalid_argument("unknown codec; use 'gzip', 'zlib', 'deflate' or 'lz4'");
+    }
+    level = compression::kDefaultLevel;
+    if (args.contains("level")) {
+        if (!args["level"].is_number_integer() || args["level"].get<int>() < 0 || args["level"].get<int>() > 9) {
+            throw std::invalid_argument("level must be an integer from 0 to 9");
+        }
+        level = args["level"].get<int>();
+    }
+    return true;
+}
+
+TaskResult runFileKernel(const char* name, bool compress, const std::string& argsJson,
+                         const std::function<bool()>& isCancelled) {
+    const auto args = nlohmann::json::parse(argsJson, nullptr, false);
+    compression::FileStats stats;
+    try {
+        std::string source;
+        std::string destination;
+        compression::Codec codec;
+        int level;
+        if (!readFileArgs(args, source, destination, codec, level)) {
+            return makeErrorResult(std::string(name) + " expects { source, destination, codec?, level? }");
+        }
+        const bool finished = compress
+            ? compression::compressFile(codec, level, source, destination, stats, isCancelled)
+            : compression::decompressFile(codec, source, destination, stats, isCancelled);
+        if (!finished) {
+            return makeCancelledResult();
+        }
+    } catch (const std::exception& ex) {
+        return makeErrorResult(std::string(name) + ": " + ex.what());
+    }
+    nlohmann::json result;
+    result["inputBytes"] = stats.inputBytes;
+    result["outputBytes"] = stats.outputBytes;
+    return makeSuccessResult(result.dump());
+}
+
+TaskResult runCompressFileKernel(const std::string& argsJson,
+                                 const ProgressCallback&,
+                                 const std::function<bool()>& isCancelled) {
+    return runFileKernel("compression.compressFile", true, argsJson, isCancelled);
+}
+
+TaskResult runDecompressFileKernel(const std::string& argsJson,
+                                   const ProgressCallback&,
+                                   const std::function<bool()>& isCancelled) {
+    return runFileKernel("compression.decompressFile", false, argsJson, isCancelled);
+}
+
+THREADFORGE_REGISTER_KERNEL("compression.compressFile", runCompressFileKernel);
+THREADFORGE_REGISTER_KERNEL("compression.decompressFile", runDecompressFileKernel);
+
+} // namespace
+
+void installCompressionBindings(Runtime& rt) {
+    Object nativeCompression(rt);
+
+    setFunction(
+        rt, nativeCompression, "compress", 2, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+            const auto options = readOptions(runtime, argumentAt(args, count, 1));
+            auto out = withBytes(runtime, argumentAt(args, count, 0), true, [&](const uint8_t* data, size_t size) {
+                return compression::compress(options.codec, options.level, data, size);
+            });
+            return bytesValue(runtime, std::move(out));
+        });
+
+    setFunction(
+        rt, nativeCompression, "decompress", 2, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+            const auto options = readOptions(runtime, argumentAt(args, count, 1));
+            auto out = withBytes(runtime, argumentAt(args, count, 0), true, [&](const uint8_t* data, size_t size) {
+                return compression::decompress(options.codec, data, size, options.maxSize);
+            });
+            if (options.text) {
+                return Value(String::createFromUtf8(runtime, out.data(), out.size()));
+            }
+            return bytesValue(runtime, std::move(out));
+        });
+
+    setFunction(
+        rt, nativeCompression, "createCompressor", 1, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+            const auto options = readOptions(runtime, argumentAt(args, count, 0));
+            return Value(makeStream(runtime,
+                                    compression::Compressor::create(options.codec, options.level),
+                                    "nativeCompression compressor"));
+        });
+
+    setFunction(
+        rt, nativeCompression, "createDecompressor", 1, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+            const auto options = readOptions(runtime, argumentAt(args, count, 0));
+            return Value(makeStream(runtime,
+                                    compression::Decompressor::create(options.codec, options.maxSize),
+                                    "nativeCompression decompressor"));
+        });
+
+    setCompressionFunction(
+        rt, nativeCompression, "compressFile", 3, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+            const auto source = pathArgument(runtime, args, count, 0, "compressFile");
+            const auto destination = pathArgument(runtime, args, count, 1, "compressFile");
+            const auto options = readOptions(runtime, argumentAt(args, count, 2));
+            compression::FileStats stats;
+            if (!compression::compressFile(options.codec, options.level, source, destination, stats, taskCancelled)) {
+                throw JSError(runtime, "nativeCompression: the task was cancelled");
+            }
+            return fileStats(runtime, stats);
+        });
+
+    setCompressionFunction(
+        rt, nativeCompression, "decompressFile", 3, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+            const auto source = pathArgument(runtime, args, count, 0, "decompressFile");
+            const auto destination = pathArgument(runtime, args, count, 1, "decompressFile");
+            const auto& optionsValue = argumentAt(args, count, 2);
+            const auto options = readOptions(runtime, optionsValue);
+            // Files are bounded by the disk, not memory, unless a limit is asked for.
+            const bool limited = optionsValue.isObject() &&
+                !optionsValue.getObject(runtime).getProperty(runtime, "maxSize").isUndefined();
+            compression::FileStats stats;
+            if (!compression::decompressFile(
+                    options.codec, source, destination, stats, taskCancelled, limited ? options.maxSize : UINT64_MAX)) {
+                throw JSError(runtime, "nativeCompression: the task was cancelled");
+            }
+            return fileStats(runtime, stats);
+        });
+
+    rt.global().setProperty(rt, "nativeCompression", nativeCompression);
+}
+
+} // namespace threadforge
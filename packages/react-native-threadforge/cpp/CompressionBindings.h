@@ -0,0 +1,32 @@
+#pragma once
+
+namespace facebook::jsi {
+class Runtime;
+} // namespace facebook::jsi
+
+namespace threadforge {
+
+// Installs the global `nativeCompression` object in a worker runtime, a front
+// end for Compression.h. codec is 'gzip' (the default), 'zlib', 'deflate' or
+// 'lz4'; level runs 0-9 for the deflate family.
+//
+//     const packed = nativeCompression.compress(data, { codec: 'lz4' });    // Uint8Array
+//     nativeCompression.decompress(packed, { codec: 'lz4', text: true });   // string
+//     const gz = nativeCompression.createCompressor({ level: 9 });
+//     gz.write(chunk);                     // Uint8Array of output ready so far
+//     gz.finish();                         // the rest
+//     nativeCompression.createDecompressor({ codec: 'zlib', maxSize });     // same shape
+//     nativeCompression.compressFile('logs/app.log', 'logs/app.log.gz');   // { inputBytes, outputBytes }
+//     nativeCompression.decompressFile('dump.lz4', 'dump.bin', { codec: 'lz4' });
+//
+// data may be a string (compressed as UTF-8), typed array or ArrayBuffer.
+// Large inputs compress in parallel chunks on the shared pool. Decompression
+// stops with an error past maxSize (1 GiB unless given) so a small hostile
+// input cannot exhaust memory. File paths go through files::resolvePath();
+// the file forms stream through bounded memory and give up once the task is
+// cancelled. The same two file operations are registered as the kernels
+// "compression.compressFile" and "compression.decompressFile", taking
+// { source, destination, codec?, level? }.
+void installCompressionBindings(facebook::jsi::Runtime& runtime);
+
+} // namespace threadforge
@@ -0,0 +1,436 @@
+#pragma once
+
+// C++20 coroutine front end for ThreadPool. Only available when the including
+// translation unit is compiled with coroutine support; ThreadForge itself still
+// builds as C++17, so this header is a no-op there.
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "DelayQueue.h"
+#include "SharedPool.h"
+#include "ThreadPool.h"
+
+namespace threadforge::co {
+
+// Thrown out of a co_await once the chain has been cancelled.
+struct TaskCancelled : std::runtime_error {
+    TaskCancelled() : std::runtime_error("Task cancelled") {}
+};
+
+// Shared by a root task and every task it awaits, directly or indirectly.
+class CancellationToken {
+public:
+    void cancel() const {
+        flag_->store(true);
+    }
+
+    bool isCancelled() const {
+        return flag_->load();
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> flag_ = std::make_shared<std::atomic<bool>>(false);
+};
+
+namespace detail {
+
+// Where a coroutine chain runs: which pool and at which priority it is
+// re-queued after a suspension, and the token every await point checks. The
+// pool is held weakly, like TaskHandle does: once its owner drops it, the next
+// await cancels the chain instead of keeping the pool alive.
+struct PromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+    std::weak_ptr<ThreadPool> pool;
+    TaskPriority priority{TaskPriority::NORMAL};
+    CancellationToken token;
+
+    struct FinalAwaiter {
+        bool await_ready() const noexcept {
+            return false;
+        }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            auto continuation = handle.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept {
+        return {};
+    }
+    FinalAwaiter final_suspend() const noexcept {
+        return {};
+    }
+    void unhandled_exception() {
+        exception = std::current_exception();
+    }
+
+    // The pool step that is resuming us was cancelled (e.g. by shutdown).
+    void syncCancellation() {
+        const auto task = ThreadPool::currentTask();
+        if (task && task->cancelled) {
+            token.cancel();
+        }
+    }
+};
+
+inline std::string nextStepId() {
+    static std::atomic<uint64_t> counter{0};
+    return "threadforge.co:" + std::to_string(counter.fetch_add(1));
+}
+
+// Resumes handle as a pool task. If the pool refuses the step or drops it
+// before it runs (queue limit, shutdown), the chain is cancelled and resumed
+// on the rejecting thread so the suspended frame is never leaked.
+inline void resumeOn(const std::weak_ptr<ThreadPool>& weakPool,
+                     TaskPriority priority,
+                     CancellationToken token,
+                     std::coroutine_handle<> handle) {
+    auto pool = weakPool.lock();
+    if (!pool) {
+        token.cancel();
+        handle.resume();
+        return;
+    }
+    auto started = std::make_shared<std::atomic<bool>>(false);
+    pool->enqueueTask(
+        nextStepId(),
+        priority,
+        [handle, started](const ProgressCallback&, const std::function<bool()>&) {
+            started->store(true);
+            handle.resume();
+            return makeSuccessResult("null");
+        },
+        nullptr,
+        [handle, started, token](const TaskResult&) {
+            if (!started->exchange(true)) {
+                token.cancel();
+                handle.resume();
+            }
+        });
+}
+
+template <typename Promise>
+PromiseBase& promiseOf(std::coroutine_handle<Promise> handle) {
+    return static_cast<PromiseBase&>(handle.promise());
+}
+
+// Starts the awaited task on the awaiting thread with the awaiter's context and
+// resumes the awaiter when it finishes (symmetric transfer, no extra stack).
+// Awaiting an empty (default-constructed or moved-from) Task throws
+// std::logic_error in the awaiting coroutine.
+template <typename ChildPromise>
+struct TaskAwaiter {
+    std::coroutine_handle<ChildPromise> child;
+
+    bool await_ready() const {
+        if (!child) {
+            throw std::logic_error("co_await on an empty co::Task");
+        }
+        return child.done();
+    }
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> parent) noexcept {
+        auto& parentPromise = promiseOf(parent);
+        auto& childPromise = child.promise();
+        childPromise.continuation = parent;
+        childPromise.pool = parentPromise.pool;
+        childPromise.priority = parentPromise.priority;
+        childPromise.token = parentPromise.token;
+        return child;
+    }
+    decltype(auto) await_resume() {
+        return child.promise().takeResult();
+    }
+};
+
+} // namespace detail
+
+// Lazily started coroutine producing T. co_await runs it on the awaiting
+// thread; it inherits the awaiter's pool, priority and cancellation token.
+template <typename T = void>
+class Task {
+public:
+    struct promise_type : detail::PromiseBase {
+        std::optional<T> value;
+
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        template <typename U>
+        void return_value(U&& result) {
+            value.emplace(std::forward<U>(result));
+        }
+        T takeResult() {
+            if (exception) {
+                std::rethrow_exception(exception);
+            }
+            return std::move(*value);
+        }
+    };
+
+    Task() = default;
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        reset();
+    }
+
+    detail::TaskAwaiter<promise_type> operator co_await() && noexcept {
+        return {handle_};
+    }
+
+    std::coroutine_handle<promise_type> release() {
+        return std::exchange(handle_, {});
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    void reset() {
+        if (handle_) {
+            handle_.destroy();
+            handle_ = {};
+        }
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <>
+class Task<void> {
+public:
+    struct promise_type : detail::PromiseBase {
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        void return_void() const noexcept {}
+        void takeResult() const {
+            if (exception) {
+                std::rethrow_exception(exception);
+            }
+        }
+    };
+
+    Task() = default;
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        reset();
+    }
+
+    detail::TaskAwaiter<promise_type> operator co_await() && noexcept {
+        return {handle_};
+    }
+
+    std::coroutine_handle<promise_type> release() {
+        return std::exchange(handle_, {});
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    void reset() {
+        if (handle_) {
+            handle_.destroy();
+            handle_ = {};
+        }
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+// co_await switchTo(priority) re-queues the rest of the coroutine at a new
+// priority; switchTo(pool, priority) also moves it to another pool. The worker
+// is released while the continuation waits in the queue.
+struct SwitchTo {
+    std::shared_ptr<ThreadPool> pool;
+    TaskPriority priority;
+    detail::PromiseBase* promise{nullptr};
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> handle) {
+        promise = &detail::promiseOf(handle);
+        if (pool) {
+            promise->pool = pool;
+        } else if (promise->pool.expired()) {
+            promise->pool = sharedThreadPool();
+        }
+        promise->priority = priority;
+        // The step may resume (and even finish) the coroutine before this
+        // returns, so nothing below may touch the frame.
+        detail::resumeOn(promise->pool, priority, promise->token, handle);
+    }
+    void await_resume() const {
+        promise->syncCancellation();
+        if (promise->token.isCancelled()) {
+            throw TaskCancelled();
+        }
+    }
+};
+
+inline SwitchTo switchTo(TaskPriority priority) {
+    return SwitchTo{nullptr, priority};
+}
+
+inline SwitchTo switchTo(std::shared_ptr<ThreadPool> pool, TaskPriority priority) {
+    return SwitchTo{std::move(pool), priority};
+}
+
+// co_await sleepFor(delay) suspends without holding a worker; the coroutine is
+// re-queued on its pool at its current priority once the delay has elapsed.
+// Cancellation is observed when it wakes up.
+struct SleepFor {
+    std::chrono::steady_clock::duration delay;
+    detail::PromiseBase* promise{nullptr};
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> handle) {
+        promise = &detail::promiseOf(handle);
+        if (promise->pool.expired()) {
+            promise->pool = sharedThreadPool();
+        }
+        runAfter(delay, [pool = promise->pool, priority = promise->priority, token = promise->token, handle] {
+            detail::resumeOn(pool, priority, token, handle);
+        });
+    }
+    void await_resume() const {
+        promise->syncCancellation();
+        if (promise->token.isCancelled()) {
+            throw TaskCancelled();
+        }
+    }
+};
+
+template <typename Rep, typename Period>
+SleepFor sleepFor(std::chrono::duration<Rep, Period> delay) {
+    return SleepFor{std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay)};
+}
+
+// co_await isCancelled() polls cancellation without suspending, for loops that
+// want to stop cleanly rather than unwind through TaskCancelled.
+struct IsCancelled {
+    bool cancelled{false};
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+        auto& promise = detail::promiseOf(handle);
+        promise.syncCancellation();
+        cancelled = promise.token.isCancelled();
+        return false;
+    }
+    bool await_resume() const noexcept {
+        return cancelled;
+    }
+};
+
+inline IsCancelled isCancelled() {
+    return {};
+}
+
+namespace detail {
+
+// Owns itself: the frame is destroyed when the root coroutine finishes.
+struct RootTask {
+    struct promise_type : PromiseBase {
+        RootTask get_return_object() {
+            return RootTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_never final_suspend() const noexcept {
+            return {};
+        }
+        void return_void() const noexcept {}
+    };
+    std::coroutine_handle<promise_type> handle;
+};
+
+template <typename T>
+RootTask runRoot(Task<T> task, std::shared_ptr<std::promise<T>> result) {
+    // co_await results are bound to locals: GCC 12 skips coroutine bodies that
+    // co_await inside an if condition.
+    try {
+        const bool cancelled = co_await isCancelled();
+        if (cancelled) {
+            throw TaskCancelled();
+        }
+        if constexpr (std::is_void_v<T>) {
+            co_await std::move(task);
+            result->set_value();
+        } else {
+            auto value = co_await std::move(task);
+            result->set_value(std::move(value));
+        }
+    } catch (...) {
+        result->set_exception(std::current_exception());
+    }
+}
+
+} // namespace detail
+
+template <typename T>
+struct Spawned {
+    std::future<T> result;
+    CancellationToken token;
+};
+
+// Starts task on pool (the shared pool when null) at priority. Cancel it with
+// token.cancel(): every await point in the chain then throws TaskCancelled,
+// which surfaces from result.get(). The same happens when the pool is shut
+// down (or released) while the chain is suspended.
+template <typename T>
+Spawned<T> spawn(std::shared_ptr<ThreadPool> pool, TaskPriority priority, Task<T> task) {
+    auto result = std::make_shared<std::promise<T>>();
+    Spawned<T> spawned{result->get_future(), CancellationToken()};
+    auto root = detail::runRoot<T>(std::move(task), result).handle;
+    auto& promise = root.promise();
+    if (!pool) {
+        pool = sharedThreadPool();
+    }
+    promise.pool = pool;
+    promise.priority = priority;
+    promise.token = spawned.token;
+    detail::resumeOn(promise.pool, priority, spawned.token, root);
+    return spawned;
+}
+
+} // namespace threadforge::co
+
+#endif // __cpp_impl_coroutine
@@ -0,0 +1,215 @@
+#include "CpuTopology.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <thread>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#if defined(__APPLE__)
+#include <pthread.h>
+#include <sys/qos.h>
+#include <sys/sysctl.h>
+#endif
+
+namespace threadforge {
+
+namespace {
+
+bool readNumber(const std::string& path, int64_t& value) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    file >> value;
+    return !file.fail();
+}
+
+bool parseCpuDirectory(const char* name, int& id) {
+    if (std::string(name).rfind("cpu", 0) != 0 || name[3] == '\0') {
+        return false;
+    }
+    for (const char* c = name + 3; *c != '\0'; ++c) {
+        if (!std::isdigit(static_cast<unsigned char>(*c))) {
+            return false;
+        }
+    }
+    id = std::atoi(name + 3);
+    return true;
+}
+
+CpuTopology homogeneousTopology(size_t count) {
+    CpuTopology topology;
+    for (size_t i = 0; i < std::max<size_t>(1, count); ++i) {
+        topology.cores.push_back({static_cast<int>(i), 0, 0});
+        topology.performanceCores.push_back(static_cast<int>(i));
+        topology.efficiencyCores.push_back(static_cast<int>(i));
+    }
+    return topology;
+}
+
+void classifyByFrequency(CpuTopology& topology) {
+    std::sort(topology.cores.begin(), topology.cores.end(), [](const CpuCore& lhs, const CpuCore& rhs) {
+        return lhs.id < rhs.id;
+    });
+    uint64_t slowest = UINT64_MAX;
+    uint64_t fastest = 0;
+    for (const auto& core : topology.cores) {
+        slowest = std::min(slowest, core.maxFrequencyKHz);
+        fastest = std::max(fastest, core.maxFrequencyKHz);
+    }
+    for (const auto& core : topology.cores) {
+        if (slowest == fastest) {
+            topology.performanceCores.push_back(core.id);
+            topology.efficiencyCores.push_back(core.id);
+        } else if (core.maxFrequencyKHz == slowest) {
+            topology.efficiencyCores.push_back(core.id);
+        } else {
+            topology.performanceCores.push_back(core.id);
+        }
+    }
+}
+
+#if defined(__APPLE__)
+int readSysctlInt(const char* name) {
+    int value = 0;
+    size_t size = sizeof(value);
+    if (sysctlbyname(name, &value, &size, nullptr, 0) != 0) {
+        return 0;
+    }
+    return value;
+}
+
+CpuTopology readAppleTopology() {
+    // perflevel0 is the fastest level; anything beyond it counts as efficiency cores.
+    const int levels = readSysctlInt("hw.nperflevels");
+    const int performance = readSysctlInt("hw.perflevel0.logicalcpu");
+    const int efficiency = levels > 1 ? readSysctlInt("hw.perflevel1.logicalcpu") : 0;
+    if (performance <= 0 || efficiency <= 0) {
+        return homogeneousTopology(std::thread::hardware_concurrency());
+    }
+
+    CpuTopology topology;
+    for (int i = 0; i < performance + efficiency; ++i) {
+        const bool isPerformance = i < performance;
+        topology.cores.push_back({i, 0, isPerformance ? 0 : 1});
+        (isPerformance ? topology.performanceCores : topology.efficiencyCores).push_back(i);
+    }
+    return topology;
+}
+#endif
+
+} // namespace
+
+bool CpuTopology::isHeterogeneous() const {
+    return !performanceCores.empty() && !efficiencyCores.empty() &&
+        performanceCores.size() + efficiencyCores.size() == cores.size();
+}
+
+CpuTopology readCpuTopology(const std::string& sysfsRoot) {
+#if defined(__APPLE__)
+    (void)sysfsRoot;
+    return readAppleTopology();
+#else
+    CpuTopology topology;
+    DIR* directory = opendir(sysfsRoot.c_str());
+    if (!directory) {
+        return homogeneousTopology(std::thread::hardware_concurrency());
+    }
+
+    bool hasFrequencies = false;
+    while (dirent* entry = readdir(directory)) {
+        int id = 0;
+        if (!parseCpuDirectory(entry->d_name, id)) {
+            continue;
+        }
+        const auto base = sysfsRoot + "/" + entry->d_name;
+        CpuCore core;
+        core.id = id;
+        int64_t frequency = 0;
+        if (readNumber(base + "/cpufreq/cpuinfo_max_freq", frequency) && frequency > 0) {
+            core.maxFrequencyKHz = static_cast<uint64_t>(frequency);
+            hasFrequencies = true;
+        }
+        int64_t cluster = -1;
+        if (readNumber(base + "/topology/cluster_id", cluster) && cluster >= 0) {
+            core.cluster = static_cast<int>(cluster);
+        } else if (readNumber(base + "/topology/physical_package_id", cluster) && cluster >= 0) {
+            core.cluster = static_cast<int>(cluster);
+        }
+        topology.cores.push_back(core);
+    }
+    closedir(directory);
+
+    if (topology.cores.empty()) {
+        return homogeneousTopology(std::thread::hardware_concurrency());
+    }
+    if (!hasFrequencies) {
+        return homogeneousTopology(topology.cores.size());
+    }
+    classifyByFrequency(topology);
+    return topology;
+#endif
+}
+
+size_t recommendedThreadCount(const CpuTopology& topology) {
+    const size_t total = topology.cores.size();
+    if (total <= 1) {
+        return 1;
+    }
+    const size_t preferred = topology.isHeterogeneous()
+        ? topology.performanceCores.size() + 1
+        : total;
+    return std::max<size_t>(1, std::min(preferred, total - 1));
+}
+
+void applyCorePlacement(const CpuTopology& topology, CorePlacement placement) {
+#if defined(__linux__)
+    const std::vector<int>* targets = nullptr;
+    std::vector<int> allCores;
+    switch (placement) {
+        case CorePlacement::PERFORMANCE:
+            targets = &topology.performanceCores;
+            break;
+        case CorePlacement::EFFICIENCY:
+            targets = &topology.efficiencyCores;
+            break;
+        case CorePlacement::ANY:
+            for (const auto& core : topology.cores) {
+                allCores.push_back(core.id);
+            }
+            targets = &allCores;
+            break;
+    }
+    if (targets->empty()) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int id : *targets) {
+        if (id >= 0 && id < CPU_SETSIZE) {
+            CPU_SET(id, &set);
+        }
+    }
+    sched_setaffinity(0, sizeof(set), &set);
+#elif defined(__APPLE__)
+    (void)topology;
+    qos_class_t qos = QOS_CLASS_DEFAULT;
+    if (placement == CorePlacement::PERFORMANCE) {
+        qos = QOS_CLASS_USER_INITIATED;
+    } else if (placement == CorePlacement::EFFICIENCY) {
+        qos = QOS_CLASS_UTILITY;
+    }
+    pthread_set_qos_class_self_np(qos, 0);
+#else
+    (void)topology;
+    (void)placement;
+#endif
+}
+
+} // namespace threadforge
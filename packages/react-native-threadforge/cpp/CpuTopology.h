@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace threadforge {
+
+constexpr const char* kDefaultCpuSysfsRoot = "/sys/devices/system/cpu";
+
+struct CpuCore {
+    int id{0};
+    uint64_t maxFrequencyKHz{0};
+    int cluster{0};
+};
+
+// Which cores a task class should run on. Efficiency cores are the ones in the
+// slowest cluster; every other core counts as a performance core. On a
+// homogeneous SoC both lists contain every core.
+struct CpuTopology {
+    std::vector<CpuCore> cores;
+    std::vector<int> performanceCores;
+    std::vector<int> efficiencyCores;
+
+    bool isHeterogeneous() const;
+};
+
+enum class CorePlacement {
+    ANY = 0,
+    PERFORMANCE = 1,
+    EFFICIENCY = 2
+};
+
+// Reads per-core max frequencies and cluster ids below sysfsRoot (Linux/Android).
+// On Apple platforms the performance levels come from sysctl instead and
+// sysfsRoot is ignored. Falls back to a homogeneous layout of
+// hardware_concurrency() cores when nothing can be read.
+CpuTopology readCpuTopology(const std::string& sysfsRoot = kDefaultCpuSysfsRoot);
+
+// Worker count for initialize('auto'): one per performance core plus one for
+// the efficiency cluster, leaving a core free for the UI thread.
+size_t recommendedThreadCount(const CpuTopology& topology);
+
+// Moves the calling thread onto the cores for placement. Uses CPU affinity on
+// Linux/Android and QoS classes on Apple platforms, where affinity is not
+// available. Best effort: failures leave the thread where it is.
+void applyCorePlacement(const CpuTopology& topology, CorePlacement placement);
+
+} // namespace threadforge
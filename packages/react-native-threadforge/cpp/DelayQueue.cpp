@@ -0,0 +1,69 @@
+#include "DelayQueue.h"
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace threadforge {
+
+namespace {
+
+class DelayQueue {
+public:
+    DelayQueue() {
+        std::thread([this] { run(); }).detach();
+    }
+
+    void add(std::chrono::steady_clock::time_point deadline, std::function<void()> callback) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            timers_.emplace(deadline, std::move(callback));
+        }
+        condition_.notify_one();
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            if (timers_.empty()) {
+                condition_.wait(lock);
+                continue;
+            }
+            const auto next = timers_.begin()->first;
+            if (std::chrono::steady_clock::now() < next) {
+                condition_.wait_until(lock, next);
+                continue;
+            }
+            auto callback = std::move(timers_.begin()->second);
+            timers_.erase(timers_.begin());
+            lock.unlock();
+            callback();
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    // Equal deadlines fire in insertion order.
+    std::multimap<std::chrono::steady_clock::time_point, std::function<void()>> timers_;
+};
+
+DelayQueue& delayQueue() {
+    // Leaked on purpose: the timer thread outlives static destruction.
+    static auto* queue = new DelayQueue();
+    return *queue;
+}
+
+} // namespace
+
+void runAfter(std::chrono::steady_clock::duration delay, std::function<void()> callback) {
+    if (!callback) {
+        return;
+    }
+    delayQueue().add(std::chrono::steady_clock::now() + delay, std::move(callback));
+}
+
+} // namespace threadforge
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+
+namespace threadforge {
+
+// Runs callback on ThreadForge's timer thread once delay has elapsed. The
+// timer thread only hands work off (e.g. re-queues it on a pool); callbacks
+// must be short and must not block. Started on first use and kept for the
+// lifetime of the process.
+void runAfter(std::chrono::steady_clock::duration delay, std::function<void()> callback);
+
+} // namespace threadforge
@@ -0,0 +1,995 @@
+#include "Encoding.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+
+// Like SimdVector.h, the vector paths are picked at compile time from the
+// target's baseline. pshufb needs SSSE3, which every x86 Android ABI and Mac
+// includes; arm64 always has NEON. Plain SSE2 builds and armv7 take the
+// scalar loops, which every path also uses for its remainder.
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define THREADFORGE_CODEC_SSSE3 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define THREADFORGE_CODEC_NEON 1
+#endif
+
+namespace threadforge::encoding {
+
+namespace {
+
+constexpr uint8_t kInvalid = 0xFF;
+constexpr char kStandardAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+constexpr char kUrlAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+constexpr char kHexDigits[] = "0123456789abcdef";
+// U+FFFD REPLACEMENT CHARACTER in UTF-8.
+constexpr char kReplacement[] = "\xEF\xBF\xBD";
+
+struct Base64Tables {
+    char encode[64];
+    uint8_t decode[256];
+    // The SSSE3 encoder maps each sextet to a class (0 for a-z, 1-10 for
+    // 0-9, 11 and 12 for the last two characters, 13 for A-Z) and adds
+    // encodeShift[class] to it.
+    uint8_t encodeShift[16];
+    // The SSSE3 decoder rejects a character when validLow[low nibble] and
+    // validHigh[high nibble] share a bit, then adds roll[high nibble] to it.
+    // The last character shares its high nibble with others that need a
+    // different offset, so it gets lastFix on top.
+    uint8_t validLow[16];
+    uint8_t validHigh[16];
+    uint8_t roll[16];
+    uint8_t lastChar;
+    uint8_t lastFix;
+};
+
+Base64Tables makeTables(const char* alphabet) {
+    Base64Tables tables{};
+    std::memset(tables.decode, kInvalid, sizeof(tables.decode));
+    for (uint8_t i = 0; i < 64; ++i) {
+        tables.encode[i] = alphabet[i];
+        tables.decode[static_cast<uint8_t>(alphabet[i])] = i;
+    }
+
+    tables.encodeShift[0] = static_cast<uint8_t>('a' - 26);
+    for (int i = 1; i <= 10; ++i) {
+        tables.encodeShift[i] = static_cast<uint8_t>('0' - 52);
+    }
+    tables.encodeShift[11] = static_cast<uint8_t>(alphabet[62] - 62);
+    tables.encodeShift[12] = static_cast<uint8_t>(alphabet[63] - 63);
+    tables.encodeShift[13] = 'A';
+
+    // Every character of the alphabet has a high nibble from 2 to 7; each of
+    // those gets a bit, and bit 6 rejects everything else.
+    for (int high = 0; high < 16; ++high) {
+        tables.validHigh[high] = high >= 2 && high <= 7 ? static_cast<uint8_t>(1u << (high - 2)) : 0x40;
+    }
+    for (int low = 0; low < 16; ++low) {
+        uint8_t mask = 0x40;
+        for (int high = 2; high <= 7; ++high) {
+            if (tables.decode[(high << 4) | low] == kInvalid) {
+                mask |= static_cast<uint8_t>(1u << (high - 2));
+            }
+        }
+        tables.validLow[low] = mask;
+    }
+    for (uint8_t i = 0; i < 63; ++i) {
+        const auto c = static_cast<uint8_t>(alphabet[i]);
+        tables.roll[c >> 4] = static_cast<uint8_t>(i - c);
+    }
+    tables.lastChar = static_cast<uint8_t>(alphabet[63]);
+    tables.lastFix = static_cast<uint8_t>(63 - tables.lastChar - tables.roll[tables.lastChar >> 4]);
+    return tables;
+}
+
+const Base64Tables& tablesFor(Base64Alphabet alphabet) {
+    static const Base64Tables standard = makeTables(kStandardAlphabet);
+    static const Base64Tables url = makeTables(kUrlAlphabet);
+    return alphabet == Base64Alphabet::URL ? url : standard;
+}
+
+std::array<uint8_t, 256> makeHexTable() {
+    std::array<uint8_t, 256> table{};
+    table.fill(kInvalid);
+    for (uint8_t i = 0; i < 16; ++i) {
+        table[static_cast<uint8_t>(kHexDigits[i])] = i;
+        table[static_cast<uint8_t>(kHexDigits[i] & ~0x20)] = i;
+    }
+    return table;
+}
+
+const std::array<uint8_t, 256>& hexTable() {
+    static const auto table = makeHexTable();
+    return table;
+}
+
+// Decodes the UTF-8 sequence at the start of data (Unicode table 3-7).
+// Returns its length with codePoint set, or 0 when it is malformed, with
+// consumed set to the maximal subpart: the lead byte and whatever valid
+// continuation bytes follow it, which a decoder replaces with one U+FFFD.
+size_t decodeSequence(const uint8_t* data, size_t size, uint32_t& codePoint, size_t& consumed) {
+    const uint8_t lead = data[0];
+    if (lead < 0x80) {
+        codePoint = lead;
+        return 1;
+    }
+    size_t trailing;
+    uint8_t lowest = 0x80;
+    uint8_t highest = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        trailing = 1;
+        codePoint = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        trailing = 2;
+        codePoint = lead & 0x0F;
+        if (lead == 0xE0) {
+            lowest = 0xA0;  // overlong
+        } else if (lead == 0xED) {
+            highest = 0x9F;  // surrogates
+        }
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        trailing = 3;
+        codePoint = lead & 0x07;
+        if (lead == 0xF0) {
+            lowest = 0x90;  // overlong
+        } else if (lead == 0xF4) {
+            highest = 0x8F;  // past U+10FFFF
+        }
+    } else {
+        consumed = 1;
+        return 0;
+    }
+    for (size_t i = 1; i <= trailing; ++i) {
+        if (i >= size || data[i] < lowest || data[i] > highest) {
+            consumed = i;
+            return 0;
+        }
+        codePoint = (codePoint << 6) | (data[i] & 0x3F);
+        lowest = 0x80;
+        highest = 0xBF;
+    }
+    return trailing + 1;
+}
+
+size_t sequenceLengthOf(uint8_t lead) {
+    return lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+}
+
+bool asciiWord(const uint8_t* data) {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    return (word & 0x8080808080808080ull) == 0;
+}
+
+#if !defined(THREADFORGE_CODEC_SSSE3) && !defined(THREADFORGE_CODEC_NEON)
+bool validateScalar(const uint8_t* data, size_t size) {
+    size_t i = 0;
+    while (i < size) {
+        if (i + 8 <= size && asciiWord(data + i)) {
+            i += 8;
+            continue;
+        }
+        uint32_t codePoint;
+        size_t consumed;
+        const size_t length = decodeSequence(data + i, size - i, codePoint, consumed);
+        if (length == 0) {
+            return false;
+        }
+        i += length;
+    }
+    return true;
+}
+#endif
+
+// Transcodes one sequence of valid UTF-8 and returns the bytes it took.
+size_t transcodeSequence(const uint8_t* data, char16_t*& out) {
+    const uint8_t lead = data[0];
+    const size_t length = sequenceLengthOf(lead);
+    uint32_t codePoint;
+    switch (length) {
+        case 1:
+            codePoint = lead;
+            break;
+        case 2:
+            codePoint = ((lead & 0x1Fu) << 6) | (data[1] & 0x3Fu);
+            break;
+        case 3:
+            codePoint = ((lead & 0x0Fu) << 12) | ((data[1] & 0x3Fu) << 6) | (data[2] & 0x3Fu);
+            break;
+        default:
+            codePoint = ((lead & 0x07u) << 18) | ((data[1] & 0x3Fu) << 12) | ((data[2] & 0x3Fu) << 6) |
+                        (data[3] & 0x3Fu);
+            break;
+    }
+    if (codePoint >= 0x10000) {
+        codePoint -= 0x10000;
+        *out++ = static_cast<char16_t>(0xD800 + (codePoint >> 10));
+        *out++ = static_cast<char16_t>(0xDC00 + (codePoint & 0x3FF));
+    } else {
+        *out++ = static_cast<char16_t>(codePoint);
+    }
+    return length;
+}
+
+// Writes the code point at data[i] as UTF-8 and returns the units it took.
+// Unpaired surrogates come out as U+FFFD.
+size_t encodeUnit(const char16_t* data, size_t size, size_t i, uint8_t*& out) {
+    uint32_t codePoint = data[i];
+    size_t units = 1;
+    if (codePoint >= 0xD800 && codePoint <= 0xDFFF) {
+        if (codePoint <= 0xDBFF && i + 1 < size && data[i + 1] >= 0xDC00 && data[i + 1] <= 0xDFFF) {
+            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (data[i + 1] - 0xDC00);
+            units = 2;
+        } else {
+            codePoint = 0xFFFD;
+        }
+    }
+    if (codePoint < 0x80) {
+        *out++ = static_cast<uint8_t>(codePoint);
+    } else if (codePoint < 0x800) {
+        *out++ = static_cast<uint8_t>(0xC0 | (codePoint >> 6));
+        *out++ = static_cast<uint8_t>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+        *out++ = static_cast<uint8_t>(0xE0 | (codePoint >> 12));
+        *out++ = static_cast<uint8_t>(0x80 | ((codePoint >> 6) & 0x3F));
+        *out++ = static_cast<uint8_t>(0x80 | (codePoint & 0x3F));
+    } else {
+        *out++ = static_cast<uint8_t>(0xF0 | (codePoint >> 18));
+        *out++ = static_cast<uint8_t>(0x80 | ((codePoint >> 12) & 0x3F));
+        *out++ = static_cast<uint8_t>(0x80 | ((codePoint >> 6) & 0x3F));
+        *out++ = static_cast<uint8_t>(0x80 | (codePoint & 0x3F));
+    }
+    return units;
+}
+
+#if defined(THREADFORGE_CODEC_SSSE3) || defined(THREADFORGE_CODEC_NEON)
+
+// The byte-vector operations the UTF-8 validator and ASCII fast paths need.
+#if defined(THREADFORGE_CODEC_SSSE3)
+
+using Bytes = __m128i;
+
+inline Bytes load(const uint8_t* data) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)); }
+inline void store(uint8_t* out, Bytes v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(out), v); }
+inline Bytes splat(uint8_t value) { return _mm_set1_epi8(static_cast<char>(value)); }
+inline Bytes bitAnd(Bytes a, Bytes b) { return _mm_and_si128(a, b); }
+inline Bytes bitOr(Bytes a, Bytes b) { return _mm_or_si128(a, b); }
+inline Bytes bitXor(Bytes a, Bytes b) { return _mm_xor_si128(a, b); }
+inline Bytes subSaturate(Bytes a, Bytes b) { return _mm_subs_epu8(a, b); }
+inline Bytes highNibbles(Bytes v) { return _mm_and_si128(_mm_srli_epi16(v, 4), splat(0x0F)); }
+inline Bytes lowNibbles(Bytes v) { return _mm_and_si128(v, splat(0x0F)); }
+// table[index] per lane; index must be below 16.
+inline Bytes lookup(Bytes table, Bytes index) { return _mm_shuffle_epi8(table, index); }
+// input shifted right by N lanes, with the last N lanes of previous in front.
+template <int N>
+inline Bytes previous(Bytes input, Bytes previousInput) { return _mm_alignr_epi8(input, previousInput, 16 - N); }
+inline bool anyNonZero(Bytes v) { return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) != 0xFFFF; }
+inline bool anyHighBit(Bytes v) { return _mm_movemask_epi8(v) != 0; }
+
+// Widens 16 ASCII bytes to UTF-16.
+inline void widen(Bytes v, char16_t* out) {
+    const auto zero = _mm_setzero_si128();
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi8(v, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpackhi_epi8(v, zero));
+}
+
+// Narrows 16 UTF-16 units to bytes when all of them are ASCII.
+inline bool narrowAscii(const char16_t* data, uint8_t* out) {
+    const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 8));
+    const auto high = _mm_and_si128(_mm_or_si128(a, b), _mm_set1_epi16(static_cast<short>(0xFF80)));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128())) != 0xFFFF) {
+        return false;
+    }
+    store(out, _mm_packus_epi16(a, b));
+    return true;
+}
+
+#else
+
+using Bytes = uint8x16_t;
+
+inline Bytes load(const uint8_t* data) { return vld1q_u8(data); }
+inline void store(uint8_t* out, Bytes v) { vst1q_u8(out, v); }
+inline Bytes splat(uint8_t value) { return vdupq_n_u8(value); }
+inline Bytes bitAnd(Bytes a, Bytes b) { return vandq_u8(a, b); }
+inline Bytes bitOr(Bytes a, Bytes b) { return vorrq_u8(a, b); }
+inline Bytes bitXor(Bytes a, Bytes b) { return veorq_u8(a, b); }
+inline Bytes subSaturate(Bytes a, Bytes b) { return vqsubq_u8(a, b); }
+inline Bytes highNibbles(Bytes v) { return vshrq_n_u8(v, 4); }
+inline Bytes lowNibbles(Bytes v) { return vandq_u8(v, splat(0x0F)); }
+inline Bytes lookup(Bytes table, Bytes index) { return vqtbl1q_u8(table, index); }
+template <int N>
+inline Bytes previous(Bytes input, Bytes previousInput) { return vextq_u8(previousInput, input, 16 - N); }
+inline bool anyNonZero(Bytes v) { return vmaxvq_u8(v) != 0; }
+inline bool anyHighBit(Bytes v) { return vmaxvq_u8(v) >= 0x80; }
+
+inline void widen(Bytes v, char16_t* out) {
+    vst1q_u16(reinterpret_cast<uint16_t*>(out), vmovl_u8(vget_low_u8(v)));
+    vst1q_u16(reinterpret_cast<uint16_t*>(out + 8), vmovl_u8(vget_high_u8(v)));
+}
+
+inline bool narrowAscii(const char16_t* data, uint8_t* out) {
+    const auto a = vld1q_u16(reinterpret_cast<const uint16_t*>(data));
+    const auto b = vld1q_u16(reinterpret_cast<const uint16_t*>(data + 8));
+    if (vmaxvq_u16(vorrq_u16(a, b)) >= 0x80) {
+        return false;
+    }
+    store(out, vcombine_u8(vmovn_u16(a), vmovn_u16(b)));
+    return true;
+}
+
+#endif
+
+inline Bytes table16(const uint8_t (&values)[16]) { return load(values); }
+
+// Keiser and Lemire's lookup validator ("Validating UTF-8 In Less Than One
+// Instruction Per Byte", 2021). Each byte pair is classified by three nibble
+// lookups whose AND is non-zero exactly when the pair is an error; the
+// lookbacks two and three bytes back catch missing third and fourth bytes.
+class Utf8Validator {
+public:
+    void check(Bytes input) {
+        if (!anyHighBit(input)) {
+            // An ASCII block is fine unless the previous one ended mid-sequence.
+            error_ = bitOr(error_, incomplete_);
+        } else {
+            const auto previous1 = previous<1>(input, previous_);
+            const auto special = bitAnd(bitAnd(lookup(byte1High_, highNibbles(previous1)),
+                                               lookup(byte1Low_, lowNibbles(previous1))),
+                                        lookup(byte2High_, highNibbles(input)));
+            const auto third = subSaturate(previous<2>(input, previous_), splat(0xE0 - 0x80));
+            const auto fourth = subSaturate(previous<3>(input, previous_), splat(0xF0 - 0x80));
+            const auto mustContinue = bitAnd(bitOr(third, fourth), splat(0x80));
+            error_ = bitOr(error_, bitXor(mustContinue, special));
+            incomplete_ = subSaturate(input, maxValue_);
+        }
+        previous_ = input;
+    }
+
+    bool finish() {
+        return !anyNonZero(bitOr(error_, incomplete_));
+    }
+
+private:
+    static constexpr uint8_t kTooShort = 1 << 0;
+    static constexpr uint8_t kTooLong = 1 << 1;
+    static constexpr uint8_t kOverlong3 = 1 << 2;
+    static constexpr uint8_t kTooLarge = 1 << 3;
+    static constexpr uint8_t kSurrogate = 1 << 4;
+    static constexpr uint8_t kOverlong2 = 1 << 5;
+    static constexpr uint8_t kTooLarge1000 = 1 << 6;
+    static constexpr uint8_t kOverlong4 = 1 << 6;
+    static constexpr uint8_t kTwoConts = 1 << 7;
+    static constexpr uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+
+    static constexpr uint8_t kByte1High[16] = {
+        // 0xxx: ASCII
+        kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+        // 10xx: continuation
+        kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+        // 1100, 1101: two-byte lead
+        kTooShort | kOverlong2, kTooShort,
+        // 1110: three-byte lead
+        kTooShort | kOverlong3 | kSurrogate,
+        // 1111: four-byte lead
+        kTooShort | kTooLarge | kTooLarge1000 | kOverlong4};
+    static constexpr uint8_t kByte1Low[16] = {
+        kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+        kCarry | kOverlong2,
+        kCarry,
+        kCarry,
+        kCarry | kTooLarge,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000};
+    static constexpr uint8_t kByte2High[16] = {
+        // 0xxx: ASCII
+        kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+        // 1000
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+        // 1001
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+        // 101x
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        // 11xx: a lead byte
+        kTooShort, kTooShort, kTooShort, kTooShort};
+    // A lead byte in the last three lanes needs the next block to finish it.
+    static constexpr uint8_t kMaxValue[16] = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1};
+
+    Bytes byte1High_ = table16(kByte1High);
+    Bytes byte1Low_ = table16(kByte1Low);
+    Bytes byte2High_ = table16(kByte2High);
+    Bytes maxValue_ = table16(kMaxValue);
+    Bytes previous_ = splat(0);
+    Bytes error_ = splat(0);
+    Bytes incomplete_ = splat(0);
+};
+
+bool validateVector(const uint8_t* data, size_t size) {
+    Utf8Validator validator;
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        validator.check(load(data + i));
+    }
+    // The tail goes through zero-padded; the padding also flushes out a
+    // sequence cut off at the very end.
+    uint8_t tail[16] = {};
+    if (i < size) {
+        std::memcpy(tail, data + i, size - i);
+    }
+    validator.check(load(tail));
+    return validator.finish();
+}
+
+#endif
+
+} // namespace
+
+const char* simdBackend() {
+#if defined(THREADFORGE_CODEC_SSSE3)
+    return "ssse3";
+#elif defined(THREADFORGE_CODEC_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+size_t base64EncodedLength(size_t size, bool padded) {
+    return padded ? (size + 2) / 3 * 4 : size / 3 * 4 + (size % 3 == 0 ? 0 : size % 3 + 1);
+}
+
+void encodeBase64(const uint8_t* data, size_t size, char* out, Base64Alphabet alphabet, bool padded) {
+    const auto& tables = tablesFor(alphabet);
+    size_t i = 0;
+#if defined(THREADFORGE_CODEC_SSSE3)
+    // Muła's method: 12 input bytes are spread over four 32-bit lanes, the
+    // multiplies move each sextet into its own byte, and one shuffle maps the
+    // sextets to characters. Loads read 16 bytes, so the loop stops short.
+    const auto spread = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const auto shift = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.encodeShift));
+    for (; i + 16 <= size; i += 12, out += 16) {
+        const auto in = _mm_shuffle_epi8(load(data + i), spread);
+        const auto ac = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+        const auto bd = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+        const auto sextets = _mm_or_si128(ac, bd);
+        auto classes = _mm_subs_epu8(sextets, splat(51));
+        classes = _mm_or_si128(classes, _mm_and_si128(_mm_cmpgt_epi8(splat(26), sextets), splat(13)));
+        store(reinterpret_cast<uint8_t*>(out), _mm_add_epi8(_mm_shuffle_epi8(shift, classes), sextets));
+    }
+#elif defined(THREADFORGE_CODEC_NEON)
+    // 48 bytes de-interleave into three registers and come out as four
+    // registers of sextets, each mapped through a 64-byte table lookup.
+    uint8x16x4_t table;
+    for (int t = 0; t < 4; ++t) {
+        table.val[t] = vld1q_u8(reinterpret_cast<const uint8_t*>(tables.encode) + 16 * t);
+    }
+    const auto mask = vdupq_n_u8(63);
+    for (; i + 48 <= size; i += 48, out += 64) {
+        const auto in = vld3q_u8(data + i);
+        uint8x16x4_t chars;
+        chars.val[0] = vqtbl4q_u8(table, vshrq_n_u8(in.val[0], 2));
+        chars.val[1] = vqtbl4q_u8(table, vandq_u8(vorrq_u8(vshlq_n_u8(in.val[0], 4), vshrq_n_u8(in.val[1], 4)), mask));
+        chars.val[2] = vqtbl4q_u8(table, vandq_u8(vorrq_u8(vshlq_n_u8(in.val[1], 2), vshrq_n_u8(in.val[2], 6)), mask));
+        chars.val[3] = vqtbl4q_u8(table, vandq_u8(in.val[2], mask));
+        vst4q_u8(reinterpret_cast<uint8_t*>(out), chars);
+    }
+#endif
+    for (; i + 3 <= size; i += 3) {
+        const uint32_t word = (uint32_t{data[i]} << 16) | (uint32_t{data[i + 1]} << 8) | data[i + 2];
+        *out++ = tables.encode[word >> 18];
+        *out++ = tables.encode[(word >> 12) & 63];
+        *out++ = tables.encode[(word >> 6) & 63];
+        *out++ = tables.encode[word & 63];
+    }
+    if (i < size) {
+        const bool two = i + 1 < size;
+        const uint32_t word = (uint32_t{data[i]} << 16) | (two ? uint32_t{data[i + 1]} << 8 : 0);
+        *out++ = tables.encode[word >> 18];
+        *out++ = tables.encode[(word >> 12) & 63];
+        if (two) {
+            *out++ = tables.encode[(word >> 6) & 63];
+        } else if (padded) {
+            *out++ = '=';
+        }
+        if (padded) {
+            *out = '=';
+        }
+    }
+}
+
+size_t base64DecodedCapacity(size_t length) {
+    return length / 4 * 3 + (length % 4 == 0 ? 0 : length % 4 - 1);
+}
+
+size_t decodeBase64(const char* text, size_t length, uint8_t* out, Base64Alphabet alphabet) {
+    const auto& tables = tablesFor(alphabet);
+    size_t body = length;
+    if (body != 0 && text[body - 1] == '=') {
+        --body;
+        if (body != 0 && text[body - 1] == '=') {
+            --body;
+        }
+        // Padding only ever completes the last quad.
+        if (length % 4 != 0) {
+            return SIZE_MAX;
+        }
+    }
+    if (body % 4 == 1) {
+        return SIZE_MAX;
+    }
+
+    const auto* in = reinterpret_cast<const uint8_t*>(text);
+    uint8_t* const start = out;
+    size_t i = 0;
+#if defined(THREADFORGE_CODEC_SSSE3)
+    // Each block of 16 characters is checked against nibble masks, turned into
+    // sextets by adding a per-nibble offset, and packed into 12 bytes by two
+    // multiply-adds and a shuffle. Stores write 16 bytes, so the loop stops
+    // while at least 8 more characters (6 or more bytes) follow.
+    const auto validLow = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.validLow));
+    const auto validHigh = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.validHigh));
+    const auto roll = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.roll));
+    const auto pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    for (; i + 24 <= body; i += 16, out += 12) {
+        const auto chars = load(in + i);
+        const auto high = highNibbles(chars);
+        if (anyNonZero(_mm_and_si128(_mm_shuffle_epi8(validLow, lowNibbles(chars)),
+                                     _mm_shuffle_epi8(validHigh, high)))) {
+            return SIZE_MAX;
+        }
+        const auto offsets = _mm_add_epi8(
+            _mm_shuffle_epi8(roll, high),
+            _mm_and_si128(_mm_cmpeq_epi8(chars, splat(tables.lastChar)), splat(tables.lastFix)));
+        const auto sextets = _mm_add_epi8(chars, offsets);
+        const auto pairs = _mm_maddubs_epi16(sextets, _mm_set1_epi32(0x01400140));
+        const auto words = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+        store(out, _mm_shuffle_epi8(words, pack));
+    }
+#elif defined(THREADFORGE_CODEC_NEON)
+    // 64 characters de-interleave into four registers of sextets through two
+    // 64-byte table lookups (characters below and above 64), then pack into
+    // three registers of bytes.
+    uint8x16x4_t lower;
+    uint8x16x4_t upper;
+    for (int t = 0; t < 4; ++t) {
+        lower.val[t] = vld1q_u8(tables.decode + 16 * t);
+        upper.val[t] = vld1q_u8(tables.decode + 64 + 16 * t);
+    }
+    const auto flip = vdupq_n_u8(0x40);
+    for (; i + 64 <= body; i += 64, out += 48) {
+        const auto chars = vld4q_u8(in + i);
+        uint8x16_t sextets[4];
+        uint8x16_t invalid = vdupq_n_u8(0);
+        for (int t = 0; t < 4; ++t) {
+            // Out-of-range indices give 0, so each character hits one table;
+            // kInvalid entries and non-ASCII characters both set bit 7.
+            sextets[t] =
+                vorrq_u8(vqtbl4q_u8(lower, chars.val[t]), vqtbl4q_u8(upper, veorq_u8(chars.val[t], flip)));
+            invalid = vorrq_u8(invalid, vorrq_u8(sextets[t], chars.val[t]));
+        }
+        if (vmaxvq_u8(invalid) >= 0x80) {
+            return SIZE_MAX;
+        }
+        uint8x16x3_t bytes;
+        bytes.val[0] = vorrq_u8(vshlq_n_u8(sextets[0], 2), vshrq_n_u8(sextets[1], 4));
+        bytes.val[1] = vorrq_u8(vshlq_n_u8(sextets[1], 4), vshrq_n_u8(sextets[2], 2));
+        bytes.val[2] = vorrq_u8(vshlq_n_u8(sextets[2], 6), sextets[3]);
+        vst3q_u8(out, bytes);
+    }
+#endif
+    uint8_t invalid = 0;
+    for (; i + 4 <= body; i += 4) {
+        const uint8_t a = tables.decode[in[i]];
+        const uint8_t b = tables.decode[in[i + 1]];
+        const uint8_t c = tables.decode[in[i + 2]];
+        const uint8_t d = tables.decode[in[i + 3]];
+        invalid |= a | b | c | d;
+        const uint32_t word = (uint32_t{a} << 18) | (uint32_t{b} << 12) | (uint32_t{c} << 6) | d;
+        *out++ = static_cast<uint8_t>(word >> 16);
+        *out++ = static_cast<uint8_t>(word >> 8);
+        *out++ = static_cast<uint8_t>(word);
+    }
+    if (i < body) {
+        // Two or three characters: one or two bytes.
+        const uint8_t a = tables.decode[in[i]];
+        const uint8_t b = tables.decode[in[i + 1]];
+        const uint8_t c = body - i == 3 ? tables.decode[in[i + 2]] : 0;
+        invalid |= a | b | c;
+        const uint32_t word = (uint32_t{a} << 18) | (uint32_t{b} << 12) | (uint32_t{c} << 6);
+        *out++ = static_cast<uint8_t>(word >> 16);
+        if (body - i == 3) {
+            *out++ = static_cast<uint8_t>(word >> 8);
+        }
+    }
+    // Valid sextets stay below 64, so any kInvalid lookup shows up in bit 7.
+    if (invalid & 0x80) {
+        return SIZE_MAX;
+    }
+    return static_cast<size_t>(out - start);
+}
+
+void encodeHex(const uint8_t* data, size_t size, char* out) {
+    size_t i = 0;
+#if defined(THREADFORGE_CODEC_SSSE3) || defined(THREADFORGE_CODEC_NEON)
+    const auto digits = load(reinterpret_cast<const uint8_t*>(kHexDigits));
+    for (; i + 16 <= size; i += 16, out += 32) {
+        const auto in = load(data + i);
+        const auto high = lookup(digits, highNibbles(in));
+        const auto low = lookup(digits, lowNibbles(in));
+#if defined(THREADFORGE_CODEC_SSSE3)
+        store(reinterpret_cast<uint8_t*>(out), _mm_unpacklo_epi8(high, low));
+        store(reinterpret_cast<uint8_t*>(out + 16), _mm_unpackhi_epi8(high, low));
+#else
+        vst2q_u8(reinterpret_cast<uint8_t*>(out), uint8x16x2_t{{high, low}});
+#endif
+    }
+#endif
+    for (; i < size; ++i) {
+        *out++ = kHexDigits[data[i] >> 4];
+        *out++ = kHexDigits[data[i] & 15];
+    }
+}
+
+bool decodeHex(const char* text, size_t length, uint8_t* out) {
+    if (length % 2 != 0) {
+        return false;
+    }
+    const auto* in = reinterpret_cast<const uint8_t*>(text);
+    size_t i = 0;
+#if defined(THREADFORGE_CODEC_SSSE3) || defined(THREADFORGE_CODEC_NEON)
+    // Digits and letters (either case, folded by setting bit 5) become
+    // nibbles by subtraction; anything outside both ranges fails the block.
+#if defined(THREADFORGE_CODEC_SSSE3)
+    const auto nibbles = [](Bytes chars, Bytes& valid) {
+        const auto digit = _mm_sub_epi8(chars, splat('0'));
+        const auto letter = _mm_sub_epi8(_mm_or_si128(chars, splat(0x20)), splat('a'));
+        const auto isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digit, splat(9)), digit);
+        const auto isLetter = _mm_cmpeq_epi8(_mm_min_epu8(letter, splat(5)), letter);
+        valid = _mm_and_si128(valid, _mm_or_si128(isDigit, isLetter));
+        return _mm_or_si128(_mm_and_si128(isDigit, digit),
+                            _mm_and_si128(isLetter, _mm_add_epi8(letter, splat(10))));
+    };
+    for (; i + 32 <= length; i += 32, out += 16) {
+        auto valid = splat(0xFF);
+        const auto first = nibbles(load(in + i), valid);
+        const auto second = nibbles(load(in + i + 16), valid);
+        if (_mm_movemask_epi8(valid) != 0xFFFF) {
+            return false;
+        }
+        // Each even lane is the high nibble: 16 * even + odd per 16-bit lane.
+        const auto weights = _mm_set1_epi16(0x0110);
+        store(out, _mm_packus_epi16(_mm_maddubs_epi16(first, weights), _mm_maddubs_epi16(second, weights)));
+    }
+#else
+    const auto nibbles = [](Bytes chars, Bytes& valid) {
+        const auto digit = vsubq_u8(chars, splat('0'));
+        const auto letter = vsubq_u8(vorrq_u8(chars, splat(0x20)), splat('a'));
+        const auto isDigit = vcltq_u8(digit, splat(10));
+        const auto isLetter = vcltq_u8(letter, splat(6));
+        valid = vandq_u8(valid, vorrq_u8(isDigit, isLetter));
+        return vbslq_u8(isDigit, digit, vaddq_u8(letter, splat(10)));
+    };
+    for (; i + 32 <= length; i += 32, out += 16) {
+        const auto chars = vld2q_u8(in + i);
+        auto valid = splat(0xFF);
+        const auto high = nibbles(chars.val[0], valid);
+        const auto low = nibbles(chars.val[1], valid);
+        if (vminvq_u8(valid) == 0) {
+            return false;
+        }
+        store(out, vorrq_u8(vshlq_n_u8(high, 4), low));
+    }
+#endif
+#endif
+    const auto& table = hexTable();
+    uint8_t invalid = 0;
+    for (; i < length; i += 2) {
+        const uint8_t high = table[in[i]];
+        const uint8_t low = table[in[i + 1]];
+        invalid |= high | low;
+        *out++ = static_cast<uint8_t>((high << 4) | (low & 15));
+    }
+    return (invalid & 0x80) == 0;
+}
+
+bool isAscii(const uint8_t* data, size_t size) {
+    size_t i = 0;
+#if defined(THREADFORGE_CODEC_SSSE3) || defined(THREADFORGE_CODEC_NEON)
+    for (; i + 64 <= size; i += 64) {
+        const auto any = bitOr(bitOr(load(data + i), load(data + i + 16)), bitOr(load(data + i + 32), load(data + i + 48)));
+        if (anyHighBit(any)) {
+            return false;
+        }
+    }
+#endif
+    for (; i + 8 <= size; i += 8) {
+        if (!asciiWord(data + i)) {
+            return false;
+        }
+    }
+    for (; i < size; ++i) {
+        if (data[i] >= 0x80) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool validateUtf8(const uint8_t* data, size_t size) {
+#if defined(THREADFORGE_CODEC_SSSE3) || defined(THREADFORGE_CODEC_NEON)
+    return validateVector(data, size);
+#else
+    return validateScalar(data, size);
+#endif
+}
+
+size_t utf16Length(const uint8_t* data, size_t size) {
+    // One unit per lead byte, and a second for each four-byte sequence.
+    size_t units = 0;
+    for (size_t i = 0; i < size; ++i) {
+        units += (data[i] & 0xC0) != 0x80;
+        units += data[i] >= 0xF0;
+    }
+    return units;
+}
+
+size_t utf8ToUtf16(const uint8_t* data, size_t size, char16_t* out) {
+    if (!validateUtf8(data, size)) {
+        return SIZE_MAX;
+    }
+    char16_t* const start = out;
+    size_t i = 0;
+    while (i < size) {
+#if defined(THREADFORGE_CODEC_SSSE3) || defined(THREADFORGE_CODEC_NEON)
+        if (i + 16 <= size) {
+            const auto block = load(data + i);
+            if (!anyHighBit(block)) {
+                widen(block, out);
+                out += 16;
+                i += 16;
+                continue;
+            }
+            // Mixed blocks go one sequence at a time; the next full block
+            // gets another try at the fast path.
+            const size_t end = i + 16;
+            while (i < end) {
+                i += transcodeSequence(data + i, out);
+            }
+            continue;
+        }
+#endif
+        i += transcodeSequence(data + i, out);
+    }
+    return static_cast<size_t>(out - start);
+}
+
+size_t utf8Length(const char16_t* data, size_t size) {
+    size_t bytes = 0;
+    for (size_t i = 0; i < size; ++i) {
+        const char16_t unit = data[i];
+        if (unit < 0x80) {
+            bytes += 1;
+        } else if (unit < 0x800) {
+            bytes += 2;
+        } else if (unit >= 0xD800 && unit <= 0xDBFF && i + 1 < size && data[i + 1] >= 0xDC00 &&
+                   data[i + 1] <= 0xDFFF) {
+            bytes += 4;
+            ++i;
+        } else {
+            // The BMP, and U+FFFD for an unpaired surrogate.
+            bytes += 3;
+        }
+    }
+    return bytes;
+}
+
+size_t utf16ToUtf8(const char16_t* data, size_t size, uint8_t* out) {
+    uint8_t* const start = out;
+    size_t i = 0;
+    while (i < size) {
+#if defined(THREADFORGE_CODEC_SSSE3) || defined(THREADFORGE_CODEC_NEON)
+        if (i + 16 <= size && narrowAscii(data + i, out)) {
+            out += 16;
+            i += 16;
+            continue;
+        }
+        if (i + 16 <= size) {
+            const size_t end = i + 16;
+            while (i < end) {
+                i += encodeUnit(data, size, i, out);
+            }
+            continue;
+        }
+#endif
+        i += encodeUnit(data, size, i, out);
+    }
+    return static_cast<size_t>(out - start);
+}
+
+bool isWellFormedUtf16(const char16_t* data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        const char16_t unit = data[i];
+        if (unit < 0xD800 || unit > 0xDFFF) {
+            continue;
+        }
+        if (unit > 0xDBFF || i + 1 >= size || data[i + 1] < 0xDC00 || data[i + 1] > 0xDFFF) {
+            return false;
+        }
+        ++i;
+    }
+    return true;
+}
+
+std::string replaceInvalidUtf8(const uint8_t* data, size_t size) {
+    if (validateUtf8(data, size)) {
+        return std::string(reinterpret_cast<const char*>(data), size);
+    }
+    std::string text;
+    text.reserve(size + size / 2);
+    size_t i = 0;
+    while (i < size) {
+        uint32_t codePoint;
+        size_t consumed;
+        const size_t length = decodeSequence(data + i, size - i, codePoint, consumed);
+        if (length == 0) {
+            text.append(kReplacement, 3);
+            i += consumed;
+        } else {
+            text.append(reinterpret_cast<const char*>(data + i), length);
+            i += length;
+        }
+    }
+    return text;
+}
+
+size_t incompleteUtf8Suffix(const uint8_t* data, size_t size) {
+    for (size_t k = size < 3 ? size : 3; k > 0; --k) {
+        const uint8_t* tail = data + size - k;
+        if (*tail < 0xC2 || *tail > 0xF4) {
+            continue;
+        }
+        uint32_t codePoint;
+        size_t consumed;
+        // A valid prefix fails only for running out of input.
+        if (decodeSequence(tail, k, codePoint, consumed) == 0 && consumed == k) {
+            return k;
+        }
+    }
+    return 0;
+}
+
+bool TextDecoder::parseLabel(const std::string& label, Kind& kind) {
+    static const char* const kUtf8Labels[] = {
+        "unicode-1-1-utf-8", "unicode11utf8", "unicode20utf8", "utf-8", "utf8", "x-unicode20utf8"};
+    static const char* const kUtf16Labels[] = {
+        "csunicode", "iso-10646-ucs-2", "ucs-2", "unicode", "unicodefeff", "utf-16", "utf-16le"};
+    const auto isSpace = [](unsigned char c) {
+        return std::isspace(c) != 0;
+    };
+    const auto begin = std::find_if_not(label.begin(), label.end(), isSpace);
+    const auto end = std::find_if_not(label.rbegin(), label.rend(), isSpace).base();
+    std::string name(begin, begin < end ? end : begin);
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    for (const char* candidate : kUtf8Labels) {
+        if (name == candidate) {
+            kind = Kind::UTF8;
+            return true;
+        }
+    }
+    for (const char* candidate : kUtf16Labels) {
+        if (name == candidate) {
+            kind = Kind::UTF16LE;
+            return true;
+        }
+    }
+    return false;
+}
+
+TextDecoder::TextDecoder(Kind kind, bool fatal, bool ignoreBOM)
+    : kind_(kind),
+      fatal_(fatal),
+      ignoreBOM_(ignoreBOM) {}
+
+const char* TextDecoder::encoding() const {
+    return kind_ == Kind::UTF8 ? "utf-8" : "utf-16le";
+}
+
+std::string TextDecoder::decode(const uint8_t* data, size_t size, bool stream) {
+    std::vector<uint8_t> joined;
+    if (!pending_.empty()) {
+        joined.swap(pending_);
+        joined.insert(joined.end(), data, data + size);
+        data = joined.data();
+        size = joined.size();
+    }
+
+    if (!bomSeen_) {
+        static constexpr uint8_t kUtf8Bom[] = {0xEF, 0xBB, 0xBF};
+        static constexpr uint8_t kUtf16Bom[] = {0xFF, 0xFE};
+        const uint8_t* bom = kind_ == Kind::UTF8 ? kUtf8Bom : kUtf16Bom;
+        const size_t bomSize = kind_ == Kind::UTF8 ? sizeof(kUtf8Bom) : sizeof(kUtf16Bom);
+        if (stream && size < bomSize && (size == 0 || std::memcmp(data, bom, size) == 0)) {
+            // Could still turn out to be a byte order mark.
+            pending_.assign(data, data + size);
+            return {};
+        }
+        bomSeen_ = true;
+        if (!ignoreBOM_ && size >= bomSize && std::memcmp(data, bom, bomSize) == 0) {
+            data += bomSize;
+            size -= bomSize;
+        }
+    }
+
+    size_t keep = 0;
+    std::string text;
+    bool malformed = false;
+    if (kind_ == Kind::UTF8) {
+        keep = stream ? incompleteUtf8Suffix(data, size) : 0;
+        const size_t length = size - keep;
+        if (validateUtf8(data, length)) {
+            text.assign(reinterpret_cast<const char*>(data), length);
+        } else if (!fatal_) {
+            text = replaceInvalidUtf8(data, length);
+        } else {
+            malformed = true;
+        }
+    } else {
+        // Units are little-endian, as is every platform React Native runs on.
+        size_t units = size / 2;
+        keep = size % 2;
+        if (stream && units != 0) {
+            uint16_t last;
+            std::memcpy(&last, data + 2 * (units - 1), sizeof(last));
+            if (last >= 0xD800 && last <= 0xDBFF) {
+                --units;
+                keep += 2;
+            }
+        }
+        std::vector<char16_t> buffer(units);
+        if (units != 0) {
+            std::memcpy(buffer.data(), data, units * 2);
+        }
+        // Without stream, keep is a lone trailing byte: one more U+FFFD.
+        const bool oddByte = !stream && keep != 0;
+        if (fatal_ && (oddByte || !isWellFormedUtf16(buffer.data(), units))) {
+            malformed = true;
+        } else {
+            text.resize(utf8Length(buffer.data(), units));
+            utf16ToUtf8(buffer.data(), units, reinterpret_cast<uint8_t*>(text.data()));
+            if (oddByte) {
+                text.append(kReplacement, 3);
+            }
+        }
+    }
+
+    if (stream && !malformed) {
+        pending_.assign(data + size - keep, data + size);
+    } else {
+        // The end of a stream (or a failed one) starts the next afresh.
+        bomSeen_ = false;
+    }
+    if (malformed) {
+        throw std::invalid_argument(std::string("the data is not valid ") + encoding());
+    }
+    return text;
+}
+
+} // namespace threadforge::encoding
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace threadforge::encoding {
+
+// Binary-to-text codecs and UTF-8 handling. The bulk of each loop runs 16
+// (SSSE3) or 64 (NEON) bytes at a time when the build target has the
+// instructions, with a scalar path for the rest and for other targets.
+// "ssse3", "neon" or "scalar".
+const char* simdBackend();
+
+enum class Base64Alphabet : uint8_t {
+    // RFC 4648 section 4: A-Z a-z 0-9 + /
+    STANDARD,
+    // RFC 4648 section 5: A-Z a-z 0-9 - _
+    URL
+};
+
+// Characters encodeBase64() writes for size bytes.
+size_t base64EncodedLength(size_t size, bool padded);
+void encodeBase64(const uint8_t* data,
+                  size_t size,
+                  char* out,
+                  Base64Alphabet alphabet = Base64Alphabet::STANDARD,
+                  bool padded = true);
+
+// Room decodeBase64() may need for length characters.
+size_t base64DecodedCapacity(size_t length);
+// Decodes text into out and returns the byte count, or SIZE_MAX when text
+// has characters outside the alphabet or a length no encoder produces.
+// Padding is optional, but when present it must be correct.
+size_t decodeBase64(const char* text,
+                    size_t length,
+                    uint8_t* out,
+                    Base64Alphabet alphabet = Base64Alphabet::STANDARD);
+
+// Lowercase hex, 2 * size characters.
+void encodeHex(const uint8_t* data, size_t size, char* out);
+// length / 2 bytes into out; false on an odd length or a non-hex digit
+// (either case is accepted).
+bool decodeHex(const char* text, size_t length, uint8_t* out);
+
+bool isAscii(const uint8_t* data, size_t size);
+// Well-formed UTF-8 per RFC 3629: no overlong forms, surrogates or code
+// points past U+10FFFF, and no sequence cut off at the end.
+bool validateUtf8(const uint8_t* data, size_t size);
+
+// UTF-16 code units the UTF-8 in data decodes to; data must be valid.
+size_t utf16Length(const uint8_t* data, size_t size);
+// Transcodes UTF-8 to UTF-16 (out needs utf16Length() units) and returns the
+// units written, or SIZE_MAX if data is not valid UTF-8.
+size_t utf8ToUtf16(const uint8_t* data, size_t size, char16_t* out);
+
+// UTF-8 bytes the UTF-16 in data encodes to. Unpaired surrogates count as
+// U+FFFD, which is what utf16ToUtf8() writes for them.
+size_t utf8Length(const char16_t* data, size_t size);
+size_t utf16ToUtf8(const char16_t* data, size_t size, uint8_t* out);
+// False when data has an unpaired surrogate.
+bool isWellFormedUtf16(const char16_t* data, size_t size);
+
+// data with every malformed sequence replaced by U+FFFD, one per maximal
+// subpart as the WHATWG decoder does.
+std::string replaceInvalidUtf8(const uint8_t* data, size_t size);
+
+// Bytes at the end of data that start a sequence more input could still
+// complete (0 to 3). A streaming decoder holds these back.
+size_t incompleteUtf8Suffix(const uint8_t* data, size_t size);
+
+// The WHATWG TextDecoder algorithm for UTF-8 and UTF-16LE input, producing
+// UTF-8 (what a JSI string is created from).
+class TextDecoder {
+public:
+    enum class Kind : uint8_t { UTF8, UTF16LE };
+
+    // Maps a WHATWG label ("utf8", "unicode-1-1-utf-8", "utf-16", ...) to its
+    // encoding, ignoring case and surrounding whitespace. False for labels of
+    // any other encoding.
+    static bool parseLabel(const std::string& label, Kind& kind);
+
+    TextDecoder(Kind kind, bool fatal, bool ignoreBOM);
+
+    // With stream set, bytes the next call may complete are held back until
+    // then. Malformed input becomes U+FFFD, or throws std::invalid_argument
+    // when fatal. A leading byte order mark is dropped unless ignoreBOM.
+    std::string decode(const uint8_t* data, size_t size, bool stream);
+
+    // "utf-8" or "utf-16le".
+    const char* encoding() const;
+    bool fatal() const {
+        return fatal_;
+    }
+    bool ignoreBOM() const {
+        return ignoreBOM_;
+    }
+
+private:
+    Kind kind_;
+    bool fatal_;
+    bool ignoreBOM_;
+    bool bomSeen_{false};
+    std::vector<uint8_t> pending_;
+};
+
+} // namespace threadforge::encoding
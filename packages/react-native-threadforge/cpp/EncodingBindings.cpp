@@ -0,0 +1,267 @@
+#include "EncodingBindings.h"
+
+#include <algorithm>
+#include <jsi/jsi.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BindingHelpers.h"
+#include "Encoding.h"
+#include "TypedArrayView.h"
+
+namespace threadforge {
+
+namespace {
+
+using facebook::jsi::JSError;
+using facebook::jsi::Object;
+using facebook::jsi::Runtime;
+using facebook::jsi::String;
+using facebook::jsi::StringBuffer;
+using facebook::jsi::Value;
+
+// TextEncoder and TextDecoder are plain ES5 constructors over the native
+// codec, since host functions cannot be called with `new` on every engine.
+// The wrapper only shapes arguments; the work happens in Encoding.cpp.
+constexpr const char* kTextCodecSource = R"JS((function (codec, global) {
+  'use strict';
+  function TextEncoder() {
+    if (!(this instanceof TextEncoder)) {
+      throw new TypeError("Constructor TextEncoder requires 'new'");
+    }
+  }
+  Object.defineProperty(TextEncoder.prototype, 'encoding', {
+    get: function () { return 'utf-8'; },
+  });
+  TextEncoder.prototype.encode = function (input) {
+    return codec.encode(input === undefined ? '' : String(input));
+  };
+  TextEncoder.prototype.encodeInto = function (source, destination) {
+    return codec.encodeInto(String(source), destination);
+  };
+
+  function TextDecoder(label, options) {
+    if (!(this instanceof TextDecoder)) {
+      throw new TypeError("Constructor TextDecoder requires 'new'");
+    }
+    options = options || {};
+    Object.defineProperty(this, '_decoder', {
+      value: codec.createDecoder(label === undefined ? 'utf-8' : String(label), !!options.fatal, !!options.ignoreBOM),
+    });
+  }
+  ['encoding', 'fatal', 'ignoreBOM'].forEach(function (name) {
+    Object.defineProperty(TextDecoder.prototype, name, {
+      get: function () { return this._decoder[name]; },
+    });
+  });
+  TextDecoder.prototype.decode = function (input, options) {
+    if (typeof DataView !== 'undefined' && input instanceof DataView) {
+      input = new Uint8Array(input.buffer, input.byteOffset, input.byteLength);
+    }
+    return this._decoder.decode(input, !!(options && options.stream));
+  };
+
+  if (typeof global.TextEncoder !== 'function') {
+    global.TextEncoder = TextEncoder;
+  }
+  if (typeof global.TextDecoder !== 'function') {
+    global.TextDecoder = TextDecoder;
+  }
+}))JS";
+
+std::string textArgument(Runtime& rt, const Value* args, size_t count, const char* method) {
+    const auto& value = argumentAt(args, count, 0);
+    if (!value.isString()) {
+        throw JSError(rt, std::string("nativeEncoding.") + method + " expects a string");
+    }
+    return value.getString(rt).utf8(rt);
+}
+
+encoding::Base64Alphabet alphabetOption(Runtime& rt, const Value& options) {
+    if (!options.isObject()) {
+        return encoding::Base64Alphabet::STANDARD;
+    }
+    const auto value = options.getObject(rt).getProperty(rt, "alphabet");
+    const auto name = value.isString() ? value.getString(rt).utf8(rt) : std::string();
+    if (value.isUndefined() || name == "base64") {
+        return encoding::Base64Alphabet::STANDARD;
+    }
+    if (name == "base64url") {
+        return encoding::Base64Alphabet::URL;
+    }
+    throw std::invalid_argument("alphabet must be 'base64' or 'base64url'");
+}
+
+bool boolOption(Runtime& rt, const Value& options, const char* name) {
+    if (!options.isObject()) {
+        return false;
+    }
+    const auto value = options.getObject(rt).getProperty(rt, name);
+    return value.isBool() && value.getBool();
+}
+
+Object makeDecoder(Runtime& rt, std::shared_ptr<encoding::TextDecoder> decoder) {
+    Object object(rt);
+    object.setProperty(rt, "encoding", String::createFromAscii(rt, decoder->encoding()));
+    object.setProperty(rt, "fatal", decoder->fatal());
+    object.setProperty(rt, "ignoreBOM", decoder->ignoreBOM());
+    setFunction(rt, object, "decode", 2, [decoder](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto& input = argumentAt(args, count, 0);
+        const bool stream = argumentAt(args, count, 1).isBool() && argumentAt(args, count, 1).getBool();
+        std::string text;
+        if (input.isUndefined()) {
+            text = decoder->decode(nullptr, 0, stream);
+        } else {
+            text = withBytes(runtime, input, false, [&](const uint8_t* data, size_t size) {
+                return decoder->decode(data, size, stream);
+            });
+        }
+        return Value(String::createFromUtf8(runtime, text));
+    });
+    return object;
+}
+
+Object makeTextCodec(Runtime& rt) {
+    Object codec(rt);
+
+    setFunction(rt, codec, "encode", 1, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto text = argumentAt(args, count, 0).getString(runtime).utf8(runtime);
+        return bytesValue(runtime, std::vector<uint8_t>(text.begin(), text.end()));
+    });
+
+    setFunction(rt, codec, "encodeInto", 2, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto text = argumentAt(args, count, 0).getString(runtime).utf8(runtime);
+        const auto destination = typedArrayView(runtime, argumentAt(args, count, 1));
+        if (destination.type != "Uint8Array") {
+            throw JSError(runtime, "TextEncoder.encodeInto expects a Uint8Array destination");
+        }
+        const auto* data = reinterpret_cast<const uint8_t*>(text.data());
+        // Only whole characters go in, so back off to a sequence boundary.
+        size_t written = text.size() < destination.length ? text.size() : destination.length;
+        while (written < text.size() && written > 0 && (data[written] & 0xC0) == 0x80) {
+            --written;
+        }
+        std::copy(data, data + written, destination.data);
+        Object result(runtime);
+        result.setProperty(runtime, "read", static_cast<double>(encoding::utf16Length(data, written)));
+        result.setProperty(runtime, "written", static_cast<double>(written));
+        return Value(std::move(result));
+    });
+
+    setFunction(rt, codec, "createDecoder", 3, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto label = argumentAt(args, count, 0).getString(runtime).utf8(runtime);
+        encoding::TextDecoder::Kind kind;
+        if (!encoding::TextDecoder::parseLabel(label, kind)) {
+            throw JSError(runtime, "TextDecoder: unsupported encoding '" + label + "'; use 'utf-8' or 'utf-16le'");
+        }
+        return Value(makeDecoder(runtime,
+                                 std::make_shared<encoding::TextDecoder>(kind,
+                                                                         argumentAt(args, count, 1).getBool(),
+                                                                         argumentAt(args, count, 2).getBool())));
+    });
+
+    return codec;
+}
+
+void installTextCodec(Runtime& rt) {
+    auto global = rt.global();
+    if (global.getProperty(rt, "TextEncoder").isObject() && global.getProperty(rt, "TextDecoder").isObject()) {
+        return;
+    }
+    const auto install = rt.evaluateJavaScript(std::make_shared<StringBuffer>(kTextCodecSource), "ThreadForgeTextCodec");
+    install.getObject(rt).getFunction(rt).call(rt, makeTextCodec(rt), global);
+}
+
+} // namespace
+
+void installEncodingBindings(Runtime& rt) {
+    Object nativeEncoding(rt);
+
+    setFunction(
+        rt, nativeEncoding, "base64Encode", 2, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+            const auto& options = argumentAt(args, count, 1);
+            const auto alphabet = alphabetOption(runtime, options);
+            const bool padded = !boolOption(runtime, options, "omitPadding");
+            std::string text;
+            withBytes(runtime, argumentAt(args, count, 0), true, [&](const uint8_t* data, size_t size) {
+                text.resize(encoding::base64EncodedLength(size, padded));
+                encoding::encodeBase64(data, size, text.data(), alphabet, padded);
+            });
+            return Value(String::createFromAscii(runtime, text));
+        });
+
+    setFunction(
+        rt, nativeEncoding, "base64Decode", 2, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+            const auto text = textArgument(runtime, args, count, "base64Decode");
+            std::vector<uint8_t> bytes(encoding::base64DecodedCapacity(text.size()));
+            const size_t size = encoding::decodeBase64(
+                text.data(), text.size(), bytes.data(), alphabetOption(runtime, argumentAt(args, count, 1)));
+            if (size == SIZE_MAX) {
+                throw JSError(runtime, "nativeEncoding.base64Decode: the text is not valid base64");
+            }
+            bytes.resize(size);
+            return bytesValue(runtime, std::move(bytes));
+        });
+
+    setFunction(rt, nativeEncoding, "hexEncode", 1, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        std::string text;
+        withBytes(runtime, argumentAt(args, count, 0), true, [&](const uint8_t* data, size_t size) {
+            text.resize(size * 2);
+            encoding::encodeHex(data, size, text.data());
+        });
+        return Value(String::createFromAscii(runtime, text));
+    });
+
+    setFunction(rt, nativeEncoding, "hexDecode", 1, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto text = textArgument(runtime, args, count, "hexDecode");
+        TypedArrayView view;
+        auto bytes = makeTypedArray(runtime, "Uint8Array", text.size() / 2, view);
+        if (!encoding::decodeHex(text.data(), text.size(), view.data)) {
+            throw JSError(runtime, "nativeEncoding.hexDecode: the text is not an even number of hex digits");
+        }
+        return bytes;
+    });
+
+    setFunction(rt, nativeEncoding, "isUtf8", 1, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        return Value(withBytes(runtime, argumentAt(args, count, 0), false, [](const uint8_t* data, size_t size) {
+            return encoding::validateUtf8(data, size);
+        }));
+    });
+
+    setFunction(
+        rt, nativeEncoding, "utf8ToUtf16", 1, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+            return withBytes(runtime, argumentAt(args, count, 0), false, [&](const uint8_t* data, size_t size) {
+                if (!encoding::validateUtf8(data, size)) {
+                    throw JSError(runtime, "nativeEncoding.utf8ToUtf16: the data is not valid UTF-8");
+                }
+                TypedArrayView view;
+                auto units = makeTypedArray(runtime, "Uint16Array", encoding::utf16Length(data, size), view);
+                encoding::utf8ToUtf16(data, size, reinterpret_cast<char16_t*>(view.data));
+                return units;
+            });
+        });
+
+    setFunction(
+        rt, nativeEncoding, "utf16ToUtf8", 1, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+            const auto view = typedArrayView(runtime, argumentAt(args, count, 0));
+            if (view.type != "Uint16Array") {
+                throw JSError(runtime, "nativeEncoding.utf16ToUtf8 expects a Uint16Array");
+            }
+            const auto* units = reinterpret_cast<const char16_t*>(view.data);
+            std::vector<uint8_t> bytes(encoding::utf8Length(units, view.length));
+            encoding::utf16ToUtf8(units, view.length, bytes.data());
+            return bytesValue(runtime, std::move(bytes));
+        });
+
+    setFunction(rt, nativeEncoding, "implementation", 0, [](Runtime& runtime, const Value&, const Value*, size_t) {
+        return Value(String::createFromAscii(runtime, encoding::simdBackend()));
+    });
+
+    rt.global().setProperty(rt, "nativeEncoding", nativeEncoding);
+    installTextCodec(rt);
+}
+
+} // namespace threadforge
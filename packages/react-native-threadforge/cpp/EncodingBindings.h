@@ -0,0 +1,30 @@
+#pragma once
+
+namespace facebook::jsi {
+class Runtime;
+} // namespace facebook::jsi
+
+namespace threadforge {
+
+// Installs the global `nativeEncoding` object in a worker runtime, a front end
+// for Encoding.h:
+//
+//     nativeEncoding.base64Encode(bytes);                        // 'AQID'
+//     nativeEncoding.base64Encode(bytes, { alphabet: 'base64url', omitPadding: true });
+//     nativeEncoding.base64Decode('AQID');                       // Uint8Array
+//     nativeEncoding.hexEncode(bytes);                           // '010203'
+//     nativeEncoding.hexDecode('010203');                        // Uint8Array
+//     nativeEncoding.isUtf8(bytes);                              // boolean
+//     nativeEncoding.utf8ToUtf16(bytes);                         // Uint16Array
+//     nativeEncoding.utf16ToUtf8(units);                         // Uint8Array
+//     nativeEncoding.implementation();                           // 'ssse3', 'neon' or 'scalar'
+//
+// bytes may be a typed array, ArrayBuffer or string (taken as UTF-8). Decoders
+// throw on malformed input; base64Decode() accepts missing padding.
+//
+// Also defines TextEncoder and TextDecoder (utf-8 and utf-16le, with fatal,
+// ignoreBOM and { stream: true }) when the engine has none, so code written
+// for the web runs in workers unchanged.
+void installEncodingBindings(facebook::jsi::Runtime& runtime);
+
+} // namespace threadforge
@@ -0,0 +1,174 @@
+#include "EngineConfig.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <sys/stat.h>
+
+#include "nlohmann/json.hpp"
+
+namespace threadforge {
+
+namespace {
+
+constexpr const char* kJournalDirectory = "threadforge";
+constexpr const char* kJournalFile = "tasks.journal";
+
+bool ensureDirectory(const std::string& path) {
+    if (mkdir(path.c_str(), 0700) == 0 || errno == EEXIST) {
+        return true;
+    }
+    return false;
+}
+
+void readCpuQuota(const nlohmann::json& quotas, const char* key, CpuQuota& quota) {
+    const auto entry = quotas.find(key);
+    if (entry == quotas.end() || !entry->is_object()) {
+        return;
+    }
+    const auto share = entry->find("coreShare");
+    if (share != entry->end() && share->is_number()) {
+        quota.coreShare = share->get<double>();
+    }
+    const auto periodMs = entry->find("periodMs");
+    if (periodMs != entry->end() && periodMs->is_number() && periodMs->get<double>() >= 1) {
+        quota.period = std::chrono::milliseconds(static_cast<int64_t>(periodMs->get<double>()));
+    }
+}
+
+} // namespace
+
+EngineConfig parseEngineConfig(const std::string& optionsJson, const std::string& storageDirectory) {
+    EngineConfig config;
+    config.storageDirectory = storageDirectory;
+
+    if (optionsJson.empty()) {
+        return config;
+    }
+
+    const auto json = nlohmann::json::parse(optionsJson, nullptr, false);
+    if (!json.is_object()) {
+        return config;
+    }
+
+    config.persistQueue = json.value("persistQueue", false);
+    const auto queueLimit = json.find("queueLimit");
+    if (queueLimit != json.end() && queueLimit->is_number() && queueLimit->get<double>() > 0) {
+        config.queueLimit = static_cast<size_t>(queueLimit->get<double>());
+    }
+    const auto minThreads = json.find("minThreads");
+    if (minThreads != json.end() && minThreads->is_number()) {
+        config.minThreads = static_cast<size_t>(std::max(0.0, minThreads->get<double>()));
+    }
+    const auto idleTimeoutMs = json.find("idleTimeoutMs");
+    if (idleTimeoutMs != json.end() && idleTimeoutMs->is_number()) {
+        config.idleTimeout = std::chrono::milliseconds(
+            static_cast<int64_t>(std::max(0.0, idleTimeoutMs->get<double>())));
+    }
+    const auto cpuQuotas = json.find("cpuQuotas");
+    if (cpuQuotas != json.end() && cpuQuotas->is_object()) {
+        readCpuQuota(*cpuQuotas, "idle", config.cpuQuotas[priorityClassIndex(TaskPriority::IDLE)]);
+        readCpuQuota(*cpuQuotas, "low", config.cpuQuotas[priorityClassIndex(TaskPriority::LOW)]);
+        readCpuQuota(*cpuQuotas, "normal", config.cpuQuotas[priorityClassIndex(TaskPriority::NORMAL)]);
+        readCpuQuota(*cpuQuotas, "high", config.cpuQuotas[priorityClassIndex(TaskPriority::HIGH)]);
+    }
+    return config;
+}
+
+std::unique_ptr<ThreadPool> makeThreadPool(size_t threadCount, const EngineConfig& config) {
+    // configureThreadPool() settles the final worker count; the pool starts lazily either way.
+    return std::make_unique<ThreadPool>(std::max<size_t>(1, threadCount), config.minThreads, config.idleTimeout);
+}
+
+std::shared_ptr<TaskJournal> openTaskJournal(const EngineConfig& config) {
+    if (!config.persistQueue || config.storageDirectory.empty()) {
+        return nullptr;
+    }
+
+    const auto directory = config.storageDirectory + "/" + kJournalDirectory;
+    if (!ensureDirectory(directory)) {
+        return nullptr;
+    }
+
+    auto journal = std::make_shared<TaskJournal>(directory + "/" + kJournalFile);
+    if (!journal->open()) {
+        return nullptr;
+    }
+    return journal;
+}
+
+void configureThreadPool(ThreadPool& pool,
+                         size_t threadCount,
+                         const EngineConfig& config,
+                         const JournalTaskFactory& journalTaskFactory) {
+    auto topology = std::make_shared<const CpuTopology>(readCpuTopology(config.cpuSysfsRoot));
+    const size_t workerCount = threadCount > 0 ? threadCount : recommendedThreadCount(*topology);
+    pool.setCpuTopology(topology);
+    pool.setIdlePolicy(config.minThreads, config.idleTimeout);
+    for (auto priority : {TaskPriority::IDLE, TaskPriority::LOW, TaskPriority::NORMAL, TaskPriority::HIGH}) {
+        pool.setCpuQuota(priority, config.cpuQuotas[priorityClassIndex(priority)]);
+    }
+    pool.setConcurrency(workerCount);
+    pool.setQueueLimit(config.queueLimit);
+
+    if (!config.persistQueue) {
+        // Turning persistence off also forgets the queued and running tasks, or
+        // a later launch that turns it back on would replay them.
+        if (auto journal = pool.detachJournal()) {
+            journal->clear();
+        }
+        return;
+    }
+    if (pool.isJournaling()) {
+        return;
+    }
+    if (auto journal = openTaskJournal(config)) {
+        pool.attachJournal(std::move(journal));
+        pool.restoreJournal(journalTaskFactory);
+    }
+}
+
+std::string makeFunctionJournalPayload(const std::string& functionSource) {
+    nlohmann::json json;
+    json["kind"] = "function";
+    json["source"] = functionSource;
+    return json.dump();
+}
+
+bool readFunctionJournalPayload(const std::string& payload, std::string& functionSource) {
+    const auto json = nlohmann::json::parse(payload, nullptr, false);
+    if (!json.is_object() || json.value("kind", "") != "function") {
+        return false;
+    }
+    const auto source = json.find("source");
+    if (source == json.end() || !source->is_string()) {
+        return false;
+    }
+    functionSource = source->get<std::string>();
+    return true;
+}
+
+std::string makeKernelJournalPayload(const std::string& kernelName, const std::string& argsJson) {
+    nlohmann::json json;
+    json["kind"] = "kernel";
+    json["name"] = kernelName;
+    json["args"] = argsJson;
+    return json.dump();
+}
+
+bool readKernelJournalPayload(const std::string& payload, std::string& kernelName, std::string& argsJson) {
+    const auto json = nlohmann::json::parse(payload, nullptr, false);
+    if (!json.is_object() || json.value("kind", "") != "kernel") {
+        return false;
+    }
+    const auto name = json.find("name");
+    const auto args = json.find("args");
+    if (name == json.end() || !name->is_string() || args == json.end() || !args->is_string()) {
+        return false;
+    }
+    kernelName = name->get<std::string>();
+    argsJson = args->get<std::string>();
+    return true;
+}
+
+} // namespace threadforge
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "CpuTopology.h"
+#include "TaskJournal.h"
+#include "ThreadPool.h"
+
+namespace threadforge {
+
+// Options forwarded from ThreadForgeEngine.initialize() as a JSON object,
+// plus the platform-provided directory ThreadForge may persist state into.
+struct EngineConfig {
+    bool persistQueue{false};
+    size_t queueLimit{0};
+    // Workers kept alive while idle; more are spawned on demand up to the thread count.
+    size_t minThreads{1};
+    std::chrono::milliseconds idleTimeout{30000};
+    std::string storageDirectory;
+    std::string cpuSysfsRoot{kDefaultCpuSysfsRoot};
+    // Indexed by priorityClassIndex(); a zero coreShare leaves the class unthrottled.
+    std::array<CpuQuota, kPriorityClassCount> cpuQuotas{};
+};
+
+EngineConfig parseEngineConfig(const std::string& optionsJson, const std::string& storageDirectory);
+
+std::shared_ptr<TaskJournal> openTaskJournal(const EngineConfig& config);
+
+std::unique_ptr<ThreadPool> makeThreadPool(size_t threadCount, const EngineConfig& config);
+
+// Applies a (re-)initialize call to a live pool: resizes workers (a threadCount
+// of 0 picks one from the CPU topology), updates placement, the idle policy and
+// queue limit and attaches or detaches the journal without dropping queued work.
+// Detaching clears the journal, so its tasks are not replayed by a later
+// initialize() that enables persistQueue again.
+void configureThreadPool(ThreadPool& pool,
+                         size_t threadCount,
+                         const EngineConfig& config,
+                         const JournalTaskFactory& journalTaskFactory);
+
+std::string makeFunctionJournalPayload(const std::string& functionSource);
+bool readFunctionJournalPayload(const std::string& payload, std::string& functionSource);
+std::string makeKernelJournalPayload(const std::string& kernelName, const std::string& argsJson);
+bool readKernelJournalPayload(const std::string& payload, std::string& kernelName, std::string& argsJson);
+
+} // namespace threadforge
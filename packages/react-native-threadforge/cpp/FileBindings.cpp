@@ -0,0 +1,253 @@
+#include "FileBindings.h"
+
+#include <algorithm>
+#include <cmath>
+#include <jsi/jsi.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "BindingHelpers.h"
+#include "Files.h"
+
+namespace threadforge {
+
+namespace {
+
+using facebook::jsi::Array;
+using facebook::jsi::ArrayBuffer;
+using facebook::jsi::HostFunctionType;
+using facebook::jsi::JSError;
+using facebook::jsi::MutableBuffer;
+using facebook::jsi::Object;
+using facebook::jsi::Runtime;
+using facebook::jsi::String;
+using facebook::jsi::Value;
+
+// Lines per lines().next() and bytes per chunks().next() unless the caller
+// asks otherwise.
+constexpr size_t kDefaultLineBatch = 1024;
+constexpr size_t kDefaultChunkSize = 1u << 20;
+constexpr double kMaxSafeInteger = 9007199254740991.0;
+
+// An ArrayBuffer's storage: the mapping itself, released when the runtime
+// collects the buffer.
+class MappedBuffer : public MutableBuffer {
+public:
+    explicit MappedBuffer(std::shared_ptr<files::MappedFile> file)
+        : file_(std::move(file)) {}
+
+    size_t size() const override {
+        return file_->size();
+    }
+    uint8_t* data() override {
+        return file_->data();
+    }
+
+private:
+    std::shared_ptr<files::MappedFile> file_;
+};
+
+// setFunction() for file calls: failed system calls become JS errors too.
+void setFileFunction(Runtime& rt, Object& target, const char* name, unsigned length, HostFunctionType body) {
+    setFunction(rt,
+                target,
+                name,
+                length,
+                [body = std::move(body)](Runtime& runtime, const Value& thisValue, const Value* args, size_t count) {
+                    try {
+                        return body(runtime, thisValue, args, count);
+                    } catch (const files::Error& ex) {
+                        throw JSError(runtime, ex.what());
+                    }
+                });
+}
+
+std::string pathArgument(Runtime& rt, const Value* args, size_t count, const char* method) {
+    const auto& path = argumentAt(args, count, 0);
+    if (!path.isString()) {
+        throw JSError(rt, std::string("nativeFiles.") + method + " expects a path");
+    }
+    return files::resolvePath(path.getString(rt).utf8(rt));
+}
+
+// options[name] as a non-negative whole number, fallback when absent.
+uint64_t sizeOption(Runtime& rt, const Value& options, const char* name, uint64_t fallback) {
+    if (!options.isObject()) {
+        return fallback;
+    }
+    const auto value = options.getObject(rt).getProperty(rt, name);
+    if (value.isUndefined()) {
+        return fallback;
+    }
+    if (!value.isNumber() || value.getNumber() < 0 || std::trunc(value.getNumber()) != value.getNumber() ||
+        value.getNumber() > kMaxSafeInteger) {
+        throw std::invalid_argument(std::string(name) + " must be a non-negative integer");
+    }
+    return static_cast<uint64_t>(value.getNumber());
+}
+
+bool flagOption(Runtime& rt, const Value& options, const char* name) {
+    if (!options.isObject()) {
+        return false;
+    }
+    const auto value = options.getObject(rt).getProperty(rt, name);
+    return value.isBool() && value.getBool();
+}
+
+Value wrapMapping(Runtime& rt, std::shared_ptr<files::MappedFile> file) {
+    return Value(ArrayBuffer(rt, std::make_shared<MappedBuffer>(std::move(file))));
+}
+
+Value writeResult(Runtime& rt, const Value* args, size_t count, const char* method, bool append) {
+    const auto path = pathArgument(rt, args, count, method);
+    uint64_t written = 0;
+    withBytes(rt, argumentAt(args, count, 1), true, [&](const void* bytes, size_t size) {
+        files::writeFile(path, bytes, size, append);
+        written = size;
+    });
+    return Value(static_cast<double>(written));
+}
+
+void setReaderCommon(Runtime& rt, Object& object, const std::shared_ptr<files::FileReader>& reader) {
+    object.setProperty(rt, "size", static_cast<double>(reader->size()));
+    setFileFunction(rt, object, "position", 0, [reader](Runtime&, const Value&, const Value*, size_t) {
+        return Value(static_cast<double>(reader->position()));
+    });
+    setFileFunction(rt, object, "close", 0, [reader](Runtime&, const Value&, const Value*, size_t) {
+        reader->close();
+        return Value::undefined();
+    });
+}
+
+Object makeLineReader(Runtime& rt, std::shared_ptr<files::FileReader> reader) {
+    Object object(rt);
+    setReaderCommon(rt, object, reader);
+    setFileFunction(rt, object, "next", 1, [reader](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto& limit = argumentAt(args, count, 0);
+        const size_t batch = limit.isNumber() && limit.getNumber() >= 1 ? static_cast<size_t>(limit.getNumber())
+                                                                        : kDefaultLineBatch;
+        std::vector<std::string_view> lines;
+        lines.reserve(std::min<size_t>(batch, kDefaultLineBatch));
+        reader->nextLines(batch, lines);
+        Array result(runtime, lines.size());
+        for (size_t i = 0; i < lines.size(); ++i) {
+            result.setValueAtIndex(runtime,
+                                   i,
+                                   String::createFromUtf8(runtime,
+                                                          reinterpret_cast<const uint8_t*>(lines[i].data()),
+                                                          lines[i].size()));
+        }
+        return Value(std::move(result));
+    });
+    return object;
+}
+
+Object makeChunkReader(Runtime& rt, std::shared_ptr<files::FileReader> reader, size_t chunkSize) {
+    Object object(rt);
+    setReaderCommon(rt, object, reader);
+    setFileFunction(rt, object, "next", 0, [reader, chunkSize](Runtime& runtime, const Value&, const Value*, size_t) {
+        auto chunk = reader->nextChunk(chunkSize);
+        if (!chunk) {
+            return Value::null();
+        }
+        auto buffer = wrapMapping(runtime, std::move(chunk));
+        return runtime.global().getPropertyAsFunction(runtime, "Uint8Array").callAsConstructor(runtime, buffer);
+    });
+    return object;
+}
+
+Object makeWriter(Runtime& rt, std::shared_ptr<files::FileWriter> writer) {
+    Object object(rt);
+    setFileFunction(rt, object, "write", 1, [writer](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        withBytes(runtime, argumentAt(args, count, 0), true, [&](const void* bytes, size_t size) {
+            writer->write(bytes, size);
+        });
+        return Value(static_cast<double>(writer->written()));
+    });
+    setFileFunction(rt, object, "commit", 0, [writer](Runtime&, const Value&, const Value*, size_t) {
+        writer->commit();
+        return Value(static_cast<double>(writer->written()));
+    });
+    setFileFunction(rt, object, "abandon", 0, [writer](Runtime&, const Value&, const Value*, size_t) {
+        writer->abandon();
+        return Value::undefined();
+    });
+    return object;
+}
+
+} // namespace
+
+void installFileBindings(Runtime& rt) {
+    Object nativeFiles(rt);
+
+    Object roots(rt);
+    for (const auto& root : files::roots()) {
+        roots.setProperty(rt, root.first.c_str(), String::createFromUtf8(rt, root.second));
+    }
+    nativeFiles.setProperty(rt, "roots", roots);
+
+    setFileFunction(rt, nativeFiles, "resolve", 1, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        return Value(String::createFromUtf8(runtime, pathArgument(runtime, args, count, "resolve")));
+    });
+
+    setFileFunction(rt, nativeFiles, "stat", 1, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto info = files::stat(pathArgument(runtime, args, count, "stat"));
+        Object result(runtime);
+        result.setProperty(runtime, "exists", info.exists);
+        result.setProperty(runtime, "directory", info.directory);
+        result.setProperty(runtime, "size", static_cast<double>(info.size));
+        result.setProperty(runtime, "modified", info.modifiedMs);
+        return Value(std::move(result));
+    });
+
+    setFileFunction(rt, nativeFiles, "map", 2, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto path = pathArgument(runtime, args, count, "map");
+        const auto& options = argumentAt(args, count, 1);
+        return wrapMapping(runtime,
+                           files::MappedFile::open(
+                               path, sizeOption(runtime, options, "offset", 0), sizeOption(runtime, options, "length", 0)));
+    });
+
+    setFileFunction(rt, nativeFiles, "readText", 1, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto file = files::MappedFile::open(pathArgument(runtime, args, count, "readText"));
+        return Value(String::createFromUtf8(runtime, file->data(), file->size()));
+    });
+
+    setFileFunction(rt, nativeFiles, "lines", 1, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        return Value(
+            makeLineReader(runtime, std::make_shared<files::FileReader>(pathArgument(runtime, args, count, "lines"))));
+    });
+
+    setFileFunction(rt, nativeFiles, "chunks", 2, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto path = pathArgument(runtime, args, count, "chunks");
+        const auto& size = argumentAt(args, count, 1);
+        if (!size.isUndefined() && (!size.isNumber() || size.getNumber() < 1)) {
+            throw JSError(runtime, "nativeFiles.chunks expects a positive chunk size");
+        }
+        const size_t chunkSize = size.isNumber() ? static_cast<size_t>(size.getNumber()) : kDefaultChunkSize;
+        return Value(makeChunkReader(runtime, std::make_shared<files::FileReader>(path), chunkSize));
+    });
+
+    setFileFunction(rt, nativeFiles, "writeFile", 2, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        return writeResult(runtime, args, count, "writeFile", false);
+    });
+
+    setFileFunction(rt, nativeFiles, "appendFile", 2, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        return writeResult(runtime, args, count, "appendFile", true);
+    });
+
+    setFileFunction(
+        rt, nativeFiles, "createWriter", 2, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+            const auto path = pathArgument(runtime, args, count, "createWriter");
+            const bool append = flagOption(runtime, argumentAt(args, count, 1), "append");
+            return Value(makeWriter(runtime, std::make_shared<files::FileWriter>(path, append)));
+        });
+
+    rt.global().setProperty(rt, "nativeFiles", nativeFiles);
+}
+
+} // namespace threadforge
@@ -0,0 +1,32 @@
+#pragma once
+
+namespace facebook::jsi {
+class Runtime;
+} // namespace facebook::jsi
+
+namespace threadforge {
+
+// Installs the global `nativeFiles` object in a worker runtime, a front end
+// for Files.h. Every path goes through files::resolvePath(): relative paths
+// land in the first root, and nothing outside the roots opens.
+//
+//     nativeFiles.roots;                                  // { documents: '/…', cache: '/…' }
+//     nativeFiles.stat('logs/app.log');                    // { exists, directory, size, modified }
+//     const bytes = new Uint8Array(nativeFiles.map('data.bin', { offset?, length? }));
+//     const lines = nativeFiles.lines('logs/app.log');
+//     for (let batch = lines.next(1000); batch.length > 0; batch = lines.next(1000)) { ... }
+//     const chunks = nativeFiles.chunks('data.bin', 1 << 20);
+//     for (let chunk = chunks.next(); chunk; chunk = chunks.next()) { ... }   // Uint8Array
+//     nativeFiles.writeFile('out.json', text);             // string, typed array or ArrayBuffer
+//     nativeFiles.appendFile('out.csv', row);
+//     const writer = nativeFiles.createWriter('out.csv');  // write(data), commit(), abandon()
+//     nativeFiles.readText('config.json');
+//
+// map() and chunks() hand out ArrayBuffers backed directly by copy-on-write
+// mappings: nothing is copied until a page is touched, writes stay private to
+// the buffer, and the mapping goes away with the buffer. lines() decodes UTF-8
+// one batch at a time through a sliding window, so memory stays flat however
+// large the file. Fresh writes replace the file atomically on commit.
+void installFileBindings(facebook::jsi::Runtime& runtime);
+
+} // namespace threadforge
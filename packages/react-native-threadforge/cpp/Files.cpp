@@ -0,0 +1,385 @@
+#include "Files.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace threadforge::files {
+
+namespace {
+
+std::mutex gRootsMutex;
+std::vector<std::pair<std::string, std::string>> gRoots;
+std::atomic<uint64_t> gTemporaryCounter{0};
+
+[[noreturn]] void fail(const std::string& action, const std::string& path) {
+    const int code = errno;
+    throw Error(code, action + " " + path + ": " + std::strerror(code));
+}
+
+size_t pageSize() {
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+// Splits path on '/' and folds "." and ".." away; ".." at the top stays at "/".
+std::vector<std::string> normalize(const std::string& path) {
+    std::vector<std::string> parts;
+    for (size_t start = 0; start <= path.size();) {
+        const size_t end = std::min(path.find('/', start), path.size());
+        const auto part = path.substr(start, end - start);
+        if (part == "..") {
+            if (!parts.empty()) {
+                parts.pop_back();
+            }
+        } else if (!part.empty() && part != ".") {
+            parts.push_back(part);
+        }
+        start = end + 1;
+    }
+    return parts;
+}
+
+std::string join(const std::vector<std::string>& parts, size_t count) {
+    std::string path;
+    for (size_t i = 0; i < count; ++i) {
+        path += '/';
+        path += parts[i];
+    }
+    return path.empty() ? "/" : path;
+}
+
+std::string realPath(const std::string& path) {
+    char buffer[PATH_MAX];
+    return ::realpath(path.c_str(), buffer) ? std::string(buffer) : std::string();
+}
+
+// parts with symlinks resolved as far as the path exists. Empty when the
+// first missing component is itself a (dangling) link.
+std::string canonical(const std::vector<std::string>& parts) {
+    for (size_t count = parts.size();; --count) {
+        auto resolved = realPath(join(parts, count));
+        if (!resolved.empty()) {
+            if (count < parts.size()) {
+                struct stat info {};
+                if (::lstat((resolved + "/" + parts[count]).c_str(), &info) == 0 && S_ISLNK(info.st_mode)) {
+                    return std::string();
+                }
+            }
+            for (size_t i = count; i < parts.size(); ++i) {
+                if (resolved.back() != '/') {
+                    resolved += '/';
+                }
+                resolved += parts[i];
+            }
+            return resolved;
+        }
+        if (count == 0) {
+            return std::string();
+        }
+    }
+}
+
+bool within(const std::string& path, const std::string& root) {
+    if (root == "/") {
+        return true;
+    }
+    return path.compare(0, root.size(), root) == 0 && (path.size() == root.size() || path[root.size()] == '/');
+}
+
+} // namespace
+
+Error::Error(int code, const std::string& message)
+    : std::runtime_error(message),
+      code_(code) {}
+
+void setRoots(std::vector<std::pair<std::string, std::string>> roots) {
+    std::lock_guard<std::mutex> lock(gRootsMutex);
+    gRoots = std::move(roots);
+}
+
+std::vector<std::pair<std::string, std::string>> roots() {
+    std::lock_guard<std::mutex> lock(gRootsMutex);
+    return gRoots;
+}
+
+std::string resolvePath(const std::string& path) {
+    if (path.empty()) {
+        throw std::invalid_argument("path is empty");
+    }
+    const auto sandbox = roots();
+    if (sandbox.empty()) {
+        throw std::invalid_argument("no file roots are set");
+    }
+    const auto absolute = path[0] == '/' ? path : sandbox.front().second + "/" + path;
+    const auto resolved = canonical(normalize(absolute));
+    if (!resolved.empty()) {
+        for (const auto& root : sandbox) {
+            const auto base = canonical(normalize(root.second));
+            if (!base.empty() && within(resolved, base)) {
+                return resolved;
+            }
+        }
+    }
+    throw std::invalid_argument("'" + path + "' is outside the app's file roots");
+}
+
+FileInfo stat(const std::string& path) {
+    FileInfo info;
+    struct stat status {};
+    if (::stat(path.c_str(), &status) != 0) {
+        if (errno == ENOENT || errno == ENOTDIR) {
+            return info;
+        }
+        fail("cannot stat", path);
+    }
+    info.exists = true;
+    info.directory = S_ISDIR(status.st_mode);
+    info.size = static_cast<uint64_t>(status.st_size);
+    info.modifiedMs = static_cast<double>(status.st_mtime) * 1000.0;
+    return info;
+}
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& path, uint64_t offset, uint64_t length) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fail("cannot open", path);
+    }
+    try {
+        auto mapping = map(fd, offset, length);
+        ::close(fd);
+        return mapping;
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+std::shared_ptr<MappedFile> MappedFile::map(int fd, uint64_t offset, uint64_t length) {
+    struct stat status {};
+    if (::fstat(fd, &status) != 0) {
+        fail("cannot stat", "descriptor " + std::to_string(fd));
+    }
+    const auto fileSize = static_cast<uint64_t>(status.st_size);
+    if (offset > fileSize || length > fileSize - offset) {
+        throw std::invalid_argument("range " + std::to_string(offset) + "+" + std::to_string(length) +
+                                    " is outside a file of " + std::to_string(fileSize) + " bytes");
+    }
+    if (length == 0) {
+        length = fileSize - offset;
+    }
+    const size_t delta = static_cast<size_t>(offset % pageSize());
+    if (length > SIZE_MAX - delta) {
+        throw std::invalid_argument("cannot map " + std::to_string(length) + " bytes at once on this device");
+    }
+    if (length == 0) {
+        return std::shared_ptr<MappedFile>(new MappedFile(nullptr, 0, 0, 0));
+    }
+    const size_t mappedSize = delta + static_cast<size_t>(length);
+    // Private and writable: JS may scribble on an ArrayBuffer, but only its
+    // own copies of the pages change.
+    void* base = ::mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                        static_cast<off_t>(offset - delta));
+    if (base == MAP_FAILED) {
+        fail("cannot map", "descriptor " + std::to_string(fd));
+    }
+    return std::shared_ptr<MappedFile>(new MappedFile(base, mappedSize, delta, static_cast<size_t>(length)));
+}
+
+MappedFile::MappedFile(void* base, size_t mappedSize, size_t delta, size_t size)
+    : base_(base),
+      mappedSize_(mappedSize),
+      data_(base ? static_cast<uint8_t*>(base) + delta : nullptr),
+      size_(size) {}
+
+MappedFile::~MappedFile() {
+    if (base_) {
+        ::munmap(base_, mappedSize_);
+    }
+}
+
+FileReader::FileReader(const std::string& path, size_t windowSize)
+    : fd_(::open(path.c_str(), O_RDONLY | O_CLOEXEC)),
+      path_(path),
+      windowSize_((std::max<size_t>(windowSize, 1) + pageSize() - 1) / pageSize() * pageSize()) {
+    if (fd_ < 0) {
+        fail("cannot open", path);
+    }
+    struct stat status {};
+    if (::fstat(fd_, &status) != 0) {
+        const int code = errno;
+        ::close(fd_);
+        fd_ = -1;
+        throw Error(code, "cannot stat " + path + ": " + std::strerror(code));
+    }
+    size_ = static_cast<uint64_t>(status.st_size);
+}
+
+FileReader::~FileReader() {
+    close();
+}
+
+void FileReader::slide(size_t minimum) {
+    const uint64_t wanted = std::min<uint64_t>(std::max(windowSize_, minimum), size_ - position_);
+    window_ = MappedFile::map(fd_, position_, wanted);
+    windowStart_ = position_;
+}
+
+bool FileReader::nextLines(size_t maxLines, std::vector<std::string_view>& lines) {
+    if (fd_ < 0) {
+        throw std::invalid_argument("reader is closed");
+    }
+    size_t found = 0;
+    while (found < maxLines && position_ < size_) {
+        size_t minimum = 1;
+        size_t length = 0;
+        size_t consumed = 0;
+        for (;;) {
+            const uint64_t windowEnd = window_ ? windowStart_ + window_->size() : 0;
+            if (!window_ || position_ < windowStart_ || position_ + std::min<uint64_t>(minimum, size_ - position_) > windowEnd) {
+                // Remapping would invalidate the views handed out already.
+                if (found > 0) {
+                    return true;
+                }
+                slide(minimum);
+                continue;
+            }
+            const auto* start = window_->data() + (position_ - windowStart_);
+            const auto available = static_cast<size_t>(windowEnd - position_);
+            const auto* newline = static_cast<const uint8_t*>(std::memchr(start, '\n', available));
+            if (newline) {
+                length = static_cast<size_t>(newline - start);
+                consumed = length + 1;
+                break;
+            }
+            if (windowEnd == size_) {
+                length = available;
+                consumed = available;
+                break;
+            }
+            // The line runs past the window: map a bigger one from here.
+            minimum = available * 2;
+        }
+        const auto* start = reinterpret_cast<const char*>(window_->data() + (position_ - windowStart_));
+        if (length > 0 && start[length - 1] == '\r') {
+            --length;
+        }
+        lines.emplace_back(start, length);
+        position_ += consumed;
+        ++found;
+    }
+    return found > 0;
+}
+
+std::shared_ptr<MappedFile> FileReader::nextChunk(size_t size) {
+    if (fd_ < 0) {
+        throw std::invalid_argument("reader is closed");
+    }
+    if (size == 0) {
+        throw std::invalid_argument("chunk size must be positive");
+    }
+    if (position_ >= size_) {
+        return nullptr;
+    }
+    const uint64_t length = std::min<uint64_t>(size, size_ - position_);
+    auto chunk = MappedFile::map(fd_, position_, length);
+    position_ += length;
+    return chunk;
+}
+
+void FileReader::close() {
+    window_.reset();
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+FileWriter::FileWriter(const std::string& path, bool append)
+    : fd_(-1),
+      path_(path) {
+    if (append) {
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    } else {
+        temporary_ = path + ".tmp-" + std::to_string(::getpid()) + "-" + std::to_string(gTemporaryCounter++);
+        fd_ = ::open(temporary_.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    }
+    if (fd_ < 0) {
+        fail("cannot write", path);
+    }
+}
+
+FileWriter::~FileWriter() {
+    abandon();
+}
+
+void FileWriter::write(const void* data, size_t size) {
+    if (fd_ < 0) {
+        throw std::invalid_argument("writer is closed");
+    }
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        const ssize_t count = ::write(fd_, bytes, size);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fail("cannot write", path_);
+        }
+        bytes += count;
+        size -= static_cast<size_t>(count);
+        written_ += static_cast<uint64_t>(count);
+    }
+}
+
+void FileWriter::commit() {
+    if (fd_ < 0) {
+        throw std::invalid_argument("writer is closed");
+    }
+    // The data has to be on storage before the rename makes it visible.
+    int code = ::fsync(fd_) == 0 ? 0 : errno;
+    if (::close(fd_) != 0 && code == 0) {
+        code = errno;
+    }
+    fd_ = -1;
+    if (code != 0) {
+        abandon();
+        throw Error(code, "cannot write " + path_ + ": " + std::strerror(code));
+    }
+    if (!temporary_.empty()) {
+        if (::rename(temporary_.c_str(), path_.c_str()) != 0) {
+            const int code = errno;
+            abandon();
+            throw Error(code, "cannot replace " + path_ + ": " + std::strerror(code));
+        }
+        temporary_.clear();
+    }
+}
+
+void FileWriter::abandon() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    if (!temporary_.empty()) {
+        ::unlink(temporary_.c_str());
+        temporary_.clear();
+    }
+}
+
+void writeFile(const std::string& path, const void* data, size_t size, bool append) {
+    FileWriter writer(path, append);
+    writer.write(data, size);
+    writer.commit();
+}
+
+} // namespace threadforge::files
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace threadforge::files {
+
+// A failed system call; code is the errno value and what() names the path.
+class Error : public std::runtime_error {
+public:
+    Error(int code, const std::string& message);
+
+    int code() const {
+        return code_;
+    }
+
+private:
+    int code_;
+};
+
+// Directories worker code may touch, by name ("documents", "cache", ...). The
+// first root is where relative paths resolve. Replaces any earlier roots.
+void setRoots(std::vector<std::pair<std::string, std::string>> roots);
+std::vector<std::pair<std::string, std::string>> roots();
+
+// Absolute, normalized form of path inside one of the roots. Symlinks are
+// resolved for the part of the path that exists, so a link cannot lead out of
+// the sandbox either. Throws std::invalid_argument for paths outside every
+// root and when no roots are set.
+std::string resolvePath(const std::string& path);
+
+struct FileInfo {
+    bool exists{false};
+    bool directory{false};
+    uint64_t size{0};
+    // Milliseconds since the epoch.
+    double modifiedMs{0};
+};
+
+FileInfo stat(const std::string& path);
+
+// A copy-on-write mapping of part of a file: the pages are shared with the
+// page cache until written, and writes never reach the file. Unmapped when the
+// last reference goes away.
+class MappedFile {
+public:
+    // Maps length bytes from offset (0 = to the end of the file). Any offset
+    // works; the mapping itself starts at the page below it. Throws Error, or
+    // std::invalid_argument when the range is outside the file.
+    static std::shared_ptr<MappedFile> open(const std::string& path, uint64_t offset = 0, uint64_t length = 0);
+    // Same, for a descriptor the caller keeps open.
+    static std::shared_ptr<MappedFile> map(int fd, uint64_t offset, uint64_t length);
+
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    uint8_t* data() const {
+        return data_;
+    }
+    size_t size() const {
+        return size_;
+    }
+
+private:
+    MappedFile(void* base, size_t mappedSize, size_t delta, size_t size);
+
+    void* base_;
+    size_t mappedSize_;
+    uint8_t* data_;
+    size_t size_;
+};
+
+// Reads a file sequentially through a sliding window of mappings, so files
+// larger than the address space left on 32-bit devices still stream.
+class FileReader {
+public:
+    // windowSize is rounded up to whole pages.
+    explicit FileReader(const std::string& path, size_t windowSize = 32u << 20);
+    ~FileReader();
+    FileReader(const FileReader&) = delete;
+    FileReader& operator=(const FileReader&) = delete;
+
+    // Appends up to maxLines lines, without their "\n" or "\r\n", to lines.
+    // The views point into the current window and stay valid until the next
+    // call. Returns false once the file is exhausted. A final line without a
+    // newline is still a line; the empty string after a trailing newline is
+    // not.
+    bool nextLines(size_t maxLines, std::vector<std::string_view>& lines);
+    // The next size bytes (fewer at the end of the file) as their own
+    // mapping; nullptr once the file is exhausted.
+    std::shared_ptr<MappedFile> nextChunk(size_t size);
+
+    // Bytes consumed so far.
+    uint64_t position() const {
+        return position_;
+    }
+    uint64_t size() const {
+        return size_;
+    }
+    void close();
+
+private:
+    // Ensures the window covers [position_, position_ + minimum) or reaches
+    // the end of the file.
+    void slide(size_t minimum);
+
+    int fd_;
+    std::string path_;
+    uint64_t size_{0};
+    uint64_t position_{0};
+    size_t windowSize_;
+    std::shared_ptr<MappedFile> window_;
+    uint64_t windowStart_{0};
+};
+
+// Writes a file. A fresh write goes to a temporary file next to path that
+// commit() renames over it, so readers never see half a file and an abandoned
+// writer leaves the old one in place. Appends go straight to path.
+class FileWriter {
+public:
+    FileWriter(const std::string& path, bool append);
+    ~FileWriter();
+    FileWriter(const FileWriter&) = delete;
+    FileWriter& operator=(const FileWriter&) = delete;
+
+    void write(const void* data, size_t size);
+    // Flushes to storage and publishes the file; the writer is closed after.
+    void commit();
+    // Closes without publishing a fresh write.
+    void abandon();
+
+    bool isOpen() const {
+        return fd_ >= 0;
+    }
+    uint64_t written() const {
+        return written_;
+    }
+
+private:
+    int fd_;
+    std::string path_;
+    std::string temporary_;
+    uint64_t written_{0};
+};
+
+// One-shot FileWriter.
+void writeFile(const std::string& path, const void* data, size_t size, bool append);
+
+} // namespace threadforge::files
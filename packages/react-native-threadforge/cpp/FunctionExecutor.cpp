@@ -6,16 +6,33 @@
 #include <memory>
 #include <stdexcept>
 
+#include "AsyncIoBindings.h"
+#include "ColumnarBindings.h"
+#include "CompressionBindings.h"
+#include "EncodingBindings.h"
+#include "FileBindings.h"
+#include "HashBindings.h"
+#include "SortBindings.h"
+#include "SqliteBindings.h"
+#include "StatisticsBindings.h"
+#include "ThreadPool.h"
+#include "VectorMathBindings.h"
+#include "nlohmann/json.hpp"
+
 #if __has_include(<hermes/Public/hermes.h>)
 #include <hermes/Public/hermes.h>
+#define THREADFORGE_HERMES_INTERRUPTS 1
 #elif __has_include(<hermes/hermes.h>)
 #include <hermes/hermes.h>
+#define THREADFORGE_HERMES_INTERRUPTS 1
 #elif __has_include(<hermes-engine/hermes/hermes.h>)
 #include <hermes-engine/hermes/hermes.h>
+#define THREADFORGE_HERMES_INTERRUPTS 1
 #else
 namespace facebook::hermes {
 std::unique_ptr<facebook::jsi::Runtime> makeHermesRuntime();
 } // namespace facebook::hermes
+#define THREADFORGE_HERMES_INTERRUPTS 0
 #endif
 
 namespace threadforge {
@@ -35,6 +52,34 @@ public:
     explicit SimpleStringBuffer(std::string source)
         : StringBuffer(std::move(source)) {}
 };
+
+// Points the pool's interrupt hook at the runtime for exactly as long as the
+// runtime is alive; declared after the runtime so it is torn down first.
+class ScopedInterruptHandler {
+public:
+    explicit ScopedInterruptHandler(std::function<void()> handler) {
+        ThreadPool::setInterruptHandler(std::move(handler));
+    }
+
+    ScopedInterruptHandler(const ScopedInterruptHandler&) = delete;
+    ScopedInterruptHandler& operator=(const ScopedInterruptHandler&) = delete;
+
+    ~ScopedInterruptHandler() {
+        ThreadPool::setInterruptHandler(nullptr);
+    }
+};
+
+// Checkpoints (progress reports and cancellation polls) are the only safe points
+// to act on the pool while the task is executing: collect garbage for
+// trimMemory(), pause while the task's class is over its CPU quota and park
+// IDLE tasks until the app is idle again.
+void runCheckpoint(Runtime& runtime) {
+    if (ThreadPool::takeTrimRequest()) {
+        runtime.instrumentation().collectGarbage("threadforge-trim-memory");
+    }
+    ThreadPool::throttleCurrentTask();
+    ThreadPool::waitForIdleWindow();
+}
 } // namespace
 
 TaskResult runSerializedFunction(const std::string& taskId,
@@ -47,7 +92,17 @@ TaskResult runSerializedFunction(const std::string& taskId,
     }
 
     try {
+#if THREADFORGE_HERMES_INTERRUPTS
+        // Async break checks let another thread abort a busy loop via asyncTriggerTimeout().
+        auto runtime = makeHermesRuntime(
+            ::hermes::vm::RuntimeConfig::Builder().withAsyncBreakCheckInEval(true).build());
+        auto* hermesRuntime = runtime.get();
+        ScopedInterruptHandler interruptScope([hermesRuntime] {
+            hermesRuntime->asyncTriggerTimeout();
+        });
+#else
         auto runtime = makeHermesRuntime();
+#endif
         Runtime& rt = *runtime;
 
         auto lastEmission = std::make_shared<std::chrono::steady_clock::time_point>(
@@ -62,6 +117,7 @@ TaskResult runSerializedFunction(const std::string& taskId,
                                                                 const Value&,
                                                                 const Value* args,
                                                                 size_t count) -> Value {
+                runCheckpoint(runtime);
                 if (!throttledEmitter) {
                     return Value::undefined();
                 }
@@ -87,6 +143,7 @@ TaskResult runSerializedFunction(const std::string& taskId,
             PropNameID::forAscii(rt, "shouldCancel"),
             0,
             [isCancelled](Runtime& runtime, const Value&, const Value*, size_t) -> Value {
+                runCheckpoint(runtime);
                 if (isCancelled && isCancelled()) {
                     return Value(true);
                 }
@@ -94,6 +151,44 @@ TaskResult runSerializedFunction(const std::string& taskId,
             });
         rt.global().setProperty(rt, "shouldCancel", cancellationFn);
 
+        auto yieldFn = Function::createFromHostFunction(
+            rt,
+            PropNameID::forAscii(rt, "shouldYield"),
+            0,
+            [](Runtime&, const Value&, const Value*, size_t) -> Value {
+                return Value(ThreadPool::shouldYield());
+            });
+        rt.global().setProperty(rt, "shouldYield", yieldFn);
+
+        auto partialResultFn = Function::createFromHostFunction(
+            rt,
+            PropNameID::forAscii(rt, "setPartialResult"),
+            1,
+            [](Runtime& runtime, const Value&, const Value* args, size_t count) -> Value {
+                if (count == 0 || args[0].isUndefined()) {
+                    return Value::undefined();
+                }
+                auto stringify = runtime.global()
+                    .getPropertyAsObject(runtime, "JSON")
+                    .getPropertyAsFunction(runtime, "stringify");
+                auto serialized = stringify.call(runtime, args[0]);
+                if (serialized.isString()) {
+                    ThreadPool::setPartialResult(serialized.getString(runtime).utf8(runtime));
+                }
+                return Value::undefined();
+            });
+        rt.global().setProperty(rt, "setPartialResult", partialResultFn);
+        installStatisticsBindings(rt);
+        installColumnarBindings(rt);
+        installFileBindings(rt);
+        installAsyncIoBindings(rt);
+        installCompressionBindings(rt);
+        installHashBindings(rt);
+        installEncodingBindings(rt);
+        installSortBindings(rt);
+        installSqliteBindings(rt);
+        installVectorMathBindings(rt);
+
         auto wrappedSource = std::string("(function(){\n") +
             "  const fn = (" + functionSource + ");\n" +
             "  if (typeof fn !== 'function') {\n" +
@@ -118,8 +213,14 @@ TaskResult runSerializedFunction(const std::string& taskId,
         }
 
         if (isCancelled && isCancelled()) {
+            // The function ran to completion after being cancelled, so its final value is
+            // the best partial result available.
             auto cancelled = makeCancelledResult();
-            cancelled.valueJson = json;
+            const auto parsed = nlohmann::json::parse(json, nullptr, false);
+            if (parsed.is_object() && parsed.contains("value")) {
+                cancelled.valueJson = parsed["value"].dump();
+                ThreadPool::setPartialResult(cancelled.valueJson);
+            }
             return cancelled;
         }
 
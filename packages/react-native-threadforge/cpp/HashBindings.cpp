@@ -0,0 +1,190 @@
+#include "HashBindings.h"
+
+#include <cmath>
+#include <jsi/jsi.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BindingHelpers.h"
+#include "Encoding.h"
+#include "Files.h"
+#include "Hashing.h"
+#include "KernelRegistry.h"
+#include "ThreadPool.h"
+#include "nlohmann/json.hpp"
+
+namespace threadforge {
+
+namespace {
+
+using facebook::jsi::JSError;
+using facebook::jsi::Object;
+using facebook::jsi::Runtime;
+using facebook::jsi::String;
+using facebook::jsi::Value;
+
+constexpr double kMaxSafeInteger = 9007199254740991.0;
+
+std::string toHex(const std::vector<uint8_t>& bytes) {
+    std::string hex(bytes.size() * 2, '0');
+    encoding::encodeHex(bytes.data(), bytes.size(), hex.data());
+    return hex;
+}
+
+hashing::Algorithm algorithmArgument(Runtime& rt, const Value* args, size_t count, const char* method) {
+    const auto& value = argumentAt(args, count, 0);
+    const auto name = value.isString() ? value.getString(rt).utf8(rt) : std::string();
+    hashing::Algorithm algorithm;
+    if (!hashing::parseAlgorithm(name, algorithm)) {
+        throw JSError(rt,
+                      std::string("nativeHash.") + method + ": unknown algorithm '" + name +
+                          "'; use 'xxh32', 'xxh64', 'crc32c', 'sha256' or 'blake3'");
+    }
+    return algorithm;
+}
+
+uint64_t seedOption(Runtime& rt, const Value& options) {
+    if (!options.isObject()) {
+        return 0;
+    }
+    const auto seed = options.getObject(rt).getProperty(rt, "seed");
+    if (seed.isUndefined()) {
+        return 0;
+    }
+    if (!seed.isNumber() || seed.getNumber() < 0 || std::trunc(seed.getNumber()) != seed.getNumber() ||
+        seed.getNumber() > kMaxSafeInteger) {
+        throw std::invalid_argument("seed must be a non-negative integer");
+    }
+    return static_cast<uint64_t>(seed.getNumber());
+}
+
+// A digest as a hex string, or a Uint8Array for { encoding: 'bytes' }.
+Value digestValue(Runtime& rt, std::vector<uint8_t> digest, const Value& options) {
+    std::string encoding = "hex";
+    if (options.isObject()) {
+        const auto value = options.getObject(rt).getProperty(rt, "encoding");
+        if (!value.isUndefined()) {
+            encoding = value.isString() ? value.getString(rt).utf8(rt) : std::string();
+        }
+    }
+    if (encoding == "hex") {
+        return Value(String::createFromAscii(rt, toHex(digest)));
+    }
+    if (encoding == "bytes") {
+        return bytesValue(rt, std::move(digest));
+    }
+    throw std::invalid_argument("encoding must be 'hex' or 'bytes'");
+}
+
+Object makeHasher(Runtime& rt, std::shared_ptr<hashing::Hasher> hasher) {
+    Object object(rt);
+    setFunction(
+        rt, object, "update", 1, [hasher](Runtime& runtime, const Value& thisValue, const Value* args, size_t count) {
+            withBytes(runtime, argumentAt(args, count, 0), true, [&](const uint8_t* data, size_t size) {
+                hasher->update(data, size);
+            });
+            // The hasher itself, so updates chain.
+            return Value(runtime, thisValue);
+        });
+    setFunction(rt, object, "digest", 1, [hasher](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        return digestValue(runtime, hasher->digest(), argumentAt(args, count, 0));
+    });
+    setFunction(rt, object, "reset", 0, [hasher](Runtime&, const Value&, const Value*, size_t) {
+        hasher->reset();
+        return Value::undefined();
+    });
+    return object;
+}
+
+TaskResult runFileKernel(const std::string& argsJson,
+                         const ProgressCallback&,
+                         const std::function<bool()>& isCancelled) {
+    const auto args = nlohmann::json::parse(argsJson, nullptr, false);
+    hashing::Algorithm algorithm;
+    if (!args.is_object() || !args.contains("algorithm") || !args["algorithm"].is_string() ||
+        !hashing::parseAlgorithm(args["algorithm"].get<std::string>(), algorithm) || !args.contains("path") ||
+        !args["path"].is_string()) {
+        return makeErrorResult("hash.file expects { algorithm: 'xxh32' | 'xxh64' | 'crc32c' | 'sha256' | 'blake3', "
+                               "path, seed? }");
+    }
+    const uint64_t seed = args.contains("seed") && args["seed"].is_number_unsigned() ? args["seed"].get<uint64_t>() : 0;
+    std::vector<uint8_t> digest;
+    uint64_t size = 0;
+    try {
+        const auto path = files::resolvePath(args["path"].get<std::string>());
+        if (!hashing::hashFile(algorithm, path, digest, size, isCancelled, seed)) {
+            return makeCancelledResult();
+        }
+    } catch (const std::exception& ex) {
+        return makeErrorResult(std::string("hash.file: ") + ex.what());
+    }
+    nlohmann::json result;
+    result["digest"] = toHex(digest);
+    result["size"] = size;
+    return makeSuccessResult(result.dump());
+}
+
+THREADFORGE_REGISTER_KERNEL("hash.file", runFileKernel);
+
+} // namespace
+
+void installHashBindings(Runtime& rt) {
+    Object nativeHash(rt);
+
+    setFunction(rt, nativeHash, "hash", 3, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto algorithm = algorithmArgument(runtime, args, count, "hash");
+        const auto& options = argumentAt(args, count, 2);
+        std::vector<uint8_t> digest;
+        withBytes(runtime, argumentAt(args, count, 1), true, [&](const uint8_t* data, size_t size) {
+            digest = hashing::hash(algorithm, data, size, seedOption(runtime, options));
+        });
+        return digestValue(runtime, std::move(digest), options);
+    });
+
+    setFunction(rt, nativeHash, "hashFile", 3, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto algorithm = algorithmArgument(runtime, args, count, "hashFile");
+        const auto& path = argumentAt(args, count, 1);
+        if (!path.isString()) {
+            throw JSError(runtime, "nativeHash.hashFile expects a path");
+        }
+        const auto& options = argumentAt(args, count, 2);
+        std::vector<uint8_t> digest;
+        uint64_t size = 0;
+        const auto task = ThreadPool::currentTask();
+        const auto cancelled = [task] {
+            return task && task->cancelled.load();
+        };
+        try {
+            if (!hashing::hashFile(algorithm,
+                                   files::resolvePath(path.getString(runtime).utf8(runtime)),
+                                   digest,
+                                   size,
+                                   cancelled,
+                                   seedOption(runtime, options))) {
+                throw JSError(runtime, "nativeHash: the task was cancelled");
+            }
+        } catch (const files::Error& ex) {
+            throw JSError(runtime, ex.what());
+        }
+        return digestValue(runtime, std::move(digest), options);
+    });
+
+    setFunction(rt, nativeHash, "createHasher", 2, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto algorithm = algorithmArgument(runtime, args, count, "createHasher");
+        return Value(makeHasher(runtime,
+                                hashing::Hasher::create(algorithm, seedOption(runtime, argumentAt(args, count, 1)))));
+    });
+
+    setFunction(
+        rt, nativeHash, "implementation", 1, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+            return Value(String::createFromAscii(
+                runtime, hashing::implementation(algorithmArgument(runtime, args, count, "implementation"))));
+        });
+
+    rt.global().setProperty(rt, "nativeHash", nativeHash);
+}
+
+} // namespace threadforge
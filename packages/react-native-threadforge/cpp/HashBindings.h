@@ -0,0 +1,27 @@
+#pragma once
+
+namespace facebook::jsi {
+class Runtime;
+} // namespace facebook::jsi
+
+namespace threadforge {
+
+// Installs the global `nativeHash` object in a worker runtime, a front end for
+// Hashing.h. algorithm is 'xxh32', 'xxh64', 'crc32c', 'sha256' or 'blake3'.
+//
+//     nativeHash.hash('sha256', data);                          // hex string
+//     nativeHash.hash('xxh64', data, { seed: 42, encoding: 'bytes' });   // Uint8Array
+//     nativeHash.hashFile('blake3', 'cache/model.bin');         // hex string
+//     const hasher = nativeHash.createHasher('crc32c');
+//     hasher.update(chunk).update(more);
+//     hasher.digest();                                          // more updates may follow
+//     hasher.reset();
+//     nativeHash.implementation('sha256');                      // 'sha-ni', 'armv8-sha2' or 'portable'
+//
+// data may be a string (hashed as UTF-8), typed array or ArrayBuffer.
+// hashFile() streams through mapped slices and gives up once the task is
+// cancelled; its path goes through files::resolvePath(). The kernel
+// "hash.file" takes { algorithm, path, seed? } and returns { digest, size }.
+void installHashBindings(facebook::jsi::Runtime& runtime);
+
+} // namespace threadforge
@@ -0,0 +1,1147 @@
+#include "Hashing.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+#include "Files.h"
+#include "ParallelFor.h"
+
+// CRC32C and SHA-256 instructions are optional extensions on both x86-64
+// and arm64, so the accelerated paths are compiled with per-function target
+// attributes and picked at runtime.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#include <immintrin.h>
+#define THREADFORGE_HASH_X86 1
+#elif defined(__aarch64__) && defined(__clang__)
+#include <arm_neon.h>
+#define THREADFORGE_HASH_ARM 1
+#if defined(__APPLE__)
+#include <sys/sysctl.h>
+#elif defined(__linux__)
+#include <sys/auxv.h>
+#ifndef HWCAP_SHA2
+#define HWCAP_SHA2 (1 << 6)
+#endif
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+#endif
+// Older arm_neon.h only declares the SHA-256 intrinsics when the whole
+// translation unit targets the extension.
+#if defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO) || __clang_major__ >= 16
+#define THREADFORGE_HASH_ARM_SHA2 1
+#endif
+#endif
+
+namespace threadforge::hashing {
+
+namespace {
+
+// Input per piece when a large CRC32C update is split across the pool.
+constexpr size_t kCrcPiece = 1u << 20;
+constexpr size_t kCrcParallelMinimum = 4u << 20;
+// How much of a file is mapped at a time while hashing it.
+constexpr size_t kFileSlice = 8u << 20;
+
+std::atomic<bool> gAccelerationDisabled{false};
+
+uint32_t readLe32(const uint8_t* data) {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+uint64_t readLe64(const uint8_t* data) {
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+uint32_t readBe32(const uint8_t* data) {
+    return static_cast<uint32_t>(data[0]) << 24 | static_cast<uint32_t>(data[1]) << 16 |
+        static_cast<uint32_t>(data[2]) << 8 | static_cast<uint32_t>(data[3]);
+}
+
+void appendBe(std::vector<uint8_t>& out, uint64_t value, int bytes) {
+    for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+uint32_t rotl32(uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+uint32_t rotr32(uint32_t value, int bits) {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+uint64_t rotl64(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// --- xxHash ---
+
+constexpr uint32_t kPrime32_1 = 0x9E3779B1u;
+constexpr uint32_t kPrime32_2 = 0x85EBCA77u;
+constexpr uint32_t kPrime32_3 = 0xC2B2AE3Du;
+constexpr uint32_t kPrime32_4 = 0x27D4EB2Fu;
+constexpr uint32_t kPrime32_5 = 0x165667B1u;
+
+constexpr uint64_t kPrime64_1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t kPrime64_2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t kPrime64_3 = 0x165667B19E3779F9ull;
+constexpr uint64_t kPrime64_4 = 0x85EBCA77C2B2AE63ull;
+constexpr uint64_t kPrime64_5 = 0x27D4EB2F165667C5ull;
+
+uint32_t xxh32Round(uint32_t accumulator, uint32_t input) {
+    return rotl32(accumulator + input * kPrime32_2, 13) * kPrime32_1;
+}
+
+uint64_t xxh64Round(uint64_t accumulator, uint64_t input) {
+    return rotl64(accumulator + input * kPrime64_2, 31) * kPrime64_1;
+}
+
+uint64_t xxh64Merge(uint64_t accumulator, uint64_t lane) {
+    return (accumulator ^ xxh64Round(0, lane)) * kPrime64_1 + kPrime64_4;
+}
+
+// --- CRC32C ---
+
+// Reflected Castagnoli polynomial.
+constexpr uint32_t kCrcPolynomial = 0x82F63B78u;
+
+struct CrcTables {
+    uint32_t slices[8][256];
+    // x^(2^n) mod P, for shifting a CRC past a run of zero bytes.
+    uint32_t powers[32];
+};
+
+// a * b modulo the polynomial, both in reflected form.
+uint32_t crcMultiply(uint32_t a, uint32_t b) {
+    uint32_t product = 0;
+    for (uint32_t bit = 1u << 31; bit != 0; bit >>= 1) {
+        if (a & bit) {
+            product ^= b;
+        }
+        b = (b & 1) ? (b >> 1) ^ kCrcPolynomial : b >> 1;
+    }
+    return product;
+}
+
+const CrcTables& crcTables() {
+    static const CrcTables tables = [] {
+        CrcTables built{};
+        for (uint32_t byte = 0; byte < 256; ++byte) {
+            uint32_t crc = byte;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 1) ? (crc >> 1) ^ kCrcPolynomial : crc >> 1;
+            }
+            built.slices[0][byte] = crc;
+        }
+        for (uint32_t byte = 0; byte < 256; ++byte) {
+            for (int slice = 1; slice < 8; ++slice) {
+                const uint32_t previous = built.slices[slice - 1][byte];
+                built.slices[slice][byte] = (previous >> 8) ^ built.slices[0][previous & 0xFF];
+            }
+        }
+        built.powers[0] = 1u << 30; // x^1
+        for (int n = 1; n < 32; ++n) {
+            built.powers[n] = crcMultiply(built.powers[n - 1], built.powers[n - 1]);
+        }
+        return built;
+    }();
+    return tables;
+}
+
+// Advances a raw CRC register past length zero bytes.
+uint32_t crcShift(uint32_t crc, uint64_t length) {
+    const auto& powers = crcTables().powers;
+    uint32_t factor = 1u << 31; // x^0
+    // Bytes are 8 bits, so start at x^(2^3).
+    for (int n = 3; length != 0; length >>= 1, ++n) {
+        if (length & 1) {
+            factor = crcMultiply(powers[n & 31], factor);
+        }
+    }
+    return crcMultiply(factor, crc);
+}
+
+// The CRC functions below work on the raw register: no pre- or
+// post-inversion, which crc32c() adds.
+uint32_t crcPortable(uint32_t crc, const uint8_t* data, size_t size) {
+    const auto& table = crcTables().slices;
+    for (; size >= 8; data += 8, size -= 8) {
+        const uint32_t low = readLe32(data) ^ crc;
+        const uint32_t high = readLe32(data + 4);
+        crc = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^ table[5][(low >> 16) & 0xFF] ^
+            table[4][low >> 24] ^ table[3][high & 0xFF] ^ table[2][(high >> 8) & 0xFF] ^
+            table[1][(high >> 16) & 0xFF] ^ table[0][high >> 24];
+    }
+    for (; size > 0; --size) {
+        crc = (crc >> 8) ^ table[0][(crc ^ *data++) & 0xFF];
+    }
+    return crc;
+}
+
+// The CRC instruction's latency is three times its throughput, so long
+// inputs run as three interleaved streams that are combined at the end.
+constexpr size_t kCrcStripe = 8192;
+
+uint32_t crcStripeShift(uint32_t crc) {
+    static const uint32_t factor = crcShift(1u << 31, kCrcStripe);
+    return crcMultiply(factor, crc);
+}
+
+#if defined(THREADFORGE_HASH_X86)
+
+__attribute__((target("sse4.2"))) uint32_t crcSse42(uint32_t crc, const uint8_t* data, size_t size) {
+    for (; size > 0 && (reinterpret_cast<uintptr_t>(data) & 7) != 0; --size) {
+        crc = _mm_crc32_u8(crc, *data++);
+    }
+    uint64_t wide = crc;
+    for (; size >= 3 * kCrcStripe; data += 3 * kCrcStripe, size -= 3 * kCrcStripe) {
+        uint64_t second = 0;
+        uint64_t third = 0;
+        for (size_t i = 0; i < kCrcStripe; i += 8) {
+            wide = _mm_crc32_u64(wide, readLe64(data + i));
+            second = _mm_crc32_u64(second, readLe64(data + kCrcStripe + i));
+            third = _mm_crc32_u64(third, readLe64(data + 2 * kCrcStripe + i));
+        }
+        wide = crcStripeShift(static_cast<uint32_t>(wide)) ^ static_cast<uint32_t>(second);
+        wide = crcStripeShift(static_cast<uint32_t>(wide)) ^ static_cast<uint32_t>(third);
+    }
+    for (; size >= 8; data += 8, size -= 8) {
+        wide = _mm_crc32_u64(wide, readLe64(data));
+    }
+    crc = static_cast<uint32_t>(wide);
+    for (; size > 0; --size) {
+        crc = _mm_crc32_u8(crc, *data++);
+    }
+    return crc;
+}
+
+bool hasSse42() {
+    return __builtin_cpu_supports("sse4.2");
+}
+
+bool hasShaNi() {
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || (ecx & bit_SSE4_1) == 0 || (ecx & bit_SSSE3) == 0) {
+        return false;
+    }
+    return __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & (1u << 29)) != 0;
+}
+
+#elif defined(THREADFORGE_HASH_ARM)
+
+__attribute__((target("crc"))) uint32_t crcArmv8(uint32_t crc, const uint8_t* data, size_t size) {
+    for (; size > 0 && (reinterpret_cast<uintptr_t>(data) & 7) != 0; --size) {
+        crc = __builtin_arm_crc32cb(crc, *data++);
+    }
+    for (; size >= 3 * kCrcStripe; data += 3 * kCrcStripe, size -= 3 * kCrcStripe) {
+        uint32_t second = 0;
+        uint32_t third = 0;
+        for (size_t i = 0; i < kCrcStripe; i += 8) {
+            crc = __builtin_arm_crc32cd(crc, readLe64(data + i));
+            second = __builtin_arm_crc32cd(second, readLe64(data + kCrcStripe + i));
+            third = __builtin_arm_crc32cd(third, readLe64(data + 2 * kCrcStripe + i));
+        }
+        crc = crcStripeShift(crc) ^ second;
+        crc = crcStripeShift(crc) ^ third;
+    }
+    for (; size >= 8; data += 8, size -= 8) {
+        crc = __builtin_arm_crc32cd(crc, readLe64(data));
+    }
+    for (; size > 0; --size) {
+        crc = __builtin_arm_crc32cb(crc, *data++);
+    }
+    return crc;
+}
+
+#if defined(__APPLE__)
+bool sysctlFlag(const char* name) {
+    int value = 0;
+    size_t size = sizeof(value);
+    return sysctlbyname(name, &value, &size, nullptr, 0) == 0 && value != 0;
+}
+#endif
+
+bool hasArmCrc() {
+#if defined(__ARM_FEATURE_CRC32)
+    return true;
+#elif defined(__APPLE__)
+    return sysctlFlag("hw.optional.armv8_crc32");
+#elif defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#else
+    return false;
+#endif
+}
+
+bool hasArmSha2() {
+#if defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO)
+    return true;
+#elif defined(__APPLE__)
+    // Every Apple arm64 core has the SHA-256 instructions.
+    return true;
+#elif defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0;
+#else
+    return false;
+#endif
+}
+
+#endif
+
+using CrcFunction = uint32_t (*)(uint32_t, const uint8_t*, size_t);
+
+struct CrcBackend {
+    CrcFunction function;
+    const char* name;
+};
+
+const CrcBackend& crcBackend() {
+    static const CrcBackend backend = []() -> CrcBackend {
+        if (gAccelerationDisabled.load()) {
+            return {crcPortable, "portable"};
+        }
+#if defined(THREADFORGE_HASH_X86)
+        if (hasSse42()) {
+            return {crcSse42, "sse4.2"};
+        }
+#elif defined(THREADFORGE_HASH_ARM)
+        if (hasArmCrc()) {
+            return {crcArmv8, "armv8-crc"};
+        }
+#endif
+        return {crcPortable, "portable"};
+    }();
+    return backend;
+}
+
+// Raw register over data, split across the pool when there is a lot of it.
+uint32_t crcUpdate(uint32_t crc, const uint8_t* data, size_t size) {
+    const auto function = crcBackend().function;
+    if (size < kCrcParallelMinimum) {
+        return function(crc, data, size);
+    }
+    const size_t pieces = (size + kCrcPiece - 1) / kCrcPiece;
+    std::vector<uint32_t> crcs(pieces);
+    parallelFor(pieces, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const size_t offset = i * kCrcPiece;
+            crcs[i] = function(0, data + offset, std::min(kCrcPiece, size - offset));
+        }
+    });
+    for (size_t i = 0; i < pieces; ++i) {
+        crc = crcShift(crc, std::min(kCrcPiece, size - i * kCrcPiece)) ^ crcs[i];
+    }
+    return crc;
+}
+
+// --- SHA-256 ---
+
+constexpr uint32_t kSha256Initial[8] = {
+    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19,
+};
+
+alignas(16) constexpr uint32_t kSha256Rounds[64] = {
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+    0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+    0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+    0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+    0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+    0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+};
+
+void sha256Portable(uint32_t state[8], const uint8_t* data, size_t blocks) {
+    for (; blocks > 0; --blocks, data += 64) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = readBe32(data + 4 * i);
+        }
+        for (int i = 16; i < 64; ++i) {
+            const uint32_t s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            const uint32_t s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; ++i) {
+            const uint32_t t1 =
+                h + (rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25)) + ((e & f) ^ (~e & g)) + kSha256Rounds[i] + w[i];
+            const uint32_t t2 = (rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+}
+
+#if defined(THREADFORGE_HASH_X86)
+
+// The SHA extensions keep the state as ABEF / CDGH halves and run two
+// rounds per instruction; the message schedule takes one msg1 + msg2 per
+// four words.
+__attribute__((target("sha,sse4.1,ssse3"))) void sha256ShaNi(uint32_t state[8], const uint8_t* data, size_t blocks) {
+    const __m128i byteSwap = _mm_set_epi64x(0x0C0D0E0F08090A0Bll, 0x0405060700010203ll);
+    __m128i low = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xB1);  // CDAB
+    __m128i high = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1B); // EFGH
+    __m128i abef = _mm_alignr_epi8(low, high, 8);
+    __m128i cdgh = _mm_blend_epi16(high, low, 0xF0);
+
+    for (; blocks > 0; --blocks, data += 64) {
+        const __m128i abefSaved = abef;
+        const __m128i cdghSaved = cdgh;
+        __m128i words[4];
+        for (int i = 0; i < 4; ++i) {
+            words[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i)), byteSwap);
+        }
+        for (int group = 0; group < 16; ++group) {
+            __m128i& current = words[group & 3];
+            if (group >= 4) {
+                // current still holds w[t-16..t-13]; the others are the next
+                // three groups of the window.
+                __m128i next = _mm_sha256msg1_epu32(current, words[(group + 1) & 3]);
+                next = _mm_add_epi32(next, _mm_alignr_epi8(words[(group + 3) & 3], words[(group + 2) & 3], 4));
+                current = _mm_sha256msg2_epu32(next, words[(group + 3) & 3]);
+            }
+            __m128i message = _mm_add_epi32(
+                current, _mm_load_si128(reinterpret_cast<const __m128i*>(kSha256Rounds + 4 * group)));
+            cdgh = _mm_sha256rnds2_epu32(cdgh, abef, message);
+            message = _mm_shuffle_epi32(message, 0x0E);
+            abef = _mm_sha256rnds2_epu32(abef, cdgh, message);
+        }
+        abef = _mm_add_epi32(abef, abefSaved);
+        cdgh = _mm_add_epi32(cdgh, cdghSaved);
+    }
+
+    const __m128i feba = _mm_shuffle_epi32(abef, 0x1B);
+    const __m128i dchg = _mm_shuffle_epi32(cdgh, 0xB1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_blend_epi16(feba, dchg, 0xF0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), _mm_alignr_epi8(dchg, feba, 8));
+}
+
+#elif defined(THREADFORGE_HASH_ARM_SHA2)
+
+__attribute__((target("crypto"))) void sha256Armv8(uint32_t state[8], const uint8_t* data, size_t blocks) {
+    uint32x4_t abcd = vld1q_u32(state);
+    uint32x4_t efgh = vld1q_u32(state + 4);
+
+    for (; blocks > 0; --blocks, data += 64) {
+        const uint32x4_t abcdSaved = abcd;
+        const uint32x4_t efghSaved = efgh;
+        uint32x4_t words[4];
+        for (int i = 0; i < 4; ++i) {
+            words[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * i)));
+        }
+        for (int group = 0; group < 16; ++group) {
+            const uint32x4_t message = vaddq_u32(words[group & 3], vld1q_u32(kSha256Rounds + 4 * group));
+            if (group < 12) {
+                // Schedule the words group + 4 will use.
+                words[group & 3] = vsha256su1q_u32(vsha256su0q_u32(words[group & 3], words[(group + 1) & 3]),
+                                                   words[(group + 2) & 3],
+                                                   words[(group + 3) & 3]);
+            }
+            const uint32x4_t previous = abcd;
+            abcd = vsha256hq_u32(abcd, efgh, message);
+            efgh = vsha256h2q_u32(efgh, previous, message);
+        }
+        abcd = vaddq_u32(abcd, abcdSaved);
+        efgh = vaddq_u32(efgh, efghSaved);
+    }
+
+    vst1q_u32(state, abcd);
+    vst1q_u32(state + 4, efgh);
+}
+
+#endif
+
+using Sha256Function = void (*)(uint32_t*, const uint8_t*, size_t);
+
+struct Sha256Backend {
+    Sha256Function function;
+    const char* name;
+};
+
+const Sha256Backend& sha256Backend() {
+    static const Sha256Backend backend = []() -> Sha256Backend {
+        if (gAccelerationDisabled.load()) {
+            return {sha256Portable, "portable"};
+        }
+#if defined(THREADFORGE_HASH_X86)
+        if (hasShaNi()) {
+            return {sha256ShaNi, "sha-ni"};
+        }
+#elif defined(THREADFORGE_HASH_ARM_SHA2)
+        if (hasArmSha2()) {
+            return {sha256Armv8, "armv8-sha2"};
+        }
+#endif
+        return {sha256Portable, "portable"};
+    }();
+    return backend;
+}
+
+class Sha256Hasher : public Hasher {
+public:
+    Sha256Hasher() {
+        reset();
+    }
+
+    void update(const uint8_t* data, size_t size) override {
+        if (size == 0) {
+            return;
+        }
+        total_ += size;
+        if (buffered_ > 0) {
+            const size_t take = std::min(size, 64 - buffered_);
+            std::memcpy(buffer_ + buffered_, data, take);
+            buffered_ += take;
+            data += take;
+            size -= take;
+            if (buffered_ < 64) {
+                return;
+            }
+            sha256Backend().function(state_, buffer_, 1);
+            buffered_ = 0;
+        }
+        const size_t blocks = size / 64;
+        if (blocks > 0) {
+            sha256Backend().function(state_, data, blocks);
+        }
+        std::memcpy(buffer_, data + blocks * 64, size - blocks * 64);
+        buffered_ = size - blocks * 64;
+    }
+
+    std::vector<uint8_t> digest() const override {
+        uint32_t state[8];
+        std::memcpy(state, state_, sizeof(state));
+        uint8_t tail[128] = {};
+        std::memcpy(tail, buffer_, buffered_);
+        tail[buffered_] = 0x80;
+        const size_t length = buffered_ + 9 <= 64 ? 64 : 128;
+        const uint64_t bits = total_ * 8;
+        for (int i = 0; i < 8; ++i) {
+            tail[length - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+        }
+        sha256Backend().function(state, tail, length / 64);
+        std::vector<uint8_t> out;
+        out.reserve(32);
+        for (const uint32_t word : state) {
+            appendBe(out, word, 4);
+        }
+        return out;
+    }
+
+    void reset() override {
+        std::memcpy(state_, kSha256Initial, sizeof(state_));
+        buffered_ = 0;
+        total_ = 0;
+    }
+
+private:
+    uint32_t state_[8];
+    uint8_t buffer_[64];
+    size_t buffered_{0};
+    uint64_t total_{0};
+};
+
+// --- BLAKE3 ---
+
+constexpr size_t kBlake3Block = 64;
+constexpr size_t kBlake3Chunk = 1024;
+// Chunks hashed as one parallel subtree at most (64 MiB of input), which
+// bounds the chaining values held at once.
+constexpr uint64_t kBlake3MaxSubtree = 1u << 16;
+// Below this many chunks a subtree is cheaper to hash on the calling thread.
+constexpr uint64_t kBlake3ParallelMinimum = 64;
+
+// Domain flags.
+constexpr uint32_t kChunkStart = 1;
+constexpr uint32_t kChunkEnd = 2;
+constexpr uint32_t kParent = 4;
+constexpr uint32_t kRoot = 8;
+
+constexpr uint8_t kBlake3Schedule[7][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8},
+    {3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1},
+    {10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6},
+    {12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4},
+    {9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7},
+    {11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13},
+};
+
+using ChainingValue = std::array<uint32_t, 8>;
+
+inline void blake3Mix(uint32_t* v, int a, int b, int c, int d, uint32_t x, uint32_t y) {
+    v[a] += v[b] + x;
+    v[d] = rotr32(v[d] ^ v[a], 16);
+    v[c] += v[d];
+    v[b] = rotr32(v[b] ^ v[c], 12);
+    v[a] += v[b] + y;
+    v[d] = rotr32(v[d] ^ v[a], 8);
+    v[c] += v[d];
+    v[b] = rotr32(v[b] ^ v[c], 7);
+}
+
+// The compression function; the first eight output words are the new
+// chaining value.
+void blake3Compress(const uint32_t cv[8],
+                    const uint32_t block[16],
+                    uint64_t counter,
+                    uint32_t blockLength,
+                    uint32_t flags,
+                    uint32_t out[16]) {
+    uint32_t v[16] = {
+        cv[0], cv[1], cv[2], cv[3], cv[4], cv[5], cv[6], cv[7],
+        kSha256Initial[0], kSha256Initial[1], kSha256Initial[2], kSha256Initial[3],
+        static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32), blockLength, flags,
+    };
+    for (const auto& s : kBlake3Schedule) {
+        blake3Mix(v, 0, 4, 8, 12, block[s[0]], block[s[1]]);
+        blake3Mix(v, 1, 5, 9, 13, block[s[2]], block[s[3]]);
+        blake3Mix(v, 2, 6, 10, 14, block[s[4]], block[s[5]]);
+        blake3Mix(v, 3, 7, 11, 15, block[s[6]], block[s[7]]);
+        blake3Mix(v, 0, 5, 10, 15, block[s[8]], block[s[9]]);
+        blake3Mix(v, 1, 6, 11, 12, block[s[10]], block[s[11]]);
+        blake3Mix(v, 2, 7, 8, 13, block[s[12]], block[s[13]]);
+        blake3Mix(v, 3, 4, 9, 14, block[s[14]], block[s[15]]);
+    }
+    for (int i = 0; i < 8; ++i) {
+        out[i] = v[i] ^ v[i + 8];
+        out[i + 8] = v[i + 8] ^ cv[i];
+    }
+}
+
+void blake3Words(const uint8_t* block, uint32_t words[16]) {
+    for (int i = 0; i < 16; ++i) {
+        words[i] = readLe32(block + 4 * i);
+    }
+}
+
+// What a node hands up the tree: enough to produce either its chaining
+// value or, at the root, the final output.
+struct Blake3Output {
+    ChainingValue cv;
+    uint32_t block[16];
+    uint64_t counter;
+    uint32_t blockLength;
+    uint32_t flags;
+
+    ChainingValue chainingValue() const {
+        uint32_t out[16];
+        blake3Compress(cv.data(), block, counter, blockLength, flags, out);
+        ChainingValue result;
+        std::copy(out, out + 8, result.begin());
+        return result;
+    }
+
+    std::vector<uint8_t> rootBytes() const {
+        uint32_t out[16];
+        blake3Compress(cv.data(), block, 0, blockLength, flags | kRoot, out);
+        std::vector<uint8_t> bytes(32);
+        std::memcpy(bytes.data(), out, bytes.size());
+        return bytes;
+    }
+};
+
+ChainingValue blake3Key() {
+    ChainingValue key;
+    std::copy(kSha256Initial, kSha256Initial + 8, key.begin());
+    return key;
+}
+
+Blake3Output blake3Parent(const ChainingValue& left, const ChainingValue& right) {
+    Blake3Output output;
+    output.cv = blake3Key();
+    std::copy(left.begin(), left.end(), output.block);
+    std::copy(right.begin(), right.end(), output.block + 8);
+    output.counter = 0;
+    output.blockLength = kBlake3Block;
+    output.flags = kParent;
+    return output;
+}
+
+// Chaining value of one whole 1 KiB chunk.
+ChainingValue blake3ChunkCv(const uint8_t* chunk, uint64_t counter) {
+    ChainingValue cv = blake3Key();
+    uint32_t block[16];
+    uint32_t out[16];
+    for (size_t i = 0; i < kBlake3Chunk / kBlake3Block; ++i) {
+        uint32_t flags = 0;
+        if (i == 0) {
+            flags |= kChunkStart;
+        }
+        if (i == kBlake3Chunk / kBlake3Block - 1) {
+            flags |= kChunkEnd;
+        }
+        blake3Words(chunk + i * kBlake3Block, block);
+        blake3Compress(cv.data(), block, counter, kBlake3Block, flags, out);
+        std::copy(out, out + 8, cv.begin());
+    }
+    return cv;
+}
+
+// Chaining value of count (a power of two) whole chunks starting at chunk
+// number counter. Leaves hash in parallel, then each level of parents.
+ChainingValue blake3SubtreeCv(const uint8_t* data, uint64_t counter, size_t count) {
+    std::vector<ChainingValue> level(count);
+    std::vector<ChainingValue> next(count / 2);
+    const bool parallel = count >= kBlake3ParallelMinimum;
+    const auto leaves = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            level[i] = blake3ChunkCv(data + i * kBlake3Chunk, counter + i);
+        }
+    };
+    if (parallel) {
+        parallelFor(count, 16, leaves);
+    } else {
+        leaves(0, count);
+    }
+    for (size_t width = count; width > 1; width /= 2) {
+        const auto parents = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                next[i] = blake3Parent(level[2 * i], level[2 * i + 1]).chainingValue();
+            }
+        };
+        if (parallel && width / 2 >= kBlake3ParallelMinimum) {
+            parallelFor(width / 2, 64, parents);
+        } else {
+            parents(0, width / 2);
+        }
+        std::copy(next.begin(), next.begin() + static_cast<ptrdiff_t>(width / 2), level.begin());
+    }
+    return level[0];
+}
+
+class Blake3Hasher : public Hasher {
+public:
+    Blake3Hasher() {
+        reset();
+    }
+
+    void update(const uint8_t* data, size_t size) override {
+        while (size > 0) {
+            if (chunkLength() == kBlake3Chunk) {
+                // More input follows, so the full chunk is not the root.
+                pushSubtree(chunkOutput().chainingValue(), 0);
+                startChunk(chunkCounter_ + 1);
+            }
+            if (chunkLength() == 0 && size > kBlake3Chunk) {
+                // Hash the largest aligned power-of-two run of whole chunks
+                // that still leaves input behind it as one subtree.
+                uint64_t count = 1;
+                while (count * 2 * kBlake3Chunk < size && count * 2 <= kBlake3MaxSubtree) {
+                    count *= 2;
+                }
+                if (chunkCounter_ != 0) {
+                    count = std::min<uint64_t>(count, chunkCounter_ & (~chunkCounter_ + 1));
+                }
+                int levelBits = 0;
+                while ((uint64_t{1} << levelBits) < count) {
+                    ++levelBits;
+                }
+                pushSubtree(blake3SubtreeCv(data, chunkCounter_, count), levelBits);
+                data += count * kBlake3Chunk;
+                size -= count * kBlake3Chunk;
+                startChunk(chunkCounter_ + count);
+                continue;
+            }
+            if (blockLength_ == kBlake3Block) {
+                uint32_t words[16];
+                uint32_t out[16];
+                blake3Words(block_, words);
+                const uint32_t flags = blocksCompressed_ == 0 ? kChunkStart : 0;
+                blake3Compress(cv_.data(), words, chunkCounter_, kBlake3Block, flags, out);
+                std::copy(out, out + 8, cv_.begin());
+                ++blocksCompressed_;
+                blockLength_ = 0;
+            }
+            const size_t take = std::min(kBlake3Block - blockLength_, size);
+            std::memcpy(block_ + blockLength_, data, take);
+            blockLength_ += take;
+            data += take;
+            size -= take;
+        }
+    }
+
+    std::vector<uint8_t> digest() const override {
+        Blake3Output output = chunkOutput();
+        for (size_t i = stack_.size(); i > 0; --i) {
+            output = blake3Parent(stack_[i - 1], output.chainingValue());
+        }
+        return output.rootBytes();
+    }
+
+    void reset() override {
+        stack_.clear();
+        startChunk(0);
+    }
+
+private:
+    size_t chunkLength() const {
+        return blocksCompressed_ * kBlake3Block + blockLength_;
+    }
+
+    void startChunk(uint64_t counter) {
+        cv_ = blake3Key();
+        chunkCounter_ = counter;
+        std::memset(block_, 0, sizeof(block_));
+        blockLength_ = 0;
+        blocksCompressed_ = 0;
+    }
+
+    Blake3Output chunkOutput() const {
+        Blake3Output output;
+        output.cv = cv_;
+        uint8_t block[kBlake3Block] = {};
+        std::memcpy(block, block_, blockLength_);
+        blake3Words(block, output.block);
+        output.counter = chunkCounter_;
+        output.blockLength = static_cast<uint32_t>(blockLength_);
+        output.flags = (blocksCompressed_ == 0 ? kChunkStart : 0) | kChunkEnd;
+        return output;
+    }
+
+    // Adds the chaining value of 2^levelBits chunks ending at the current
+    // chunk counter, merging completed subtrees like a binary counter.
+    void pushSubtree(ChainingValue cv, int levelBits) {
+        uint64_t total = (chunkCounter_ + (uint64_t{1} << levelBits)) >> levelBits;
+        while ((total & 1) == 0) {
+            cv = blake3Parent(stack_.back(), cv).chainingValue();
+            stack_.pop_back();
+            total >>= 1;
+        }
+        stack_.push_back(cv);
+    }
+
+    std::vector<ChainingValue> stack_;
+    ChainingValue cv_;
+    uint64_t chunkCounter_{0};
+    uint8_t block_[kBlake3Block];
+    size_t blockLength_{0};
+    size_t blocksCompressed_{0};
+};
+
+// --- Adapters ---
+
+class Xxh32Hasher : public Hasher {
+public:
+    explicit Xxh32Hasher(uint32_t seed)
+        : seed_(seed),
+          state_(seed) {}
+
+    void update(const uint8_t* data, size_t size) override {
+        state_.update(data, size);
+    }
+    std::vector<uint8_t> digest() const override {
+        std::vector<uint8_t> out;
+        appendBe(out, state_.digest(), 4);
+        return out;
+    }
+    void reset() override {
+        state_ = Xxh32(seed_);
+    }
+
+private:
+    uint32_t seed_;
+    Xxh32 state_;
+};
+
+class Xxh64Hasher : public Hasher {
+public:
+    explicit Xxh64Hasher(uint64_t seed)
+        : seed_(seed),
+          state_(seed) {}
+
+    void update(const uint8_t* data, size_t size) override {
+        state_.update(data, size);
+    }
+    std::vector<uint8_t> digest() const override {
+        std::vector<uint8_t> out;
+        appendBe(out, state_.digest(), 8);
+        return out;
+    }
+    void reset() override {
+        state_ = Xxh64(seed_);
+    }
+
+private:
+    uint64_t seed_;
+    Xxh64 state_;
+};
+
+class Crc32cHasher : public Hasher {
+public:
+    void update(const uint8_t* data, size_t size) override {
+        crc_ = crc32c(crc_, data, size);
+    }
+    std::vector<uint8_t> digest() const override {
+        std::vector<uint8_t> out;
+        appendBe(out, crc_, 4);
+        return out;
+    }
+    void reset() override {
+        crc_ = 0;
+    }
+
+private:
+    uint32_t crc_{0};
+};
+
+} // namespace
+
+Xxh32::Xxh32(uint32_t seed)
+    : seed_(seed),
+      lanes_{seed + kPrime32_1 + kPrime32_2, seed + kPrime32_2, seed, seed - kPrime32_1} {}
+
+void Xxh32::update(const uint8_t* data, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    total_ += size;
+    const auto consume = [this](const uint8_t* stripe) {
+        for (int lane = 0; lane < 4; ++lane) {
+            lanes_[lane] = xxh32Round(lanes_[lane], readLe32(stripe + lane * 4));
+        }
+    };
+    if (buffered_ + size < 16) {
+        std::memcpy(buffer_ + buffered_, data, size);
+        buffered_ += size;
+        return;
+    }
+    if (buffered_ > 0) {
+        const size_t fill = 16 - buffered_;
+        std::memcpy(buffer_ + buffered_, data, fill);
+        consume(buffer_);
+        data += fill;
+        size -= fill;
+        buffered_ = 0;
+    }
+    for (; size >= 16; data += 16, size -= 16) {
+        consume(data);
+    }
+    std::memcpy(buffer_, data, size);
+    buffered_ = size;
+}
+
+uint32_t Xxh32::digest() const {
+    uint32_t hash = total_ >= 16
+        ? rotl32(lanes_[0], 1) + rotl32(lanes_[1], 7) + rotl32(lanes_[2], 12) + rotl32(lanes_[3], 18)
+        : seed_ + kPrime32_5;
+    hash += static_cast<uint32_t>(total_);
+    size_t i = 0;
+    for (; i + 4 <= buffered_; i += 4) {
+        hash = rotl32(hash + readLe32(buffer_ + i) * kPrime32_3, 17) * kPrime32_4;
+    }
+    for (; i < buffered_; ++i) {
+        hash = rotl32(hash + buffer_[i] * kPrime32_5, 11) * kPrime32_1;
+    }
+    hash ^= hash >> 15;
+    hash *= kPrime32_2;
+    hash ^= hash >> 13;
+    hash *= kPrime32_3;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+uint32_t Xxh32::of(const uint8_t* data, size_t size, uint32_t seed) {
+    Xxh32 hash(seed);
+    hash.update(data, size);
+    return hash.digest();
+}
+
+Xxh64::Xxh64(uint64_t seed)
+    : seed_(seed),
+      lanes_{seed + kPrime64_1 + kPrime64_2, seed + kPrime64_2, seed, seed - kPrime64_1} {}
+
+void Xxh64::update(const uint8_t* data, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    total_ += size;
+    const auto consume = [this](const uint8_t* stripe) {
+        for (int lane = 0; lane < 4; ++lane) {
+            lanes_[lane] = xxh64Round(lanes_[lane], readLe64(stripe + lane * 8));
+        }
+    };
+    if (buffered_ + size < 32) {
+        std::memcpy(buffer_ + buffered_, data, size);
+        buffered_ += size;
+        return;
+    }
+    if (buffered_ > 0) {
+        const size_t fill = 32 - buffered_;
+        std::memcpy(buffer_ + buffered_, data, fill);
+        consume(buffer_);
+        data += fill;
+        size -= fill;
+        buffered_ = 0;
+    }
+    for (; size >= 32; data += 32, size -= 32) {
+        consume(data);
+    }
+    std::memcpy(buffer_, data, size);
+    buffered_ = size;
+}
+
+uint64_t Xxh64::digest() const {
+    uint64_t hash;
+    if (total_ >= 32) {
+        hash = rotl64(lanes_[0], 1) + rotl64(lanes_[1], 7) + rotl64(lanes_[2], 12) + rotl64(lanes_[3], 18);
+        for (const uint64_t lane : lanes_) {
+            hash = xxh64Merge(hash, lane);
+        }
+    } else {
+        hash = seed_ + kPrime64_5;
+    }
+    hash += total_;
+    size_t i = 0;
+    for (; i + 8 <= buffered_; i += 8) {
+        hash = rotl64(hash ^ xxh64Round(0, readLe64(buffer_ + i)), 27) * kPrime64_1 + kPrime64_4;
+    }
+    if (i + 4 <= buffered_) {
+        hash = rotl64(hash ^ (static_cast<uint64_t>(readLe32(buffer_ + i)) * kPrime64_1), 23) * kPrime64_2 + kPrime64_3;
+        i += 4;
+    }
+    for (; i < buffered_; ++i) {
+        hash = rotl64(hash ^ (buffer_[i] * kPrime64_5), 11) * kPrime64_1;
+    }
+    hash ^= hash >> 33;
+    hash *= kPrime64_2;
+    hash ^= hash >> 29;
+    hash *= kPrime64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+uint32_t crc32c(uint32_t crc, const uint8_t* data, size_t size) {
+    return ~crcUpdate(~crc, data, size);
+}
+
+bool parseAlgorithm(const std::string& name, Algorithm& algorithm) {
+    if (name == "xxh32") {
+        algorithm = Algorithm::XXH32;
+    } else if (name == "xxh64") {
+        algorithm = Algorithm::XXH64;
+    } else if (name == "crc32c") {
+        algorithm = Algorithm::CRC32C;
+    } else if (name == "sha256") {
+        algorithm = Algorithm::SHA256;
+    } else if (name == "blake3") {
+        algorithm = Algorithm::BLAKE3;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* algorithmName(Algorithm algorithm) {
+    switch (algorithm) {
+    case Algorithm::XXH32:
+        return "xxh32";
+    case Algorithm::XXH64:
+        return "xxh64";
+    case Algorithm::CRC32C:
+        return "crc32c";
+    case Algorithm::SHA256:
+        return "sha256";
+    case Algorithm::BLAKE3:
+        return "blake3";
+    }
+    return "unknown";
+}
+
+size_t digestSize(Algorithm algorithm) {
+    switch (algorithm) {
+    case Algorithm::XXH32:
+    case Algorithm::CRC32C:
+        return 4;
+    case Algorithm::XXH64:
+        return 8;
+    case Algorithm::SHA256:
+    case Algorithm::BLAKE3:
+        return 32;
+    }
+    return 0;
+}
+
+const char* implementation(Algorithm algorithm) {
+    switch (algorithm) {
+    case Algorithm::CRC32C:
+        return crcBackend().name;
+    case Algorithm::SHA256:
+        return sha256Backend().name;
+    default:
+        return "portable";
+    }
+}
+
+void disableAcceleration() {
+    gAccelerationDisabled.store(true);
+}
+
+std::unique_ptr<Hasher> Hasher::create(Algorithm algorithm, uint64_t seed) {
+    switch (algorithm) {
+    case Algorithm::XXH32:
+        return std::make_unique<Xxh32Hasher>(static_cast<uint32_t>(seed));
+    case Algorithm::XXH64:
+        return std::make_unique<Xxh64Hasher>(seed);
+    case Algorithm::CRC32C:
+        return std::make_unique<Crc32cHasher>();
+    case Algorithm::SHA256:
+        return std::make_unique<Sha256Hasher>();
+    case Algorithm::BLAKE3:
+        return std::make_unique<Blake3Hasher>();
+    }
+    throw std::invalid_argument("unknown hash algorithm");
+}
+
+std::vector<uint8_t> hash(Algorithm algorithm, const uint8_t* data, size_t size, uint64_t seed) {
+    auto hasher = Hasher::create(algorithm, seed);
+    hasher->update(data, size);
+    return hasher->digest();
+}
+
+bool hashFile(Algorithm algorithm,
+              const std::string& path,
+              std::vector<uint8_t>& digest,
+              uint64_t& size,
+              const std::function<bool()>& isCancelled,
+              uint64_t seed) {
+    auto hasher = Hasher::create(algorithm, seed);
+    files::FileReader reader(path);
+    while (auto slice = reader.nextChunk(kFileSlice)) {
+        if (isCancelled && isCancelled()) {
+            return false;
+        }
+        hasher->update(slice->data(), slice->size());
+    }
+    size = reader.size();
+    digest = hasher->digest();
+    return true;
+}
+
+} // namespace threadforge::hashing
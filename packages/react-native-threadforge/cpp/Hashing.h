@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace threadforge::hashing {
+
+enum class Algorithm : uint8_t {
+    // Fast non-cryptographic hashes for dedup keys and hash tables.
+    XXH32,
+    XXH64,
+    // Castagnoli CRC, the checksum iSCSI, ext4 and LevelDB use.
+    CRC32C,
+    // Cryptographic hashes for content addressing and integrity.
+    SHA256,
+    BLAKE3
+};
+
+// "xxh32", "xxh64", "crc32c", "sha256" or "blake3". False for anything else.
+bool parseAlgorithm(const std::string& name, Algorithm& algorithm);
+const char* algorithmName(Algorithm algorithm);
+size_t digestSize(Algorithm algorithm);
+
+// The code path algorithm takes on this device: "sse4.2" or "armv8-crc" for
+// CRC32C, "sha-ni" or "armv8-sha2" for SHA-256, "portable" otherwise. The
+// instructions are optional on both x86-64 and arm64, so they are detected at
+// runtime rather than assumed from the build target.
+const char* implementation(Algorithm algorithm);
+
+// Keeps CRC32C and SHA-256 on the portable code even where the CPU has the
+// instructions. Only effective before the first hash of either.
+void disableAcceleration();
+
+// Incremental hashing. Digests are big-endian byte strings, so the 32- and
+// 64-bit hashes read the same as their usual hex form. Large updates to
+// BLAKE3 hash whole subtrees of the input in parallel on the shared pool,
+// and large CRC32C updates split into pieces whose CRCs are combined; the
+// other algorithms are inherently serial.
+class Hasher {
+public:
+    // seed applies to the xxHash functions and is ignored by the rest.
+    static std::unique_ptr<Hasher> create(Algorithm algorithm, uint64_t seed = 0);
+    virtual ~Hasher() = default;
+
+    virtual void update(const uint8_t* data, size_t size) = 0;
+    // The digest of everything so far; more updates may follow.
+    virtual std::vector<uint8_t> digest() const = 0;
+    // Starts over with the same algorithm and seed.
+    virtual void reset() = 0;
+};
+
+std::vector<uint8_t> hash(Algorithm algorithm, const uint8_t* data, size_t size, uint64_t seed = 0);
+
+// Streams the file at path through a hasher. False when isCancelled stopped
+// it first.
+bool hashFile(Algorithm algorithm,
+              const std::string& path,
+              std::vector<uint8_t>& digest,
+              uint64_t& size,
+              const std::function<bool()>& isCancelled = nullptr,
+              uint64_t seed = 0);
+
+// The primitives themselves, for formats that embed them (LZ4 frames carry
+// xxHash32 checksums).
+class Xxh32 {
+public:
+    explicit Xxh32(uint32_t seed = 0);
+
+    void update(const uint8_t* data, size_t size);
+    uint32_t digest() const;
+
+    static uint32_t of(const uint8_t* data, size_t size, uint32_t seed = 0);
+
+private:
+    uint32_t seed_;
+    uint32_t lanes_[4];
+    uint8_t buffer_[16]{};
+    size_t buffered_{0};
+    uint64_t total_{0};
+};
+
+class Xxh64 {
+public:
+    explicit Xxh64(uint64_t seed = 0);
+
+    void update(const uint8_t* data, size_t size);
+    uint64_t digest() const;
+
+private:
+    uint64_t seed_;
+    uint64_t lanes_[4];
+    uint8_t buffer_[32]{};
+    size_t buffered_{0};
+    uint64_t total_{0};
+};
+
+// Continues crc (0 to start) over data, hardware-accelerated when possible.
+uint32_t crc32c(uint32_t crc, const uint8_t* data, size_t size);
+
+} // namespace threadforge::hashing
@@ -0,0 +1,1035 @@
+#include "Ingest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+#include "Files.h"
+#include "ParallelFor.h"
+
+namespace threadforge::ingest {
+
+namespace {
+
+// Inputs are split into chunks of about this many bytes, each parsed as one
+// pool task.
+constexpr size_t kChunkSize = size_t(1) << 20;
+
+constexpr double kPowersOfTen[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+bool isBlank(std::string_view text) {
+    return std::all_of(text.begin(), text.end(), isSpace);
+}
+
+// Parses a decimal number with optional sign, fraction and exponent, allowing
+// surrounding spaces. Up to 18 significant digits with a small exponent are
+// exact in doubles and take a fast path; the rest go through strtod.
+bool parseNumber(std::string_view text, double& value) {
+    const char* p = text.data();
+    const char* last = text.data() + text.size();
+    while (p < last && isSpace(*p)) {
+        ++p;
+    }
+    while (last > p && isSpace(last[-1])) {
+        --last;
+    }
+    const char* const start = p;
+    bool negative = false;
+    if (p < last && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+    constexpr uint64_t kMantissaLimit = 1000000000000000000ULL;
+    uint64_t mantissa = 0;
+    int64_t exponent = 0;
+    bool digits = false;
+    bool truncated = false;
+    for (; p < last && isDigit(*p); ++p) {
+        digits = true;
+        if (mantissa < kMantissaLimit) {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+        } else {
+            ++exponent;
+            truncated = true;
+        }
+    }
+    if (p < last && *p == '.') {
+        for (++p; p < last && isDigit(*p); ++p) {
+            digits = true;
+            if (mantissa < kMantissaLimit) {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                --exponent;
+            } else {
+                truncated = true;
+            }
+        }
+    }
+    if (!digits) {
+        return false;
+    }
+    if (p < last && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negativeExponent = false;
+        if (p < last && (*p == '-' || *p == '+')) {
+            negativeExponent = *p == '-';
+            ++p;
+        }
+        if (p == last || !isDigit(*p)) {
+            return false;
+        }
+        int64_t written = 0;
+        for (; p < last && isDigit(*p); ++p) {
+            if (written < 100000) {
+                written = written * 10 + (*p - '0');
+            }
+        }
+        exponent += negativeExponent ? -written : written;
+    }
+    if (p != last) {
+        return false;
+    }
+    if (!truncated && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+        // Both operands are exact, so the one rounding is the correct one.
+        const auto magnitude = exponent < 0 ? static_cast<double>(mantissa) / kPowersOfTen[-exponent]
+                                            : static_cast<double>(mantissa) * kPowersOfTen[exponent];
+        value = negative ? -magnitude : magnitude;
+        return true;
+    }
+    const std::string copy(start, last);
+    value = std::strtod(copy.c_str(), nullptr);
+    return true;
+}
+
+int32_t toInt32(double value) {
+    return value > -2147483649.0 && value < 2147483648.0 ? static_cast<int32_t>(value) : 0;
+}
+
+size_t elementSize(ColumnKind kind) {
+    return kind == ColumnKind::FLOAT64 ? 8 : 4;
+}
+
+struct Schema {
+    std::vector<std::string> names;
+    std::vector<ColumnKind> kinds;
+};
+
+// The kind options.types gives name, else the sampled one.
+ColumnKind kindOf(const Options& options, const std::string& name, bool seen, bool numeric) {
+    for (const auto& [typed, kind] : options.types) {
+        if (typed == name) {
+            return kind;
+        }
+    }
+    return seen && numeric ? ColumnKind::FLOAT64 : ColumnKind::STRING;
+}
+
+// A column while its chunk is parsed: numbers for the numeric kinds, codes into
+// a chunk-local dictionary for STRING.
+struct ChunkColumn {
+    std::vector<double> numbers;
+    std::vector<uint32_t> codes;
+    std::unordered_map<std::string_view, uint32_t> lookup;
+    std::vector<std::string_view> dictionary;
+};
+
+struct Chunk {
+    size_t begin{0};
+    size_t end{0};
+    size_t rows{0};
+    std::vector<ChunkColumn> columns;
+    // Unescaped strings the dictionaries point into; the rest point into the input.
+    std::deque<std::string> strings;
+    // CSV: where the last record ended, past end when the split was wrong,
+    // and what the chunk threw, which only counts if the split was right.
+    size_t stop{0};
+    std::exception_ptr error;
+};
+
+// text is transient when it points into scratch space that the next record
+// reuses.
+uint32_t intern(Chunk& chunk, ChunkColumn& column, std::string_view text, bool transient) {
+    const auto found = column.lookup.find(text);
+    if (found != column.lookup.end()) {
+        return found->second;
+    }
+    if (transient) {
+        text = chunk.strings.emplace_back(text);
+    }
+    const auto code = static_cast<uint32_t>(column.dictionary.size());
+    column.dictionary.push_back(text);
+    column.lookup.emplace(text, code);
+    return code;
+}
+
+void appendMissing(ChunkColumn& column, ColumnKind kind) {
+    if (kind == ColumnKind::STRING) {
+        column.codes.push_back(kMissingCode);
+    } else {
+        column.numbers.push_back(NAN);
+    }
+}
+
+// Splits [begin, size) into chunks of about kChunkSize bytes, moving every
+// split forward to recordStart(index, offset), the first record boundary at or
+// after offset.
+std::vector<Chunk> splitChunks(size_t begin,
+                               size_t size,
+                               const std::function<size_t(size_t index, size_t offset)>& recordStart) {
+    const size_t count = std::max<size_t>(1, (size - begin + kChunkSize - 1) / kChunkSize);
+    std::vector<Chunk> chunks(count);
+    chunks[0].begin = begin;
+    for (size_t i = 1; i < count; ++i) {
+        chunks[i].begin = std::max(chunks[i - 1].begin, recordStart(i, begin + i * kChunkSize));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        chunks[i].end = i + 1 < count ? chunks[i + 1].begin : size;
+    }
+    return chunks;
+}
+
+// Concatenates the chunks' columns into table. Dictionaries are merged in
+// chunk order, then each chunk's values are copied (and codes remapped) in
+// parallel.
+bool assemble(std::vector<Chunk>& chunks,
+              const Schema& schema,
+              Table& table,
+              const std::function<bool()>& isCancelled) {
+    std::vector<size_t> offsets(chunks.size() + 1, 0);
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        offsets[i + 1] = offsets[i] + chunks[i].rows;
+    }
+    Table result;
+    result.rows = offsets.back();
+    // remaps[column][chunk][local code] = global code.
+    std::vector<std::vector<std::vector<uint32_t>>> remaps(schema.names.size());
+    for (size_t c = 0; c < schema.names.size(); ++c) {
+        Column column;
+        column.name = schema.names[c];
+        column.kind = schema.kinds[c];
+        column.data.resize(result.rows * elementSize(column.kind));
+        if (column.kind == ColumnKind::STRING) {
+            std::unordered_map<std::string_view, uint32_t> lookup;
+            std::vector<std::string_view> order;
+            for (const auto& chunk : chunks) {
+                auto& remap = remaps[c].emplace_back();
+                remap.reserve(chunk.columns[c].dictionary.size());
+                for (const auto text : chunk.columns[c].dictionary) {
+                    const auto inserted = lookup.emplace(text, static_cast<uint32_t>(order.size()));
+                    if (inserted.second) {
+                        order.push_back(text);
+                    }
+                    remap.push_back(inserted.first->second);
+                }
+            }
+            column.dictionary.reserve(order.size());
+            for (const auto text : order) {
+                column.dictionary.emplace_back(text);
+            }
+        }
+        result.columns.push_back(std::move(column));
+    }
+
+    const bool completed = parallelFor(
+        chunks.size(),
+        1,
+        [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                for (size_t c = 0; c < result.columns.size(); ++c) {
+                    auto& column = result.columns[c];
+                    auto& source = chunks[i].columns[c];
+                    const size_t rows = chunks[i].rows;
+                    auto* out = column.data.data() + offsets[i] * elementSize(column.kind);
+                    switch (column.kind) {
+                    case ColumnKind::FLOAT64:
+                        if (rows > 0) {
+                            std::memcpy(out, source.numbers.data(), rows * sizeof(double));
+                        }
+                        break;
+                    case ColumnKind::FLOAT32:
+                        std::transform(source.numbers.begin(),
+                                       source.numbers.end(),
+                                       reinterpret_cast<float*>(out),
+                                       [](double value) { return static_cast<float>(value); });
+                        break;
+                    case ColumnKind::INT32:
+                        std::transform(
+                            source.numbers.begin(), source.numbers.end(), reinterpret_cast<int32_t*>(out), toInt32);
+                        break;
+                    case ColumnKind::STRING: {
+                        const auto& remap = remaps[c][i];
+                        std::transform(source.codes.begin(),
+                                       source.codes.end(),
+                                       reinterpret_cast<uint32_t*>(out),
+                                       [&remap](uint32_t code) { return code == kMissingCode ? code : remap[code]; });
+                        break;
+                    }
+                    }
+                    // Done with the chunk's copy; release it while the rest finish.
+                    std::vector<double>().swap(source.numbers);
+                    std::vector<uint32_t>().swap(source.codes);
+                }
+            }
+        },
+        isCancelled);
+    if (!completed) {
+        return false;
+    }
+    table = std::move(result);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// CSV
+
+struct Field {
+    std::string_view text;
+    bool transient{false};
+};
+
+// Reads the record at pos into fields and returns the offset just past it.
+// Quoted fields with "" escapes are unescaped into scratch, which is cleared
+// first, so they only last until the next call.
+size_t readRecord(const char* data,
+                  size_t size,
+                  size_t pos,
+                  char delimiter,
+                  std::vector<Field>& fields,
+                  std::deque<std::string>& scratch) {
+    fields.clear();
+    scratch.clear();
+    while (true) {
+        Field field;
+        if (pos < size && data[pos] == '"') {
+            const size_t open = pos++;
+            const size_t start = pos;
+            bool escaped = false;
+            while (true) {
+                const auto* quote = static_cast<const char*>(std::memchr(data + pos, '"', size - pos));
+                if (quote == nullptr) {
+                    throw std::invalid_argument("unterminated quoted field at byte " + std::to_string(open));
+                }
+                pos = static_cast<size_t>(quote - data);
+                if (pos + 1 < size && data[pos + 1] == '"') {
+                    escaped = true;
+                    pos += 2;
+                    continue;
+                }
+                break;
+            }
+            field.text = std::string_view(data + start, pos - start);
+            ++pos;
+            if (escaped) {
+                auto& text = scratch.emplace_back();
+                text.reserve(field.text.size());
+                for (size_t i = 0; i < field.text.size(); ++i) {
+                    text.push_back(field.text[i]);
+                    i += field.text[i] == '"' ? 1 : 0;
+                }
+                field.text = text;
+                field.transient = true;
+            }
+            // Anything between the closing quote and the delimiter is outside
+            // RFC 4180 and dropped.
+            while (pos < size && data[pos] != delimiter && data[pos] != '\n') {
+                ++pos;
+            }
+        } else {
+            const size_t start = pos;
+            while (pos < size && data[pos] != delimiter && data[pos] != '\n') {
+                ++pos;
+            }
+            size_t stop = pos;
+            if (stop > start && data[stop - 1] == '\r' && (pos == size || data[pos] == '\n')) {
+                --stop;
+            }
+            field.text = std::string_view(data + start, stop - start);
+        }
+        fields.push_back(field);
+        if (pos >= size) {
+            return size;
+        }
+        if (data[pos] == '\n') {
+            return pos + 1;
+        }
+        ++pos;
+    }
+}
+
+// Skips an empty line ("\n" or "\r\n") at pos, if there is one.
+size_t skipBlankLine(const char* data, size_t size, size_t pos) {
+    if (data[pos] == '\n') {
+        return pos + 1;
+    }
+    if (data[pos] == '\r' && (pos + 1 == size || data[pos + 1] == '\n')) {
+        return std::min(pos + 2, size);
+    }
+    return pos;
+}
+
+void parseCsvChunk(const char* data,
+                   size_t size,
+                   char delimiter,
+                   const Schema& schema,
+                   const std::vector<size_t>& sources,
+                   Chunk& chunk) {
+    chunk.columns.resize(schema.names.size());
+    std::vector<Field> fields;
+    std::deque<std::string> scratch;
+    size_t pos = chunk.begin;
+    while (pos < chunk.end) {
+        const size_t next = skipBlankLine(data, size, pos);
+        if (next != pos) {
+            pos = next;
+            continue;
+        }
+        pos = readRecord(data, size, pos, delimiter, fields, scratch);
+        for (size_t c = 0; c < sources.size(); ++c) {
+            auto& column = chunk.columns[c];
+            const auto kind = schema.kinds[c];
+            if (sources[c] >= fields.size()) {
+                appendMissing(column, kind);
+            } else if (kind == ColumnKind::STRING) {
+                const auto& field = fields[sources[c]];
+                column.codes.push_back(intern(chunk, column, field.text, field.transient));
+            } else {
+                double value = NAN;
+                column.numbers.push_back(parseNumber(fields[sources[c]].text, value) ? value : NAN);
+            }
+        }
+        ++chunk.rows;
+    }
+    chunk.stop = pos;
+}
+
+bool parseCsv(const char* data,
+              size_t size,
+              size_t begin,
+              const Options& options,
+              Table& table,
+              const std::function<bool()>& isCancelled) {
+    const char delimiter = options.delimiter;
+    if (delimiter == '"' || delimiter == '\n' || delimiter == '\r') {
+        throw std::invalid_argument("the delimiter cannot be a quote or a line break");
+    }
+    std::vector<Field> fields;
+    std::deque<std::string> scratch;
+    std::vector<std::string> names;
+    size_t pos = begin;
+    if (options.header) {
+        while (pos < size && skipBlankLine(data, size, pos) != pos) {
+            pos = skipBlankLine(data, size, pos);
+        }
+        if (pos < size) {
+            pos = readRecord(data, size, pos, delimiter, fields, scratch);
+            for (const auto& field : fields) {
+                names.emplace_back(field.text);
+            }
+        }
+    }
+
+    // Sample the first records for column kinds (and, without a header, the
+    // column count).
+    std::vector<uint8_t> seen(names.size(), 0);
+    std::vector<uint8_t> numeric(names.size(), 1);
+    size_t sample = pos;
+    for (size_t records = 0; records < options.inferRows && sample < size;) {
+        const size_t next = skipBlankLine(data, size, sample);
+        if (next != sample) {
+            sample = next;
+            continue;
+        }
+        sample = readRecord(data, size, sample, delimiter, fields, scratch);
+        ++records;
+        if (!options.header && fields.size() > seen.size()) {
+            seen.resize(fields.size(), 0);
+            numeric.resize(fields.size(), 1);
+        }
+        for (size_t f = 0; f < std::min(fields.size(), seen.size()); ++f) {
+            double value = 0;
+            if (!isBlank(fields[f].text)) {
+                seen[f] = 1;
+                numeric[f] = numeric[f] && parseNumber(fields[f].text, value);
+            }
+        }
+    }
+    for (size_t f = names.size(); f < seen.size(); ++f) {
+        names.push_back(std::to_string(f));
+    }
+
+    const auto indexOf = [&names](const std::string& name) {
+        const auto found = std::find(names.begin(), names.end(), name);
+        if (found == names.end()) {
+            throw std::invalid_argument("unknown column '" + name + "'");
+        }
+        return static_cast<size_t>(found - names.begin());
+    };
+    for (const auto& typed : options.types) {
+        indexOf(typed.first);
+    }
+    Schema schema;
+    std::vector<size_t> sources;
+    for (size_t i = 0; i < (options.select.empty() ? names.size() : options.select.size()); ++i) {
+        const size_t source = options.select.empty() ? i : indexOf(options.select[i]);
+        schema.names.push_back(names[source]);
+        schema.kinds.push_back(kindOf(options, names[source], seen[source], numeric[source]));
+        sources.push_back(source);
+    }
+
+    // A chunk boundary must not fall inside a quoted field. Every quote
+    // toggles the state, "" escapes included, so the parity of the quotes
+    // before a split says whether it lands inside one.
+    const size_t nominal = std::max<size_t>(1, (size - pos + kChunkSize - 1) / kChunkSize);
+    std::vector<uint8_t> insideQuotes(nominal, 0);
+    const bool counted = parallelFor(
+        nominal,
+        1,
+        [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                const char* start = data + pos + i * kChunkSize;
+                const char* end = data + std::min(size, pos + (i + 1) * kChunkSize);
+                insideQuotes[i] = static_cast<uint8_t>(std::count(start, end, '"') & 1);
+            }
+        },
+        isCancelled);
+    if (!counted) {
+        return false;
+    }
+    for (size_t i = 1; i < nominal; ++i) {
+        insideQuotes[i] ^= insideQuotes[i - 1];
+    }
+    auto chunks = splitChunks(pos, size, [&](size_t index, size_t offset) {
+        bool quoted = insideQuotes[index - 1] != 0;
+        for (; offset < size; ++offset) {
+            if (data[offset] == '"') {
+                quoted = !quoted;
+            } else if (data[offset] == '\n' && !quoted) {
+                return offset + 1;
+            }
+        }
+        return size;
+    });
+
+    const bool parsed = parallelFor(
+        chunks.size(),
+        1,
+        [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                try {
+                    parseCsvChunk(data, size, delimiter, schema, sources, chunks[i]);
+                } catch (...) {
+                    chunks[i].error = std::current_exception();
+                }
+            }
+        },
+        isCancelled);
+    if (!parsed) {
+        return false;
+    }
+    // A quote inside an unquoted field throws the parity off. The parser
+    // ignores such quotes, so the chunk before a misplaced split overruns its
+    // end (and the one after may fail); parse again in one piece.
+    const bool split = std::all_of(chunks.begin(), chunks.end(), [](const Chunk& chunk) {
+        return chunk.error || chunk.stop == chunk.end;
+    });
+    if (split) {
+        for (const auto& chunk : chunks) {
+            if (chunk.error) {
+                std::rethrow_exception(chunk.error);
+            }
+        }
+    } else {
+        chunks.assign(1, Chunk());
+        chunks[0].begin = pos;
+        chunks[0].end = size;
+        parseCsvChunk(data, size, delimiter, schema, sources, chunks[0]);
+        if (isCancelled && isCancelled()) {
+            return false;
+        }
+    }
+    return assemble(chunks, schema, table, isCancelled);
+}
+
+// ---------------------------------------------------------------------------
+// NDJSON
+
+enum class ValueKind : uint8_t { STRING, NUMBER, BOOLEAN, NULL_VALUE, NESTED };
+
+struct JsonValue {
+    ValueKind kind{ValueKind::NULL_VALUE};
+    // Unescaped for strings, the literal text for numbers and nested values.
+    std::string_view text;
+    bool transient{false};
+    bool boolean{false};
+};
+
+void appendUtf8(std::string& out, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        out.push_back(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+// Reads the members of the flat JSON object on one line. Nested values are
+// skipped over, not parsed; only their extent matters.
+class LineScanner {
+public:
+    LineScanner(const char* data, size_t begin, size_t end, std::deque<std::string>& scratch)
+        : p_(data + begin),
+          end_(data + end),
+          offset_(begin),
+          scratch_(scratch) {}
+
+    // Calls member(key, value) for each member, in order.
+    template <typename Member>
+    void scan(Member&& member) {
+        skipSpace();
+        expect('{');
+        skipSpace();
+        if (p_ < end_ && *p_ == '}') {
+            ++p_;
+        } else {
+            while (true) {
+                skipSpace();
+                if (p_ >= end_ || *p_ != '"') {
+                    fail();
+                }
+                bool transient = false;
+                const auto key = readString(transient);
+                skipSpace();
+                expect(':');
+                member(key, readValue());
+                skipSpace();
+                if (p_ < end_ && *p_ == ',') {
+                    ++p_;
+                    continue;
+                }
+                expect('}');
+                break;
+            }
+        }
+        skipSpace();
+        if (p_ != end_) {
+            fail();
+        }
+    }
+
+private:
+    [[noreturn]] void fail() const {
+        throw std::invalid_argument("the line at byte " + std::to_string(offset_) + " is not a JSON object");
+    }
+
+    void skipSpace() {
+        while (p_ < end_ && (isSpace(*p_) || *p_ == '\n')) {
+            ++p_;
+        }
+    }
+
+    void expect(char c) {
+        if (p_ >= end_ || *p_ != c) {
+            fail();
+        }
+        ++p_;
+    }
+
+    void expectWord(const char* word) {
+        const size_t length = std::strlen(word);
+        if (static_cast<size_t>(end_ - p_) < length || std::memcmp(p_, word, length) != 0) {
+            fail();
+        }
+        p_ += length;
+    }
+
+    uint32_t readHex4() {
+        if (end_ - p_ < 4) {
+            fail();
+        }
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            const char c = *p_++;
+            value <<= 4;
+            if (c >= '0' && c <= '9') {
+                value |= static_cast<uint32_t>(c - '0');
+            } else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+                value |= static_cast<uint32_t>((c | 0x20) - 'a' + 10);
+            } else {
+                fail();
+            }
+        }
+        return value;
+    }
+
+    // At an opening quote. Strings without escapes are returned in place.
+    std::string_view readString(bool& transient) {
+        const char* start = ++p_;
+        while (p_ < end_ && *p_ != '"' && *p_ != '\\') {
+            ++p_;
+        }
+        if (p_ >= end_) {
+            fail();
+        }
+        if (*p_ == '"') {
+            transient = false;
+            return std::string_view(start, static_cast<size_t>(p_++ - start));
+        }
+        auto& out = scratch_.emplace_back(start, p_);
+        while (true) {
+            if (p_ >= end_) {
+                fail();
+            }
+            const char c = *p_++;
+            if (c == '"') {
+                break;
+            }
+            if (c != '\\') {
+                out.push_back(c);
+                continue;
+            }
+            if (p_ >= end_) {
+                fail();
+            }
+            switch (*p_++) {
+            case '"':
+                out.push_back('"');
+                break;
+            case '\\':
+                out.push_back('\\');
+                break;
+            case '/':
+                out.push_back('/');
+                break;
+            case 'b':
+                out.push_back('\b');
+                break;
+            case 'f':
+                out.push_back('\f');
+                break;
+            case 'n':
+                out.push_back('\n');
+                break;
+            case 'r':
+                out.push_back('\r');
+                break;
+            case 't':
+                out.push_back('\t');
+                break;
+            case 'u': {
+                uint32_t codePoint = readHex4();
+                if (codePoint >= 0xD800 && codePoint < 0xDC00 && end_ - p_ >= 6 && p_[0] == '\\' && p_[1] == 'u') {
+                    const char* pair = p_;
+                    p_ += 2;
+                    const uint32_t low = readHex4();
+                    if (low >= 0xDC00 && low < 0xE000) {
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    } else {
+                        p_ = pair;
+                    }
+                }
+                // Lone surrogates have no UTF-8 form.
+                appendUtf8(out, codePoint >= 0xD800 && codePoint < 0xE000 ? 0xFFFD : codePoint);
+                break;
+            }
+            default:
+                fail();
+            }
+        }
+        transient = true;
+        return out;
+    }
+
+    // At an opening bracket; stops past the matching close.
+    void skipNested() {
+        int depth = 0;
+        do {
+            if (p_ >= end_) {
+                fail();
+            }
+            const char c = *p_++;
+            if (c == '"') {
+                while (true) {
+                    if (p_ >= end_) {
+                        fail();
+                    }
+                    const char s = *p_++;
+                    if (s == '\\') {
+                        ++p_;
+                    } else if (s == '"') {
+                        break;
+                    }
+                }
+            } else if (c == '{' || c == '[') {
+                ++depth;
+            } else if (c == '}' || c == ']') {
+                --depth;
+            }
+        } while (depth > 0);
+    }
+
+    JsonValue readValue() {
+        skipSpace();
+        if (p_ >= end_) {
+            fail();
+        }
+        JsonValue value;
+        const char* start = p_;
+        switch (*p_) {
+        case '"':
+            value.kind = ValueKind::STRING;
+            value.text = readString(value.transient);
+            return value;
+        case '{':
+        case '[':
+            skipNested();
+            value.kind = ValueKind::NESTED;
+            break;
+        case 't':
+            expectWord("true");
+            value.kind = ValueKind::BOOLEAN;
+            value.boolean = true;
+            break;
+        case 'f':
+            expectWord("false");
+            value.kind = ValueKind::BOOLEAN;
+            break;
+        case 'n':
+            expectWord("null");
+            return value;
+        default:
+            while (p_ < end_ && (isDigit(*p_) || *p_ == '-' || *p_ == '+' || *p_ == '.' || *p_ == 'e' || *p_ == 'E')) {
+                ++p_;
+            }
+            if (p_ == start) {
+                fail();
+            }
+            value.kind = ValueKind::NUMBER;
+            break;
+        }
+        value.text = std::string_view(start, static_cast<size_t>(p_ - start));
+        return value;
+    }
+
+    const char* p_;
+    const char* const end_;
+    const size_t offset_;
+    std::deque<std::string>& scratch_;
+};
+
+// Overwrites the row's value, which starts out missing.
+void setValue(Chunk& chunk, ChunkColumn& column, ColumnKind kind, const JsonValue& value) {
+    if (kind != ColumnKind::STRING) {
+        double number = NAN;
+        if (value.kind == ValueKind::BOOLEAN) {
+            number = value.boolean ? 1 : 0;
+        } else if ((value.kind == ValueKind::NUMBER || value.kind == ValueKind::STRING) &&
+                   !parseNumber(value.text, number)) {
+            number = NAN;
+        }
+        column.numbers.back() = number;
+    } else if (value.kind == ValueKind::NULL_VALUE) {
+        column.codes.back() = kMissingCode;
+    } else if (value.kind == ValueKind::BOOLEAN) {
+        column.codes.back() = intern(chunk, column, value.boolean ? "true" : "false", false);
+    } else {
+        column.codes.back() = intern(chunk, column, value.text, value.transient);
+    }
+}
+
+// Calls line(begin, end) for each non-blank line in [begin, end).
+template <typename Line>
+void forEachLine(const char* data, size_t begin, size_t end, Line&& line) {
+    while (begin < end) {
+        const auto* newline = static_cast<const char*>(std::memchr(data + begin, '\n', end - begin));
+        const size_t stop = newline ? static_cast<size_t>(newline - data) : end;
+        if (!isBlank(std::string_view(data + begin, stop - begin)) && !line(begin, stop)) {
+            return;
+        }
+        begin = stop + 1;
+    }
+}
+
+bool parseNdjson(const char* data,
+                 size_t size,
+                 size_t begin,
+                 const Options& options,
+                 Table& table,
+                 const std::function<bool()>& isCancelled) {
+    std::deque<std::string> scratch;
+
+    // Sample the first lines for keys, in order of appearance, and kinds.
+    std::vector<std::string> names;
+    std::unordered_map<std::string, size_t> sampled;
+    std::vector<uint8_t> seen;
+    std::vector<uint8_t> numeric;
+    size_t records = 0;
+    forEachLine(data, begin, size, [&](size_t start, size_t stop) {
+        if (records++ == options.inferRows) {
+            return false;
+        }
+        scratch.clear();
+        LineScanner(data, start, stop, scratch).scan([&](std::string_view key, const JsonValue& value) {
+            const auto inserted = sampled.emplace(std::string(key), names.size());
+            if (inserted.second) {
+                names.emplace_back(key);
+                seen.push_back(0);
+                numeric.push_back(1);
+            }
+            const size_t index = inserted.first->second;
+            if (value.kind != ValueKind::NULL_VALUE) {
+                seen[index] = 1;
+                double number = 0;
+                const bool isNumber = value.kind == ValueKind::BOOLEAN ||
+                    (value.kind == ValueKind::NUMBER && parseNumber(value.text, number));
+                numeric[index] = numeric[index] && isNumber;
+            }
+        });
+        return true;
+    });
+
+    Schema schema;
+    if (options.select.empty()) {
+        schema.names = names;
+        for (const auto& typed : options.types) {
+            if (sampled.count(typed.first) == 0) {
+                schema.names.push_back(typed.first);
+            }
+        }
+    } else {
+        schema.names = options.select;
+    }
+    std::unordered_map<std::string_view, size_t> columnIndex;
+    for (size_t c = 0; c < schema.names.size(); ++c) {
+        const auto found = sampled.find(schema.names[c]);
+        const bool known = found != sampled.end();
+        schema.kinds.push_back(kindOf(
+            options, schema.names[c], known && seen[found->second] != 0, known && numeric[found->second] != 0));
+        columnIndex.emplace(schema.names[c], c);
+    }
+
+    // JSON strings cannot hold a raw newline, so every newline ends a record.
+    auto chunks = splitChunks(begin, size, [data, size](size_t, size_t offset) {
+        const auto* newline = static_cast<const char*>(std::memchr(data + offset, '\n', size - offset));
+        return newline ? static_cast<size_t>(newline - data) + 1 : size;
+    });
+    const bool parsed = parallelFor(
+        chunks.size(),
+        1,
+        [&](size_t first, size_t last) {
+            std::deque<std::string> lineScratch;
+            for (size_t i = first; i < last; ++i) {
+                auto& chunk = chunks[i];
+                chunk.columns.resize(schema.names.size());
+                forEachLine(data, chunk.begin, chunk.end, [&](size_t start, size_t stop) {
+                    for (size_t c = 0; c < schema.names.size(); ++c) {
+                        appendMissing(chunk.columns[c], schema.kinds[c]);
+                    }
+                    lineScratch.clear();
+                    LineScanner(data, start, stop, lineScratch)
+                        .scan([&](std::string_view key, const JsonValue& value) {
+                            const auto found = columnIndex.find(key);
+                            if (found != columnIndex.end()) {
+                                setValue(chunk, chunk.columns[found->second], schema.kinds[found->second], value);
+                            }
+                        });
+                    ++chunk.rows;
+                    return true;
+                });
+            }
+        },
+        isCancelled);
+    if (!parsed) {
+        return false;
+    }
+    return assemble(chunks, schema, table, isCancelled);
+}
+
+} // namespace
+
+bool parseFormat(const std::string& name, Format& format) {
+    if (name == "csv") {
+        format = Format::CSV;
+    } else if (name == "ndjson" || name == "jsonl") {
+        format = Format::NDJSON;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parseColumnKind(const std::string& name, ColumnKind& kind) {
+    static const std::pair<const char*, ColumnKind> kKinds[] = {
+        {"float64", ColumnKind::FLOAT64},
+        {"float32", ColumnKind::FLOAT32},
+        {"int32", ColumnKind::INT32},
+        {"string", ColumnKind::STRING},
+    };
+    for (const auto& [kindName, value] : kKinds) {
+        if (name == kindName) {
+            kind = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* columnKindName(ColumnKind kind) {
+    switch (kind) {
+    case ColumnKind::FLOAT64:
+        return "float64";
+    case ColumnKind::FLOAT32:
+        return "float32";
+    case ColumnKind::INT32:
+        return "int32";
+    case ColumnKind::STRING:
+        return "string";
+    }
+    return "float64";
+}
+
+bool parse(const uint8_t* data,
+           size_t size,
+           const Options& options,
+           Table& table,
+           const std::function<bool()>& isCancelled) {
+    const auto* text = reinterpret_cast<const char*>(data);
+    // A UTF-8 byte order mark is not part of the first field or key.
+    const size_t begin = size >= 3 && std::memcmp(text, "\xEF\xBB\xBF", 3) == 0 ? 3 : 0;
+    if (options.format == Format::CSV) {
+        return parseCsv(text, size, begin, options, table, isCancelled);
+    }
+    return parseNdjson(text, size, begin, options, table, isCancelled);
+}
+
+bool parseFile(const std::string& path,
+               const Options& options,
+               Table& table,
+               const std::function<bool()>& isCancelled) {
+    const auto file = files::MappedFile::open(path);
+    return parse(file->data(), file->size(), options, table, isCancelled);
+}
+
+} // namespace threadforge::ingest
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace threadforge::ingest {
+
+enum class Format : uint8_t {
+    // RFC 4180: quoted fields may hold delimiters, newlines and "" for a quote.
+    CSV,
+    // One JSON object per line (NDJSON / JSON Lines).
+    NDJSON
+};
+
+// "csv", or "ndjson" / "jsonl". False for anything else.
+bool parseFormat(const std::string& name, Format& format);
+
+enum class ColumnKind : uint8_t {
+    FLOAT64,
+    FLOAT32,
+    INT32,
+    // Dictionary-encoded: uint32 codes into the column's dictionary.
+    STRING
+};
+
+// "float64", "float32", "int32" or "string". False for anything else.
+bool parseColumnKind(const std::string& name, ColumnKind& kind);
+const char* columnKindName(ColumnKind kind);
+
+// The code of a missing string: an NDJSON null or absent key, or a field past
+// the end of a short CSV record. It is never a dictionary index.
+constexpr uint32_t kMissingCode = UINT32_MAX;
+
+struct Options {
+    Format format{Format::CSV};
+    // CSV only.
+    char delimiter{','};
+    // CSV only: whether the first record names the columns. Without it the
+    // columns are named "0", "1", ...
+    bool header{true};
+    // Only these columns, in this order; every column when empty.
+    std::vector<std::string> select;
+    // Column kinds by name. The rest are inferred from the first inferRows
+    // records: FLOAT64 when every non-empty value is a number (or an NDJSON
+    // boolean), STRING otherwise.
+    std::vector<std::pair<std::string, ColumnKind>> types;
+    size_t inferRows{1000};
+};
+
+struct Column {
+    std::string name;
+    ColumnKind kind{ColumnKind::FLOAT64};
+    // rows elements of the kind's type (double, float, int32_t or uint32_t
+    // codes), in native byte order.
+    std::vector<uint8_t> data;
+    // STRING columns: distinct values in order of first appearance.
+    std::vector<std::string> dictionary;
+};
+
+struct Table {
+    size_t rows{0};
+    std::vector<Column> columns;
+};
+
+// Parses data into typed columns. Missing values and values that do not fit
+// their column become NaN (FLOAT64, FLOAT32) or 0 (INT32); INT32 truncates
+// fractions. Empty CSV fields are "" in STRING columns. NDJSON nested objects
+// and arrays are kept as their JSON text.
+//
+// The input is split into chunks at record boundaries (found by counting
+// quotes for CSV), the chunks are parsed in parallel on the shared pool, and
+// their columns are concatenated in order, with dictionaries merged so codes
+// follow first appearance in the whole input.
+//
+// Throws std::invalid_argument for malformed input (an unterminated quoted
+// field, a line that is not a JSON object) or options. Returns false, leaving
+// table untouched, when isCancelled fires first.
+bool parse(const uint8_t* data,
+           size_t size,
+           const Options& options,
+           Table& table,
+           const std::function<bool()>& isCancelled = nullptr);
+
+// parse() over the file at path, which is mapped rather than read.
+bool parseFile(const std::string& path,
+               const Options& options,
+               Table& table,
+               const std::function<bool()>& isCancelled = nullptr);
+
+} // namespace threadforge::ingest
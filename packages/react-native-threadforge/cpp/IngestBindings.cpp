@@ -0,0 +1,247 @@
+#include "IngestBindings.h"
+
+#include <jsi/jsi.h>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BindingHelpers.h"
+#include "Files.h"
+#include "KernelRegistry.h"
+#include "PackedTable.h"
+#include "ThreadPool.h"
+#include "TypedArrayView.h"
+#include "nlohmann/json.hpp"
+
+namespace threadforge {
+
+namespace {
+
+using facebook::jsi::Array;
+using facebook::jsi::ArrayBuffer;
+using facebook::jsi::JSError;
+using facebook::jsi::MutableBuffer;
+using facebook::jsi::Object;
+using facebook::jsi::Runtime;
+using facebook::jsi::String;
+using facebook::jsi::Value;
+
+class ColumnBuffer : public MutableBuffer {
+public:
+    explicit ColumnBuffer(std::vector<uint8_t> bytes)
+        : bytes_(std::move(bytes)) {}
+
+    size_t size() const override {
+        return bytes_.size();
+    }
+    uint8_t* data() override {
+        return bytes_.data();
+    }
+
+private:
+    std::vector<uint8_t> bytes_;
+};
+
+const char* typedArrayType(ingest::ColumnKind kind) {
+    switch (kind) {
+    case ingest::ColumnKind::FLOAT64:
+        return "Float64Array";
+    case ingest::ColumnKind::FLOAT32:
+        return "Float32Array";
+    case ingest::ColumnKind::INT32:
+        return "Int32Array";
+    case ingest::ColumnKind::STRING:
+        return "Uint32Array";
+    }
+    return "Float64Array";
+}
+
+// The options object, JSON-encoded so JSI and runKernel share one parser.
+// Keys other than the options are ignored.
+ingest::Options readOptions(const nlohmann::json& spec, ingest::Format format) {
+    ingest::Options options;
+    options.format = format;
+    if (spec.is_null()) {
+        return options;
+    }
+    if (!spec.is_object()) {
+        throw std::invalid_argument("options must be an object");
+    }
+    if (spec.contains("delimiter")) {
+        const auto& delimiter = spec["delimiter"];
+        if (!delimiter.is_string() || delimiter.get_ref<const std::string&>().size() != 1 ||
+            static_cast<unsigned char>(delimiter.get_ref<const std::string&>()[0]) >= 0x80) {
+            throw std::invalid_argument("delimiter must be a single ASCII character");
+        }
+        options.delimiter = delimiter.get_ref<const std::string&>()[0];
+    }
+    if (spec.contains("header")) {
+        if (!spec["header"].is_boolean()) {
+            throw std::invalid_argument("header must be a boolean");
+        }
+        options.header = spec["header"].get<bool>();
+    }
+    if (spec.contains("columns")) {
+        const auto& columns = spec["columns"];
+        if (!columns.is_array()) {
+            throw std::invalid_argument("columns must be an array of column names");
+        }
+        for (const auto& name : columns) {
+            if (!name.is_string()) {
+                throw std::invalid_argument("columns must be an array of column names");
+            }
+            options.select.push_back(name.get<std::string>());
+        }
+    }
+    if (spec.contains("types")) {
+        const auto& types = spec["types"];
+        if (!types.is_object()) {
+            throw std::invalid_argument("types must map column names to 'float64', 'float32', 'int32' or 'string'");
+        }
+        for (const auto& item : types.items()) {
+            ingest::ColumnKind kind;
+            if (!item.value().is_string() || !ingest::parseColumnKind(item.value().get<std::string>(), kind)) {
+                throw std::invalid_argument("type of column '" + item.key() +
+                                            "' must be 'float64', 'float32', 'int32' or 'string'");
+            }
+            options.types.emplace_back(item.key(), kind);
+        }
+    }
+    if (spec.contains("inferRows")) {
+        if (!spec["inferRows"].is_number_unsigned()) {
+            throw std::invalid_argument("inferRows must be a non-negative integer");
+        }
+        options.inferRows = spec["inferRows"].get<size_t>();
+    }
+    return options;
+}
+
+// Codes in the narrowest unsigned type that leaves its all-ones value free
+// for missing strings, as in packed tables made by nativeColumns.table().
+template <typename Code>
+std::string packCodes(const ingest::Column& column, size_t rows) {
+    const auto* codes = reinterpret_cast<const uint32_t*>(column.data.data());
+    std::vector<Code> narrow(rows);
+    for (size_t r = 0; r < rows; ++r) {
+        narrow[r] = codes[r] == ingest::kMissingCode ? std::numeric_limits<Code>::max() : static_cast<Code>(codes[r]);
+    }
+    return encodeBase64(reinterpret_cast<const uint8_t*>(narrow.data()), narrow.size() * sizeof(Code));
+}
+
+TaskResult runIngestKernel(const std::string& argsJson,
+                           const ProgressCallback&,
+                           const std::function<bool()>& isCancelled) {
+    const auto args = nlohmann::json::parse(argsJson, nullptr, false);
+    ingest::Format format;
+    if (!args.is_object() || !args.contains("path") || !args["path"].is_string() || !args.contains("format") ||
+        !args["format"].is_string() || !ingest::parseFormat(args["format"].get<std::string>(), format)) {
+        return makeErrorResult("columns.ingest expects { path, format: 'csv' | 'ndjson', delimiter?, header?, "
+                               "columns?, types?, inferRows? }");
+    }
+    ingest::Table table;
+    try {
+        const auto options = readOptions(args, format);
+        if (!ingest::parseFile(files::resolvePath(args["path"].get<std::string>()), options, table, isCancelled)) {
+            return makeCancelledResult();
+        }
+    } catch (const std::exception& ex) {
+        return makeErrorResult(std::string("columns.ingest: ") + ex.what());
+    }
+
+    nlohmann::json result;
+    result[kPackedTableKey] = kPackedTableVersion;
+    result["length"] = table.rows;
+    auto& columns = result["columns"] = nlohmann::json::array();
+    for (const auto& column : table.columns) {
+        nlohmann::json packed;
+        packed["name"] = column.name;
+        if (column.kind != ingest::ColumnKind::STRING) {
+            packed["type"] = typedArrayType(column.kind);
+            packed["data"] = encodeBase64(column.data.data(), column.data.size());
+        } else if (column.dictionary.size() <= UINT8_MAX) {
+            packed["type"] = "Uint8Array";
+            packed["data"] = packCodes<uint8_t>(column, table.rows);
+        } else if (column.dictionary.size() <= UINT16_MAX) {
+            packed["type"] = "Uint16Array";
+            packed["data"] = packCodes<uint16_t>(column, table.rows);
+        } else {
+            packed["type"] = "Uint32Array";
+            packed["data"] = packCodes<uint32_t>(column, table.rows);
+        }
+        if (column.kind == ingest::ColumnKind::STRING) {
+            packed["dictionary"] = column.dictionary;
+        }
+        columns.push_back(std::move(packed));
+    }
+    // Input text need not be valid UTF-8; bad bytes become U+FFFD.
+    return makeSuccessResult(result.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace));
+}
+
+THREADFORGE_REGISTER_KERNEL("columns.ingest", runIngestKernel);
+
+} // namespace
+
+Value ingestTable(Runtime& rt, ingest::Format format, const Value& source, const Value& optionsValue) {
+    const std::string method = format == ingest::Format::CSV ? "nativeColumns.readCsv" : "nativeColumns.readNdjson";
+    nlohmann::json spec;
+    if (optionsValue.isObject()) {
+        auto stringify = rt.global().getPropertyAsObject(rt, "JSON").getPropertyAsFunction(rt, "stringify");
+        spec = nlohmann::json::parse(stringify.call(rt, optionsValue).getString(rt).utf8(rt), nullptr, false);
+    } else if (!optionsValue.isUndefined()) {
+        throw JSError(rt, method + " expects an options object");
+    }
+    const auto options = readOptions(spec, format);
+
+    const auto task = ThreadPool::currentTask();
+    const auto cancelled = [task] {
+        return task && task->cancelled.load();
+    };
+    ingest::Table table;
+    bool completed = false;
+    try {
+        if (source.isString()) {
+            completed = ingest::parseFile(files::resolvePath(source.getString(rt).utf8(rt)), options, table, cancelled);
+        } else if (const auto view = typedArrayView(rt, source); view.valid()) {
+            const size_t size = view.length * typedArrayElementSize(view.type);
+            completed = ingest::parse(view.data, size, options, table, cancelled);
+        } else if (source.isObject() && source.getObject(rt).isArrayBuffer(rt)) {
+            const auto buffer = source.getObject(rt).getArrayBuffer(rt);
+            completed = ingest::parse(buffer.data(rt), buffer.size(rt), options, table, cancelled);
+        } else {
+            throw JSError(rt, method + " expects a path, typed array or ArrayBuffer");
+        }
+    } catch (const files::Error& ex) {
+        throw JSError(rt, ex.what());
+    }
+    if (!completed) {
+        throw JSError(rt, method + ": the task was cancelled");
+    }
+
+    auto global = rt.global();
+    Object columns(rt);
+    for (auto& column : table.columns) {
+        ArrayBuffer buffer(rt, std::make_shared<ColumnBuffer>(std::move(column.data)));
+        auto values = global.getPropertyAsFunction(rt, typedArrayType(column.kind)).callAsConstructor(rt, buffer);
+        if (column.kind != ingest::ColumnKind::STRING) {
+            columns.setProperty(rt, column.name.c_str(), values);
+            continue;
+        }
+        Array dictionary(rt, column.dictionary.size());
+        for (size_t d = 0; d < column.dictionary.size(); ++d) {
+            dictionary.setValueAtIndex(rt, d, String::createFromUtf8(rt, column.dictionary[d]));
+        }
+        Object encoded(rt);
+        encoded.setProperty(rt, "codes", values);
+        encoded.setProperty(rt, "dictionary", dictionary);
+        columns.setProperty(rt, column.name.c_str(), encoded);
+    }
+    Object result(rt);
+    result.setProperty(rt, "rows", static_cast<double>(table.rows));
+    result.setProperty(rt, "columns", columns);
+    return Value(std::move(result));
+}
+
+} // namespace threadforge
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Ingest.h"
+
+namespace facebook::jsi {
+class Runtime;
+class Value;
+} // namespace facebook::jsi
+
+namespace threadforge {
+
+// Worker side: parses CSV or NDJSON (Ingest.h) from a file path or the bytes
+// of a typed array / ArrayBuffer straight into columns:
+//
+//     { rows, columns: { name: Float64Array | Float32Array | Int32Array | { codes: Uint32Array, dictionary } } }
+//
+// which nativeColumns.aggregate() and table() take as they are. options is
+// { delimiter?, header?, columns?: names, types?: { name: 'float64' | 'float32'
+// | 'int32' | 'string' }, inferRows? }. Missing strings have code 0xFFFFFFFF.
+// Exposed to workers as nativeColumns.readCsv() and readNdjson().
+//
+// The same parse runs as the "columns.ingest" kernel for runKernel(), with
+// { path, format: 'csv' | 'ndjson', ...options }, and returns a packed table
+// (PackedTable.h).
+facebook::jsi::Value ingestTable(facebook::jsi::Runtime& runtime,
+                                 ingest::Format format,
+                                 const facebook::jsi::Value& source,
+                                 const facebook::jsi::Value& options);
+
+} // namespace threadforge
@@ -0,0 +1,129 @@
+#include "KernelRegistry.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace threadforge {
+
+namespace {
+
+struct Registry {
+    std::mutex mutex;
+    std::unordered_map<std::string, Kernel> kernels;
+};
+
+// Function-local so registrations from other translation units' static
+// initializers never see an unconstructed map.
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+Kernel findKernel(const std::string& name) {
+    auto& state = registry();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    const auto it = state.kernels.find(name);
+    return it == state.kernels.end() ? Kernel() : it->second;
+}
+
+// Same safe points the JS executor offers through reportProgress()/shouldCancel().
+void runCheckpoint() {
+    ThreadPool::takeTrimRequest();
+    ThreadPool::throttleCurrentTask();
+    ThreadPool::waitForIdleWindow();
+}
+
+} // namespace
+
+bool registerKernel(const std::string& name, Kernel kernel) {
+    if (name.empty() || !kernel) {
+        return false;
+    }
+    auto& state = registry();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.kernels.emplace(name, std::move(kernel)).second;
+}
+
+bool unregisterKernel(const std::string& name) {
+    auto& state = registry();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.kernels.erase(name) > 0;
+}
+
+bool hasKernel(const std::string& name) {
+    auto& state = registry();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.kernels.count(name) > 0;
+}
+
+std::vector<std::string> registeredKernelNames() {
+    auto& state = registry();
+    std::vector<std::string> names;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        names.reserve(state.kernels.size());
+        for (const auto& item : state.kernels) {
+            names.push_back(item.first);
+        }
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+TaskFunction makeKernelWork(const std::string& name,
+                            const std::string& argsJson,
+                            std::chrono::milliseconds progressThrottle) {
+    return [name, argsJson, progressThrottle](const ProgressCallback& progressCallback,
+                                              const std::function<bool()>& isCancelled) {
+        if (isCancelled && isCancelled()) {
+            return makeCancelledResult();
+        }
+        const auto kernel = findKernel(name);
+        if (!kernel) {
+            return makeErrorResult("Unknown ThreadForge kernel: " + name);
+        }
+
+        auto lastEmission = std::chrono::steady_clock::now() - progressThrottle;
+        const ProgressCallback progress = [&](double value) {
+            runCheckpoint();
+            if (!progressCallback) {
+                return;
+            }
+            const auto now = std::chrono::steady_clock::now();
+            if (progressThrottle.count() == 0 || now - lastEmission >= progressThrottle) {
+                lastEmission = now;
+                progressCallback(std::clamp(value, 0.0, 1.0));
+            }
+        };
+        const std::function<bool()> cancelled = [&]() {
+            runCheckpoint();
+            return isCancelled && isCancelled();
+        };
+
+        try {
+            auto result = kernel(argsJson, progress, cancelled);
+            if (!result.success) {
+                return result;
+            }
+            if (progressCallback) {
+                progressCallback(1.0);
+            }
+            if (isCancelled && isCancelled()) {
+                // Finished after being cancelled: report the value as the partial result.
+                auto cancelledResult = makeCancelledResult();
+                cancelledResult.valueJson = result.valueJson;
+                ThreadPool::setPartialResult(result.valueJson);
+                return cancelledResult;
+            }
+            return result;
+        } catch (const std::exception& ex) {
+            return makeErrorResult(ex.what());
+        } catch (...) {
+            return makeErrorResult("Unknown error in ThreadForge kernel " + name);
+        }
+    };
+}
+
+} // namespace threadforge
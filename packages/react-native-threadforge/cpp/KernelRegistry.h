@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "TaskResult.h"
+#include "ThreadPool.h"
+
+namespace threadforge {
+
+// A named native computation that runs on the pool without a Hermes runtime.
+// Arguments arrive as the JSON text passed to runKernel() and the result goes
+// back through the same TaskResult path as runFunction(). Long kernels should
+// call progress or isCancelled regularly: both are checkpoints at which the
+// pool applies CPU quotas, idle windows and cancellation. Cancelled tasks settle
+// immediately, so kernels publish intermediate values through
+// ThreadPool::setPartialResult() for the caller to receive.
+using Kernel = std::function<TaskResult(const std::string& argsJson,
+                                        const ProgressCallback& progress,
+                                        const std::function<bool()>& isCancelled)>;
+
+// Registers kernel under name. Returns false (and keeps the existing kernel)
+// when the name is already taken or the kernel is empty. Safe to call from any
+// thread, including static initializers.
+bool registerKernel(const std::string& name, Kernel kernel);
+bool unregisterKernel(const std::string& name);
+bool hasKernel(const std::string& name);
+std::vector<std::string> registeredKernelNames();
+
+// Wraps a kernel call as pool work. The kernel is looked up when the task
+// starts, so an unknown name settles the task with an error instead of
+// throwing at submission. Progress is throttled like runSerializedFunction().
+TaskFunction makeKernelWork(const std::string& name,
+                            const std::string& argsJson,
+                            std::chrono::milliseconds progressThrottle);
+
+} // namespace threadforge
+
+#define THREADFORGE_KERNEL_CONCAT_INNER(a, b) a##b
+#define THREADFORGE_KERNEL_CONCAT(a, b) THREADFORGE_KERNEL_CONCAT_INNER(a, b)
+
+// Registers a kernel at load time from any translation unit linked into the app:
+//
+//     THREADFORGE_REGISTER_KERNEL("image.blur", [](const std::string& args,
+//                                                  const threadforge::ProgressCallback& progress,
+//                                                  const std::function<bool()>& isCancelled) {
+//         ...
+//         return threadforge::makeSuccessResult(json);
+//     });
+//
+// Objects in static libraries are only linked when something references them,
+// so kernels shipped in a static library should call registerKernel() from an
+// explicit init function instead.
+#define THREADFORGE_REGISTER_KERNEL(name, kernel)                               \
+    static const bool THREADFORGE_KERNEL_CONCAT(threadforgeKernelRegistered_, __COUNTER__) = \
+        ::threadforge::registerKernel((name), (kernel))
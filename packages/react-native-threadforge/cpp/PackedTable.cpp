@@ -0,0 +1,66 @@
+#include "PackedTable.h"
+
+#include <cstdint>
+#include <utility>
+
+#include "Encoding.h"
+
+namespace threadforge {
+
+namespace {
+
+size_t paddingOf(const char* text, size_t length) {
+    if (length == 0 || text[length - 1] != '=') {
+        return 0;
+    }
+    return text[length - 2] == '=' ? 2 : 1;
+}
+
+} // namespace
+
+std::string encodeBase64(const uint8_t* data, size_t size) {
+    std::string text(encoding::base64EncodedLength(size, true), '=');
+    encoding::encodeBase64(data, size, text.data());
+    return text;
+}
+
+size_t base64DecodedSize(const char* text, size_t length) {
+    if (length % 4 != 0) {
+        return SIZE_MAX;
+    }
+    const size_t padding = paddingOf(text, length);
+    for (size_t i = 0; i + padding < length; ++i) {
+        if (text[i] == '=') {
+            return SIZE_MAX;
+        }
+    }
+    return length / 4 * 3 - padding;
+}
+
+bool decodeBase64(const char* text, size_t length, uint8_t* out) {
+    // After base64DecodedSize() the only failure left is a character outside
+    // the alphabet, and the decoder writes no more than that size.
+    return encoding::decodeBase64(text, length, out) != SIZE_MAX;
+}
+
+size_t typedArrayElementSize(const std::string& type) {
+    static const std::pair<const char*, size_t> kSizes[] = {
+        {"Float64Array", 8},
+        {"Float32Array", 4},
+        {"Int32Array", 4},
+        {"Uint32Array", 4},
+        {"Int16Array", 2},
+        {"Uint16Array", 2},
+        {"Int8Array", 1},
+        {"Uint8Array", 1},
+        {"Uint8ClampedArray", 1},
+    };
+    for (const auto& [name, size] : kSizes) {
+        if (type == name) {
+            return size;
+        }
+    }
+    return 0;
+}
+
+} // namespace threadforge
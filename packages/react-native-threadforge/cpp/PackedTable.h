@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace threadforge {
+
+// Tables cross from a worker to the app runtime inside the task's JSON result
+// as column buffers rather than one object per row:
+//
+//     { "__threadforgeTable": 1, "length": rows,
+//       "columns": [{ "name", "type": "Float64Array", "data": base64, "dictionary"?: [strings] }] }
+//
+// data holds the column's typed-array bytes in base64. They are in native
+// byte order, which is little-endian on every platform React Native supports.
+// Dictionary columns carry integer codes into their dictionary.
+constexpr const char* kPackedTableKey = "__threadforgeTable";
+constexpr int kPackedTableVersion = 1;
+
+std::string encodeBase64(const uint8_t* data, size_t size);
+
+// Number of bytes text decodes to, or SIZE_MAX if its length is not a
+// multiple of 4 or it has misplaced padding.
+size_t base64DecodedSize(const char* text, size_t length);
+
+// Writes base64DecodedSize() bytes to out; text must have passed that check.
+// Returns false on characters outside the base64 alphabet, leaving out
+// partially written.
+bool decodeBase64(const char* text, size_t length, uint8_t* out);
+
+// Bytes per element for a typed array constructor name ("Uint16Array" -> 2),
+// 0 for anything else.
+size_t typedArrayElementSize(const std::string& type);
+
+} // namespace threadforge
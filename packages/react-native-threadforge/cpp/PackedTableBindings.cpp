@@ -0,0 +1,189 @@
+#include "PackedTableBindings.h"
+
+#include <cmath>
+#include <cstdint>
+#include <jsi/jsi.h>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BindingHelpers.h"
+#include "PackedTable.h"
+#include "TypedArrayView.h"
+
+namespace threadforge {
+
+namespace {
+
+using facebook::jsi::Array;
+using facebook::jsi::JSError;
+using facebook::jsi::Object;
+using facebook::jsi::Runtime;
+using facebook::jsi::String;
+using facebook::jsi::Value;
+
+struct PackedColumn {
+    std::string type;
+    std::string data;
+    size_t length{0};
+    Value dictionary;
+};
+
+PackedColumn packTypedArray(const TypedArrayView& view, const std::string& name) {
+    const size_t elementSize = typedArrayElementSize(view.type);
+    if (elementSize == 0) {
+        throw std::invalid_argument("column '" + name + "' has unsupported type " + view.type);
+    }
+    PackedColumn packed;
+    packed.type = view.type;
+    packed.data = encodeBase64(view.data, view.length * elementSize);
+    packed.length = view.length;
+    return packed;
+}
+
+template <typename Code>
+std::string encodeCodes(const std::vector<uint32_t>& codes) {
+    std::vector<Code> narrow(codes.begin(), codes.end());
+    return encodeBase64(reinterpret_cast<const uint8_t*>(narrow.data()), narrow.size() * sizeof(Code));
+}
+
+PackedColumn packStrings(Runtime& rt, const Array& strings) {
+    const size_t length = strings.size(rt);
+    std::unordered_map<std::string, uint32_t> lookup;
+    std::vector<const std::string*> order;
+    std::vector<uint32_t> codes(length);
+    for (size_t i = 0; i < length; ++i) {
+        const auto inserted = lookup.emplace(
+            strings.getValueAtIndex(rt, i).toString(rt).utf8(rt), static_cast<uint32_t>(lookup.size()));
+        if (inserted.second) {
+            order.push_back(&inserted.first->first);
+        }
+        codes[i] = inserted.first->second;
+    }
+
+    PackedColumn packed;
+    packed.length = length;
+    if (order.size() <= UINT8_MAX + 1) {
+        packed.type = "Uint8Array";
+        packed.data = encodeCodes<uint8_t>(codes);
+    } else if (order.size() <= UINT16_MAX + 1) {
+        packed.type = "Uint16Array";
+        packed.data = encodeCodes<uint16_t>(codes);
+    } else {
+        packed.type = "Uint32Array";
+        packed.data = encodeCodes<uint32_t>(codes);
+    }
+    Array dictionary(rt, order.size());
+    for (size_t d = 0; d < order.size(); ++d) {
+        dictionary.setValueAtIndex(rt, d, String::createFromUtf8(rt, *order[d]));
+    }
+    packed.dictionary = Value(std::move(dictionary));
+    return packed;
+}
+
+PackedColumn packNumbers(Runtime& rt, const Array& numbers) {
+    const size_t length = numbers.size(rt);
+    std::vector<double> values(length);
+    for (size_t i = 0; i < length; ++i) {
+        const auto value = numbers.getValueAtIndex(rt, i);
+        values[i] = value.isNumber() ? value.getNumber() : NAN;
+    }
+    PackedColumn packed;
+    packed.type = "Float64Array";
+    packed.data = encodeBase64(reinterpret_cast<const uint8_t*>(values.data()), length * sizeof(double));
+    packed.length = length;
+    return packed;
+}
+
+PackedColumn packColumn(Runtime& rt, const Value& value, const std::string& name) {
+    const auto view = typedArrayView(rt, value);
+    if (view.valid()) {
+        return packTypedArray(view, name);
+    }
+    if (!value.isObject()) {
+        throw std::invalid_argument("column '" + name + "' must be a typed array, an array or { codes, dictionary }");
+    }
+    const auto object = value.getObject(rt);
+    if (object.isArray(rt)) {
+        const auto array = object.getArray(rt);
+        if (array.size(rt) > 0 && array.getValueAtIndex(rt, 0).isString()) {
+            return packStrings(rt, array);
+        }
+        return packNumbers(rt, array);
+    }
+    // { codes, dictionary }
+    const auto codes = typedArrayView(rt, object.getProperty(rt, "codes"));
+    auto dictionary = object.getProperty(rt, "dictionary");
+    if (!codes.valid() || !dictionary.isObject() || !dictionary.getObject(rt).isArray(rt)) {
+        throw std::invalid_argument("column '" + name + "' must be a typed array, an array or { codes, dictionary }");
+    }
+    auto packed = packTypedArray(codes, name);
+    packed.dictionary = std::move(dictionary);
+    return packed;
+}
+
+} // namespace
+
+Value packTable(Runtime& rt, const Value& columnsValue) {
+    if (!columnsValue.isObject()) {
+        throw JSError(rt, "nativeColumns.table expects { name: column }");
+    }
+    const auto columns = columnsValue.getObject(rt);
+    const auto names = columns.getPropertyNames(rt);
+    const size_t count = names.size(rt);
+    Array packedColumns(rt, count);
+    size_t rows = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const auto name = names.getValueAtIndex(rt, i).getString(rt).utf8(rt);
+        const auto item = columns.getProperty(rt, name.c_str());
+        auto packed = packColumn(rt, item, name);
+        if (i == 0) {
+            rows = packed.length;
+        } else if (packed.length != rows) {
+            throw std::invalid_argument("column '" + name + "' has " + std::to_string(packed.length) +
+                                        " rows, expected " + std::to_string(rows));
+        }
+
+        Object column(rt);
+        column.setProperty(rt, "name", String::createFromUtf8(rt, name));
+        column.setProperty(rt, "type", String::createFromAscii(rt, packed.type));
+        column.setProperty(rt, "data", String::createFromAscii(rt, packed.data));
+        if (!packed.dictionary.isUndefined()) {
+            column.setProperty(rt, "dictionary", packed.dictionary);
+        }
+        packedColumns.setValueAtIndex(rt, i, std::move(column));
+    }
+
+    Object table(rt);
+    table.setProperty(rt, kPackedTableKey, kPackedTableVersion);
+    table.setProperty(rt, "length", static_cast<double>(rows));
+    table.setProperty(rt, "columns", packedColumns);
+    return Value(std::move(table));
+}
+
+void installPackedTableDecoder(Runtime& rt) {
+    auto global = rt.global();
+    setFunction(rt, global, "__threadforgeDecodeColumn", 2, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto& data = argumentAt(args, count, 0);
+        const auto& type = argumentAt(args, count, 1);
+        if (!data.isString() || !type.isString()) {
+            throw JSError(runtime, "__threadforgeDecodeColumn expects (data, type) strings");
+        }
+        const auto typeName = type.getString(runtime).utf8(runtime);
+        const size_t elementSize = typedArrayElementSize(typeName);
+        const auto text = data.getString(runtime).utf8(runtime);
+        const size_t size = base64DecodedSize(text.data(), text.size());
+        if (elementSize == 0 || size == SIZE_MAX || size % elementSize != 0) {
+            throw JSError(runtime, "malformed packed column of type " + typeName);
+        }
+        TypedArrayView view;
+        auto array = makeTypedArray(runtime, typeName.c_str(), size / elementSize, view);
+        if (!decodeBase64(text.data(), text.size(), view.data)) {
+            throw JSError(runtime, "malformed packed column of type " + typeName);
+        }
+        return array;
+    });
+}
+
+} // namespace threadforge
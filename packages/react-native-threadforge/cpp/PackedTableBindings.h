@@ -0,0 +1,22 @@
+#pragma once
+
+namespace facebook::jsi {
+class Runtime;
+class Value;
+} // namespace facebook::jsi
+
+namespace threadforge {
+
+// Worker side: packs { name: column } into the format described in
+// PackedTable.h. A column is a typed array, { codes, dictionary }, an array of
+// strings (dictionary-encoded into the narrowest unsigned codes) or an array of
+// numbers (stored as Float64Array). All columns must have the same length.
+// Exposed to workers as nativeColumns.table().
+facebook::jsi::Value packTable(facebook::jsi::Runtime& runtime, const facebook::jsi::Value& columns);
+
+// App side: installs the global `__threadforgeDecodeColumn(data, type)`, which
+// decodes one packed column straight into a new typed array. The package's JS
+// reader uses it when present and decodes in JS otherwise.
+void installPackedTableDecoder(facebook::jsi::Runtime& runtime);
+
+} // namespace threadforge
@@ -0,0 +1,111 @@
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "SharedPool.h"
+
+namespace threadforge {
+
+namespace {
+
+struct ParallelState {
+    size_t count = 0;
+    size_t grain = 1;
+    size_t chunks = 0;
+    // Only dereferenced after a successful claim, and the caller does not return
+    // before every claimed chunk has finished, so the pointer stays valid.
+    const std::function<void(size_t, size_t)>* body = nullptr;
+    std::atomic<size_t> next{0};
+    std::atomic<bool> stopped{false};
+    std::mutex mutex;
+    std::condition_variable finishedCv;
+    size_t finished = 0;
+    std::exception_ptr error;
+};
+
+std::string nextHelperId() {
+    static std::atomic<uint64_t> counter{0};
+    return "threadforge.parallel:" + std::to_string(counter.fetch_add(1));
+}
+
+// Claims chunks until none are left. Once stopped, claimed chunks are counted
+// as finished without running so the caller's wait still completes.
+void drainChunks(ParallelState& state, const std::function<bool()>& isCancelled) {
+    while (true) {
+        if (isCancelled && !state.stopped.load() && isCancelled()) {
+            state.stopped = true;
+        }
+        const size_t chunk = state.next.fetch_add(1);
+        if (chunk >= state.chunks) {
+            return;
+        }
+        if (!state.stopped.load()) {
+            const size_t begin = chunk * state.grain;
+            const size_t end = std::min(state.count, begin + state.grain);
+            try {
+                (*state.body)(begin, end);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                if (!state.error) {
+                    state.error = std::current_exception();
+                }
+                state.stopped = true;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.finished++;
+        }
+        state.finishedCv.notify_all();
+    }
+}
+
+} // namespace
+
+bool parallelFor(size_t count,
+                 size_t grain,
+                 const std::function<void(size_t begin, size_t end)>& body,
+                 const std::function<bool()>& isCancelled) {
+    if (count == 0 || !body) {
+        return !(isCancelled && isCancelled());
+    }
+    auto state = std::make_shared<ParallelState>();
+    state->count = count;
+    state->grain = std::max<size_t>(1, grain);
+    state->chunks = (count + state->grain - 1) / state->grain;
+    state->body = &body;
+
+    const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    const size_t helpers = std::min(state->chunks, hardware) - 1;
+    auto pool = helpers > 0 ? sharedThreadPool() : nullptr;
+    if (pool) {
+        const auto current = ThreadPool::currentTask();
+        const auto priority = current ? current->priority : TaskPriority::NORMAL;
+        for (size_t i = 0; i < helpers; ++i) {
+            pool->enqueueTask(nextHelperId(),
+                              priority,
+                              [state](const ProgressCallback&, const std::function<bool()>&) {
+                                  drainChunks(*state, nullptr);
+                                  return makeSuccessResult("null");
+                              },
+                              nullptr);
+        }
+    }
+
+    drainChunks(*state, isCancelled);
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finishedCv.wait(lock, [&state] { return state->finished == state->chunks; });
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+    return !state->stopped.load();
+}
+
+} // namespace threadforge
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace threadforge {
+
+// Splits [0, count) into chunks of at most grain items and runs body(begin, end)
+// on each, spreading the chunks over the shared pool's workers. The calling
+// thread claims chunks too, so this is safe to call from inside a pool task:
+// helpers that never get a worker simply find no chunk left, and the caller
+// only ever waits for chunks that are already running elsewhere.
+//
+// isCancelled, when given, is polled by the caller between chunks; once it
+// returns true the remaining chunks are skipped and the function returns false.
+// The first exception thrown by body is rethrown after in-flight chunks finish.
+bool parallelFor(size_t count,
+                 size_t grain,
+                 const std::function<void(size_t begin, size_t end)>& body,
+                 const std::function<bool()>& isCancelled = nullptr);
+
+} // namespace threadforge
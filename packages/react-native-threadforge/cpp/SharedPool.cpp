@@ -0,0 +1,43 @@
+#include "SharedPool.h"
+
+#include <mutex>
+
+namespace threadforge {
+
+namespace {
+
+std::mutex& sharedPoolMutex() {
+    static std::mutex* mutex = new std::mutex();
+    return *mutex;
+}
+
+std::shared_ptr<ThreadPool>& sharedPoolSlot() {
+    static auto* slot = new std::shared_ptr<ThreadPool>();
+    return *slot;
+}
+
+} // namespace
+
+std::shared_ptr<ThreadPool> sharedThreadPool() {
+    std::lock_guard<std::mutex> lock(sharedPoolMutex());
+    return sharedPoolSlot();
+}
+
+void setSharedThreadPool(std::shared_ptr<ThreadPool> pool) {
+    std::shared_ptr<ThreadPool> previous;
+    {
+        std::lock_guard<std::mutex> lock(sharedPoolMutex());
+        previous = std::move(sharedPoolSlot());
+        sharedPoolSlot() = std::move(pool);
+        if (previous == sharedPoolSlot()) {
+            return;
+        }
+    }
+    if (previous) {
+        previous->retire();
+    }
+    // Dropping the last reference joins the pool's workers; never under the lock.
+    previous.reset();
+}
+
+} // namespace threadforge
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "TaskResult.h"
+#include "ThreadPool.h"
+
+namespace threadforge {
+
+// Public entry point for other native modules (decoders, crypto, ...) that want
+// to run work on the same workers as ThreadForge's JS tasks instead of keeping
+// a pool of their own. Everything below is inline except the two accessors,
+// which live in the ThreadForge library so there is one pool per process.
+
+// The pool that initialize() configured, or nullptr before initialize() and
+// after shutdown(). Holding the returned pointer keeps the pool object alive,
+// but once shutdown() has run the pool stays stopped: enqueueTask() through a
+// stale pointer settles with "ThreadPool is stopped", and co::spawn() chains on
+// it throw co::TaskCancelled.
+std::shared_ptr<ThreadPool> sharedThreadPool();
+
+// Installed by the platform bridges; other modules should not call it. The
+// pool it replaces is retired (ThreadPool::retire()).
+void setSharedThreadPool(std::shared_ptr<ThreadPool> pool);
+
+// Refers to one submitted task. Copies share the task. Task ids share one
+// namespace with JS task ids, so prefix them with the module's name.
+class TaskHandle {
+public:
+    TaskHandle() = default;
+    TaskHandle(std::weak_ptr<ThreadPool> pool, std::shared_ptr<Task> task)
+        : pool_(std::move(pool)), task_(std::move(task)) {}
+
+    bool valid() const {
+        return task_ != nullptr;
+    }
+
+    const std::string& id() const {
+        return task_->id;
+    }
+
+    bool isDone() const {
+        std::lock_guard<std::mutex> lock(task_->mutex);
+        return task_->finished;
+    }
+
+    // Blocks until the task settles. Never call it from inside a pool task:
+    // the waiting worker cannot run the task it waits for.
+    TaskResult wait() const {
+        return ThreadPool::waitForTask(task_);
+    }
+
+    // False when the task is still pending after timeout.
+    bool waitFor(std::chrono::milliseconds timeout) const {
+        return ThreadPool::waitForTask(task_, timeout);
+    }
+
+    bool cancel() const {
+        auto pool = pool_.lock();
+        return pool && pool->cancelTask(task_->id);
+    }
+
+private:
+    std::weak_ptr<ThreadPool> pool_;
+    std::shared_ptr<Task> task_;
+};
+
+// Queues native work on the shared pool without blocking. completion, when
+// given, runs once with the final result on the thread that settles the task.
+// Without a shared pool the handle is already settled with an error.
+inline TaskHandle submitSharedTask(const std::string& taskId,
+                                   TaskPriority priority,
+                                   TaskFunction work,
+                                   ProgressCallback progress = nullptr,
+                                   TaskCompletion completion = nullptr) {
+    auto pool = sharedThreadPool();
+    if (!pool) {
+        auto result = makeErrorResult("ThreadForge is not initialized");
+        auto task = std::make_shared<Task>(taskId, nullptr, priority, 0, nullptr);
+        task->result = result;
+        task->hasResult = true;
+        task->finished = true;
+        if (completion) {
+            completion(result);
+        }
+        return TaskHandle({}, std::move(task));
+    }
+    auto task = pool->enqueueTask(taskId, priority, std::move(work), std::move(progress), std::move(completion));
+    return TaskHandle(pool, std::move(task));
+}
+
+} // namespace threadforge
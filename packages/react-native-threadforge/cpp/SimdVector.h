@@ -0,0 +1,243 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Minimal double-precision vector used by the numeric kernels. The backend is
+// picked at compile time from the target's baseline: AVX when the translation
+// unit is built with it, otherwise SSE2 on x86-64, NEON on arm64 and a
+// one-lane scalar fallback everywhere else (armv7 NEON has no f64 lanes).
+// float inputs are widened on load so every kernel accumulates in double.
+#if defined(__AVX__)
+#include <immintrin.h>
+#define THREADFORGE_SIMD_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define THREADFORGE_SIMD_SSE2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define THREADFORGE_SIMD_NEON 1
+#endif
+
+namespace threadforge::simd {
+
+#if defined(THREADFORGE_SIMD_AVX)
+
+constexpr const char* kBackend = "avx";
+constexpr size_t kLanes = 4;
+using VecD = __m256d;
+
+inline VecD zero() { return _mm256_setzero_pd(); }
+inline VecD broadcast(double value) { return _mm256_set1_pd(value); }
+inline VecD load(const double* data) { return _mm256_loadu_pd(data); }
+inline VecD load(const float* data) { return _mm256_cvtps_pd(_mm_loadu_ps(data)); }
+inline void store(double* out, VecD v) { _mm256_storeu_pd(out, v); }
+inline VecD add(VecD a, VecD b) { return _mm256_add_pd(a, b); }
+inline VecD sub(VecD a, VecD b) { return _mm256_sub_pd(a, b); }
+inline VecD mul(VecD a, VecD b) { return _mm256_mul_pd(a, b); }
+inline VecD div(VecD a, VecD b) { return _mm256_div_pd(a, b); }
+// NaN in value leaves acc untouched, so NaNs are skipped like the scalar path.
+inline VecD min(VecD value, VecD acc) { return _mm256_min_pd(value, acc); }
+inline VecD max(VecD value, VecD acc) { return _mm256_max_pd(value, acc); }
+inline VecD sqrt(VecD v) { return _mm256_sqrt_pd(v); }
+inline VecD bitAnd(VecD a, VecD b) { return _mm256_and_pd(a, b); }
+inline VecD bitOr(VecD a, VecD b) { return _mm256_or_pd(a, b); }
+// AVX1 has no 256-bit integer shifts, so each half goes through SSE2.
+inline VecD shiftLeft52(VecD v) {
+    const auto lo = _mm_slli_epi64(_mm_castpd_si128(_mm256_castpd256_pd128(v)), 52);
+    const auto hi = _mm_slli_epi64(_mm_castpd_si128(_mm256_extractf128_pd(v, 1)), 52);
+    return _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_castsi128_pd(lo)), _mm_castsi128_pd(hi), 1);
+}
+inline VecD shiftRight52(VecD v) {
+    const auto lo = _mm_srli_epi64(_mm_castpd_si128(_mm256_castpd256_pd128(v)), 52);
+    const auto hi = _mm_srli_epi64(_mm_castpd_si128(_mm256_extractf128_pd(v, 1)), 52);
+    return _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_castsi128_pd(lo)), _mm_castsi128_pd(hi), 1);
+}
+
+using MaskD = __m256d;
+inline MaskD lessThan(VecD a, VecD b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+inline MaskD equal(VecD a, VecD b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+inline MaskD isNan(VecD v) { return _mm256_cmp_pd(v, v, _CMP_UNORD_Q); }
+inline MaskD maskOr(MaskD a, MaskD b) { return _mm256_or_pd(a, b); }
+inline VecD select(MaskD mask, VecD ifTrue, VecD ifFalse) { return _mm256_blendv_pd(ifFalse, ifTrue, mask); }
+
+#elif defined(THREADFORGE_SIMD_SSE2)
+
+constexpr const char* kBackend = "sse2";
+constexpr size_t kLanes = 2;
+using VecD = __m128d;
+
+inline VecD zero() { return _mm_setzero_pd(); }
+inline VecD broadcast(double value) { return _mm_set1_pd(value); }
+inline VecD load(const double* data) { return _mm_loadu_pd(data); }
+inline VecD load(const float* data) {
+    return _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(data))));
+}
+inline void store(double* out, VecD v) { _mm_storeu_pd(out, v); }
+inline VecD add(VecD a, VecD b) { return _mm_add_pd(a, b); }
+inline VecD sub(VecD a, VecD b) { return _mm_sub_pd(a, b); }
+inline VecD mul(VecD a, VecD b) { return _mm_mul_pd(a, b); }
+inline VecD div(VecD a, VecD b) { return _mm_div_pd(a, b); }
+inline VecD min(VecD value, VecD acc) { return _mm_min_pd(value, acc); }
+inline VecD max(VecD value, VecD acc) { return _mm_max_pd(value, acc); }
+inline VecD sqrt(VecD v) { return _mm_sqrt_pd(v); }
+inline VecD bitAnd(VecD a, VecD b) { return _mm_and_pd(a, b); }
+inline VecD bitOr(VecD a, VecD b) { return _mm_or_pd(a, b); }
+inline VecD shiftLeft52(VecD v) { return _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(v), 52)); }
+inline VecD shiftRight52(VecD v) { return _mm_castsi128_pd(_mm_srli_epi64(_mm_castpd_si128(v), 52)); }
+
+using MaskD = __m128d;
+inline MaskD lessThan(VecD a, VecD b) { return _mm_cmplt_pd(a, b); }
+inline MaskD equal(VecD a, VecD b) { return _mm_cmpeq_pd(a, b); }
+inline MaskD isNan(VecD v) { return _mm_cmpunord_pd(v, v); }
+inline MaskD maskOr(MaskD a, MaskD b) { return _mm_or_pd(a, b); }
+inline VecD select(MaskD mask, VecD ifTrue, VecD ifFalse) {
+    return _mm_or_pd(_mm_and_pd(mask, ifTrue), _mm_andnot_pd(mask, ifFalse));
+}
+
+#elif defined(THREADFORGE_SIMD_NEON)
+
+constexpr const char* kBackend = "neon";
+constexpr size_t kLanes = 2;
+using VecD = float64x2_t;
+
+inline VecD zero() { return vdupq_n_f64(0.0); }
+inline VecD broadcast(double value) { return vdupq_n_f64(value); }
+inline VecD load(const double* data) { return vld1q_f64(data); }
+inline VecD load(const float* data) { return vcvt_f64_f32(vld1_f32(data)); }
+inline void store(double* out, VecD v) { vst1q_f64(out, v); }
+inline VecD add(VecD a, VecD b) { return vaddq_f64(a, b); }
+inline VecD sub(VecD a, VecD b) { return vsubq_f64(a, b); }
+inline VecD mul(VecD a, VecD b) { return vmulq_f64(a, b); }
+inline VecD div(VecD a, VecD b) { return vdivq_f64(a, b); }
+// vminnm/vmaxnm return the number when one operand is NaN.
+inline VecD min(VecD value, VecD acc) { return vminnmq_f64(value, acc); }
+inline VecD max(VecD value, VecD acc) { return vmaxnmq_f64(value, acc); }
+inline VecD sqrt(VecD v) { return vsqrtq_f64(v); }
+inline VecD bitAnd(VecD a, VecD b) {
+    return vreinterpretq_f64_u64(vandq_u64(vreinterpretq_u64_f64(a), vreinterpretq_u64_f64(b)));
+}
+inline VecD bitOr(VecD a, VecD b) {
+    return vreinterpretq_f64_u64(vorrq_u64(vreinterpretq_u64_f64(a), vreinterpretq_u64_f64(b)));
+}
+inline VecD shiftLeft52(VecD v) { return vreinterpretq_f64_u64(vshlq_n_u64(vreinterpretq_u64_f64(v), 52)); }
+inline VecD shiftRight52(VecD v) { return vreinterpretq_f64_u64(vshrq_n_u64(vreinterpretq_u64_f64(v), 52)); }
+
+using MaskD = uint64x2_t;
+inline MaskD lessThan(VecD a, VecD b) { return vcltq_f64(a, b); }
+inline MaskD equal(VecD a, VecD b) { return vceqq_f64(a, b); }
+inline MaskD isNan(VecD v) {
+    return veorq_u64(vceqq_f64(v, v), vdupq_n_u64(~uint64_t{0}));
+}
+inline MaskD maskOr(MaskD a, MaskD b) { return vorrq_u64(a, b); }
+inline VecD select(MaskD mask, VecD ifTrue, VecD ifFalse) { return vbslq_f64(mask, ifTrue, ifFalse); }
+
+#else
+
+constexpr const char* kBackend = "scalar";
+constexpr size_t kLanes = 1;
+using VecD = double;
+
+inline VecD zero() { return 0.0; }
+inline VecD broadcast(double value) { return value; }
+inline VecD load(const double* data) { return *data; }
+inline VecD load(const float* data) { return static_cast<double>(*data); }
+inline void store(double* out, VecD v) { *out = v; }
+inline VecD add(VecD a, VecD b) { return a + b; }
+inline VecD sub(VecD a, VecD b) { return a - b; }
+inline VecD mul(VecD a, VecD b) { return a * b; }
+inline VecD div(VecD a, VecD b) { return a / b; }
+inline VecD min(VecD value, VecD acc) { return value < acc ? value : acc; }
+inline VecD max(VecD value, VecD acc) { return value > acc ? value : acc; }
+inline VecD sqrt(VecD v) { return std::sqrt(v); }
+inline uint64_t bitsOf(double v) {
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+inline double doubleOf(uint64_t bits) {
+    double v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+inline VecD bitAnd(VecD a, VecD b) { return doubleOf(bitsOf(a) & bitsOf(b)); }
+inline VecD bitOr(VecD a, VecD b) { return doubleOf(bitsOf(a) | bitsOf(b)); }
+inline VecD shiftLeft52(VecD v) { return doubleOf(bitsOf(v) << 52); }
+inline VecD shiftRight52(VecD v) { return doubleOf(bitsOf(v) >> 52); }
+
+using MaskD = bool;
+inline MaskD lessThan(VecD a, VecD b) { return a < b; }
+inline MaskD equal(VecD a, VecD b) { return a == b; }
+inline MaskD isNan(VecD v) { return v != v; }
+inline MaskD maskOr(MaskD a, MaskD b) { return a || b; }
+inline VecD select(MaskD mask, VecD ifTrue, VecD ifFalse) { return mask ? ifTrue : ifFalse; }
+
+#endif
+
+// Broadcasts the double with the given bit pattern (sign and exponent masks).
+inline VecD broadcastBits(uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return broadcast(value);
+}
+
+inline VecD abs(VecD v) {
+    return bitAnd(v, broadcastBits(0x7fffffffffffffffULL));
+}
+
+// Round to nearest, ties to even. Adding and subtracting 2^52 (carrying v's
+// sign) pushes the fraction bits out of the mantissa; |v| >= 2^52 is already
+// an integer. The scalar fallback may run on x87, whose excess precision
+// defeats the trick, so it defers to libm.
+inline VecD roundNearest(VecD v) {
+#if defined(THREADFORGE_SIMD_AVX) || defined(THREADFORGE_SIMD_SSE2) || defined(THREADFORGE_SIMD_NEON)
+    const auto two52 = broadcast(4503599627370496.0);
+    const auto magic = bitOr(two52, bitAnd(v, broadcastBits(0x8000000000000000ULL)));
+    return select(lessThan(abs(v), two52), sub(add(v, magic), magic), v);
+#else
+    return std::nearbyint(v);
+#endif
+}
+
+// 2^k for integer-valued k in [-1022, 1023], built directly in the exponent
+// field: k + 1023 lands in the low mantissa bits of 2^52 + k + 1023, and the
+// shift moves it up while dropping the exponent bits of the 2^52 bias.
+inline VecD pow2(VecD k) {
+    return shiftLeft52(add(k, broadcast(4503599627370496.0 + 1023.0)));
+}
+
+// Biased exponent field of a non-negative v, as a double.
+inline VecD biasedExponent(VecD v) {
+    const auto two52 = broadcast(4503599627370496.0);
+    return sub(bitOr(shiftRight52(v), two52), two52);
+}
+
+// v with its exponent replaced by 0, i.e. the significand in [1, 2).
+inline VecD significand(VecD v) {
+    return bitOr(bitAnd(v, broadcastBits(0x000fffffffffffffULL)), broadcastBits(0x3ff0000000000000ULL));
+}
+
+// Lane-wise spill, for reductions that finish in scalar code.
+struct Lanes {
+    double values[kLanes];
+};
+
+inline Lanes spill(VecD v) {
+    Lanes lanes;
+    store(lanes.values, v);
+    return lanes;
+}
+
+inline double horizontalSum(VecD v) {
+    const auto lanes = spill(v);
+    double total = 0.0;
+    for (size_t i = 0; i < kLanes; ++i) {
+        total += lanes.values[i];
+    }
+    return total;
+}
+
+} // namespace threadforge::simd
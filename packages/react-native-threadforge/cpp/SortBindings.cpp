@@ -0,0 +1,291 @@
+#include "SortBindings.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <jsi/jsi.h>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BindingHelpers.h"
+#include "ColumnarBindings.h"
+#include "KernelRegistry.h"
+#include "Sorting.h"
+#include "TypedArrayView.h"
+#include "nlohmann/json.hpp"
+
+namespace threadforge {
+
+namespace {
+
+using facebook::jsi::Array;
+using facebook::jsi::JSError;
+using facebook::jsi::Object;
+using facebook::jsi::Runtime;
+using facebook::jsi::String;
+using facebook::jsi::Value;
+
+// Copies made for keys that are not typed arrays; deques keep element
+// addresses stable while the columns point into them.
+struct KeyStorage {
+    std::deque<std::vector<double>> numbers;
+    std::deque<std::vector<uint32_t>> ranks;
+};
+
+// Rank of every dictionary entry in string order; equal strings share a rank.
+std::vector<uint32_t> stringRanks(const std::vector<std::string>& strings) {
+    std::vector<uint32_t> order(strings.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return strings[a] < strings[b]; });
+    std::vector<uint32_t> ranks(strings.size());
+    uint32_t rank = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (i > 0 && strings[order[i]] != strings[order[i - 1]]) {
+            ++rank;
+        }
+        ranks[order[i]] = rank;
+    }
+    return ranks;
+}
+
+template <typename Code>
+void remapCodes(const columnar::Column& codes, const std::vector<uint32_t>& ranks, std::vector<uint32_t>& out) {
+    const auto* values = static_cast<const Code*>(codes.data);
+    out.resize(codes.size);
+    for (size_t i = 0; i < codes.size; ++i) {
+        // Codes outside the dictionary sort last.
+        out[i] = values[i] < ranks.size() ? ranks[values[i]] : UINT32_MAX;
+    }
+}
+
+std::vector<std::string> readStrings(Runtime& rt, const Array& array) {
+    std::vector<std::string> strings(array.size(rt));
+    for (size_t i = 0; i < strings.size(); ++i) {
+        strings[i] = array.getValueAtIndex(rt, i).toString(rt).utf8(rt);
+    }
+    return strings;
+}
+
+columnar::Column readNumbers(Runtime& rt, const Array& array, KeyStorage& storage) {
+    auto& numbers = storage.numbers.emplace_back(array.size(rt));
+    for (size_t i = 0; i < numbers.size(); ++i) {
+        const auto value = array.getValueAtIndex(rt, i);
+        numbers[i] = value.isNumber() ? value.getNumber() : NAN;
+    }
+    return columnar::Column{columnar::ColumnType::FLOAT64, numbers.data(), numbers.size()};
+}
+
+// A typed array or a plain number array.
+columnar::Column readValues(Runtime& rt, const Value& value, KeyStorage& storage, const char* method) {
+    const auto view = typedArrayView(rt, value);
+    if (view.valid()) {
+        return columnFromTypedArray(view, "values");
+    }
+    if (!value.isObject() || !value.getObject(rt).isArray(rt)) {
+        throw JSError(rt, std::string(method) + " expects a typed array or an array of numbers");
+    }
+    return readNumbers(rt, value.getObject(rt).getArray(rt), storage);
+}
+
+// Like readValues, plus { codes, dictionary } and string arrays, which are
+// replaced by the rank of each row's string.
+columnar::Column readKeyColumn(Runtime& rt, const Value& value, const std::string& name, KeyStorage& storage) {
+    const auto view = typedArrayView(rt, value);
+    if (view.valid()) {
+        return columnFromTypedArray(view, name);
+    }
+    const auto invalid = "column '" + name + "' must be a typed array, an array or { codes, dictionary }";
+    if (!value.isObject()) {
+        throw std::invalid_argument(invalid);
+    }
+    const auto object = value.getObject(rt);
+    if (object.isArray(rt)) {
+        const auto array = object.getArray(rt);
+        if (array.size(rt) == 0 || !array.getValueAtIndex(rt, 0).isString()) {
+            return readNumbers(rt, array, storage);
+        }
+        auto& ranks = storage.ranks.emplace_back(stringRanks(readStrings(rt, array)));
+        return columnar::Column{columnar::ColumnType::UINT32, ranks.data(), ranks.size()};
+    }
+
+    const auto codesView = typedArrayView(rt, object.getProperty(rt, "codes"));
+    const auto dictionary = object.getProperty(rt, "dictionary");
+    if (!codesView.valid() || !dictionary.isObject() || !dictionary.getObject(rt).isArray(rt)) {
+        throw std::invalid_argument(invalid);
+    }
+    const auto codes = columnFromTypedArray(codesView, name);
+    const auto ranks = stringRanks(readStrings(rt, dictionary.getObject(rt).getArray(rt)));
+    auto& remapped = storage.ranks.emplace_back();
+    switch (codes.type) {
+    case columnar::ColumnType::UINT8:
+        remapCodes<uint8_t>(codes, ranks, remapped);
+        break;
+    case columnar::ColumnType::UINT16:
+        remapCodes<uint16_t>(codes, ranks, remapped);
+        break;
+    case columnar::ColumnType::UINT32:
+        remapCodes<uint32_t>(codes, ranks, remapped);
+        break;
+    default:
+        throw std::invalid_argument("column '" + name + "' codes must be a Uint8Array, Uint16Array or Uint32Array");
+    }
+    return columnar::Column{columnar::ColumnType::UINT32, remapped.data(), remapped.size()};
+}
+
+bool descendingOption(Runtime& rt, const Value& options, bool fallback) {
+    if (!options.isObject()) {
+        return fallback;
+    }
+    const auto descending = options.getObject(rt).getProperty(rt, "descending");
+    return descending.isBool() ? descending.getBool() : fallback;
+}
+
+Value indicesValue(Runtime& rt, const uint32_t* indices, size_t count) {
+    TypedArrayView view;
+    auto array = makeTypedArray(rt, "Uint32Array", count, view);
+    std::copy(indices, indices + count, reinterpret_cast<uint32_t*>(view.data));
+    return array;
+}
+
+// [name, 'asc' | 'desc'] or a bare name (ascending).
+sorting::SortKey readSortKey(Runtime& rt, const Value& entry, const Object& columns, KeyStorage& storage) {
+    std::string name;
+    bool descending = false;
+    if (entry.isString()) {
+        name = entry.getString(rt).utf8(rt);
+    } else if (entry.isObject() && entry.getObject(rt).isArray(rt)) {
+        const auto pair = entry.getObject(rt).getArray(rt);
+        const auto direction = pair.size(rt) == 2 ? pair.getValueAtIndex(rt, 1) : Value::undefined();
+        if (!pair.getValueAtIndex(rt, 0).isString() || !direction.isString()) {
+            throw std::invalid_argument("sort keys look like 'column' or ['column', 'desc']");
+        }
+        name = pair.getValueAtIndex(rt, 0).getString(rt).utf8(rt);
+        const auto order = direction.getString(rt).utf8(rt);
+        if (order != "asc" && order != "desc") {
+            throw std::invalid_argument("sort direction must be 'asc' or 'desc', got '" + order + "'");
+        }
+        descending = order == "desc";
+    } else {
+        throw std::invalid_argument("sort keys look like 'column' or ['column', 'desc']");
+    }
+    if (!columns.hasProperty(rt, name.c_str())) {
+        throw std::invalid_argument("unknown column '" + name + "'");
+    }
+    return sorting::SortKey{readKeyColumn(rt, columns.getProperty(rt, name.c_str()), name, storage), descending};
+}
+
+TaskResult runSortKernel(const std::string& argsJson,
+                         const ProgressCallback&,
+                         const std::function<bool()>& isCancelled) {
+    const auto args = nlohmann::json::parse(argsJson, nullptr, false);
+    if (!args.is_object() || !args.contains("values") || !args["values"].is_array()) {
+        return makeErrorResult("sort.values expects { values: number[], descending?, k? }");
+    }
+    const auto& input = args["values"];
+    std::vector<double> values;
+    values.reserve(input.size());
+    for (const auto& value : input) {
+        values.push_back(value.is_number() ? value.get<double>() : NAN);
+    }
+    const bool descending = args.value("descending", false);
+    const sorting::SortKey key{columnar::Column{columnar::ColumnType::FLOAT64, values.data(), values.size()},
+                               descending};
+
+    std::vector<uint32_t> order;
+    try {
+        bool finished;
+        if (args.contains("k")) {
+            if (!args["k"].is_number() || args["k"].get<double>() < 0) {
+                return makeErrorResult("sort.values: k must be a non-negative number");
+            }
+            finished = sorting::topK(key, static_cast<size_t>(args["k"].get<double>()), order, isCancelled);
+        } else {
+            order.resize(values.size());
+            finished = sorting::argsort({key}, order.data(), isCancelled);
+        }
+        if (!finished) {
+            return makeCancelledResult();
+        }
+    } catch (const std::exception& ex) {
+        return makeErrorResult(std::string("sort.values: ") + ex.what());
+    }
+
+    nlohmann::json result;
+    result["indices"] = order;
+    auto& sorted = result["values"] = nlohmann::json::array();
+    for (const uint32_t index : order) {
+        const double value = values[index];
+        sorted.push_back(std::isfinite(value) ? nlohmann::json(value) : nlohmann::json(nullptr));
+    }
+    return makeSuccessResult(result.dump());
+}
+
+THREADFORGE_REGISTER_KERNEL("sort.values", runSortKernel);
+
+} // namespace
+
+void installSortBindings(Runtime& rt) {
+    Object nativeSort(rt);
+
+    setFunction(rt, nativeSort, "sort", 2, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto& values = argumentAt(args, count, 0);
+        const auto view = typedArrayView(runtime, values);
+        if (!view.valid()) {
+            throw JSError(runtime, "nativeSort.sort sorts typed arrays in place; use argsort for plain arrays");
+        }
+        const auto column = columnFromTypedArray(view, "values");
+        sorting::sortValues(column.type, view.data, view.length, descendingOption(runtime, argumentAt(args, count, 1), false));
+        return Value(runtime, values);
+    });
+
+    setFunction(rt, nativeSort, "argsort", 2, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        KeyStorage storage;
+        const sorting::SortKey key{readValues(runtime, argumentAt(args, count, 0), storage, "nativeSort.argsort"),
+                                   descendingOption(runtime, argumentAt(args, count, 1), false)};
+        TypedArrayView view;
+        auto order = makeTypedArray(runtime, "Uint32Array", key.column.size, view);
+        sorting::argsort({key}, reinterpret_cast<uint32_t*>(view.data));
+        return order;
+    });
+
+    setFunction(rt, nativeSort, "topK", 3, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        KeyStorage storage;
+        const sorting::SortKey key{readValues(runtime, argumentAt(args, count, 0), storage, "nativeSort.topK"),
+                                   descendingOption(runtime, argumentAt(args, count, 2), true)};
+        const auto& k = argumentAt(args, count, 1);
+        if (!k.isNumber() || !(k.getNumber() >= 0)) {
+            throw JSError(runtime, "nativeSort.topK expects a non-negative k");
+        }
+        std::vector<uint32_t> order;
+        sorting::topK(key, static_cast<size_t>(std::min(k.getNumber(), static_cast<double>(key.column.size))), order);
+        return indicesValue(runtime, order.data(), order.size());
+    });
+
+    setFunction(rt, nativeSort, "sortBy", 2, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto& columnsValue = argumentAt(args, count, 0);
+        const auto& byValue = argumentAt(args, count, 1);
+        if (!columnsValue.isObject() || !byValue.isObject() || !byValue.getObject(runtime).isArray(runtime)) {
+            throw JSError(runtime, "nativeSort.sortBy expects ({ name: column }, keys[])");
+        }
+        const auto columns = columnsValue.getObject(runtime);
+        const auto by = byValue.getObject(runtime).getArray(runtime);
+        KeyStorage storage;
+        std::vector<sorting::SortKey> keys;
+        for (size_t i = 0; i < by.size(runtime); ++i) {
+            keys.push_back(readSortKey(runtime, by.getValueAtIndex(runtime, i), columns, storage));
+        }
+        if (keys.empty()) {
+            throw JSError(runtime, "nativeSort.sortBy needs at least one key");
+        }
+        TypedArrayView view;
+        auto order = makeTypedArray(runtime, "Uint32Array", keys[0].column.size, view);
+        sorting::argsort(keys, reinterpret_cast<uint32_t*>(view.data));
+        return order;
+    });
+
+    rt.global().setProperty(rt, "nativeSort", nativeSort);
+}
+
+} // namespace threadforge
@@ -0,0 +1,26 @@
+#pragma once
+
+namespace facebook::jsi {
+class Runtime;
+} // namespace facebook::jsi
+
+namespace threadforge {
+
+// Installs the global `nativeSort` object in a worker runtime, a front end for
+// Sorting.h. Typed arrays are read in place; plain number arrays are copied to
+// Float64. Orders come back as Uint32Array row indices, and NaN sorts last.
+//
+//     nativeSort.sort(values, { descending? })    // sorts the typed array in place, returns it
+//     nativeSort.argsort(values, { descending? })
+//     nativeSort.topK(values, k, { descending? }) // largest first unless descending: false
+//     nativeSort.sortBy(
+//       { category: { codes, dictionary }, amount },
+//       ['category', ['amount', 'desc']],        // later keys break ties, at most 4
+//     )
+//
+// Dictionary-encoded columns (and plain string arrays) sort by their strings.
+// The "sort.values" kernel takes { values, descending?, k? } as JSON for
+// runKernel() and returns { indices, values }.
+void installSortBindings(facebook::jsi::Runtime& runtime);
+
+} // namespace threadforge
@@ -0,0 +1,484 @@
+#include "Sorting.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "ParallelFor.h"
+
+namespace threadforge::sorting {
+
+namespace {
+
+using columnar::Column;
+using columnar::ColumnType;
+
+constexpr size_t kMaxChunks = 16;
+constexpr size_t kMinChunk = 1 << 14;
+constexpr size_t kBuckets = 256;
+// Below this a comparison sort beats the fixed cost of the radix passes.
+constexpr size_t kSmallSort = 256;
+// Records of a multi-key argsort carry their keys inline.
+constexpr size_t kMaxSortKeys = 4;
+
+template <typename T>
+struct TypeTag {
+    using type = T;
+};
+
+template <typename Fn>
+decltype(auto) withElementType(ColumnType type, Fn&& fn) {
+    switch (type) {
+    case ColumnType::FLOAT64:
+        return fn(TypeTag<double>{});
+    case ColumnType::FLOAT32:
+        return fn(TypeTag<float>{});
+    case ColumnType::INT32:
+        return fn(TypeTag<int32_t>{});
+    case ColumnType::UINT32:
+        return fn(TypeTag<uint32_t>{});
+    case ColumnType::INT16:
+        return fn(TypeTag<int16_t>{});
+    case ColumnType::UINT16:
+        return fn(TypeTag<uint16_t>{});
+    case ColumnType::INT8:
+        return fn(TypeTag<int8_t>{});
+    case ColumnType::UINT8:
+        break;
+    }
+    return fn(TypeTag<uint8_t>{});
+}
+
+template <typename T>
+using KeyFor = std::conditional_t<sizeof(T) == 8, uint64_t, uint32_t>;
+
+// Maps value to an unsigned key with the same order: the sign bit is flipped
+// for integers, and for IEEE floats negative values are complemented. NaN gets
+// the largest key, and descending order complements every other key, so NaN
+// stays last.
+template <typename T>
+KeyFor<T> sortKey(T value, bool descending) {
+    using Key = KeyFor<T>;
+    constexpr Key kSign = Key{1} << (sizeof(Key) * 8 - 1);
+    Key key;
+    if constexpr (std::is_floating_point_v<T>) {
+        if (std::isnan(value)) {
+            return std::numeric_limits<Key>::max();
+        }
+        std::memcpy(&key, &value, sizeof(key));
+        key = (key & kSign) ? ~key : key | kSign;
+    } else if constexpr (std::is_signed_v<T>) {
+        key = static_cast<Key>(static_cast<std::make_signed_t<Key>>(value)) ^ kSign;
+    } else {
+        key = static_cast<Key>(value);
+    }
+    return descending ? ~key : key;
+}
+
+template <typename Key>
+struct Ranked {
+    Key key;
+    uint32_t index;
+
+    bool operator<(const Ranked& other) const {
+        return key != other.key ? key < other.key : index < other.index;
+    }
+};
+
+size_t chunkCount(size_t size) {
+    return size < kParallelThreshold ? 1 : std::min(kMaxChunks, size / kMinChunk);
+}
+
+// Runs body(chunk) for every chunk, on the pool when there are several.
+// Deliberately not cancellable: callers only stop between whole passes, so
+// their buffers are never left half written.
+template <typename Body>
+void forEachChunk(size_t chunks, const Body& body) {
+    if (chunks == 1) {
+        body(0);
+        return;
+    }
+    parallelFor(chunks, 1, [&](size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; ++chunk) {
+            body(chunk);
+        }
+    });
+}
+
+// Stable LSD radix sort of items by keyOf(item), one byte per pass. Every
+// chunk histograms and scatters its own slice into exclusive output ranges,
+// so the passes parallelize without atomics and stay stable.
+template <typename Item, typename KeyFn>
+bool radixSort(Item* data, size_t size, const KeyFn& keyOf, const std::function<bool()>& isCancelled) {
+    using Key = std::decay_t<decltype(keyOf(*data))>;
+    constexpr size_t kDigits = sizeof(Key);
+    if (size < kSmallSort) {
+        std::stable_sort(data, data + size, [&](const Item& a, const Item& b) { return keyOf(a) < keyOf(b); });
+        return !(isCancelled && isCancelled());
+    }
+
+    const size_t chunks = chunkCount(size);
+    const size_t chunkSize = (size + chunks - 1) / chunks;
+    using Histogram = std::array<size_t, kBuckets>;
+    std::vector<std::array<Histogram, kDigits>> counts(chunks);
+    auto rangeOf = [&](size_t chunk) {
+        return std::make_pair(chunk * chunkSize, std::min(size, (chunk + 1) * chunkSize));
+    };
+
+    // One read counts every digit. The totals do not depend on the order of
+    // the items, so they also tell which digits all items share.
+    forEachChunk(chunks, [&](size_t chunk) {
+        auto& count = counts[chunk];
+        for (auto& histogram : count) {
+            histogram.fill(0);
+        }
+        const auto [begin, end] = rangeOf(chunk);
+        for (size_t i = begin; i < end; ++i) {
+            const Key key = keyOf(data[i]);
+            for (size_t digit = 0; digit < kDigits; ++digit) {
+                count[digit][(key >> (digit * 8)) & 0xFF]++;
+            }
+        }
+    });
+
+    std::vector<Item> scratch(size);
+    Item* source = data;
+    Item* target = scratch.data();
+    bool countsCurrent = true;
+    bool cancelled = false;
+    for (size_t digit = 0; digit < kDigits; ++digit) {
+        bool shared = false;
+        for (size_t bucket = 0; bucket < kBuckets && !shared; ++bucket) {
+            size_t total = 0;
+            for (size_t chunk = 0; chunk < chunks; ++chunk) {
+                total += counts[chunk][digit][bucket];
+            }
+            shared = total == size;
+        }
+        if (shared) {
+            continue;
+        }
+        if (isCancelled && isCancelled()) {
+            cancelled = true;
+            break;
+        }
+        const size_t shift = digit * 8;
+        // A single chunk's counts stay exact; otherwise items changed chunks
+        // in the previous pass and each chunk recounts this digit.
+        if (!countsCurrent && chunks > 1) {
+            forEachChunk(chunks, [&](size_t chunk) {
+                auto& histogram = counts[chunk][digit];
+                histogram.fill(0);
+                const auto [begin, end] = rangeOf(chunk);
+                for (size_t i = begin; i < end; ++i) {
+                    histogram[(keyOf(source[i]) >> shift) & 0xFF]++;
+                }
+            });
+        }
+        std::vector<Histogram> offsets(chunks);
+        size_t running = 0;
+        for (size_t bucket = 0; bucket < kBuckets; ++bucket) {
+            for (size_t chunk = 0; chunk < chunks; ++chunk) {
+                offsets[chunk][bucket] = running;
+                running += counts[chunk][digit][bucket];
+            }
+        }
+        forEachChunk(chunks, [&](size_t chunk) {
+            auto& offset = offsets[chunk];
+            const auto [begin, end] = rangeOf(chunk);
+            for (size_t i = begin; i < end; ++i) {
+                target[offset[(keyOf(source[i]) >> shift) & 0xFF]++] = source[i];
+            }
+        });
+        std::swap(source, target);
+        countsCurrent = false;
+    }
+    if (source != data) {
+        std::copy(source, source + size, data);
+    }
+    return !cancelled;
+}
+
+template <typename T>
+const T* valuesOf(const Column& column) {
+    return static_cast<const T*>(column.data);
+}
+
+size_t checkedRows(const std::vector<SortKey>& keys) {
+    if (keys.empty()) {
+        throw std::invalid_argument("argsort needs at least one key");
+    }
+    const size_t rows = keys[0].column.size;
+    for (const auto& key : keys) {
+        if (key.column.size != rows) {
+            throw std::invalid_argument("sort key columns must have the same length");
+        }
+    }
+    if (rows > std::numeric_limits<uint32_t>::max()) {
+        throw std::invalid_argument("sorting is limited to 2^32 - 1 rows");
+    }
+    return rows;
+}
+
+bool argsortSingle(const SortKey& key, size_t rows, uint32_t* order, const std::function<bool()>& isCancelled) {
+    return withElementType(key.column.type, [&](auto tag) {
+        using T = typename decltype(tag)::type;
+        using Item = Ranked<KeyFor<T>>;
+        const T* values = valuesOf<T>(key.column);
+        std::vector<Item> items(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            items[i] = Item{sortKey(values[i], key.descending), static_cast<uint32_t>(i)};
+        }
+        if (!radixSort(items.data(), rows, [](const Item& item) { return item.key; }, isCancelled)) {
+            return false;
+        }
+        for (size_t i = 0; i < rows; ++i) {
+            order[i] = items[i].index;
+        }
+        return true;
+    });
+}
+
+struct Record {
+    std::array<uint64_t, kMaxSortKeys> keys;
+    uint32_t index;
+};
+
+// First position i of a such that merging a and b puts exactly a[0, i) and
+// b[0, position - i) before output index position.
+template <typename Less>
+size_t coRank(size_t position, const Record* a, size_t aSize, const Record* b, size_t bSize, const Less& less) {
+    size_t low = position > bSize ? position - bSize : 0;
+    size_t high = std::min(position, aSize);
+    while (low < high) {
+        const size_t i = low + (high - low) / 2;
+        const size_t j = position - i;
+        if (j > 0 && less(a[i], b[j - 1])) {
+            low = i + 1;
+        } else {
+            high = i;
+        }
+    }
+    return low;
+}
+
+// Sorts chunks in parallel, then merges runs pairwise. Each merge is split
+// into output segments at co-ranks, so the last rounds, with few long runs,
+// still keep every worker busy.
+bool argsortMerge(const std::vector<SortKey>& keys, size_t rows, uint32_t* order, const std::function<bool()>& isCancelled) {
+    const size_t width = keys.size();
+    std::vector<Record> records(rows);
+    for (size_t k = 0; k < width; ++k) {
+        withElementType(keys[k].column.type, [&](auto tag) {
+            using T = typename decltype(tag)::type;
+            const T* values = valuesOf<T>(keys[k].column);
+            for (size_t i = 0; i < rows; ++i) {
+                records[i].keys[k] = sortKey(values[i], keys[k].descending);
+            }
+        });
+    }
+    for (size_t i = 0; i < rows; ++i) {
+        records[i].index = static_cast<uint32_t>(i);
+    }
+    // The index breaks remaining ties, which makes the order total and the
+    // result stable without a stable sort.
+    const auto less = [width](const Record& a, const Record& b) {
+        for (size_t k = 0; k < width; ++k) {
+            if (a.keys[k] != b.keys[k]) {
+                return a.keys[k] < b.keys[k];
+            }
+        }
+        return a.index < b.index;
+    };
+
+    const size_t chunks = chunkCount(rows);
+    const size_t chunkSize = rows == 0 ? 1 : (rows + chunks - 1) / chunks;
+    std::vector<size_t> bounds;
+    for (size_t begin = 0; begin < rows; begin += chunkSize) {
+        bounds.push_back(begin);
+    }
+    bounds.push_back(rows);
+    forEachChunk(bounds.size() - 1, [&](size_t chunk) {
+        std::sort(records.begin() + bounds[chunk], records.begin() + bounds[chunk + 1], less);
+    });
+
+    std::vector<Record> scratch(rows);
+    Record* source = records.data();
+    Record* target = scratch.data();
+    bool cancelled = false;
+    while (bounds.size() > 2) {
+        if (isCancelled && isCancelled()) {
+            cancelled = true;
+            break;
+        }
+        struct Segment {
+            size_t aBegin, aEnd, bBegin, bEnd, out;
+        };
+        std::vector<Segment> segments;
+        std::vector<size_t> merged{0};
+        for (size_t run = 0; run + 1 < bounds.size(); run += 2) {
+            const size_t aBegin = bounds[run];
+            const size_t aEnd = bounds[run + 1];
+            // An odd run out is copied through unchanged.
+            const size_t bEnd = run + 2 < bounds.size() ? bounds[run + 2] : aEnd;
+            const size_t length = bEnd - aBegin;
+            const size_t parts = std::max<size_t>(1, length / chunkSize);
+            size_t previous = 0;
+            for (size_t part = 1; part <= parts; ++part) {
+                const size_t position = part == parts ? length : length * part / parts;
+                const size_t i = coRank(position, source + aBegin, aEnd - aBegin, source + aEnd, bEnd - aEnd, less);
+                const size_t i0 = coRank(previous, source + aBegin, aEnd - aBegin, source + aEnd, bEnd - aEnd, less);
+                segments.push_back(Segment{aBegin + i0, aBegin + i, aEnd + (previous - i0), aEnd + (position - i), aBegin + previous});
+                previous = position;
+            }
+            merged.push_back(bEnd);
+        }
+        forEachChunk(segments.size(), [&](size_t index) {
+            const auto& segment = segments[index];
+            std::merge(source + segment.aBegin,
+                       source + segment.aEnd,
+                       source + segment.bBegin,
+                       source + segment.bEnd,
+                       target + segment.out,
+                       less);
+        });
+        std::swap(source, target);
+        bounds = std::move(merged);
+    }
+    if (cancelled) {
+        return false;
+    }
+    for (size_t i = 0; i < rows; ++i) {
+        order[i] = source[i].index;
+    }
+    return true;
+}
+
+// Keeps the k smallest items seen, compacting with nth_element whenever the
+// buffer doubles; items not below the current k-th are rejected outright.
+template <typename Key>
+class Selection {
+public:
+    explicit Selection(size_t k)
+        : k_(k) {
+        kept_.reserve(2 * k);
+    }
+
+    void offer(Key key, uint32_t index) {
+        // Indices arrive in increasing order, so a tie with the k-th loses.
+        if (full_ && key >= worst_) {
+            return;
+        }
+        kept_.push_back(Ranked<Key>{key, index});
+        if (kept_.size() == 2 * k_) {
+            compact();
+        }
+    }
+
+    std::vector<Ranked<Key>>& finish() {
+        if (kept_.size() > k_) {
+            compact();
+        }
+        return kept_;
+    }
+
+private:
+    void compact() {
+        std::nth_element(kept_.begin(), kept_.begin() + (k_ - 1), kept_.end());
+        kept_.resize(k_);
+        worst_ = kept_[k_ - 1].key;
+        full_ = true;
+    }
+
+    size_t k_;
+    std::vector<Ranked<Key>> kept_;
+    Key worst_{};
+    bool full_{false};
+};
+
+} // namespace
+
+bool sortValues(ColumnType type, void* data, size_t size, bool descending, const std::function<bool()>& isCancelled) {
+    return withElementType(type, [&](auto tag) {
+        using T = typename decltype(tag)::type;
+        return radixSort(
+            static_cast<T*>(data), size, [descending](T value) { return sortKey(value, descending); }, isCancelled);
+    });
+}
+
+bool argsort(const std::vector<SortKey>& keys, uint32_t* order, const std::function<bool()>& isCancelled) {
+    const size_t rows = checkedRows(keys);
+    if (keys.size() > kMaxSortKeys) {
+        throw std::invalid_argument("argsort takes at most " + std::to_string(kMaxSortKeys) + " keys");
+    }
+    if (keys.size() == 1) {
+        return argsortSingle(keys[0], rows, order, isCancelled);
+    }
+    return argsortMerge(keys, rows, order, isCancelled);
+}
+
+bool topK(const SortKey& key, size_t k, std::vector<uint32_t>& order, const std::function<bool()>& isCancelled) {
+    const size_t rows = checkedRows({key});
+    k = std::min(k, rows);
+    // Selecting a large share of the rows is no cheaper than sorting them.
+    if (k > rows / 8) {
+        std::vector<uint32_t> sorted(rows);
+        if (!argsort({key}, sorted.data(), isCancelled)) {
+            return false;
+        }
+        sorted.resize(k);
+        order = std::move(sorted);
+        return true;
+    }
+    if (k == 0) {
+        order.clear();
+        return !(isCancelled && isCancelled());
+    }
+    return withElementType(key.column.type, [&](auto tag) {
+        using T = typename decltype(tag)::type;
+        using Key = KeyFor<T>;
+        const T* values = valuesOf<T>(key.column);
+        const size_t chunks = chunkCount(rows);
+        const size_t chunkSize = (rows + chunks - 1) / chunks;
+        std::vector<std::vector<Ranked<Key>>> partials(chunks);
+        const bool finished = parallelFor(
+            chunks,
+            1,
+            [&](size_t begin, size_t end) {
+                for (size_t chunk = begin; chunk < end; ++chunk) {
+                    Selection<Key> selection(k);
+                    const size_t last = std::min(rows, (chunk + 1) * chunkSize);
+                    for (size_t i = chunk * chunkSize; i < last; ++i) {
+                        selection.offer(sortKey(values[i], key.descending), static_cast<uint32_t>(i));
+                    }
+                    partials[chunk] = std::move(selection.finish());
+                }
+            },
+            isCancelled);
+        if (!finished) {
+            return false;
+        }
+        std::vector<Ranked<Key>> best;
+        for (auto& partial : partials) {
+            best.insert(best.end(), partial.begin(), partial.end());
+        }
+        if (best.size() > k) {
+            std::nth_element(best.begin(), best.begin() + (k - 1), best.end());
+            best.resize(k);
+        }
+        std::sort(best.begin(), best.end());
+        order.resize(k);
+        for (size_t i = 0; i < k; ++i) {
+            order[i] = best[i].index;
+        }
+        return true;
+    });
+}
+
+} // namespace threadforge::sorting
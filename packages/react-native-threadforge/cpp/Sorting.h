@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "Columnar.h"
+
+namespace threadforge::sorting {
+
+// Element counts from which the sorts split their passes across the shared pool.
+constexpr size_t kParallelThreshold = 1 << 16;
+
+// One sort key over a column of any Columnar.h type. Values are ordered
+// numerically; NaN sorts last in either direction.
+struct SortKey {
+    columnar::Column column;
+    bool descending{false};
+};
+
+// Sorts size elements of type at data in place with an LSD radix sort that
+// skips the byte positions all values share.
+bool sortValues(columnar::ColumnType type,
+                void* data,
+                size_t size,
+                bool descending,
+                const std::function<bool()>& isCancelled = nullptr);
+
+// Fills order (the keys' common length) with the row indices in key order:
+// keys[0] decides first, later keys break ties, and rows that tie on every key
+// keep their relative order. A single key is radix sorted; several go through
+// a parallel merge sort. Throws std::invalid_argument for more than 4 keys,
+// columns that differ in length, or 2^32 rows or more.
+bool argsort(const std::vector<SortKey>& keys,
+             uint32_t* order,
+             const std::function<bool()>& isCancelled = nullptr);
+
+// The first min(k, rows) entries of argsort({key}), i.e. the k largest rows
+// first when key.descending, found without sorting the rest.
+bool topK(const SortKey& key,
+          size_t k,
+          std::vector<uint32_t>& order,
+          const std::function<bool()>& isCancelled = nullptr);
+
+} // namespace threadforge::sorting
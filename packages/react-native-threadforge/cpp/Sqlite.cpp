@@ -0,0 +1,285 @@
+#include "Sqlite.h"
+
+#if THREADFORGE_SQLITE
+
+#include <sqlite3.h>
+
+namespace threadforge::sqlite {
+
+namespace {
+
+[[noreturn]] void fail(sqlite3* db, int result) {
+    const int code = db ? sqlite3_extended_errcode(db) : result;
+    const char* message = db ? sqlite3_errmsg(db) : sqlite3_errstr(result);
+    throw Error(code, message ? message : sqlite3_errstr(result));
+}
+
+std::string savepointName(size_t level) {
+    return "threadforge_" + std::to_string(level);
+}
+
+} // namespace
+
+Error::Error(int code, const std::string& message)
+    : std::runtime_error(message),
+      code_(code) {}
+
+std::shared_ptr<Database> Database::open(const std::string& path, const Options& options) {
+    int flags = options.readOnly ? SQLITE_OPEN_READONLY : SQLITE_OPEN_READWRITE;
+    if (!options.readOnly && options.create) {
+        flags |= SQLITE_OPEN_CREATE;
+    }
+    sqlite3* handle = nullptr;
+    const int result = sqlite3_open_v2(path.c_str(), &handle, flags, nullptr);
+    if (result != SQLITE_OK) {
+        const std::string message = handle ? sqlite3_errmsg(handle) : sqlite3_errstr(result);
+        sqlite3_close_v2(handle);
+        throw Error(result, "cannot open " + path + ": " + message);
+    }
+    sqlite3_extended_result_codes(handle, 1);
+    sqlite3_busy_timeout(handle, options.busyTimeoutMs);
+    return std::shared_ptr<Database>(new Database(handle));
+}
+
+Database::Database(sqlite3* handle)
+    : db_(handle) {}
+
+Database::~Database() {
+    close();
+}
+
+void Database::exec(const std::string& sql) {
+    if (sqlite3_exec(handle(), sql.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK) {
+        fail(db_, SQLITE_ERROR);
+    }
+}
+
+std::shared_ptr<Statement> Database::prepare(const std::string& sql) {
+    sqlite3_stmt* stmt = nullptr;
+    const char* tail = nullptr;
+    if (sqlite3_prepare_v2(handle(), sql.c_str(), static_cast<int>(sql.size()), &stmt, &tail) != SQLITE_OK) {
+        fail(db_, SQLITE_ERROR);
+    }
+    if (!stmt) {
+        throw Error(SQLITE_MISUSE, "prepare() needs a statement");
+    }
+    auto statement = std::make_shared<Statement>(shared_from_this(), stmt);
+    // Whitespace and comments after the statement compile to nothing.
+    sqlite3_stmt* extra = nullptr;
+    const int result = sqlite3_prepare_v2(db_, tail, -1, &extra, nullptr);
+    sqlite3_finalize(extra);
+    if (result != SQLITE_OK || extra) {
+        throw Error(SQLITE_MISUSE, "prepare() takes a single statement; use exec() for scripts");
+    }
+    return statement;
+}
+
+void Database::begin() {
+    const bool outermost = sqlite3_get_autocommit(handle()) != 0;
+    exec(outermost ? std::string("BEGIN") : "SAVEPOINT " + savepointName(levels_.size()));
+    levels_.push_back(outermost);
+}
+
+void Database::commit() {
+    if (levels_.empty()) {
+        throw Error(SQLITE_MISUSE, "commit() without begin()");
+    }
+    const bool outermost = levels_.back();
+    exec(outermost ? std::string("COMMIT") : "RELEASE " + savepointName(levels_.size() - 1));
+    levels_.pop_back();
+}
+
+void Database::rollback() {
+    if (levels_.empty()) {
+        throw Error(SQLITE_MISUSE, "rollback() without begin()");
+    }
+    const bool outermost = levels_.back();
+    const auto name = savepointName(levels_.size() - 1);
+    levels_.pop_back();
+    // Some errors (SQLITE_FULL, SQLITE_IOERR, ...) already rolled the whole
+    // transaction back.
+    if (sqlite3_get_autocommit(handle())) {
+        return;
+    }
+    exec(outermost ? std::string("ROLLBACK") : "ROLLBACK TO " + name + "; RELEASE " + name);
+}
+
+int64_t Database::changes() const {
+    return sqlite3_changes(handle());
+}
+
+int64_t Database::totalChanges() const {
+    return sqlite3_total_changes(handle());
+}
+
+int64_t Database::lastInsertRowId() const {
+    return sqlite3_last_insert_rowid(handle());
+}
+
+bool Database::isOpen() const {
+    return db_ != nullptr;
+}
+
+void Database::close() {
+    if (db_) {
+        // Statements still alive keep the connection until they finalize
+        // (that is what _v2 allows), but must not keep holding locks.
+        for (auto* stmt = sqlite3_next_stmt(db_, nullptr); stmt; stmt = sqlite3_next_stmt(db_, stmt)) {
+            sqlite3_reset(stmt);
+        }
+        sqlite3_close_v2(db_);
+        db_ = nullptr;
+        levels_.clear();
+    }
+}
+
+sqlite3* Database::handle() const {
+    if (!db_) {
+        throw Error(SQLITE_MISUSE, "database is closed");
+    }
+    return db_;
+}
+
+Statement::Statement(std::shared_ptr<Database> database, sqlite3_stmt* handle)
+    : database_(std::move(database)),
+      stmt_(handle) {}
+
+Statement::~Statement() {
+    finalize();
+}
+
+sqlite3_stmt* Statement::checked() const {
+    if (!stmt_) {
+        throw Error(SQLITE_MISUSE, "statement is finalized");
+    }
+    database_->handle();
+    return stmt_;
+}
+
+void Statement::check(int result) const {
+    if (result != SQLITE_OK) {
+        fail(sqlite3_db_handle(stmt_), result);
+    }
+}
+
+int Statement::parameterCount() const {
+    return sqlite3_bind_parameter_count(checked());
+}
+
+int Statement::parameterIndex(const std::string& name) const {
+    auto* stmt = checked();
+    if (!name.empty() && (name[0] == ':' || name[0] == '@' || name[0] == '$')) {
+        return sqlite3_bind_parameter_index(stmt, name.c_str());
+    }
+    for (const char prefix : {':', '@', '$'}) {
+        const int index = sqlite3_bind_parameter_index(stmt, (prefix + name).c_str());
+        if (index > 0) {
+            return index;
+        }
+    }
+    return 0;
+}
+
+void Statement::bindNull(int index) {
+    check(sqlite3_bind_null(checked(), index));
+}
+
+void Statement::bindInt64(int index, int64_t value) {
+    check(sqlite3_bind_int64(checked(), index, value));
+}
+
+void Statement::bindDouble(int index, double value) {
+    check(sqlite3_bind_double(checked(), index, value));
+}
+
+void Statement::bindText(int index, const char* text, size_t size) {
+    check(sqlite3_bind_text64(checked(), index, text, size, SQLITE_TRANSIENT, SQLITE_UTF8));
+}
+
+void Statement::bindBlob(int index, const void* data, size_t size) {
+    check(sqlite3_bind_blob64(checked(), index, data, size, SQLITE_TRANSIENT));
+}
+
+void Statement::clearBindings() {
+    check(sqlite3_clear_bindings(checked()));
+}
+
+bool Statement::step() {
+    const int result = sqlite3_step(checked());
+    if (result == SQLITE_ROW) {
+        return true;
+    }
+    if (result == SQLITE_DONE) {
+        return false;
+    }
+    // Leave the statement reusable; the error stays readable until then.
+    Error error(sqlite3_extended_errcode(sqlite3_db_handle(stmt_)), sqlite3_errmsg(sqlite3_db_handle(stmt_)));
+    sqlite3_reset(stmt_);
+    ++generation_;
+    throw error;
+}
+
+void Statement::reset() {
+    // The step() that failed already reported the error reset() returns again.
+    sqlite3_reset(checked());
+    ++generation_;
+}
+
+int Statement::columnCount() const {
+    return sqlite3_column_count(checked());
+}
+
+std::string Statement::columnName(int column) const {
+    const char* name = sqlite3_column_name(checked(), column);
+    return name ? name : std::string();
+}
+
+ValueType Statement::columnType(int column) const {
+    switch (sqlite3_column_type(checked(), column)) {
+    case SQLITE_INTEGER:
+        return ValueType::INTEGER;
+    case SQLITE_FLOAT:
+        return ValueType::FLOAT;
+    case SQLITE_TEXT:
+        return ValueType::TEXT;
+    case SQLITE_BLOB:
+        return ValueType::BLOB;
+    default:
+        return ValueType::NUL;
+    }
+}
+
+int64_t Statement::columnInt64(int column) const {
+    return sqlite3_column_int64(checked(), column);
+}
+
+double Statement::columnDouble(int column) const {
+    return sqlite3_column_double(checked(), column);
+}
+
+std::string_view Statement::columnText(int column) const {
+    auto* stmt = checked();
+    const auto* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+    return text ? std::string_view(text, static_cast<size_t>(sqlite3_column_bytes(stmt, column))) : std::string_view();
+}
+
+std::pair<const uint8_t*, size_t> Statement::columnBlob(int column) const {
+    auto* stmt = checked();
+    const auto* data = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, column));
+    return {data, static_cast<size_t>(sqlite3_column_bytes(stmt, column))};
+}
+
+bool Statement::readOnly() const {
+    return sqlite3_stmt_readonly(checked()) != 0;
+}
+
+void Statement::finalize() {
+    if (stmt_) {
+        sqlite3_finalize(stmt_);
+        stmt_ = nullptr;
+    }
+}
+
+} // namespace threadforge::sqlite
+
+#endif // THREADFORGE_SQLITE
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// SQLite support is compiled in wherever <sqlite3.h> is available: iOS links
+// the system library, Android the sqlite-android prefab when enabled (see
+// android/build.gradle). Define THREADFORGE_SQLITE=0 to leave it out.
+#ifndef THREADFORGE_SQLITE
+#if __has_include(<sqlite3.h>)
+#define THREADFORGE_SQLITE 1
+#else
+#define THREADFORGE_SQLITE 0
+#endif
+#endif
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace threadforge::sqlite {
+
+// A failed SQLite call; code is the extended result code and what() carries
+// SQLite's message.
+class Error : public std::runtime_error {
+public:
+    Error(int code, const std::string& message);
+
+    int code() const {
+        return code_;
+    }
+
+private:
+    int code_;
+};
+
+enum class ValueType : uint8_t {
+    NUL,
+    INTEGER,
+    FLOAT,
+    TEXT,
+    BLOB
+};
+
+class Statement;
+
+// One connection, used by one thread at a time (each worker runtime opens its
+// own). Statements keep their database alive; close() finalizes nothing, so
+// statements still open then fail with an Error on their next use.
+class Database : public std::enable_shared_from_this<Database> {
+public:
+    struct Options {
+        bool readOnly{false};
+        bool create{true};
+        // How long a write waits for another connection's lock.
+        int busyTimeoutMs{5000};
+    };
+
+    // Opens path (":memory:" for a private in-memory database). Throws Error.
+    static std::shared_ptr<Database> open(const std::string& path, const Options& options);
+
+    ~Database();
+    Database(const Database&) = delete;
+    Database& operator=(const Database&) = delete;
+
+    // Runs every statement in sql, discarding rows.
+    void exec(const std::string& sql);
+    // Compiles the first statement in sql; trailing statements are an error.
+    std::shared_ptr<Statement> prepare(const std::string& sql);
+
+    // Transactions nest: the outermost level is BEGIN / COMMIT, inner levels
+    // are savepoints. rollback() undoes only the innermost level.
+    void begin();
+    void commit();
+    void rollback();
+
+    int64_t changes() const;
+    int64_t totalChanges() const;
+    int64_t lastInsertRowId() const;
+    bool isOpen() const;
+    void close();
+
+    sqlite3* handle() const;
+
+private:
+    explicit Database(sqlite3* handle);
+
+    sqlite3* db_;
+    // One entry per open begin(): true where it issued BEGIN, false for a
+    // savepoint inside a transaction that was already open.
+    std::vector<bool> levels_;
+};
+
+// A prepared statement. Parameters are 1-based as in SQLite, columns 0-based.
+// Text and blob columns point into SQLite's buffers and stay valid until the
+// next step(), reset() or column read of a different type.
+class Statement {
+public:
+    Statement(std::shared_ptr<Database> database, sqlite3_stmt* handle);
+    ~Statement();
+    Statement(const Statement&) = delete;
+    Statement& operator=(const Statement&) = delete;
+
+    int parameterCount() const;
+    // Index of a named parameter; a bare name also matches :name, @name and
+    // $name. 0 when the statement has no such parameter.
+    int parameterIndex(const std::string& name) const;
+
+    void bindNull(int index);
+    void bindInt64(int index, int64_t value);
+    void bindDouble(int index, double value);
+    void bindText(int index, const char* text, size_t size);
+    void bindBlob(int index, const void* data, size_t size);
+    void clearBindings();
+
+    // Advances to the next row; false once the statement is done.
+    bool step();
+    // Rewinds for another run with new bindings. Bumps generation().
+    void reset();
+    // Changes on every reset(), so row cursors notice the statement was rerun.
+    uint64_t generation() const {
+        return generation_;
+    }
+
+    int columnCount() const;
+    std::string columnName(int column) const;
+    ValueType columnType(int column) const;
+    int64_t columnInt64(int column) const;
+    double columnDouble(int column) const;
+    std::string_view columnText(int column) const;
+    std::pair<const uint8_t*, size_t> columnBlob(int column) const;
+
+    // True when the statement does not write to the database.
+    bool readOnly() const;
+    const std::shared_ptr<Database>& database() const {
+        return database_;
+    }
+    void finalize();
+
+private:
+    sqlite3_stmt* checked() const;
+    void check(int result) const;
+
+    std::shared_ptr<Database> database_;
+    sqlite3_stmt* stmt_;
+    uint64_t generation_{0};
+};
+
+} // namespace threadforge::sqlite
@@ -0,0 +1,537 @@
+#include "SqliteBindings.h"
+
+#include <algorithm>
+#include <cmath>
+#include <jsi/jsi.h>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BindingHelpers.h"
+#include "KernelRegistry.h"
+#include "PackedTable.h"
+#include "Sqlite.h"
+#include "TypedArrayView.h"
+#include "nlohmann/json.hpp"
+
+namespace threadforge {
+
+namespace {
+
+std::mutex gDirectoryMutex;
+std::string gDirectory;
+
+} // namespace
+
+void setSqliteDatabaseDirectory(const std::string& directory) {
+    std::lock_guard<std::mutex> lock(gDirectoryMutex);
+    gDirectory = directory;
+}
+
+std::string resolveSqlitePath(const std::string& name) {
+    if (name == ":memory:" || (!name.empty() && name[0] == '/')) {
+        return name;
+    }
+    if (name.empty()) {
+        throw std::invalid_argument("database name is empty");
+    }
+    // Relative names stay inside the directory.
+    for (size_t start = 0; start <= name.size();) {
+        const size_t end = std::min(name.find('/', start), name.size());
+        if (name.compare(start, end - start, "..") == 0) {
+            throw std::invalid_argument("database name '" + name + "' leaves the database directory");
+        }
+        start = end + 1;
+    }
+    std::lock_guard<std::mutex> lock(gDirectoryMutex);
+    if (gDirectory.empty()) {
+        throw std::invalid_argument("no database directory is set; open '" + name + "' by absolute path");
+    }
+    return gDirectory.back() == '/' ? gDirectory + name : gDirectory + "/" + name;
+}
+
+#if THREADFORGE_SQLITE
+
+namespace {
+
+using facebook::jsi::Array;
+using facebook::jsi::Function;
+using facebook::jsi::HostFunctionType;
+using facebook::jsi::JSError;
+using facebook::jsi::Object;
+using facebook::jsi::PropNameID;
+using facebook::jsi::Runtime;
+using facebook::jsi::String;
+using facebook::jsi::Value;
+
+// Rows fetched per cursor.next() call unless the caller asks otherwise.
+constexpr size_t kDefaultCursorBatch = 256;
+// Whole numbers up to this magnitude bind as integers.
+constexpr double kMaxSafeInteger = 9007199254740991.0;
+
+// setFunction() for SQLite calls: their errors become JS errors too.
+void setSqliteFunction(Runtime& rt, Object& target, const char* name, unsigned length, HostFunctionType body) {
+    setFunction(rt,
+                target,
+                name,
+                length,
+                [body = std::move(body)](Runtime& runtime, const Value& thisValue, const Value* args, size_t count) {
+                    try {
+                        return body(runtime, thisValue, args, count);
+                    } catch (const sqlite::Error& ex) {
+                        throw JSError(runtime, ex.what());
+                    }
+                });
+}
+
+void bindValue(Runtime& rt, sqlite::Statement& statement, int index, const Value& value) {
+    if (value.isUndefined() || value.isNull()) {
+        statement.bindNull(index);
+    } else if (value.isBool()) {
+        statement.bindInt64(index, value.getBool() ? 1 : 0);
+    } else if (value.isNumber()) {
+        const double number = value.getNumber();
+        if (std::trunc(number) == number && std::fabs(number) <= kMaxSafeInteger) {
+            statement.bindInt64(index, static_cast<int64_t>(number));
+        } else {
+            statement.bindDouble(index, number);
+        }
+    } else if (value.isString()) {
+        const auto text = value.getString(rt).utf8(rt);
+        statement.bindText(index, text.data(), text.size());
+    } else if (value.isObject()) {
+        const auto view = typedArrayView(rt, value);
+        if (view.valid()) {
+            statement.bindBlob(index, view.data, view.length * typedArrayElementSize(view.type));
+            return;
+        }
+        const auto object = value.getObject(rt);
+        if (!object.isArrayBuffer(rt)) {
+            throw std::invalid_argument("parameter " + std::to_string(index) +
+                                        " must be a number, string, boolean, null, typed array or ArrayBuffer");
+        }
+        const auto buffer = object.getArrayBuffer(rt);
+        statement.bindBlob(index, buffer.data(rt), buffer.size(rt));
+    } else {
+        throw std::invalid_argument("parameter " + std::to_string(index) + " has an unsupported type");
+    }
+}
+
+// Rewinds statement and binds params: an array (positional), an object
+// (named) or undefined.
+void bindParams(Runtime& rt, sqlite::Statement& statement, const Value& params) {
+    statement.reset();
+    statement.clearBindings();
+    if (params.isUndefined() || params.isNull()) {
+        return;
+    }
+    if (!params.isObject()) {
+        throw std::invalid_argument("parameters must be an array or an object");
+    }
+    const auto object = params.getObject(rt);
+    if (object.isArray(rt)) {
+        const auto values = object.getArray(rt);
+        const size_t count = values.size(rt);
+        if (count > static_cast<size_t>(statement.parameterCount())) {
+            throw std::invalid_argument(std::to_string(count) + " parameters given, the statement takes " +
+                                        std::to_string(statement.parameterCount()));
+        }
+        for (size_t i = 0; i < count; ++i) {
+            bindValue(rt, statement, static_cast<int>(i + 1), values.getValueAtIndex(rt, i));
+        }
+        return;
+    }
+    const auto names = object.getPropertyNames(rt);
+    for (size_t i = 0; i < names.size(rt); ++i) {
+        const auto name = names.getValueAtIndex(rt, i).getString(rt).utf8(rt);
+        const int index = statement.parameterIndex(name);
+        if (index == 0) {
+            throw std::invalid_argument("the statement has no parameter named '" + name + "'");
+        }
+        bindValue(rt, statement, index, object.getProperty(rt, name.c_str()));
+    }
+}
+
+Value columnValue(Runtime& rt, const sqlite::Statement& statement, int column) {
+    switch (statement.columnType(column)) {
+    case sqlite::ValueType::INTEGER:
+        return Value(static_cast<double>(statement.columnInt64(column)));
+    case sqlite::ValueType::FLOAT:
+        return Value(statement.columnDouble(column));
+    case sqlite::ValueType::TEXT: {
+        const auto text = statement.columnText(column);
+        return Value(String::createFromUtf8(rt, reinterpret_cast<const uint8_t*>(text.data()), text.size()));
+    }
+    case sqlite::ValueType::BLOB: {
+        const auto [data, size] = statement.columnBlob(column);
+        TypedArrayView view;
+        auto array = makeTypedArray(rt, "Uint8Array", size, view);
+        std::copy(data, data + size, view.data);
+        return array;
+    }
+    case sqlite::ValueType::NUL:
+        break;
+    }
+    return Value::null();
+}
+
+// Column names of a statement, made once per call and reused for every row.
+std::vector<PropNameID> columnNames(Runtime& rt, const sqlite::Statement& statement) {
+    std::vector<PropNameID> names;
+    for (int c = 0; c < statement.columnCount(); ++c) {
+        names.push_back(PropNameID::forUtf8(rt, statement.columnName(c)));
+    }
+    return names;
+}
+
+Object readRow(Runtime& rt, const sqlite::Statement& statement, const std::vector<PropNameID>& names) {
+    Object row(rt);
+    for (size_t c = 0; c < names.size(); ++c) {
+        row.setProperty(rt, names[c], columnValue(rt, statement, static_cast<int>(c)));
+    }
+    return row;
+}
+
+Array toArray(Runtime& rt, std::vector<Value>& values) {
+    Array array(rt, values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        array.setValueAtIndex(rt, i, std::move(values[i]));
+    }
+    return array;
+}
+
+// Undoes the innermost transaction level while an error is already on its way
+// out; a failing rollback must not replace that error.
+void rollbackQuietly(sqlite::Database& database) {
+    try {
+        if (database.isOpen()) {
+            database.rollback();
+        }
+    } catch (const sqlite::Error&) {
+    }
+}
+
+Object runResult(Runtime& rt, int64_t changes, const sqlite::Database& database) {
+    Object result(rt);
+    result.setProperty(rt, "changes", static_cast<double>(changes));
+    result.setProperty(rt, "lastInsertRowId", static_cast<double>(database.lastInsertRowId()));
+    return result;
+}
+
+Value runStatement(Runtime& rt, sqlite::Statement& statement, const Value& params) {
+    bindParams(rt, statement, params);
+    while (statement.step()) {
+    }
+    const int64_t changes = statement.readOnly() ? 0 : statement.database()->changes();
+    statement.reset();
+    return runResult(rt, changes, *statement.database());
+}
+
+Value allRows(Runtime& rt, sqlite::Statement& statement, const Value& params) {
+    bindParams(rt, statement, params);
+    const auto names = columnNames(rt, statement);
+    std::vector<Value> rows;
+    while (statement.step()) {
+        rows.emplace_back(readRow(rt, statement, names));
+    }
+    statement.reset();
+    return toArray(rt, rows);
+}
+
+Value firstRow(Runtime& rt, sqlite::Statement& statement, const Value& params) {
+    bindParams(rt, statement, params);
+    Value row = statement.step() ? Value(readRow(rt, statement, columnNames(rt, statement))) : Value::undefined();
+    statement.reset();
+    return row;
+}
+
+struct CursorState {
+    std::shared_ptr<sqlite::Statement> statement;
+    uint64_t generation{0};
+    bool done{false};
+};
+
+Object makeCursor(Runtime& rt, const std::shared_ptr<sqlite::Statement>& statement, const Value& params) {
+    bindParams(rt, *statement, params);
+    auto state = std::make_shared<CursorState>();
+    state->statement = statement;
+    state->generation = statement->generation();
+
+    Object cursor(rt);
+    setSqliteFunction(rt, cursor, "next", 1, [state](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto& limit = argumentAt(args, count, 0);
+        const size_t batch = limit.isNumber() && limit.getNumber() >= 1 ? static_cast<size_t>(limit.getNumber())
+                                                                         : kDefaultCursorBatch;
+        std::vector<Value> rows;
+        if (!state->done) {
+            auto& statement = *state->statement;
+            if (statement.generation() != state->generation) {
+                throw JSError(runtime, "cursor is stale: its statement ran again");
+            }
+            const auto names = columnNames(runtime, statement);
+            while (rows.size() < batch) {
+                if (!statement.step()) {
+                    // Finished: release the statement's read lock.
+                    state->done = true;
+                    statement.reset();
+                    break;
+                }
+                rows.emplace_back(readRow(runtime, statement, names));
+            }
+        }
+        return Value(toArray(runtime, rows));
+    });
+    setSqliteFunction(rt, cursor, "close", 0, [state](Runtime&, const Value&, const Value*, size_t) {
+        if (!state->done && state->statement->generation() == state->generation) {
+            state->statement->reset();
+        }
+        state->done = true;
+        return Value::undefined();
+    });
+    return cursor;
+}
+
+Object makeStatement(Runtime& rt, std::shared_ptr<sqlite::Statement> statement) {
+    Object object(rt);
+
+    setSqliteFunction(rt, object, "run", 1, [statement](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        return runStatement(runtime, *statement, argumentAt(args, count, 0));
+    });
+
+    setSqliteFunction(
+        rt, object, "runBatch", 1, [statement](Runtime& runtime, const Value&, const Value* args, size_t count) {
+            const auto& input = argumentAt(args, count, 0);
+            if (!input.isObject() || !input.getObject(runtime).isArray(runtime)) {
+                throw JSError(runtime, "runBatch expects an array of parameter arrays or objects");
+            }
+            const auto batch = input.getObject(runtime).getArray(runtime);
+            auto& database = *statement->database();
+            const int64_t before = database.totalChanges();
+            database.begin();
+            try {
+                for (size_t i = 0; i < batch.size(runtime); ++i) {
+                    bindParams(runtime, *statement, batch.getValueAtIndex(runtime, i));
+                    while (statement->step()) {
+                    }
+                }
+                statement->reset();
+                database.commit();
+            } catch (...) {
+                statement->reset();
+                rollbackQuietly(database);
+                throw;
+            }
+            return Value(runResult(runtime, database.totalChanges() - before, database));
+        });
+
+    setSqliteFunction(rt, object, "all", 1, [statement](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        return allRows(runtime, *statement, argumentAt(args, count, 0));
+    });
+
+    setSqliteFunction(rt, object, "get", 1, [statement](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        return firstRow(runtime, *statement, argumentAt(args, count, 0));
+    });
+
+    setSqliteFunction(
+        rt, object, "iterate", 1, [statement](Runtime& runtime, const Value&, const Value* args, size_t count) {
+            return Value(makeCursor(runtime, statement, argumentAt(args, count, 0)));
+        });
+
+    setSqliteFunction(rt, object, "columns", 0, [statement](Runtime& runtime, const Value&, const Value*, size_t) {
+        Array names(runtime, static_cast<size_t>(statement->columnCount()));
+        for (int c = 0; c < statement->columnCount(); ++c) {
+            names.setValueAtIndex(runtime, static_cast<size_t>(c), String::createFromUtf8(runtime, statement->columnName(c)));
+        }
+        return Value(std::move(names));
+    });
+
+    setSqliteFunction(rt, object, "finalize", 0, [statement](Runtime&, const Value&, const Value*, size_t) {
+        statement->finalize();
+        return Value::undefined();
+    });
+    return object;
+}
+
+std::string sqlArgument(Runtime& rt, const Value* args, size_t count, const char* method) {
+    const auto& sql = argumentAt(args, count, 0);
+    if (!sql.isString()) {
+        throw JSError(rt, std::string(method) + " expects an SQL string");
+    }
+    return sql.getString(rt).utf8(rt);
+}
+
+Object makeDatabase(Runtime& rt, std::shared_ptr<sqlite::Database> database, const std::string& path) {
+    Object object(rt);
+    object.setProperty(rt, "path", String::createFromUtf8(rt, path));
+
+    setSqliteFunction(rt, object, "exec", 1, [database](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        database->exec(sqlArgument(runtime, args, count, "exec"));
+        return Value::undefined();
+    });
+
+    setSqliteFunction(rt, object, "prepare", 1, [database](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        return Value(makeStatement(runtime, database->prepare(sqlArgument(runtime, args, count, "prepare"))));
+    });
+
+    // One-shot forms of prepare(sql).run / all / get.
+    setSqliteFunction(rt, object, "run", 2, [database](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto statement = database->prepare(sqlArgument(runtime, args, count, "run"));
+        return runStatement(runtime, *statement, argumentAt(args, count, 1));
+    });
+    setSqliteFunction(rt, object, "all", 2, [database](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto statement = database->prepare(sqlArgument(runtime, args, count, "all"));
+        return allRows(runtime, *statement, argumentAt(args, count, 1));
+    });
+    setSqliteFunction(rt, object, "get", 2, [database](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto statement = database->prepare(sqlArgument(runtime, args, count, "get"));
+        return firstRow(runtime, *statement, argumentAt(args, count, 1));
+    });
+
+    setSqliteFunction(
+        rt, object, "transaction", 1, [database](Runtime& runtime, const Value&, const Value* args, size_t count) {
+            const auto& callback = argumentAt(args, count, 0);
+            if (!callback.isObject() || !callback.getObject(runtime).isFunction(runtime)) {
+                throw JSError(runtime, "transaction expects a function");
+            }
+            database->begin();
+            try {
+                auto result = callback.getObject(runtime).getFunction(runtime).call(runtime);
+                database->commit();
+                return result;
+            } catch (...) {
+                rollbackQuietly(*database);
+                throw;
+            }
+        });
+
+    setSqliteFunction(rt, object, "close", 0, [database](Runtime&, const Value&, const Value*, size_t) {
+        database->close();
+        return Value::undefined();
+    });
+    return object;
+}
+
+void bindJson(sqlite::Statement& statement, int index, const nlohmann::json& value) {
+    if (value.is_null()) {
+        statement.bindNull(index);
+    } else if (value.is_boolean()) {
+        statement.bindInt64(index, value.get<bool>() ? 1 : 0);
+    } else if (value.is_number_integer()) {
+        statement.bindInt64(index, value.get<int64_t>());
+    } else if (value.is_number()) {
+        statement.bindDouble(index, value.get<double>());
+    } else if (value.is_string()) {
+        const auto& text = value.get_ref<const std::string&>();
+        statement.bindText(index, text.data(), text.size());
+    } else {
+        throw std::invalid_argument("parameter " + std::to_string(index) + " must be a number, string, boolean or null");
+    }
+}
+
+TaskResult runQueryKernel(const std::string& argsJson, const ProgressCallback&, const std::function<bool()>& isCancelled) {
+    const auto args = nlohmann::json::parse(argsJson, nullptr, false);
+    if (!args.is_object() || !args.contains("database") || !args["database"].is_string() || !args.contains("sql") ||
+        !args["sql"].is_string()) {
+        return makeErrorResult("sqlite.query expects { database, sql, params? }");
+    }
+
+    nlohmann::json result;
+    try {
+        const auto database =
+            sqlite::Database::open(resolveSqlitePath(args["database"].get<std::string>()), sqlite::Database::Options{});
+        const auto statement = database->prepare(args["sql"].get<std::string>());
+        const auto params = args.value("params", nlohmann::json());
+        if (params.is_array()) {
+            for (size_t i = 0; i < params.size(); ++i) {
+                bindJson(*statement, static_cast<int>(i + 1), params[i]);
+            }
+        } else if (params.is_object()) {
+            for (const auto& item : params.items()) {
+                const int index = statement->parameterIndex(item.key());
+                if (index == 0) {
+                    throw std::invalid_argument("the statement has no parameter named '" + item.key() + "'");
+                }
+                bindJson(*statement, index, item.value());
+            }
+        }
+
+        auto& columns = result["columns"] = nlohmann::json::array();
+        for (int c = 0; c < statement->columnCount(); ++c) {
+            columns.push_back(statement->columnName(c));
+        }
+        auto& rows = result["rows"] = nlohmann::json::array();
+        while (statement->step()) {
+            if (isCancelled && isCancelled()) {
+                return makeCancelledResult();
+            }
+            auto& row = rows.emplace_back(nlohmann::json::array());
+            for (int c = 0; c < statement->columnCount(); ++c) {
+                switch (statement->columnType(c)) {
+                case sqlite::ValueType::INTEGER:
+                    row.push_back(statement->columnInt64(c));
+                    break;
+                case sqlite::ValueType::FLOAT: {
+                    const double value = statement->columnDouble(c);
+                    row.push_back(std::isfinite(value) ? nlohmann::json(value) : nlohmann::json(nullptr));
+                    break;
+                }
+                case sqlite::ValueType::TEXT:
+                    row.push_back(std::string(statement->columnText(c)));
+                    break;
+                case sqlite::ValueType::BLOB: {
+                    // base64, like packed table columns.
+                    const auto [data, size] = statement->columnBlob(c);
+                    row.push_back(encodeBase64(data, size));
+                    break;
+                }
+                case sqlite::ValueType::NUL:
+                    row.push_back(nullptr);
+                    break;
+                }
+            }
+        }
+        result["changes"] = statement->readOnly() ? 0 : database->changes();
+        result["lastInsertRowId"] = database->lastInsertRowId();
+    } catch (const std::exception& ex) {
+        return makeErrorResult(std::string("sqlite.query: ") + ex.what());
+    }
+    return makeSuccessResult(result.dump());
+}
+
+THREADFORGE_REGISTER_KERNEL("sqlite.query", runQueryKernel);
+
+} // namespace
+
+void installSqliteBindings(Runtime& rt) {
+    Object nativeSqlite(rt);
+
+    setSqliteFunction(rt, nativeSqlite, "open", 2, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto& name = argumentAt(args, count, 0);
+        if (!name.isString()) {
+            throw JSError(runtime, "nativeSqlite.open expects a database name or path");
+        }
+        sqlite::Database::Options options;
+        const auto& optionsValue = argumentAt(args, count, 1);
+        if (optionsValue.isObject()) {
+            const auto object = optionsValue.getObject(runtime);
+            const auto readOnly = object.getProperty(runtime, "readOnly");
+            const auto create = object.getProperty(runtime, "create");
+            options.readOnly = readOnly.isBool() && readOnly.getBool();
+            options.create = !create.isBool() || create.getBool();
+        }
+        const auto path = resolveSqlitePath(name.getString(runtime).utf8(runtime));
+        return Value(makeDatabase(runtime, sqlite::Database::open(path, options), path));
+    });
+
+    rt.global().setProperty(rt, "nativeSqlite", nativeSqlite);
+}
+
+#else
+
+void installSqliteBindings(facebook::jsi::Runtime&) {}
+
+#endif // THREADFORGE_SQLITE
+
+} // namespace threadforge
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+
+namespace facebook::jsi {
+class Runtime;
+} // namespace facebook::jsi
+
+namespace threadforge {
+
+// Installs the global `nativeSqlite` object in a worker runtime, a front end
+// for Sqlite.h. Builds without SQLite (THREADFORGE_SQLITE=0) leave it
+// undefined.
+//
+//     const db = nativeSqlite.open('orders.db', { readOnly?, create? });
+//     db.exec('CREATE TABLE IF NOT EXISTS ...');          // scripts, no results
+//     const insert = db.prepare('INSERT INTO t VALUES (?, ?)');
+//     insert.run([1, 'a']);                                // { changes, lastInsertRowId }
+//     insert.runBatch([[2, 'b'], [3, 'c']]);               // one transaction
+//     db.prepare('SELECT * FROM t WHERE id > :min').all({ min: 1 });   // row objects
+//     const cursor = db.prepare('SELECT * FROM t').iterate();
+//     for (let rows = cursor.next(500); rows.length > 0; rows = cursor.next(500)) { ... }
+//     db.transaction(() => { ... });                       // rolls back if the callback throws
+//     db.close();
+//
+// Parameters are arrays (positional) or objects (named). Numbers bind as
+// integers when they are whole, typed arrays and ArrayBuffers as blobs.
+// Integers read back as numbers (exact up to 2^53), blobs as Uint8Array.
+// Relative paths resolve against setSqliteDatabaseDirectory().
+//
+// The "sqlite.query" kernel runs one statement for runKernel(), taking
+// { database, sql, params? } as JSON and returning { columns, rows, changes,
+// lastInsertRowId } with rows as arrays.
+void installSqliteBindings(facebook::jsi::Runtime& runtime);
+
+// Directory relative database names are resolved against; the platforms set
+// it to where react-native-sqlite-storage keeps its "default" databases.
+void setSqliteDatabaseDirectory(const std::string& directory);
+
+// directory/name for relative names, name itself for absolute paths and
+// ":memory:". Throws std::invalid_argument for names that climb out of the
+// directory or when no directory is set.
+std::string resolveSqlitePath(const std::string& name);
+
+} // namespace threadforge
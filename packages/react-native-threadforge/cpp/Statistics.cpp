@@ -0,0 +1,350 @@
+#include "Statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+#include "ParallelFor.h"
+#include "SimdVector.h"
+
+namespace threadforge::stats {
+
+namespace {
+
+constexpr double kInfinity = std::numeric_limits<double>::infinity();
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+// Four independent accumulators hide the add latency of the reductions.
+constexpr size_t kUnroll = 4;
+
+// Splits large inputs into chunks, reduces each with rangeFn and merges the
+// partial results in chunk order, so the result does not depend on scheduling.
+template <typename R, typename RangeFn, typename MergeFn>
+R reduceChunks(size_t count, R identity, RangeFn rangeFn, MergeFn merge) {
+    if (count < kParallelThreshold) {
+        return rangeFn(0, count);
+    }
+    const size_t grain = std::max<size_t>(kParallelThreshold / 4, (count + 63) / 64);
+    std::vector<R> partials((count + grain - 1) / grain, identity);
+    parallelFor(count, grain, [&](size_t begin, size_t end) {
+        partials[begin / grain] = rangeFn(begin, end);
+    });
+    R result = identity;
+    for (const auto& partial : partials) {
+        result = merge(result, partial);
+    }
+    return result;
+}
+
+template <typename T>
+double sumRange(const T* data, size_t count) {
+    constexpr size_t step = simd::kLanes * kUnroll;
+    simd::VecD acc[kUnroll] = {simd::zero(), simd::zero(), simd::zero(), simd::zero()};
+    size_t i = 0;
+    for (; i + step <= count; i += step) {
+        for (size_t u = 0; u < kUnroll; ++u) {
+            acc[u] = simd::add(acc[u], simd::load(data + i + u * simd::kLanes));
+        }
+    }
+    for (; i + simd::kLanes <= count; i += simd::kLanes) {
+        acc[0] = simd::add(acc[0], simd::load(data + i));
+    }
+    double total = simd::horizontalSum(simd::add(simd::add(acc[0], acc[1]), simd::add(acc[2], acc[3])));
+    for (; i < count; ++i) {
+        total += static_cast<double>(data[i]);
+    }
+    return total;
+}
+
+Moments mergeMoments(const Moments& a, const Moments& b) {
+    if (a.count == 0) {
+        return b;
+    }
+    if (b.count == 0) {
+        return a;
+    }
+    Moments merged;
+    merged.count = a.count + b.count;
+    const double total = static_cast<double>(merged.count);
+    const double delta = b.mean - a.mean;
+    merged.mean = a.mean + delta * static_cast<double>(b.count) / total;
+    merged.m2 = a.m2 + b.m2 + delta * delta * static_cast<double>(a.count) * static_cast<double>(b.count) / total;
+    return merged;
+}
+
+// Welford per lane (every lane has seen the same number of samples, so the
+// reciprocal is shared), then Chan's merge across lanes and a scalar tail.
+template <typename T>
+Moments momentsRange(const T* data, size_t count) {
+    simd::VecD mean = simd::zero();
+    simd::VecD m2 = simd::zero();
+    size_t perLane = 0;
+    size_t i = 0;
+    for (; i + simd::kLanes <= count; i += simd::kLanes) {
+        ++perLane;
+        const auto x = simd::load(data + i);
+        const auto delta = simd::sub(x, mean);
+        mean = simd::add(mean, simd::mul(delta, simd::broadcast(1.0 / static_cast<double>(perLane))));
+        m2 = simd::add(m2, simd::mul(delta, simd::sub(x, mean)));
+    }
+
+    Moments result;
+    if (perLane > 0) {
+        const auto means = simd::spill(mean);
+        const auto m2s = simd::spill(m2);
+        for (size_t lane = 0; lane < simd::kLanes; ++lane) {
+            result = mergeMoments(result, Moments{perLane, means.values[lane], m2s.values[lane]});
+        }
+    }
+    for (; i < count; ++i) {
+        const double x = static_cast<double>(data[i]);
+        result.count++;
+        const double delta = x - result.mean;
+        result.mean += delta / static_cast<double>(result.count);
+        result.m2 += delta * (x - result.mean);
+    }
+    return result;
+}
+
+template <typename T>
+Extrema extremaRange(const T* data, size_t count) {
+    auto low = simd::broadcast(kInfinity);
+    auto high = simd::broadcast(-kInfinity);
+    size_t i = 0;
+    for (; i + simd::kLanes <= count; i += simd::kLanes) {
+        const auto x = simd::load(data + i);
+        low = simd::min(x, low);
+        high = simd::max(x, high);
+    }
+    const auto lows = simd::spill(low);
+    const auto highs = simd::spill(high);
+    Extrema result{kInfinity, -kInfinity};
+    for (size_t lane = 0; lane < simd::kLanes; ++lane) {
+        result.min = std::min(result.min, lows.values[lane]);
+        result.max = std::max(result.max, highs.values[lane]);
+    }
+    for (; i < count; ++i) {
+        const double x = static_cast<double>(data[i]);
+        if (x < result.min) {
+            result.min = x;
+        }
+        if (x > result.max) {
+            result.max = x;
+        }
+    }
+    return result;
+}
+
+template <typename T>
+double dotRange(const T* a, const T* b, size_t count) {
+    constexpr size_t step = simd::kLanes * kUnroll;
+    simd::VecD acc[kUnroll] = {simd::zero(), simd::zero(), simd::zero(), simd::zero()};
+    size_t i = 0;
+    for (; i + step <= count; i += step) {
+        for (size_t u = 0; u < kUnroll; ++u) {
+            const size_t offset = i + u * simd::kLanes;
+            acc[u] = simd::add(acc[u], simd::mul(simd::load(a + offset), simd::load(b + offset)));
+        }
+    }
+    for (; i + simd::kLanes <= count; i += simd::kLanes) {
+        acc[0] = simd::add(acc[0], simd::mul(simd::load(a + i), simd::load(b + i)));
+    }
+    double total = simd::horizontalSum(simd::add(simd::add(acc[0], acc[1]), simd::add(acc[2], acc[3])));
+    for (; i < count; ++i) {
+        total += static_cast<double>(a[i]) * static_cast<double>(b[i]);
+    }
+    return total;
+}
+
+template <typename T>
+double sumImpl(const T* data, size_t count) {
+    return reduceChunks<double>(
+        count,
+        0.0,
+        [data](size_t begin, size_t end) {
+            return sumRange(data + begin, end - begin);
+        },
+        [](double a, double b) {
+            return a + b;
+        });
+}
+
+template <typename T>
+Moments momentsImpl(const T* data, size_t count) {
+    return reduceChunks<Moments>(
+        count,
+        Moments(),
+        [data](size_t begin, size_t end) {
+            return momentsRange(data + begin, end - begin);
+        },
+        mergeMoments);
+}
+
+template <typename T>
+Extrema extremaImpl(const T* data, size_t count) {
+    auto result = reduceChunks<Extrema>(
+        count,
+        Extrema{kInfinity, -kInfinity},
+        [data](size_t begin, size_t end) {
+            return extremaRange(data + begin, end - begin);
+        },
+        [](const Extrema& a, const Extrema& b) {
+            return Extrema{std::min(a.min, b.min), std::max(a.max, b.max)};
+        });
+    if (result.min > result.max) {
+        return Extrema{kNaN, kNaN};
+    }
+    return result;
+}
+
+template <typename T>
+double dotImpl(const T* a, const T* b, size_t count) {
+    return reduceChunks<double>(
+        count,
+        0.0,
+        [a, b](size_t begin, size_t end) {
+            return dotRange(a + begin, b + begin, end - begin);
+        },
+        [](double x, double y) {
+            return x + y;
+        });
+}
+
+template <typename T>
+std::vector<uint64_t> histogramImpl(const T* data, size_t count, double lo, double hi, size_t bins) {
+    if (bins == 0 || !(lo < hi) || !std::isfinite(lo) || !std::isfinite(hi)) {
+        throw std::invalid_argument("histogram expects bins > 0 and finite lo < hi");
+    }
+    const double scale = static_cast<double>(bins) / (hi - lo);
+    return reduceChunks<std::vector<uint64_t>>(
+        count,
+        std::vector<uint64_t>(bins, 0),
+        [=](size_t begin, size_t end) {
+            std::vector<uint64_t> counts(bins, 0);
+            for (size_t i = begin; i < end; ++i) {
+                const double x = static_cast<double>(data[i]);
+                if (!(x >= lo && x <= hi)) {
+                    continue;
+                }
+                const auto bin = static_cast<size_t>((x - lo) * scale);
+                counts[std::min(bin, bins - 1)]++;
+            }
+            return counts;
+        },
+        [](std::vector<uint64_t> a, const std::vector<uint64_t>& b) {
+            for (size_t i = 0; i < a.size(); ++i) {
+                a[i] += b[i];
+            }
+            return a;
+        });
+}
+
+template <typename T>
+std::vector<double> percentilesImpl(const T* data, size_t count, const std::vector<double>& ranks) {
+    for (const double rank : ranks) {
+        if (!(rank >= 0.0 && rank <= 100.0)) {
+            throw std::invalid_argument("percentiles must be between 0 and 100");
+        }
+    }
+
+    std::vector<double> values;
+    values.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const double x = static_cast<double>(data[i]);
+        if (!std::isnan(x)) {
+            values.push_back(x);
+        }
+    }
+    std::vector<double> results(ranks.size(), kNaN);
+    if (values.empty()) {
+        return results;
+    }
+
+    // Visit ranks in ascending order so every selection only has to look at the
+    // part of the array right of the previous one.
+    std::vector<size_t> order(ranks.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&ranks](size_t a, size_t b) {
+        return ranks[a] < ranks[b];
+    });
+    auto first = values.begin();
+    for (const size_t index : order) {
+        const double position = ranks[index] / 100.0 * static_cast<double>(values.size() - 1);
+        const auto lower = static_cast<size_t>(position);
+        const double fraction = position - static_cast<double>(lower);
+        const auto nth = values.begin() + static_cast<std::ptrdiff_t>(lower);
+        std::nth_element(first, nth, values.end());
+        first = nth;
+        double value = *nth;
+        if (fraction > 0.0 && nth + 1 != values.end()) {
+            // Everything right of nth is >= it, so the next order statistic is their minimum.
+            const double upper = *std::min_element(nth + 1, values.end());
+            value += fraction * (upper - value);
+        }
+        results[index] = value;
+    }
+    return results;
+}
+
+} // namespace
+
+double Moments::variance() const {
+    return count > 0 ? m2 / static_cast<double>(count) : kNaN;
+}
+
+double Moments::sampleVariance() const {
+    return count > 1 ? m2 / static_cast<double>(count - 1) : kNaN;
+}
+
+double sum(const double* data, size_t count) {
+    return sumImpl(data, count);
+}
+
+double sum(const float* data, size_t count) {
+    return sumImpl(data, count);
+}
+
+Moments moments(const double* data, size_t count) {
+    return momentsImpl(data, count);
+}
+
+Moments moments(const float* data, size_t count) {
+    return momentsImpl(data, count);
+}
+
+Extrema extrema(const double* data, size_t count) {
+    return extremaImpl(data, count);
+}
+
+Extrema extrema(const float* data, size_t count) {
+    return extremaImpl(data, count);
+}
+
+double dot(const double* a, const double* b, size_t count) {
+    return dotImpl(a, b, count);
+}
+
+double dot(const float* a, const float* b, size_t count) {
+    return dotImpl(a, b, count);
+}
+
+std::vector<uint64_t> histogram(const double* data, size_t count, double lo, double hi, size_t bins) {
+    return histogramImpl(data, count, lo, hi, bins);
+}
+
+std::vector<uint64_t> histogram(const float* data, size_t count, double lo, double hi, size_t bins) {
+    return histogramImpl(data, count, lo, hi, bins);
+}
+
+std::vector<double> percentiles(const double* data, size_t count, const std::vector<double>& ranks) {
+    return percentilesImpl(data, count, ranks);
+}
+
+std::vector<double> percentiles(const float* data, size_t count, const std::vector<double>& ranks) {
+    return percentilesImpl(data, count, ranks);
+}
+
+} // namespace threadforge::stats
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace threadforge::stats {
+
+// Vectorized reductions over contiguous float64/float32 samples (see
+// SimdVector.h for the backends). float32 input is accumulated in double.
+// Inputs of kParallelThreshold samples or more are split across the shared
+// pool with parallelFor().
+//
+// Lanes and chunks change the order of additions, so sums differ from a
+// sequential loop by at most about n * 2^-53 * sum(|x|); with well-scaled data
+// that is a relative error below 1e-12. min/max, histogram and percentiles are
+// exact. NaN propagates into sum, moments and dot and is skipped by the others.
+
+constexpr size_t kParallelThreshold = 1 << 16;
+
+// Running mean and sum of squared deviations (Welford), merged across lanes
+// and chunks with Chan's formula.
+struct Moments {
+    size_t count{0};
+    double mean{0.0};
+    double m2{0.0};
+
+    // Population variance (divides by count), matching sumOfSquares/n - mean^2.
+    double variance() const;
+    // Divides by count - 1.
+    double sampleVariance() const;
+};
+
+// NaN for both when there are no non-NaN samples.
+struct Extrema {
+    double min;
+    double max;
+};
+
+double sum(const double* data, size_t count);
+double sum(const float* data, size_t count);
+
+Moments moments(const double* data, size_t count);
+Moments moments(const float* data, size_t count);
+
+Extrema extrema(const double* data, size_t count);
+Extrema extrema(const float* data, size_t count);
+
+double dot(const double* a, const double* b, size_t count);
+double dot(const float* a, const float* b, size_t count);
+
+// bins equal-width buckets over [lo, hi]. hi itself lands in the last bucket;
+// values outside the range and NaN are not counted. Throws
+// std::invalid_argument unless bins > 0 and lo < hi.
+std::vector<uint64_t> histogram(const double* data, size_t count, double lo, double hi, size_t bins);
+std::vector<uint64_t> histogram(const float* data, size_t count, double lo, double hi, size_t bins);
+
+// Percentiles in [0, 100] with linear interpolation between closest ranks (the
+// numpy default). NaN samples are ignored; with no samples every result is NaN.
+// Throws std::invalid_argument for a percentile outside [0, 100].
+std::vector<double> percentiles(const double* data, size_t count, const std::vector<double>& ranks);
+std::vector<double> percentiles(const float* data, size_t count, const std::vector<double>& ranks);
+
+} // namespace threadforge::stats
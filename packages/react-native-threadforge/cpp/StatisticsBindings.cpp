@@ -0,0 +1,251 @@
+#include "StatisticsBindings.h"
+
+#include <cmath>
+#include <jsi/jsi.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BindingHelpers.h"
+#include "KernelRegistry.h"
+#include "SimdVector.h"
+#include "Statistics.h"
+#include "TypedArrayView.h"
+#include "nlohmann/json.hpp"
+
+namespace threadforge {
+
+namespace {
+
+using facebook::jsi::Array;
+using facebook::jsi::JSError;
+using facebook::jsi::Object;
+using facebook::jsi::Runtime;
+using facebook::jsi::String;
+using facebook::jsi::Value;
+
+// Typed arrays are read in place (see FloatArrayView); plain arrays are copied.
+struct Samples {
+    const double* f64{nullptr};
+    const float* f32{nullptr};
+    size_t count{0};
+    std::vector<double> copy;
+
+    template <typename Fn>
+    auto visit(Fn&& fn) const {
+        if (f64) {
+            return fn(f64);
+        }
+        if (f32) {
+            return fn(f32);
+        }
+        return fn(copy.data());
+    }
+
+    std::vector<double> toDoubles() const {
+        return visit([this](const auto* data) {
+            return std::vector<double>(data, data + count);
+        });
+    }
+};
+
+Samples readSamples(Runtime& rt, const Value& value, const char* function) {
+    Samples samples;
+    if (value.isObject() && value.getObject(rt).isArray(rt)) {
+        auto array = value.getObject(rt).getArray(rt);
+        samples.count = array.size(rt);
+        samples.copy.reserve(samples.count);
+        for (size_t i = 0; i < samples.count; ++i) {
+            const auto item = array.getValueAtIndex(rt, i);
+            samples.copy.push_back(item.isNumber() ? item.getNumber() : NAN);
+        }
+        return samples;
+    }
+    const auto view = floatArrayView(rt, value);
+    if (view.valid()) {
+        samples.f64 = view.f64;
+        samples.f32 = view.f32;
+        samples.count = view.count;
+        return samples;
+    }
+    throw JSError(rt, std::string("nativeStats.") + function + " expects a Float64Array, Float32Array or array of numbers");
+}
+
+std::vector<double> readNumbers(Runtime& rt, const Value& value, const char* function) {
+    if (!value.isObject() || !value.getObject(rt).isArray(rt)) {
+        throw JSError(rt, std::string("nativeStats.") + function + " expects an array of numbers");
+    }
+    auto array = value.getObject(rt).getArray(rt);
+    std::vector<double> numbers;
+    numbers.reserve(array.size(rt));
+    for (size_t i = 0; i < array.size(rt); ++i) {
+        numbers.push_back(array.getValueAtIndex(rt, i).asNumber());
+    }
+    return numbers;
+}
+
+template <typename T>
+Array toArray(Runtime& rt, const std::vector<T>& values) {
+    Array array(rt, values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        array.setValueAtIndex(rt, i, Value(static_cast<double>(values[i])));
+    }
+    return array;
+}
+
+Object momentsObject(Runtime& rt, const stats::Moments& moments) {
+    Object result(rt);
+    const double variance = moments.variance();
+    result.setProperty(rt, "count", static_cast<double>(moments.count));
+    result.setProperty(rt, "mean", moments.count > 0 ? moments.mean : NAN);
+    result.setProperty(rt, "variance", variance);
+    result.setProperty(rt, "sampleVariance", moments.sampleVariance());
+    result.setProperty(rt, "stdDev", std::sqrt(variance));
+    return result;
+}
+
+stats::Extrema extremaOf(const Samples& samples) {
+    return samples.visit([&samples](const auto* data) {
+        return stats::extrema(data, samples.count);
+    });
+}
+
+nlohmann::json finiteOrNull(double value) {
+    return std::isfinite(value) ? nlohmann::json(value) : nlohmann::json(nullptr);
+}
+
+TaskResult runSummaryKernel(const std::string& argsJson,
+                            const ProgressCallback&,
+                            const std::function<bool()>& isCancelled) {
+    const auto args = nlohmann::json::parse(argsJson, nullptr, false);
+    if (!args.is_object() || !args.contains("values") || !args["values"].is_array()) {
+        return makeErrorResult("stats.summary expects { values: number[] }");
+    }
+    std::vector<double> values;
+    values.reserve(args["values"].size());
+    for (const auto& item : args["values"]) {
+        values.push_back(item.is_number() ? item.get<double>() : NAN);
+    }
+    if (isCancelled()) {
+        return makeCancelledResult();
+    }
+
+    const auto moments = stats::moments(values.data(), values.size());
+    const auto extrema = stats::extrema(values.data(), values.size());
+    nlohmann::json result;
+    result["count"] = moments.count;
+    result["sum"] = finiteOrNull(stats::sum(values.data(), values.size()));
+    result["mean"] = finiteOrNull(moments.count > 0 ? moments.mean : NAN);
+    result["variance"] = finiteOrNull(moments.variance());
+    result["sampleVariance"] = finiteOrNull(moments.sampleVariance());
+    result["stdDev"] = finiteOrNull(std::sqrt(moments.variance()));
+    result["min"] = finiteOrNull(extrema.min);
+    result["max"] = finiteOrNull(extrema.max);
+
+    try {
+        if (args.contains("percentiles")) {
+            const auto ranks = args["percentiles"].get<std::vector<double>>();
+            result["percentiles"] = nlohmann::json::array();
+            for (const double value : stats::percentiles(values.data(), values.size(), ranks)) {
+                result["percentiles"].push_back(finiteOrNull(value));
+            }
+        }
+        if (args.contains("bins") && std::isfinite(extrema.min)) {
+            const auto bins = args["bins"].get<size_t>();
+            const double lo = args.value("min", extrema.min);
+            const double hi = args.value("max", extrema.max > lo ? extrema.max : lo + 1.0);
+            result["histogram"] = stats::histogram(values.data(), values.size(), lo, hi, bins);
+        }
+    } catch (const std::exception& ex) {
+        return makeErrorResult(std::string("stats.summary: ") + ex.what());
+    }
+    return makeSuccessResult(result.dump());
+}
+
+THREADFORGE_REGISTER_KERNEL("stats.summary", runSummaryKernel);
+
+} // namespace
+
+void installStatisticsBindings(Runtime& rt) {
+    Object nativeStats(rt);
+    nativeStats.setProperty(rt, "backend", String::createFromAscii(rt, simd::kBackend));
+
+    setFunction(rt, nativeStats, "sum", 1, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto samples = readSamples(runtime, argumentAt(args, count, 0), "sum");
+        return Value(samples.visit([&samples](const auto* data) {
+            return stats::sum(data, samples.count);
+        }));
+    });
+
+    setFunction(rt, nativeStats, "moments", 1, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto samples = readSamples(runtime, argumentAt(args, count, 0), "moments");
+        const auto moments = samples.visit([&samples](const auto* data) {
+            return stats::moments(data, samples.count);
+        });
+        return Value(momentsObject(runtime, moments));
+    });
+
+    setFunction(rt, nativeStats, "minMax", 1, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto extrema = extremaOf(readSamples(runtime, argumentAt(args, count, 0), "minMax"));
+        Object result(runtime);
+        result.setProperty(runtime, "min", extrema.min);
+        result.setProperty(runtime, "max", extrema.max);
+        return Value(std::move(result));
+    });
+
+    setFunction(rt, nativeStats, "dot", 2, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto a = readSamples(runtime, argumentAt(args, count, 0), "dot");
+        const auto b = readSamples(runtime, argumentAt(args, count, 1), "dot");
+        if (a.count != b.count) {
+            throw JSError(runtime, "nativeStats.dot expects arrays of the same length");
+        }
+        if (a.f64 && b.f64) {
+            return Value(stats::dot(a.f64, b.f64, a.count));
+        }
+        if (a.f32 && b.f32) {
+            return Value(stats::dot(a.f32, b.f32, a.count));
+        }
+        const auto left = a.toDoubles();
+        const auto right = b.toDoubles();
+        return Value(stats::dot(left.data(), right.data(), left.size()));
+    });
+
+    setFunction(rt, nativeStats, "histogram", 4, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto samples = readSamples(runtime, argumentAt(args, count, 0), "histogram");
+        const auto& binsArg = argumentAt(args, count, 1);
+        if (!binsArg.isNumber() || binsArg.getNumber() < 1) {
+            throw JSError(runtime, "nativeStats.histogram expects a positive bin count");
+        }
+        const auto bins = static_cast<size_t>(binsArg.getNumber());
+        const auto& minArg = argumentAt(args, count, 2);
+        const auto& maxArg = argumentAt(args, count, 3);
+        double lo = minArg.isNumber() ? minArg.getNumber() : NAN;
+        double hi = maxArg.isNumber() ? maxArg.getNumber() : NAN;
+        if (std::isnan(lo) || std::isnan(hi)) {
+            // Default to the data's range; a constant input gets a unit-wide range.
+            const auto extrema = extremaOf(samples);
+            if (std::isnan(extrema.min)) {
+                return Value(toArray(runtime, std::vector<uint64_t>(bins, 0)));
+            }
+            lo = std::isnan(lo) ? extrema.min : lo;
+            hi = std::isnan(hi) ? (extrema.max > lo ? extrema.max : lo + 1.0) : hi;
+        }
+        const auto counts = samples.visit([&](const auto* data) {
+            return stats::histogram(data, samples.count, lo, hi, bins);
+        });
+        return Value(toArray(runtime, counts));
+    });
+
+    setFunction(rt, nativeStats, "percentiles", 2, [](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto samples = readSamples(runtime, argumentAt(args, count, 0), "percentiles");
+        const auto ranks = readNumbers(runtime, argumentAt(args, count, 1), "percentiles");
+        const auto values = samples.visit([&](const auto* data) {
+            return stats::percentiles(data, samples.count, ranks);
+        });
+        return Value(toArray(runtime, values));
+    });
+
+    rt.global().setProperty(rt, "nativeStats", nativeStats);
+}
+
+} // namespace threadforge
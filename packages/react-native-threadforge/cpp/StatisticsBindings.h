@@ -0,0 +1,25 @@
+#pragma once
+
+namespace facebook::jsi {
+class Runtime;
+} // namespace facebook::jsi
+
+namespace threadforge {
+
+// Installs the global `nativeStats` object in a worker runtime. Its functions
+// read Float64Array/Float32Array samples in place (plain number arrays are
+// copied) and run the reductions from Statistics.h:
+//
+//     nativeStats.sum(values)
+//     nativeStats.moments(values)            // { count, mean, variance, sampleVariance, stdDev }
+//     nativeStats.minMax(values)             // { min, max }
+//     nativeStats.dot(a, b)
+//     nativeStats.histogram(values, bins, min?, max?)
+//     nativeStats.percentiles(values, [50, 90, 99])
+//     nativeStats.backend                    // "avx" | "sse2" | "neon" | "scalar"
+//
+// The same reductions are registered as the "stats.summary" kernel for
+// runKernel(), taking { values, percentiles?, bins? } as JSON.
+void installStatisticsBindings(facebook::jsi::Runtime& runtime);
+
+} // namespace threadforge
@@ -0,0 +1,426 @@
+#include "TaskJournal.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace threadforge {
+
+namespace {
+
+constexpr char kMagic[4] = {'T', 'F', 'J', '1'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 16;
+constexpr size_t kEndOffset = 8;
+constexpr size_t kRecordHeaderSize = sizeof(uint32_t) + sizeof(uint8_t);
+constexpr size_t kInitialSize = 64 * 1024;
+constexpr size_t kCompactionThreshold = 256 * 1024;
+
+constexpr uint8_t kEnqueueRecord = 1;
+constexpr uint8_t kCompleteRecord = 2;
+
+void appendU32(std::string& out, uint32_t value) {
+    char bytes[sizeof(value)];
+    std::memcpy(bytes, &value, sizeof(value));
+    out.append(bytes, sizeof(value));
+}
+
+void appendString(std::string& out, const std::string& value) {
+    appendU32(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+bool readU32(const uint8_t* data, size_t size, size_t& offset, uint32_t& value) {
+    if (offset + sizeof(value) > size) {
+        return false;
+    }
+    std::memcpy(&value, data + offset, sizeof(value));
+    offset += sizeof(value);
+    return true;
+}
+
+bool readString(const uint8_t* data, size_t size, size_t& offset, std::string& value) {
+    uint32_t length = 0;
+    if (!readU32(data, size, offset, length) || offset + length > size) {
+        return false;
+    }
+    value.assign(reinterpret_cast<const char*>(data + offset), length);
+    offset += length;
+    return true;
+}
+
+std::string encodeEnqueue(const JournalEntry& entry) {
+    std::string body;
+    body.reserve(entry.taskId.size() + entry.payload.size() + 3 * sizeof(uint32_t));
+    appendString(body, entry.taskId);
+    appendU32(body, static_cast<uint32_t>(entry.priority));
+    appendString(body, entry.payload);
+    return body;
+}
+
+std::string encodeComplete(const std::string& taskId) {
+    std::string body;
+    appendString(body, taskId);
+    return body;
+}
+
+size_t roundUpCapacity(size_t required) {
+    size_t capacity = kInitialSize;
+    while (capacity < required) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+} // namespace
+
+TaskJournal::TaskJournal(std::string path)
+    : path_(std::move(path)) {}
+
+TaskJournal::~TaskJournal() {
+    close();
+}
+
+bool TaskJournal::open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (data_) {
+        return true;
+    }
+
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd_ < 0) {
+        return false;
+    }
+
+    struct stat info {};
+    if (fstat(fd_, &info) != 0) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    const auto existingSize = static_cast<size_t>(info.st_size);
+    if (!mapFileLocked(std::max(existingSize, kInitialSize))) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    const bool valid = existingSize >= kHeaderSize &&
+        std::memcmp(data_, kMagic, sizeof(kMagic)) == 0 &&
+        std::memcmp(data_ + sizeof(kMagic), &kVersion, sizeof(kVersion)) == 0;
+    if (!valid) {
+        std::memset(data_, 0, kHeaderSize);
+        std::memcpy(data_, kMagic, sizeof(kMagic));
+        std::memcpy(data_ + sizeof(kMagic), &kVersion, sizeof(kVersion));
+        setCommittedEndLocked(kHeaderSize);
+    }
+
+    scanLocked();
+    maybeCompactLocked();
+    return data_ != nullptr;
+}
+
+void TaskJournal::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    unmapLocked();
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    live_.clear();
+    liveBytes_ = 0;
+    deadBytes_ = 0;
+}
+
+bool TaskJournal::append(const JournalEntry& entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!data_) {
+        return false;
+    }
+
+    auto existing = live_.find(entry.taskId);
+    if (existing != live_.end()) {
+        // A task id is only ever live once; the newer descriptor supersedes the old one.
+        if (!writeRecordLocked(kCompleteRecord, encodeComplete(entry.taskId))) {
+            return false;
+        }
+        liveBytes_ -= existing->second.bytes;
+        deadBytes_ += existing->second.bytes + kRecordHeaderSize + sizeof(uint32_t) + entry.taskId.size();
+        live_.erase(existing);
+    }
+
+    const auto body = encodeEnqueue(entry);
+    if (!writeRecordLocked(kEnqueueRecord, body)) {
+        return false;
+    }
+
+    LiveRecord record;
+    record.entry = entry;
+    record.order = nextOrder_++;
+    record.bytes = kRecordHeaderSize + body.size();
+    liveBytes_ += record.bytes;
+    live_[entry.taskId] = std::move(record);
+    return true;
+}
+
+void TaskJournal::remove(const std::string& taskId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!data_) {
+        return;
+    }
+
+    auto it = live_.find(taskId);
+    if (it == live_.end()) {
+        return;
+    }
+
+    const auto body = encodeComplete(taskId);
+    if (!writeRecordLocked(kCompleteRecord, body)) {
+        return;
+    }
+
+    liveBytes_ -= it->second.bytes;
+    deadBytes_ += it->second.bytes + kRecordHeaderSize + body.size();
+    live_.erase(it);
+    maybeCompactLocked();
+}
+
+std::vector<JournalEntry> TaskJournal::pendingEntries() const {
+    std::vector<const LiveRecord*> ordered;
+    std::vector<JournalEntry> entries;
+    std::lock_guard<std::mutex> lock(mutex_);
+    ordered.reserve(live_.size());
+    for (const auto& item : live_) {
+        ordered.push_back(&item.second);
+    }
+    std::sort(ordered.begin(), ordered.end(), [](const LiveRecord* lhs, const LiveRecord* rhs) {
+        return lhs->order < rhs->order;
+    });
+    entries.reserve(ordered.size());
+    for (const auto* record : ordered) {
+        entries.push_back(record->entry);
+    }
+    return entries;
+}
+
+void TaskJournal::compact() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (data_) {
+        compactLocked();
+    }
+}
+
+void TaskJournal::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (data_) {
+        live_.clear();
+        liveBytes_ = 0;
+        compactLocked();
+    }
+}
+
+size_t TaskJournal::sizeBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return mappedSize_;
+}
+
+const std::string& TaskJournal::path() const {
+    return path_;
+}
+
+bool TaskJournal::mapFileLocked(size_t minimumSize) {
+    unmapLocked();
+    if (ftruncate(fd_, static_cast<off_t>(minimumSize)) != 0) {
+        return false;
+    }
+    void* mapped = mmap(nullptr, minimumSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    data_ = static_cast<uint8_t*>(mapped);
+    mappedSize_ = minimumSize;
+    return true;
+}
+
+void TaskJournal::unmapLocked() {
+    if (data_) {
+        munmap(data_, mappedSize_);
+        data_ = nullptr;
+        mappedSize_ = 0;
+    }
+}
+
+bool TaskJournal::ensureCapacityLocked(size_t additional) {
+    const auto required = static_cast<size_t>(committedEndLocked()) + additional;
+    if (required <= mappedSize_) {
+        return true;
+    }
+    return mapFileLocked(roundUpCapacity(required));
+}
+
+bool TaskJournal::writeRecordLocked(uint8_t type, const std::string& body) {
+    const size_t recordSize = kRecordHeaderSize + body.size();
+    if (!ensureCapacityLocked(recordSize)) {
+        return false;
+    }
+
+    const auto end = committedEndLocked();
+    uint8_t* cursor = data_ + end;
+    const auto length = static_cast<uint32_t>(body.size());
+    std::memcpy(cursor, &length, sizeof(length));
+    cursor[sizeof(length)] = type;
+    std::memcpy(cursor + kRecordHeaderSize, body.data(), body.size());
+
+    // The record only becomes visible to a later scan once the committed end
+    // moves past it, so a crash mid-write leaves a clean tail.
+    setCommittedEndLocked(end + recordSize);
+    return true;
+}
+
+void TaskJournal::scanLocked() {
+    live_.clear();
+    liveBytes_ = 0;
+    deadBytes_ = 0;
+
+    const auto end = std::min<uint64_t>(committedEndLocked(), mappedSize_);
+    size_t offset = kHeaderSize;
+    while (offset + kRecordHeaderSize <= end) {
+        uint32_t length = 0;
+        size_t cursor = offset;
+        readU32(data_, end, cursor, length);
+        const uint8_t type = data_[cursor];
+        cursor += sizeof(uint8_t);
+        const size_t recordEnd = cursor + length;
+        if (recordEnd > end) {
+            break;
+        }
+
+        std::string taskId;
+        if (!readString(data_, recordEnd, cursor, taskId)) {
+            break;
+        }
+
+        const size_t recordBytes = kRecordHeaderSize + length;
+        if (type == kEnqueueRecord) {
+            uint32_t priority = 0;
+            std::string payload;
+            if (!readU32(data_, recordEnd, cursor, priority) || !readString(data_, recordEnd, cursor, payload)) {
+                break;
+            }
+            auto previous = live_.find(taskId);
+            if (previous != live_.end()) {
+                liveBytes_ -= previous->second.bytes;
+                deadBytes_ += previous->second.bytes;
+            }
+            LiveRecord record;
+            record.entry.taskId = taskId;
+            record.entry.priority = static_cast<int>(priority);
+            record.entry.payload = std::move(payload);
+            record.order = nextOrder_++;
+            record.bytes = recordBytes;
+            liveBytes_ += recordBytes;
+            live_[taskId] = std::move(record);
+        } else if (type == kCompleteRecord) {
+            auto previous = live_.find(taskId);
+            if (previous != live_.end()) {
+                liveBytes_ -= previous->second.bytes;
+                deadBytes_ += previous->second.bytes;
+                live_.erase(previous);
+            }
+            deadBytes_ += recordBytes;
+        } else {
+            break;
+        }
+
+        offset = recordEnd;
+    }
+
+    // Anything past the last well-formed record is discarded.
+    setCommittedEndLocked(offset);
+}
+
+void TaskJournal::compactLocked() {
+    std::vector<const LiveRecord*> ordered;
+    ordered.reserve(live_.size());
+    for (const auto& item : live_) {
+        ordered.push_back(&item.second);
+    }
+    std::sort(ordered.begin(), ordered.end(), [](const LiveRecord* lhs, const LiveRecord* rhs) {
+        return lhs->order < rhs->order;
+    });
+
+    std::string image;
+    image.reserve(kHeaderSize + liveBytes_);
+    image.append(kMagic, sizeof(kMagic));
+    appendU32(image, kVersion);
+    image.append(sizeof(uint64_t), '\0');
+    for (const auto* record : ordered) {
+        const auto body = encodeEnqueue(record->entry);
+        appendU32(image, static_cast<uint32_t>(body.size()));
+        image.push_back(static_cast<char>(kEnqueueRecord));
+        image.append(body);
+    }
+    const uint64_t end = image.size();
+    std::memcpy(&image[kEndOffset], &end, sizeof(end));
+
+    // Write the compacted image next to the journal and atomically swap it in,
+    // so a crash during compaction leaves either the old or the new file intact.
+    const auto tempPath = path_ + ".compact";
+    const int tempFd = ::open(tempPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (tempFd < 0) {
+        return;
+    }
+    size_t written = 0;
+    while (written < image.size()) {
+        const auto chunk = ::write(tempFd, image.data() + written, image.size() - written);
+        if (chunk <= 0) {
+            ::close(tempFd);
+            ::unlink(tempPath.c_str());
+            return;
+        }
+        written += static_cast<size_t>(chunk);
+    }
+    fsync(tempFd);
+
+    if (std::rename(tempPath.c_str(), path_.c_str()) != 0) {
+        ::close(tempFd);
+        ::unlink(tempPath.c_str());
+        return;
+    }
+
+    unmapLocked();
+    ::close(fd_);
+    fd_ = tempFd;
+    if (!mapFileLocked(roundUpCapacity(image.size()))) {
+        ::close(fd_);
+        fd_ = -1;
+        live_.clear();
+        liveBytes_ = 0;
+        deadBytes_ = 0;
+        return;
+    }
+    deadBytes_ = 0;
+}
+
+void TaskJournal::maybeCompactLocked() {
+    if (deadBytes_ >= kCompactionThreshold && deadBytes_ > liveBytes_) {
+        compactLocked();
+    }
+}
+
+uint64_t TaskJournal::committedEndLocked() const {
+    uint64_t end = 0;
+    std::memcpy(&end, data_ + kEndOffset, sizeof(end));
+    return end;
+}
+
+void TaskJournal::setCommittedEndLocked(uint64_t end) {
+    std::memcpy(data_ + kEndOffset, &end, sizeof(end));
+}
+
+} // namespace threadforge
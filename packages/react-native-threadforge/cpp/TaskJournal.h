@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace threadforge {
+
+struct JournalEntry {
+    std::string taskId;
+    int priority{0};
+    std::string payload;
+};
+
+// Append-only, memory-mapped log of pending task descriptors. Every queued task
+// writes an enqueue record and every finished task writes a completion record;
+// whatever is still open when the process dies is replayed on the next start.
+// The file is rewritten with only the live records once dead records dominate.
+class TaskJournal {
+public:
+    explicit TaskJournal(std::string path);
+    ~TaskJournal();
+
+    TaskJournal(const TaskJournal&) = delete;
+    TaskJournal& operator=(const TaskJournal&) = delete;
+
+    bool open();
+    void close();
+
+    bool append(const JournalEntry& entry);
+    void remove(const std::string& taskId);
+    std::vector<JournalEntry> pendingEntries() const;
+
+    void compact();
+    // Drops every record, so nothing is replayed on the next open.
+    void clear();
+    size_t sizeBytes() const;
+    const std::string& path() const;
+
+private:
+    struct LiveRecord {
+        JournalEntry entry;
+        uint64_t order{0};
+        size_t bytes{0};
+    };
+
+    bool mapFileLocked(size_t minimumSize);
+    void unmapLocked();
+    bool ensureCapacityLocked(size_t additional);
+    bool writeRecordLocked(uint8_t type, const std::string& body);
+    void scanLocked();
+    void compactLocked();
+    void maybeCompactLocked();
+    uint64_t committedEndLocked() const;
+    void setCommittedEndLocked(uint64_t end);
+
+    std::string path_;
+    int fd_{-1};
+    uint8_t* data_{nullptr};
+    size_t mappedSize_{0};
+    size_t liveBytes_{0};
+    size_t deadBytes_{0};
+    uint64_t nextOrder_{0};
+    std::unordered_map<std::string, LiveRecord> live_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace threadforge
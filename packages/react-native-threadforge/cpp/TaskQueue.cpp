@@ -0,0 +1,91 @@
+#include "TaskQueue.h"
+
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+namespace threadforge {
+
+namespace {
+
+constexpr size_t kCompactThreshold = 32;
+
+int highestBit(uint64_t word) {
+    return 63 - __builtin_clzll(word);
+}
+
+} // namespace
+
+void TaskQueue::push(std::shared_ptr<Task> task) {
+    const int level = static_cast<int>(task->priority);
+    buckets_[level].items.push_back(std::move(task));
+    occupied_[level >> 6] |= uint64_t{1} << (level & 63);
+    ++count_;
+}
+
+bool TaskQueue::empty() const {
+    return count_ == 0;
+}
+
+size_t TaskQueue::size() const {
+    return count_;
+}
+
+const std::shared_ptr<Task>& TaskQueue::top() const {
+    return front(highestLevel());
+}
+
+void TaskQueue::pop() {
+    popFront(highestLevel());
+}
+
+int TaskQueue::highestLevel() const {
+    for (int word = static_cast<int>(occupied_.size()) - 1; word >= 0; --word) {
+        if (occupied_[word] != 0) {
+            return word * 64 + highestBit(occupied_[word]);
+        }
+    }
+    return -1;
+}
+
+int TaskQueue::nextLevelBelow(int level) const {
+    if (level <= 0) {
+        return -1;
+    }
+    const int below = std::min(level, kPriorityLevelCount) - 1;
+    const int firstWord = below >> 6;
+    const int bit = below & 63;
+    const uint64_t mask = bit == 63 ? ~uint64_t{0} : (uint64_t{1} << (bit + 1)) - 1;
+    if (const uint64_t masked = occupied_[firstWord] & mask) {
+        return firstWord * 64 + highestBit(masked);
+    }
+    for (int word = firstWord - 1; word >= 0; --word) {
+        if (occupied_[word] != 0) {
+            return word * 64 + highestBit(occupied_[word]);
+        }
+    }
+    return -1;
+}
+
+const std::shared_ptr<Task>& TaskQueue::front(int level) const {
+    const auto& bucket = buckets_[level];
+    return bucket.items[bucket.head];
+}
+
+void TaskQueue::popFront(int level) {
+    auto& bucket = buckets_[level];
+    bucket.items[bucket.head].reset();
+    ++bucket.head;
+    --count_;
+
+    if (bucket.head == bucket.items.size()) {
+        bucket.items.clear();
+        bucket.head = 0;
+        occupied_[level >> 6] &= ~(uint64_t{1} << (level & 63));
+    } else if (bucket.head >= kCompactThreshold && bucket.head * 2 >= bucket.items.size()) {
+        bucket.items.erase(bucket.items.begin(), bucket.items.begin() + static_cast<std::ptrdiff_t>(bucket.head));
+        bucket.head = 0;
+    }
+}
+
+} // namespace threadforge
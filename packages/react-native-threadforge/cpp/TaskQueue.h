@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace threadforge {
+
+struct Task;
+
+constexpr int kPriorityLevelCount = 256;
+
+// One FIFO per priority level plus a bitmap of non-empty levels. Push, pop and
+// finding the highest waiting level are O(1); tasks of equal level run in
+// submission order.
+class TaskQueue {
+public:
+    void push(std::shared_ptr<Task> task);
+    bool empty() const;
+    size_t size() const;
+
+    // Front task of the highest non-empty level. Queue must not be empty.
+    const std::shared_ptr<Task>& top() const;
+    void pop();
+
+    // Highest non-empty level, or -1 when empty.
+    int highestLevel() const;
+    // Highest non-empty level strictly below level, or -1 when there is none.
+    int nextLevelBelow(int level) const;
+    const std::shared_ptr<Task>& front(int level) const;
+    void popFront(int level);
+
+private:
+    // Popped slots are reclaimed once the dead prefix dominates, so a level
+    // that never fully drains does not grow without bound.
+    struct Bucket {
+        std::vector<std::shared_ptr<Task>> items;
+        size_t head{0};
+    };
+
+    std::array<Bucket, kPriorityLevelCount> buckets_{};
+    std::array<uint64_t, kPriorityLevelCount / 64> occupied_{};
+    size_t count_{0};
+};
+
+} // namespace threadforge
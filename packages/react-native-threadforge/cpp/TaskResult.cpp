@@ -54,6 +54,9 @@ std::string serializeTaskResult(const TaskResult& result) {
         if (!result.errorStack.empty()) {
             json["stack"] = result.errorStack;
         }
+        if (!result.valueJson.empty()) {
+            json["partial"] = parseJsonOrValue(result.valueJson);
+        }
         return json.dump();
     }
 
@@ -1,44 +1,250 @@
 #include "ThreadPool.h"
 
 #include <algorithm>
+#include <pthread.h>
 #include <stdexcept>
+#include <time.h>
+#include <utility>
+
+#include "nlohmann/json.hpp"
 
 namespace threadforge {
 
-ThreadPool::ThreadPool(size_t numThreads) {
-    const size_t clamped = std::max<size_t>(1, numThreads);
-    for (size_t i = 0; i < clamped; ++i) {
-        workers.emplace_back([this] { this->workerThread(); });
+// A worker holds its lease's mutex whenever it touches the pool, and drops it
+// only while running a task. The destructor takes it to orphan a worker, so an
+// orphaned worker never reaches freed pool state again.
+struct WorkerLease {
+    std::mutex mutex;
+    bool orphaned{false};
+};
+
+namespace {
+
+thread_local std::shared_ptr<Task> tCurrentTask;
+thread_local ThreadPool* tCurrentPool = nullptr;
+thread_local WorkerLease* tCurrentLease = nullptr;
+thread_local bool tHasPlacement = false;
+thread_local CorePlacement tPlacement = CorePlacement::ANY;
+
+constexpr auto kLowPriorityCooldown = std::chrono::seconds(10);
+constexpr auto kTrimRetireWait = std::chrono::milliseconds(100);
+
+constexpr auto kThrottleSleepSlice = std::chrono::milliseconds(5);
+
+std::atomic<size_t> gDetachedWorkers{0};
+
+// Replayed results wait this long for their submitter to come back, and at most
+// this many are held at once; the oldest goes first when the cap is reached.
+constexpr auto kRecoveredResultTtl = std::chrono::minutes(5);
+constexpr size_t kMaxRecoveredResults = 64;
+
+int64_t threadCpuTimeNs() {
+    timespec ts{};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0;
+    }
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+CorePlacement placementFor(TaskPriority priority) {
+    switch (priorityClassIndex(priority)) {
+        case priorityClassIndex(TaskPriority::HIGH):
+            return CorePlacement::PERFORMANCE;
+        case priorityClassIndex(TaskPriority::IDLE):
+        case priorityClassIndex(TaskPriority::LOW):
+            return CorePlacement::EFFICIENCY;
+        default:
+            return CorePlacement::ANY;
+    }
+}
+
+// Only touches affinity when the class changes, so back-to-back tasks of the
+// same class cost no syscalls.
+void placeWorker(const std::shared_ptr<const CpuTopology>& topology, TaskPriority priority) {
+    if (!topology || !topology->isHeterogeneous()) {
+        return;
+    }
+    const auto placement = placementFor(priority);
+    if (tHasPlacement && tPlacement == placement) {
+        return;
+    }
+    applyCorePlacement(*topology, placement);
+    tHasPlacement = true;
+    tPlacement = placement;
+}
+
+// Workers use the default pthread attributes, so this is what each retired
+// worker gives back in stack reservation.
+size_t defaultThreadStackBytes() {
+    pthread_attr_t attr;
+    if (pthread_attr_init(&attr) != 0) {
+        return 0;
+    }
+    size_t stackBytes = 0;
+    pthread_attr_getstacksize(&attr, &stackBytes);
+    pthread_attr_destroy(&attr);
+    return stackBytes;
+}
+
+TaskResult makeCancelledResultWithPartial(const Task& task) {
+    auto result = makeCancelledResult();
+    result.valueJson = task.partialJson;
+    return result;
+}
+
+} // namespace
+
+std::string serializeShutdownReport(const ShutdownReport& report) {
+    nlohmann::json json;
+    json["completed"] = report.completed;
+    json["cancelled"] = report.cancelled;
+    json["interrupted"] = report.interrupted;
+    json["timedOut"] = report.deadlineExceeded;
+    return json.dump();
+}
+
+std::string serializeMemoryTrimReport(const MemoryTrimReport& report) {
+    nlohmann::json json;
+    json["bytesFreed"] = report.bytesFreed;
+    json["workersReleased"] = report.workersReleased;
+    json["resultsDropped"] = report.resultsDropped;
+    json["lowPriorityPaused"] = report.lowPriorityPaused;
+    return json.dump();
+}
+
+ThreadPool::ThreadPool(size_t numThreads)
+    : ThreadPool(numThreads, numThreads, std::chrono::milliseconds(0)) {}
+
+ThreadPool::ThreadPool(size_t maxThreads, size_t minThreads, std::chrono::milliseconds idleTimeout)
+    : targetWorkers(std::max<size_t>(1, maxThreads)),
+      minWorkers(minThreads),
+      idleTimeout(std::max(idleTimeout, std::chrono::milliseconds(0))) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    while (liveWorkers < std::min(minWorkers, targetWorkers)) {
+        spawnWorkerLocked();
     }
 }
 
 ThreadPool::~ThreadPool() {
+    if (hasStragglers()) {
+        detachStragglers();
+        return;
+    }
     shutdown();
 }
 
-void ThreadPool::workerThread() {
+void ThreadPool::detachStragglers() {
+    std::vector<Worker> stuck;
+    {
+        // The shutdown deadline has already passed, so there is no time left to
+        // wait: join the workers that have exited since and detach the rest.
+        std::lock_guard<std::mutex> lock(queueMutex);
+        reapExitedWorkersLocked();
+        stuck = std::move(workers);
+    }
+    // Never under queueMutex: a worker holding its lease may be waiting for it.
+    for (auto& worker : stuck) {
+        {
+            std::lock_guard<std::mutex> leaseLock(worker.lease->mutex);
+            worker.lease->orphaned = true;
+        }
+        worker.thread.detach();
+    }
+    gDetachedWorkers += stuck.size();
+}
+
+size_t ThreadPool::detachedWorkerCount() {
+    return gDetachedWorkers.load();
+}
+
+void ThreadPool::workerThread(const std::shared_ptr<WorkerLease>& lease) {
+    std::unique_lock<std::mutex> leaseLock(lease->mutex);
+    tCurrentLease = lease.get();
     while (true) {
         std::shared_ptr<Task> task;
+        ProgressCallback progressEmitter;
+        std::shared_ptr<const CpuTopology> cpuTopology;
+        JournalReleases releases;
 
         {
             std::unique_lock<std::mutex> lock(queueMutex);
-            condition.wait(lock, [this] {
-                return stop || (!paused && !tasks.empty());
-            });
+            const uint64_t epoch = idlePolicyEpoch;
+            auto ready = [this, epoch] {
+                return stop || liveWorkers > workerCapacityLocked() || (!paused && !tasks.empty()) ||
+                    pendingRetirements > 0 || idlePolicyEpoch != epoch;
+            };
+            bool timedOut = false;
+            if (idleTimeout.count() > 0) {
+                timedOut = !condition.wait_for(lock, idleTimeout, ready);
+            } else {
+                condition.wait(lock, ready);
+            }
 
-            if (stop && tasks.empty()) {
+            // Surplus workers retire between tasks after the pool has been shrunk, and
+            // workers above the floor retire after sitting idle for idleTimeout.
+            const bool idleExpired = timedOut && liveWorkers > std::min(minWorkers, targetWorkers);
+            const bool hasWork = !stop && !paused && !tasks.empty();
+            const bool trimmed = !stop && !hasWork && pendingRetirements > 0;
+            if (trimmed) {
+                pendingRetirements--;
+            }
+            const bool retiring = !stop && (liveWorkers > workerCapacityLocked() || idleExpired || trimmed);
+            if (!stop && !retiring && !hasWork) {
+                // Timed out at the floor or woken by an idle policy change: wait again.
+                continue;
+            }
+            if ((stop && tasks.empty()) || retiring) {
+                liveWorkers--;
+                idleWorkers--;
+                exitedWorkers.push_back(std::this_thread::get_id());
+                workersExitedCv.notify_all();
                 return;
             }
 
-            task = tasks.top();
-            tasks.pop();
+            int level = tasks.highestLevel();
+            if (!stop) {
+                // Skip classes that are over their CPU quota or waiting for an idle
+                // window so lower levels can still run. Cancelled tasks are always
+                // taken so their callers settle.
+                const auto now = std::chrono::steady_clock::now();
+                std::chrono::steady_clock::time_point earliestResume{};
+                while (level >= 0 && !tasks.front(level)->cancelled) {
+                    const auto priority = tasks.front(level)->priority;
+                    const auto resumeAt = throttledUntil(priority);
+                    const bool throttled = resumeAt > now;
+                    if (!throttled && !(isIdlePriority(priority) && !idleWindowOpenLocked(now))) {
+                        break;
+                    }
+                    if (throttled && (earliestResume == std::chrono::steady_clock::time_point{} ||
+                                      resumeAt < earliestResume)) {
+                        earliestResume = resumeAt;
+                    }
+                    // The whole class is held back, so jump below its lowest level.
+                    level = tasks.nextLevelBelow(static_cast<int>(priorityClassIndex(priority) << 6));
+                }
+                if (level < 0) {
+                    // A submission, resize or setIdle(true) wakes us early to re-evaluate.
+                    if (earliestResume != std::chrono::steady_clock::time_point{}) {
+                        condition.wait_until(lock, earliestResume);
+                    } else {
+                        condition.wait(lock);
+                    }
+                    continue;
+                }
+            }
+
+            task = tasks.front(level);
+            tasks.popFront(level);
             pendingTasks--;
 
             if (task->cancelled) {
                 taskMap.erase(task->id);
+                releaseJournalEntryLocked(task, releases);
+                lock.unlock();
+                removeJournalEntries(releases);
                 {
                     std::lock_guard<std::mutex> taskLock(task->mutex);
-                    task->result = makeCancelledResult();
+                    task->result = makeCancelledResultWithPartial(*task);
                     task->hasResult = true;
                     task->finished = true;
                 }
@@ -47,18 +253,27 @@ void ThreadPool::workerThread() {
             }
 
             activeTasks++;
+            idleWorkers--;
+            task->started = true;
+            progressEmitter = task->progress;
+            cpuTopology = topology;
         }
 
+        leaseLock.unlock();
+        placeWorker(cpuTopology, task->priority);
+
         TaskResult taskResult;
         bool hasLocalResult = false;
         try {
-            auto progressEmitter = task->progress;
             if (!progressEmitter) {
                 progressEmitter = [](double) {};
             }
             auto cancellationCheck = [task]() {
                 return task->cancelled.load();
             };
+            tCurrentTask = task;
+            tCurrentPool = this;
+            task->cpuChargedAtNs = threadCpuTimeNs();
             taskResult = task->work(progressEmitter, cancellationCheck);
             hasLocalResult = true;
         } catch (const std::exception& ex) {
@@ -68,77 +283,214 @@ void ThreadPool::workerThread() {
             taskResult = makeErrorResult("Unknown exception while executing ThreadForge task");
             hasLocalResult = true;
         }
+        tCurrentTask.reset();
+        tCurrentPool = nullptr;
+
+        leaseLock.lock();
+        if (lease->orphaned) {
+            // The pool was destroyed while this task ran; only the task is left to settle.
+            settleRanTask(task, std::move(taskResult), hasLocalResult);
+            return;
+        }
+        chargeCpuTime(*task);
 
         {
             std::lock_guard<std::mutex> lock(queueMutex);
             taskMap.erase(task->id);
             activeTasks--;
+            idleWorkers++;
+            if (!task->abandoned) {
+                completedTasks++;
+            }
+            if (task->recovered && !task->claimed && !task->abandoned) {
+                parkRecoveredTaskLocked(task, releases);
+            } else {
+                releaseJournalEntryLocked(task, releases);
+            }
         }
+        removeJournalEntries(releases);
+        settleRanTask(task, std::move(taskResult), hasLocalResult);
+    }
+}
 
-        {
-            std::lock_guard<std::mutex> taskLock(task->mutex);
-            if (!task->finished) {
-                if (task->cancelled) {
-                    taskResult.cancelled = true;
-                    taskResult.success = false;
-                    if (taskResult.errorMessage.empty()) {
-                        taskResult.errorMessage = "Task cancelled";
-                    }
-                    taskResult.valueJson.clear();
-                } else if (!hasLocalResult) {
-                    taskResult = makeErrorResult("ThreadForge task completed without result");
+void ThreadPool::settleRanTask(const std::shared_ptr<Task>& task, TaskResult taskResult, bool hasLocalResult) {
+    {
+        std::lock_guard<std::mutex> taskLock(task->mutex);
+        if (!task->finished) {
+            if (task->cancelled) {
+                taskResult.cancelled = true;
+                taskResult.success = false;
+                if (taskResult.errorMessage.empty()) {
+                    taskResult.errorMessage = "Task cancelled";
                 }
-                task->result = std::move(taskResult);
-                task->hasResult = true;
-                task->finished = true;
+                taskResult.errorStack.clear();
+                taskResult.valueJson = task->partialJson;
+            } else if (!hasLocalResult) {
+                taskResult = makeErrorResult("ThreadForge task completed without result");
             }
+            task->result = std::move(taskResult);
+            task->hasResult = true;
+            task->finished = true;
         }
-
-        task->completionCv.notify_all();
     }
+
+    task->completionCv.notify_all();
+    deliverCompletion(task);
 }
 
-TaskResult ThreadPool::submitTask(const std::string& taskId, TaskPriority priority, TaskFunction task, ProgressCallback progress) {
-    auto sequence = sequenceCounter.fetch_add(1);
-    auto taskObj = std::make_shared<Task>(taskId, std::move(task), priority, sequence, std::move(progress));
+TaskResult ThreadPool::submitTask(const std::string& taskId,
+                                  TaskPriority priority,
+                                  TaskFunction task,
+                                  ProgressCallback progress,
+                                  std::string journalPayload) {
+    return waitForTask(enqueueTask(taskId,
+                                   priority,
+                                   std::move(task),
+                                   std::move(progress),
+                                   nullptr,
+                                   std::move(journalPayload)));
+}
+
+std::shared_ptr<Task> ThreadPool::enqueueTask(const std::string& taskId,
+                                              TaskPriority priority,
+                                              TaskFunction task,
+                                              ProgressCallback progress,
+                                              TaskCompletion completion,
+                                              std::string journalPayload) {
+    std::shared_ptr<Task> taskObj;
+    bool joined = false;
+    JournalReleases releases;
 
     {
         std::unique_lock<std::mutex> lock(queueMutex);
         if (stop) {
-            return makeErrorResult("ThreadPool is stopped");
+            lock.unlock();
+            return makeSettledTask(taskId, priority, makeErrorResult("ThreadPool is stopped"), std::move(completion));
         }
 
-        const auto limit = queueLimit.load();
-        if (limit > 0 && pendingTasks.load() >= limit) {
-            return makeErrorResult("ThreadPool queue limit reached");
+        // A task replayed from the journal under the same id is joined instead of
+        // being computed a second time.
+        if (!recoveredTasks.empty()) {
+            pruneRecoveredTasksLocked(std::chrono::steady_clock::now(), releases);
+        }
+        auto recovered = recoveredTasks.find(taskId);
+        if (recovered != recoveredTasks.end()) {
+            taskObj = recovered->second;
+            recoveredTasks.erase(recovered);
+            releaseJournalEntryLocked(taskObj, releases);
+            joined = true;
+        } else {
+            auto live = taskMap.find(taskId);
+            if (live != taskMap.end() && live->second->recovered && !live->second->claimed) {
+                taskObj = live->second;
+                taskObj->claimed = true;
+                taskObj->progress = std::move(progress);
+                joined = true;
+            }
         }
 
-        tasks.push(taskObj);
-        taskMap[taskId] = taskObj;
-        pendingTasks++;
+        if (!taskObj) {
+            const auto limit = queueLimit.load();
+            if (limit > 0 && pendingTasks.load() >= limit) {
+                lock.unlock();
+                return makeSettledTask(taskId,
+                                       priority,
+                                       makeErrorResult("ThreadPool queue limit reached"),
+                                       std::move(completion));
+            }
+            if (priorityClassIndex(priority) <= priorityClassIndex(TaskPriority::LOW) &&
+                std::chrono::steady_clock::now() < lowPriorityResumeAt) {
+                lock.unlock();
+                return makeSettledTask(taskId,
+                                       priority,
+                                       makeErrorResult("ThreadPool is rejecting LOW priority tasks under memory pressure"),
+                                       std::move(completion));
+            }
+
+            auto sequence = sequenceCounter.fetch_add(1);
+            taskObj = std::make_shared<Task>(taskId, std::move(task), priority, sequence, std::move(progress));
+            taskObj->completion = std::move(completion);
+            if (journal && !journalPayload.empty()) {
+                taskObj->journaled = journal->append({taskId, static_cast<int>(priority), std::move(journalPayload)});
+            }
+
+            tasks.push(taskObj);
+            taskMap[taskId] = taskObj;
+            pendingTasks++;
+            growForBacklogLocked();
+        }
+    }
+    removeJournalEntries(releases);
+
+    if (joined) {
+        // The replayed task may already have finished; deliver right away then.
+        {
+            std::lock_guard<std::mutex> taskLock(taskObj->mutex);
+            taskObj->completion = std::move(completion);
+        }
+        deliverCompletion(taskObj);
     }
 
     condition.notify_one();
+    return taskObj;
+}
 
-    std::unique_lock<std::mutex> completionLock(taskObj->mutex);
-    taskObj->completionCv.wait(completionLock, [&taskObj] {
-        return taskObj->finished;
+TaskResult ThreadPool::waitForTask(const std::shared_ptr<Task>& task) {
+    std::unique_lock<std::mutex> completionLock(task->mutex);
+    task->completionCv.wait(completionLock, [&task] {
+        return task->finished;
     });
 
-    if (!taskObj->hasResult) {
+    if (!task->hasResult) {
         auto result = makeErrorResult("ThreadForge task completed without result");
-        if (taskObj->cancelled) {
+        if (task->cancelled) {
             result.cancelled = true;
             result.errorMessage = "Task cancelled";
         }
         return result;
     }
 
-    return taskObj->result;
+    return task->result;
+}
+
+bool ThreadPool::waitForTask(const std::shared_ptr<Task>& task, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> completionLock(task->mutex);
+    return task->completionCv.wait_for(completionLock, timeout, [&task] {
+        return task->finished;
+    });
+}
+
+void ThreadPool::deliverCompletion(const std::shared_ptr<Task>& task) {
+    TaskCompletion completion;
+    TaskResult result;
+    {
+        std::lock_guard<std::mutex> taskLock(task->mutex);
+        if (!task->finished || !task->completion) {
+            return;
+        }
+        completion = std::move(task->completion);
+        task->completion = nullptr;
+        result = task->result;
+    }
+    completion(result);
+}
+
+std::shared_ptr<Task> ThreadPool::makeSettledTask(const std::string& taskId,
+                                                  TaskPriority priority,
+                                                  TaskResult result,
+                                                  TaskCompletion completion) {
+    auto task = std::make_shared<Task>(taskId, nullptr, priority, 0, nullptr);
+    task->result = std::move(result);
+    task->hasResult = true;
+    task->finished = true;
+    task->completion = std::move(completion);
+    deliverCompletion(task);
+    return task;
 }
 
 bool ThreadPool::cancelTask(const std::string& taskId) {
     std::shared_ptr<Task> taskRef;
+    JournalReleases releases;
     {
         std::lock_guard<std::mutex> lock(queueMutex);
         auto it = taskMap.find(taskId);
@@ -147,19 +499,23 @@ bool ThreadPool::cancelTask(const std::string& taskId) {
         }
         taskRef = it->second;
         taskRef->cancelled = true;
+        releaseJournalEntryLocked(taskRef, releases);
     }
+    removeJournalEntries(releases);
 
     {
         std::lock_guard<std::mutex> taskLock(taskRef->mutex);
         if (!taskRef->hasResult) {
-            taskRef->result = makeCancelledResult();
+            taskRef->result = makeCancelledResultWithPartial(*taskRef);
             taskRef->hasResult = true;
         }
         taskRef->finished = true;
     }
 
     taskRef->completionCv.notify_all();
+    deliverCompletion(taskRef);
     condition.notify_all();
+    idleWindowCv.notify_all();
     return true;
 }
 
@@ -172,6 +528,9 @@ void ThreadPool::resume() {
     {
         std::lock_guard<std::mutex> lock(queueMutex);
         paused = false;
+        if (!stop) {
+            growForBacklogLocked();
+        }
     }
     condition.notify_all();
 }
@@ -181,7 +540,8 @@ bool ThreadPool::isPaused() const {
 }
 
 size_t ThreadPool::getThreadCount() const {
-    return workers.size();
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return liveWorkers;
 }
 
 size_t ThreadPool::getPendingTaskCount() const {
@@ -193,36 +553,140 @@ size_t ThreadPool::getActiveTaskCount() const {
 }
 
 void ThreadPool::setConcurrency(size_t threads) {
-    if (threads == 0) {
-        threads = 1;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (stop) {
+            return;
+        }
+        reapExitedWorkersLocked();
+        targetWorkers = std::max<size_t>(1, threads);
+        while (liveWorkers < std::min(minWorkers, targetWorkers)) {
+            spawnWorkerLocked();
+        }
+        growForBacklogLocked();
     }
+    // Wake idle workers so any surplus retires; busy ones retire after their task.
+    condition.notify_all();
+}
 
-    std::vector<std::thread> oldWorkers;
+void ThreadPool::setIdlePolicy(size_t minThreads, std::chrono::milliseconds timeout) {
     {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        if (pendingTasks.load() > 0 || activeTasks.load() > 0) {
-            throw std::runtime_error("Cannot resize thread pool while tasks are pending or active");
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (stop) {
+            return;
         }
-        stop = true;
-        paused = false;
-        condition.notify_all();
-        oldWorkers.swap(workers);
+        reapExitedWorkersLocked();
+        minWorkers = minThreads;
+        idleTimeout = std::max(timeout, std::chrono::milliseconds(0));
+        idlePolicyEpoch++;
+        while (liveWorkers < std::min(minWorkers, targetWorkers)) {
+            spawnWorkerLocked();
+        }
+    }
+    // Idle workers wake up and re-arm their wait with the new timeout.
+    condition.notify_all();
+}
+
+size_t ThreadPool::getIdleThreadCount() const {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return idleWorkers;
+}
+
+void ThreadPool::spawnWorkerLocked() {
+    auto lease = std::make_shared<WorkerLease>();
+    workers.push_back({std::thread([this, lease] { this->workerThread(lease); }), lease});
+    liveWorkers++;
+    idleWorkers++;
+}
+
+void ThreadPool::growForBacklogLocked() {
+    if (paused) {
+        return;
+    }
+    if (pendingTasks.load() > 0) {
+        // New demand outranks a pending trim.
+        pendingRetirements = 0;
+    }
+    reapExitedWorkersLocked();
+    while (liveWorkers < workerCapacityLocked() && idleWorkers < pendingTasks.load()) {
+        spawnWorkerLocked();
     }
+}
 
-    for (std::thread& worker : oldWorkers) {
-        if (worker.joinable()) {
-            worker.join();
+void ThreadPool::reapExitedWorkersLocked() {
+    for (const auto& exitedId : exitedWorkers) {
+        auto it = std::find_if(workers.begin(), workers.end(), [&exitedId](const Worker& worker) {
+            return worker.thread.get_id() == exitedId;
+        });
+        if (it != workers.end()) {
+            it->thread.join();
+            workers.erase(it);
         }
     }
+    exitedWorkers.clear();
+}
+
+size_t ThreadPool::workerCapacityLocked() const {
+    return targetWorkers + pausedIdleTasks;
+}
+
+bool ThreadPool::idleWindowOpenLocked(std::chrono::steady_clock::time_point now) const {
+    return appIdle && (!idleWindowBounded || now < idleWindowEnd);
+}
 
+void ThreadPool::setIdle(bool idle, std::chrono::milliseconds window) {
     {
         std::lock_guard<std::mutex> lock(queueMutex);
-        stop = false;
-        paused = false;
-        for (size_t i = 0; i < threads; ++i) {
-            workers.emplace_back([this] { this->workerThread(); });
+        appIdle = idle;
+        idleWindowBounded = idle && window.count() >= 0;
+        idleWindowEnd = std::chrono::steady_clock::now() + std::max(window, std::chrono::milliseconds(0));
+        if (idle && !stop) {
+            growForBacklogLocked();
         }
     }
+    condition.notify_all();
+    idleWindowCv.notify_all();
+}
+
+bool ThreadPool::isIdleWindowOpen() const {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return idleWindowOpenLocked(std::chrono::steady_clock::now());
+}
+
+bool ThreadPool::shouldYield() {
+    auto task = tCurrentTask;
+    ThreadPool* pool = tCurrentPool;
+    if (!task || !pool || !isIdlePriority(task->priority)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> leaseLock(tCurrentLease->mutex);
+    return !tCurrentLease->orphaned && !pool->isIdleWindowOpen();
+}
+
+void ThreadPool::waitForIdleWindow() {
+    auto task = tCurrentTask;
+    ThreadPool* pool = tCurrentPool;
+    if (!task || !pool || !isIdlePriority(task->priority)) {
+        return;
+    }
+    {
+        // Shutdown wakes this wait, so holding the lease across it stays bounded.
+        std::lock_guard<std::mutex> leaseLock(tCurrentLease->mutex);
+        if (tCurrentLease->orphaned) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(pool->queueMutex);
+        if (pool->stop || pool->idleWindowOpenLocked(std::chrono::steady_clock::now())) {
+            return;
+        }
+        pool->pausedIdleTasks++;
+        pool->growForBacklogLocked();
+        pool->idleWindowCv.wait(lock, [pool, &task] {
+            return pool->stop || task->cancelled || pool->idleWindowOpenLocked(std::chrono::steady_clock::now());
+        });
+        pool->pausedIdleTasks--;
+    }
+    task->cpuChargedAtNs = threadCpuTimeNs();
 }
 
 size_t ThreadPool::getQueueLimit() const {
@@ -233,31 +697,440 @@ void ThreadPool::setQueueLimit(size_t limit) {
     queueLimit = limit;
 }
 
+std::shared_ptr<Task> ThreadPool::currentTask() {
+    return tCurrentTask;
+}
+
+void ThreadPool::setPartialResult(std::string valueJson) {
+    auto task = tCurrentTask;
+    if (!task) {
+        return;
+    }
+    std::lock_guard<std::mutex> taskLock(task->mutex);
+    task->partialJson = std::move(valueJson);
+}
+
+void ThreadPool::setInterruptHandler(std::function<void()> handler) {
+    auto task = tCurrentTask;
+    if (!task) {
+        return;
+    }
+    std::lock_guard<std::mutex> taskLock(task->mutex);
+    task->interruptHandler = std::move(handler);
+}
+
+void ThreadPool::setCpuTopology(std::shared_ptr<const CpuTopology> cpuTopology) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    topology = std::move(cpuTopology);
+}
+
+void ThreadPool::setCpuQuota(TaskPriority priority, CpuQuota quota) {
+    {
+        std::lock_guard<std::mutex> lock(quotaMutex);
+        auto& budget = cpuBudgets[priorityClassIndex(priority)];
+        budget = CpuBudget();
+        if (quota.coreShare > 0.0 && quota.period.count() > 0) {
+            budget.quota = quota;
+            budget.tokensNs = quota.coreShare * std::chrono::duration<double, std::nano>(quota.period).count();
+            budget.refilledAt = std::chrono::steady_clock::now();
+        }
+    }
+    condition.notify_all();
+}
+
+std::chrono::milliseconds ThreadPool::getThrottledTime() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::nanoseconds(throttledNs.load()));
+}
+
+void ThreadPool::throttleCurrentTask() {
+    auto task = tCurrentTask;
+    ThreadPool* pool = tCurrentPool;
+    if (!task || !pool) {
+        return;
+    }
+    std::chrono::steady_clock::time_point resumeAt;
+    {
+        std::lock_guard<std::mutex> leaseLock(tCurrentLease->mutex);
+        if (tCurrentLease->orphaned) {
+            return;
+        }
+        pool->chargeCpuTime(*task);
+        resumeAt = pool->throttledUntil(task->priority);
+    }
+    while (!task->cancelled && std::chrono::steady_clock::now() < resumeAt) {
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+            resumeAt - std::chrono::steady_clock::now(), kThrottleSleepSlice));
+    }
+    // Sleeping is not CPU time, but resync so the next charge starts from here.
+    task->cpuChargedAtNs = threadCpuTimeNs();
+}
+
+void ThreadPool::refillBudget(CpuBudget& budget, std::chrono::steady_clock::time_point now) {
+    const double capacityNs = budget.quota.coreShare *
+        std::chrono::duration<double, std::nano>(budget.quota.period).count();
+    const double elapsedNs = std::chrono::duration<double, std::nano>(now - budget.refilledAt).count();
+    budget.tokensNs = std::min(capacityNs, budget.tokensNs + elapsedNs * budget.quota.coreShare);
+    budget.refilledAt = now;
+}
+
+void ThreadPool::chargeCpuTime(Task& task) {
+    const int64_t nowCpu = threadCpuTimeNs();
+    const int64_t usedNs = std::max<int64_t>(0, nowCpu - task.cpuChargedAtNs);
+    task.cpuChargedAtNs = nowCpu;
+
+    std::lock_guard<std::mutex> lock(quotaMutex);
+    auto& budget = cpuBudgets[priorityClassIndex(task.priority)];
+    if (budget.quota.coreShare <= 0.0) {
+        return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    refillBudget(budget, now);
+    budget.tokensNs -= static_cast<double>(usedNs);
+    if (budget.tokensNs >= 0.0) {
+        return;
+    }
+
+    // Over quota: the class pauses until the deficit has been paid back. Only the
+    // extension of the window counts, so concurrent workers are not double counted.
+    const auto deficit = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double, std::nano>(-budget.tokensNs / budget.quota.coreShare));
+    const auto resumeAt = now + deficit;
+    const auto windowStart = std::max(now, budget.throttledUntil);
+    if (resumeAt > windowStart) {
+        throttledNs += std::chrono::duration_cast<std::chrono::nanoseconds>(resumeAt - windowStart).count();
+        budget.throttledUntil = resumeAt;
+    }
+}
+
+std::chrono::steady_clock::time_point ThreadPool::throttledUntil(TaskPriority priority) {
+    std::lock_guard<std::mutex> lock(quotaMutex);
+    const auto& budget = cpuBudgets[priorityClassIndex(priority)];
+    if (budget.quota.coreShare <= 0.0) {
+        return {};
+    }
+    return budget.throttledUntil;
+}
+
+bool ThreadPool::takeTrimRequest() {
+    auto task = tCurrentTask;
+    return task && task->trimRequested.exchange(false);
+}
+
+MemoryTrimReport ThreadPool::trimMemory(MemoryTrimLevel level) {
+    MemoryTrimReport report;
+    std::shared_ptr<TaskJournal> journalToCompact;
+    JournalReleases releases;
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        if (stop) {
+            return report;
+        }
+
+        const size_t floor = level == MemoryTrimLevel::MODERATE ? std::min(minWorkers, targetWorkers) : 0;
+        const size_t releasable = liveWorkers > floor ? liveWorkers - floor : 0;
+        const size_t idleNow = tasks.empty() ? idleWorkers : 0;
+        pendingRetirements = std::min(idleNow, releasable);
+        const size_t liveBefore = liveWorkers;
+        if (pendingRetirements > 0) {
+            condition.notify_all();
+            workersExitedCv.wait_for(lock, kTrimRetireWait, [this] { return pendingRetirements == 0; });
+            pendingRetirements = 0;
+        }
+        report.workersReleased = liveBefore > liveWorkers ? liveBefore - liveWorkers : 0;
+        reapExitedWorkersLocked();
+        report.bytesFreed += report.workersReleased * defaultThreadStackBytes();
+
+        if (level >= MemoryTrimLevel::LOW) {
+            journalToCompact = journal;
+            for (const auto& item : taskMap) {
+                if (item.second->started) {
+                    item.second->trimRequested = true;
+                }
+            }
+        }
+
+        if (level == MemoryTrimLevel::CRITICAL) {
+            for (const auto& item : recoveredTasks) {
+                report.bytesFreed += item.second->result.valueJson.size() + item.second->partialJson.size();
+                releaseJournalEntryLocked(item.second, releases);
+            }
+            report.resultsDropped = recoveredTasks.size();
+            recoveredTasks.clear();
+            lowPriorityResumeAt = std::chrono::steady_clock::now() + kLowPriorityCooldown;
+            report.lowPriorityPaused = true;
+        }
+    }
+
+    removeJournalEntries(releases);
+    if (journalToCompact) {
+        const size_t before = journalToCompact->sizeBytes();
+        journalToCompact->compact();
+        const size_t after = journalToCompact->sizeBytes();
+        report.bytesFreed += before > after ? before - after : 0;
+    }
+    return report;
+}
+
+void ThreadPool::attachJournal(std::shared_ptr<TaskJournal> taskJournal) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    journal = std::move(taskJournal);
+}
+
+std::shared_ptr<TaskJournal> ThreadPool::detachJournal() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return std::exchange(journal, nullptr);
+}
+
+bool ThreadPool::isJournaling() const {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return journal != nullptr;
+}
+
+size_t ThreadPool::restoreJournal(const JournalTaskFactory& factory) {
+    std::shared_ptr<TaskJournal> source;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        source = journal;
+    }
+    if (!source || !factory) {
+        return 0;
+    }
+
+    size_t restored = 0;
+    for (auto& entry : source->pendingEntries()) {
+        TaskFunction work = factory(entry);
+        if (!work) {
+            source->remove(entry.taskId);
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (stop || taskMap.count(entry.taskId) > 0) {
+                continue;
+            }
+            auto sequence = sequenceCounter.fetch_add(1);
+            const auto level = std::clamp(entry.priority, 0, kPriorityLevelCount - 1);
+            auto taskObj = std::make_shared<Task>(entry.taskId,
+                                                  std::move(work),
+                                                  static_cast<TaskPriority>(level),
+                                                  sequence,
+                                                  ProgressCallback());
+            taskObj->journaled = true;
+            taskObj->recovered = true;
+            tasks.push(taskObj);
+            taskMap[entry.taskId] = taskObj;
+            pendingTasks++;
+            growForBacklogLocked();
+        }
+        condition.notify_one();
+        ++restored;
+    }
+    return restored;
+}
+
+size_t ThreadPool::getRecoveredTaskCount() const {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return recoveredTasks.size();
+}
+
+void ThreadPool::releaseJournalEntryLocked(const std::shared_ptr<Task>& task, JournalReleases& releases) {
+    if (task->journaled && !task->abandoned && journal) {
+        releases.journal = journal;
+        releases.taskIds.push_back(task->id);
+        task->journaled = false;
+    }
+}
+
+void ThreadPool::removeJournalEntries(const JournalReleases& releases) {
+    for (const auto& taskId : releases.taskIds) {
+        releases.journal->remove(taskId);
+    }
+}
+
+void ThreadPool::parkRecoveredTaskLocked(const std::shared_ptr<Task>& task, JournalReleases& releases) {
+    const auto now = std::chrono::steady_clock::now();
+    pruneRecoveredTasksLocked(now, releases);
+    if (recoveredTasks.size() >= kMaxRecoveredResults) {
+        auto oldest = std::min_element(recoveredTasks.begin(),
+                                       recoveredTasks.end(),
+                                       [](const auto& lhs, const auto& rhs) {
+                                           return lhs.second->parkedAt < rhs.second->parkedAt;
+                                       });
+        releaseJournalEntryLocked(oldest->second, releases);
+        recoveredTasks.erase(oldest);
+    }
+    task->parkedAt = now;
+    recoveredTasks[task->id] = task;
+}
+
+void ThreadPool::pruneRecoveredTasksLocked(std::chrono::steady_clock::time_point now, JournalReleases& releases) {
+    for (auto it = recoveredTasks.begin(); it != recoveredTasks.end();) {
+        if (now - it->second->parkedAt >= kRecoveredResultTtl) {
+            releaseJournalEntryLocked(it->second, releases);
+            it = recoveredTasks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+std::vector<std::shared_ptr<Task>> ThreadPool::takeQueuedTasksLocked() {
+    std::vector<std::shared_ptr<Task>> queued;
+    queued.reserve(tasks.size());
+    while (!tasks.empty()) {
+        auto task = tasks.top();
+        tasks.pop();
+        pendingTasks--;
+        taskMap.erase(task->id);
+        task->abandoned = true;
+        task->cancelled = true;
+        queued.push_back(std::move(task));
+    }
+    return queued;
+}
+
+std::vector<std::shared_ptr<Task>> ThreadPool::interruptRunningTasksLocked() {
+    std::vector<std::shared_ptr<Task>> running;
+    for (const auto& item : taskMap) {
+        const auto& task = item.second;
+        if (!task->started) {
+            continue;
+        }
+        task->abandoned = true;
+        task->cancelled = true;
+        {
+            std::lock_guard<std::mutex> taskLock(task->mutex);
+            if (task->finished) {
+                continue;
+            }
+            if (task->interruptHandler) {
+                task->interruptHandler();
+            }
+        }
+        running.push_back(task);
+    }
+    return running;
+}
+
+void ThreadPool::abandonTask(const std::shared_ptr<Task>& task, const char* message) {
+    {
+        std::lock_guard<std::mutex> taskLock(task->mutex);
+        if (task->finished) {
+            return;
+        }
+        task->result = makeCancelledResultWithPartial(*task);
+        task->result.errorMessage = message;
+        task->hasResult = true;
+        task->finished = true;
+    }
+    task->completionCv.notify_all();
+    deliverCompletion(task);
+}
+
 void ThreadPool::shutdown() {
+    shutdown(ShutdownOptions());
+}
+
+ShutdownReport ThreadPool::shutdown(const ShutdownOptions& options) {
+    ShutdownReport report;
+    const bool bounded = options.drainTimeout.count() >= 0;
+    const auto deadline = std::chrono::steady_clock::now() + std::max(options.drainTimeout, std::chrono::milliseconds(0));
+    std::vector<std::shared_ptr<Task>> cancelled;
+    std::vector<std::shared_ptr<Task>> interrupted;
+
+    size_t completedBefore = 0;
     {
         std::unique_lock<std::mutex> lock(queueMutex);
+        completedBefore = completedTasks.load();
         stop = true;
         paused = false;
+        if (options.mode != ShutdownMode::DRAIN) {
+            cancelled = takeQueuedTasksLocked();
+        } else {
+            // A lazy pool may have fewer workers than the queue needs to drain.
+            growForBacklogLocked();
+        }
+        if (options.mode == ShutdownMode::INTERRUPT_RUNNING) {
+            interrupted = interruptRunningTasksLocked();
+        }
     }
 
     condition.notify_all();
+    idleWindowCv.notify_all();
 
-    for (std::thread& worker : workers) {
-        if (worker.joinable()) {
-            worker.join();
+    for (const auto& task : cancelled) {
+        abandonTask(task, "ThreadForge shut down before the task started");
+    }
+    report.cancelled = cancelled.size();
+
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        auto workersExited = [this] { return liveWorkers == 0; };
+        if (bounded) {
+            if (!workersExitedCv.wait_until(lock, deadline, workersExited)) {
+                // Out of time: release every submitter with a definite status and leave
+                // the stuck workers behind. The pool stays stopped; its destructor joins
+                // the ones that have exited by then and detaches the rest.
+                auto remaining = takeQueuedTasksLocked();
+                report.cancelled += remaining.size();
+                cancelled.insert(cancelled.end(), remaining.begin(), remaining.end());
+                for (auto& task : interruptRunningTasksLocked()) {
+                    if (std::find(interrupted.begin(), interrupted.end(), task) == interrupted.end()) {
+                        interrupted.push_back(std::move(task));
+                    }
+                }
+                report.deadlineExceeded = true;
+                stragglers = true;
+            }
+        } else {
+            workersExitedCv.wait(lock, workersExited);
+        }
+        report.completed = completedTasks.load() - completedBefore;
+    }
+
+    for (const auto& task : cancelled) {
+        abandonTask(task, "ThreadForge shut down before the task started");
+    }
+    for (const auto& task : interrupted) {
+        abandonTask(task, "Task interrupted by ThreadForge shutdown");
+    }
+    report.interrupted = interrupted.size();
+
+    if (report.deadlineExceeded) {
+        return report;
+    }
+
+    for (auto& worker : workers) {
+        if (worker.thread.joinable()) {
+            worker.thread.join();
         }
     }
     workers.clear();
 
     {
         std::lock_guard<std::mutex> lock(queueMutex);
+        exitedWorkers.clear();
         tasks = decltype(tasks)();
         taskMap.clear();
+        recoveredTasks.clear();
         pendingTasks = 0;
         activeTasks = 0;
-        stop = false;
+        stop = retired;
         paused = false;
+        stragglers = false;
     }
+    return report;
+}
+
+bool ThreadPool::hasStragglers() const {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return stragglers;
+}
+
+void ThreadPool::retire() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    retired = true;
 }
 
 } // namespace threadforge
@@ -1,29 +1,59 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
 #include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "CpuTopology.h"
+#include "TaskJournal.h"
+#include "TaskQueue.h"
 #include "TaskResult.h"
 
 namespace threadforge {
 
-enum class TaskPriority {
-    LOW = 0,
-    NORMAL = 1,
-    HIGH = 2
+// A priority is any level in 0-255; higher levels run first and equal levels
+// run in submission order. The named values are presets in the middle of the
+// four classes that CPU quotas, core placement and memory pressure act on:
+// 0-63 idle, 64-127 low, 128-191 normal, 192-255 high.
+enum class TaskPriority : uint8_t {
+    // Idle-class tasks start only while the app reports an idle window (setIdle)
+    // and pause at checkpoints once interaction resumes.
+    IDLE = 32,
+    LOW = 64,
+    NORMAL = 128,
+    HIGH = 192
 };
 
+constexpr size_t kPriorityClassCount = 4;
+
+// Clamps a level from the bridge into 0-255.
+constexpr TaskPriority toPriorityLevel(int level) {
+    return static_cast<TaskPriority>(std::clamp(level, 0, kPriorityLevelCount - 1));
+}
+
+constexpr size_t priorityClassIndex(TaskPriority priority) {
+    return static_cast<size_t>(priority) >> 6;
+}
+
+constexpr bool isIdlePriority(TaskPriority priority) {
+    return priorityClassIndex(priority) == priorityClassIndex(TaskPriority::IDLE);
+}
+
 using ProgressCallback = std::function<void(double)>;
 using TaskFunction = std::function<TaskResult(const ProgressCallback&, const std::function<bool()>&)>;
+// Called once with the final result, on whichever thread settles the task (a
+// worker, a cancelTask() caller or shutdown). Must not block.
+using TaskCompletion = std::function<void(const TaskResult&)>;
 
 struct Task {
     std::string id;
@@ -39,27 +69,121 @@ struct Task {
     bool hasResult{false};
 
     ProgressCallback progress;
+    // Taken (and so invoked at most once) when the task finishes. Guarded by mutex.
+    TaskCompletion completion;
+    // Latest JSON value published by the task through setPartialResult().
+    std::string partialJson;
+
+    // The journal still holds this task's record. Cleared under queueMutex; the
+    // record itself is removed after the lock is released (JournalReleases).
+    bool journaled{false};
+    bool recovered{false};
+    bool claimed{false};
+    bool started{false};
+    // Set when shutdown abandons the task; its journal entry is kept for replay.
+    bool abandoned{false};
+    // When a finished recovered task was parked waiting to be claimed.
+    std::chrono::steady_clock::time_point parkedAt{};
+
+    // Installed by the executor while the task runs to abort it from another
+    // thread (e.g. by breaking out of the JS interpreter loop). Guarded by mutex.
+    std::function<void()> interruptHandler;
+
+    // Raised by trimMemory(); the executor collects garbage at its next checkpoint.
+    std::atomic<bool> trimRequested{false};
+
+    // Thread CPU time already charged to the task's CPU quota. Worker thread only.
+    int64_t cpuChargedAtNs{0};
 
     Task(std::string taskId, TaskFunction fn, TaskPriority prio, uint64_t seq, ProgressCallback callback)
         : id(std::move(taskId)), work(std::move(fn)), priority(prio), sequence(seq),
           progress(std::move(callback)) {}
 };
 
-struct TaskComparator {
-    bool operator()(const std::shared_ptr<Task>& lhs, const std::shared_ptr<Task>& rhs) const {
-        if (lhs->priority == rhs->priority) {
-            return lhs->sequence > rhs->sequence;
-        }
-        return static_cast<int>(lhs->priority) < static_cast<int>(rhs->priority);
-    }
+using JournalTaskFactory = std::function<TaskFunction(const JournalEntry&)>;
+
+enum class ShutdownMode {
+    // Keep executing queued tasks until the queue is empty or the deadline passes.
+    DRAIN = 0,
+    // Cancel queued tasks immediately and let running tasks finish until the deadline.
+    CANCEL_QUEUED = 1,
+    // Cancel queued tasks and interrupt running tasks immediately.
+    INTERRUPT_RUNNING = 2
 };
 
+struct ShutdownOptions {
+    ShutdownMode mode{ShutdownMode::DRAIN};
+    // Negative values wait for the queue to drain without a deadline.
+    std::chrono::milliseconds drainTimeout{-1};
+};
+
+struct ShutdownReport {
+    size_t completed{0};
+    size_t cancelled{0};
+    size_t interrupted{0};
+    bool deadlineExceeded{false};
+};
+
+std::string serializeShutdownReport(const ShutdownReport& report);
+
+enum class MemoryTrimLevel {
+    // Release idle workers above the configured floor.
+    MODERATE = 1,
+    // Release every idle worker, compact the journal and ask running tasks to collect garbage.
+    LOW = 2,
+    // Also drop unclaimed recovered results and reject new LOW priority work for a cooldown.
+    CRITICAL = 3
+};
+
+struct MemoryTrimReport {
+    size_t bytesFreed{0};
+    size_t workersReleased{0};
+    size_t resultsDropped{0};
+    bool lowPriorityPaused{false};
+};
+
+std::string serializeMemoryTrimReport(const MemoryTrimReport& report);
+
+// Share of one core a task class may use, averaged over period. Enforced by
+// workers between tasks and by executor checkpoints inside long tasks.
+struct CpuQuota {
+    // 0.3 means 30% of one core; values <= 0 disable the quota.
+    double coreShare{0.0};
+    std::chrono::milliseconds period{100};
+};
+
+// Shared between a worker thread and its pool so a destructor that gives up on
+// the worker can tell it the pool is gone (ThreadPool.cpp).
+struct WorkerLease;
+
 class ThreadPool {
 public:
     explicit ThreadPool(size_t numThreads = 4);
+    // Lazy pool: starts minThreads workers, spawns more (up to maxThreads) only when
+    // queued work outnumbers idle workers, and retires workers above the floor after
+    // idleTimeout without work. A zero idleTimeout keeps spawned workers forever.
+    ThreadPool(size_t maxThreads, size_t minThreads, std::chrono::milliseconds idleTimeout);
+    // Drains the queue, unless a shutdown already missed its deadline: then the
+    // stuck workers that have not exited yet are detached (and counted in
+    // detachedWorkerCount()) without waiting, so drainTimeout bounds teardown.
     ~ThreadPool();
 
-    TaskResult submitTask(const std::string& taskId, TaskPriority priority, TaskFunction task, ProgressCallback progress);
+    // Blocks the caller until the task settles.
+    TaskResult submitTask(const std::string& taskId,
+                          TaskPriority priority,
+                          TaskFunction task,
+                          ProgressCallback progress,
+                          std::string journalPayload = std::string());
+    // Queues the task and returns immediately. Rejected submissions come back as
+    // an already finished task carrying the error, so callers handle one shape.
+    std::shared_ptr<Task> enqueueTask(const std::string& taskId,
+                                      TaskPriority priority,
+                                      TaskFunction task,
+                                      ProgressCallback progress,
+                                      TaskCompletion completion = nullptr,
+                                      std::string journalPayload = std::string());
+    static TaskResult waitForTask(const std::shared_ptr<Task>& task);
+    static bool waitForTask(const std::shared_ptr<Task>& task, std::chrono::milliseconds timeout);
     bool cancelTask(const std::string& taskId);
     void pause();
     void resume();
@@ -70,24 +194,151 @@ public:
     size_t getActiveTaskCount() const;
 
     void setConcurrency(size_t threads);
+    void setIdlePolicy(size_t minThreads, std::chrono::milliseconds idleTimeout);
+    size_t getIdleThreadCount() const;
     size_t getQueueLimit() const;
     void setQueueLimit(size_t limit);
 
+    // The task being executed by the calling worker thread, or nullptr when the
+    // caller is not running inside a ThreadPool task.
+    static std::shared_ptr<Task> currentTask();
+    static void setPartialResult(std::string valueJson);
+    static void setInterruptHandler(std::function<void()> handler);
+    // True once per trimMemory() request that reached the calling worker's task.
+    static bool takeTrimRequest();
+
+    MemoryTrimReport trimMemory(MemoryTrimLevel level);
+
+    // With a heterogeneous topology, workers move onto performance cores for HIGH
+    // tasks and efficiency cores for LOW tasks before running them.
+    void setCpuTopology(std::shared_ptr<const CpuTopology> cpuTopology);
+
+    void setCpuQuota(TaskPriority priority, CpuQuota quota);
+    // Total time task classes have spent held back by their CPU quota.
+    std::chrono::milliseconds getThrottledTime() const;
+    // Charges the calling task's CPU time to its class and sleeps while the class
+    // is over quota. Called from executor checkpoints; no-op outside a task.
+    static void throttleCurrentTask();
+
+    // Opens or closes the window in which IDLE tasks may run. A non-negative
+    // window closes it automatically, e.g. at the end of a frame's spare budget.
+    void setIdle(bool idle, std::chrono::milliseconds window = std::chrono::milliseconds(-1));
+    bool isIdleWindowOpen() const;
+    // For IDLE tasks: true once the idle window has closed, so the task can save
+    // its state and return early. Always false for other classes.
+    static bool shouldYield();
+    // Blocks an IDLE task at a checkpoint until the idle window reopens, the task
+    // is cancelled or the pool shuts down. Its worker slot is lent to other work.
+    static void waitForIdleWindow();
+
+    void attachJournal(std::shared_ptr<TaskJournal> taskJournal);
+    // Stops journaling and returns the journal that was attached, if any. Its
+    // records are left as they are.
+    std::shared_ptr<TaskJournal> detachJournal();
+    bool isJournaling() const;
+    size_t restoreJournal(const JournalTaskFactory& factory);
+    size_t getRecoveredTaskCount() const;
+
     void shutdown();
+    // A shutdown that meets its deadline leaves the pool reusable. One that
+    // misses it settles every task, leaves the stuck workers running and keeps
+    // the pool stopped for good: it rejects new work, is never reused and should
+    // simply be dropped.
+    ShutdownReport shutdown(const ShutdownOptions& options);
+    bool hasStragglers() const;
+    // Marks a pool the process has let go of (setSharedThreadPool() does this
+    // for the pool it replaces). Its next shutdown leaves it stopped for good, so
+    // code still holding a pointer cannot revive it or spawn workers on it.
+    void retire();
+    // Workers left running by destroyed pools since the process started.
+    static size_t detachedWorkerCount();
 
 private:
-    void workerThread();
+    struct Worker {
+        std::thread thread;
+        std::shared_ptr<WorkerLease> lease;
+    };
+
+    void workerThread(const std::shared_ptr<WorkerLease>& lease);
+    static void settleRanTask(const std::shared_ptr<Task>& task, TaskResult taskResult, bool hasLocalResult);
+    void detachStragglers();
+    void spawnWorkerLocked();
+    void growForBacklogLocked();
+    size_t workerCapacityLocked() const;
+    bool idleWindowOpenLocked(std::chrono::steady_clock::time_point now) const;
+    void reapExitedWorkersLocked();
 
-    std::vector<std::thread> workers;
-    std::priority_queue<std::shared_ptr<Task>, std::vector<std::shared_ptr<Task>>, TaskComparator> tasks;
+    // Journal records to remove once queueMutex is released: a removal can
+    // compact the journal (write, fsync, rename), which must not stall the pool.
+    struct JournalReleases {
+        std::shared_ptr<TaskJournal> journal;
+        std::vector<std::string> taskIds;
+    };
+    void releaseJournalEntryLocked(const std::shared_ptr<Task>& task, JournalReleases& releases);
+    static void removeJournalEntries(const JournalReleases& releases);
+    // Unclaimed recovered results keep their journal record until they are
+    // claimed or dropped here, after a TTL or once the cap is reached.
+    void parkRecoveredTaskLocked(const std::shared_ptr<Task>& task, JournalReleases& releases);
+    void pruneRecoveredTasksLocked(std::chrono::steady_clock::time_point now, JournalReleases& releases);
+    std::vector<std::shared_ptr<Task>> takeQueuedTasksLocked();
+    std::vector<std::shared_ptr<Task>> interruptRunningTasksLocked();
+    static void abandonTask(const std::shared_ptr<Task>& task, const char* message);
+    static void deliverCompletion(const std::shared_ptr<Task>& task);
+    static std::shared_ptr<Task> makeSettledTask(const std::string& taskId,
+                                                 TaskPriority priority,
+                                                 TaskResult result,
+                                                 TaskCompletion completion);
+
+    struct CpuBudget {
+        CpuQuota quota;
+        double tokensNs{0.0};
+        std::chrono::steady_clock::time_point refilledAt{};
+        std::chrono::steady_clock::time_point throttledUntil{};
+    };
+    void chargeCpuTime(Task& task);
+    std::chrono::steady_clock::time_point throttledUntil(TaskPriority priority);
+    static void refillBudget(CpuBudget& budget, std::chrono::steady_clock::time_point now);
+
+    std::vector<Worker> workers;
+    TaskQueue tasks;
     std::unordered_map<std::string, std::shared_ptr<Task>> taskMap;
+    std::unordered_map<std::string, std::shared_ptr<Task>> recoveredTasks;
+    std::shared_ptr<TaskJournal> journal;
+    std::shared_ptr<const CpuTopology> topology;
 
     mutable std::mutex queueMutex;
     std::condition_variable condition;
+    std::condition_variable workersExitedCv;
+    size_t liveWorkers{0};
+    size_t targetWorkers{0};
+    size_t minWorkers{0};
+    // Live workers not currently executing a task (waiting or about to dequeue).
+    size_t idleWorkers{0};
+    std::chrono::milliseconds idleTimeout{0};
+    uint64_t idlePolicyEpoch{0};
+    // Idle workers asked to exit by trimMemory().
+    size_t pendingRetirements{0};
+    std::chrono::steady_clock::time_point lowPriorityResumeAt{};
+
+    bool appIdle{false};
+    bool idleWindowBounded{false};
+    std::chrono::steady_clock::time_point idleWindowEnd{};
+    // IDLE tasks parked at a checkpoint; each lends its worker slot to the pool.
+    size_t pausedIdleTasks{0};
+    std::condition_variable idleWindowCv;
+
+    // Indexed by priorityClassIndex(); guarded by quotaMutex, which nests inside queueMutex.
+    std::array<CpuBudget, kPriorityClassCount> cpuBudgets{};
+    mutable std::mutex quotaMutex;
+    std::atomic<int64_t> throttledNs{0};
+    std::vector<std::thread::id> exitedWorkers;
+    bool stragglers{false};
+    bool retired{false};
     std::atomic<bool> stop{false};
     std::atomic<bool> paused{false};
     std::atomic<size_t> pendingTasks{0};
     std::atomic<size_t> activeTasks{0};
+    std::atomic<size_t> completedTasks{0};
     std::atomic<uint64_t> sequenceCounter{0};
     std::atomic<size_t> queueLimit{0};
 };
@@ -0,0 +1,69 @@
+#include "TypedArrayView.h"
+
+#include <jsi/jsi.h>
+#include <string>
+
+namespace threadforge {
+
+namespace {
+
+using facebook::jsi::Runtime;
+using facebook::jsi::Value;
+
+FloatArrayView asFloatArray(const TypedArrayView& array) {
+    FloatArrayView view;
+    if (array.type == "Float64Array") {
+        view.f64 = reinterpret_cast<double*>(array.data);
+    } else if (array.type == "Float32Array") {
+        view.f32 = reinterpret_cast<float*>(array.data);
+    } else {
+        return view;
+    }
+    view.count = array.length;
+    return view;
+}
+
+} // namespace
+
+TypedArrayView typedArrayView(Runtime& rt, const Value& value) {
+    TypedArrayView view;
+    if (!value.isObject()) {
+        return view;
+    }
+    auto object = value.getObject(rt);
+    auto buffer = object.getProperty(rt, "buffer");
+    auto constructor = object.getProperty(rt, "constructor");
+    if (!buffer.isObject() || !buffer.getObject(rt).isArrayBuffer(rt) || !constructor.isObject()) {
+        return view;
+    }
+    const auto name = constructor.getObject(rt).getProperty(rt, "name");
+    auto type = name.isString() ? name.getString(rt).utf8(rt) : std::string();
+    if (type.size() < 6 || type.compare(type.size() - 5, 5, "Array") != 0) {
+        return view;
+    }
+    view.data = buffer.getObject(rt).getArrayBuffer(rt).data(rt) +
+        static_cast<size_t>(object.getProperty(rt, "byteOffset").asNumber());
+    view.length = static_cast<size_t>(object.getProperty(rt, "length").asNumber());
+    view.type = std::move(type);
+    return view;
+}
+
+FloatArrayView floatArrayView(Runtime& rt, const Value& value) {
+    return asFloatArray(typedArrayView(rt, value));
+}
+
+Value makeTypedArray(Runtime& rt, const char* type, size_t length, TypedArrayView& view) {
+    auto constructor = rt.global().getPropertyAsFunction(rt, type);
+    Value array = constructor.callAsConstructor(rt, static_cast<double>(length));
+    view = typedArrayView(rt, array);
+    return array;
+}
+
+Value makeFloatArray(Runtime& rt, bool float32, size_t count, FloatArrayView& view) {
+    TypedArrayView array;
+    Value result = makeTypedArray(rt, float32 ? "Float32Array" : "Float64Array", count, array);
+    view = asFloatArray(array);
+    return result;
+}
+
+} // namespace threadforge
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace facebook::jsi {
+class Runtime;
+class Value;
+} // namespace facebook::jsi
+
+namespace threadforge {
+
+// Raw view of any typed array: its constructor name ("Uint8Array", ...) and
+// storage. Same lifetime rules as FloatArrayView below.
+struct TypedArrayView {
+    std::string type;
+    uint8_t* data{nullptr};
+    size_t length{0};
+
+    bool valid() const {
+        return !type.empty();
+    }
+};
+
+// Empty view when value is not a typed array.
+TypedArrayView typedArrayView(facebook::jsi::Runtime& runtime, const facebook::jsi::Value& value);
+
+// Raw view of a Float64Array or Float32Array. Only valid while the calling
+// host function runs: the JS thread is parked there, so the buffer can neither
+// be collected nor modified.
+struct FloatArrayView {
+    double* f64{nullptr};
+    float* f32{nullptr};
+    size_t count{0};
+
+    bool valid() const {
+        return f64 != nullptr || f32 != nullptr;
+    }
+};
+
+// Empty view when value is anything else (plain arrays, other typed arrays).
+FloatArrayView floatArrayView(facebook::jsi::Runtime& runtime, const facebook::jsi::Value& value);
+
+// Allocates a new Float64Array (or Float32Array) of count elements in the
+// runtime and points view at its storage.
+facebook::jsi::Value makeFloatArray(facebook::jsi::Runtime& runtime,
+                                    bool float32,
+                                    size_t count,
+                                    FloatArrayView& view);
+
+// Same for any typed array constructor, e.g. "Uint32Array".
+facebook::jsi::Value makeTypedArray(facebook::jsi::Runtime& runtime,
+                                    const char* type,
+                                    size_t length,
+                                    TypedArrayView& view);
+
+} // namespace threadforge
@@ -0,0 +1,728 @@
+#include "VectorMath.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+#include "ParallelFor.h"
+#include "SimdVector.h"
+
+namespace threadforge::vmath {
+
+namespace {
+
+using simd::VecD;
+
+constexpr size_t kBlock = 256;
+constexpr size_t kParallelThreshold = 1 << 14;
+constexpr size_t kMaxNesting = 256;
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kE = 2.71828182845904523536;
+constexpr double kInfinity = std::numeric_limits<double>::infinity();
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+// Beyond this the three-part reduction by pi/2 loses bits, so such blocks
+// fall back to libm.
+constexpr double kTrigReductionLimit = 1e6;
+
+// pi/2 and ln 2 split so that k * hi is exact for the k we reach (fdlibm).
+constexpr double kPiOver2Hi = 1.57079632673412561417e+00;
+constexpr double kPiOver2Mid = 6.07710050630396597660e-11;
+constexpr double kPiOver2Lo = 2.02226624871116645580e-21;
+constexpr double kTwoOverPi = 6.36619772367581382433e-01;
+constexpr double kLn2Hi = 6.93147180369123816490e-01;
+constexpr double kLn2Lo = 1.90821492927058770002e-10;
+constexpr double kInvLn2 = 1.44269504088896338700e+00;
+constexpr double kSqrt2 = 1.41421356237309504880;
+
+// Taylor coefficients on the reduced ranges |r| <= pi/4 (sin, cos), |r| <=
+// ln2/2 (exp) and atanh series |s| <= 0.1716 (log). FAST drops the tail.
+constexpr double kSinHigh[] = {-1.0 / 6.0,
+                               1.0 / 120.0,
+                               -1.0 / 5040.0,
+                               1.0 / 362880.0,
+                               -1.0 / 39916800.0,
+                               1.0 / 6227020800.0,
+                               -1.0 / 1307674368000.0};
+constexpr double kSinFast[] = {-1.0 / 6.0, 1.0 / 120.0, -1.0 / 5040.0, 1.0 / 362880.0};
+constexpr double kCosHigh[] = {-1.0 / 2.0,
+                               1.0 / 24.0,
+                               -1.0 / 720.0,
+                               1.0 / 40320.0,
+                               -1.0 / 3628800.0,
+                               1.0 / 479001600.0,
+                               -1.0 / 87178291200.0,
+                               1.0 / 20922789888000.0};
+constexpr double kCosFast[] = {-1.0 / 2.0, 1.0 / 24.0, -1.0 / 720.0, 1.0 / 40320.0};
+constexpr double kExpHigh[] = {1.0,
+                               1.0,
+                               1.0 / 2.0,
+                               1.0 / 6.0,
+                               1.0 / 24.0,
+                               1.0 / 120.0,
+                               1.0 / 720.0,
+                               1.0 / 5040.0,
+                               1.0 / 40320.0,
+                               1.0 / 362880.0,
+                               1.0 / 3628800.0,
+                               1.0 / 39916800.0,
+                               1.0 / 479001600.0,
+                               1.0 / 6227020800.0};
+constexpr double kExpFast[] = {1.0, 1.0, 1.0 / 2.0, 1.0 / 6.0, 1.0 / 24.0, 1.0 / 120.0, 1.0 / 720.0, 1.0 / 5040.0};
+constexpr double kLogHigh[] = {1.0 / 3.0,
+                               1.0 / 5.0,
+                               1.0 / 7.0,
+                               1.0 / 9.0,
+                               1.0 / 11.0,
+                               1.0 / 13.0,
+                               1.0 / 15.0,
+                               1.0 / 17.0,
+                               1.0 / 19.0};
+constexpr double kLogFast[] = {1.0 / 3.0, 1.0 / 5.0, 1.0 / 7.0};
+
+// c[0] + z * (c[1] + z * (... + z * c[N - 1]))
+template <size_t N>
+VecD horner(VecD z, const double (&c)[N]) {
+    VecD result = simd::broadcast(c[N - 1]);
+    for (size_t i = N - 1; i > 0; --i) {
+        result = simd::add(simd::mul(result, z), simd::broadcast(c[i - 1]));
+    }
+    return result;
+}
+
+// sin(x) with quadrantShift 0, cos(x) with quadrantShift 1 (cos x = sin(x + pi/2),
+// applied to the quadrant instead of the argument so no precision is lost).
+template <bool kHigh>
+VecD sinCos(VecD x, double quadrantShift) {
+    const auto k = simd::roundNearest(simd::mul(x, simd::broadcast(kTwoOverPi)));
+    auto r = simd::sub(x, simd::mul(k, simd::broadcast(kPiOver2Hi)));
+    r = simd::sub(r, simd::mul(k, simd::broadcast(kPiOver2Mid)));
+    r = simd::sub(r, simd::mul(k, simd::broadcast(kPiOver2Lo)));
+    const auto r2 = simd::mul(r, r);
+
+    VecD sinR;
+    VecD cosR;
+    if constexpr (kHigh) {
+        sinR = simd::add(r, simd::mul(simd::mul(r, r2), horner(r2, kSinHigh)));
+        cosR = simd::add(simd::broadcast(1.0), simd::mul(r2, horner(r2, kCosHigh)));
+    } else {
+        sinR = simd::add(r, simd::mul(simd::mul(r, r2), horner(r2, kSinFast)));
+        cosR = simd::add(simd::broadcast(1.0), simd::mul(r2, horner(r2, kCosFast)));
+    }
+
+    // Quadrant q = (k + shift) mod 4; for integral q, floor(q / 4) == round((q - 1.5) / 4).
+    auto q = simd::add(k, simd::broadcast(quadrantShift));
+    q = simd::sub(q, simd::mul(simd::broadcast(4.0), simd::roundNearest(simd::mul(simd::sub(q, simd::broadcast(1.5)), simd::broadcast(0.25)))));
+    const auto upperHalf = simd::lessThan(simd::broadcast(1.5), q);
+    const auto odd = simd::lessThan(simd::broadcast(0.5), simd::select(upperHalf, simd::sub(q, simd::broadcast(2.0)), q));
+    const auto value = simd::select(odd, cosR, sinR);
+    return simd::select(upperHalf, simd::sub(simd::zero(), value), value);
+}
+
+template <bool kHigh>
+VecD exp(VecD x) {
+    // Clamped so that both 2^k halves stay normal; the final product then
+    // overflows to infinity or underflows to zero exactly once.
+    const auto clamped = simd::max(simd::min(x, simd::broadcast(710.0)), simd::broadcast(-746.0));
+    const auto k = simd::roundNearest(simd::mul(clamped, simd::broadcast(kInvLn2)));
+    auto r = simd::sub(clamped, simd::mul(k, simd::broadcast(kLn2Hi)));
+    r = simd::sub(r, simd::mul(k, simd::broadcast(kLn2Lo)));
+    const auto p = kHigh ? horner(r, kExpHigh) : horner(r, kExpFast);
+    const auto k1 = simd::roundNearest(simd::mul(k, simd::broadcast(0.5)));
+    const auto k2 = simd::sub(k, k1);
+    const auto result = simd::mul(simd::mul(p, simd::pow2(k1)), simd::pow2(k2));
+    return simd::select(simd::isNan(x), x, result);
+}
+
+template <bool kHigh>
+VecD log(VecD x) {
+    // Subnormals are scaled into the normal range first.
+    const auto tiny = simd::lessThan(x, simd::broadcast(std::numeric_limits<double>::min()));
+    const auto scaled = simd::select(tiny, simd::mul(x, simd::broadcast(18014398509481984.0)), x);
+    auto e = simd::sub(simd::biasedExponent(scaled), simd::select(tiny, simd::broadcast(1023.0 + 54.0), simd::broadcast(1023.0)));
+    auto m = simd::significand(scaled);
+    const auto big = simd::lessThan(simd::broadcast(kSqrt2), m);
+    m = simd::select(big, simd::mul(m, simd::broadcast(0.5)), m);
+    e = simd::select(big, simd::add(e, simd::broadcast(1.0)), e);
+
+    // log(m) = 2 atanh(s) with s = (m - 1) / (m + 1), |s| <= 0.1716.
+    const auto s = simd::div(simd::sub(m, simd::broadcast(1.0)), simd::add(m, simd::broadcast(1.0)));
+    const auto z = simd::mul(s, s);
+    const auto series = kHigh ? horner(z, kLogHigh) : horner(z, kLogFast);
+    const auto twoS = simd::add(s, s);
+    const auto logM = simd::add(twoS, simd::mul(simd::mul(twoS, z), series));
+    auto result = simd::add(simd::mul(e, simd::broadcast(kLn2Hi)), simd::add(logM, simd::mul(e, simd::broadcast(kLn2Lo))));
+
+    result = simd::select(simd::equal(x, simd::broadcast(kInfinity)), x, result);
+    result = simd::select(simd::equal(x, simd::zero()), simd::broadcast(-kInfinity), result);
+    return simd::select(simd::maskOr(simd::isNan(x), simd::lessThan(x, simd::zero())), simd::broadcast(kNaN), result);
+}
+
+VecD floor(VecD x) {
+    const auto rounded = simd::roundNearest(x);
+    return simd::select(simd::lessThan(x, rounded), simd::sub(rounded, simd::broadcast(1.0)), rounded);
+}
+
+// Math.min/Math.max semantics: NaN in either operand wins.
+VecD jsMin(VecD a, VecD b) {
+    return simd::select(simd::maskOr(simd::isNan(a), simd::isNan(b)), simd::add(a, b), simd::min(a, b));
+}
+
+VecD jsMax(VecD a, VecD b) {
+    return simd::select(simd::maskOr(simd::isNan(a), simd::isNan(b)), simd::add(a, b), simd::max(a, b));
+}
+
+// Scalar reference used for constant folding and STRICT evaluation.
+double applyScalar(Op op, double a, double b) {
+    switch (op) {
+        case Op::NEG:
+            return -a;
+        case Op::ABS:
+            return std::fabs(a);
+        case Op::FLOOR:
+            return std::floor(a);
+        case Op::SQRT:
+            return std::sqrt(a);
+        case Op::SIN:
+            return std::sin(a);
+        case Op::COS:
+            return std::cos(a);
+        case Op::TAN:
+            return std::tan(a);
+        case Op::EXP:
+            return std::exp(a);
+        case Op::LOG:
+            return std::log(a);
+        case Op::ADD:
+            return a + b;
+        case Op::SUB:
+            return a - b;
+        case Op::MUL:
+            return a * b;
+        case Op::DIV:
+            return a / b;
+        case Op::MIN:
+            return std::isnan(a) || std::isnan(b) ? kNaN : std::min(a, b);
+        case Op::MAX:
+            return std::isnan(a) || std::isnan(b) ? kNaN : std::max(a, b);
+        default:
+            return kNaN;
+    }
+}
+
+bool isBinary(Op op) {
+    return op == Op::ADD || op == Op::SUB || op == Op::MUL || op == Op::DIV || op == Op::MIN || op == Op::MAX;
+}
+
+struct Node {
+    Op op;
+    double constant{0.0};
+    std::unique_ptr<Node> left;
+    std::unique_ptr<Node> right;
+};
+
+std::unique_ptr<Node> makeConstant(double value) {
+    auto node = std::make_unique<Node>();
+    node->op = Op::CONST;
+    node->constant = value;
+    return node;
+}
+
+std::unique_ptr<Node> makeNode(Op op, std::unique_ptr<Node> left, std::unique_ptr<Node> right = nullptr) {
+    const bool foldable = left->op == Op::CONST && (!right || right->op == Op::CONST);
+    if (foldable) {
+        return makeConstant(applyScalar(op, left->constant, right ? right->constant : 0.0));
+    }
+    auto node = std::make_unique<Node>();
+    node->op = op;
+    node->left = std::move(left);
+    node->right = std::move(right);
+    return node;
+}
+
+struct FunctionInfo {
+    const char* name;
+    Op op;
+    size_t arity;
+};
+
+constexpr FunctionInfo kFunctions[] = {
+    {"sin", Op::SIN, 1},
+    {"cos", Op::COS, 1},
+    {"tan", Op::TAN, 1},
+    {"sqrt", Op::SQRT, 1},
+    {"log", Op::LOG, 1},
+    {"exp", Op::EXP, 1},
+    {"abs", Op::ABS, 1},
+    {"floor", Op::FLOOR, 1},
+    {"min", Op::MIN, 2},
+    {"max", Op::MAX, 2},
+};
+
+class Parser {
+public:
+    explicit Parser(const std::string& source) : source_(source) {}
+
+    std::unique_ptr<Node> parse() {
+        auto node = parseSum();
+        skipSpace();
+        if (pos_ < source_.size()) {
+            fail("Unexpected '" + std::string(1, source_[pos_]) + "'");
+        }
+        return node;
+    }
+
+private:
+    [[noreturn]] void fail(const std::string& message) const {
+        throw std::invalid_argument(message + " at position " + std::to_string(pos_) + " in expression");
+    }
+
+    void skipSpace() {
+        while (pos_ < source_.size() && std::isspace(static_cast<unsigned char>(source_[pos_]))) {
+            ++pos_;
+        }
+    }
+
+    bool accept(char c) {
+        skipSpace();
+        if (pos_ < source_.size() && source_[pos_] == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!accept(c)) {
+            fail(pos_ < source_.size() ? "Expected '" + std::string(1, c) + "'" : "Unexpected end");
+        }
+    }
+
+    std::unique_ptr<Node> parseSum() {
+        auto node = parseProduct();
+        while (true) {
+            if (accept('+')) {
+                node = makeNode(Op::ADD, std::move(node), parseProduct());
+            } else if (accept('-')) {
+                node = makeNode(Op::SUB, std::move(node), parseProduct());
+            } else {
+                return node;
+            }
+        }
+    }
+
+    std::unique_ptr<Node> parseProduct() {
+        auto node = parseUnary();
+        while (true) {
+            if (accept('*')) {
+                node = makeNode(Op::MUL, std::move(node), parseUnary());
+            } else if (accept('/')) {
+                node = makeNode(Op::DIV, std::move(node), parseUnary());
+            } else {
+                return node;
+            }
+        }
+    }
+
+    std::unique_ptr<Node> parseUnary() {
+        if (++depth_ > kMaxNesting) {
+            fail("Expression nested too deeply");
+        }
+        std::unique_ptr<Node> node;
+        if (accept('-')) {
+            node = makeNode(Op::NEG, parseUnary());
+        } else if (accept('+')) {
+            node = parseUnary();
+        } else {
+            node = parsePrimary();
+        }
+        --depth_;
+        return node;
+    }
+
+    std::unique_ptr<Node> parsePrimary() {
+        skipSpace();
+        if (pos_ >= source_.size()) {
+            fail("Unexpected end");
+        }
+        const char c = source_[pos_];
+        if (accept('(')) {
+            auto node = parseSum();
+            expect(')');
+            return node;
+        }
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            const char* start = source_.c_str() + pos_;
+            char* end = nullptr;
+            const double value = std::strtod(start, &end);
+            if (end == start) {
+                fail("Invalid number");
+            }
+            pos_ += static_cast<size_t>(end - start);
+            return makeConstant(value);
+        }
+        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            return parseIdentifier();
+        }
+        fail("Unexpected '" + std::string(1, c) + "'");
+    }
+
+    std::unique_ptr<Node> parseIdentifier() {
+        const size_t start = pos_;
+        while (pos_ < source_.size() &&
+               (std::isalnum(static_cast<unsigned char>(source_[pos_])) || source_[pos_] == '_' || source_[pos_] == '.')) {
+            ++pos_;
+        }
+        std::string name = source_.substr(start, pos_ - start);
+        if (name.rfind("Math.", 0) == 0) {
+            name = name.substr(5);
+        }
+
+        if (name == "x" || name == "y" || name == "i") {
+            auto node = std::make_unique<Node>();
+            node->op = name == "x" ? Op::LOAD_X : name == "y" ? Op::LOAD_Y : Op::LOAD_INDEX;
+            return node;
+        }
+        if (name == "pi" || name == "PI") {
+            return makeConstant(kPi);
+        }
+        if (name == "e" || name == "E") {
+            return makeConstant(kE);
+        }
+        for (const auto& function : kFunctions) {
+            if (name != function.name) {
+                continue;
+            }
+            expect('(');
+            auto first = parseSum();
+            std::unique_ptr<Node> second;
+            if (function.arity == 2) {
+                expect(',');
+                second = parseSum();
+            }
+            expect(')');
+            return makeNode(function.op, std::move(first), std::move(second));
+        }
+        pos_ = start;
+        fail("Unknown identifier '" + name + "'");
+    }
+
+    const std::string& source_;
+    size_t pos_{0};
+    size_t depth_{0};
+};
+
+Op immediateForm(Op op, bool constantOnLeft) {
+    switch (op) {
+        case Op::ADD:
+            return Op::ADD_K;
+        case Op::SUB:
+            return constantOnLeft ? Op::K_SUB : Op::SUB_K;
+        case Op::MUL:
+            return Op::MUL_K;
+        case Op::DIV:
+            return constantOnLeft ? Op::K_DIV : Op::DIV_K;
+        case Op::MIN:
+            return Op::MIN_K;
+        default:
+            return Op::MAX_K;
+    }
+}
+
+// Emits node in postfix order and tracks how many registers it needs.
+void emit(const Node& node, std::vector<Instruction>& program, size_t& depth, size_t& maxDepth) {
+    switch (node.op) {
+        case Op::CONST:
+        case Op::LOAD_X:
+        case Op::LOAD_Y:
+        case Op::LOAD_INDEX:
+            program.push_back({node.op, node.constant});
+            maxDepth = std::max(maxDepth, ++depth);
+            return;
+        default:
+            break;
+    }
+    if (!isBinary(node.op)) {
+        emit(*node.left, program, depth, maxDepth);
+        program.push_back({node.op});
+        return;
+    }
+    if (node.right->op == Op::CONST) {
+        emit(*node.left, program, depth, maxDepth);
+        program.push_back({immediateForm(node.op, false), node.right->constant});
+        return;
+    }
+    if (node.left->op == Op::CONST) {
+        emit(*node.right, program, depth, maxDepth);
+        program.push_back({immediateForm(node.op, true), node.left->constant});
+        return;
+    }
+    emit(*node.left, program, depth, maxDepth);
+    emit(*node.right, program, depth, maxDepth);
+    program.push_back({node.op});
+    --depth;
+}
+
+template <typename Fn>
+void mapLanes(double* a, size_t count, Fn fn) {
+    for (size_t j = 0; j < count; j += simd::kLanes) {
+        simd::store(a + j, fn(simd::load(a + j)));
+    }
+}
+
+template <typename Fn>
+void zipLanes(double* a, const double* b, size_t count, Fn fn) {
+    for (size_t j = 0; j < count; j += simd::kLanes) {
+        simd::store(a + j, fn(simd::load(a + j), simd::load(b + j)));
+    }
+}
+
+void loadOperand(Operand operand, size_t begin, size_t count, double* out) {
+    if (operand.f64) {
+        std::copy(operand.f64 + begin, operand.f64 + begin + count, out);
+    } else if (operand.f32) {
+        std::copy(operand.f32 + begin, operand.f32 + begin + count, out);
+    } else {
+        for (size_t j = 0; j < count; ++j) {
+            out[j] = static_cast<double>(begin + j);
+        }
+    }
+}
+
+template <bool kHigh>
+void transcendental(Op op, double* a, size_t count) {
+    switch (op) {
+        case Op::SIN:
+        case Op::COS:
+        case Op::TAN: {
+            const bool large = std::any_of(a, a + count, [](double v) {
+                return std::fabs(v) > kTrigReductionLimit;
+            });
+            if (large) {
+                for (size_t j = 0; j < count; ++j) {
+                    a[j] = applyScalar(op, a[j], 0.0);
+                }
+                return;
+            }
+            if (op == Op::SIN) {
+                mapLanes(a, count, [](VecD v) { return sinCos<kHigh>(v, 0.0); });
+            } else if (op == Op::COS) {
+                mapLanes(a, count, [](VecD v) { return sinCos<kHigh>(v, 1.0); });
+            } else {
+                mapLanes(a, count, [](VecD v) { return simd::div(sinCos<kHigh>(v, 0.0), sinCos<kHigh>(v, 1.0)); });
+            }
+            return;
+        }
+        case Op::EXP:
+            mapLanes(a, count, [](VecD v) { return exp<kHigh>(v); });
+            return;
+        default:
+            mapLanes(a, count, [](VecD v) { return log<kHigh>(v); });
+            return;
+    }
+}
+
+} // namespace
+
+bool parseAccuracy(const std::string& name, Accuracy& accuracy) {
+    if (name == "fast") {
+        accuracy = Accuracy::FAST;
+    } else if (name == "high") {
+        accuracy = Accuracy::HIGH;
+    } else if (name == "strict") {
+        accuracy = Accuracy::STRICT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+Expression::Expression(const std::string& source) {
+    const auto root = Parser(source).parse();
+    size_t depth = 0;
+    emit(*root, program_, depth, registerCount_);
+    for (const auto& instruction : program_) {
+        usesX_ = usesX_ || instruction.op == Op::LOAD_X;
+        usesY_ = usesY_ || instruction.op == Op::LOAD_Y;
+    }
+}
+
+bool Expression::usesX() const {
+    return usesX_;
+}
+
+bool Expression::usesY() const {
+    return usesY_;
+}
+
+// Runs the program over count (<= kBlock) elements starting at begin. The
+// result is left in the first register. Loops cover whole vectors; the lanes
+// past count read stale but initialized register values and are ignored.
+void Expression::runBlock(Operand x, Operand y, size_t begin, size_t count, Accuracy accuracy, double* registers) const {
+    const size_t lanes = (count + simd::kLanes - 1) / simd::kLanes * simd::kLanes;
+    size_t top = 0;
+    for (const auto& instruction : program_) {
+        // Top of the stack; loads and constants push above it instead.
+        double* a = registers + (top > 0 ? top - 1 : 0) * kBlock;
+        const auto k = simd::broadcast(instruction.constant);
+        switch (instruction.op) {
+            case Op::LOAD_X:
+            case Op::LOAD_Y:
+            case Op::LOAD_INDEX:
+                loadOperand(instruction.op == Op::LOAD_X ? x : instruction.op == Op::LOAD_Y ? y : Operand(),
+                            begin,
+                            count,
+                            registers + top * kBlock);
+                ++top;
+                break;
+            case Op::CONST:
+                std::fill(registers + top * kBlock, registers + top * kBlock + lanes, instruction.constant);
+                ++top;
+                break;
+            case Op::NEG:
+                mapLanes(a, lanes, [](VecD v) { return simd::sub(simd::zero(), v); });
+                break;
+            case Op::ABS:
+                mapLanes(a, lanes, [](VecD v) { return simd::abs(v); });
+                break;
+            case Op::FLOOR:
+                mapLanes(a, lanes, [](VecD v) { return floor(v); });
+                break;
+            case Op::SQRT:
+                mapLanes(a, lanes, [](VecD v) { return simd::sqrt(v); });
+                break;
+            case Op::SIN:
+            case Op::COS:
+            case Op::TAN:
+            case Op::EXP:
+            case Op::LOG:
+                if (accuracy == Accuracy::STRICT) {
+                    for (size_t j = 0; j < count; ++j) {
+                        a[j] = applyScalar(instruction.op, a[j], 0.0);
+                    }
+                } else if (accuracy == Accuracy::HIGH) {
+                    transcendental<true>(instruction.op, a, lanes);
+                } else {
+                    transcendental<false>(instruction.op, a, lanes);
+                }
+                break;
+            case Op::ADD:
+            case Op::SUB:
+            case Op::MUL:
+            case Op::DIV:
+            case Op::MIN:
+            case Op::MAX: {
+                double* left = a - kBlock;
+                const auto op = instruction.op;
+                zipLanes(left, a, lanes, [op](VecD l, VecD r) {
+                    switch (op) {
+                        case Op::ADD:
+                            return simd::add(l, r);
+                        case Op::SUB:
+                            return simd::sub(l, r);
+                        case Op::MUL:
+                            return simd::mul(l, r);
+                        case Op::DIV:
+                            return simd::div(l, r);
+                        case Op::MIN:
+                            return jsMin(l, r);
+                        default:
+                            return jsMax(l, r);
+                    }
+                });
+                --top;
+                break;
+            }
+            case Op::ADD_K:
+                mapLanes(a, lanes, [k](VecD v) { return simd::add(v, k); });
+                break;
+            case Op::SUB_K:
+                mapLanes(a, lanes, [k](VecD v) { return simd::sub(v, k); });
+                break;
+            case Op::K_SUB:
+                mapLanes(a, lanes, [k](VecD v) { return simd::sub(k, v); });
+                break;
+            case Op::MUL_K:
+                mapLanes(a, lanes, [k](VecD v) { return simd::mul(v, k); });
+                break;
+            case Op::DIV_K:
+                mapLanes(a, lanes, [k](VecD v) { return simd::div(v, k); });
+                break;
+            case Op::K_DIV:
+                mapLanes(a, lanes, [k](VecD v) { return simd::div(k, v); });
+                break;
+            case Op::MIN_K:
+                mapLanes(a, lanes, [k](VecD v) { return jsMin(v, k); });
+                break;
+            case Op::MAX_K:
+                mapLanes(a, lanes, [k](VecD v) { return jsMax(v, k); });
+                break;
+        }
+    }
+}
+
+template <typename Out>
+void Expression::evaluateInto(Operand x, Operand y, size_t count, Accuracy accuracy, Out* out) const {
+    auto range = [&](size_t begin, size_t end) {
+        std::vector<double> registers(registerCount_ * kBlock, 0.0);
+        for (size_t blockBegin = begin; blockBegin < end; blockBegin += kBlock) {
+            const size_t blockCount = std::min(kBlock, end - blockBegin);
+            runBlock(x, y, blockBegin, blockCount, accuracy, registers.data());
+            std::copy(registers.begin(), registers.begin() + static_cast<std::ptrdiff_t>(blockCount), out + blockBegin);
+        }
+    };
+    if (count < kParallelThreshold) {
+        range(0, count);
+        return;
+    }
+    const size_t grain = std::max<size_t>(kParallelThreshold / 2, (count / 64 + kBlock - 1) / kBlock * kBlock);
+    parallelFor(count, grain, range);
+}
+
+void Expression::evaluate(Operand x, Operand y, size_t count, Accuracy accuracy, double* out) const {
+    evaluateInto(x, y, count, accuracy, out);
+}
+
+void Expression::evaluate(Operand x, Operand y, size_t count, Accuracy accuracy, float* out) const {
+    evaluateInto(x, y, count, accuracy, out);
+}
+
+double Expression::sum(Operand x, Operand y, size_t count, Accuracy accuracy) const {
+    auto range = [&](size_t begin, size_t end) {
+        std::vector<double> registers(registerCount_ * kBlock, 0.0);
+        auto acc = simd::zero();
+        double tail = 0.0;
+        for (size_t blockBegin = begin; blockBegin < end; blockBegin += kBlock) {
+            const size_t blockCount = std::min(kBlock, end - blockBegin);
+            runBlock(x, y, blockBegin, blockCount, accuracy, registers.data());
+            size_t j = 0;
+            for (; j + simd::kLanes <= blockCount; j += simd::kLanes) {
+                acc = simd::add(acc, simd::load(registers.data() + j));
+            }
+            for (; j < blockCount; ++j) {
+                tail += registers[j];
+            }
+        }
+        return simd::horizontalSum(acc) + tail;
+    };
+    if (count < kParallelThreshold) {
+        return range(0, count);
+    }
+    const size_t grain = std::max<size_t>(kParallelThreshold / 2, (count / 64 + kBlock - 1) / kBlock * kBlock);
+    std::vector<double> partials((count + grain - 1) / grain, 0.0);
+    parallelFor(count, grain, [&](size_t begin, size_t end) {
+        partials[begin / grain] = range(begin, end);
+    });
+    double total = 0.0;
+    for (const double partial : partials) {
+        total += partial;
+    }
+    return total;
+}
+
+} // namespace threadforge::vmath
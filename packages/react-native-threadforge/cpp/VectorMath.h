@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace threadforge::vmath {
+
+// How transcendental functions (sin, cos, tan, exp, log) are evaluated. sqrt,
+// abs, floor and arithmetic are exact in every mode.
+enum class Accuracy {
+    // Short SIMD polynomials: errors around 1e-7 (absolute for sin, cos and
+    // tan; relative for exp and log).
+    FAST,
+    // Long SIMD polynomials: within a few ulp of libm.
+    HIGH,
+    // libm per element: bit-identical to the same expression in JS.
+    STRICT
+};
+
+// Parses "fast" / "high" / "strict".
+bool parseAccuracy(const std::string& name, Accuracy& accuracy);
+
+// Elementwise input. Leave both pointers null to read the element index
+// instead, which lets an expression generate data from i alone.
+struct Operand {
+    const double* f64{nullptr};
+    const float* f32{nullptr};
+};
+
+enum class Op : uint8_t {
+    LOAD_X,
+    LOAD_Y,
+    LOAD_INDEX,
+    CONST,
+    NEG,
+    ABS,
+    FLOOR,
+    SQRT,
+    SIN,
+    COS,
+    TAN,
+    EXP,
+    LOG,
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    MIN,
+    MAX,
+    // Binary operations with an immediate constant: x op k, or k op x for the
+    // non-commutative K_SUB and K_DIV.
+    ADD_K,
+    SUB_K,
+    K_SUB,
+    MUL_K,
+    DIV_K,
+    K_DIV,
+    MIN_K,
+    MAX_K
+};
+
+// One step of the stack program an Expression compiles to.
+struct Instruction {
+    Op op;
+    double constant{0.0};
+};
+
+// A compiled elementwise expression over x, y and the element index i, e.g.
+// "sin(x / 40) + cos(i / 23)". Supports + - * /, unary minus, parentheses,
+// numeric literals, pi and e, and sin cos tan sqrt log exp abs floor min max
+// (a "Math." prefix is accepted). Constant sub-expressions are folded once.
+//
+// Evaluation is fused: each block of elements runs through the whole program
+// while it is in cache, instead of materializing one array per operation.
+class Expression {
+public:
+    // Throws std::invalid_argument with the offending position on parse errors.
+    explicit Expression(const std::string& source);
+
+    bool usesX() const;
+    bool usesY() const;
+
+    // out[k] = f(x[k], y[k], k) for k in [0, count). Large inputs are split
+    // across the shared pool with parallelFor().
+    void evaluate(Operand x, Operand y, size_t count, Accuracy accuracy, double* out) const;
+    void evaluate(Operand x, Operand y, size_t count, Accuracy accuracy, float* out) const;
+
+    // Sum of f over [0, count) without materializing the results.
+    double sum(Operand x, Operand y, size_t count, Accuracy accuracy) const;
+
+private:
+    template <typename Out>
+    void evaluateInto(Operand x, Operand y, size_t count, Accuracy accuracy, Out* out) const;
+    void runBlock(Operand x, Operand y, size_t begin, size_t count, Accuracy accuracy, double* registers) const;
+
+    std::vector<Instruction> program_;
+    size_t registerCount_{0};
+    bool usesX_{false};
+    bool usesY_{false};
+};
+
+} // namespace threadforge::vmath
@@ -0,0 +1,148 @@
+#include "VectorMathBindings.h"
+
+#include <cmath>
+#include <jsi/jsi.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "BindingHelpers.h"
+#include "SimdVector.h"
+#include "TypedArrayView.h"
+#include "VectorMath.h"
+
+namespace threadforge {
+
+namespace {
+
+using facebook::jsi::JSError;
+using facebook::jsi::Object;
+using facebook::jsi::Runtime;
+using facebook::jsi::String;
+using facebook::jsi::Value;
+
+// Workers tend to evaluate the same handful of expressions in a loop; the
+// cache is per runtime and simply starts over once it fills up.
+constexpr size_t kMaxCachedExpressions = 64;
+
+using ExpressionCache = std::unordered_map<std::string, std::shared_ptr<const vmath::Expression>>;
+
+std::shared_ptr<const vmath::Expression> compile(Runtime& rt, ExpressionCache& cache, const Value& source) {
+    if (!source.isString()) {
+        throw JSError(rt, "nativeMath expects an expression string as its first argument");
+    }
+    auto text = source.getString(rt).utf8(rt);
+    const auto found = cache.find(text);
+    if (found != cache.end()) {
+        return found->second;
+    }
+    auto expression = std::make_shared<const vmath::Expression>(text);
+    if (cache.size() >= kMaxCachedExpressions) {
+        cache.clear();
+    }
+    cache.emplace(std::move(text), expression);
+    return expression;
+}
+
+vmath::Operand operandOf(const FloatArrayView& view) {
+    return vmath::Operand{view.f64, view.f32};
+}
+
+// The x input and optional { y, out, accuracy } shared by map() and sum().
+struct Call {
+    std::shared_ptr<const vmath::Expression> expression;
+    vmath::Operand x;
+    vmath::Operand y;
+    size_t count{0};
+    bool float32{false};
+    vmath::Accuracy accuracy{vmath::Accuracy::HIGH};
+    FloatArrayView out;
+    Value outValue;
+};
+
+Call readCall(Runtime& rt, ExpressionCache& cache, const Value* args, size_t argCount, const char* function) {
+    const std::string name = std::string("nativeMath.") + function;
+    Call call;
+    call.expression = compile(rt, cache, argumentAt(args, argCount, 0));
+
+    const auto& input = argumentAt(args, argCount, 1);
+    if (input.isNumber()) {
+        const double length = input.getNumber();
+        if (!(length >= 0 && length <= 9007199254740992.0) || length != std::floor(length)) {
+            throw JSError(rt, name + " expects a non-negative integer length");
+        }
+        // Null operands make x the element index.
+        call.count = static_cast<size_t>(length);
+    } else {
+        const auto view = floatArrayView(rt, input);
+        if (!view.valid()) {
+            throw JSError(rt, name + " expects a Float64Array, Float32Array or length as its second argument");
+        }
+        call.x = operandOf(view);
+        call.count = view.count;
+        call.float32 = view.f32 != nullptr;
+    }
+
+    const auto& options = argumentAt(args, argCount, 2);
+    if (!options.isUndefined() && !options.isNull()) {
+        if (!options.isObject()) {
+            throw JSError(rt, name + " expects an options object as its third argument");
+        }
+        const auto object = options.getObject(rt);
+        const auto y = object.getProperty(rt, "y");
+        if (!y.isUndefined()) {
+            const auto view = floatArrayView(rt, y);
+            if (!view.valid() || view.count < call.count) {
+                throw JSError(rt, name + " expects options.y to be a Float64Array or Float32Array at least as long as the input");
+            }
+            call.y = operandOf(view);
+        }
+        auto out = object.getProperty(rt, "out");
+        if (!out.isUndefined()) {
+            call.out = floatArrayView(rt, out);
+            if (!call.out.valid() || call.out.count != call.count) {
+                throw JSError(rt, name + " expects options.out to be a Float64Array or Float32Array of the input's length");
+            }
+            call.outValue = std::move(out);
+        }
+        const auto accuracy = object.getProperty(rt, "accuracy");
+        if (!accuracy.isUndefined() &&
+            (!accuracy.isString() || !vmath::parseAccuracy(accuracy.getString(rt).utf8(rt), call.accuracy))) {
+            throw JSError(rt, name + " expects options.accuracy to be 'fast', 'high' or 'strict'");
+        }
+    }
+    if (call.expression->usesY() && call.y.f64 == nullptr && call.y.f32 == nullptr) {
+        throw JSError(rt, name + " uses y but options.y was not given");
+    }
+    return call;
+}
+
+} // namespace
+
+void installVectorMathBindings(Runtime& rt) {
+    auto cache = std::make_shared<ExpressionCache>();
+    Object nativeMath(rt);
+    nativeMath.setProperty(rt, "backend", String::createFromAscii(rt, simd::kBackend));
+
+    setFunction(rt, nativeMath, "map", 3, [cache](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        auto call = readCall(runtime, *cache, args, count, "map");
+        // out may be x or y itself: each block is read before it is written.
+        auto result = call.out.valid() ? std::move(call.outValue)
+                                       : makeFloatArray(runtime, call.float32, call.count, call.out);
+        if (call.out.f64) {
+            call.expression->evaluate(call.x, call.y, call.count, call.accuracy, call.out.f64);
+        } else {
+            call.expression->evaluate(call.x, call.y, call.count, call.accuracy, call.out.f32);
+        }
+        return result;
+    });
+
+    setFunction(rt, nativeMath, "sum", 3, [cache](Runtime& runtime, const Value&, const Value* args, size_t count) {
+        const auto call = readCall(runtime, *cache, args, count, "sum");
+        return Value(call.expression->sum(call.x, call.y, call.count, call.accuracy));
+    });
+
+    rt.global().setProperty(rt, "nativeMath", nativeMath);
+}
+
+} // namespace threadforge
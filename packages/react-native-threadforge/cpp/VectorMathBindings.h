@@ -0,0 +1,21 @@
+#pragma once
+
+namespace facebook::jsi {
+class Runtime;
+} // namespace facebook::jsi
+
+namespace threadforge {
+
+// Installs the global `nativeMath` object in a worker runtime. Expressions use
+// the syntax described in VectorMath.h and are compiled once per runtime:
+//
+//     nativeMath.map('sin(x) * cos(x / 10)', values)      // new Float64Array (Float32Array in, Float32Array out)
+//     nativeMath.map('x * y', a, { y: b, out: a })        // writes into out
+//     nativeMath.map('sin(x / 40)', 600000)               // x is the index when given a length
+//     nativeMath.sum('sqrt(x)', 5000000, { accuracy: 'fast' })
+//     nativeMath.backend                                  // "avx" | "sse2" | "neon" | "scalar"
+//
+// accuracy is 'fast', 'high' (default) or 'strict'.
+void installVectorMathBindings(facebook::jsi::Runtime& runtime);
+
+} // namespace threadforge
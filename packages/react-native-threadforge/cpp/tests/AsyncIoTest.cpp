@@ -0,0 +1,269 @@
+#include "AsyncIo.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "TempDir.h"
+
+namespace threadforge::io {
+namespace {
+
+using namespace std::chrono_literals;
+
+std::vector<uint8_t> bytesOf(const std::string& text) {
+    return {text.begin(), text.end()};
+}
+
+std::string textOf(const std::vector<uint8_t>& bytes) {
+    return {bytes.begin(), bytes.end()};
+}
+
+std::string readText(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+Request readRequest(const std::string& path, uint64_t offset = 0, uint64_t length = 0) {
+    Request request;
+    request.path = path;
+    request.offset = offset;
+    request.length = length;
+    return request;
+}
+
+Request writeRequest(const std::string& path, const std::string& text, WriteMode mode, uint64_t offset = 0) {
+    Request request;
+    request.operation = Operation::WRITE;
+    request.path = path;
+    request.data = bytesOf(text);
+    request.mode = mode;
+    request.offset = offset;
+    return request;
+}
+
+#ifdef THREADFORGE_TEST_IO_THREADS
+// The same tests again on the I/O thread pool, which Linux hosts with
+// io_uring would otherwise never reach.
+class ThreadBackend : public ::testing::Environment {
+public:
+    void SetUp() override {
+        disableUring();
+    }
+};
+const auto* const kThreadBackend = ::testing::AddGlobalTestEnvironment(new ThreadBackend);
+#endif
+
+// Batches driven by hand, the way the engines settle them.
+
+TEST(AsyncIoBatchTest, IsDoneOnlyAfterTheLastRequestSettles) {
+    Batch batch({readRequest("a"), readRequest("b"), readRequest("c")});
+    EXPECT_FALSE(batch.isDone());
+
+    // Completion order need not follow request order.
+    batch.result(2).transferred = 2;
+    batch.settle(2);
+    batch.result(0).transferred = 0;
+    batch.settle(0);
+    EXPECT_FALSE(batch.isDone());
+    EXPECT_FALSE(batch.waitFor(10ms));
+
+    std::thread last([&batch] {
+        std::this_thread::sleep_for(20ms);
+        batch.fail(1, ENOENT, "cannot open");
+    });
+    batch.wait();
+    last.join();
+    EXPECT_TRUE(batch.isDone());
+
+    const auto& results = batch.results();
+    EXPECT_EQ(results[0].transferred, 0u);
+    EXPECT_EQ(results[2].transferred, 2u);
+    EXPECT_EQ(results[1].error, ENOENT);
+    EXPECT_EQ(results[1].message, std::string("cannot open b: ") + std::strerror(ENOENT));
+    EXPECT_TRUE(Batch({}).isDone());
+}
+
+TEST(AsyncIoBatchTest, CancellableWaitsTimeOutOrStopOnTheFlag) {
+    Batch batch({readRequest("a")});
+    const auto never = [] {
+        return false;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(batch.waitFor(60ms, never), WaitStatus::TIMED_OUT);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 60ms);
+    EXPECT_EQ(batch.waitFor(0ms, never), WaitStatus::TIMED_OUT);
+
+    std::atomic<bool> cancelled{false};
+    std::thread canceller([&cancelled] {
+        std::this_thread::sleep_for(50ms);
+        cancelled.store(true);
+    });
+    start = std::chrono::steady_clock::now();
+    EXPECT_EQ(batch.waitFor(std::chrono::milliseconds::max(),
+                            [&cancelled] {
+                                return cancelled.load();
+                            }),
+              WaitStatus::CANCELLED);
+    const auto waited = std::chrono::steady_clock::now() - start;
+    canceller.join();
+    EXPECT_GE(waited, 50ms);
+    EXPECT_LT(waited, 50ms + 20 * kCancelPoll);
+
+    // Cancelling the wait leaves the batch running; once it is done, done wins.
+    EXPECT_FALSE(batch.isDone());
+    batch.settle(0);
+    EXPECT_EQ(batch.waitFor(0ms,
+                            [] {
+                                return true;
+                            }),
+              WaitStatus::DONE);
+    EXPECT_EQ(batch.waitFor(std::chrono::milliseconds::max(), nullptr), WaitStatus::DONE);
+}
+
+// Batches run by the engine.
+
+class AsyncIoTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        for (size_t i = 0; i < kDataSize; ++i) {
+            data_ += static_cast<char>('A' + (i * 7 + i / 251) % 26);
+        }
+        path_ = dir_.file("data.bin");
+        std::ofstream(path_, std::ios::binary) << data_;
+    }
+
+    static constexpr size_t kDataSize = 1 << 20;
+    threadforge::testing::TempDir dir_;
+    std::string data_;
+    std::string path_;
+};
+
+TEST_F(AsyncIoTest, ReportsItsBackend) {
+    const std::string name = backend();
+#ifdef THREADFORGE_TEST_IO_THREADS
+    EXPECT_EQ(name, "threads");
+#else
+    EXPECT_TRUE(name == "io_uring" || name == "threads") << name;
+#endif
+}
+
+TEST_F(AsyncIoTest, ReadsEachRequestIntoItsOwnSlot) {
+    // More requests than the ring holds, so some wait in the engine's queue.
+    std::vector<Request> requests;
+    for (uint64_t i = 0; i < 300; ++i) {
+        requests.push_back(readRequest(path_, i * 3331 % kDataSize, 1 + i * 17 % 9000));
+    }
+    requests.push_back(readRequest(path_));
+    requests.push_back(readRequest(path_, kDataSize - 10, 100));
+    requests.push_back(readRequest(path_, kDataSize + 5, 10));
+
+    const auto batch = submit(requests);
+    EXPECT_EQ(batch->waitFor(std::chrono::milliseconds(30000), nullptr), WaitStatus::DONE);
+    const auto& results = batch->results();
+    ASSERT_EQ(results.size(), requests.size());
+    for (size_t i = 0; i < 300; ++i) {
+        const auto& request = requests[i];
+        ASSERT_EQ(results[i].error, 0) << results[i].message;
+        const auto expected = data_.substr(request.offset, request.length);
+        EXPECT_EQ(results[i].transferred, expected.size()) << i;
+        EXPECT_EQ(textOf(results[i].data), expected) << i;
+    }
+    EXPECT_EQ(textOf(results[300].data), data_);
+    // Short at the end of the file, empty past it.
+    EXPECT_EQ(textOf(results[301].data), data_.substr(kDataSize - 10));
+    EXPECT_EQ(results[302].error, 0);
+    EXPECT_TRUE(results[302].data.empty());
+}
+
+TEST_F(AsyncIoTest, FailuresStayWithTheirRequest) {
+    const auto missing = dir_.file("missing.bin");
+    const auto batch = submit({readRequest(path_, 0, 4),
+                               readRequest(missing),
+                               writeRequest(dir_.file("no-such-dir/out.bin"), "x", WriteMode::REPLACE),
+                               readRequest(path_, 4, 4)});
+    batch->wait();
+    const auto& results = batch->results();
+    EXPECT_EQ(textOf(results[0].data), data_.substr(0, 4));
+    EXPECT_EQ(results[1].error, ENOENT);
+    EXPECT_NE(results[1].message.find(missing), std::string::npos);
+    EXPECT_EQ(results[2].error, ENOENT);
+    EXPECT_EQ(results[2].message.rfind("cannot write", 0), 0u);
+    EXPECT_EQ(textOf(results[3].data), data_.substr(4, 4));
+}
+
+TEST_F(AsyncIoTest, WritesInEachMode) {
+    const auto out = dir_.file("out.txt");
+    const auto run = [](std::vector<Request> requests) {
+        const auto batch = submit(std::move(requests));
+        batch->wait();
+        for (const auto& result : batch->results()) {
+            EXPECT_EQ(result.error, 0) << result.message;
+        }
+        return batch;
+    };
+
+    EXPECT_EQ(run({writeRequest(out, "hello world", WriteMode::REPLACE)})->results()[0].transferred, 11u);
+    run({writeRequest(out, "!!", WriteMode::APPEND)});
+    EXPECT_EQ(readText(out), "hello world!!");
+    run({writeRequest(out, "W", WriteMode::OVERWRITE, 6)});
+    EXPECT_EQ(readText(out), "hello World!!");
+    run({writeRequest(out, "bye", WriteMode::REPLACE)});
+    EXPECT_EQ(readText(out), "bye");
+
+    // Distinct files in one batch, then read back in the next.
+    std::vector<Request> writes;
+    std::vector<Request> reads;
+    for (int i = 0; i < 40; ++i) {
+        const auto path = dir_.file("part-" + std::to_string(i));
+        const std::string text(static_cast<size_t>(i) * 1000, static_cast<char>('a' + i % 26));
+        writes.push_back(writeRequest(path, text, WriteMode::REPLACE));
+        reads.push_back(readRequest(path));
+    }
+    run(writes);
+    const auto batch = run(reads);
+    for (size_t i = 0; i < reads.size(); ++i) {
+        EXPECT_EQ(textOf(batch->results()[i].data), textOf(writes[i].data));
+    }
+}
+
+TEST_F(AsyncIoTest, ConcurrentBatchesSettleIndependently) {
+    std::vector<std::thread> submitters;
+    std::atomic<int> mismatches{0};
+    for (int t = 0; t < 8; ++t) {
+        submitters.emplace_back([&, t] {
+            for (int round = 0; round < 25; ++round) {
+                std::vector<Request> requests;
+                for (int i = 0; i < 8; ++i) {
+                    const auto offset = static_cast<uint64_t>((t * 1000 + round * 37 + i) * 101);
+                    requests.push_back(readRequest(path_, offset, 64));
+                }
+                const auto batch = submit(requests);
+                batch->wait();
+                for (size_t i = 0; i < requests.size(); ++i) {
+                    if (textOf(batch->results()[i].data) != data_.substr(requests[i].offset, 64)) {
+                        mismatches.fetch_add(1);
+                    }
+                }
+            }
+        });
+    }
+    for (auto& submitter : submitters) {
+        submitter.join();
+    }
+    EXPECT_EQ(mismatches.load(), 0);
+}
+
+} // namespace
+} // namespace threadforge::io
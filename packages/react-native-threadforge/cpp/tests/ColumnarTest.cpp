@@ -0,0 +1,212 @@
+#include "Columnar.h"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "SharedPool.h"
+
+namespace threadforge::columnar {
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+template <typename T>
+Column column(ColumnType type, const std::vector<T>& values) {
+    return Column{type, values.data(), values.size()};
+}
+
+// Sales-like rows: region code (uint8), month (int32), amount (float64 with a
+// few NaN), flags (uint16).
+struct Sales {
+    std::vector<uint8_t> region;
+    std::vector<int32_t> month;
+    std::vector<double> amount;
+    std::vector<uint16_t> flags;
+
+    explicit Sales(size_t rows, uint32_t seed = 7) {
+        std::mt19937 rng(seed);
+        for (size_t r = 0; r < rows; ++r) {
+            region.push_back(static_cast<uint8_t>(rng() % 5));
+            month.push_back(static_cast<int32_t>(1 + rng() % 12));
+            amount.push_back(r % 97 == 0 ? kNaN : static_cast<double>(rng() % 10'000) / 100.0);
+            flags.push_back(static_cast<uint16_t>(1u << (rng() % 4)));
+        }
+    }
+
+    Query query() const {
+        Query query;
+        query.columns = {column(ColumnType::UINT8, region), column(ColumnType::INT32, month),
+                         column(ColumnType::FLOAT64, amount), column(ColumnType::UINT16, flags)};
+        return query;
+    }
+};
+
+struct Expected {
+    double count{0};
+    double sum{0};
+    double min{kNaN};
+    double max{kNaN};
+    uint32_t flags{0};
+};
+
+// amount > 10, grouped by (region, month): count, sum, min, max, or(flags).
+std::map<std::pair<uint32_t, uint32_t>, Expected> reference(const Sales& sales) {
+    std::map<std::pair<uint32_t, uint32_t>, Expected> groups;
+    for (size_t r = 0; r < sales.region.size(); ++r) {
+        if (!(sales.amount[r] > 10.0)) {
+            continue;
+        }
+        auto& group = groups[{sales.region[r], static_cast<uint32_t>(sales.month[r])}];
+        group.count++;
+        group.sum += sales.amount[r];
+        group.min = std::isnan(group.min) ? sales.amount[r] : std::min(group.min, sales.amount[r]);
+        group.max = std::isnan(group.max) ? sales.amount[r] : std::max(group.max, sales.amount[r]);
+        group.flags |= sales.flags[r];
+    }
+    return groups;
+}
+
+Query groupedQuery(const Sales& sales) {
+    auto query = sales.query();
+    query.filters = {{2, Compare::GT, 10.0}};
+    query.groupBy = {0, 1};
+    query.aggregations = {{Aggregate::COUNT},
+                          {Aggregate::SUM, 2},
+                          {Aggregate::MIN, 2},
+                          {Aggregate::MAX, 2},
+                          {Aggregate::OR, 3}};
+    return query;
+}
+
+void expectMatches(const GroupedResult& result, const std::map<std::pair<uint32_t, uint32_t>, Expected>& expected) {
+    ASSERT_EQ(result.groups, expected.size());
+    size_t g = 0;
+    for (const auto& [key, group] : expected) {
+        EXPECT_EQ(result.keys[0][g], key.first);
+        EXPECT_EQ(result.keys[1][g], key.second);
+        EXPECT_EQ(result.values[0][g], group.count);
+        EXPECT_NEAR(result.values[1][g], group.sum, 1e-9 * group.count);
+        EXPECT_EQ(result.values[2][g], group.min);
+        EXPECT_EQ(result.values[3][g], group.max);
+        EXPECT_EQ(result.values[4][g], group.flags);
+        ++g;
+    }
+}
+
+TEST(ColumnarTest, GroupsSmallInputsLikeAReferenceLoop) {
+    const Sales sales(5'000);
+    GroupedResult result;
+    ASSERT_TRUE(aggregate(groupedQuery(sales), result));
+    expectMatches(result, reference(sales));
+}
+
+TEST(ColumnarTest, ChunkedAggregationIsIndependentOfThePool) {
+    const Sales sales(kParallelThreshold * 4 + 123, 11);
+    const auto query = groupedQuery(sales);
+    GroupedResult inlineResult;
+    ASSERT_TRUE(aggregate(query, inlineResult));
+    expectMatches(inlineResult, reference(sales));
+
+    setSharedThreadPool(std::make_shared<ThreadPool>(4));
+    GroupedResult pooled;
+    ASSERT_TRUE(aggregate(query, pooled));
+    setSharedThreadPool(nullptr);
+    EXPECT_EQ(pooled.keys, inlineResult.keys);
+    EXPECT_EQ(pooled.values, inlineResult.values);
+}
+
+TEST(ColumnarTest, SparseKeysUseAHashTableAndStayOrdered) {
+    // Keys near 2^32 make the key space far too large for direct tables.
+    const std::vector<uint32_t> ids{4'000'000'000u, 7u, 4'000'000'000u, 123'456'789u, 7u, 7u};
+    const std::vector<uint32_t> buckets{2, 1, 2, 0, 1, 3};
+    const std::vector<float> weight{1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f};
+    Query query;
+    query.columns = {column(ColumnType::UINT32, ids), column(ColumnType::UINT32, buckets),
+                     column(ColumnType::FLOAT32, weight)};
+    query.groupBy = {0, 1};
+    query.aggregations = {{Aggregate::SUM, 2}};
+
+    GroupedResult result;
+    ASSERT_TRUE(aggregate(query, result));
+    EXPECT_EQ(result.keys[0], (std::vector<uint32_t>{7u, 7u, 123'456'789u, 4'000'000'000u}));
+    EXPECT_EQ(result.keys[1], (std::vector<uint32_t>{1, 3, 0, 2}));
+    EXPECT_EQ(result.values[0], (std::vector<double>{7.0, 6.0, 4.0, 4.0}));
+}
+
+TEST(ColumnarTest, WithoutGroupByYieldsOneGroupEvenWhenNothingMatches) {
+    const std::vector<double> values{1.0, kNaN, 3.0};
+    Query query;
+    query.columns = {column(ColumnType::FLOAT64, values)};
+    query.aggregations = {{Aggregate::COUNT}, {Aggregate::MIN, 0}};
+
+    GroupedResult result;
+    query.filters = {{0, Compare::NE, 2.0}};
+    ASSERT_TRUE(aggregate(query, result));
+    ASSERT_EQ(result.groups, 1u);
+    // NaN only passes "!=", and MIN skips it.
+    EXPECT_EQ(result.values[0][0], 3.0);
+    EXPECT_EQ(result.values[1][0], 1.0);
+
+    query.filters = {{0, Compare::GT, 100.0}};
+    ASSERT_TRUE(aggregate(query, result));
+    ASSERT_EQ(result.groups, 1u);
+    EXPECT_EQ(result.values[0][0], 0.0);
+    EXPECT_TRUE(std::isnan(result.values[1][0]));
+}
+
+TEST(ColumnarTest, RejectsMalformedQueries) {
+    const std::vector<double> a{1.0, 2.0};
+    const std::vector<double> shorter{1.0};
+    const std::vector<double> fractional{0.5, 1.0};
+    const std::vector<int8_t> negative{1, -1};
+
+    Query query;
+    query.columns = {column(ColumnType::FLOAT64, a), column(ColumnType::FLOAT64, shorter)};
+    GroupedResult result;
+    EXPECT_THROW(aggregate(query, result), std::invalid_argument);
+
+    query.columns = {column(ColumnType::FLOAT64, a)};
+    query.aggregations = {{Aggregate::SUM, 1}};
+    EXPECT_THROW(aggregate(query, result), std::invalid_argument);
+
+    query.aggregations = {{Aggregate::COUNT}};
+    query.columns = {column(ColumnType::FLOAT64, fractional)};
+    query.groupBy = {0};
+    EXPECT_THROW(aggregate(query, result), std::invalid_argument);
+    query.columns = {column(ColumnType::INT8, negative)};
+    EXPECT_THROW(aggregate(query, result), std::invalid_argument);
+}
+
+TEST(ColumnarTest, CancellationLeavesTheResultUntouched) {
+    const Sales sales(kParallelThreshold * 2);
+    GroupedResult result;
+    result.groups = 42;
+    EXPECT_FALSE(aggregate(groupedQuery(sales), result, [] { return true; }));
+    EXPECT_EQ(result.groups, 42u);
+}
+
+TEST(ColumnarTest, ParsesOperatorAndAggregateNames) {
+    Compare compare;
+    EXPECT_TRUE(parseCompare("===", compare));
+    EXPECT_EQ(compare, Compare::EQ);
+    EXPECT_TRUE(parseCompare("<=", compare));
+    EXPECT_EQ(compare, Compare::LE);
+    EXPECT_FALSE(parseCompare("=<", compare));
+
+    Aggregate kind;
+    EXPECT_TRUE(parseAggregate("or", kind));
+    EXPECT_EQ(kind, Aggregate::OR);
+    EXPECT_FALSE(parseAggregate("avg", kind));
+}
+
+} // namespace
+} // namespace threadforge::columnar
@@ -0,0 +1,230 @@
+#include "Compression.h"
+
+#include <zlib.h>
+
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "TempDir.h"
+
+namespace threadforge::compression {
+namespace {
+
+using Bytes = std::vector<uint8_t>;
+
+Bytes bytesOf(const std::string& text) {
+    return {text.begin(), text.end()};
+}
+
+// Log-like text (compressible) with runs of random bytes mixed in.
+Bytes sample(size_t size, uint32_t seed = 1) {
+    std::mt19937 random(seed);
+    Bytes data;
+    data.reserve(size);
+    while (data.size() < size) {
+        if (random() % 8 == 0) {
+            for (int i = 0; i < 64 && data.size() < size; ++i) {
+                data.push_back(static_cast<uint8_t>(random()));
+            }
+        } else {
+            const auto line = "2024-05-01T12:00:" + std::to_string(random() % 60) + " GET /api/items/" +
+                std::to_string(random() % 500) + " 200\n";
+            for (char c : line) {
+                if (data.size() < size) {
+                    data.push_back(static_cast<uint8_t>(c));
+                }
+            }
+        }
+    }
+    return data;
+}
+
+Bytes roundTrip(Codec codec, const Bytes& data, int level = kDefaultLevel) {
+    const auto packed = compress(codec, level, data.data(), data.size());
+    return decompress(codec, packed.data(), packed.size());
+}
+
+// zlib's own inflate, as a reference decoder for the deflate family.
+Bytes zlibInflate(const Bytes& packed, int windowBits) {
+    z_stream stream{};
+    EXPECT_EQ(inflateInit2(&stream, windowBits), Z_OK);
+    Bytes out;
+    uint8_t buffer[16384];
+    stream.next_in = const_cast<Bytes::value_type*>(packed.data());
+    stream.avail_in = static_cast<uInt>(packed.size());
+    int status = Z_OK;
+    while (status == Z_OK) {
+        stream.next_out = buffer;
+        stream.avail_out = sizeof(buffer);
+        status = inflate(&stream, Z_NO_FLUSH);
+        out.insert(out.end(), buffer, buffer + (sizeof(buffer) - stream.avail_out));
+    }
+    EXPECT_EQ(status, Z_STREAM_END);
+    EXPECT_EQ(stream.avail_in, 0u);
+    inflateEnd(&stream);
+    return out;
+}
+
+TEST(CompressionTest, ParsesCodecNames) {
+    for (const char* name : {"gzip", "zlib", "deflate", "lz4"}) {
+        Codec codec;
+        ASSERT_TRUE(parseCodec(name, codec)) << name;
+        EXPECT_STREQ(codecName(codec), name);
+    }
+    Codec codec;
+    EXPECT_FALSE(parseCodec("zstd", codec));
+    EXPECT_FALSE(parseCodec("GZIP", codec));
+}
+
+// Sizes around the 256 KiB deflate chunks and the 1 MiB LZ4 blocks.
+class CompressionRoundTripTest : public ::testing::TestWithParam<std::tuple<Codec, size_t>> {};
+
+TEST_P(CompressionRoundTripTest, RoundTrips) {
+    const auto [codec, size] = GetParam();
+    const auto data = sample(size, static_cast<uint32_t>(size));
+    EXPECT_EQ(roundTrip(codec, data), data);
+}
+
+INSTANTIATE_TEST_SUITE_P(Sizes,
+                         CompressionRoundTripTest,
+                         ::testing::Combine(::testing::Values(Codec::GZIP, Codec::ZLIB, Codec::DEFLATE, Codec::LZ4),
+                                            ::testing::Values(size_t{0},
+                                                              size_t{1},
+                                                              size_t{1000},
+                                                              (size_t{256} << 10) - 1,
+                                                              (size_t{256} << 10) + 1,
+                                                              (size_t{1} << 20) + 3,
+                                                              size_t{3} << 20)));
+
+TEST(CompressionTest, DeflateFamilyIsReadableByZlib) {
+    const auto data = sample(size_t{2} << 20);
+    for (int level : {0, 1, 6, 9}) {
+        EXPECT_EQ(zlibInflate(compress(Codec::GZIP, level, data.data(), data.size()), 16 + MAX_WBITS), data);
+        EXPECT_EQ(zlibInflate(compress(Codec::ZLIB, level, data.data(), data.size()), MAX_WBITS), data);
+        EXPECT_EQ(zlibInflate(compress(Codec::DEFLATE, level, data.data(), data.size()), -MAX_WBITS), data);
+    }
+}
+
+TEST(CompressionTest, ParallelChunksKeepTheSerialRatio) {
+    const auto data = sample(size_t{4} << 20);
+    uLongf serialSize = compressBound(static_cast<uLong>(data.size()));
+    Bytes serial(serialSize);
+    ASSERT_EQ(compress2(serial.data(), &serialSize, data.data(), static_cast<uLong>(data.size()), kDefaultLevel), Z_OK);
+    const auto parallel = compress(Codec::ZLIB, kDefaultLevel, data.data(), data.size());
+    // Priming each chunk with the previous window leaves only the chunk seams.
+    EXPECT_LT(parallel.size(), serialSize + serialSize / 100 + 64);
+    EXPECT_LT(compress(Codec::ZLIB, 0, data.data(), data.size()).size(), data.size() + data.size() / 1000 + 64);
+}
+
+TEST(CompressionTest, DecodesAnLz4CliFrame) {
+    // `lz4 v.txt` (v1.9.4): linked blocks with a content checksum.
+    const Bytes frame = {0x04, 0x22, 0x4d, 0x18, 0x64, 0x40, 0xa7, 0x16, 0x00, 0x00, 0x00, 0xcf, 0x74, 0x68,
+                         0x72, 0x65, 0x61, 0x64, 0x66, 0x6f, 0x72, 0x67, 0x65, 0x20, 0x0c, 0x00, 0x0c, 0x50,
+                         0x6f, 0x72, 0x67, 0x65, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x44, 0x2a, 0x1f, 0x28};
+    const auto text = bytesOf("threadforge threadforge threadforge threadforge\n");
+    EXPECT_EQ(decompress(Codec::LZ4, frame.data(), frame.size()), text);
+
+    auto corrupt = frame;
+    corrupt[corrupt.size() - 1] ^= 1;
+    EXPECT_THROW(decompress(Codec::LZ4, corrupt.data(), corrupt.size()), std::invalid_argument);
+
+    // Frames produced here start with the same magic number.
+    const auto packed = compress(Codec::LZ4, kDefaultLevel, text.data(), text.size());
+    EXPECT_EQ(Bytes(packed.begin(), packed.begin() + 4), Bytes(frame.begin(), frame.begin() + 4));
+}
+
+TEST(CompressionTest, StreamsInArbitraryPieces) {
+    const auto data = sample(size_t{700} << 10);
+    std::mt19937 random(7);
+    for (const auto codec : {Codec::GZIP, Codec::LZ4}) {
+        Bytes packed;
+        auto compressor = Compressor::create(codec);
+        for (size_t at = 0; at < data.size();) {
+            const size_t piece = std::min<size_t>(data.size() - at, random() % 70000);
+            compressor->write(data.data() + at, piece, packed);
+            at += piece;
+        }
+        compressor->finish(packed);
+        EXPECT_EQ(decompress(codec, packed.data(), packed.size()), data);
+
+        Bytes unpacked;
+        auto decompressor = Decompressor::create(codec);
+        for (size_t at = 0; at < packed.size();) {
+            const size_t piece = std::min<size_t>(packed.size() - at, 1 + random() % 999);
+            decompressor->write(packed.data() + at, piece, unpacked);
+            at += piece;
+        }
+        decompressor->finish(unpacked);
+        EXPECT_EQ(unpacked, data);
+    }
+}
+
+TEST(CompressionTest, ConcatenatedMembersDecodeAsOneStream) {
+    const auto first = bytesOf("first member\n");
+    const auto second = bytesOf("second member\n");
+    for (const auto codec : {Codec::GZIP, Codec::LZ4}) {
+        auto packed = compress(codec, kDefaultLevel, first.data(), first.size());
+        const auto more = compress(codec, kDefaultLevel, second.data(), second.size());
+        packed.insert(packed.end(), more.begin(), more.end());
+        EXPECT_EQ(decompress(codec, packed.data(), packed.size()), bytesOf("first member\nsecond member\n"));
+    }
+}
+
+TEST(CompressionTest, RejectsBadInput) {
+    const auto data = sample(100000);
+    for (const auto codec : {Codec::GZIP, Codec::ZLIB, Codec::DEFLATE, Codec::LZ4}) {
+        const auto packed = compress(codec, kDefaultLevel, data.data(), data.size());
+        SCOPED_TRACE(codecName(codec));
+        EXPECT_THROW(decompress(codec, packed.data(), packed.size() / 2), std::invalid_argument);
+        EXPECT_THROW(decompress(codec, packed.data(), packed.size(), data.size() - 1), std::invalid_argument);
+        EXPECT_EQ(decompress(codec, packed.data(), packed.size(), data.size()), data);
+    }
+    const auto garbage = bytesOf("definitely not compressed");
+    EXPECT_THROW(decompress(Codec::GZIP, garbage.data(), garbage.size()), std::invalid_argument);
+    EXPECT_THROW(decompress(Codec::LZ4, garbage.data(), garbage.size()), std::invalid_argument);
+}
+
+TEST(CompressionTest, CompressesFilesAtomically) {
+    threadforge::testing::TempDir dir;
+    const auto data = sample(size_t{9} << 20);
+    std::ofstream(dir.file("input.log"), std::ios::binary)
+        .write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+    FileStats packed;
+    ASSERT_TRUE(compressFile(Codec::GZIP, kDefaultLevel, dir.file("input.log"), dir.file("input.log.gz"), packed));
+    EXPECT_EQ(packed.inputBytes, data.size());
+    EXPECT_LT(packed.outputBytes, data.size() / 2);
+
+    FileStats unpacked;
+    ASSERT_TRUE(decompressFile(Codec::GZIP, dir.file("input.log.gz"), dir.file("output.log"), unpacked));
+    EXPECT_EQ(unpacked.inputBytes, packed.outputBytes);
+    EXPECT_EQ(unpacked.outputBytes, data.size());
+    std::ifstream in(dir.file("output.log"), std::ios::binary);
+    std::stringstream text;
+    text << in.rdbuf();
+    EXPECT_EQ(text.str(), std::string(data.begin(), data.end()));
+
+    // A cancelled or failed run leaves the destination as it was.
+    std::ofstream(dir.file("kept.gz")) << "previous";
+    FileStats ignored;
+    EXPECT_FALSE(compressFile(Codec::GZIP, kDefaultLevel, dir.file("input.log"), dir.file("kept.gz"), ignored, [] {
+        return true;
+    }));
+    EXPECT_THROW(decompressFile(Codec::LZ4, dir.file("input.log.gz"), dir.file("kept.gz"), ignored),
+                 std::invalid_argument);
+    EXPECT_THROW(decompressFile(Codec::GZIP, dir.file("input.log.gz"), dir.file("kept.gz"), ignored, nullptr, 1000),
+                 std::invalid_argument);
+    std::ifstream kept(dir.file("kept.gz"));
+    std::string previous;
+    kept >> previous;
+    EXPECT_EQ(previous, "previous");
+}
+
+} // namespace
+} // namespace threadforge::compression
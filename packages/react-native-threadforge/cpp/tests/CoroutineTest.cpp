@@ -0,0 +1,221 @@
+#include "Coroutine.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace threadforge {
+namespace {
+
+using namespace std::chrono_literals;
+
+template <typename T>
+T settle(co::Spawned<T>& spawned) {
+    if (spawned.result.wait_for(5s) != std::future_status::ready) {
+        throw std::runtime_error("coroutine did not settle");
+    }
+    return spawned.result.get();
+}
+
+co::Task<int> square(int value) {
+    co_return value * value;
+}
+
+co::Task<int> sumOfSquares(int count) {
+    int total = 0;
+    for (int i = 1; i <= count; ++i) {
+        const int step = co_await square(i);
+        total += step;
+    }
+    co_return total;
+}
+
+TEST(CoroutineTest, AwaitsNestedTasks) {
+    auto pool = std::make_shared<ThreadPool>(2);
+    auto spawned = co::spawn(pool, TaskPriority::NORMAL, sumOfSquares(4));
+    EXPECT_EQ(settle(spawned), 30);
+}
+
+co::Task<int> failing() {
+    throw std::logic_error("bad input");
+    co_return 0;
+}
+
+co::Task<int> awaitsFailing() {
+    const int value = co_await failing();
+    co_return value + 1;
+}
+
+TEST(CoroutineTest, PropagatesExceptionsToTheAwaiter) {
+    auto pool = std::make_shared<ThreadPool>(1);
+    auto spawned = co::spawn(pool, TaskPriority::NORMAL, awaitsFailing());
+    EXPECT_THROW(settle(spawned), std::logic_error);
+}
+
+co::Task<int> awaitsMovedFrom() {
+    auto task = square(3);
+    auto moved = std::move(task);
+    const int value = co_await std::move(moved);
+    try {
+        co_await std::move(task);
+    } catch (const std::logic_error&) {
+        co_return value;
+    }
+    co_return -1;
+}
+
+co::Task<int> awaitsDefault() {
+    co_return co_await co::Task<int>();
+}
+
+TEST(CoroutineTest, AwaitingAnEmptyTaskThrowsInTheAwaiter) {
+    auto pool = std::make_shared<ThreadPool>(1);
+    auto caught = co::spawn(pool, TaskPriority::NORMAL, awaitsMovedFrom());
+    EXPECT_EQ(settle(caught), 9);
+
+    auto uncaught = co::spawn(pool, TaskPriority::NORMAL, awaitsDefault());
+    try {
+        settle(uncaught);
+        FAIL() << "expected a logic_error";
+    } catch (const std::logic_error& ex) {
+        EXPECT_STREQ(ex.what(), "co_await on an empty co::Task");
+    }
+}
+
+co::Task<std::string> sleepThenReport(std::vector<std::string>& order, std::mutex& mutex) {
+    co_await co::sleepFor(100ms);
+    std::lock_guard<std::mutex> lock(mutex);
+    order.push_back("coroutine");
+    co_return "woke";
+}
+
+TEST(CoroutineTest, SleepReleasesTheWorker) {
+    // One worker: the plain task can only run before the coroutine resumes if
+    // the sleeping coroutine is not holding that worker.
+    auto pool = std::make_shared<ThreadPool>(1);
+    std::vector<std::string> order;
+    std::mutex mutex;
+    auto spawned = co::spawn(pool, TaskPriority::NORMAL, sleepThenReport(order, mutex));
+    std::this_thread::sleep_for(20ms);
+    auto plain = pool->enqueueTask("plain", TaskPriority::NORMAL,
+                                   [&](const ProgressCallback&, const std::function<bool()>&) {
+                                       std::lock_guard<std::mutex> lock(mutex);
+                                       order.push_back("plain");
+                                       return makeSuccessResult("null");
+                                   },
+                                   nullptr);
+    EXPECT_TRUE(ThreadPool::waitForTask(plain).success);
+    EXPECT_EQ(settle(spawned), "woke");
+    EXPECT_EQ(order, (std::vector<std::string>{"plain", "coroutine"}));
+}
+
+co::Task<std::vector<int>> observePriorities(std::shared_ptr<ThreadPool> other) {
+    std::vector<int> seen;
+    seen.push_back(static_cast<int>(ThreadPool::currentTask()->priority));
+    co_await co::switchTo(TaskPriority::HIGH);
+    seen.push_back(static_cast<int>(ThreadPool::currentTask()->priority));
+    co_await co::switchTo(other, TaskPriority::LOW);
+    seen.push_back(static_cast<int>(ThreadPool::currentTask()->priority));
+    co_await co::sleepFor(1ms);
+    // Sleeping re-queues at the current priority, on the pool switched to.
+    seen.push_back(static_cast<int>(ThreadPool::currentTask()->priority));
+    co_return seen;
+}
+
+TEST(CoroutineTest, SwitchToRequeuesAtTheNewPriority) {
+    auto pool = std::make_shared<ThreadPool>(1);
+    auto other = std::make_shared<ThreadPool>(1);
+    auto spawned = co::spawn(pool, TaskPriority::IDLE, observePriorities(other));
+    // IDLE steps only run inside an idle window.
+    pool->setIdle(true);
+    const auto levels = settle(spawned);
+    EXPECT_EQ(levels, (std::vector<int>{static_cast<int>(TaskPriority::IDLE), static_cast<int>(TaskPriority::HIGH),
+                                        static_cast<int>(TaskPriority::LOW), static_cast<int>(TaskPriority::LOW)}));
+}
+
+co::Task<int> sleepForever(std::atomic<int>& iterations) {
+    while (true) {
+        iterations++;
+        co_await co::sleepFor(5ms);
+    }
+    co_return 0;
+}
+
+co::Task<int> awaitsSleeper(std::atomic<int>& iterations) {
+    const int value = co_await sleepForever(iterations);
+    co_return value;
+}
+
+TEST(CoroutineTest, CancellationReachesNestedAwaits) {
+    auto pool = std::make_shared<ThreadPool>(2);
+    std::atomic<int> iterations{0};
+    auto spawned = co::spawn(pool, TaskPriority::NORMAL, awaitsSleeper(iterations));
+    while (iterations.load() < 3) {
+        std::this_thread::sleep_for(1ms);
+    }
+    spawned.token.cancel();
+    EXPECT_THROW(settle(spawned), co::TaskCancelled);
+    const int stopped = iterations.load();
+    std::this_thread::sleep_for(30ms);
+    EXPECT_EQ(iterations.load(), stopped);
+}
+
+co::Task<int> countUntilCancelled(std::atomic<int>& iterations) {
+    while (true) {
+        const bool cancelled = co_await co::isCancelled();
+        if (cancelled) {
+            co_return iterations.load();
+        }
+        iterations++;
+        co_await co::switchTo(TaskPriority::NORMAL);
+    }
+}
+
+TEST(CoroutineTest, IsCancelledStopsWithoutThrowing) {
+    auto pool = std::make_shared<ThreadPool>(1);
+    std::atomic<int> iterations{0};
+    auto spawned = co::spawn(pool, TaskPriority::NORMAL, countUntilCancelled(iterations));
+    while (iterations.load() < 3) {
+        std::this_thread::sleep_for(1ms);
+    }
+    spawned.token.cancel();
+    // Either the poll or the next switchTo notices first; both settle the chain.
+    try {
+        EXPECT_GE(settle(spawned), 3);
+    } catch (const co::TaskCancelled&) {
+    }
+}
+
+co::Task<int> sleepThenAnswer() {
+    co_await co::sleepFor(50ms);
+    co_return 42;
+}
+
+TEST(CoroutineTest, ShutdownWhileSuspendedCancelsTheChain) {
+    auto pool = std::make_shared<ThreadPool>(1);
+    auto spawned = co::spawn(pool, TaskPriority::NORMAL, sleepThenAnswer());
+    std::this_thread::sleep_for(10ms);
+    pool.reset();
+    EXPECT_THROW(settle(spawned), co::TaskCancelled);
+}
+
+TEST(CoroutineTest, RetiredPoolCancelsNewChains) {
+    auto pool = std::make_shared<ThreadPool>(1);
+    setSharedThreadPool(pool);
+    setSharedThreadPool(nullptr);
+    pool->shutdown();
+
+    auto spawned = co::spawn(pool, TaskPriority::NORMAL, square(3));
+    EXPECT_THROW(settle(spawned), co::TaskCancelled);
+}
+
+} // namespace
+} // namespace threadforge
@@ -0,0 +1,101 @@
+#include "CpuTopology.h"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace threadforge {
+namespace {
+
+// Trimmed copies of /sys/devices/system/cpu: only the files readCpuTopology() reads,
+// next to unrelated entries (online, cpufreq/policyN) it has to skip.
+std::string fixture(const std::string& name) {
+    return std::string(THREADFORGE_TEST_FIXTURES) + "/cpu/" + name;
+}
+
+std::vector<int> clustersOf(const CpuTopology& topology) {
+    std::vector<int> clusters;
+    for (const auto& core : topology.cores) {
+        clusters.push_back(core.cluster);
+    }
+    return clusters;
+}
+
+class CpuTopologyTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+#if defined(__APPLE__)
+        GTEST_SKIP() << "Apple platforms read the topology from sysctl, not sysfs";
+#endif
+    }
+};
+
+TEST_F(CpuTopologyTest, HomogeneousSocUsesEveryCoreForEveryClass) {
+    const auto topology = readCpuTopology(fixture("homogeneous"));
+
+    ASSERT_EQ(topology.cores.size(), 4u);
+    EXPECT_FALSE(topology.isHeterogeneous());
+    EXPECT_EQ(topology.performanceCores, (std::vector<int>{0, 1, 2, 3}));
+    EXPECT_EQ(topology.efficiencyCores, (std::vector<int>{0, 1, 2, 3}));
+    EXPECT_EQ(clustersOf(topology), (std::vector<int>{0, 0, 0, 0}));
+    EXPECT_EQ(topology.cores[2].maxFrequencyKHz, 2016000u);
+    // Every core but one, left for the UI thread.
+    EXPECT_EQ(recommendedThreadCount(topology), 3u);
+}
+
+TEST_F(CpuTopologyTest, BigLittleSplitsTheSlowestClusterFromTheRest) {
+    const auto topology = readCpuTopology(fixture("big_little"));
+
+    ASSERT_EQ(topology.cores.size(), 8u);
+    for (size_t i = 0; i < topology.cores.size(); ++i) {
+        EXPECT_EQ(topology.cores[i].id, static_cast<int>(i));
+    }
+    EXPECT_TRUE(topology.isHeterogeneous());
+    EXPECT_EQ(topology.efficiencyCores, (std::vector<int>{0, 1, 2, 3}));
+    // The mid and prime clusters both count as performance cores.
+    EXPECT_EQ(topology.performanceCores, (std::vector<int>{4, 5, 6, 7}));
+    // cpu7 has no cluster_id and falls back to its physical_package_id.
+    EXPECT_EQ(clustersOf(topology), (std::vector<int>{0, 0, 0, 0, 1, 1, 1, 2}));
+    EXPECT_EQ(topology.cores[7].maxFrequencyKHz, 3187200u);
+    // One worker per performance core plus one for the efficiency cluster.
+    EXPECT_EQ(recommendedThreadCount(topology), 5u);
+}
+
+TEST_F(CpuTopologyTest, MissingCpufreqFallsBackToHomogeneous) {
+    const auto topology = readCpuTopology(fixture("no_cpufreq"));
+
+    ASSERT_EQ(topology.cores.size(), 6u);
+    EXPECT_FALSE(topology.isHeterogeneous());
+    EXPECT_EQ(topology.performanceCores.size(), 6u);
+    EXPECT_EQ(topology.efficiencyCores.size(), 6u);
+    EXPECT_EQ(clustersOf(topology), (std::vector<int>(6, 0)));
+    EXPECT_EQ(recommendedThreadCount(topology), 5u);
+}
+
+TEST_F(CpuTopologyTest, UnreadableRootFallsBackToHardwareConcurrency) {
+    const auto topology = readCpuTopology(fixture("does_not_exist"));
+
+    EXPECT_EQ(topology.cores.size(), std::max(1u, std::thread::hardware_concurrency()));
+    EXPECT_FALSE(topology.isHeterogeneous());
+}
+
+TEST(CpuTopologyCountTest, SmallTopologiesKeepAtLeastOneWorker) {
+    CpuTopology single;
+    single.cores.push_back({0, 0, 0});
+    single.performanceCores = {0};
+    single.efficiencyCores = {0};
+    EXPECT_EQ(recommendedThreadCount(single), 1u);
+
+    CpuTopology pair;
+    pair.cores = {{0, 1000, 0}, {1, 2000, 1}};
+    pair.performanceCores = {1};
+    pair.efficiencyCores = {0};
+    EXPECT_TRUE(pair.isHeterogeneous());
+    EXPECT_EQ(recommendedThreadCount(pair), 1u);
+}
+
+} // namespace
+} // namespace threadforge
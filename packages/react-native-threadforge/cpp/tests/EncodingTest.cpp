@@ -0,0 +1,252 @@
+#include "Encoding.h"
+
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace threadforge::encoding {
+namespace {
+
+using Bytes = std::vector<uint8_t>;
+
+Bytes bytesOf(const std::string& text) {
+    return {text.begin(), text.end()};
+}
+
+Bytes randomBytes(size_t size, uint32_t seed) {
+    std::mt19937 random(seed);
+    Bytes data(size);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(random());
+    }
+    return data;
+}
+
+std::string base64(const Bytes& data, Base64Alphabet alphabet = Base64Alphabet::STANDARD, bool padded = true) {
+    std::string text(base64EncodedLength(data.size(), padded), '\0');
+    encodeBase64(data.data(), data.size(), text.data(), alphabet, padded);
+    return text;
+}
+
+// The decoded bytes, or "<invalid>" when decodeBase64() rejects text.
+std::string unbase64(const std::string& text, Base64Alphabet alphabet = Base64Alphabet::STANDARD) {
+    Bytes out(base64DecodedCapacity(text.size()));
+    const size_t size = decodeBase64(text.data(), text.size(), out.data(), alphabet);
+    return size == SIZE_MAX ? "<invalid>" : std::string(out.begin(), out.begin() + static_cast<ptrdiff_t>(size));
+}
+
+// A byte-at-a-time encoder to compare the vector loops with.
+std::string referenceBase64(const Bytes& data) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string text;
+    for (size_t i = 0; i < data.size(); i += 3) {
+        const uint32_t group = data[i] << 16 | (i + 1 < data.size() ? data[i + 1] << 8 : 0) |
+            (i + 2 < data.size() ? data[i + 2] : 0);
+        text += alphabet[group >> 18 & 63];
+        text += alphabet[group >> 12 & 63];
+        text += i + 1 < data.size() ? alphabet[group >> 6 & 63] : '=';
+        text += i + 2 < data.size() ? alphabet[group & 63] : '=';
+    }
+    return text;
+}
+
+bool validUtf8(const std::string& text) {
+    return validateUtf8(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+}
+
+std::u16string toUtf16(const std::string& text) {
+    const auto* data = reinterpret_cast<const uint8_t*>(text.data());
+    std::u16string units(utf16Length(data, text.size()), u'\0');
+    EXPECT_EQ(utf8ToUtf16(data, text.size(), units.data()), units.size());
+    return units;
+}
+
+std::string toUtf8(const std::u16string& units) {
+    std::string text(utf8Length(units.data(), units.size()), '\0');
+    EXPECT_EQ(utf16ToUtf8(units.data(), units.size(), reinterpret_cast<uint8_t*>(text.data())), text.size());
+    return text;
+}
+
+std::string decode(TextDecoder& decoder, const std::string& bytes, bool stream = false) {
+    return decoder.decode(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(), stream);
+}
+
+TEST(EncodingTest, ReportsTheBuildsVectorPath) {
+    const std::string backend = simdBackend();
+#if defined(THREADFORGE_TEST_EXPECT_SSSE3)
+    EXPECT_EQ(backend, "ssse3");
+#else
+    EXPECT_TRUE(backend == "ssse3" || backend == "neon" || backend == "scalar") << backend;
+#endif
+}
+
+TEST(EncodingTest, EncodesRfc4648Vectors) {
+    const std::pair<const char*, const char*> vectors[] = {
+        {"", ""}, {"f", "Zg=="}, {"fo", "Zm8="}, {"foo", "Zm9v"}, {"foob", "Zm9vYg=="}, {"fooba", "Zm9vYmE="},
+        {"foobar", "Zm9vYmFy"}};
+    for (const auto& [plain, encoded] : vectors) {
+        EXPECT_EQ(base64(bytesOf(plain)), encoded);
+        EXPECT_EQ(unbase64(encoded), plain);
+        std::string unpadded = encoded;
+        unpadded.erase(unpadded.find_last_not_of('=') + 1);
+        EXPECT_EQ(base64(bytesOf(plain), Base64Alphabet::STANDARD, false), unpadded);
+        EXPECT_EQ(unbase64(unpadded), plain);
+    }
+
+    const Bytes high = {0xfb, 0xff, 0xbf};
+    EXPECT_EQ(base64(high), "+/+/");
+    EXPECT_EQ(base64(high, Base64Alphabet::URL), "-_-_");
+    EXPECT_EQ(unbase64("-_-_", Base64Alphabet::URL), "\xfb\xff\xbf");
+    EXPECT_EQ(unbase64("-_-_"), "<invalid>");
+    EXPECT_EQ(unbase64("+/+/", Base64Alphabet::URL), "<invalid>");
+}
+
+TEST(EncodingTest, MatchesTheScalarEncoderAtEveryLength) {
+    for (size_t size = 0; size < 300; ++size) {
+        const auto data = randomBytes(size, static_cast<uint32_t>(size));
+        const auto text = base64(data);
+        ASSERT_EQ(text, referenceBase64(data)) << size;
+        ASSERT_EQ(unbase64(text), std::string(data.begin(), data.end())) << size;
+    }
+    const auto large = randomBytes((size_t{1} << 20) + 1, 99);
+    EXPECT_EQ(base64(large), referenceBase64(large));
+    EXPECT_EQ(unbase64(base64(large, Base64Alphabet::URL, false), Base64Alphabet::URL),
+              std::string(large.begin(), large.end()));
+}
+
+TEST(EncodingTest, RejectsMalformedBase64) {
+    for (const char* text : {"Zg=", "Zg===", "Z", "Zm9vY", "Zg==Zg==", "Zm=v", "Zm9v\n", "Zm 9v"}) {
+        EXPECT_EQ(unbase64(text), "<invalid>") << text;
+    }
+    // Stray bits in the last character are dropped, as atob() does.
+    EXPECT_EQ(unbase64("Zh=="), "f");
+    // A bad character anywhere in a long input, inside a vector block or the tail.
+    const auto text = base64(randomBytes(300, 5));
+    for (size_t at = 0; at < text.size(); at += 7) {
+        auto broken = text;
+        broken[at] = '*';
+        ASSERT_EQ(unbase64(broken), "<invalid>") << at;
+    }
+}
+
+TEST(EncodingTest, EncodesHex) {
+    const Bytes data = {0x00, 0x7f, 0x80, 0xab, 0xff};
+    std::string text(data.size() * 2, '\0');
+    encodeHex(data.data(), data.size(), text.data());
+    EXPECT_EQ(text, "007f80abff");
+
+    Bytes out(5);
+    ASSERT_TRUE(decodeHex("007F80aBfF", 10, out.data()));
+    EXPECT_EQ(out, data);
+    EXPECT_FALSE(decodeHex("abc", 3, out.data()));
+    EXPECT_FALSE(decodeHex("zz", 2, out.data()));
+
+    const auto large = randomBytes(1000, 8);
+    std::string largeText(2000, '\0');
+    encodeHex(large.data(), large.size(), largeText.data());
+    Bytes back(1000);
+    ASSERT_TRUE(decodeHex(largeText.data(), largeText.size(), back.data()));
+    EXPECT_EQ(back, large);
+}
+
+TEST(EncodingTest, ValidatesUtf8) {
+    EXPECT_TRUE(validUtf8(""));
+    EXPECT_TRUE(validUtf8("plain ascii"));
+    EXPECT_TRUE(validUtf8("caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80 \xf4\x8f\xbf\xbf"));
+    const char* invalid[] = {
+        "\x80",             // continuation without a lead
+        "\xc0\xaf",         // overlong /
+        "\xe0\x80\x80",     // overlong NUL
+        "\xed\xa0\x80",     // surrogate
+        "\xf4\x90\x80\x80", // past U+10FFFF
+        "\xf5\x80\x80\x80", // invalid lead
+        "\xe2\x82",         // cut off at the end
+        "\xc3\x28",         // bad continuation
+    };
+    const std::string padding(70, 'a');
+    for (const char* sequence : invalid) {
+        EXPECT_FALSE(validUtf8(sequence)) << sequence;
+        // At each offset of a longer buffer, so vector blocks and the tail both see it.
+        for (size_t at = 0; at <= padding.size(); at += 5) {
+            ASSERT_FALSE(validUtf8(padding.substr(0, at) + sequence + padding.substr(at))) << at;
+        }
+    }
+    const std::string text = padding + "\xf0\x9f\x98\x80" + padding;
+    EXPECT_TRUE(validUtf8(text));
+    EXPECT_TRUE(isAscii(reinterpret_cast<const uint8_t*>(padding.data()), padding.size()));
+    EXPECT_FALSE(isAscii(reinterpret_cast<const uint8_t*>(text.data()), text.size()));
+}
+
+TEST(EncodingTest, TranscodesBetweenUtf8AndUtf16) {
+    const std::string text = "a\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80" + std::string(40, 'z');
+    const auto units = toUtf16(text);
+    EXPECT_EQ(units, u"aé€😀" + std::u16string(40, u'z'));
+    EXPECT_TRUE(isWellFormedUtf16(units.data(), units.size()));
+    EXPECT_EQ(toUtf8(units), text);
+
+    char16_t out[4];
+    const std::string bad = "\xed\xa0\x80";
+    EXPECT_EQ(utf8ToUtf16(reinterpret_cast<const uint8_t*>(bad.data()), bad.size(), out), SIZE_MAX);
+
+    // Unpaired surrogates become U+FFFD.
+    const std::u16string lone = {u'x', 0xd83d, u'y', 0xde00};
+    EXPECT_FALSE(isWellFormedUtf16(lone.data(), lone.size()));
+    EXPECT_EQ(toUtf8(lone), "x\xef\xbf\xbdy\xef\xbf\xbd");
+}
+
+TEST(EncodingTest, ReplacesMaximalSubparts) {
+    // The examples from the Unicode standard's "U+FFFD substitution" section.
+    const std::string mixed = "\x61\xf1\x80\x80\xe1\x80\xc2\x62\x80\x63\x80\xbf\x64";
+    const std::string fffd = "\xef\xbf\xbd";
+    EXPECT_EQ(replaceInvalidUtf8(reinterpret_cast<const uint8_t*>(mixed.data()), mixed.size()),
+              "a" + fffd + fffd + fffd + "b" + fffd + "c" + fffd + fffd + "d");
+    const std::string forms = "\xed\xa0\x80x\xf4\x90\x80\x80y\xc0\xafz\xe0\x80\x80";
+    EXPECT_EQ(replaceInvalidUtf8(reinterpret_cast<const uint8_t*>(forms.data()), forms.size()),
+              fffd + fffd + fffd + "x" + fffd + fffd + fffd + fffd + "y" + fffd + fffd + "z" + fffd + fffd + fffd);
+
+    const std::string cut = "ab\xf0\x9f\x98";
+    EXPECT_EQ(incompleteUtf8Suffix(reinterpret_cast<const uint8_t*>(cut.data()), cut.size()), 3u);
+    EXPECT_EQ(incompleteUtf8Suffix(reinterpret_cast<const uint8_t*>(cut.data()), 2), 0u);
+    const std::string wrong = "ab\xe0\x80";
+    EXPECT_EQ(incompleteUtf8Suffix(reinterpret_cast<const uint8_t*>(wrong.data()), wrong.size()), 0u);
+}
+
+TEST(EncodingTest, DecodesTextLikeWhatwg) {
+    TextDecoder::Kind kind;
+    EXPECT_TRUE(TextDecoder::parseLabel(" UTF8 ", kind));
+    EXPECT_EQ(kind, TextDecoder::Kind::UTF8);
+    EXPECT_TRUE(TextDecoder::parseLabel("unicode-1-1-utf-8", kind));
+    EXPECT_TRUE(TextDecoder::parseLabel("utf-16", kind));
+    EXPECT_EQ(kind, TextDecoder::Kind::UTF16LE);
+    EXPECT_FALSE(TextDecoder::parseLabel("latin1", kind));
+
+    // A character split across streamed calls, and the BOM dropped once.
+    TextDecoder utf8(TextDecoder::Kind::UTF8, false, false);
+    EXPECT_STREQ(utf8.encoding(), "utf-8");
+    EXPECT_EQ(decode(utf8, "\xef\xbb\xbfh\xf0\x9f", true), "h");
+    EXPECT_EQ(decode(utf8, "\x98\x80!", true), "\xf0\x9f\x98\x80!");
+    EXPECT_EQ(decode(utf8, "\xe2\x82"), "\xef\xbf\xbd");
+    EXPECT_EQ(decode(utf8, "\xef\xbb\xbfx"), "x");
+
+    TextDecoder keepBom(TextDecoder::Kind::UTF8, false, true);
+    EXPECT_EQ(decode(keepBom, "\xef\xbb\xbfx"), "\xef\xbb\xbfx");
+
+    TextDecoder fatal(TextDecoder::Kind::UTF8, true, false);
+    EXPECT_THROW(decode(fatal, "ok\xff"), std::invalid_argument);
+    EXPECT_EQ(decode(fatal, "ok"), "ok");
+
+    // UTF-16LE: an odd byte and a surrogate pair split across calls.
+    TextDecoder utf16(TextDecoder::Kind::UTF16LE, false, false);
+    EXPECT_STREQ(utf16.encoding(), "utf-16le");
+    EXPECT_EQ(decode(utf16, std::string("\xff\xfe" "a\0\x3d", 5), true), "a");
+    EXPECT_EQ(decode(utf16, std::string("\xd8", 1), true), "");
+    EXPECT_EQ(decode(utf16, std::string("\x00\xde" "b\0", 4)), "\xf0\x9f\x98\x80" "b");
+    EXPECT_EQ(decode(utf16, std::string("\x3d\xd8", 2)), "\xef\xbf\xbd");
+}
+
+} // namespace
+} // namespace threadforge::encoding
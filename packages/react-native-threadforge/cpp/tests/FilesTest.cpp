@@ -0,0 +1,238 @@
+#include "Files.h"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "TempDir.h"
+
+namespace threadforge::files {
+namespace {
+
+namespace fs = std::filesystem;
+
+void writeText(const std::string& path, const std::string& text) {
+    std::ofstream(path, std::ios::binary) << text;
+}
+
+std::string readText(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+std::vector<std::string> readAllLines(FileReader& reader, size_t batch) {
+    std::vector<std::string> all;
+    std::vector<std::string_view> lines;
+    while (true) {
+        lines.clear();
+        if (!reader.nextLines(batch, lines)) {
+            return all;
+        }
+        EXPECT_LE(lines.size(), batch);
+        all.insert(all.end(), lines.begin(), lines.end());
+    }
+}
+
+class FilesTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        documents_ = (dir_.path() / "documents").string();
+        cache_ = (dir_.path() / "cache").string();
+        fs::create_directories(documents_);
+        fs::create_directories(cache_);
+        setRoots({{"documents", documents_}, {"cache", cache_}});
+    }
+    void TearDown() override {
+        setRoots({});
+    }
+
+    threadforge::testing::TempDir dir_;
+    std::string documents_;
+    std::string cache_;
+};
+
+TEST_F(FilesTest, ResolvesPathsInsideTheRoots) {
+    const auto documents = fs::canonical(documents_).string();
+    EXPECT_EQ(resolvePath("notes/today.txt"), documents + "/notes/today.txt");
+    EXPECT_EQ(resolvePath("./a/../b.txt"), documents + "/b.txt");
+    EXPECT_EQ(resolvePath(cache_ + "/thumbs/1.png"), fs::canonical(cache_).string() + "/thumbs/1.png");
+    EXPECT_EQ(roots().size(), 2u);
+
+    EXPECT_THROW(resolvePath(""), std::invalid_argument);
+    EXPECT_THROW(resolvePath("../cache-sibling.txt"), std::invalid_argument);
+    EXPECT_THROW(resolvePath("/etc/passwd"), std::invalid_argument);
+    // A prefix of a root is not inside it.
+    EXPECT_THROW(resolvePath(documents_ + "-other/file"), std::invalid_argument);
+
+    setRoots({});
+    EXPECT_THROW(resolvePath("notes/today.txt"), std::invalid_argument);
+}
+
+TEST_F(FilesTest, SymlinksCannotLeaveTheSandbox) {
+    const auto outside = (dir_.path() / "outside").string();
+    fs::create_directories(outside);
+    writeText(outside + "/secret.txt", "secret");
+    fs::create_directory_symlink(outside, documents_ + "/escape");
+    fs::create_symlink(outside + "/missing.txt", documents_ + "/dangling");
+    fs::create_directory_symlink(cache_, documents_ + "/cache-link");
+
+    EXPECT_THROW(resolvePath("escape/secret.txt"), std::invalid_argument);
+    EXPECT_THROW(resolvePath("escape/new.txt"), std::invalid_argument);
+    EXPECT_THROW(resolvePath("dangling"), std::invalid_argument);
+    // Links between roots stay allowed.
+    EXPECT_EQ(resolvePath("cache-link/a.bin"), fs::canonical(cache_).string() + "/a.bin");
+}
+
+TEST_F(FilesTest, StatsFilesAndMissingPaths) {
+    writeText(documents_ + "/data.bin", std::string(1234, 'x'));
+    const auto info = stat(documents_ + "/data.bin");
+    EXPECT_TRUE(info.exists);
+    EXPECT_FALSE(info.directory);
+    EXPECT_EQ(info.size, 1234u);
+    EXPECT_GT(info.modifiedMs, 0.0);
+    EXPECT_TRUE(stat(documents_).directory);
+    EXPECT_FALSE(stat(documents_ + "/missing").exists);
+    EXPECT_FALSE(stat(documents_ + "/data.bin/child").exists);
+}
+
+TEST_F(FilesTest, MapsAnyRangeCopyOnWrite) {
+    std::string text;
+    for (int i = 0; i < 5000; ++i) {
+        text += static_cast<char>('a' + i % 26);
+    }
+    const auto path = documents_ + "/letters.txt";
+    writeText(path, text);
+
+    const auto whole = MappedFile::open(path);
+    ASSERT_EQ(whole->size(), text.size());
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(whole->data()), whole->size()), text);
+
+    // An offset that is not page aligned.
+    const auto middle = MappedFile::open(path, 4099, 10);
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(middle->data()), middle->size()), text.substr(4099, 10));
+
+    middle->data()[0] = '!';
+    EXPECT_EQ(readText(path), text);
+    EXPECT_EQ(MappedFile::open(path, 4099, 1)->data()[0], static_cast<uint8_t>(text[4099]));
+
+    EXPECT_EQ(MappedFile::open(path, text.size())->size(), 0u);
+    EXPECT_THROW(MappedFile::open(path, text.size() + 1), std::invalid_argument);
+    EXPECT_THROW(MappedFile::open(path, 10, text.size()), std::invalid_argument);
+    try {
+        MappedFile::open(documents_ + "/missing.bin");
+        FAIL() << "expected an Error";
+    } catch (const Error& error) {
+        EXPECT_EQ(error.code(), ENOENT);
+    }
+}
+
+TEST_F(FilesTest, ReadsLinesAcrossWindowBoundaries) {
+    // Lines of varying length, CRLF endings, one line longer than the window
+    // and a final line without a newline.
+    std::vector<std::string> expected;
+    std::string text;
+    for (int i = 0; i < 3000; ++i) {
+        expected.push_back(std::string(static_cast<size_t>(i % 37), static_cast<char>('a' + i % 26)));
+        text += expected.back() + (i % 3 == 0 ? "\r\n" : "\n");
+    }
+    expected.emplace_back(20000, 'L');
+    text += expected.back() + "\n";
+    expected.emplace_back("");
+    text += "\n";
+    expected.emplace_back("tail");
+    text += "tail";
+    const auto path = documents_ + "/lines.txt";
+    writeText(path, text);
+
+    FileReader reader(path, 4096);
+    EXPECT_EQ(reader.size(), text.size());
+    EXPECT_EQ(readAllLines(reader, 100), expected);
+    EXPECT_EQ(reader.position(), text.size());
+
+    writeText(path, "one\ntwo\n");
+    FileReader trailing(path);
+    EXPECT_EQ(readAllLines(trailing, 10), (std::vector<std::string>{"one", "two"}));
+}
+
+TEST_F(FilesTest, HandsOutChunksAsMappings) {
+    const std::string text(10000, 'c');
+    const auto path = documents_ + "/chunks.bin";
+    writeText(path, text);
+
+    FileReader reader(path);
+    EXPECT_THROW(reader.nextChunk(0), std::invalid_argument);
+    std::vector<size_t> sizes;
+    while (auto chunk = reader.nextChunk(4096)) {
+        sizes.push_back(chunk->size());
+    }
+    EXPECT_EQ(sizes, (std::vector<size_t>{4096, 4096, 1808}));
+    reader.close();
+    EXPECT_THROW(reader.nextChunk(1), std::invalid_argument);
+    std::vector<std::string_view> lines;
+    EXPECT_THROW(reader.nextLines(1, lines), std::invalid_argument);
+}
+
+TEST_F(FilesTest, FreshWritesOnlyReplaceTheFileOnCommit) {
+    const auto path = documents_ + "/report.json";
+    writeText(path, "old");
+
+    {
+        FileWriter writer(path, false);
+        writer.write("new ", 4);
+        writer.write("contents", 8);
+        EXPECT_EQ(writer.written(), 12u);
+        EXPECT_EQ(readText(path), "old");
+        writer.abandon();
+        EXPECT_FALSE(writer.isOpen());
+    }
+    EXPECT_EQ(readText(path), "old");
+
+    {
+        // Dropping a writer without commit() abandons it too.
+        FileWriter writer(path, false);
+        writer.write("lost", 4);
+    }
+    EXPECT_EQ(readText(path), "old");
+
+    FileWriter writer(path, false);
+    writer.write("new contents", 12);
+    writer.commit();
+    EXPECT_EQ(readText(path), "new contents");
+    EXPECT_THROW(writer.write("x", 1), std::invalid_argument);
+
+    // No temporary files are left behind.
+    size_t entries = 0;
+    for ([[maybe_unused]] const auto& entry : fs::directory_iterator(documents_)) {
+        ++entries;
+    }
+    EXPECT_EQ(entries, 1u);
+}
+
+TEST_F(FilesTest, AppendsInPlace) {
+    const auto path = documents_ + "/log.txt";
+    writeFile(path, "a\n", 2, true);
+    writeFile(path, "b\n", 2, true);
+    EXPECT_EQ(readText(path), "a\nb\n");
+    writeFile(path, "c\n", 2, false);
+    EXPECT_EQ(readText(path), "c\n");
+
+    try {
+        writeFile(documents_ + "/missing-dir/file.txt", "x", 1, false);
+        FAIL() << "expected an Error";
+    } catch (const Error& error) {
+        EXPECT_EQ(error.code(), ENOENT);
+    }
+}
+
+} // namespace
+} // namespace threadforge::files
@@ -0,0 +1,271 @@
+#include "Hashing.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "TempDir.h"
+
+namespace threadforge::hashing {
+namespace {
+
+std::string hex(const std::vector<uint8_t>& digest) {
+    std::string text;
+    char pair[3];
+    for (uint8_t byte : digest) {
+        std::snprintf(pair, sizeof(pair), "%02x", byte);
+        text += pair;
+    }
+    return text;
+}
+
+// The input of the official BLAKE3 test vectors: 0, 1, ..., 250, 0, 1, ...
+std::vector<uint8_t> pattern(size_t size) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<uint8_t>(i % 251);
+    }
+    return data;
+}
+
+std::string hashHex(Algorithm algorithm, const std::vector<uint8_t>& data, uint64_t seed = 0) {
+    return hex(hash(algorithm, data.data(), data.size(), seed));
+}
+
+#ifdef THREADFORGE_TEST_PORTABLE_HASHES
+// The same tests again on the portable CRC32C and SHA-256, which hosts with
+// the instructions would otherwise never run.
+class PortableHashes : public ::testing::Environment {
+public:
+    void SetUp() override {
+        disableAcceleration();
+    }
+};
+const auto* const kPortableHashes = ::testing::AddGlobalTestEnvironment(new PortableHashes);
+#endif
+
+// Reference digests from the xxhash and blake3 Python packages, hashlib and a
+// bitwise CRC32C. Sizes straddle stripes, BLAKE3 chunks (1 KiB) and its
+// parallel subtrees (64 KiB), and the parallel CRC32C threshold (4 MiB).
+struct Vector {
+    size_t size;
+    const char* xxh32;
+    const char* xxh64;
+    const char* crc32c;
+    const char* sha256;
+    const char* blake3;
+};
+
+const Vector kVectors[] = {
+    {0,
+     "02cc5d05",
+     "ef46db3751d8e999",
+     "00000000",
+     "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+     "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262"},
+    {1,
+     "cf65b03e",
+     "e934a84adb052768",
+     "527d5351",
+     "6e340b9cffb37a989ca544e6bb780a2c78901d3fb33738768511a30617afa01d",
+     "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213"},
+    {3,
+     "663e9a55",
+     "e5c7bb4533bc65dd",
+     "92fd4bfa",
+     "ae4b3280e56e2faf83f414a6e3dabe9d5fbe18976544c05fed121accb85b53fc",
+     "e1be4d7a8ab5560aa4199eea339849ba8e293d55ca0a81006726d184519e647f"},
+    {31,
+     "ef24f709",
+     "c346d2b59b4d8ee1",
+     "e95cabcb",
+     "4f23c2ca8c5c962e50cd31e221bfb6d0adca19111dca8e0c62598ff146dd19c4",
+     "bda80c7fe2db38be6387b35c870bd7728d67b7b6cc5eb9b0e5c7dcb21ea754c2"},
+    {32,
+     "830741c1",
+     "cbf59c5116ff32b4",
+     "46dd794e",
+     "630dcd2966c4336691125448bbb25b4ff412a49c732db2c8abc1b8581bd710dd",
+     "e528e95798037df410543d9f31e396ecdd458d71b157d6014398bae32fb56c65"},
+    {33,
+     "f1e6a545",
+     "0c535d1acafb8ead",
+     "9f85a26d",
+     "5d8fcfefa9aeeb711fb8ed1e4b7d5c8a9bafa46e8e76e68aa18adce5a10df6ab",
+     "4f4e6c1dffd3a6c9959876d15aa96b5fb0da8632b995f6ca2e30503f2829fa29"},
+    {1023,
+     "cc664d02",
+     "d66738f081c25cf4",
+     "39a4911a",
+     "1c5e88a585b61754df6137d66632a7348557a88358afc401b0a0a4fc427104a9",
+     "10108970eeda3eb932baac1428c7a2163b0e924c9a9e25b35bba72b28f70bd11"},
+    {1024,
+     "69dd7c7e",
+     "138e26c65048ce29",
+     "2af62c0c",
+     "2bce1ba628720664be4b9fdd77aae0678e5f0f3f02fc6ff641ec879094f6a404",
+     "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7"},
+    {1025,
+     "d6a1188a",
+     "cfd73aedd2d6a39d",
+     "c8d03add",
+     "bc0b6b10b89b9487a12fda2a8cc13194e7091c217aabf8b92846274026f4bcd0",
+     "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444"},
+    {2049,
+     "6524dcf5",
+     "27858160679416ba",
+     "0be89406",
+     "26e1e2808e3a6cf967ca03f6749a063c5ed55f92f5874653a1faabed78346f00",
+     "5f4d72f40d7a5f82b15ca2b2e44b1de3c2ef86c426c95c1af0b6879522563030"},
+    {8193,
+     "8ee4003d",
+     "755e4befd10cccf4",
+     "e814309c",
+     "7e3691790cd64b19d4edb1a80e988214515abeb53aa0f34ffbfe4b4bf405d120",
+     "bab6c09cb8ce8cf459261398d2e7aef35700bf488116ceb94a36d0f5f1b7bc3b"},
+    {65536,
+     "11fc918e",
+     "316c40df46fe2584",
+     "0daafcde",
+     "4b640d85ab3ba30fd02c9fc9db4a8928f416322ad27022ea58a65aaee68a4df2",
+     "68d647e619a930e7b1082f74f334b0c65a315725569bdc123f0ee11881717bfe"},
+    {102400,
+     "96c7eb65",
+     "eb1adcdd9e1369a6",
+     "7957da17",
+     "74588b7f0bcc354ac14d9cf199fa3a20c05f0c7293b9075b2f2e146e718de800",
+     "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085"},
+    {1048581,
+     "105926c2",
+     "a7772578f0b0e043",
+     "341908bf",
+     "b5c324a19845fd0e5fd3bb9471d9ced2215154672c50aca851fc0ca780f761da",
+     "e7d3a085aae37615eb1535109c71eae66a4d65d741e7d6b3268608c5a509ec4e"},
+    {9437191,
+     "1d674c4c",
+     "f65d0129eb6edef6",
+     "747f5e9f",
+     "8461691889434d8612698ecdc04cfe0ce63ef00d872f239d7e652b027e2bfda9",
+     "3921c624961dc453b3ad2f5ec310c0daab99a5e8dbb8a7ef758918800094e2c4"},
+};
+
+class HashingVectorTest : public ::testing::TestWithParam<Vector> {};
+
+TEST_P(HashingVectorTest, MatchesReferenceDigests) {
+    const auto& vector = GetParam();
+    const auto data = pattern(vector.size);
+    EXPECT_EQ(hashHex(Algorithm::XXH32, data), vector.xxh32);
+    EXPECT_EQ(hashHex(Algorithm::XXH64, data), vector.xxh64);
+    EXPECT_EQ(hashHex(Algorithm::CRC32C, data), vector.crc32c);
+    EXPECT_EQ(hashHex(Algorithm::SHA256, data), vector.sha256);
+    EXPECT_EQ(hashHex(Algorithm::BLAKE3, data), vector.blake3);
+}
+
+INSTANTIATE_TEST_SUITE_P(Sizes, HashingVectorTest, ::testing::ValuesIn(kVectors), [](const auto& info) {
+    return "Bytes" + std::to_string(info.param.size);
+});
+
+TEST(HashingTest, NamesAlgorithms) {
+    const std::pair<const char*, size_t> expected[] = {
+        {"xxh32", 4}, {"xxh64", 8}, {"crc32c", 4}, {"sha256", 32}, {"blake3", 32}};
+    for (const auto& [name, size] : expected) {
+        Algorithm algorithm;
+        ASSERT_TRUE(parseAlgorithm(name, algorithm)) << name;
+        EXPECT_STREQ(algorithmName(algorithm), name);
+        EXPECT_EQ(digestSize(algorithm), size);
+        EXPECT_EQ(hash(algorithm, nullptr, 0).size(), size);
+    }
+    Algorithm algorithm;
+    EXPECT_FALSE(parseAlgorithm("md5", algorithm));
+
+    const std::string crc = implementation(Algorithm::CRC32C);
+    const std::string sha = implementation(Algorithm::SHA256);
+#ifdef THREADFORGE_TEST_PORTABLE_HASHES
+    EXPECT_EQ(crc, "portable");
+    EXPECT_EQ(sha, "portable");
+#else
+    EXPECT_TRUE(crc == "sse4.2" || crc == "armv8-crc" || crc == "portable") << crc;
+    EXPECT_TRUE(sha == "sha-ni" || sha == "armv8-sha2" || sha == "portable") << sha;
+#endif
+    EXPECT_STREQ(implementation(Algorithm::BLAKE3), "portable");
+}
+
+TEST(HashingTest, SeedsTheXxHashFunctionsOnly) {
+    const std::vector<uint8_t> abc = {'a', 'b', 'c'};
+    EXPECT_EQ(hashHex(Algorithm::XXH32, abc, 0x9e3779b1), "a1ae7709");
+    EXPECT_EQ(hashHex(Algorithm::XXH64, abc, 0x0123456789abcdefull), "1fc03ef74cebaa7d");
+    EXPECT_EQ(Xxh32::of(abc.data(), abc.size(), 0x9e3779b1), 0xa1ae7709u);
+    EXPECT_EQ(hashHex(Algorithm::SHA256, abc, 42), hashHex(Algorithm::SHA256, abc));
+    EXPECT_EQ(hashHex(Algorithm::BLAKE3, abc, 42), hashHex(Algorithm::BLAKE3, abc));
+}
+
+TEST(HashingTest, ContinuesCrc32c) {
+    const std::string check = "123456789";
+    const auto* bytes = reinterpret_cast<const uint8_t*>(check.data());
+    EXPECT_EQ(crc32c(0, bytes, check.size()), 0xe3069283u);
+    EXPECT_EQ(crc32c(crc32c(0, bytes, 4), bytes + 4, 5), 0xe3069283u);
+    EXPECT_EQ(crc32c(0x1234u, nullptr, 0), 0x1234u);
+}
+
+TEST(HashingTest, StreamsInAnyPieces) {
+    const auto data = pattern((size_t{5} << 20) + 321);
+    std::mt19937 random(3);
+    for (const auto algorithm :
+         {Algorithm::XXH32, Algorithm::XXH64, Algorithm::CRC32C, Algorithm::SHA256, Algorithm::BLAKE3}) {
+        SCOPED_TRACE(algorithmName(algorithm));
+        const auto expected = hash(algorithm, data.data(), data.size(), 7);
+        auto hasher = Hasher::create(algorithm, 7);
+        size_t at = 0;
+        std::vector<uint8_t> partial;
+        while (at < data.size()) {
+            // Mostly small pieces, now and then one big enough to go parallel.
+            const size_t piece = std::min(data.size() - at, random() % 16 == 0 ? size_t{1} << 20 : random() % 5000);
+            hasher->update(data.data() + at, piece);
+            at += piece;
+            if (partial.empty() && at > data.size() / 2) {
+                // A digest mid-stream matches the prefix and leaves the state alone.
+                partial = hasher->digest();
+                EXPECT_EQ(partial, hash(algorithm, data.data(), at, 7));
+            }
+        }
+        EXPECT_EQ(hasher->digest(), expected);
+        EXPECT_EQ(hasher->digest(), expected);
+
+        hasher->reset();
+        hasher->update(data.data(), 10);
+        EXPECT_EQ(hasher->digest(), hash(algorithm, data.data(), 10, 7));
+    }
+}
+
+TEST(HashingTest, HashesFiles) {
+    threadforge::testing::TempDir dir;
+    const auto data = pattern((size_t{9} << 20) + 7);
+    std::ofstream(dir.file("blob.bin"), std::ios::binary)
+        .write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+    std::vector<uint8_t> digest;
+    uint64_t size = 0;
+    ASSERT_TRUE(hashFile(Algorithm::BLAKE3, dir.file("blob.bin"), digest, size));
+    EXPECT_EQ(size, data.size());
+    EXPECT_EQ(hex(digest), kVectors[std::size(kVectors) - 1].blake3);
+
+    ASSERT_TRUE(hashFile(Algorithm::XXH64, dir.file("blob.bin"), digest, size, nullptr, 5));
+    EXPECT_EQ(digest, hash(Algorithm::XXH64, data.data(), data.size(), 5));
+
+    std::ofstream(dir.file("empty.bin"));
+    ASSERT_TRUE(hashFile(Algorithm::SHA256, dir.file("empty.bin"), digest, size));
+    EXPECT_EQ(size, 0u);
+    EXPECT_EQ(hex(digest), kVectors[0].sha256);
+
+    EXPECT_FALSE(hashFile(Algorithm::SHA256, dir.file("blob.bin"), digest, size, [] {
+        return true;
+    }));
+}
+
+} // namespace
+} // namespace threadforge::hashing
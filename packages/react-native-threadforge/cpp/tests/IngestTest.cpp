@@ -0,0 +1,388 @@
+#include "Ingest.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Files.h"
+#include "TempDir.h"
+
+namespace threadforge::ingest {
+namespace {
+
+Table parseText(const std::string& text, Options options = {}) {
+    Table table;
+    EXPECT_TRUE(parse(reinterpret_cast<const uint8_t*>(text.data()), text.size(), options, table));
+    return table;
+}
+
+Options ndjson() {
+    Options options;
+    options.format = Format::NDJSON;
+    return options;
+}
+
+const Column& column(const Table& table, const std::string& name) {
+    for (const auto& candidate : table.columns) {
+        if (candidate.name == name) {
+            return candidate;
+        }
+    }
+    throw std::out_of_range("no column " + name);
+}
+
+template <typename T>
+std::vector<T> valuesOf(const Column& column) {
+    std::vector<T> values(column.data.size() / sizeof(T));
+    std::memcpy(values.data(), column.data.data(), column.data.size());
+    return values;
+}
+
+// The column's strings, with "<missing>" for kMissingCode.
+std::vector<std::string> stringsOf(const Column& column) {
+    EXPECT_EQ(column.kind, ColumnKind::STRING);
+    std::vector<std::string> strings;
+    for (const uint32_t code : valuesOf<uint32_t>(column)) {
+        strings.push_back(code == kMissingCode ? "<missing>" : column.dictionary.at(code));
+    }
+    return strings;
+}
+
+std::vector<std::string> namesOf(const Table& table) {
+    std::vector<std::string> names;
+    for (const auto& candidate : table.columns) {
+        names.push_back(candidate.name);
+    }
+    return names;
+}
+
+TEST(IngestNames, FormatsAndKindsRoundTrip) {
+    Format format;
+    EXPECT_TRUE(parseFormat("csv", format));
+    EXPECT_EQ(format, Format::CSV);
+    EXPECT_TRUE(parseFormat("jsonl", format));
+    EXPECT_EQ(format, Format::NDJSON);
+    EXPECT_TRUE(parseFormat("ndjson", format));
+    EXPECT_FALSE(parseFormat("CSV", format));
+    EXPECT_FALSE(parseFormat("tsv", format));
+
+    for (const auto kind : {ColumnKind::FLOAT64, ColumnKind::FLOAT32, ColumnKind::INT32, ColumnKind::STRING}) {
+        ColumnKind parsed;
+        ASSERT_TRUE(parseColumnKind(columnKindName(kind), parsed));
+        EXPECT_EQ(parsed, kind);
+    }
+    ColumnKind parsed;
+    EXPECT_FALSE(parseColumnKind("int64", parsed));
+}
+
+TEST(IngestCsv, InfersNumbersAndDictionaryEncodesTheRest) {
+    const auto table = parseText("id,city,price\n1,Oslo,9.5\n2,Lima,-1e3\n3,Oslo, 7 \n");
+
+    ASSERT_EQ(table.rows, 3u);
+    EXPECT_EQ(namesOf(table), (std::vector<std::string>{"id", "city", "price"}));
+    EXPECT_EQ(column(table, "id").kind, ColumnKind::FLOAT64);
+    EXPECT_EQ(valuesOf<double>(column(table, "id")), (std::vector<double>{1, 2, 3}));
+    EXPECT_EQ(valuesOf<double>(column(table, "price")), (std::vector<double>{9.5, -1000, 7}));
+    EXPECT_EQ(column(table, "city").dictionary, (std::vector<std::string>{"Oslo", "Lima"}));
+    EXPECT_EQ(valuesOf<uint32_t>(column(table, "city")), (std::vector<uint32_t>{0, 1, 0}));
+}
+
+TEST(IngestCsv, ParsesNumbersExactly) {
+    const std::string text = "x\n0.1\n123456789012345678901\n1.7976931348623157e308\n-0\n+4.25e-2\n1e\n.\n";
+    Options options;
+    options.types = {{"x", ColumnKind::FLOAT64}};
+    const auto x = valuesOf<double>(column(parseText(text, options), "x"));
+
+    ASSERT_EQ(x.size(), 7u);
+    EXPECT_EQ(x[0], 0.1);
+    EXPECT_EQ(x[1], 123456789012345678901.0);
+    EXPECT_EQ(x[2], 1.7976931348623157e308);
+    EXPECT_TRUE(std::signbit(x[3]));
+    EXPECT_EQ(x[4], 0.0425);
+    EXPECT_TRUE(std::isnan(x[5]));
+    EXPECT_TRUE(std::isnan(x[6]));
+    // Untyped, the sample sees the non-numbers and keeps the column as text.
+    EXPECT_EQ(column(parseText(text), "x").kind, ColumnKind::STRING);
+}
+
+TEST(IngestCsv, UnquotesFieldsAndKeepsTheirDelimitersAndNewlines) {
+    const auto table = parseText(
+        "name,note\r\n"
+        "\"Smith, J\",\"said \"\"hi\"\"\"\r\n"
+        "\r\n"
+        "plain,\"two\nlines\"\r\n"
+        "\"\",\"closed\"junk\r\n");
+
+    ASSERT_EQ(table.rows, 3u);
+    EXPECT_EQ(stringsOf(column(table, "name")), (std::vector<std::string>{"Smith, J", "plain", ""}));
+    // The text after a closing quote is dropped.
+    EXPECT_EQ(stringsOf(column(table, "note")), (std::vector<std::string>{"said \"hi\"", "two\nlines", "closed"}));
+}
+
+TEST(IngestCsv, ShortRecordsAreMissingAndEmptyFieldsAreEmptyStrings) {
+    const auto table = parseText("a,b,c\n1,x,2\n3\n,,\n");
+
+    ASSERT_EQ(table.rows, 3u);
+    const auto a = valuesOf<double>(column(table, "a"));
+    EXPECT_EQ(a[0], 1);
+    EXPECT_EQ(a[1], 3);
+    EXPECT_TRUE(std::isnan(a[2]));
+    EXPECT_EQ(stringsOf(column(table, "b")), (std::vector<std::string>{"x", "<missing>", ""}));
+    const auto c = valuesOf<double>(column(table, "c"));
+    EXPECT_EQ(c[0], 2);
+    EXPECT_TRUE(std::isnan(c[1]));
+    EXPECT_TRUE(std::isnan(c[2]));
+}
+
+TEST(IngestCsv, NamesColumnsByPositionWithoutAHeader) {
+    Options options;
+    options.header = false;
+    options.delimiter = ';';
+    const auto table = parseText("1;a\n2;b;9\n", options);
+
+    ASSERT_EQ(table.rows, 2u);
+    EXPECT_EQ(namesOf(table), (std::vector<std::string>{"0", "1", "2"}));
+    EXPECT_EQ(valuesOf<double>(column(table, "0")), (std::vector<double>{1, 2}));
+    EXPECT_EQ(stringsOf(column(table, "1")), (std::vector<std::string>{"a", "b"}));
+    const auto third = valuesOf<double>(column(table, "2"));
+    EXPECT_TRUE(std::isnan(third[0]));
+    EXPECT_EQ(third[1], 9);
+}
+
+TEST(IngestCsv, SkipsAByteOrderMark) {
+    const auto table = parseText("\xEF\xBB\xBFid\n5\n");
+
+    EXPECT_EQ(namesOf(table), (std::vector<std::string>{"id"}));
+    EXPECT_EQ(valuesOf<double>(column(table, "id")), (std::vector<double>{5}));
+}
+
+TEST(IngestCsv, SelectsAndTypesColumns) {
+    Options options;
+    options.select = {"qty", "sku"};
+    options.types = {{"qty", ColumnKind::INT32}, {"sku", ColumnKind::STRING}, {"weight", ColumnKind::FLOAT32}};
+    const auto table = parseText("sku,weight,qty\n100,0.25,7.9\n200,x,-3000000000\n300,1.5,-2.5\n", options);
+
+    EXPECT_EQ(namesOf(table), (std::vector<std::string>{"qty", "sku"}));
+    EXPECT_EQ(column(table, "qty").kind, ColumnKind::INT32);
+    // Fractions truncate; values outside int32 become 0.
+    EXPECT_EQ(valuesOf<int32_t>(column(table, "qty")), (std::vector<int32_t>{7, 0, -2}));
+    // Numeric text stays text when typed as a string.
+    EXPECT_EQ(stringsOf(column(table, "sku")), (std::vector<std::string>{"100", "200", "300"}));
+
+    Options floats;
+    floats.types = {{"weight", ColumnKind::FLOAT32}};
+    const auto weights = parseText("sku,weight,qty\n100,0.25,7.9\n200,x,1\n", floats);
+    const auto weight = valuesOf<float>(column(weights, "weight"));
+    ASSERT_EQ(weight.size(), 2u);
+    EXPECT_EQ(weight[0], 0.25f);
+    EXPECT_TRUE(std::isnan(weight[1]));
+}
+
+TEST(IngestCsv, InfersFromTheFirstInferRowsRecords) {
+    Options options;
+    options.inferRows = 2;
+    const auto table = parseText("v\n1\n2\nthree\n", options);
+
+    // The sample saw numbers only, so "three" becomes NaN.
+    ASSERT_EQ(column(table, "v").kind, ColumnKind::FLOAT64);
+    EXPECT_TRUE(std::isnan(valuesOf<double>(column(table, "v"))[2]));
+
+    options.inferRows = 3;
+    EXPECT_EQ(column(parseText("v\n1\n2\nthree\n", options), "v").kind, ColumnKind::STRING);
+    // A column with no values in the sample is a string column.
+    EXPECT_EQ(column(parseText("v,w\n1,\n2,\n"), "w").kind, ColumnKind::STRING);
+}
+
+TEST(IngestCsv, RejectsBadOptionsAndInput) {
+    Options unknown;
+    unknown.select = {"nope"};
+    Table table;
+    const std::string text = "a\n1\n";
+    const auto* data = reinterpret_cast<const uint8_t*>(text.data());
+    try {
+        parse(data, text.size(), unknown, table);
+        FAIL() << "expected an unknown column error";
+    } catch (const std::invalid_argument& ex) {
+        EXPECT_STREQ(ex.what(), "unknown column 'nope'");
+    }
+
+    Options typed;
+    typed.types = {{"b", ColumnKind::INT32}};
+    EXPECT_THROW(parse(data, text.size(), typed, table), std::invalid_argument);
+
+    Options quote;
+    quote.delimiter = '"';
+    EXPECT_THROW(parse(data, text.size(), quote, table), std::invalid_argument);
+
+    const std::string open = "a,b\n1,\"never closed\n2,3\n";
+    try {
+        parse(reinterpret_cast<const uint8_t*>(open.data()), open.size(), Options(), table);
+        FAIL() << "expected an unterminated field error";
+    } catch (const std::invalid_argument& ex) {
+        EXPECT_STREQ(ex.what(), "unterminated quoted field at byte 6");
+    }
+    EXPECT_TRUE(table.columns.empty());
+}
+
+// Enough records to span several 1 MiB chunks, with quoted newlines and
+// delimiters so the chunk boundaries have to respect the quotes.
+std::string largeCsv(size_t rows, bool strayQuote) {
+    std::string text = "id,label,score\n";
+    for (size_t r = 0; r < rows; ++r) {
+        text += std::to_string(r);
+        text += r % 3 == 0 ? ",\"tag " + std::to_string(r % 7) + ",\nnext\"" : ",plain" + std::to_string(r % 5);
+        if (strayQuote && r == 10) {
+            text += "\"";
+        }
+        text += "," + std::to_string(r * 0.5) + "\n";
+    }
+    return text;
+}
+
+void expectLargeCsv(const Table& table, size_t rows, bool strayQuote) {
+    ASSERT_EQ(table.rows, rows);
+    const auto ids = valuesOf<double>(column(table, "id"));
+    const auto scores = valuesOf<double>(column(table, "score"));
+    const auto labels = stringsOf(column(table, "label"));
+    for (size_t r = 0; r < rows; ++r) {
+        ASSERT_EQ(ids[r], static_cast<double>(r)) << r;
+        ASSERT_EQ(scores[r], r * 0.5) << r;
+        auto label = r % 3 == 0 ? "tag " + std::to_string(r % 7) + ",\nnext" : "plain" + std::to_string(r % 5);
+        if (strayQuote && r == 10) {
+            label += "\"";
+        }
+        ASSERT_EQ(labels[r], label) << r;
+    }
+}
+
+TEST(IngestCsv, SplitsLargeInputsAtRecordBoundaries) {
+    constexpr size_t kRows = 200000;
+    const auto text = largeCsv(kRows, false);
+    ASSERT_GT(text.size(), size_t(4) << 20);
+    const auto table = parseText(text);
+
+    expectLargeCsv(table, kRows, false);
+    // Codes follow first appearance in the whole input, not per chunk.
+    EXPECT_EQ(column(table, "label").dictionary.front(), "tag 0,\nnext");
+    EXPECT_EQ(column(table, "label").dictionary[1], "plain1");
+    EXPECT_EQ(column(table, "label").dictionary.size(), 12u);
+}
+
+TEST(IngestCsv, ReparsesWhenAStrayQuoteThrowsTheSplitOff) {
+    constexpr size_t kRows = 120000;
+    expectLargeCsv(parseText(largeCsv(kRows, true)), kRows, true);
+}
+
+TEST(IngestCsv, CancellationLeavesTheTableUntouched) {
+    const auto text = largeCsv(100000, false);
+    Table table;
+    table.rows = 42;
+    std::atomic<int> polls{0};
+    const bool completed = parse(
+        reinterpret_cast<const uint8_t*>(text.data()), text.size(), Options(), table, [&polls] {
+            return ++polls > 1;
+        });
+
+    EXPECT_FALSE(completed);
+    EXPECT_EQ(table.rows, 42u);
+    EXPECT_TRUE(table.columns.empty());
+}
+
+TEST(IngestNdjson, TypesKeysInOrderOfAppearance) {
+    const auto table = parseText(
+        "{\"id\": 1, \"ok\": true, \"name\": \"a\\u00e9\\n\"}\n"
+        "\n"
+        "{\"id\": 2.5, \"ok\": false, \"extra\": \"late\"}\r\n"
+        "{\"name\": null, \"id\": null, \"tags\": [1, {\"x\": \"]\"}], \"meta\": {\"k\": 1}}\n",
+        ndjson());
+
+    ASSERT_EQ(table.rows, 3u);
+    EXPECT_EQ(namesOf(table), (std::vector<std::string>{"id", "ok", "name", "extra", "tags", "meta"}));
+    const auto id = valuesOf<double>(column(table, "id"));
+    EXPECT_EQ(id[0], 1);
+    EXPECT_EQ(id[1], 2.5);
+    EXPECT_TRUE(std::isnan(id[2]));
+    // Booleans are numbers in an inferred column; an absent key is missing.
+    const auto ok = valuesOf<double>(column(table, "ok"));
+    EXPECT_EQ(ok[0], 1);
+    EXPECT_EQ(ok[1], 0);
+    EXPECT_TRUE(std::isnan(ok[2]));
+    EXPECT_EQ(stringsOf(column(table, "name")), (std::vector<std::string>{"a\xC3\xA9\n", "<missing>", "<missing>"}));
+    EXPECT_EQ(stringsOf(column(table, "extra")), (std::vector<std::string>{"<missing>", "late", "<missing>"}));
+    // Nested values keep their JSON text.
+    EXPECT_EQ(stringsOf(column(table, "tags"))[2], "[1, {\"x\": \"]\"}]");
+    EXPECT_EQ(stringsOf(column(table, "meta"))[2], "{\"k\": 1}");
+}
+
+TEST(IngestNdjson, SelectsAndTypesKeys) {
+    auto options = ndjson();
+    options.select = {"flag", "n", "absent"};
+    options.types = {{"flag", ColumnKind::STRING}, {"n", ColumnKind::INT32}};
+    const auto table = parseText(
+        "{\"n\": \"12\", \"flag\": true, \"skip\": 1}\n"
+        "{\"n\": 3.99, \"flag\": \"maybe\"}\n"
+        "{\"n\": true, \"flag\": false}\n",
+        options);
+
+    EXPECT_EQ(namesOf(table), (std::vector<std::string>{"flag", "n", "absent"}));
+    EXPECT_EQ(stringsOf(column(table, "flag")), (std::vector<std::string>{"true", "maybe", "false"}));
+    // Numeric strings and booleans convert in a typed numeric column.
+    EXPECT_EQ(valuesOf<int32_t>(column(table, "n")), (std::vector<int32_t>{12, 3, 1}));
+    EXPECT_EQ(stringsOf(column(table, "absent")),
+              (std::vector<std::string>{"<missing>", "<missing>", "<missing>"}));
+}
+
+TEST(IngestNdjson, RejectsLinesThatAreNotObjects) {
+    const std::string text = "{\"a\": 1}\n[1, 2]\n";
+    Table table;
+    try {
+        parse(reinterpret_cast<const uint8_t*>(text.data()), text.size(), ndjson(), table);
+        FAIL() << "expected a JSON error";
+    } catch (const std::invalid_argument& ex) {
+        EXPECT_STREQ(ex.what(), "the line at byte 9 is not a JSON object");
+    }
+    EXPECT_EQ(table.rows, 0u);
+}
+
+TEST(IngestNdjson, SplitsLargeInputsAtLines) {
+    constexpr size_t kRows = 100000;
+    std::string text;
+    for (size_t r = 0; r < kRows; ++r) {
+        text += "{\"i\": " + std::to_string(r) + ", \"kind\": \"k" + std::to_string((kRows - r) % 300) + "\"}\n";
+    }
+    ASSERT_GT(text.size(), size_t(2) << 20);
+    const auto table = parseText(text, ndjson());
+
+    ASSERT_EQ(table.rows, kRows);
+    const auto i = valuesOf<double>(column(table, "i"));
+    const auto kinds = stringsOf(column(table, "kind"));
+    for (size_t r = 0; r < kRows; ++r) {
+        ASSERT_EQ(i[r], static_cast<double>(r));
+        ASSERT_EQ(kinds[r], "k" + std::to_string((kRows - r) % 300));
+    }
+    const auto& dictionary = column(table, "kind").dictionary;
+    ASSERT_EQ(dictionary.size(), 300u);
+    EXPECT_EQ(dictionary[0], "k" + std::to_string(kRows % 300));
+    EXPECT_EQ(dictionary[1], "k" + std::to_string((kRows - 1) % 300));
+}
+
+TEST(IngestFile, ParsesAMappedFile) {
+    testing::TempDir dir;
+    const auto path = dir.file("events.jsonl");
+    std::ofstream(path, std::ios::binary) << "{\"v\": 1}\n{\"v\": 2}";
+
+    Table table;
+    ASSERT_TRUE(parseFile(path, ndjson(), table));
+    EXPECT_EQ(valuesOf<double>(column(table, "v")), (std::vector<double>{1, 2}));
+
+    EXPECT_THROW(parseFile(dir.file("absent.csv"), Options(), table), files::Error);
+}
+
+} // namespace
+} // namespace threadforge::ingest
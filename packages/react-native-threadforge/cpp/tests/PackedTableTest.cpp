@@ -0,0 +1,100 @@
+#include "PackedTable.h"
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace threadforge {
+namespace {
+
+std::string encode(const std::string& bytes) {
+    return encodeBase64(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
+}
+
+// Decodes through the same two steps as the JSI column decoder.
+bool decode(const std::string& text, std::vector<uint8_t>& out) {
+    const size_t size = base64DecodedSize(text.data(), text.size());
+    if (size == SIZE_MAX) {
+        return false;
+    }
+    out.assign(size, 0);
+    return decodeBase64(text.data(), text.size(), out.data());
+}
+
+TEST(PackedTableTest, EncodesTheRfc4648Vectors) {
+    EXPECT_EQ(encode(""), "");
+    EXPECT_EQ(encode("f"), "Zg==");
+    EXPECT_EQ(encode("fo"), "Zm8=");
+    EXPECT_EQ(encode("foo"), "Zm9v");
+    EXPECT_EQ(encode("foob"), "Zm9vYg==");
+    EXPECT_EQ(encode("fooba"), "Zm9vYmE=");
+    EXPECT_EQ(encode("foobar"), "Zm9vYmFy");
+}
+
+TEST(PackedTableTest, RoundTripsColumnBytesOfEveryLength) {
+    // Lengths around the SIMD block sizes, filled with every byte value.
+    std::mt19937 rng(92);
+    for (size_t length = 0; length < 200; ++length) {
+        std::vector<uint8_t> bytes(length);
+        for (auto& byte : bytes) {
+            byte = static_cast<uint8_t>(rng());
+        }
+        const auto text = encodeBase64(bytes.data(), bytes.size());
+        ASSERT_EQ(text.size(), (length + 2) / 3 * 4);
+        std::vector<uint8_t> decoded;
+        ASSERT_TRUE(decode(text, decoded)) << length;
+        ASSERT_EQ(decoded, bytes) << length;
+    }
+}
+
+TEST(PackedTableTest, RoundTripsALittleEndianFloat64Column) {
+    const std::vector<double> column{1.5, -2.0, 0.1, 1e308};
+    const auto text = encodeBase64(reinterpret_cast<const uint8_t*>(column.data()), column.size() * sizeof(double));
+    std::vector<uint8_t> decoded;
+    ASSERT_TRUE(decode(text, decoded));
+    ASSERT_EQ(decoded.size() % typedArrayElementSize("Float64Array"), 0u);
+    std::vector<double> values(decoded.size() / sizeof(double));
+    std::memcpy(values.data(), decoded.data(), decoded.size());
+    EXPECT_EQ(values, column);
+}
+
+TEST(PackedTableTest, SizesRejectBadLengthAndPadding) {
+    const auto sizeOf = [](const std::string& text) { return base64DecodedSize(text.data(), text.size()); };
+    EXPECT_EQ(sizeOf(""), 0u);
+    EXPECT_EQ(sizeOf("Zg=="), 1u);
+    EXPECT_EQ(sizeOf("Zm8="), 2u);
+    EXPECT_EQ(sizeOf("Zm9vYmFy"), 6u);
+    EXPECT_EQ(sizeOf("Zm9"), SIZE_MAX);
+    EXPECT_EQ(sizeOf("Z=g="), SIZE_MAX);
+    EXPECT_EQ(sizeOf("A==="), SIZE_MAX);
+    EXPECT_EQ(sizeOf("Zg==Zg=="), SIZE_MAX);
+}
+
+TEST(PackedTableTest, DecodeRejectsCharactersOutsideTheAlphabet) {
+    std::vector<uint8_t> out;
+    EXPECT_FALSE(decode("Zm9v!mFy", out));
+    // URL-safe characters are not part of the wire format.
+    EXPECT_FALSE(decode("Zm9-YmFy", out));
+    EXPECT_FALSE(decode(std::string(64, 'A') + "Zm9v YmFy" + "AAA", out));
+}
+
+TEST(PackedTableTest, KnowsEveryTypedArrayElementSize) {
+    EXPECT_EQ(typedArrayElementSize("Float64Array"), 8u);
+    EXPECT_EQ(typedArrayElementSize("Float32Array"), 4u);
+    EXPECT_EQ(typedArrayElementSize("Int32Array"), 4u);
+    EXPECT_EQ(typedArrayElementSize("Uint32Array"), 4u);
+    EXPECT_EQ(typedArrayElementSize("Int16Array"), 2u);
+    EXPECT_EQ(typedArrayElementSize("Uint16Array"), 2u);
+    EXPECT_EQ(typedArrayElementSize("Int8Array"), 1u);
+    EXPECT_EQ(typedArrayElementSize("Uint8Array"), 1u);
+    EXPECT_EQ(typedArrayElementSize("Uint8ClampedArray"), 1u);
+    EXPECT_EQ(typedArrayElementSize("BigInt64Array"), 0u);
+    EXPECT_EQ(typedArrayElementSize("float64"), 0u);
+}
+
+} // namespace
+} // namespace threadforge
@@ -0,0 +1,84 @@
+#include "ParallelFor.h"
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "SharedPool.h"
+
+namespace threadforge {
+namespace {
+
+class ParallelForTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        setSharedThreadPool(std::make_shared<ThreadPool>(4));
+    }
+    void TearDown() override {
+        setSharedThreadPool(nullptr);
+    }
+};
+
+TEST_F(ParallelForTest, CoversEveryIndexExactlyOnce) {
+    std::vector<std::atomic<int>> hits(10'007);
+    EXPECT_TRUE(parallelFor(hits.size(), 64, [&](size_t begin, size_t end) {
+        EXPECT_LE(end - begin, 64u);
+        for (size_t i = begin; i < end; ++i) {
+            hits[i]++;
+        }
+    }));
+    for (const auto& hit : hits) {
+        ASSERT_EQ(hit.load(), 1);
+    }
+}
+
+TEST_F(ParallelForTest, RunsInlineWithoutASharedPool) {
+    setSharedThreadPool(nullptr);
+    size_t covered = 0;
+    EXPECT_TRUE(parallelFor(1000, 10, [&](size_t begin, size_t end) { covered += end - begin; }));
+    EXPECT_EQ(covered, 1000u);
+}
+
+TEST_F(ParallelForTest, NestedInsideAPoolTaskDoesNotDeadlock) {
+    // A single-worker pool: the helpers can never start while the outer task
+    // holds the worker, so the caller has to claim every chunk itself.
+    auto pool = std::make_shared<ThreadPool>(1);
+    setSharedThreadPool(pool);
+    auto task = pool->enqueueTask(
+        "outer", TaskPriority::NORMAL,
+        [](const ProgressCallback&, const std::function<bool()>&) {
+            std::atomic<size_t> covered{0};
+            parallelFor(4096, 16, [&](size_t begin, size_t end) { covered += end - begin; });
+            return makeSuccessResult(std::to_string(covered.load()));
+        },
+        nullptr);
+    EXPECT_EQ(ThreadPool::waitForTask(task).valueJson, "4096");
+}
+
+TEST_F(ParallelForTest, StopsWhenCancelled) {
+    std::atomic<size_t> chunks{0};
+    const bool completed = parallelFor(
+        1'000'000, 1, [&](size_t, size_t) { chunks++; }, [&] { return chunks.load() >= 10; });
+    EXPECT_FALSE(completed);
+    EXPECT_LT(chunks.load(), 1'000'000u);
+}
+
+TEST_F(ParallelForTest, RethrowsTheFirstError) {
+    try {
+        parallelFor(256, 1, [](size_t begin, size_t) {
+            if (begin % 3 == 0) {
+                throw std::runtime_error("chunk " + std::to_string(begin));
+            }
+        });
+        FAIL() << "expected an exception";
+    } catch (const std::runtime_error& ex) {
+        EXPECT_EQ(std::string(ex.what()).rfind("chunk ", 0), 0u);
+    }
+}
+
+} // namespace
+} // namespace threadforge
@@ -0,0 +1,112 @@
+#include "SharedPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace threadforge {
+namespace {
+
+using namespace std::chrono_literals;
+
+TaskFunction returning(std::string valueJson) {
+    return [valueJson](const ProgressCallback&, const std::function<bool()>&) {
+        return makeSuccessResult(valueJson);
+    };
+}
+
+class SharedPoolTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        setSharedThreadPool(nullptr);
+    }
+};
+
+TEST_F(SharedPoolTest, SubmitWithoutAPoolSettlesWithAnError) {
+    setSharedThreadPool(nullptr);
+    std::atomic<int> completions{0};
+    auto handle = submitSharedTask("decoder:1", TaskPriority::NORMAL, returning("1"), nullptr,
+                                   [&completions](const TaskResult& result) {
+                                       EXPECT_FALSE(result.success);
+                                       completions++;
+                                   });
+
+    ASSERT_TRUE(handle.valid());
+    EXPECT_TRUE(handle.isDone());
+    EXPECT_EQ(handle.wait().errorMessage, "ThreadForge is not initialized");
+    EXPECT_EQ(completions.load(), 1);
+    EXPECT_FALSE(handle.cancel());
+}
+
+TEST_F(SharedPoolTest, SubmitsOntoTheInstalledPool) {
+    auto pool = std::make_shared<ThreadPool>(2);
+    setSharedThreadPool(pool);
+    EXPECT_EQ(sharedThreadPool(), pool);
+
+    // The completion callback runs on the worker after waiters wake, so wait for it separately.
+    std::promise<std::string> completed;
+    auto handle = submitSharedTask("decoder:2", TaskPriority::HIGH, returning("\"frame\""), nullptr,
+                                   [&completed](const TaskResult& result) {
+                                       completed.set_value(result.valueJson);
+                                   });
+    ASSERT_TRUE(handle.waitFor(5s));
+    EXPECT_TRUE(handle.wait().success);
+    EXPECT_EQ(handle.id(), "decoder:2");
+    auto callback = completed.get_future();
+    ASSERT_EQ(callback.wait_for(5s), std::future_status::ready);
+    EXPECT_EQ(callback.get(), "\"frame\"");
+}
+
+TEST_F(SharedPoolTest, CancelsAQueuedTaskThroughItsHandle) {
+    auto pool = std::make_shared<ThreadPool>(1);
+    setSharedThreadPool(pool);
+    pool->pause();
+    auto handle = submitSharedTask("decoder:3", TaskPriority::NORMAL, returning("3"));
+
+    EXPECT_TRUE(handle.cancel());
+    EXPECT_TRUE(handle.wait().cancelled);
+    pool->resume();
+}
+
+TEST_F(SharedPoolTest, DetachedPoolStaysStoppedAfterShutdown) {
+    auto pool = std::make_shared<ThreadPool>(4, 0, 0ms);
+    setSharedThreadPool(pool);
+    auto stale = submitSharedTask("decoder:4", TaskPriority::NORMAL, returning("4"));
+    ASSERT_TRUE(stale.waitFor(5s));
+
+    // What the platform bridges do on shutdown(), while another module still holds the pool.
+    setSharedThreadPool(nullptr);
+    pool->shutdown();
+    EXPECT_EQ(sharedThreadPool(), nullptr);
+
+    auto late = pool->enqueueTask("decoder:5", TaskPriority::HIGH, returning("5"), nullptr);
+    EXPECT_EQ(ThreadPool::waitForTask(late).errorMessage, "ThreadPool is stopped");
+    // No lazy growth either: the detached pool never gets workers again.
+    pool->setConcurrency(4);
+    pool->setIdlePolicy(2, 0ms);
+    EXPECT_EQ(pool->getThreadCount(), 0u);
+    EXPECT_FALSE(stale.cancel());
+}
+
+TEST_F(SharedPoolTest, ReplacingThePoolRetiresThePreviousOne) {
+    auto first = std::make_shared<ThreadPool>(1);
+    auto second = std::make_shared<ThreadPool>(1);
+    setSharedThreadPool(first);
+    setSharedThreadPool(first);
+    setSharedThreadPool(second);
+    first->shutdown();
+    second->shutdown();
+
+    // A pool that was never handed out is reusable after a clean shutdown.
+    EXPECT_TRUE(ThreadPool::waitForTask(second->enqueueTask("reuse", TaskPriority::NORMAL, returning("1"), nullptr))
+                    .success);
+    EXPECT_FALSE(ThreadPool::waitForTask(first->enqueueTask("stale", TaskPriority::NORMAL, returning("1"), nullptr))
+                     .success);
+}
+
+} // namespace
+} // namespace threadforge
@@ -0,0 +1,191 @@
+#include "Sorting.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "SharedPool.h"
+
+namespace threadforge::sorting {
+namespace {
+
+using columnar::Column;
+using columnar::ColumnType;
+
+template <typename T>
+Column column(ColumnType type, const std::vector<T>& values) {
+    return Column{type, values.data(), values.size()};
+}
+
+// Numeric order with NaN last in both directions.
+template <typename T>
+bool before(T a, T b, bool descending) {
+    if constexpr (std::is_floating_point_v<T>) {
+        if (std::isnan(a) || std::isnan(b)) {
+            return !std::isnan(a) && std::isnan(b);
+        }
+    }
+    return descending ? a > b : a < b;
+}
+
+template <typename T>
+std::vector<uint32_t> referenceOrder(const std::vector<T>& values, bool descending) {
+    std::vector<uint32_t> order(values.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](uint32_t a, uint32_t b) { return before(values[a], values[b], descending); });
+    return order;
+}
+
+// Random values with many duplicates and, for floats, some NaN. No -0.0: the
+// radix keys order it before +0.0 while a comparison sort keeps them tied.
+template <typename T>
+std::vector<T> randomValues(size_t count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<T> values(count);
+    for (auto& value : values) {
+        if constexpr (std::is_floating_point_v<T>) {
+            value = rng() % 50 == 0 ? std::numeric_limits<T>::quiet_NaN()
+                                    : static_cast<T>(static_cast<int>(rng() % 2001) - 1000) / T(8) + T(0.5);
+        } else {
+            value = static_cast<T>(rng());
+        }
+    }
+    return values;
+}
+
+template <typename T>
+void expectSortsLikeStdSort(ColumnType type, size_t count) {
+    for (const bool descending : {false, true}) {
+        auto values = randomValues<T>(count, static_cast<uint32_t>(count) + descending);
+        auto expected = values;
+        std::stable_sort(expected.begin(), expected.end(), [&](T a, T b) { return before(a, b, descending); });
+        ASSERT_TRUE(sortValues(type, values.data(), values.size(), descending));
+        for (size_t i = 0; i < count; ++i) {
+            if constexpr (std::is_floating_point_v<T>) {
+                if (std::isnan(expected[i])) {
+                    ASSERT_TRUE(std::isnan(values[i])) << i;
+                    continue;
+                }
+            }
+            ASSERT_EQ(values[i], expected[i]) << i << (descending ? " descending" : " ascending");
+        }
+    }
+}
+
+class SortingTest : public ::testing::TestWithParam<size_t> {
+protected:
+    void SetUp() override {
+        setSharedThreadPool(std::make_shared<ThreadPool>(4));
+    }
+    void TearDown() override {
+        setSharedThreadPool(nullptr);
+    }
+};
+
+TEST_P(SortingTest, SortsEveryColumnType) {
+    const size_t count = GetParam();
+    expectSortsLikeStdSort<double>(ColumnType::FLOAT64, count);
+    expectSortsLikeStdSort<float>(ColumnType::FLOAT32, count);
+    expectSortsLikeStdSort<int32_t>(ColumnType::INT32, count);
+    expectSortsLikeStdSort<uint32_t>(ColumnType::UINT32, count);
+    expectSortsLikeStdSort<int16_t>(ColumnType::INT16, count);
+    expectSortsLikeStdSort<uint16_t>(ColumnType::UINT16, count);
+    expectSortsLikeStdSort<int8_t>(ColumnType::INT8, count);
+    expectSortsLikeStdSort<uint8_t>(ColumnType::UINT8, count);
+}
+
+TEST_P(SortingTest, SingleKeyArgsortIsStable) {
+    const size_t count = GetParam();
+    // int8 values guarantee long runs of ties whose order must be kept.
+    const auto small = randomValues<int8_t>(count, 3);
+    const auto reals = randomValues<float>(count, 4);
+    for (const bool descending : {false, true}) {
+        std::vector<uint32_t> order(count);
+        ASSERT_TRUE(argsort({{column(ColumnType::INT8, small), descending}}, order.data()));
+        EXPECT_EQ(order, referenceOrder(small, descending));
+        ASSERT_TRUE(argsort({{column(ColumnType::FLOAT32, reals), descending}}, order.data()));
+        EXPECT_EQ(order, referenceOrder(reals, descending));
+    }
+}
+
+TEST_P(SortingTest, MultiKeyArgsortBreaksTiesInKeyOrder) {
+    const size_t count = GetParam();
+    std::mt19937 rng(93);
+    std::vector<uint8_t> category(count);
+    std::vector<double> amount(count);
+    std::vector<int32_t> day(count);
+    for (size_t i = 0; i < count; ++i) {
+        category[i] = static_cast<uint8_t>(rng() % 6);
+        amount[i] = rng() % 40 == 0 ? std::nan("") : static_cast<double>(rng() % 100);
+        day[i] = static_cast<int32_t>(rng() % 31) - 15;
+    }
+    std::vector<uint32_t> expected(count);
+    std::iota(expected.begin(), expected.end(), 0u);
+    std::stable_sort(expected.begin(), expected.end(), [&](uint32_t a, uint32_t b) {
+        if (category[a] != category[b]) {
+            return category[a] < category[b];
+        }
+        if (before(amount[a], amount[b], true) || before(amount[b], amount[a], true)) {
+            return before(amount[a], amount[b], true);
+        }
+        return day[a] < day[b];
+    });
+
+    std::vector<uint32_t> order(count);
+    ASSERT_TRUE(argsort({{column(ColumnType::UINT8, category), false},
+                         {column(ColumnType::FLOAT64, amount), true},
+                         {column(ColumnType::INT32, day), false}},
+                        order.data()));
+    EXPECT_EQ(order, expected);
+}
+
+TEST_P(SortingTest, TopKMatchesTheArgsortPrefix) {
+    const size_t count = GetParam();
+    const auto values = randomValues<double>(count, 5);
+    for (const bool descending : {false, true}) {
+        const auto expected = referenceOrder(values, descending);
+        for (const size_t k : {size_t{0}, size_t{1}, size_t{10}, count / 4, count + 5}) {
+            std::vector<uint32_t> order{99};
+            ASSERT_TRUE(topK({column(ColumnType::FLOAT64, values), descending}, k, order));
+            ASSERT_EQ(order.size(), std::min(k, count));
+            EXPECT_TRUE(std::equal(order.begin(), order.end(), expected.begin())) << "k=" << k;
+        }
+    }
+}
+
+// 1000 stays on the calling thread; 200k splits passes, merges and selections across the pool.
+INSTANTIATE_TEST_SUITE_P(Sizes, SortingTest, ::testing::Values(size_t{1000}, kParallelThreshold * 3 + 7));
+
+TEST(SortingErrorsTest, RejectsMalformedKeys) {
+    const std::vector<double> a{1.0, 2.0};
+    const std::vector<double> b{1.0};
+    std::vector<uint32_t> order(2);
+    EXPECT_THROW(argsort({}, order.data()), std::invalid_argument);
+    EXPECT_THROW(argsort({{column(ColumnType::FLOAT64, a)}, {column(ColumnType::FLOAT64, b)}}, order.data()),
+                 std::invalid_argument);
+    const SortKey key{column(ColumnType::FLOAT64, a)};
+    EXPECT_THROW(argsort({key, key, key, key, key}, order.data()), std::invalid_argument);
+}
+
+TEST(SortingErrorsTest, StopsWhenCancelled) {
+    auto values = randomValues<uint32_t>(kParallelThreshold * 2, 6);
+    const auto original = values;
+    std::vector<uint32_t> order(values.size());
+    const auto cancelled = [] { return true; };
+    EXPECT_FALSE(sortValues(ColumnType::UINT32, values.data(), values.size(), false, cancelled));
+    EXPECT_FALSE(argsort({{column(ColumnType::UINT32, original)}}, order.data(), cancelled));
+    std::vector<uint32_t> top;
+    EXPECT_FALSE(topK({column(ColumnType::UINT32, original)}, 10, top, cancelled));
+}
+
+} // namespace
+} // namespace threadforge::sorting
@@ -0,0 +1,184 @@
+#include "Sqlite.h"
+
+#include <sqlite3.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "TempDir.h"
+
+namespace threadforge::sqlite {
+namespace {
+
+static_assert(THREADFORGE_SQLITE, "SqliteTest must be built against SQLite");
+
+int errorCode(const std::function<void()>& fn) {
+    try {
+        fn();
+    } catch (const Error& error) {
+        return error.code();
+    }
+    return SQLITE_OK;
+}
+
+std::shared_ptr<Database> memory() {
+    auto db = Database::open(":memory:", {});
+    db->exec("CREATE TABLE orders (id INTEGER PRIMARY KEY, category TEXT UNIQUE, amount REAL, note BLOB)");
+    return db;
+}
+
+int64_t countRows(Database& db) {
+    auto count = db.prepare("SELECT COUNT(*) FROM orders");
+    EXPECT_TRUE(count->step());
+    return count->columnInt64(0);
+}
+
+TEST(SqliteTest, BindsAndReadsEveryValueType) {
+    auto db = memory();
+    auto insert = db->prepare("INSERT INTO orders (category, amount, note) VALUES (?, ?, ?)");
+    EXPECT_EQ(insert->parameterCount(), 3);
+    EXPECT_FALSE(insert->readOnly());
+
+    const std::string category("home\0garden", 11);
+    const std::vector<uint8_t> note{0x00, 0xFF, 0x10};
+    insert->bindText(1, category.data(), category.size());
+    insert->bindDouble(2, 12.5);
+    insert->bindBlob(3, note.data(), note.size());
+    EXPECT_FALSE(insert->step());
+    EXPECT_EQ(db->changes(), 1);
+    EXPECT_EQ(db->lastInsertRowId(), 1);
+
+    insert->reset();
+    // note has no type affinity, so an integer beyond 2^53 stays exact.
+    insert->bindNull(1);
+    insert->bindNull(2);
+    insert->bindInt64(3, INT64_C(9007199254740993));
+    EXPECT_FALSE(insert->step());
+    EXPECT_EQ(db->totalChanges(), 2);
+
+    auto select = db->prepare("SELECT id, category, amount, note FROM orders ORDER BY id");
+    EXPECT_TRUE(select->readOnly());
+    ASSERT_EQ(select->columnCount(), 4);
+    EXPECT_EQ(select->columnName(2), "amount");
+    ASSERT_TRUE(select->step());
+    EXPECT_EQ(select->columnType(0), ValueType::INTEGER);
+    EXPECT_EQ(select->columnType(1), ValueType::TEXT);
+    EXPECT_EQ(select->columnText(1), category);
+    EXPECT_EQ(select->columnType(2), ValueType::FLOAT);
+    EXPECT_EQ(select->columnDouble(2), 12.5);
+    EXPECT_EQ(select->columnType(3), ValueType::BLOB);
+    const auto [data, size] = select->columnBlob(3);
+    EXPECT_EQ(std::vector<uint8_t>(data, data + size), note);
+
+    ASSERT_TRUE(select->step());
+    EXPECT_EQ(select->columnType(1), ValueType::NUL);
+    EXPECT_EQ(select->columnType(2), ValueType::NUL);
+    EXPECT_EQ(select->columnType(3), ValueType::INTEGER);
+    EXPECT_EQ(select->columnInt64(3), INT64_C(9007199254740993));
+    EXPECT_FALSE(select->step());
+}
+
+TEST(SqliteTest, NamedParametersMatchAnyPrefix) {
+    auto db = memory();
+    auto statement = db->prepare("SELECT :category, @amount, $note, ?4");
+    EXPECT_EQ(statement->parameterIndex("category"), 1);
+    EXPECT_EQ(statement->parameterIndex("amount"), 2);
+    EXPECT_EQ(statement->parameterIndex("note"), 3);
+    EXPECT_EQ(statement->parameterIndex("@amount"), 2);
+    EXPECT_EQ(statement->parameterIndex(":amount"), 0);
+    EXPECT_EQ(statement->parameterIndex("missing"), 0);
+}
+
+TEST(SqliteTest, PrepareTakesExactlyOneStatement) {
+    auto db = memory();
+    EXPECT_NO_THROW(db->prepare("SELECT 1; -- trailing comment\n  "));
+    EXPECT_EQ(errorCode([&] { db->prepare("SELECT 1; SELECT 2"); }), SQLITE_MISUSE);
+    EXPECT_EQ(errorCode([&] { db->prepare("   "); }), SQLITE_MISUSE);
+    try {
+        db->prepare("SELEC 1");
+        FAIL() << "expected a syntax error";
+    } catch (const Error& error) {
+        EXPECT_EQ(error.code(), SQLITE_ERROR);
+        EXPECT_NE(std::string(error.what()).find("syntax error"), std::string::npos);
+    }
+}
+
+TEST(SqliteTest, StepErrorsCarryExtendedCodesAndLeaveTheStatementReusable) {
+    auto db = memory();
+    auto insert = db->prepare("INSERT INTO orders (category) VALUES (?)");
+    insert->bindText(1, "books", 5);
+    EXPECT_FALSE(insert->step());
+    insert->reset();
+    const auto before = insert->generation();
+    EXPECT_EQ(errorCode([&] { insert->step(); }), SQLITE_CONSTRAINT_UNIQUE);
+    EXPECT_GT(insert->generation(), before);
+
+    insert->bindText(1, "toys", 4);
+    EXPECT_FALSE(insert->step());
+    EXPECT_EQ(countRows(*db), 2);
+}
+
+TEST(SqliteTest, NestedTransactionsRollBackOnlyTheInnermostLevel) {
+    auto db = memory();
+    db->begin();
+    db->exec("INSERT INTO orders (category) VALUES ('outer')");
+    db->begin();
+    db->exec("INSERT INTO orders (category) VALUES ('inner')");
+    EXPECT_EQ(countRows(*db), 2);
+    db->rollback();
+    db->begin();
+    db->exec("INSERT INTO orders (category) VALUES ('kept')");
+    db->commit();
+    db->commit();
+    EXPECT_EQ(countRows(*db), 2);
+
+    db->begin();
+    db->exec("INSERT INTO orders (category) VALUES ('discarded')");
+    db->rollback();
+    EXPECT_EQ(countRows(*db), 2);
+
+    EXPECT_EQ(errorCode([&] { db->commit(); }), SQLITE_MISUSE);
+    EXPECT_EQ(errorCode([&] { db->rollback(); }), SQLITE_MISUSE);
+}
+
+TEST(SqliteTest, ClosedDatabasesAndFinalizedStatementsFailCleanly) {
+    auto db = memory();
+    auto select = db->prepare("SELECT * FROM orders");
+    db->close();
+    EXPECT_FALSE(db->isOpen());
+    EXPECT_EQ(errorCode([&] { select->step(); }), SQLITE_MISUSE);
+    EXPECT_EQ(errorCode([&] { db->exec("SELECT 1"); }), SQLITE_MISUSE);
+    select->finalize();
+    EXPECT_EQ(errorCode([&] { select->columnCount(); }), SQLITE_MISUSE);
+    db->close();
+}
+
+TEST(SqliteTest, FileDatabasesHonourOpenOptions) {
+    threadforge::testing::TempDir dir;
+    const auto path = dir.file("orders.db");
+
+    Database::Options existingOnly;
+    existingOnly.create = false;
+    EXPECT_EQ(errorCode([&] { Database::open(path, existingOnly); }), SQLITE_CANTOPEN);
+
+    {
+        auto writer = Database::open(path, {});
+        writer->exec("CREATE TABLE t (v); INSERT INTO t VALUES (1), (2)");
+    }
+
+    Database::Options readOnly;
+    readOnly.readOnly = true;
+    auto reader = Database::open(path, readOnly);
+    auto sum = reader->prepare("SELECT SUM(v) FROM t");
+    ASSERT_TRUE(sum->step());
+    EXPECT_EQ(sum->columnInt64(0), 3);
+    EXPECT_EQ(errorCode([&] { reader->exec("INSERT INTO t VALUES (3)"); }), SQLITE_READONLY);
+}
+
+} // namespace
+} // namespace threadforge::sqlite
@@ -0,0 +1,123 @@
+#include "Statistics.h"
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "SharedPool.h"
+
+namespace threadforge::stats {
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+// Deterministic, well-scaled samples with a non-zero mean; the count is not a
+// multiple of any SIMD width so the scalar tails run too.
+std::vector<double> waveform(size_t count) {
+    std::vector<double> values(count);
+    for (size_t i = 0; i < count; ++i) {
+        values[i] = 3.0 + std::sin(static_cast<double>(i) / 40.0) + std::cos(static_cast<double>(i) / 23.0);
+    }
+    return values;
+}
+
+long double referenceSum(const std::vector<double>& values) {
+    long double total = 0;
+    for (double v : values) {
+        total += v;
+    }
+    return total;
+}
+
+TEST(StatisticsTest, SumMatchesASequentialLoop) {
+    for (size_t count : {0u, 1u, 7u, 1001u}) {
+        const auto values = waveform(count);
+        EXPECT_NEAR(sum(values.data(), values.size()), static_cast<double>(referenceSum(values)), 1e-12 * count)
+            << count;
+    }
+}
+
+TEST(StatisticsTest, MomentsMatchTwoPassVariance) {
+    const auto values = waveform(4099);
+    const double mean = static_cast<double>(referenceSum(values) / values.size());
+    long double squares = 0;
+    for (double v : values) {
+        squares += (v - mean) * (v - mean);
+    }
+    const auto m = moments(values.data(), values.size());
+    EXPECT_EQ(m.count, values.size());
+    EXPECT_NEAR(m.mean, mean, 1e-12);
+    EXPECT_NEAR(m.variance(), static_cast<double>(squares / values.size()), 1e-12);
+    EXPECT_NEAR(m.sampleVariance(), static_cast<double>(squares / (values.size() - 1)), 1e-12);
+}
+
+TEST(StatisticsTest, Float32IsAccumulatedInDouble) {
+    // 2^24 + 1 is not representable in float, but a float sum of 2^25 ones
+    // would stall at 2^24; the double accumulator must not.
+    std::vector<float> ones((1u << 24) + 3, 1.0f);
+    EXPECT_EQ(sum(ones.data(), ones.size()), static_cast<double>(ones.size()));
+    const std::vector<float> a{1.5f, -2.0f, 4.0f};
+    const std::vector<float> b{2.0f, 0.5f, 0.25f};
+    EXPECT_DOUBLE_EQ(dot(a.data(), b.data(), a.size()), 3.0);
+}
+
+TEST(StatisticsTest, NaNPropagatesIntoSumsAndIsSkippedByOrderStatistics) {
+    const std::vector<double> values{4.0, kNaN, -1.0, 9.0, 2.0};
+    EXPECT_TRUE(std::isnan(sum(values.data(), values.size())));
+    EXPECT_TRUE(std::isnan(moments(values.data(), values.size()).mean));
+
+    const auto range = extrema(values.data(), values.size());
+    EXPECT_EQ(range.min, -1.0);
+    EXPECT_EQ(range.max, 9.0);
+    EXPECT_EQ(percentiles(values.data(), values.size(), {50.0}), std::vector<double>{3.0});
+
+    const std::vector<double> onlyNaN{kNaN, kNaN};
+    EXPECT_TRUE(std::isnan(extrema(onlyNaN.data(), onlyNaN.size()).min));
+    EXPECT_TRUE(std::isnan(percentiles(onlyNaN.data(), onlyNaN.size(), {10.0})[0]));
+}
+
+TEST(StatisticsTest, HistogramPutsTheUpperEdgeInTheLastBin) {
+    const std::vector<double> values{0.0, 0.5, 1.0, 1.5, 2.0, -0.1, 2.1, kNaN};
+    EXPECT_EQ(histogram(values.data(), values.size(), 0.0, 2.0, 4), (std::vector<uint64_t>{1, 1, 1, 2}));
+    EXPECT_THROW(histogram(values.data(), values.size(), 0.0, 2.0, 0), std::invalid_argument);
+    EXPECT_THROW(histogram(values.data(), values.size(), 2.0, 2.0, 4), std::invalid_argument);
+}
+
+TEST(StatisticsTest, PercentilesInterpolateLikeNumpy) {
+    const std::vector<float> values{4.0f, 1.0f, 3.0f, 2.0f};
+    // numpy.percentile([1, 2, 3, 4], [0, 25, 50, 90, 100])
+    const auto ranks = percentiles(values.data(), values.size(), {0.0, 25.0, 50.0, 90.0, 100.0});
+    const std::vector<double> expected{1.0, 1.75, 2.5, 3.7, 4.0};
+    ASSERT_EQ(ranks.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_NEAR(ranks[i], expected[i], 1e-12);
+    }
+    EXPECT_THROW(percentiles(values.data(), values.size(), {100.5}), std::invalid_argument);
+}
+
+TEST(StatisticsTest, ParallelResultsDoNotDependOnThePool) {
+    // Above kParallelThreshold the input is chunked; chunks are the same with or
+    // without helpers and partials merge in chunk order, so results are identical.
+    const auto values = waveform(kParallelThreshold * 3 + 17);
+    setSharedThreadPool(nullptr);
+    const double inlineSum = sum(values.data(), values.size());
+    const auto inlineMoments = moments(values.data(), values.size());
+    const auto inlineHistogram = histogram(values.data(), values.size(), 1.0, 5.0, 16);
+
+    setSharedThreadPool(std::make_shared<ThreadPool>(4));
+    EXPECT_EQ(sum(values.data(), values.size()), inlineSum);
+    const auto pooled = moments(values.data(), values.size());
+    EXPECT_EQ(pooled.mean, inlineMoments.mean);
+    EXPECT_EQ(pooled.m2, inlineMoments.m2);
+    EXPECT_EQ(histogram(values.data(), values.size(), 1.0, 5.0, 16), inlineHistogram);
+    setSharedThreadPool(nullptr);
+
+    EXPECT_NEAR(inlineSum, static_cast<double>(referenceSum(values)), 1e-13 * inlineSum);
+}
+
+} // namespace
+} // namespace threadforge::stats
@@ -0,0 +1,293 @@
+#include "TaskJournal.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "TempDir.h"
+#include "ThreadPool.h"
+
+namespace threadforge {
+namespace {
+
+using threadforge::testing::TempDir;
+
+// On-disk layout, see TaskJournal.cpp: magic, version, committed end, records.
+constexpr size_t kEndOffset = 8;
+
+std::vector<std::string> pendingIds(const TaskJournal& journal) {
+    std::vector<std::string> ids;
+    for (const auto& entry : journal.pendingEntries()) {
+        ids.push_back(entry.taskId);
+    }
+    return ids;
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void writeFile(const std::string& path, const std::string& bytes) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+uint64_t committedEnd(const std::string& image) {
+    uint64_t end = 0;
+    std::memcpy(&end, image.data() + kEndOffset, sizeof(end));
+    return end;
+}
+
+TEST(TaskJournalTest, AppendedEntriesArePendingInSubmissionOrder) {
+    TempDir dir;
+    TaskJournal journal(dir.file("queue.journal"));
+    ASSERT_TRUE(journal.open());
+
+    ASSERT_TRUE(journal.append({"b", 192, "() => 2"}));
+    ASSERT_TRUE(journal.append({"a", 64, "() => 1"}));
+    ASSERT_TRUE(journal.append({"c", 0, ""}));
+
+    const auto entries = journal.pendingEntries();
+    ASSERT_EQ(entries.size(), 3u);
+    EXPECT_EQ(entries[0].taskId, "b");
+    EXPECT_EQ(entries[0].priority, 192);
+    EXPECT_EQ(entries[0].payload, "() => 2");
+    EXPECT_EQ(entries[1].taskId, "a");
+    EXPECT_EQ(entries[2].payload, "");
+}
+
+TEST(TaskJournalTest, ReplaysEntriesLeftOpenByACrashedProcess) {
+    TempDir dir;
+    const auto path = dir.file("queue.journal");
+
+    // The child dies without closing or removing anything, as an app killed mid-run would.
+    const pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        auto* journal = new TaskJournal(path);
+        bool ok = journal->open();
+        ok = ok && journal->append({"done", 128, "() => 'done'"});
+        ok = ok && journal->append({"pending-1", 192, "() => 1"});
+        ok = ok && journal->append({"pending-2", 64, "() => 2"});
+        journal->remove("done");
+        _exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    ASSERT_EQ(waitpid(child, &status, 0), child);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+
+    TaskJournal journal(path);
+    ASSERT_TRUE(journal.open());
+    EXPECT_EQ(pendingIds(journal), (std::vector<std::string>{"pending-1", "pending-2"}));
+    EXPECT_EQ(journal.pendingEntries()[0].priority, 192);
+    EXPECT_EQ(journal.pendingEntries()[1].payload, "() => 2");
+}
+
+TEST(TaskJournalTest, RemovedEntriesStayRemovedAcrossReopen) {
+    TempDir dir;
+    const auto path = dir.file("queue.journal");
+    {
+        TaskJournal journal(path);
+        ASSERT_TRUE(journal.open());
+        journal.append({"a", 128, "a"});
+        journal.append({"b", 128, "b"});
+        journal.append({"c", 128, "c"});
+    }
+    {
+        TaskJournal journal(path);
+        ASSERT_TRUE(journal.open());
+        journal.remove("b");
+        journal.remove("unknown");
+        // Re-appending a live id supersedes its earlier descriptor.
+        journal.append({"a", 255, "a2"});
+    }
+
+    TaskJournal journal(path);
+    ASSERT_TRUE(journal.open());
+    const auto entries = journal.pendingEntries();
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].taskId, "c");
+    EXPECT_EQ(entries[1].taskId, "a");
+    EXPECT_EQ(entries[1].priority, 255);
+    EXPECT_EQ(entries[1].payload, "a2");
+}
+
+TEST(TaskJournalTest, CompactionKeepsOnlyLiveRecords) {
+    TempDir dir;
+    const auto path = dir.file("queue.journal");
+    const std::string payload(4096, 'x');
+    TaskJournal journal(path);
+    ASSERT_TRUE(journal.open());
+    for (int i = 0; i < 200; ++i) {
+        journal.append({"task-" + std::to_string(i), i % 256, payload});
+    }
+    const size_t grown = journal.sizeBytes();
+    for (int i = 0; i < 200; ++i) {
+        if (i % 50 != 0) {
+            journal.remove("task-" + std::to_string(i));
+        }
+    }
+
+    journal.compact();
+    EXPECT_LT(journal.sizeBytes(), grown);
+    const auto image = readFile(path);
+    // Four live records of a little over 4 KiB each, plus the header.
+    EXPECT_LT(committedEnd(image), 5u * (payload.size() + 64));
+    EXPECT_EQ(pendingIds(journal), (std::vector<std::string>{"task-0", "task-50", "task-100", "task-150"}));
+
+    // The compacted file is the journal now: appends land in it and survive a reopen.
+    journal.append({"after", 128, "after"});
+    journal.close();
+    TaskJournal reopened(path);
+    ASSERT_TRUE(reopened.open());
+    EXPECT_EQ(pendingIds(reopened),
+              (std::vector<std::string>{"task-0", "task-50", "task-100", "task-150", "after"}));
+    EXPECT_EQ(reopened.pendingEntries()[1].payload, payload);
+}
+
+TEST(TaskJournalTest, RecoversFromATornRecord) {
+    TempDir dir;
+    const auto path = dir.file("queue.journal");
+    {
+        TaskJournal journal(path);
+        ASSERT_TRUE(journal.open());
+        journal.append({"kept", 128, "() => 'kept'"});
+    }
+
+    // A record whose length runs past the committed end, as left by a crash
+    // between writing the header and the body on a filesystem that reordered them.
+    auto image = readFile(path);
+    const uint64_t end = committedEnd(image);
+    const uint32_t claimedLength = 1000;
+    std::memcpy(&image[end], &claimedLength, sizeof(claimedLength));
+    image[end + sizeof(claimedLength)] = 1;
+    std::memcpy(&image[end + 5], "\x04\x00\x00\x00torn", 8);
+    const uint64_t tornEnd = end + 5 + 8;
+    std::memcpy(&image[kEndOffset], &tornEnd, sizeof(tornEnd));
+    writeFile(path, image);
+
+    {
+        TaskJournal journal(path);
+        ASSERT_TRUE(journal.open());
+        EXPECT_EQ(pendingIds(journal), std::vector<std::string>{"kept"});
+        EXPECT_EQ(committedEnd(readFile(path)), end);
+        journal.append({"next", 64, "() => 'next'"});
+    }
+
+    TaskJournal journal(path);
+    ASSERT_TRUE(journal.open());
+    EXPECT_EQ(pendingIds(journal), (std::vector<std::string>{"kept", "next"}));
+}
+
+TEST(TaskJournalTest, StartsEmptyOverAnUnrecognisedFile) {
+    TempDir dir;
+    const auto path = dir.file("queue.journal");
+    writeFile(path, "not a journal at all");
+
+    TaskJournal journal(path);
+    ASSERT_TRUE(journal.open());
+    EXPECT_TRUE(journal.pendingEntries().empty());
+    EXPECT_TRUE(journal.append({"a", 1, "a"}));
+}
+
+TaskFunction returning(std::string valueJson, std::shared_ptr<std::atomic<int>> runs) {
+    return [valueJson = std::move(valueJson), runs](const ProgressCallback&, const std::function<bool()>&) {
+        runs->fetch_add(1);
+        return makeSuccessResult(valueJson);
+    };
+}
+
+void waitUntil(const std::function<bool()>& condition) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!condition() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+TEST(TaskJournalTest, ReplayedTaskIsClaimedByIdWithoutRecomputing) {
+    TempDir dir;
+    const auto path = dir.file("queue.journal");
+    {
+        TaskJournal journal(path);
+        ASSERT_TRUE(journal.open());
+        journal.append({"replayed", 128, "42"});
+        journal.append({"unclaimed", 128, "7"});
+    }
+
+    auto journal = std::make_shared<TaskJournal>(path);
+    ASSERT_TRUE(journal->open());
+    auto runs = std::make_shared<std::atomic<int>>(0);
+    ThreadPool pool(2);
+    pool.attachJournal(journal);
+    EXPECT_EQ(pool.restoreJournal([runs](const JournalEntry& entry) {
+        return returning(entry.payload, runs);
+    }), 2u);
+    waitUntil([&] {
+        return pool.getRecoveredTaskCount() == 2;
+    });
+    ASSERT_EQ(pool.getRecoveredTaskCount(), 2u);
+    // Unclaimed results keep their record, so a crash now would replay them again.
+    EXPECT_EQ(pendingIds(*journal), (std::vector<std::string>{"replayed", "unclaimed"}));
+
+    auto claimed = pool.enqueueTask("replayed", TaskPriority::NORMAL, returning("0", runs), nullptr);
+    const auto result = ThreadPool::waitForTask(claimed);
+    EXPECT_TRUE(result.success);
+    EXPECT_EQ(result.valueJson, "42");
+    EXPECT_EQ(runs->load(), 2);
+    EXPECT_EQ(pool.getRecoveredTaskCount(), 1u);
+    EXPECT_EQ(pendingIds(*journal), std::vector<std::string>{"unclaimed"});
+
+    // Dropping unclaimed results under memory pressure drops their records too.
+    EXPECT_EQ(pool.trimMemory(MemoryTrimLevel::CRITICAL).resultsDropped, 1u);
+    EXPECT_TRUE(journal->pendingEntries().empty());
+}
+
+TEST(TaskJournalTest, UnclaimedReplayedResultsAreCapped) {
+    TempDir dir;
+    const auto path = dir.file("queue.journal");
+    constexpr int kReplayed = 80;
+    {
+        TaskJournal journal(path);
+        ASSERT_TRUE(journal.open());
+        for (int i = 0; i < kReplayed; ++i) {
+            journal.append({"task-" + std::to_string(i), 128, std::to_string(i)});
+        }
+    }
+
+    auto journal = std::make_shared<TaskJournal>(path);
+    ASSERT_TRUE(journal->open());
+    auto runs = std::make_shared<std::atomic<int>>(0);
+    ThreadPool pool(1);
+    pool.attachJournal(journal);
+    pool.restoreJournal([runs](const JournalEntry& entry) {
+        return returning(entry.payload, runs);
+    });
+    waitUntil([&] {
+        return runs->load() == kReplayed && pool.getActiveTaskCount() == 0 && pool.getPendingTaskCount() == 0;
+    });
+    ASSERT_EQ(runs->load(), kReplayed);
+
+    // The oldest results were evicted along with their journal records.
+    waitUntil([&] {
+        return journal->pendingEntries().size() == pool.getRecoveredTaskCount();
+    });
+    EXPECT_EQ(pool.getRecoveredTaskCount(), 64u);
+    const auto remaining = pendingIds(*journal);
+    ASSERT_EQ(remaining.size(), 64u);
+    EXPECT_EQ(remaining.front(), "task-16");
+    EXPECT_EQ(remaining.back(), "task-79");
+}
+
+} // namespace
+} // namespace threadforge
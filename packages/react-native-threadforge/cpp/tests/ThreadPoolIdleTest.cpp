@@ -0,0 +1,183 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace threadforge {
+namespace {
+
+using namespace std::chrono_literals;
+
+TaskFunction instant() {
+    return [](const ProgressCallback&, const std::function<bool()>&) {
+        return makeSuccessResult("null");
+    };
+}
+
+bool eventually(const std::function<bool()>& condition) {
+    const auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+    return true;
+}
+
+// Flags an IDLE task raises as it reaches each step, and one the test raises
+// once it has closed the window under the task.
+struct Steps {
+    std::atomic<bool> started{false};
+    std::atomic<bool> windowClosed{false};
+    std::atomic<bool> resumed{false};
+};
+
+TEST(ThreadPoolIdleTest, IdleTasksWaitForTheWindow) {
+    ThreadPool pool(1);
+    EXPECT_FALSE(pool.isIdleWindowOpen());
+    auto idle = pool.enqueueTask("idle", TaskPriority::IDLE, instant(), nullptr);
+    EXPECT_FALSE(ThreadPool::waitForTask(idle, 50ms));
+    EXPECT_EQ(pool.getPendingTaskCount(), 1u);
+
+    pool.setIdle(true);
+    EXPECT_TRUE(pool.isIdleWindowOpen());
+    EXPECT_TRUE(ThreadPool::waitForTask(idle, 5s));
+}
+
+TEST(ThreadPoolIdleTest, OtherClassesRunPastAGatedIdleTask) {
+    ThreadPool pool(1);
+    auto idle = pool.enqueueTask("idle", TaskPriority::IDLE, instant(), nullptr);
+    auto low = pool.enqueueTask("low", TaskPriority::LOW, instant(), nullptr);
+    EXPECT_TRUE(ThreadPool::waitForTask(low, 5s));
+    EXPECT_FALSE(ThreadPool::waitForTask(idle, 20ms));
+
+    pool.setIdle(true);
+    EXPECT_TRUE(ThreadPool::waitForTask(idle, 5s));
+}
+
+TEST(ThreadPoolIdleTest, ABoundedWindowClosesOnItsOwn) {
+    ThreadPool pool(1);
+    pool.setIdle(true, 20ms);
+    EXPECT_TRUE(pool.isIdleWindowOpen());
+    ASSERT_TRUE(eventually([&] { return !pool.isIdleWindowOpen(); }));
+
+    auto idle = pool.enqueueTask("idle", TaskPriority::IDLE, instant(), nullptr);
+    EXPECT_FALSE(ThreadPool::waitForTask(idle, 50ms));
+    // An unbounded window stays open until it is closed.
+    pool.setIdle(true);
+    EXPECT_TRUE(ThreadPool::waitForTask(idle, 5s));
+    std::this_thread::sleep_for(30ms);
+    EXPECT_TRUE(pool.isIdleWindowOpen());
+    pool.setIdle(false);
+    EXPECT_FALSE(pool.isIdleWindowOpen());
+}
+
+TEST(ThreadPoolIdleTest, ShouldYieldOnlyTellsIdleTasksTheWindowClosed) {
+    Steps steps;
+    ThreadPool pool(2);
+    pool.setIdle(true);
+    auto idle = pool.enqueueTask("idle", TaskPriority::IDLE,
+                                 [&steps](const ProgressCallback&, const std::function<bool()>&) {
+                                     const bool before = ThreadPool::shouldYield();
+                                     steps.started = true;
+                                     while (!steps.windowClosed) {
+                                         std::this_thread::sleep_for(1ms);
+                                     }
+                                     const bool after = ThreadPool::shouldYield();
+                                     return makeSuccessResult(std::string("[") + (before ? "true" : "false") + "," +
+                                                              (after ? "true" : "false") + "]");
+                                 },
+                                 nullptr);
+    ASSERT_TRUE(eventually([&] { return steps.started.load(); }));
+    pool.setIdle(false);
+
+    const auto normal = pool.submitTask("normal", TaskPriority::NORMAL,
+                                        [](const ProgressCallback&, const std::function<bool()>&) {
+                                            return makeSuccessResult(ThreadPool::shouldYield() ? "true" : "false");
+                                        },
+                                        nullptr);
+    EXPECT_EQ(normal.valueJson, "false");
+    steps.windowClosed = true;
+    EXPECT_EQ(ThreadPool::waitForTask(idle).valueJson, "[false,true]");
+    EXPECT_FALSE(ThreadPool::shouldYield());
+}
+
+TEST(ThreadPoolIdleTest, CheckpointsPauseAndLendTheWorkerSlot) {
+    Steps steps;
+    ThreadPool pool(1);
+    pool.setIdle(true);
+    auto idle = pool.enqueueTask("idle", TaskPriority::IDLE,
+                                 [&steps](const ProgressCallback&, const std::function<bool()>&) {
+                                     steps.started = true;
+                                     while (!steps.windowClosed) {
+                                         std::this_thread::sleep_for(1ms);
+                                     }
+                                     ThreadPool::waitForIdleWindow();
+                                     steps.resumed = true;
+                                     return makeSuccessResult("null");
+                                 },
+                                 nullptr);
+    ASSERT_TRUE(eventually([&] { return steps.started.load(); }));
+    pool.setIdle(false);
+    steps.windowClosed = true;
+
+    // The paused task holds the only worker, yet other work still gets a thread.
+    auto normal = pool.enqueueTask("normal", TaskPriority::NORMAL, instant(), nullptr);
+    EXPECT_TRUE(ThreadPool::waitForTask(normal, 5s));
+    EXPECT_FALSE(steps.resumed);
+    EXPECT_EQ(pool.getThreadCount(), 2u);
+
+    pool.setIdle(true);
+    EXPECT_TRUE(ThreadPool::waitForTask(idle, 5s));
+    EXPECT_TRUE(steps.resumed);
+    // With the slot handed back, the extra worker retires.
+    EXPECT_TRUE(eventually([&] { return pool.getThreadCount() == 1; }));
+}
+
+TEST(ThreadPoolIdleTest, CheckpointsOnlyPauseIdleTasks) {
+    ThreadPool pool(1);
+    const auto result = pool.submitTask("normal", TaskPriority::NORMAL,
+                                        [](const ProgressCallback&, const std::function<bool()>&) {
+                                            ThreadPool::waitForIdleWindow();
+                                            return makeSuccessResult("null");
+                                        },
+                                        nullptr);
+    EXPECT_TRUE(result.success);
+}
+
+TEST(ThreadPoolIdleTest, CancellingWakesAPausedTask) {
+    Steps steps;
+    ThreadPool pool(1);
+    pool.setIdle(true);
+    auto idle = pool.enqueueTask("idle", TaskPriority::IDLE,
+                                 [&steps](const ProgressCallback&, const std::function<bool()>&) {
+                                     steps.started = true;
+                                     while (!steps.windowClosed) {
+                                         std::this_thread::sleep_for(1ms);
+                                     }
+                                     ThreadPool::waitForIdleWindow();
+                                     steps.resumed = true;
+                                     return makeSuccessResult("null");
+                                 },
+                                 nullptr);
+    ASSERT_TRUE(eventually([&] { return steps.started.load(); }));
+    pool.setIdle(false);
+    steps.windowClosed = true;
+    std::this_thread::sleep_for(20ms);
+    EXPECT_FALSE(steps.resumed);
+
+    ASSERT_TRUE(pool.cancelTask("idle"));
+    EXPECT_TRUE(eventually([&] { return steps.resumed.load(); }));
+    EXPECT_FALSE(pool.isIdleWindowOpen());
+    EXPECT_TRUE(ThreadPool::waitForTask(idle).cancelled);
+}
+
+} // namespace
+} // namespace threadforge
@@ -0,0 +1,159 @@
+#include "EngineConfig.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "TempDir.h"
+#include "ThreadPool.h"
+
+namespace threadforge {
+namespace {
+
+using namespace std::chrono_literals;
+using threadforge::testing::TempDir;
+
+EngineConfig persistent(const TempDir& dir, bool persistQueue) {
+    EngineConfig config;
+    config.persistQueue = persistQueue;
+    config.storageDirectory = dir.path().string();
+    return config;
+}
+
+std::string journalPath(const TempDir& dir) {
+    return dir.file("threadforge/tasks.journal");
+}
+
+// The ids a fresh open of the journal file would replay.
+std::vector<std::string> replayable(const TempDir& dir) {
+    TaskJournal journal(journalPath(dir));
+    EXPECT_TRUE(journal.open());
+    std::vector<std::string> ids;
+    for (const auto& entry : journal.pendingEntries()) {
+        ids.push_back(entry.taskId);
+    }
+    return ids;
+}
+
+// Counts what it rebuilds; the rebuilt work records its payload in ran.
+struct Factory {
+    std::shared_ptr<std::atomic<int>> built = std::make_shared<std::atomic<int>>(0);
+    std::shared_ptr<std::atomic<int>> ran = std::make_shared<std::atomic<int>>(0);
+
+    JournalTaskFactory make() const {
+        return [built = built, ran = ran](const JournalEntry&) -> TaskFunction {
+            built->fetch_add(1);
+            return [ran](const ProgressCallback&, const std::function<bool()>&) {
+                ran->fetch_add(1);
+                return makeSuccessResult("null");
+            };
+        };
+    }
+};
+
+TaskFunction counting(const std::shared_ptr<std::atomic<int>>& runs) {
+    return [runs](const ProgressCallback&, const std::function<bool()>&) {
+        runs->fetch_add(1);
+        return makeSuccessResult("null");
+    };
+}
+
+TEST(ThreadPoolJournalTest, EnablingAttachesAndReplaysOnce) {
+    TempDir dir;
+    {
+        ThreadPool crashed(1);
+        configureThreadPool(crashed, 1, persistent(dir, true), nullptr);
+        ASSERT_TRUE(crashed.isJournaling());
+        crashed.pause();
+        crashed.enqueueTask("left-over", TaskPriority::NORMAL, counting(std::make_shared<std::atomic<int>>()),
+                            nullptr, nullptr, "payload");
+        ASSERT_EQ(replayable(dir), std::vector<std::string>{"left-over"});
+        // As if the process died here: the record stays behind.
+        crashed.detachJournal();
+        crashed.shutdown(ShutdownOptions{ShutdownMode::CANCEL_QUEUED, 0ms});
+    }
+
+    ThreadPool pool(2);
+    Factory factory;
+    EXPECT_FALSE(pool.isJournaling());
+    configureThreadPool(pool, 2, persistent(dir, true), factory.make());
+    EXPECT_TRUE(pool.isJournaling());
+    EXPECT_EQ(factory.built->load(), 1);
+
+    // Reconfiguring with the journal already attached does not replay it again.
+    configureThreadPool(pool, 3, persistent(dir, true), factory.make());
+    EXPECT_EQ(factory.built->load(), 1);
+    const auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (factory.ran->load() < 1 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    EXPECT_EQ(factory.ran->load(), 1);
+}
+
+TEST(ThreadPoolJournalTest, DisablingKeepsQueuedWorkButClearsTheJournal) {
+    TempDir dir;
+    ThreadPool pool(1);
+    configureThreadPool(pool, 1, persistent(dir, true), nullptr);
+    pool.pause();
+    auto runs = std::make_shared<std::atomic<int>>(0);
+    std::vector<std::shared_ptr<Task>> tasks;
+    for (const char* id : {"a", "b", "c"}) {
+        tasks.push_back(pool.enqueueTask(id, TaskPriority::NORMAL, counting(runs), nullptr, nullptr, "payload"));
+    }
+    ASSERT_EQ(replayable(dir), (std::vector<std::string>{"a", "b", "c"}));
+
+    configureThreadPool(pool, 1, persistent(dir, false), nullptr);
+    EXPECT_FALSE(pool.isJournaling());
+    EXPECT_TRUE(replayable(dir).empty());
+
+    // The queued tasks were not dropped.
+    pool.resume();
+    for (const auto& task : tasks) {
+        EXPECT_TRUE(ThreadPool::waitForTask(task).success);
+    }
+    EXPECT_EQ(runs->load(), 3);
+
+    // Tasks queued while persistence is off are never journaled.
+    pool.pause();
+    auto unjournaled = pool.enqueueTask("d", TaskPriority::NORMAL, counting(runs), nullptr, nullptr, "payload");
+    EXPECT_TRUE(replayable(dir).empty());
+
+    // Re-enabling finds nothing to replay.
+    Factory factory;
+    configureThreadPool(pool, 1, persistent(dir, true), factory.make());
+    EXPECT_TRUE(pool.isJournaling());
+    EXPECT_EQ(factory.built->load(), 0);
+    pool.resume();
+    EXPECT_TRUE(ThreadPool::waitForTask(unjournaled).success);
+}
+
+TEST(ThreadPoolJournalTest, CompletedTasksLeaveTheJournal) {
+    TempDir dir;
+    ThreadPool pool(2);
+    configureThreadPool(pool, 2, persistent(dir, true), nullptr);
+    auto runs = std::make_shared<std::atomic<int>>(0);
+    for (int i = 0; i < 10; ++i) {
+        const auto task = pool.enqueueTask("t" + std::to_string(i), TaskPriority::NORMAL, counting(runs), nullptr,
+                                           nullptr, "payload");
+        EXPECT_TRUE(ThreadPool::waitForTask(task).success);
+    }
+    EXPECT_EQ(runs->load(), 10);
+    EXPECT_TRUE(replayable(dir).empty());
+}
+
+TEST(ThreadPoolJournalTest, NoStorageDirectoryMeansNoJournal) {
+    ThreadPool pool(1);
+    EngineConfig config;
+    config.persistQueue = true;
+    configureThreadPool(pool, 1, config, nullptr);
+    EXPECT_FALSE(pool.isJournaling());
+}
+
+} // namespace
+} // namespace threadforge
@@ -0,0 +1,293 @@
+#include "KernelRegistry.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <time.h>
+
+#include <gtest/gtest.h>
+
+#include "ThreadPool.h"
+
+namespace threadforge {
+namespace {
+
+using namespace std::chrono_literals;
+
+bool eventually(const std::function<bool()>& condition) {
+    const auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+    return true;
+}
+
+std::chrono::nanoseconds threadCpuTime() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+// Registers a kernel for the lifetime of one test; the registry is process-wide.
+class ScopedKernel {
+public:
+    ScopedKernel(std::string name, Kernel kernel) : name_(std::move(name)) {
+        EXPECT_TRUE(registerKernel(name_, std::move(kernel)));
+    }
+    ~ScopedKernel() { unregisterKernel(name_); }
+
+private:
+    std::string name_;
+};
+
+Kernel returning(std::string valueJson) {
+    return [valueJson](const std::string&, const ProgressCallback&, const std::function<bool()>&) {
+        return makeSuccessResult(valueJson);
+    };
+}
+
+std::function<bool()> never() {
+    return [] { return false; };
+}
+
+TEST(ThreadPoolKernelTest, RegistryRejectsDuplicatesAndEmptyEntries) {
+    ScopedKernel echo("test.echo", [](const std::string& args, const ProgressCallback&, const std::function<bool()>&) {
+        return makeSuccessResult(args);
+    });
+    EXPECT_TRUE(hasKernel("test.echo"));
+    // The first registration wins.
+    EXPECT_FALSE(registerKernel("test.echo", returning("\"second\"")));
+    EXPECT_FALSE(registerKernel("", returning("null")));
+    EXPECT_FALSE(registerKernel("test.empty", Kernel()));
+    EXPECT_FALSE(hasKernel("test.empty"));
+
+    const auto result = makeKernelWork("test.echo", R"({"n":1})", 0ms)(nullptr, never());
+    EXPECT_TRUE(result.success);
+    EXPECT_EQ(result.valueJson, R"({"n":1})");
+
+    EXPECT_TRUE(unregisterKernel("test.echo"));
+    EXPECT_FALSE(unregisterKernel("test.echo"));
+    EXPECT_FALSE(hasKernel("test.echo"));
+}
+
+TEST(ThreadPoolKernelTest, NamesAreSorted) {
+    ScopedKernel b("test.names.b", returning("null"));
+    ScopedKernel a("test.names.a", returning("null"));
+    std::vector<std::string> ours;
+    for (const auto& name : registeredKernelNames()) {
+        if (name.rfind("test.names.", 0) == 0) {
+            ours.push_back(name);
+        }
+    }
+    EXPECT_EQ(ours, (std::vector<std::string>{"test.names.a", "test.names.b"}));
+}
+
+TEST(ThreadPoolKernelTest, UnknownKernelsFailWhenTheTaskRuns) {
+    // Building the work does not look the kernel up.
+    auto work = makeKernelWork("test.late", "null", 0ms);
+    const auto missing = work(nullptr, never());
+    EXPECT_FALSE(missing.success);
+    EXPECT_EQ(missing.errorMessage, "Unknown ThreadForge kernel: test.late");
+
+    ScopedKernel late("test.late", returning("42"));
+    EXPECT_EQ(work(nullptr, never()).valueJson, "42");
+}
+
+TEST(ThreadPoolKernelTest, ProgressIsClampedAndEndsAtOne) {
+    ScopedKernel steps("test.progress", [](const std::string&, const ProgressCallback& progress,
+                                           const std::function<bool()>&) {
+        progress(-0.5);
+        progress(0.5);
+        progress(2.0);
+        return makeSuccessResult("null");
+    });
+    std::vector<double> seen;
+    const auto result = makeKernelWork("test.progress", "null", 0ms)([&](double value) { seen.push_back(value); },
+                                                                       never());
+    EXPECT_TRUE(result.success);
+    EXPECT_EQ(seen, (std::vector<double>{0.0, 0.5, 1.0, 1.0}));
+}
+
+TEST(ThreadPoolKernelTest, ProgressIsThrottled) {
+    ScopedKernel chatty("test.chatty", [](const std::string&, const ProgressCallback& progress,
+                                          const std::function<bool()>&) {
+        for (int i = 0; i < 1000; ++i) {
+            progress(i / 1000.0);
+        }
+        return makeSuccessResult("null");
+    });
+    std::vector<double> seen;
+    makeKernelWork("test.chatty", "null", 1h)([&](double value) { seen.push_back(value); }, never());
+    // The first report goes out at once; the rest fall inside the window, except the final 1.0.
+    EXPECT_EQ(seen, (std::vector<double>{0.0, 1.0}));
+}
+
+TEST(ThreadPoolKernelTest, FailuresAreNotReportedAsComplete) {
+    ScopedKernel failing("test.failing", [](const std::string&, const ProgressCallback&,
+                                            const std::function<bool()>&) { return makeErrorResult("bad input"); });
+    ScopedKernel throwing("test.throwing", [](const std::string&, const ProgressCallback&,
+                                              const std::function<bool()>&) -> TaskResult {
+        throw std::runtime_error("boom");
+    });
+    ScopedKernel throwingOther("test.throwing-other", [](const std::string&, const ProgressCallback&,
+                                                         const std::function<bool()>&) -> TaskResult { throw 7; });
+
+    std::vector<double> seen;
+    const auto failed = makeKernelWork("test.failing", "null", 0ms)([&](double value) { seen.push_back(value); },
+                                                                     never());
+    EXPECT_EQ(failed.errorMessage, "bad input");
+    EXPECT_TRUE(seen.empty());
+    EXPECT_EQ(makeKernelWork("test.throwing", "null", 0ms)(nullptr, never()).errorMessage, "boom");
+    EXPECT_EQ(makeKernelWork("test.throwing-other", "null", 0ms)(nullptr, never()).errorMessage,
+              "Unknown error in ThreadForge kernel test.throwing-other");
+}
+
+TEST(ThreadPoolKernelTest, CancelledBeforeStartSkipsTheKernel) {
+    auto calls = std::make_shared<std::atomic<int>>(0);
+    ScopedKernel counted("test.counted", [calls](const std::string&, const ProgressCallback&,
+                                                 const std::function<bool()>&) {
+        calls->fetch_add(1);
+        return makeSuccessResult("null");
+    });
+    const auto result = makeKernelWork("test.counted", "null", 0ms)(nullptr, [] { return true; });
+    EXPECT_TRUE(result.cancelled);
+    EXPECT_EQ(calls->load(), 0);
+}
+
+TEST(ThreadPoolKernelTest, FinishingAfterCancelReturnsTheValueAsPartial) {
+    ScopedKernel oblivious("test.oblivious", returning(R"({"rows":10})"));
+    std::atomic<bool> cancelled{false};
+    auto work = makeKernelWork("test.oblivious", "null", 0ms);
+    // Cancelled while the kernel was wrapping up, just as its final progress went out.
+    const auto result = work([&](double) { cancelled = true; }, [&] { return cancelled.load(); });
+    EXPECT_FALSE(result.success);
+    EXPECT_TRUE(result.cancelled);
+    EXPECT_EQ(result.valueJson, R"({"rows":10})");
+}
+
+TEST(ThreadPoolKernelTest, CancellingReturnsTheLastPartialResult) {
+    auto reached = std::make_shared<std::atomic<bool>>(false);
+    auto stopped = std::make_shared<std::atomic<bool>>(false);
+    ScopedKernel scan("test.scan", [reached, stopped](const std::string&, const ProgressCallback&,
+                                                      const std::function<bool()>& isCancelled) {
+        for (int row = 1; row <= 3; ++row) {
+            ThreadPool::setPartialResult("{\"rows\":" + std::to_string(row) + "}");
+        }
+        reached->store(true);
+        while (!isCancelled()) {
+            std::this_thread::sleep_for(1ms);
+        }
+        stopped->store(true);
+        return makeSuccessResult(R"({"rows":3,"done":false})");
+    });
+
+    ThreadPool pool(1);
+    auto task = pool.enqueueTask("scan", TaskPriority::NORMAL, makeKernelWork("test.scan", "null", 0ms), nullptr);
+    ASSERT_TRUE(eventually([&] { return reached->load(); }));
+    ASSERT_TRUE(pool.cancelTask("scan"));
+
+    const auto result = ThreadPool::waitForTask(task);
+    EXPECT_TRUE(result.cancelled);
+    EXPECT_EQ(result.valueJson, R"({"rows":3})");
+    // The kernel sees the cancellation at its next checkpoint.
+    EXPECT_TRUE(eventually([&] { return stopped->load(); }));
+}
+
+TEST(ThreadPoolKernelTest, CheckpointsPauseIdleKernelsOutsideTheWindow) {
+    auto started = std::make_shared<std::atomic<bool>>(false);
+    auto windowClosed = std::make_shared<std::atomic<bool>>(false);
+    auto resumed = std::make_shared<std::atomic<bool>>(false);
+    ScopedKernel background("test.background", [=](const std::string&, const ProgressCallback& progress,
+                                                   const std::function<bool()>&) {
+        started->store(true);
+        while (!windowClosed->load()) {
+            std::this_thread::sleep_for(1ms);
+        }
+        progress(0.5);
+        resumed->store(true);
+        return makeSuccessResult("null");
+    });
+
+    ThreadPool pool(1);
+    pool.setIdle(true);
+    auto task = pool.enqueueTask("background", TaskPriority::IDLE, makeKernelWork("test.background", "null", 0ms),
+                                 nullptr);
+    ASSERT_TRUE(eventually([&] { return started->load(); }));
+    pool.setIdle(false);
+    windowClosed->store(true);
+    std::this_thread::sleep_for(30ms);
+    EXPECT_FALSE(resumed->load());
+
+    pool.setIdle(true);
+    EXPECT_TRUE(ThreadPool::waitForTask(task, 5s));
+    EXPECT_TRUE(resumed->load());
+}
+
+TEST(ThreadPoolKernelTest, CheckpointsApplyTheCpuQuota) {
+    ScopedKernel hot("test.hot", [](const std::string&, const ProgressCallback&, const std::function<bool()>&
+                                                                                    isCancelled) {
+        for (int i = 0; i < 3; ++i) {
+            const auto until = threadCpuTime() + 5ms;
+            while (threadCpuTime() < until) {
+            }
+            isCancelled();
+        }
+        return makeSuccessResult("null");
+    });
+
+    ThreadPool pool(1);
+    CpuQuota quota;
+    quota.coreShare = 0.05;
+    quota.period = 40ms;
+    pool.setCpuQuota(TaskPriority::NORMAL, quota);
+    const auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(pool.submitTask("hot", TaskPriority::NORMAL, makeKernelWork("test.hot", "null", 0ms), nullptr)
+                    .success);
+    // The kernel slept inside its checkpoints, not just between tasks.
+    EXPECT_GT(pool.getThrottledTime(), 0ms);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, pool.getThrottledTime());
+}
+
+TEST(ThreadPoolKernelTest, CheckpointsConsumeTrimRequests) {
+    auto started = std::make_shared<std::atomic<int>>(0);
+    auto trimmed = std::make_shared<std::atomic<bool>>(false);
+    auto waitForTrim = [=] {
+        started->fetch_add(1);
+        while (!trimmed->load()) {
+            std::this_thread::sleep_for(1ms);
+        }
+    };
+    ScopedKernel tidy("test.tidy", [=](const std::string&, const ProgressCallback& progress,
+                                       const std::function<bool()>&) {
+        waitForTrim();
+        progress(0.5);
+        // The checkpoint already took the request on the kernel's behalf.
+        return makeSuccessResult(ThreadPool::takeTrimRequest() ? "true" : "false");
+    });
+
+    ThreadPool pool(2);
+    auto kernel = pool.enqueueTask("tidy", TaskPriority::NORMAL, makeKernelWork("test.tidy", "null", 0ms), nullptr);
+    auto plain = pool.enqueueTask("plain", TaskPriority::NORMAL,
+                                  [=](const ProgressCallback&, const std::function<bool()>&) {
+                                      waitForTrim();
+                                      return makeSuccessResult(ThreadPool::takeTrimRequest() ? "true" : "false");
+                                  },
+                                  nullptr);
+    ASSERT_TRUE(eventually([&] { return started->load() == 2; }));
+    pool.trimMemory(MemoryTrimLevel::LOW);
+    trimmed->store(true);
+    EXPECT_EQ(ThreadPool::waitForTask(kernel).valueJson, "false");
+    EXPECT_EQ(ThreadPool::waitForTask(plain).valueJson, "true");
+}
+
+} // namespace
+} // namespace threadforge
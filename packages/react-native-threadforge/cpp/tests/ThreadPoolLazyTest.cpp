@@ -0,0 +1,174 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace threadforge {
+namespace {
+
+using namespace std::chrono_literals;
+
+// Blocks every task handed out by hold() until release(); counts how many
+// are blocked at once.
+class Latch {
+public:
+    TaskFunction hold() {
+        return [this](const ProgressCallback&, const std::function<bool()>&) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ++waiting_;
+            cv_.notify_all();
+            cv_.wait(lock, [this] { return released_; });
+            return makeSuccessResult("null");
+        };
+    }
+    bool waitForWaiting(int count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, 5s, [this, count] { return waiting_ >= count; });
+    }
+    int waiting() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return waiting_;
+    }
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            released_ = true;
+        }
+        cv_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int waiting_{0};
+    bool released_{false};
+};
+
+TaskFunction instant() {
+    return [](const ProgressCallback&, const std::function<bool()>&) {
+        return makeSuccessResult("null");
+    };
+}
+
+bool threadCountBecomes(const ThreadPool& pool, size_t expected, std::chrono::milliseconds within = 5s) {
+    const auto deadline = std::chrono::steady_clock::now() + within;
+    while (pool.getThreadCount() != expected) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+    return true;
+}
+
+TEST(ThreadPoolLazyTest, StartsAtTheFloorAndReusesAnIdleWorker) {
+    ThreadPool pool(4, 1, 0ms);
+    EXPECT_EQ(pool.getThreadCount(), 1u);
+
+    // One task at a time never needs a second worker.
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_TRUE(pool.submitTask("t" + std::to_string(i), TaskPriority::NORMAL, instant(), nullptr).success);
+    }
+    EXPECT_EQ(pool.getThreadCount(), 1u);
+    EXPECT_EQ(pool.getIdleThreadCount(), 1u);
+}
+
+TEST(ThreadPoolLazyTest, SpawnsOnDemandUpToTheThreadCount) {
+    ThreadPool pool(3, 0, 0ms);
+    EXPECT_EQ(pool.getThreadCount(), 0u);
+
+    Latch latch;
+    std::vector<std::shared_ptr<Task>> tasks;
+    for (int i = 0; i < 6; ++i) {
+        tasks.push_back(pool.enqueueTask("held-" + std::to_string(i), TaskPriority::NORMAL, latch.hold(), nullptr));
+    }
+    ASSERT_TRUE(latch.waitForWaiting(3));
+    std::this_thread::sleep_for(20ms);
+    EXPECT_EQ(latch.waiting(), 3);
+    EXPECT_EQ(pool.getThreadCount(), 3u);
+    EXPECT_EQ(pool.getPendingTaskCount(), 3u);
+
+    latch.release();
+    for (const auto& task : tasks) {
+        EXPECT_TRUE(ThreadPool::waitForTask(task).success);
+    }
+    // A zero idle timeout keeps spawned workers.
+    std::this_thread::sleep_for(50ms);
+    EXPECT_EQ(pool.getThreadCount(), 3u);
+}
+
+TEST(ThreadPoolLazyTest, IdleWorkersAboveTheFloorAreReaped) {
+    ThreadPool pool(4, 1, 30ms);
+    Latch latch;
+    std::vector<std::shared_ptr<Task>> tasks;
+    for (int i = 0; i < 4; ++i) {
+        tasks.push_back(pool.enqueueTask("held-" + std::to_string(i), TaskPriority::NORMAL, latch.hold(), nullptr));
+    }
+    ASSERT_TRUE(latch.waitForWaiting(4));
+    EXPECT_EQ(pool.getThreadCount(), 4u);
+
+    latch.release();
+    for (const auto& task : tasks) {
+        ThreadPool::waitForTask(task);
+    }
+    ASSERT_TRUE(threadCountBecomes(pool, 1));
+    // The floor itself is never reaped.
+    std::this_thread::sleep_for(100ms);
+    EXPECT_EQ(pool.getThreadCount(), 1u);
+
+    // And the pool grows again on the next burst.
+    Latch again;
+    std::vector<std::shared_ptr<Task>> burst;
+    for (int i = 0; i < 2; ++i) {
+        burst.push_back(pool.enqueueTask("again-" + std::to_string(i), TaskPriority::NORMAL, again.hold(), nullptr));
+    }
+    ASSERT_TRUE(again.waitForWaiting(2));
+    EXPECT_EQ(pool.getThreadCount(), 2u);
+    again.release();
+    for (const auto& task : burst) {
+        ThreadPool::waitForTask(task);
+    }
+}
+
+TEST(ThreadPoolLazyTest, BusyWorkersAreNotReaped) {
+    ThreadPool pool(2, 0, 10ms);
+    Latch latch;
+    auto held = pool.enqueueTask("held", TaskPriority::NORMAL, latch.hold(), nullptr);
+    ASSERT_TRUE(latch.waitForWaiting(1));
+    // Many idle timeouts pass while the task runs.
+    std::this_thread::sleep_for(80ms);
+    EXPECT_EQ(pool.getThreadCount(), 1u);
+    EXPECT_EQ(pool.getActiveTaskCount(), 1u);
+
+    latch.release();
+    EXPECT_TRUE(ThreadPool::waitForTask(held).success);
+    EXPECT_TRUE(threadCountBecomes(pool, 0));
+}
+
+TEST(ThreadPoolLazyTest, PausedQueueDoesNotSpawnWorkers) {
+    ThreadPool pool(4, 0, 0ms);
+    pool.pause();
+    std::vector<std::shared_ptr<Task>> tasks;
+    for (int i = 0; i < 4; ++i) {
+        tasks.push_back(pool.enqueueTask("t" + std::to_string(i), TaskPriority::NORMAL, instant(), nullptr));
+    }
+    EXPECT_EQ(pool.getThreadCount(), 0u);
+
+    pool.resume();
+    for (const auto& task : tasks) {
+        EXPECT_TRUE(ThreadPool::waitForTask(task).success);
+    }
+    EXPECT_GE(pool.getThreadCount(), 1u);
+    EXPECT_LE(pool.getThreadCount(), 4u);
+}
+
+} // namespace
+} // namespace threadforge
@@ -0,0 +1,68 @@
+#include "ThreadPool.h"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace threadforge {
+namespace {
+
+using namespace std::chrono_literals;
+
+static_assert(static_cast<int>(toPriorityLevel(0)) == 0);
+static_assert(static_cast<int>(toPriorityLevel(2)) == 2);
+static_assert(static_cast<int>(toPriorityLevel(-7)) == 0);
+static_assert(static_cast<int>(toPriorityLevel(999)) == 255);
+static_assert(priorityClassIndex(toPriorityLevel(1)) == priorityClassIndex(TaskPriority::IDLE));
+
+TaskFunction recording(std::vector<std::string>& order, std::mutex& mutex, std::string name) {
+    return [&order, &mutex, name](const ProgressCallback&, const std::function<bool()>&) {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(name);
+        return makeSuccessResult("null");
+    };
+}
+
+TEST(ThreadPoolPriorityTest, LowNumericLevelsAreIdleClass) {
+    ThreadPool pool(1);
+    ASSERT_FALSE(pool.isIdleWindowOpen());
+    std::vector<std::string> order;
+    std::mutex mutex;
+
+    // 1 was NORMAL in 1.1.x; it is now an idle-class level like any other below 64.
+    auto one = pool.enqueueTask("one", toPriorityLevel(1), recording(order, mutex, "one"), nullptr);
+    auto low = pool.enqueueTask("low", TaskPriority::LOW, recording(order, mutex, "low"), nullptr);
+    ASSERT_TRUE(ThreadPool::waitForTask(low, 5s));
+    EXPECT_FALSE(ThreadPool::waitForTask(one, 50ms));
+    pool.setIdle(true);
+    ASSERT_TRUE(ThreadPool::waitForTask(one, 5s));
+    EXPECT_EQ(order, (std::vector<std::string>{"low", "one"}));
+}
+
+TEST(ThreadPoolPriorityTest, HigherLevelsRunFirstAndEqualLevelsInSubmissionOrder) {
+    ThreadPool pool(1);
+    pool.pause();
+    std::vector<std::string> order;
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Task>> tasks;
+    const std::vector<std::pair<std::string, int>> submissions = {
+        {"normal-a", 128}, {"low", 64}, {"high", 192}, {"normal-b", 128}, {"high-plus", 200}, {"idle-2", 2},
+    };
+    pool.setIdle(true);
+    for (const auto& [name, level] : submissions) {
+        tasks.push_back(pool.enqueueTask(name, toPriorityLevel(level), recording(order, mutex, name), nullptr));
+    }
+    pool.resume();
+    for (const auto& task : tasks) {
+        ThreadPool::waitForTask(task);
+    }
+
+    EXPECT_EQ(order, (std::vector<std::string>{"high-plus", "high", "normal-a", "normal-b", "low", "idle-2"}));
+}
+
+} // namespace
+} // namespace threadforge
@@ -0,0 +1,147 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <time.h>
+
+#include <gtest/gtest.h>
+
+namespace threadforge {
+namespace {
+
+using namespace std::chrono_literals;
+
+std::chrono::nanoseconds threadCpuTime() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+// Burns CPU on the calling thread; sleeping would not be charged to the quota.
+void spin(std::chrono::milliseconds cpu) {
+    const auto until = threadCpuTime() + cpu;
+    while (threadCpuTime() < until) {
+    }
+}
+
+TaskFunction spinning(std::chrono::milliseconds cpu) {
+    return [cpu](const ProgressCallback&, const std::function<bool()>&) {
+        spin(cpu);
+        return makeSuccessResult("null");
+    };
+}
+
+CpuQuota quota(double coreShare, std::chrono::milliseconds period) {
+    CpuQuota result;
+    result.coreShare = coreShare;
+    result.period = period;
+    return result;
+}
+
+TEST(ThreadPoolQuotaTest, NoQuotaNeverThrottles) {
+    ThreadPool pool(1);
+    pool.setCpuQuota(TaskPriority::NORMAL, quota(0.0, 10ms));
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(pool.submitTask("t" + std::to_string(i), TaskPriority::NORMAL, spinning(10ms), nullptr).success);
+    }
+    EXPECT_EQ(pool.getThrottledTime(), 0ms);
+}
+
+TEST(ThreadPoolQuotaTest, AClassOverQuotaWaitsOffItsDeficit) {
+    ThreadPool pool(1);
+    // Half a core with a 10ms burst: each 20ms task leaves a deficit of at least
+    // 10ms of CPU, which takes 20ms of wall time to pay back.
+    pool.setCpuQuota(TaskPriority::NORMAL, quota(0.5, 20ms));
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(pool.submitTask("t" + std::to_string(i), TaskPriority::NORMAL, spinning(20ms), nullptr).success);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // The last task's window need not have been waited out yet.
+    EXPECT_GE(pool.getThrottledTime(), 40ms);
+    EXPECT_GE(elapsed, 90ms);
+}
+
+TEST(ThreadPoolQuotaTest, OtherClassesRunWhileOneIsThrottled) {
+    ThreadPool pool(1);
+    // A 1% share: 10ms of CPU holds the class back for about a second.
+    pool.setCpuQuota(TaskPriority::NORMAL, quota(0.01, 10ms));
+    ASSERT_TRUE(pool.submitTask("hog", TaskPriority::NORMAL, spinning(10ms), nullptr).success);
+    EXPECT_GE(pool.getThrottledTime(), 500ms);
+
+    auto held = pool.enqueueTask("held", TaskPriority::NORMAL, spinning(0ms), nullptr);
+    auto low = pool.enqueueTask("low", TaskPriority::LOW, spinning(0ms), nullptr);
+    EXPECT_TRUE(ThreadPool::waitForTask(low, 500ms));
+    EXPECT_EQ(pool.getPendingTaskCount(), 1u);
+
+    // Lifting the quota releases the class without waiting out the window.
+    pool.setCpuQuota(TaskPriority::NORMAL, quota(0.0, 10ms));
+    EXPECT_TRUE(ThreadPool::waitForTask(held, 500ms));
+}
+
+TEST(ThreadPoolQuotaTest, CheckpointsHoldBackALongTask) {
+    ThreadPool pool(1);
+    pool.setCpuQuota(TaskPriority::NORMAL, quota(0.05, 40ms));
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = pool.submitTask("long", TaskPriority::NORMAL,
+                                        [](const ProgressCallback&, const std::function<bool()>&) {
+                                            for (int i = 0; i < 3; ++i) {
+                                                spin(5ms);
+                                                ThreadPool::throttleCurrentTask();
+                                            }
+                                            return makeSuccessResult("null");
+                                        },
+                                        nullptr);
+    ASSERT_TRUE(result.success);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // The 2ms burst is smaller than a slice, so however slowly the slices run,
+    // each one overdraws by at least 3ms of CPU: 60ms of sleep at a 5% share,
+    // taken inside the task.
+    const auto throttled = pool.getThrottledTime();
+    EXPECT_GE(throttled, 180ms);
+    EXPECT_GE(elapsed, throttled);
+}
+
+TEST(ThreadPoolQuotaTest, CancellationEndsAThrottledCheckpoint) {
+    ThreadPool pool(1);
+    pool.setCpuQuota(TaskPriority::NORMAL, quota(0.01, 10ms));
+    auto sleeping = std::make_shared<std::atomic<bool>>(false);
+    auto woke = std::make_shared<std::atomic<bool>>(false);
+    auto task = pool.enqueueTask("throttled", TaskPriority::NORMAL,
+                                 [sleeping, woke](const ProgressCallback&, const std::function<bool()>&) {
+                                     spin(10ms);
+                                     sleeping->store(true);
+                                     ThreadPool::throttleCurrentTask();
+                                     woke->store(true);
+                                     return makeSuccessResult("null");
+                                 },
+                                 nullptr);
+    while (!sleeping->load()) {
+        std::this_thread::sleep_for(1ms);
+    }
+    std::this_thread::sleep_for(20ms);
+    EXPECT_FALSE(woke->load());
+
+    ASSERT_TRUE(pool.cancelTask("throttled"));
+    const auto deadline = std::chrono::steady_clock::now() + 300ms;
+    while (!woke->load() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    EXPECT_TRUE(woke->load());
+    EXPECT_TRUE(ThreadPool::waitForTask(task).cancelled);
+}
+
+TEST(ThreadPoolQuotaTest, ThrottlingOutsideATaskIsANoOp) {
+    const auto start = std::chrono::steady_clock::now();
+    ThreadPool::throttleCurrentTask();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 50ms);
+}
+
+} // namespace
+} // namespace threadforge
@@ -0,0 +1,145 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "EngineConfig.h"
+
+namespace threadforge {
+namespace {
+
+using namespace std::chrono_literals;
+
+// Tracks how many tasks run at once and the most that ever did.
+struct Concurrency {
+    std::atomic<int> running{0};
+    std::atomic<int> peak{0};
+    std::atomic<int> finished{0};
+
+    TaskFunction task(std::chrono::milliseconds duration) {
+        return [this, duration](const ProgressCallback&, const std::function<bool()>&) {
+            const int now = running.fetch_add(1) + 1;
+            int seen = peak.load();
+            while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+            }
+            std::this_thread::sleep_for(duration);
+            running.fetch_sub(1);
+            finished.fetch_add(1);
+            return makeSuccessResult("null");
+        };
+    }
+};
+
+bool eventually(const std::function<bool()>& condition) {
+    const auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+    return true;
+}
+
+std::vector<std::shared_ptr<Task>> enqueueMany(ThreadPool& pool, Concurrency& concurrency, int count,
+                                               std::chrono::milliseconds duration) {
+    std::vector<std::shared_ptr<Task>> tasks;
+    for (int i = 0; i < count; ++i) {
+        tasks.push_back(pool.enqueueTask("t" + std::to_string(i), TaskPriority::NORMAL, concurrency.task(duration),
+                                         nullptr));
+    }
+    return tasks;
+}
+
+TEST(ThreadPoolReconfigureTest, GrowingKeepsQueuedTasksAndRunsThemWider) {
+    ThreadPool pool(2);
+    pool.pause();
+    Concurrency concurrency;
+    const auto tasks = enqueueMany(pool, concurrency, 24, 20ms);
+
+    pool.setConcurrency(6);
+    EXPECT_EQ(pool.getPendingTaskCount(), 24u);
+    pool.resume();
+    for (const auto& task : tasks) {
+        EXPECT_TRUE(ThreadPool::waitForTask(task).success);
+    }
+
+    EXPECT_EQ(concurrency.finished.load(), 24);
+    EXPECT_EQ(concurrency.peak.load(), 6);
+}
+
+TEST(ThreadPoolReconfigureTest, ShrinkingRetiresSurplusWorkersWithoutDroppingWork) {
+    ThreadPool pool(4);
+    Concurrency concurrency;
+    // Four running and eight queued when the pool shrinks under them.
+    const auto tasks = enqueueMany(pool, concurrency, 12, 30ms);
+    ASSERT_TRUE(eventually([&] { return concurrency.running.load() == 4; }));
+
+    pool.setConcurrency(1);
+    // Running tasks are not interrupted; their workers retire after them.
+    for (const auto& task : tasks) {
+        EXPECT_TRUE(ThreadPool::waitForTask(task).success);
+    }
+    EXPECT_EQ(concurrency.finished.load(), 12);
+    EXPECT_TRUE(eventually([&] { return pool.getThreadCount() == 1; }));
+
+    Concurrency after;
+    for (const auto& task : enqueueMany(pool, after, 5, 5ms)) {
+        ThreadPool::waitForTask(task);
+    }
+    EXPECT_EQ(after.peak.load(), 1);
+}
+
+TEST(ThreadPoolReconfigureTest, ConfigureUpdatesTheQueueLimitInPlace) {
+    ThreadPool pool(1);
+    EngineConfig config;
+    config.queueLimit = 2;
+    configureThreadPool(pool, 1, config, nullptr);
+    pool.pause();
+    Concurrency concurrency;
+    auto kept = enqueueMany(pool, concurrency, 2, 1ms);
+    const auto rejected =
+        ThreadPool::waitForTask(pool.enqueueTask("over", TaskPriority::NORMAL, concurrency.task(1ms), nullptr));
+    EXPECT_FALSE(rejected.success);
+    EXPECT_EQ(rejected.errorMessage, "ThreadPool queue limit reached");
+
+    // Re-initializing raises the limit and resizes without touching the queue.
+    config.queueLimit = 0;
+    configureThreadPool(pool, 3, config, nullptr);
+    EXPECT_EQ(pool.getQueueLimit(), 0u);
+    EXPECT_EQ(pool.getPendingTaskCount(), 2u);
+    kept.push_back(pool.enqueueTask("accepted", TaskPriority::NORMAL, concurrency.task(1ms), nullptr));
+    pool.resume();
+    for (const auto& task : kept) {
+        EXPECT_TRUE(ThreadPool::waitForTask(task).success);
+    }
+    EXPECT_EQ(concurrency.finished.load(), 3);
+}
+
+TEST(ThreadPoolReconfigureTest, ConfigureAppliesTheIdlePolicy) {
+    ThreadPool pool(2, 2, 0ms);
+    EXPECT_EQ(pool.getThreadCount(), 2u);
+
+    EngineConfig config;
+    config.minThreads = 0;
+    config.idleTimeout = 20ms;
+    configureThreadPool(pool, 2, config, nullptr);
+    // The idle workers pick up the new timeout and retire down to the new floor.
+    EXPECT_TRUE(eventually([&] { return pool.getThreadCount() == 0; }));
+
+    config.minThreads = 3;
+    config.idleTimeout = 0ms;
+    configureThreadPool(pool, 4, config, nullptr);
+    EXPECT_EQ(pool.getThreadCount(), 3u);
+}
+
+} // namespace
+} // namespace threadforge
@@ -0,0 +1,233 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace threadforge {
+namespace {
+
+using namespace std::chrono_literals;
+
+// Holds a task on its worker until opened, ignoring cancellation the way a
+// task stuck in native code would.
+class Gate {
+public:
+    void open() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            open_ = true;
+        }
+        cv_.notify_all();
+    }
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return open_; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool open_{false};
+};
+
+TaskFunction returning(int value) {
+    return [value](const ProgressCallback&, const std::function<bool()>&) {
+        return makeSuccessResult(std::to_string(value));
+    };
+}
+
+bool waitForNoWorkers(const ThreadPool& pool) {
+    const auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (pool.getThreadCount() > 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    return pool.getThreadCount() == 0;
+}
+
+ShutdownOptions options(ShutdownMode mode, std::chrono::milliseconds drainTimeout) {
+    ShutdownOptions result;
+    result.mode = mode;
+    result.drainTimeout = drainTimeout;
+    return result;
+}
+
+TEST(ThreadPoolShutdownTest, DrainRunsEveryQueuedTask) {
+    ThreadPool pool(2);
+    // Paused so every task is still queued when the shutdown starts counting.
+    pool.pause();
+    std::vector<std::shared_ptr<Task>> tasks;
+    for (int i = 0; i < 20; ++i) {
+        tasks.push_back(pool.enqueueTask("t" + std::to_string(i), TaskPriority::NORMAL, returning(i), nullptr));
+    }
+
+    const auto report = pool.shutdown(options(ShutdownMode::DRAIN, -1ms));
+    EXPECT_EQ(report.completed, 20u);
+    EXPECT_EQ(report.cancelled, 0u);
+    EXPECT_FALSE(report.deadlineExceeded);
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        EXPECT_EQ(ThreadPool::waitForTask(tasks[i]).valueJson, std::to_string(i));
+    }
+}
+
+TEST(ThreadPoolShutdownTest, CancelQueuedSettlesWaitingTasksAndFinishesRunningOnes) {
+    ThreadPool pool(1);
+    Gate gate;
+    std::atomic<bool> started{false};
+    auto running = pool.enqueueTask("running", TaskPriority::NORMAL,
+                                    [&](const ProgressCallback&, const std::function<bool()>&) {
+                                        started = true;
+                                        gate.wait();
+                                        return makeSuccessResult("true");
+                                    },
+                                    nullptr);
+    auto queued = pool.enqueueTask("queued", TaskPriority::NORMAL, returning(1), nullptr);
+    while (!started) {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    std::thread opener([&gate] {
+        std::this_thread::sleep_for(20ms);
+        gate.open();
+    });
+    const auto report = pool.shutdown(options(ShutdownMode::CANCEL_QUEUED, 5000ms));
+    opener.join();
+
+    EXPECT_EQ(report.cancelled, 1u);
+    EXPECT_EQ(report.completed, 1u);
+    EXPECT_FALSE(report.deadlineExceeded);
+    EXPECT_TRUE(ThreadPool::waitForTask(queued).cancelled);
+    EXPECT_TRUE(ThreadPool::waitForTask(running).success);
+    EXPECT_FALSE(pool.hasStragglers());
+}
+
+TEST(ThreadPoolShutdownTest, MissedDeadlineLeavesThePoolStopped) {
+    auto pool = std::make_unique<ThreadPool>(1);
+    Gate gate;
+    std::atomic<bool> started{false};
+    std::atomic<bool> returned{false};
+    auto stuck = pool->enqueueTask("stuck", TaskPriority::NORMAL,
+                                   [&](const ProgressCallback&, const std::function<bool()>&) {
+                                       started = true;
+                                       gate.wait();
+                                       returned = true;
+                                       return makeSuccessResult("true");
+                                   },
+                                   nullptr);
+    while (!started) {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    const auto report = pool->shutdown(options(ShutdownMode::CANCEL_QUEUED, 30ms));
+    EXPECT_TRUE(report.deadlineExceeded);
+    EXPECT_EQ(report.interrupted, 1u);
+    EXPECT_TRUE(pool->hasStragglers());
+    // The submitter is released with a definite status even though the worker is stuck.
+    const auto result = ThreadPool::waitForTask(stuck);
+    EXPECT_TRUE(result.cancelled);
+
+    // Never reused: new work is rejected instead of being queued behind the straggler.
+    const auto rejected = ThreadPool::waitForTask(pool->enqueueTask("late", TaskPriority::HIGH, returning(1), nullptr));
+    EXPECT_FALSE(rejected.success);
+    EXPECT_EQ(rejected.errorMessage, "ThreadPool is stopped");
+    pool->setConcurrency(4);
+    EXPECT_EQ(pool->getThreadCount(), 1u);
+
+    // Once the worker exits, dropping the pool joins it instead of detaching it.
+    gate.open();
+    ASSERT_TRUE(waitForNoWorkers(*pool));
+    EXPECT_TRUE(returned);
+    const size_t detachedBefore = ThreadPool::detachedWorkerCount();
+    pool.reset();
+    EXPECT_EQ(ThreadPool::detachedWorkerCount(), detachedBefore);
+}
+
+TEST(ThreadPoolShutdownTest, DestroyingAStragglerPoolDetachesStuckWorkers) {
+    auto pool = std::make_unique<ThreadPool>(2);
+    auto gate = std::make_shared<Gate>();
+    auto started = std::make_shared<std::atomic<int>>(0);
+    auto returned = std::make_shared<std::atomic<int>>(0);
+    for (int i = 0; i < 2; ++i) {
+        pool->enqueueTask("stuck-" + std::to_string(i), TaskPriority::IDLE,
+                          [gate, started, returned](const ProgressCallback&, const std::function<bool()>&) {
+                              started->fetch_add(1);
+                              gate->wait();
+                              // Checkpoints after the pool is gone must not touch it.
+                              ThreadPool::throttleCurrentTask();
+                              ThreadPool::shouldYield();
+                              ThreadPool::waitForIdleWindow();
+                              returned->fetch_add(1);
+                              return makeSuccessResult("null");
+                          },
+                          nullptr);
+    }
+    pool->setIdle(true);
+    while (started->load() < 2) {
+        std::this_thread::sleep_for(1ms);
+    }
+    ASSERT_TRUE(pool->shutdown(options(ShutdownMode::INTERRUPT_RUNNING, 10ms)).deadlineExceeded);
+
+    const size_t detachedBefore = ThreadPool::detachedWorkerCount();
+    const auto destroyStart = std::chrono::steady_clock::now();
+    pool.reset();
+    const auto destroyTime = std::chrono::steady_clock::now() - destroyStart;
+    // The deadline already passed, so the destructor must not wait any longer.
+    EXPECT_LT(destroyTime, 150ms);
+    EXPECT_EQ(ThreadPool::detachedWorkerCount(), detachedBefore + 2);
+
+    // The orphaned workers finish their tasks on their own once unblocked.
+    gate->open();
+    const auto deadline = std::chrono::steady_clock::now() + 10s;
+    while (returned->load() < 2 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    EXPECT_EQ(returned->load(), 2);
+    std::this_thread::sleep_for(20ms);
+}
+
+TEST(ThreadPoolShutdownTest, DrainTimeoutBoundsShutdownPlusDestruction) {
+    auto pool = std::make_unique<ThreadPool>(1);
+    auto gate = std::make_shared<Gate>();
+    auto started = std::make_shared<std::atomic<bool>>(false);
+    pool->enqueueTask("stuck", TaskPriority::NORMAL,
+                      [gate, started](const ProgressCallback&, const std::function<bool()>&) {
+                          started->store(true);
+                          gate->wait();
+                          return makeSuccessResult("null");
+                      },
+                      nullptr);
+    while (!started->load()) {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    // As the native modules do on teardown: a bounded shutdown, then the pool is dropped.
+    const auto begin = std::chrono::steady_clock::now();
+    ASSERT_TRUE(pool->shutdown(options(ShutdownMode::DRAIN, 100ms)).deadlineExceeded);
+    pool.reset();
+    const auto elapsed = std::chrono::steady_clock::now() - begin;
+    EXPECT_GE(elapsed, 100ms);
+    // The old destructor added a 200 ms grace on top of the deadline.
+    EXPECT_LT(elapsed, 250ms);
+    gate->open();
+    std::this_thread::sleep_for(20ms);
+}
+
+TEST(ThreadPoolShutdownTest, CleanShutdownReportSerializes) {
+    ShutdownReport report;
+    report.completed = 3;
+    report.cancelled = 2;
+    report.interrupted = 1;
+    report.deadlineExceeded = true;
+    EXPECT_EQ(serializeShutdownReport(report),
+              R"({"cancelled":2,"completed":3,"interrupted":1,"timedOut":true})");
+}
+
+} // namespace
+} // namespace threadforge
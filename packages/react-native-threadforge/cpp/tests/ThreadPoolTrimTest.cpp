@@ -0,0 +1,227 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "TempDir.h"
+
+namespace threadforge {
+namespace {
+
+using namespace std::chrono_literals;
+using threadforge::testing::TempDir;
+
+TaskFunction instant() {
+    return [](const ProgressCallback&, const std::function<bool()>&) {
+        return makeSuccessResult("null");
+    };
+}
+
+// Grows a lazy pool to its full size, then waits for every worker to be idle.
+void growToFull(ThreadPool& pool, int workers) {
+    auto started = std::make_shared<std::atomic<int>>(0);
+    std::vector<std::shared_ptr<Task>> tasks;
+    for (int i = 0; i < workers; ++i) {
+        tasks.push_back(pool.enqueueTask("warm-" + std::to_string(i), TaskPriority::NORMAL,
+                                         [started, workers](const ProgressCallback&, const std::function<bool()>&) {
+                                             started->fetch_add(1);
+                                             while (started->load() < workers) {
+                                                 std::this_thread::sleep_for(1ms);
+                                             }
+                                             return makeSuccessResult("null");
+                                         },
+                                         nullptr));
+    }
+    for (const auto& task : tasks) {
+        ThreadPool::waitForTask(task);
+    }
+    ASSERT_EQ(pool.getThreadCount(), static_cast<size_t>(workers));
+}
+
+TEST(ThreadPoolTrimTest, ModerateReleasesIdleWorkersDownToTheFloor) {
+    ThreadPool pool(4, 1, 0ms);
+    growToFull(pool, 4);
+
+    const auto report = pool.trimMemory(MemoryTrimLevel::MODERATE);
+    EXPECT_EQ(report.workersReleased, 3u);
+    EXPECT_EQ(pool.getThreadCount(), 1u);
+    EXPECT_GT(report.bytesFreed, 0u);
+    EXPECT_EQ(report.bytesFreed % report.workersReleased, 0u);
+    EXPECT_FALSE(report.lowPriorityPaused);
+    EXPECT_EQ(report.resultsDropped, 0u);
+
+    // Nothing left to release, and LOW work is still accepted.
+    EXPECT_EQ(pool.trimMemory(MemoryTrimLevel::MODERATE).workersReleased, 0u);
+    EXPECT_TRUE(pool.submitTask("low", TaskPriority::LOW, instant(), nullptr).success);
+}
+
+TEST(ThreadPoolTrimTest, LowReleasesEveryIdleWorkerButNotBusyOnes) {
+    ThreadPool pool(3, 2, 0ms);
+    growToFull(pool, 3);
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    auto started = std::make_shared<std::atomic<bool>>(false);
+    auto busy = pool.enqueueTask("busy", TaskPriority::NORMAL,
+                                 [released, started](const ProgressCallback&, const std::function<bool()>&) {
+                                     started->store(true);
+                                     released.wait();
+                                     return makeSuccessResult("null");
+                                 },
+                                 nullptr);
+    while (!started->load()) {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    const auto report = pool.trimMemory(MemoryTrimLevel::LOW);
+    EXPECT_EQ(report.workersReleased, 2u);
+    EXPECT_EQ(pool.getThreadCount(), 1u);
+    release.set_value();
+    EXPECT_TRUE(ThreadPool::waitForTask(busy).success);
+}
+
+TEST(ThreadPoolTrimTest, QueuedWorkKeepsItsWorkers) {
+    ThreadPool pool(2, 0, 0ms);
+    growToFull(pool, 2);
+    pool.pause();
+    auto queued = pool.enqueueTask("queued", TaskPriority::NORMAL, instant(), nullptr);
+
+    // Idle workers with work waiting are not "idle" for a trim.
+    EXPECT_EQ(pool.trimMemory(MemoryTrimLevel::LOW).workersReleased, 0u);
+    EXPECT_EQ(pool.getThreadCount(), 2u);
+    pool.resume();
+    EXPECT_TRUE(ThreadPool::waitForTask(queued).success);
+}
+
+TEST(ThreadPoolTrimTest, LowAsksRunningTasksToCollectOnce) {
+    ThreadPool pool(1);
+    std::promise<void> trimmed;
+    auto trimmedFuture = trimmed.get_future().share();
+    auto started = std::make_shared<std::atomic<bool>>(false);
+    auto task = pool.enqueueTask("gc", TaskPriority::NORMAL,
+                                 [trimmedFuture, started](const ProgressCallback&, const std::function<bool()>&) {
+                                     const bool before = ThreadPool::takeTrimRequest();
+                                     started->store(true);
+                                     trimmedFuture.wait();
+                                     const bool first = ThreadPool::takeTrimRequest();
+                                     const bool second = ThreadPool::takeTrimRequest();
+                                     return makeSuccessResult(std::string("[") + (before ? "1" : "0") + "," +
+                                                              (first ? "1" : "0") + "," + (second ? "1" : "0") + "]");
+                                 },
+                                 nullptr);
+    while (!started->load()) {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    // MODERATE does not reach running tasks; LOW does.
+    pool.trimMemory(MemoryTrimLevel::MODERATE);
+    pool.trimMemory(MemoryTrimLevel::LOW);
+    trimmed.set_value();
+    EXPECT_EQ(ThreadPool::waitForTask(task).valueJson, "[0,1,0]");
+    EXPECT_FALSE(ThreadPool::takeTrimRequest());
+}
+
+TEST(ThreadPoolTrimTest, LowCompactsTheJournalAndReportsTheBytes) {
+    TempDir dir;
+    auto journal = std::make_shared<TaskJournal>(dir.file("tasks.journal"));
+    ASSERT_TRUE(journal->open());
+    ThreadPool pool(1);
+    pool.attachJournal(journal);
+    // Enough dead records to grow the mapping, though not enough to compact on their own.
+    const std::string payload(8 * 1024, 'x');
+    for (int i = 0; i < 24; ++i) {
+        ASSERT_TRUE(pool.submitTask("t" + std::to_string(i), TaskPriority::NORMAL, instant(), nullptr, payload)
+                        .success);
+    }
+    const size_t before = journal->sizeBytes();
+    ASSERT_GT(before, 64u * 1024);
+
+    // Keep the only worker busy so the report counts the journal alone.
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    auto started = std::make_shared<std::atomic<bool>>(false);
+    auto busy = pool.enqueueTask("busy", TaskPriority::NORMAL,
+                                 [released, started](const ProgressCallback&, const std::function<bool()>&) {
+                                     started->store(true);
+                                     released.wait();
+                                     return makeSuccessResult("null");
+                                 },
+                                 nullptr);
+    while (!started->load()) {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    EXPECT_EQ(pool.trimMemory(MemoryTrimLevel::MODERATE).bytesFreed, 0u);
+    EXPECT_EQ(journal->sizeBytes(), before);
+    const auto low = pool.trimMemory(MemoryTrimLevel::LOW);
+    EXPECT_EQ(low.workersReleased, 0u);
+    EXPECT_LT(journal->sizeBytes(), before);
+    EXPECT_EQ(low.bytesFreed, before - journal->sizeBytes());
+    release.set_value();
+    EXPECT_TRUE(ThreadPool::waitForTask(busy).success);
+}
+
+TEST(ThreadPoolTrimTest, CriticalRejectsIdleAndLowClassWorkForACooldown) {
+    ThreadPool pool(1);
+    const auto report = pool.trimMemory(MemoryTrimLevel::CRITICAL);
+    EXPECT_TRUE(report.lowPriorityPaused);
+
+    for (const int level : {0, 32, 64, 127}) {
+        const auto rejected = pool.submitTask("l" + std::to_string(level), toPriorityLevel(level), instant(), nullptr);
+        EXPECT_FALSE(rejected.success) << level;
+        EXPECT_EQ(rejected.errorMessage, "ThreadPool is rejecting LOW priority tasks under memory pressure");
+    }
+    EXPECT_TRUE(pool.submitTask("normal", TaskPriority::NORMAL, instant(), nullptr).success);
+    EXPECT_TRUE(pool.submitTask("high", TaskPriority::HIGH, instant(), nullptr).success);
+}
+
+TEST(ThreadPoolTrimTest, StoppedPoolsReportNothing) {
+    ThreadPool pool(2);
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    auto started = std::make_shared<std::atomic<bool>>(false);
+    // Ignores cancellation, so the shutdown misses its deadline and the pool stays stopped.
+    pool.enqueueTask("stuck", TaskPriority::NORMAL,
+                     [released, started](const ProgressCallback&, const std::function<bool()>&) {
+                         started->store(true);
+                         released.wait();
+                         return makeSuccessResult("null");
+                     },
+                     nullptr);
+    while (!started->load()) {
+        std::this_thread::sleep_for(1ms);
+    }
+    ShutdownOptions options;
+    options.mode = ShutdownMode::CANCEL_QUEUED;
+    options.drainTimeout = 10ms;
+    ASSERT_TRUE(pool.shutdown(options).deadlineExceeded);
+
+    const auto report = pool.trimMemory(MemoryTrimLevel::CRITICAL);
+    EXPECT_EQ(report.workersReleased, 0u);
+    EXPECT_EQ(report.bytesFreed, 0u);
+    EXPECT_FALSE(report.lowPriorityPaused);
+    release.set_value();
+    const auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (pool.getThreadCount() > 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+}
+
+TEST(ThreadPoolTrimTest, ReportSerializes) {
+    MemoryTrimReport report;
+    report.bytesFreed = 4096;
+    report.workersReleased = 2;
+    report.resultsDropped = 1;
+    report.lowPriorityPaused = true;
+    EXPECT_EQ(serializeMemoryTrimReport(report),
+              R"({"bytesFreed":4096,"lowPriorityPaused":true,"resultsDropped":1,"workersReleased":2})");
+}
+
+} // namespace
+} // namespace threadforge
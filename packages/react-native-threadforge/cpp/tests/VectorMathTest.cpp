@@ -0,0 +1,168 @@
+#include "VectorMath.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "SharedPool.h"
+
+namespace threadforge::vmath {
+namespace {
+
+// Distance in representable doubles; both values are finite here.
+uint64_t ulpDistance(double a, double b) {
+    int64_t ia;
+    int64_t ib;
+    std::memcpy(&ia, &a, sizeof(a));
+    std::memcpy(&ib, &b, sizeof(b));
+    ia = ia < 0 ? INT64_MIN - ia : ia;
+    ib = ib < 0 ? INT64_MIN - ib : ib;
+    return ia > ib ? static_cast<uint64_t>(ia - ib) : static_cast<uint64_t>(ib - ia);
+}
+
+std::vector<double> evaluate(const std::string& source, const std::vector<double>& x, Accuracy accuracy) {
+    std::vector<double> out(x.size());
+    Expression(source).evaluate(Operand{x.data()}, Operand{}, x.size(), accuracy, out.data());
+    return out;
+}
+
+std::vector<double> spread(double lo, double hi, size_t count) {
+    std::vector<double> values(count);
+    for (size_t k = 0; k < count; ++k) {
+        values[k] = lo + (hi - lo) * static_cast<double>(k) / static_cast<double>(count - 1);
+    }
+    return values;
+}
+
+struct Function {
+    const char* name;
+    double (*reference)(double);
+    double lo;
+    double hi;
+};
+
+const Function kTranscendentals[] = {
+    {"sin", std::sin, -100.0, 100.0},
+    {"cos", std::cos, -100.0, 100.0},
+    {"tan", std::tan, -1.5, 1.5},
+    {"exp", std::exp, -700.0, 700.0},
+    {"log", std::log, 1e-300, 1e300},
+};
+
+TEST(VectorMathTest, StrictIsBitIdenticalToLibm) {
+    for (const auto& function : kTranscendentals) {
+        const auto x = spread(function.lo, function.hi, 2001);
+        const auto out = evaluate(std::string(function.name) + "(x)", x, Accuracy::STRICT);
+        for (size_t k = 0; k < x.size(); ++k) {
+            ASSERT_EQ(out[k], function.reference(x[k])) << function.name << "(" << x[k] << ")";
+        }
+    }
+}
+
+TEST(VectorMathTest, HighStaysWithinAFewUlpOfLibm) {
+    for (const auto& function : kTranscendentals) {
+        const auto x = spread(function.lo, function.hi, 20'001);
+        const auto out = evaluate(std::string(function.name) + "(x)", x, Accuracy::HIGH);
+        for (size_t k = 0; k < x.size(); ++k) {
+            const double expected = function.reference(x[k]);
+            // Near a root of sin/cos the result is tiny, so bound the error absolutely there.
+            if (std::fabs(expected) > 1e-3) {
+                ASSERT_LE(ulpDistance(out[k], expected), 4u) << function.name << "(" << x[k] << ")";
+            } else {
+                ASSERT_NEAR(out[k], expected, 1e-15) << function.name << "(" << x[k] << ")";
+            }
+        }
+    }
+}
+
+TEST(VectorMathTest, FastStaysWithinItsDocumentedError) {
+    const auto angles = spread(-50.0, 50.0, 10'001);
+    const auto sines = evaluate("sin(x)", angles, Accuracy::FAST);
+    const auto cosines = evaluate("cos(x)", angles, Accuracy::FAST);
+    for (size_t k = 0; k < angles.size(); ++k) {
+        ASSERT_NEAR(sines[k], std::sin(angles[k]), 1e-6);
+        ASSERT_NEAR(cosines[k], std::cos(angles[k]), 1e-6);
+    }
+    const auto exponents = spread(-50.0, 50.0, 10'001);
+    const auto exps = evaluate("exp(x)", exponents, Accuracy::FAST);
+    for (size_t k = 0; k < exponents.size(); ++k) {
+        ASSERT_NEAR(exps[k] / std::exp(exponents[k]), 1.0, 1e-6);
+    }
+}
+
+TEST(VectorMathTest, LargeTrigArgumentsFallBackToLibm) {
+    const std::vector<double> x{1e7, -3.5e8, 1e15};
+    const auto out = evaluate("sin(x) + cos(x)", x, Accuracy::FAST);
+    for (size_t k = 0; k < x.size(); ++k) {
+        EXPECT_EQ(out[k], std::sin(x[k]) + std::cos(x[k]));
+    }
+}
+
+TEST(VectorMathTest, EvaluatesArithmeticOverXYAndTheIndex) {
+    const Expression expression("Math.max(x, y) * 2 - i / 4 + abs(-floor(x)) + sqrt(16) + pi - PI");
+    EXPECT_TRUE(expression.usesX());
+    EXPECT_TRUE(expression.usesY());
+
+    const std::vector<float> x{1.5f, -2.25f, 8.0f, 0.0f};
+    const std::vector<double> y{3.0, -4.0, 1.0, -1.0};
+    std::vector<float> out(x.size());
+    expression.evaluate(Operand{nullptr, x.data()}, Operand{y.data()}, x.size(), Accuracy::HIGH, out.data());
+    for (size_t k = 0; k < x.size(); ++k) {
+        const double expected = std::max<double>(x[k], y[k]) * 2 - k / 4.0 + std::fabs(-std::floor(x[k])) + 4;
+        EXPECT_FLOAT_EQ(out[k], static_cast<float>(expected)) << k;
+    }
+}
+
+TEST(VectorMathTest, SumMatchesTheMaterializedValues) {
+    const Expression expression("sin(i / 40) + cos(i / 23)");
+    EXPECT_FALSE(expression.usesX());
+    const size_t count = 300'001;
+    std::vector<double> values(count);
+    expression.evaluate(Operand{}, Operand{}, count, Accuracy::STRICT, values.data());
+    long double reference = 0;
+    for (size_t k = 0; k < count; ++k) {
+        ASSERT_EQ(values[k], std::sin(k / 40.0) + std::cos(k / 23.0));
+        reference += values[k];
+    }
+    // The index range is chunked across the pool when one is installed.
+    setSharedThreadPool(std::make_shared<ThreadPool>(4));
+    EXPECT_NEAR(expression.sum(Operand{}, Operand{}, count, Accuracy::STRICT), static_cast<double>(reference), 1e-9);
+    setSharedThreadPool(nullptr);
+}
+
+TEST(VectorMathTest, ReportsWhereParsingFailed) {
+    const auto message = [](const std::string& source) {
+        try {
+            Expression expression(source);
+        } catch (const std::invalid_argument& ex) {
+            return std::string(ex.what());
+        }
+        return std::string("parsed");
+    };
+    EXPECT_EQ(message("sin(x) +"), "Unexpected end at position 8 in expression");
+    EXPECT_EQ(message("x $ 2"), "Unexpected '$' at position 2 in expression");
+    EXPECT_EQ(message("sinh(x)"), "Unknown identifier 'sinh' at position 0 in expression");
+    EXPECT_EQ(message("max(x)"), "Expected ',' at position 5 in expression");
+    EXPECT_EQ(message(std::string(1000, '(') + "x" + std::string(1000, ')')).rfind("Expression nested too deeply", 0),
+              0u);
+}
+
+TEST(VectorMathTest, ParsesAccuracyNames) {
+    Accuracy accuracy = Accuracy::HIGH;
+    EXPECT_TRUE(parseAccuracy("fast", accuracy));
+    EXPECT_EQ(accuracy, Accuracy::FAST);
+    EXPECT_TRUE(parseAccuracy("strict", accuracy));
+    EXPECT_EQ(accuracy, Accuracy::STRICT);
+    EXPECT_FALSE(parseAccuracy("exact", accuracy));
+    EXPECT_EQ(accuracy, Accuracy::STRICT);
+}
+
+} // namespace
+} // namespace threadforge::vmath
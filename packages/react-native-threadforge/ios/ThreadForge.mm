@@ -1,6 +1,10 @@
 // Author: Abhishek Kumar <alexrus28996@gmail.com>
 #import "ThreadForge.h"
 
+#import <React/RCTBridge+Private.h>
+#import <UIKit/UIKit.h>
+#import <jsi/jsi.h>
+
 #import <algorithm>
 #import <chrono>
 #import <functional>
@@ -8,7 +12,13 @@
 #import <mutex>
 #import <string>
 
+#import "EngineConfig.h"
+#import "Files.h"
 #import "FunctionExecutor.h"
+#import "KernelRegistry.h"
+#import "PackedTableBindings.h"
+#import "SharedPool.h"
+#import "SqliteBindings.h"
 #import "TaskResult.h"
 #import "ThreadPool.h"
 
@@ -21,14 +31,7 @@ std::function<void(const std::string&, double)> gProgressEmitter;
 std::chrono::milliseconds gProgressThrottle = std::chrono::milliseconds(100);
 
 TaskPriority toTaskPriority(NSInteger priority) {
-  switch (priority) {
-    case 2:
-      return TaskPriority::HIGH;
-    case 0:
-      return TaskPriority::LOW;
-    default:
-      return TaskPriority::NORMAL;
-  }
+  return toPriorityLevel(static_cast<int>(std::clamp<NSInteger>(priority, 0, kPriorityLevelCount - 1)));
 }
 
 dispatch_queue_t threadForgeQueue() {
@@ -40,6 +43,62 @@ dispatch_queue_t threadForgeQueue() {
   return queue;
 }
 
+// Submitters block until their task settles, so they wait on a concurrent queue
+// instead of the serial method queue; cancelTask and shutdown stay responsive.
+dispatch_queue_t threadForgeWaitQueue() {
+  static dispatch_once_t onceToken;
+  static dispatch_queue_t queue;
+  dispatch_once(&onceToken, ^{
+    queue = dispatch_queue_create("com.threadforge.waiters", DISPATCH_QUEUE_CONCURRENT);
+  });
+  return queue;
+}
+
+ShutdownOptions toShutdownOptions(NSInteger drainMs, NSInteger mode) {
+  ShutdownOptions options;
+  options.drainTimeout = std::chrono::milliseconds(drainMs);
+  switch (mode) {
+    case 1:
+      options.mode = ShutdownMode::CANCEL_QUEUED;
+      break;
+    case 2:
+      options.mode = ShutdownMode::INTERRUPT_RUNNING;
+      break;
+    default:
+      options.mode = ShutdownMode::DRAIN;
+      break;
+  }
+  return options;
+}
+
+ShutdownReport shutdownThreadPool(std::shared_ptr<ThreadPool> pool, const ShutdownOptions &options) {
+  ShutdownReport report;
+  if (!pool) {
+    return report;
+  }
+  // A pool whose workers missed the deadline is never reused; dropping it here
+  // detaches them at once rather than waiting them out.
+  return pool->shutdown(options);
+}
+
+MemoryTrimLevel toMemoryTrimLevel(NSInteger level) {
+  switch (level) {
+    case 3:
+      return MemoryTrimLevel::CRITICAL;
+    case 2:
+      return MemoryTrimLevel::LOW;
+    default:
+      return MemoryTrimLevel::MODERATE;
+  }
+}
+
+std::shared_ptr<ThreadPool> detachThreadPool() {
+  std::lock_guard<std::mutex> lock(gMutex);
+  gProgressEmitter = nullptr;
+  setSharedThreadPool(nullptr);
+  return std::move(gThreadPool);
+}
+
 std::string safeString(NSString *value) {
   if (!value) {
     return std::string();
@@ -64,12 +123,98 @@ std::chrono::milliseconds currentProgressThrottle() {
   return gProgressThrottle;
 }
 
+std::string storageDirectory() {
+  NSArray<NSString *> *paths =
+      NSSearchPathForDirectoriesInDomains(NSApplicationSupportDirectory, NSUserDomainMask, YES);
+  NSString *directory = paths.firstObject;
+  if (!directory) {
+    return std::string();
+  }
+  [[NSFileManager defaultManager] createDirectoryAtPath:directory
+                            withIntermediateDirectories:YES
+                                             attributes:nil
+                                                  error:nil];
+  return safeString(directory);
+}
+
+// react-native-sqlite-storage's "default" location, so nativeSqlite opens the
+// same files by name.
+std::string databaseDirectory() {
+  NSArray<NSString *> *paths = NSSearchPathForDirectoriesInDomains(NSLibraryDirectory, NSUserDomainMask, YES);
+  NSString *library = paths.firstObject;
+  if (!library) {
+    return std::string();
+  }
+  NSString *directory = [library stringByAppendingPathComponent:@"LocalDatabase"];
+  [[NSFileManager defaultManager] createDirectoryAtPath:directory
+                            withIntermediateDirectories:YES
+                                             attributes:nil
+                                                  error:nil];
+  return safeString(directory);
+}
+
+std::string searchPathDirectory(NSSearchPathDirectory directory) {
+  NSArray<NSString *> *paths = NSSearchPathForDirectoriesInDomains(directory, NSUserDomainMask, YES);
+  return safeString(paths.firstObject);
+}
+
+// Where nativeFiles may read and write; relative paths land in Documents.
+void setFileRoots() {
+  files::setRoots({
+      {"documents", searchPathDirectory(NSDocumentDirectory)},
+      {"cache", searchPathDirectory(NSCachesDirectory)},
+  });
+}
+
+TaskFunction makeFunctionWork(const std::string &taskIdentifier,
+                              const std::string &functionSource,
+                              std::chrono::milliseconds progressThrottle) {
+  return [taskIdentifier, functionSource, progressThrottle](
+             const ProgressCallback &progressCallback,
+             const std::function<bool()> &isCancelled) {
+    return runSerializedFunction(taskIdentifier,
+                                 functionSource,
+                                 progressCallback,
+                                 progressThrottle,
+                                 isCancelled);
+  };
+}
+
 } // namespace
 
 @implementation ThreadForge
 
 RCT_EXPORT_MODULE()
 
+- (instancetype)init {
+  if (self = [super init]) {
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(didReceiveMemoryWarning)
+                                                 name:UIApplicationDidReceiveMemoryWarningNotification
+                                               object:nil];
+  }
+  return self;
+}
+
+- (void)dealloc {
+  [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+- (void)didReceiveMemoryWarning {
+  std::shared_ptr<ThreadPool> threadPool;
+  {
+    std::lock_guard<std::mutex> lock(gMutex);
+    threadPool = gThreadPool;
+  }
+  if (!threadPool) {
+    return;
+  }
+  // iOS sends a single, late warning, so trim as aggressively as we can.
+  dispatch_async(threadForgeWaitQueue(), ^{
+    threadPool->trimMemory(MemoryTrimLevel::CRITICAL);
+  });
+}
+
 - (NSArray<NSString *> *)supportedEvents {
   return @[ @"threadforge_progress" ];
 }
@@ -102,25 +247,49 @@ RCT_EXPORT_MODULE()
 }
 
 - (void)invalidate {
-  std::lock_guard<std::mutex> lock(gMutex);
-  if (gThreadPool) {
-    gThreadPool->shutdown();
-    gThreadPool.reset();
-  }
-  gProgressEmitter = nullptr;
+  // The bridge is going away, so nobody is left to receive results: interrupt
+  // running work and tear the pool down within a bounded time.
+  ShutdownOptions options;
+  options.mode = ShutdownMode::INTERRUPT_RUNNING;
+  options.drainTimeout = std::chrono::milliseconds(500);
+  shutdownThreadPool(detachThreadPool(), options);
 }
 
 RCT_REMAP_METHOD(initialize,
                  initializeWithThreadCount:(nonnull NSNumber *)threadCount
                  progressThrottleMs:(nonnull NSNumber *)progressThrottleMs
+                 optionsJson:(NSString *)optionsJson
                  resolver:(RCTPromiseResolveBlock)resolve
                  rejecter:(RCTPromiseRejectBlock)reject)
 {
   std::lock_guard<std::mutex> lock(gMutex);
   try {
     const auto sanitizedThrottle = std::max(0, [progressThrottleMs intValue]);
+    const auto config = parseEngineConfig(safeString(optionsJson), storageDirectory());
+    setSqliteDatabaseDirectory(databaseDirectory());
+    setFileRoots();
+    // A thread count of 0 lets the CPU topology pick one.
+    const size_t workerCount = std::max(0, [threadCount intValue]);
     gProgressThrottle = std::chrono::milliseconds(sanitizedThrottle);
-    gThreadPool = std::make_shared<ThreadPool>(std::max(1, [threadCount intValue]));
+    // Re-initializing reconfigures the live pool so queued and running tasks survive.
+    if (!gThreadPool) {
+      gThreadPool = makeThreadPool(workerCount, config);
+      // Other native modules submit through sharedThreadPool() onto the same workers.
+      setSharedThreadPool(gThreadPool);
+    }
+    const auto progressThrottle = gProgressThrottle;
+    configureThreadPool(*gThreadPool, workerCount, config, [progressThrottle](const JournalEntry &entry) -> TaskFunction {
+      std::string source;
+      if (readFunctionJournalPayload(entry.payload, source)) {
+        return makeFunctionWork(entry.taskId, source, progressThrottle);
+      }
+      std::string kernelName;
+      std::string argsJson;
+      if (readKernelJournalPayload(entry.payload, kernelName, argsJson)) {
+        return makeKernelWork(kernelName, argsJson, progressThrottle);
+      }
+      return nullptr;
+    });
     resolve(@(YES));
   } catch (const std::exception &ex) {
     reject(@"E_INIT", [NSString stringWithUTF8String:ex.what()], nil);
@@ -151,22 +320,79 @@ RCT_REMAP_METHOD(runFunction,
     };
 
     const auto progressThrottle = currentProgressThrottle();
-    auto work = [taskIdentifier, functionSource, progressThrottle](
-                   const ProgressCallback &progressCallback,
-                   const std::function<bool()> &isCancelled) {
-      return runSerializedFunction(taskIdentifier,
-                                   functionSource,
-                                   progressCallback,
-                                   progressThrottle,
-                                   isCancelled);
+    const auto taskPriority = toTaskPriority([priority intValue]);
+    const auto journalPayload = threadPool->isJournaling()
+        ? makeFunctionJournalPayload(functionSource)
+        : std::string();
+
+    dispatch_async(threadForgeWaitQueue(), ^{
+      try {
+        const auto result = threadPool->submitTask(taskIdentifier,
+                                                   taskPriority,
+                                                   makeFunctionWork(taskIdentifier, functionSource, progressThrottle),
+                                                   progress,
+                                                   journalPayload);
+        const auto payload = serializeTaskResult(result);
+        resolve([NSString stringWithUTF8String:payload.c_str()]);
+      } catch (const std::exception &ex) {
+        reject(@"E_TASK", [NSString stringWithUTF8String:ex.what()], nil);
+      } catch (...) {
+        reject(@"E_TASK", @"Unknown task error", nil);
+      }
+    });
+  } catch (const std::exception &ex) {
+    reject(@"E_TASK", [NSString stringWithUTF8String:ex.what()], nil);
+  } catch (...) {
+    reject(@"E_TASK", @"Unknown task error", nil);
+  }
+}
+
+RCT_REMAP_METHOD(runKernel,
+                 runKernelWithId:(NSString *)taskId
+                 priority:(nonnull NSNumber *)priority
+                 name:(NSString *)name
+                 argsJson:(NSString *)argsJson
+                 resolver:(RCTPromiseResolveBlock)resolve
+                 rejecter:(RCTPromiseRejectBlock)reject)
+{
+  auto threadPool = acquireThreadPool(reject);
+  if (!threadPool) {
+    return;
+  }
+
+  try {
+    std::string taskIdentifier = safeString(taskId);
+    std::string kernelName = safeString(name);
+    std::string kernelArgs = argsJson ? safeString(argsJson) : std::string("null");
+    auto progress = [taskIdentifier](double value) {
+      const double clamped = std::max(0.0, std::min(1.0, value));
+      std::lock_guard<std::mutex> lock(gMutex);
+      if (gProgressEmitter) {
+        gProgressEmitter(taskIdentifier, clamped);
+      }
     };
 
-    const auto result = threadPool->submitTask(taskIdentifier,
-                                               toTaskPriority([priority intValue]),
-                                               std::move(work),
-                                               progress);
-    const auto payload = serializeTaskResult(result);
-    resolve([NSString stringWithUTF8String:payload.c_str()]);
+    const auto progressThrottle = currentProgressThrottle();
+    const auto taskPriority = toTaskPriority([priority intValue]);
+    const auto journalPayload = threadPool->isJournaling()
+        ? makeKernelJournalPayload(kernelName, kernelArgs)
+        : std::string();
+
+    dispatch_async(threadForgeWaitQueue(), ^{
+      try {
+        const auto result = threadPool->submitTask(taskIdentifier,
+                                                   taskPriority,
+                                                   makeKernelWork(kernelName, kernelArgs, progressThrottle),
+                                                   progress,
+                                                   journalPayload);
+        const auto payload = serializeTaskResult(result);
+        resolve([NSString stringWithUTF8String:payload.c_str()]);
+      } catch (const std::exception &ex) {
+        reject(@"E_TASK", [NSString stringWithUTF8String:ex.what()], nil);
+      } catch (...) {
+        reject(@"E_TASK", @"Unknown task error", nil);
+      }
+    });
   } catch (const std::exception &ex) {
     reject(@"E_TASK", [NSString stringWithUTF8String:ex.what()], nil);
   } catch (...) {
@@ -188,6 +414,19 @@ RCT_REMAP_METHOD(cancelTask,
   resolve(@(cancelled));
 }
 
+// Installs the JSI helpers the JS side uses to decode packed table results.
+// Synchronous methods run on the JS thread, the only thread allowed to touch
+// the runtime. Returns NO when it is not reachable (e.g. remote debugging).
+RCT_EXPORT_BLOCKING_SYNCHRONOUS_METHOD(installBindings)
+{
+  RCTCxxBridge *cxxBridge = (RCTCxxBridge *)self.bridge;
+  if (![cxxBridge respondsToSelector:@selector(runtime)] || cxxBridge.runtime == nullptr) {
+    return @(NO);
+  }
+  installPackedTableDecoder(*static_cast<facebook::jsi::Runtime *>(cxxBridge.runtime));
+  return @(YES);
+}
+
 RCT_REMAP_METHOD(getStats,
                  getStatsWithResolver:(RCTPromiseResolveBlock)resolve
                  rejecter:(RCTPromiseRejectBlock)reject)
@@ -201,21 +440,61 @@ RCT_REMAP_METHOD(getStats,
     @"threadCount" : @(threadPool->getThreadCount()),
     @"pending" : @(threadPool->getPendingTaskCount()),
     @"active" : @(threadPool->getActiveTaskCount()),
+    @"throttledMs" : @(threadPool->getThrottledTime().count()),
   });
 }
 
-RCT_REMAP_METHOD(shutdown,
-                 shutdownWithResolver:(RCTPromiseResolveBlock)resolve
+RCT_REMAP_METHOD(setIdle,
+                 setIdle:(BOOL)idle
+                 windowMs:(nonnull NSNumber *)windowMs
+                 resolver:(RCTPromiseResolveBlock)resolve
                  rejecter:(RCTPromiseRejectBlock)reject)
 {
-  std::lock_guard<std::mutex> lock(gMutex);
-  if (gThreadPool) {
-    gThreadPool->shutdown();
-    gThreadPool.reset();
+  auto threadPool = acquireThreadPool(reject);
+  if (!threadPool) {
+    return;
   }
-  gProgressEmitter = nullptr;
 
+  threadPool->setIdle(idle, std::chrono::milliseconds([windowMs integerValue]));
   resolve(@(YES));
 }
 
+RCT_REMAP_METHOD(trimMemory,
+                 trimMemoryWithLevel:(nonnull NSNumber *)level
+                 resolver:(RCTPromiseResolveBlock)resolve
+                 rejecter:(RCTPromiseRejectBlock)reject)
+{
+  std::shared_ptr<ThreadPool> threadPool;
+  {
+    std::lock_guard<std::mutex> lock(gMutex);
+    threadPool = gThreadPool;
+  }
+  const auto trimLevel = toMemoryTrimLevel([level integerValue]);
+  dispatch_async(threadForgeWaitQueue(), ^{
+    MemoryTrimReport report;
+    if (threadPool) {
+      report = threadPool->trimMemory(trimLevel);
+    }
+    const auto payload = serializeMemoryTrimReport(report);
+    resolve([NSString stringWithUTF8String:payload.c_str()]);
+  });
+}
+
+RCT_REMAP_METHOD(shutdown,
+                 shutdownWithDrainMs:(nonnull NSNumber *)drainMs
+                 mode:(nonnull NSNumber *)mode
+                 resolver:(RCTPromiseResolveBlock)resolve
+                 rejecter:(RCTPromiseRejectBlock)reject)
+{
+  const auto options = toShutdownOptions([drainMs integerValue], [mode integerValue]);
+  // Detached right away so a new initialize() gets a fresh pool, but drained on
+  // the wait queue: with no deadline this can take as long as the queue does.
+  auto threadPool = detachThreadPool();
+  dispatch_async(threadForgeWaitQueue(), ^{
+    const auto report = shutdownThreadPool(threadPool, options);
+    const auto payload = serializeShutdownReport(report);
+    resolve([NSString stringWithUTF8String:payload.c_str()]);
+  });
+}
+
 @end
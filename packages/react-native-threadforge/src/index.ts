@@ -2,41 +2,136 @@
 import { NativeEventEmitter, NativeModules, type EmitterSubscription } from 'react-native';
 
 import { DEFAULT_PROGRESS_THROTTLE_MS, DEFAULT_THREAD_COUNT } from './config';
+import { settleTable, type Settled } from './table';
 const PROGRESS_EVENT = 'threadforge_progress';
 
+/**
+ * Named presets for task priority. Any integer level from 0 to 255 is accepted: higher levels run
+ * first and equal levels run in submission order. Levels fall into four classes used by CPU
+ * quotas, core placement and memory pressure: 0-63 idle, 64-127 low, 128-191 normal, 192-255 high.
+ */
 export enum TaskPriority {
-  LOW = 0,
-  NORMAL = 1,
-  HIGH = 2,
+  /**
+   * Idle-class tasks run only while the app reports idleness through `setIdle(true)`. Once
+   * interaction resumes, running ones pause at their next `reportProgress()` / `shouldCancel()`
+   * call, and can poll `shouldYield()` to save their state and return early instead.
+   */
+  IDLE = 32,
+  LOW = 64,
+  NORMAL = 128,
+  HIGH = 192,
 }
 
+export const MIN_PRIORITY_LEVEL = 0;
+export const MAX_PRIORITY_LEVEL = 255;
+
 export type ThreadForgeStats = {
   threadCount: number;
   pending: number;
   active: number;
+  /** Total time task classes were held back by their `cpuQuotas`. */
+  throttledMs?: number;
+};
+
+/**
+ * Share of one core a task class may use, averaged over `periodMs` (default 100).
+ * `{ coreShare: 0.3 }` lets the class use 30% of one core.
+ */
+export type ThreadForgeCpuQuota = {
+  coreShare: number;
+  periodMs?: number;
 };
 
 export type ThreadForgeProgressListener = (taskId: string, progress: number) => void;
 
+/**
+ * - `drain`: keep running queued tasks until the queue is empty or `drainMs` elapses.
+ * - `cancel-queued`: cancel queued tasks immediately; running tasks may finish until `drainMs`.
+ * - `interrupt`: cancel queued tasks and interrupt running tasks immediately.
+ */
+export type ThreadForgeShutdownMode = 'drain' | 'cancel-queued' | 'interrupt';
+
+export type ThreadForgeShutdownOptions = {
+  /** Upper bound for the whole teardown. Omit to wait until the queue has drained. */
+  drainMs?: number;
+  mode?: ThreadForgeShutdownMode;
+};
+
+export type ThreadForgeShutdownReport = {
+  completed: number;
+  cancelled: number;
+  interrupted: number;
+  timedOut: boolean;
+};
+
+/**
+ * - `moderate`: release idle workers above `minThreads`.
+ * - `low`: release every idle worker, compact the task journal and collect garbage in running tasks.
+ * - `critical`: also drop unclaimed replayed results and reject new LOW priority tasks for 10 s.
+ */
+export type ThreadForgeTrimLevel = 'moderate' | 'low' | 'critical';
+
+export type ThreadForgeTrimReport = {
+  bytesFreed: number;
+  workersReleased: number;
+  resultsDropped: number;
+  lowPriorityPaused: boolean;
+};
+
 type SerializableWorker<T> = (() => T) & { __threadforgeSource?: string };
 
 export type ThreadForgeInitOptions = {
   progressThrottleMs?: number;
+  /**
+   * Journals queued tasks to disk so work that has not finished when the process dies is
+   * replayed on the next initialize(). Call runFunction() again with the same task id to
+   * receive the result of a replayed task instead of recomputing it.
+   */
+  persistQueue?: boolean;
+  /**
+   * Maximum number of queued tasks; submissions beyond it are rejected. 0 (default) means
+   * unbounded.
+   */
+  queueLimit?: number;
+  /**
+   * Workers kept alive while idle (default 1). Additional workers, up to the thread count,
+   * are started only when queued work outnumbers idle workers.
+   */
+  minThreads?: number;
+  /**
+   * How long a worker above `minThreads` may sit idle before it exits (default 30000 ms).
+   * 0 keeps spawned workers alive until shutdown.
+   */
+  idleTimeoutMs?: number;
+  /**
+   * Per-class CPU budgets. Workers hold a throttled class back between tasks, and long tasks
+   * pause inside `reportProgress()` / `shouldCancel()` until the budget refills.
+   */
+  cpuQuotas?: Partial<Record<'idle' | 'low' | 'normal' | 'high', ThreadForgeCpuQuota>>;
 };
 
 type NativeThreadForgeModule = {
-  initialize(threadCount: number, progressThrottleMs: number): Promise<boolean>;
+  initialize(threadCount: number, progressThrottleMs: number, optionsJson: string): Promise<boolean>;
   runFunction(taskId: string, priority: number, source: string): Promise<string>;
+  runKernel(taskId: string, priority: number, name: string, argsJson: string): Promise<string>;
   cancelTask(taskId: string): Promise<boolean>;
   getStats(): Promise<ThreadForgeStats | string>;
-  shutdown(): Promise<boolean>;
+  shutdown(drainMs: number, mode: number): Promise<string | boolean>;
+  trimMemory(level: number): Promise<string>;
+  setIdle(idle: boolean, windowMs: number): Promise<boolean>;
+  installBindings?: () => boolean;
   addListener?: (eventName: string) => void;
   removeListeners?: (count: number) => void;
 };
 
 type NativeRunFunctionSuccess = { status: 'ok'; value: unknown };
 type NativeRunFunctionError = { status: 'error'; message?: string; stack?: string };
-type NativeRunFunctionCancelled = { status: 'cancelled'; message?: string; stack?: string };
+type NativeRunFunctionCancelled = {
+  status: 'cancelled';
+  message?: string;
+  stack?: string;
+  partial?: unknown;
+};
 type NativeRunFunctionResponse =
   | NativeRunFunctionSuccess
   | NativeRunFunctionError
@@ -62,6 +157,32 @@ const ThreadForge = Object.assign(rawThreadForge, {
 
 const BYTECODE_PLACEHOLDER = '[bytecode]';
 
+const SHUTDOWN_MODES: Record<ThreadForgeShutdownMode, number> = {
+  drain: 0,
+  'cancel-queued': 1,
+  interrupt: 2,
+};
+
+const EMPTY_SHUTDOWN_REPORT: ThreadForgeShutdownReport = {
+  completed: 0,
+  cancelled: 0,
+  interrupted: 0,
+  timedOut: false,
+};
+
+const TRIM_LEVELS: Record<ThreadForgeTrimLevel, number> = {
+  moderate: 1,
+  low: 2,
+  critical: 3,
+};
+
+const EMPTY_TRIM_REPORT: ThreadForgeTrimReport = {
+  bytesFreed: 0,
+  workersReleased: 0,
+  resultsDropped: 0,
+  lowPriorityPaused: false,
+};
+
 const parseNativeResponse = (payload: string): NativeRunFunctionResponse => {
   try {
     return JSON.parse(payload) as NativeRunFunctionResponse;
@@ -70,6 +191,11 @@ const parseNativeResponse = (payload: string): NativeRunFunctionResponse => {
   }
 };
 
+const sanitizePriority = (priority: number): number => {
+  const normalizedPriority = Number.isFinite(priority) ? Math.floor(priority) : TaskPriority.NORMAL;
+  return Math.min(Math.max(normalizedPriority, MIN_PRIORITY_LEVEL), MAX_PRIORITY_LEVEL);
+};
+
 const ensureStats = (input: ThreadForgeStats | string): ThreadForgeStats => {
   if (typeof input === 'string') {
     try {
@@ -78,6 +204,7 @@ const ensureStats = (input: ThreadForgeStats | string): ThreadForgeStats => {
         threadCount: parsed.threadCount ?? 0,
         pending: parsed.pending ?? 0,
         active: parsed.active ?? 0,
+        ...(parsed.throttledMs !== undefined ? { throttledMs: parsed.throttledMs } : {}),
       };
     } catch {
       return { threadCount: 0, pending: 0, active: 0 };
@@ -86,13 +213,74 @@ const ensureStats = (input: ThreadForgeStats | string): ThreadForgeStats => {
   return input;
 };
 
+const ensureShutdownReport = (input: string | boolean): ThreadForgeShutdownReport => {
+  if (typeof input !== 'string') {
+    return { ...EMPTY_SHUTDOWN_REPORT };
+  }
+  try {
+    const parsed = JSON.parse(input) as Partial<ThreadForgeShutdownReport>;
+    return {
+      completed: parsed.completed ?? 0,
+      cancelled: parsed.cancelled ?? 0,
+      interrupted: parsed.interrupted ?? 0,
+      timedOut: parsed.timedOut ?? false,
+    };
+  } catch {
+    return { ...EMPTY_SHUTDOWN_REPORT };
+  }
+};
+
+const ensureTrimReport = (input: string): ThreadForgeTrimReport => {
+  try {
+    const parsed = JSON.parse(input) as Partial<ThreadForgeTrimReport>;
+    return {
+      bytesFreed: parsed.bytesFreed ?? 0,
+      workersReleased: parsed.workersReleased ?? 0,
+      resultsDropped: parsed.resultsDropped ?? 0,
+      lowPriorityPaused: parsed.lowPriorityPaused ?? false,
+    };
+  } catch {
+    return { ...EMPTY_TRIM_REPORT };
+  }
+};
+
 export class ThreadForgeCancelledError extends Error {
-  constructor(message = 'ThreadForge task was cancelled') {
+  /**
+   * Latest value the worker published through `setPartialResult()` before it was cancelled.
+   * Check `hasPartialResult` to distinguish a missing value from a published `null`.
+   */
+  readonly partialResult: unknown;
+  readonly hasPartialResult: boolean;
+
+  constructor(message = 'ThreadForge task was cancelled', partial?: { value: unknown }) {
     super(message);
     this.name = 'ThreadForgeCancelledError';
+    this.hasPartialResult = partial !== undefined;
+    this.partialResult = partial?.value;
   }
 }
 
+const settleNativeResponse = <T>(payload: string): T => {
+  const response = parseNativeResponse(payload);
+
+  if (response.status === 'ok') {
+    return settleTable<T>(response.value);
+  }
+
+  if (response.status === 'cancelled') {
+    throw new ThreadForgeCancelledError(
+      response.message,
+      'partial' in response ? { value: settleTable(response.partial) } : undefined,
+    );
+  }
+
+  const error = new Error(response.message ?? 'ThreadForge task failed');
+  if (response.stack) {
+    error.stack = response.stack;
+  }
+  throw error;
+};
+
 export class ThreadForgeEngine {
   private initialized = false;
   private readonly emitter = new NativeEventEmitter(ThreadForge);
@@ -109,18 +297,40 @@ export class ThreadForgeEngine {
     return `${prefix}-${Date.now().toString(36)}-${this.nextId.toString(36)}`;
   }
 
+  /**
+   * @param threadCount Maximum number of workers, or `'auto'` to size the pool from the CPU
+   * topology (one worker per performance core plus one for the efficiency cluster).
+   */
   async initialize(
-    threadCount = DEFAULT_THREAD_COUNT,
+    threadCount: number | 'auto' = DEFAULT_THREAD_COUNT,
     options: ThreadForgeInitOptions = {},
   ): Promise<void> {
-    const normalizedThreadCount = Number.isFinite(threadCount)
-      ? threadCount
-      : DEFAULT_THREAD_COUNT;
-    const sanitizedThreadCount = Math.max(1, Math.floor(normalizedThreadCount));
+    const autoThreadCount = threadCount === 'auto';
+    const normalizedThreadCount =
+      typeof threadCount === 'number' && Number.isFinite(threadCount) ? threadCount : DEFAULT_THREAD_COUNT;
+    // Native code treats 0 as "pick from the CPU topology".
+    const sanitizedThreadCount = autoThreadCount ? 0 : Math.max(1, Math.floor(normalizedThreadCount));
     const rawThrottle = options.progressThrottleMs ?? DEFAULT_PROGRESS_THROTTLE_MS;
     const normalizedThrottle = Number.isFinite(rawThrottle) ? rawThrottle : DEFAULT_PROGRESS_THROTTLE_MS;
     const sanitizedThrottle = Math.max(0, Math.floor(normalizedThrottle));
-    await ThreadForge.initialize(sanitizedThreadCount, sanitizedThrottle);
+    const nativeOptions: Record<string, unknown> = {
+      persistQueue: options.persistQueue === true,
+    };
+    if (options.queueLimit !== undefined && Number.isFinite(options.queueLimit)) {
+      nativeOptions.queueLimit = Math.max(0, Math.floor(options.queueLimit));
+    }
+    if (options.minThreads !== undefined && Number.isFinite(options.minThreads)) {
+      const minThreads = Math.max(0, Math.floor(options.minThreads));
+      nativeOptions.minThreads = autoThreadCount ? minThreads : Math.min(sanitizedThreadCount, minThreads);
+    }
+    if (options.idleTimeoutMs !== undefined && Number.isFinite(options.idleTimeoutMs)) {
+      nativeOptions.idleTimeoutMs = Math.max(0, Math.floor(options.idleTimeoutMs));
+    }
+    if (options.cpuQuotas) {
+      nativeOptions.cpuQuotas = options.cpuQuotas;
+    }
+    // Calling initialize() again reconfigures the running engine in place.
+    await ThreadForge.initialize(sanitizedThreadCount, sanitizedThrottle, JSON.stringify(nativeOptions));
     this.initialized = true;
   }
 
@@ -155,8 +365,8 @@ export class ThreadForgeEngine {
   async runFunction<T>(
     id: string,
     fn: SerializableWorker<T>,
-    priority: TaskPriority = TaskPriority.NORMAL,
-  ): Promise<T> {
+    priority: TaskPriority | number = TaskPriority.NORMAL,
+  ): Promise<Settled<T>> {
     this.ensureInitialized();
 
     if (typeof id !== 'string' || id.trim().length === 0) {
@@ -183,25 +393,36 @@ export class ThreadForgeEngine {
       );
     }
 
-    const normalizedPriority = Number.isInteger(priority) ? priority : TaskPriority.NORMAL;
-    const sanitizedPriority = Math.min(Math.max(normalizedPriority, TaskPriority.LOW), TaskPriority.HIGH);
+    const payload = await ThreadForge.runFunction(id, sanitizePriority(priority), serialized);
+    return settleNativeResponse<Settled<T>>(payload);
+  }
 
-    const payload = await ThreadForge.runFunction(id, sanitizedPriority, serialized);
-    const response = parseNativeResponse(payload);
+  /**
+   * Runs a native C++ kernel registered with `THREADFORGE_REGISTER_KERNEL` on the worker pool.
+   * No Hermes runtime is created, but the task is scheduled, cancelled, journaled and reports
+   * progress exactly like runFunction().
+   *
+   * @param args JSON-serializable arguments handed to the kernel as JSON text.
+   */
+  async runKernel<T>(
+    id: string,
+    name: string,
+    args: unknown = null,
+    priority: TaskPriority | number = TaskPriority.NORMAL,
+  ): Promise<T> {
+    this.ensureInitialized();
 
-    if (response.status === 'ok') {
-      return response.value as T;
+    if (typeof id !== 'string' || id.trim().length === 0) {
+      throw new Error('ThreadForge requires a non-empty task id');
     }
 
-    if (response.status === 'cancelled') {
-      throw new ThreadForgeCancelledError(response.message);
+    if (typeof name !== 'string' || name.trim().length === 0) {
+      throw new Error('ThreadForge runKernel expects a kernel name');
     }
 
-    const error = new Error(response.message ?? 'ThreadForge task failed');
-    if (response.stack) {
-      error.stack = response.stack;
-    }
-    throw error;
+    const argsJson = JSON.stringify(args ?? null);
+    const payload = await ThreadForge.runKernel(id, sanitizePriority(priority), name, argsJson);
+    return settleNativeResponse<T>(payload);
   }
 
   /**
@@ -213,19 +434,20 @@ export class ThreadForgeEngine {
    * @param fn Self-contained, serializable function executed on a background thread.
    *           It must not capture outer scope and must return JSON-serializable data.
    *           For Hermes release (bytecode-only), set fn.__threadforgeSource to a string with the original source.
-   * @param priority Optional task priority (LOW | NORMAL | HIGH). Defaults to NORMAL.
+   * @param priority Optional task priority: a TaskPriority preset or a level from 0 to 255.
+   *   Defaults to NORMAL.
    * @param opts Optional id settings:
    *   - id: explicit task id (enables easy cancellation later)
    *   - idPrefix: when no id is provided, controls the auto-generated prefix
    * @returns An object { id, result } where:
    *   - id: the task id used internally (use this to cancel)
-   *   - result: the function's return value
+   *   - result: the function's return value (a ThreadForgeTable for `nativeColumns.table()`)
    */
   async run<T>(
     fn: SerializableWorker<T>,
-    priority: TaskPriority = TaskPriority.NORMAL,
+    priority: TaskPriority | number = TaskPriority.NORMAL,
     opts?: { id?: string; idPrefix?: string },
-  ): Promise<{ id: string; result: T }> {
+  ): Promise<{ id: string; result: Settled<T> }> {
     this.ensureInitialized();
     if (typeof fn !== 'function') {
       throw new Error('ThreadForge run expects a callable function');
@@ -249,12 +471,50 @@ export class ThreadForgeEngine {
     return ensureStats(stats);
   }
 
-  async shutdown(): Promise<void> {
+  /**
+   * Stops the worker pool. Every outstanding task settles with a definite status: it either
+   * completes, or rejects with ThreadForgeCancelledError once it is cancelled or interrupted.
+   *
+   * @param options.drainMs Upper bound for the teardown; omit to wait for the queue to drain.
+   * @param options.mode What to do with queued and running work (defaults to `drain`).
+   */
+  async shutdown(options: ThreadForgeShutdownOptions = {}): Promise<ThreadForgeShutdownReport> {
     if (!this.initialized) {
-      return;
+      return { ...EMPTY_SHUTDOWN_REPORT };
     }
-    await ThreadForge.shutdown();
+    const rawDrain = options.drainMs;
+    const drainMs =
+      typeof rawDrain === 'number' && Number.isFinite(rawDrain) ? Math.max(0, Math.floor(rawDrain)) : -1;
+    const mode = SHUTDOWN_MODES[options.mode ?? 'drain'] ?? SHUTDOWN_MODES.drain;
+    const report = await ThreadForge.shutdown(drainMs, mode);
     this.initialized = false;
+    return ensureShutdownReport(report);
+  }
+
+  /**
+   * Opens or closes the window in which `TaskPriority.IDLE` tasks may run.
+   *
+   * @param options.budgetMs Closes the window automatically after this many milliseconds, e.g.
+   * the spare time left in the current frame. Omit to stay idle until `setIdle(false)`.
+   */
+  async setIdle(idle: boolean, options: { budgetMs?: number } = {}): Promise<void> {
+    this.ensureInitialized();
+    const rawBudget = options.budgetMs;
+    const windowMs =
+      idle && typeof rawBudget === 'number' && Number.isFinite(rawBudget) ? Math.max(0, Math.floor(rawBudget)) : -1;
+    await ThreadForge.setIdle(idle, windowMs);
+  }
+
+  /**
+   * Gives memory back under pressure. Android and iOS call this automatically on
+   * `onTrimMemory` / memory warnings; apps can also call it, e.g. before a heavy screen.
+   */
+  async trimMemory(level: ThreadForgeTrimLevel = 'moderate'): Promise<ThreadForgeTrimReport> {
+    if (!this.initialized) {
+      return { ...EMPTY_TRIM_REPORT };
+    }
+    const nativeLevel = TRIM_LEVELS[level] ?? TRIM_LEVELS.moderate;
+    return ensureTrimReport(await ThreadForge.trimMemory(nativeLevel));
   }
 
   isInitialized(): boolean {
@@ -263,5 +523,12 @@ export class ThreadForgeEngine {
 }
 
 export { DEFAULT_PROGRESS_THROTTLE_MS, DEFAULT_THREAD_COUNT, threadForgeConfig } from './config';
+export {
+  ThreadForgeTable,
+  type PackedTable,
+  type PackedTableColumn,
+  type Settled,
+  type ThreadForgeTypedArray,
+} from './table';
 export const threadForge = new ThreadForgeEngine();
 export default threadForge;
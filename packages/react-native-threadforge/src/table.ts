@@ -0,0 +1,282 @@
+import { NativeModules } from 'react-native';
+
+export type ThreadForgeTypedArray =
+  | Float64Array
+  | Float32Array
+  | Int32Array
+  | Uint32Array
+  | Int16Array
+  | Uint16Array
+  | Int8Array
+  | Uint8Array
+  | Uint8ClampedArray;
+
+export type PackedTableColumn = {
+  name: string;
+  /** Typed array constructor name, e.g. `Float64Array`. */
+  type: string;
+  /** The column's bytes in base64 (little-endian). */
+  data: string;
+  /** Present on dictionary-encoded columns; `data` then holds codes into it. */
+  dictionary?: string[];
+};
+
+/**
+ * Wire form of a table, as returned by `nativeColumns.table()` inside a worker. It settles on the
+ * app side as a ThreadForgeTable.
+ */
+export type PackedTable<Row extends object = Record<string, unknown>> = {
+  __threadforgeTable: 1;
+  length: number;
+  columns: PackedTableColumn[];
+  /** Type-only link to the row shape; never present at runtime. */
+  __row?: Row;
+};
+
+/** What a worker result of type T turns into once it reaches the app runtime. */
+export type Settled<T> = T extends PackedTable<infer Row extends object> ? ThreadForgeTable<Row> : T;
+
+type TypedArrayConstructor = {
+  new (buffer: ArrayBufferLike, byteOffset: number, length: number): ThreadForgeTypedArray;
+  readonly BYTES_PER_ELEMENT: number;
+};
+
+const TYPED_ARRAYS: Record<string, TypedArrayConstructor> = {
+  Float64Array,
+  Float32Array,
+  Int32Array,
+  Uint32Array,
+  Int16Array,
+  Uint16Array,
+  Int8Array,
+  Uint8Array,
+  Uint8ClampedArray,
+};
+
+type ColumnDecoder = (data: string, type: string) => ThreadForgeTypedArray;
+
+type TableGlobals = {
+  __threadforgeDecodeColumn?: ColumnDecoder;
+  atob?: (data: string) => string;
+};
+
+let decoderInstallAttempted = false;
+
+// The JSI decoder is installed on first use; remote debugging and tests have
+// no JSI runtime and decode in JS instead.
+const nativeColumnDecoder = (): ColumnDecoder | undefined => {
+  const globals = globalThis as TableGlobals;
+  if (!globals.__threadforgeDecodeColumn && !decoderInstallAttempted) {
+    decoderInstallAttempted = true;
+    try {
+      (NativeModules.ThreadForge as { installBindings?: () => boolean } | undefined)?.installBindings?.();
+    } catch {
+      // Fall back to the JS decoder.
+    }
+  }
+  return globals.__threadforgeDecodeColumn;
+};
+
+const BASE64_ALPHABET = 'ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/';
+const BASE64_LOOKUP = new Uint8Array(128).fill(255);
+for (let index = 0; index < BASE64_ALPHABET.length; index++) {
+  BASE64_LOOKUP[BASE64_ALPHABET.charCodeAt(index)] = index;
+}
+
+const malformed = (type: string) => new Error(`Malformed ThreadForge table column of type ${type}`);
+
+const decodeBase64 = (data: string, type: string): Uint8Array => {
+  const padding = data.endsWith('==') ? 2 : data.endsWith('=') ? 1 : 0;
+  if (data.length % 4 !== 0) {
+    throw malformed(type);
+  }
+  const bytes = new Uint8Array((data.length / 4) * 3 - padding);
+  const atob = (globalThis as TableGlobals).atob;
+  if (atob) {
+    const binary = atob(data);
+    for (let index = 0; index < bytes.length; index++) {
+      bytes[index] = binary.charCodeAt(index);
+    }
+    return bytes;
+  }
+  let out = 0;
+  for (let index = 0; index < data.length; index += 4) {
+    const a = BASE64_LOOKUP[data.charCodeAt(index)] ?? 255;
+    const b = BASE64_LOOKUP[data.charCodeAt(index + 1)] ?? 255;
+    const c = BASE64_LOOKUP[data.charCodeAt(index + 2)] ?? 255;
+    const d = BASE64_LOOKUP[data.charCodeAt(index + 3)] ?? 255;
+    const last = index + 4 === data.length;
+    if ((a | b) === 255 || (!(last && padding > 1) && c === 255) || (!(last && padding > 0) && d === 255)) {
+      throw malformed(type);
+    }
+    const word = (a << 18) | (b << 12) | ((c & 63) << 6) | (d & 63);
+    bytes[out++] = word >> 16;
+    if (out < bytes.length) {
+      bytes[out++] = (word >> 8) & 255;
+    }
+    if (out < bytes.length) {
+      bytes[out++] = word & 255;
+    }
+  }
+  return bytes;
+};
+
+const decodeColumn = (column: PackedTableColumn): ThreadForgeTypedArray => {
+  const Constructor = TYPED_ARRAYS[column.type];
+  if (!Constructor || typeof column.data !== 'string') {
+    throw malformed(String(column.type));
+  }
+  const native = nativeColumnDecoder();
+  if (native) {
+    return native(column.data, column.type);
+  }
+  const bytes = decodeBase64(column.data, column.type);
+  if (bytes.length % Constructor.BYTES_PER_ELEMENT !== 0) {
+    throw malformed(column.type);
+  }
+  return new Constructor(bytes.buffer, 0, bytes.length / Constructor.BYTES_PER_ELEMENT);
+};
+
+type DecodedColumn = {
+  values: ThreadForgeTypedArray;
+  dictionary?: readonly string[];
+};
+
+const ROW_INDEX = Symbol('threadforge.rowIndex');
+
+type RowView = { [ROW_INDEX]: number };
+
+/**
+ * A table produced by a worker with `nativeColumns.table()`: one typed array per column, with
+ * string columns dictionary-encoded. It crosses the bridge as a handful of column buffers instead
+ * of one JSON object per row.
+ *
+ * Rows are read through lightweight views whose properties look the value up in the columns on
+ * access. Use toArray() where plain row objects are needed.
+ */
+export class ThreadForgeTable<Row extends object = Record<string, unknown>> implements Iterable<Row> {
+  readonly length: number;
+  readonly columnNames: readonly string[];
+  private readonly columns = new Map<string, DecodedColumn>();
+  private readonly rowPrototype: object;
+
+  static isPacked(value: unknown): value is PackedTable {
+    return (
+      typeof value === 'object' &&
+      value !== null &&
+      (value as { __threadforgeTable?: unknown }).__threadforgeTable === 1 &&
+      Array.isArray((value as { columns?: unknown }).columns)
+    );
+  }
+
+  /**
+   * Decodes a packed table. Results that are a packed table are decoded automatically; use this
+   * for tables nested inside a larger result.
+   */
+  static from<Row extends object>(packed: PackedTable<Row>): ThreadForgeTable<Row> {
+    return new ThreadForgeTable<Row>(packed);
+  }
+
+  private constructor(packed: PackedTable<Row>) {
+    this.length = packed.length;
+    for (const column of packed.columns) {
+      const values = decodeColumn(column);
+      if (values.length !== packed.length) {
+        throw new Error(
+          `ThreadForge table column '${column.name}' has ${values.length} rows, expected ${packed.length}`,
+        );
+      }
+      this.columns.set(column.name, { values, dictionary: column.dictionary });
+    }
+    this.columnNames = Array.from(this.columns.keys());
+
+    const read = (index: number, name: string) => this.value(index, name as keyof Row);
+    const materialize = (index: number) => this.materialize(index);
+    const prototype: Record<string, unknown> = {
+      toJSON(this: RowView) {
+        return materialize(this[ROW_INDEX]);
+      },
+    };
+    for (const name of this.columnNames) {
+      Object.defineProperty(prototype, name, {
+        enumerable: true,
+        get(this: RowView) {
+          return read(this[ROW_INDEX], name);
+        },
+      });
+    }
+    this.rowPrototype = prototype;
+  }
+
+  /** The column's values; dictionary-encoded columns return their codes. */
+  column(name: keyof Row & string): ThreadForgeTypedArray {
+    return this.decoded(name).values;
+  }
+
+  /** The dictionary of a dictionary-encoded column, undefined for numeric ones. */
+  dictionary(name: keyof Row & string): readonly string[] | undefined {
+    return this.decoded(name).dictionary;
+  }
+
+  value<K extends keyof Row>(index: number, name: K): Row[K] {
+    const column = this.decoded(name as string);
+    const value = column.values[index];
+    if (value === undefined) {
+      return undefined as Row[K];
+    }
+    if (!column.dictionary) {
+      return value as Row[K];
+    }
+    // Missing strings carry the code type's all-ones value, which is never a dictionary index.
+    return (value < column.dictionary.length ? column.dictionary[value] : null) as Row[K];
+  }
+
+  /** A view of row `index`; its properties read the columns on access. */
+  row(index: number): Row {
+    if (!Number.isInteger(index) || index < 0 || index >= this.length) {
+      throw new RangeError(`Row ${index} is out of range for a table of ${this.length} rows`);
+    }
+    const view = Object.create(this.rowPrototype) as RowView;
+    view[ROW_INDEX] = index;
+    return view as unknown as Row;
+  }
+
+  *[Symbol.iterator](): Iterator<Row> {
+    for (let index = 0; index < this.length; index++) {
+      yield this.row(index);
+    }
+  }
+
+  /** Plain row objects, e.g. for APIs that copy their input anyway. */
+  toArray(): Row[] {
+    const rows: Row[] = new Array(this.length);
+    for (let index = 0; index < this.length; index++) {
+      rows[index] = this.materialize(index);
+    }
+    return rows;
+  }
+
+  toJSON(): Row[] {
+    return this.toArray();
+  }
+
+  private decoded(name: string): DecodedColumn {
+    const column = this.columns.get(name);
+    if (!column) {
+      throw new Error(`ThreadForge table has no column '${name}'`);
+    }
+    return column;
+  }
+
+  private materialize(index: number): Row {
+    const row: Record<string, unknown> = {};
+    for (const name of this.columnNames) {
+      row[name] = this.value(index, name as keyof Row);
+    }
+    return row as Row;
+  }
+}
+
+/** Decodes a result that is a packed table; anything else passes through untouched. */
+export const settleTable = <T>(value: unknown): T =>
+  (ThreadForgeTable.isPacked(value) ? ThreadForgeTable.from(value) : value) as T;
@@ -10,7 +10,7 @@ import {
   View,
 } from 'react-native';
 import SQLite, { SQLiteDatabase, Transaction } from 'react-native-sqlite-storage';
-import { TaskPriority, threadForge } from '../../packages/react-native-threadforge/src';
+import { TaskPriority, ThreadForgeTable, threadForge } from '../../packages/react-native-threadforge/src';
 import { createSqliteOrderBatchTask, type SqliteOrderRow } from '../tasks/sqlite';
 
 const useIsTestEnvironment = () =>
@@ -31,6 +31,7 @@ type Summary = {
 
 const TOTAL_BATCHES = 20;
 const BATCH_SIZE = 500;
+const DATABASE_NAME = 'threadforge-demo.db';
 
 const formatCurrency = (value: number) => {
   return new Intl.NumberFormat('en-US', { style: 'currency', currency: 'USD', maximumFractionDigits: 0 }).format(
@@ -79,7 +80,12 @@ const extractRowsFromContainer = (input: Record<string, unknown>): SqliteOrderRo
 };
 
 const normalizeBatchRows = (input: unknown): SqliteOrderRow[] => {
-  // Handle the ideal case where the worker already returned a materialized array.
+  // Packed columns from nativeColumns.table(); row views read the columns lazily.
+  if (input instanceof ThreadForgeTable) {
+    return Array.from(input as ThreadForgeTable<SqliteOrderRow>);
+  }
+
+  // Handle the case where the worker returned a materialized array (no native columns available).
   if (Array.isArray(input)) {
     return input as SqliteOrderRow[];
   }
@@ -132,7 +138,7 @@ export const SqliteBulkInsertScreen: React.FC<Props> = ({ onBack }) => {
       return dbRef.current;
     }
 
-    const database = await SQLite.openDatabase({ name: 'threadforge-demo.db', location: 'default' });
+    const database = await SQLite.openDatabase({ name: DATABASE_NAME, location: 'default' });
     dbRef.current = database;
     return database;
   }, [isTestEnv]);
@@ -195,10 +201,16 @@ export const SqliteBulkInsertScreen: React.FC<Props> = ({ onBack }) => {
           batchSize: BATCH_SIZE,
           batchIndex,
           totalBatches: TOTAL_BATCHES,
+          database: DATABASE_NAME,
         }),
         TaskPriority.HIGH,
       );
 
+      // Workers with nativeSqlite insert the batch themselves and only report the count.
+      if (rawRows && typeof rawRows === 'object' && 'inserted' in rawRows) {
+        return;
+      }
+
       // Normalize the raw worker response so downstream code always receives a strongly typed array of rows.
       const rows = normalizeBatchRows(rawRows);
 
@@ -5,19 +5,33 @@ type AnalyticsResult = string;
 export const createAnalyticsTask = (): ThreadTask<AnalyticsResult> => {
   const fn: ThreadTask<AnalyticsResult> = () => {
     const samples = 600_000;
-    let sum = 0;
-    let sumOfSquares = 0;
+    let values = new Float64Array(samples);
 
-    for (let i = 0; i < samples; i++) {
-      const value = Math.sin(i / 40) + Math.cos(i / 23);
-      sum += value;
-      sumOfSquares += value * value;
-      if (i % 120_000 === 0) {
-        globalThis.reportProgress?.(i / (samples * 2));
+    if (globalThis.nativeMath) {
+      values = globalThis.nativeMath.map('sin(x / 40) + cos(x / 23)', samples);
+    } else {
+      for (let i = 0; i < samples; i++) {
+        values[i] = Math.sin(i / 40) + Math.cos(i / 23);
+        if (i % 120_000 === 0) {
+          globalThis.reportProgress?.(i / (samples * 2));
+        }
       }
     }
 
-    const mean = sum / samples;
+    let mean: number;
+    let variance: number;
+    if (globalThis.nativeStats) {
+      ({ mean, variance } = globalThis.nativeStats.moments(values));
+    } else {
+      let sum = 0;
+      let sumOfSquares = 0;
+      for (let i = 0; i < samples; i++) {
+        sum += values[i];
+        sumOfSquares += values[i] * values[i];
+      }
+      mean = sum / samples;
+      variance = sumOfSquares / samples - mean * mean;
+    }
 
     let drift = 0;
     for (let i = 0; i < samples; i++) {
@@ -29,7 +43,6 @@ export const createAnalyticsTask = (): ThreadTask<AnalyticsResult> => {
       }
     }
 
-    const variance = sumOfSquares / samples - mean * mean;
     const stdDev = Math.sqrt(Math.max(variance, 0));
     globalThis.reportProgress?.(1);
     return `📊 mean=${mean.toFixed(4)} σ=${stdDev.toFixed(4)} drift=${drift.toFixed(2)}`;
@@ -38,17 +51,31 @@ export const createAnalyticsTask = (): ThreadTask<AnalyticsResult> => {
   return withThreadSource(fn, [
     '() => {',
     '  const samples = 600000;',
-    '  let sum = 0;',
-    '  let sumOfSquares = 0;',
-    '  for (let i = 0; i < samples; i++) {',
-    '    const value = Math.sin(i / 40) + Math.cos(i / 23);',
-    '    sum += value;',
-    '    sumOfSquares += value * value;',
-    '    if (i % 120000 === 0) {',
-    '      globalThis.reportProgress?.(i / (samples * 2));',
+    '  let values = new Float64Array(samples);',
+    '  if (globalThis.nativeMath) {',
+    "    values = globalThis.nativeMath.map('sin(x / 40) + cos(x / 23)', samples);",
+    '  } else {',
+    '    for (let i = 0; i < samples; i++) {',
+    '      values[i] = Math.sin(i / 40) + Math.cos(i / 23);',
+    '      if (i % 120000 === 0) {',
+    '        globalThis.reportProgress?.(i / (samples * 2));',
+    '      }',
+    '    }',
+    '  }',
+    '  let mean;',
+    '  let variance;',
+    '  if (globalThis.nativeStats) {',
+    '    ({ mean, variance } = globalThis.nativeStats.moments(values));',
+    '  } else {',
+    '    let sum = 0;',
+    '    let sumOfSquares = 0;',
+    '    for (let i = 0; i < samples; i++) {',
+    '      sum += values[i];',
+    '      sumOfSquares += values[i] * values[i];',
     '    }',
+    '    mean = sum / samples;',
+    '    variance = sumOfSquares / samples - mean * mean;',
     '  }',
-    '  const mean = sum / samples;',
     '  let drift = 0;',
     '  for (let i = 0; i < samples; i++) {',
     '    const trend = Math.sin((i + 1) / 55) + Math.cos((i + 5) / 37);',
@@ -58,7 +85,6 @@ export const createAnalyticsTask = (): ThreadTask<AnalyticsResult> => {
     '      globalThis.reportProgress?.(0.5 + offset);',
     '    }',
     '  }',
-    '  const variance = sumOfSquares / samples - mean * mean;',
     '  const stdDev = Math.sqrt(Math.max(variance, 0));',
     '  globalThis.reportProgress?.(1);',
     '  return `📊 mean=${mean.toFixed(4)} σ=${stdDev.toFixed(4)} drift=${drift.toFixed(2)}`;',
@@ -7,10 +7,14 @@ export const createHeavyMathTask = (): ThreadTask<HeavyMathResult> => {
     const iterations = 5_000_000;
     let accumulator = 0;
 
-    for (let i = 0; i < iterations; i++) {
-      accumulator += Math.sqrt(i);
-      if (i % 200_000 === 0) {
-        globalThis.reportProgress?.(i / iterations);
+    if (globalThis.nativeMath) {
+      accumulator = globalThis.nativeMath.sum('sqrt(x)', iterations);
+    } else {
+      for (let i = 0; i < iterations; i++) {
+        accumulator += Math.sqrt(i);
+        if (i % 200_000 === 0) {
+          globalThis.reportProgress?.(i / iterations);
+        }
       }
     }
 
@@ -22,10 +26,14 @@ export const createHeavyMathTask = (): ThreadTask<HeavyMathResult> => {
     '() => {',
     '  const iterations = 5000000;',
     '  let accumulator = 0;',
-    '  for (let i = 0; i < iterations; i++) {',
-    '    accumulator += Math.sqrt(i);',
-    '    if (i % 200000 === 0) {',
-    '      globalThis.reportProgress?.(i / iterations);',
+    '  if (globalThis.nativeMath) {',
+    "    accumulator = globalThis.nativeMath.sum('sqrt(x)', iterations);",
+    '  } else {',
+    '    for (let i = 0; i < iterations; i++) {',
+    '      accumulator += Math.sqrt(i);',
+    '      if (i % 200000 === 0) {',
+    '        globalThis.reportProgress?.(i / iterations);',
+    '      }',
     '    }',
     '  }',
     '  globalThis.reportProgress?.(1);',
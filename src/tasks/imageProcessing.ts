@@ -8,10 +8,14 @@ export const createImageProcessingTask = (): ThreadTask<ImageProcessingResult> =
     const pixels = 2_000_000;
     let transformed = 0;
 
-    for (let i = 0; i < pixels; i++) {
-      transformed += Math.sin(i) * Math.cos(i / 10);
-      if (i % 200_000 === 0) {
-        globalThis.reportProgress?.(i / pixels);
+    if (globalThis.nativeMath) {
+      transformed = globalThis.nativeMath.sum('sin(x) * cos(x / 10)', pixels);
+    } else {
+      for (let i = 0; i < pixels; i++) {
+        transformed += Math.sin(i) * Math.cos(i / 10);
+        if (i % 200_000 === 0) {
+          globalThis.reportProgress?.(i / pixels);
+        }
       }
     }
 
@@ -32,10 +36,14 @@ export const createImageProcessingTask = (): ThreadTask<ImageProcessingResult> =
     '  };',
     '  const pixels = 2000000;',
     '  let transformed = 0;',
-    '  for (let i = 0; i < pixels; i++) {',
-    '    transformed += Math.sin(i) * Math.cos(i / 10);',
-    '    if (i % 200000 === 0) {',
-    '      globalThis.reportProgress?.(i / pixels);',
+    '  if (globalThis.nativeMath) {',
+    "    transformed = globalThis.nativeMath.sum('sin(x) * cos(x / 10)', pixels);",
+    '  } else {',
+    '    for (let i = 0; i < pixels; i++) {',
+    '      transformed += Math.sin(i) * Math.cos(i / 10);',
+    '      if (i % 200000 === 0) {',
+    '        globalThis.reportProgress?.(i / pixels);',
+    '      }',
     '    }',
     '  }',
     '  globalThis.reportProgress?.(1);',
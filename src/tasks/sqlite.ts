@@ -1,3 +1,4 @@
+import type { PackedTable } from '../../packages/react-native-threadforge/src';
 import { ThreadTask, withThreadSource } from './threadHelpers';
 
 export type SqliteOrderRow = {
@@ -14,18 +15,30 @@ export type SqliteOrderBatchOptions = {
   batchSize: number;
   batchIndex: number;
   totalBatches: number;
+  // When set and the worker has nativeSqlite, the batch is inserted into this database's
+  // `orders` table from the worker instead of being returned.
+  database?: string;
 };
 
-export const createSqliteOrderBatchTask = (
-  options: SqliteOrderBatchOptions,
-): ThreadTask<SqliteOrderRow[]> => {
-  const fn: ThreadTask<SqliteOrderRow[]> = () => {
+export type SqliteInsertedBatch = { inserted: number };
+
+export type SqliteOrderBatchResult = SqliteOrderRow[] | PackedTable<SqliteOrderRow> | SqliteInsertedBatch;
+
+export const createSqliteOrderBatchTask = (options: SqliteOrderBatchOptions): ThreadTask<SqliteOrderBatchResult> => {
+  const fn: ThreadTask<SqliteOrderBatchResult> = () => {
     const batchSize = options.batchSize;
     const batchIndex = options.batchIndex;
     const totalBatches = options.totalBatches;
+    const database = options.database ?? null;
     const categories = ['Grocery', 'Electronics', 'Home', 'Books', 'Beauty', 'Outdoors'];
     const segments = ['Retail', 'Wholesale', 'Online', 'Enterprise'];
-    const rows: SqliteOrderRow[] = [];
+    const orderId = new Uint32Array(batchSize);
+    const customerId = new Uint16Array(batchSize);
+    const category = new Uint8Array(batchSize);
+    const segment = new Uint8Array(batchSize);
+    const createdMonth = new Uint8Array(batchSize);
+    const amount = new Float64Array(batchSize);
+    const margin = new Float64Array(batchSize);
     const baseSeed = (batchIndex + 1) * 17_317 + totalBatches * 7_919;
     let seed = baseSeed;
     const nextRandom = () => {
@@ -34,30 +47,86 @@ export const createSqliteOrderBatchTask = (
     };
 
     for (let index = 0; index < batchSize; index++) {
-      const orderId = batchIndex * batchSize + index + 1;
-      const customerId = Math.floor(nextRandom() * 3_500);
-      const category = categories[Math.floor(nextRandom() * categories.length)]!;
-      const segment = segments[Math.floor(nextRandom() * segments.length)]!;
+      orderId[index] = batchIndex * batchSize + index + 1;
+      customerId[index] = Math.floor(nextRandom() * 3_500);
+      category[index] = Math.floor(nextRandom() * categories.length);
+      segment[index] = Math.floor(nextRandom() * segments.length);
       const base = 25 + nextRandom() * 475;
-      const amount = Math.round(base * (segment === 'Wholesale' ? 0.9 : 1.1) * 100) / 100;
-      const margin = Math.round(amount * (0.2 + nextRandom() * 0.4) * 100) / 100;
-      const createdMonth = Math.floor(nextRandom() * 12);
-      rows.push({ orderId, customerId, category, segment, createdMonth, amount, margin });
+      amount[index] = Math.round(base * (segment[index] === 1 ? 0.9 : 1.1) * 100) / 100;
+      margin[index] = Math.round(amount[index]! * (0.2 + nextRandom() * 0.4) * 100) / 100;
+      createdMonth[index] = Math.floor(nextRandom() * 12);
+    }
+
+    // Insert straight from the worker; only the row count crosses the bridge.
+    if (database && globalThis.nativeSqlite) {
+      const db = globalThis.nativeSqlite.open(database);
+      try {
+        const params: Array<Array<number | string>> = [];
+        for (let index = 0; index < batchSize; index++) {
+          params.push([
+            orderId[index]!,
+            customerId[index]!,
+            categories[category[index]!]!,
+            segments[segment[index]!]!,
+            createdMonth[index]!,
+            amount[index]!,
+            margin[index]!,
+          ]);
+        }
+        db.prepare(
+          'INSERT INTO orders (orderId, customerId, category, segment, createdMonth, amount, margin) VALUES (?, ?, ?, ?, ?, ?, ?)',
+        ).runBatch(params);
+      } finally {
+        db.close();
+      }
+      return { inserted: batchSize };
+    }
+
+    // Packed columns cross to the UI thread as a few buffers instead of one object per row.
+    if (globalThis.nativeColumns) {
+      return globalThis.nativeColumns.table<SqliteOrderRow>({
+        orderId,
+        customerId,
+        category: { codes: category, dictionary: categories },
+        segment: { codes: segment, dictionary: segments },
+        createdMonth,
+        amount,
+        margin,
+      });
     }
 
+    const rows: SqliteOrderRow[] = [];
+    for (let index = 0; index < batchSize; index++) {
+      rows.push({
+        orderId: orderId[index]!,
+        customerId: customerId[index]!,
+        category: categories[category[index]!]!,
+        segment: segments[segment[index]!]!,
+        createdMonth: createdMonth[index]!,
+        amount: amount[index]!,
+        margin: margin[index]!,
+      });
+    }
     return rows;
   };
 
-  const { batchSize, batchIndex, totalBatches } = options;
+  const { batchSize, batchIndex, totalBatches, database } = options;
 
   return withThreadSource(fn, [
     '() => {',
     `  const batchSize = ${batchSize};`,
     `  const batchIndex = ${batchIndex};`,
     `  const totalBatches = ${totalBatches};`,
+    `  const database = ${JSON.stringify(database ?? null)};`,
     "  const categories = ['Grocery', 'Electronics', 'Home', 'Books', 'Beauty', 'Outdoors'];",
     "  const segments = ['Retail', 'Wholesale', 'Online', 'Enterprise'];",
-    '  const rows = [];',
+    '  const orderId = new Uint32Array(batchSize);',
+    '  const customerId = new Uint16Array(batchSize);',
+    '  const category = new Uint8Array(batchSize);',
+    '  const segment = new Uint8Array(batchSize);',
+    '  const createdMonth = new Uint8Array(batchSize);',
+    '  const amount = new Float64Array(batchSize);',
+    '  const margin = new Float64Array(batchSize);',
     '  const baseSeed = (batchIndex + 1) * 17317 + totalBatches * 7919;',
     '  let seed = baseSeed;',
     '  const nextRandom = () => {',
@@ -65,15 +134,60 @@ export const createSqliteOrderBatchTask = (
     '    return seed / 4294967295;',
     '  };',
     '  for (let index = 0; index < batchSize; index++) {',
-    '    const orderId = batchIndex * batchSize + index + 1;',
-    '    const customerId = Math.floor(nextRandom() * 3500);',
-    '    const category = categories[Math.floor(nextRandom() * categories.length)];',
-    '    const segment = segments[Math.floor(nextRandom() * segments.length)];',
+    '    orderId[index] = batchIndex * batchSize + index + 1;',
+    '    customerId[index] = Math.floor(nextRandom() * 3500);',
+    '    category[index] = Math.floor(nextRandom() * categories.length);',
+    '    segment[index] = Math.floor(nextRandom() * segments.length);',
     '    const base = 25 + nextRandom() * 475;',
-    "    const amount = Math.round(base * (segment === 'Wholesale' ? 0.9 : 1.1) * 100) / 100;",
-    '    const margin = Math.round(amount * (0.2 + nextRandom() * 0.4) * 100) / 100;',
-    '    const createdMonth = Math.floor(nextRandom() * 12);',
-    '    rows.push({ orderId, customerId, category, segment, createdMonth, amount, margin });',
+    '    amount[index] = Math.round(base * (segment[index] === 1 ? 0.9 : 1.1) * 100) / 100;',
+    '    margin[index] = Math.round(amount[index] * (0.2 + nextRandom() * 0.4) * 100) / 100;',
+    '    createdMonth[index] = Math.floor(nextRandom() * 12);',
+    '  }',
+    '  if (database && globalThis.nativeSqlite) {',
+    '    const db = globalThis.nativeSqlite.open(database);',
+    '    try {',
+    '      const params = [];',
+    '      for (let index = 0; index < batchSize; index++) {',
+    '        params.push([',
+    '          orderId[index],',
+    '          customerId[index],',
+    '          categories[category[index]],',
+    '          segments[segment[index]],',
+    '          createdMonth[index],',
+    '          amount[index],',
+    '          margin[index],',
+    '        ]);',
+    '      }',
+    '      db.prepare(',
+    "        'INSERT INTO orders (orderId, customerId, category, segment, createdMonth, amount, margin) VALUES (?, ?, ?, ?, ?, ?, ?)',",
+    '      ).runBatch(params);',
+    '    } finally {',
+    '      db.close();',
+    '    }',
+    '    return { inserted: batchSize };',
+    '  }',
+    '  if (globalThis.nativeColumns) {',
+    '    return globalThis.nativeColumns.table({',
+    '      orderId,',
+    '      customerId,',
+    '      category: { codes: category, dictionary: categories },',
+    '      segment: { codes: segment, dictionary: segments },',
+    '      createdMonth,',
+    '      amount,',
+    '      margin,',
+    '    });',
+    '  }',
+    '  const rows = [];',
+    '  for (let index = 0; index < batchSize; index++) {',
+    '    rows.push({',
+    '      orderId: orderId[index],',
+    '      customerId: customerId[index],',
+    '      category: categories[category[index]],',
+    '      segment: segments[segment[index]],',
+    '      createdMonth: createdMonth[index],',
+    '      amount: amount[index],',
+    '      margin: margin[index],',
+    '    });',
     '  }',
     '  return rows;',
     '}',
@@ -87,7 +201,14 @@ export const createSqliteHeavyOperationsTask = (): ThreadTask<SqliteReportResult
     const totalOrders = 120_000;
     const categories = ['Grocery', 'Electronics', 'Home', 'Books', 'Beauty', 'Outdoors'];
     const segments = ['Retail', 'Wholesale', 'Online', 'Enterprise'];
-    const orders: SqliteOrderRow[] = [];
+    const customerCount = 3_500;
+    const customer = new Uint16Array(totalOrders);
+    const category = new Uint8Array(totalOrders);
+    const segment = new Uint8Array(totalOrders);
+    const month = new Uint8Array(totalOrders);
+    const monthBit = new Uint16Array(totalOrders);
+    const amount = new Float64Array(totalOrders);
+    const margin = new Float64Array(totalOrders);
 
     let seed = 42;
     const nextRandom = () => {
@@ -96,57 +217,80 @@ export const createSqliteHeavyOperationsTask = (): ThreadTask<SqliteReportResult
     };
 
     for (let i = 0; i < totalOrders; i++) {
-      const customerId = Math.floor(nextRandom() * 3_500);
-      const category = categories[Math.floor(nextRandom() * categories.length)]!;
-      const segment = segments[Math.floor(nextRandom() * segments.length)]!;
+      customer[i] = Math.floor(nextRandom() * customerCount);
+      category[i] = Math.floor(nextRandom() * categories.length);
+      segment[i] = Math.floor(nextRandom() * segments.length);
       const base = 25 + nextRandom() * 475;
-      const amount = Math.round(base * (segment === 'Wholesale' ? 0.85 : 1.12) * 100) / 100;
-      const margin = Math.round(amount * (0.22 + nextRandom() * 0.38) * 100) / 100;
-      const createdMonth = Math.floor(nextRandom() * 12);
-      orders.push({
-        orderId: i + 1,
-        customerId,
-        category,
-        amount,
-        margin,
-        createdMonth,
-        segment,
-      });
+      amount[i] = Math.round(base * (segment[i] === 1 ? 0.85 : 1.12) * 100) / 100;
+      margin[i] = Math.round(amount[i]! * (0.22 + nextRandom() * 0.38) * 100) / 100;
+      month[i] = Math.floor(nextRandom() * 12);
+      monthBit[i] = 1 << month[i]!;
       if (i % 20_000 === 0 && i > 0) {
         globalThis.reportProgress?.(i / (totalOrders * 3));
       }
     }
 
-    const categoryTotals = new Map<string, number>();
-    const segmentMargins = new Map<string, number>();
-    const monthlyRevenue = Array.from({ length: 12 }, () => 0);
-    const customerVisitMask = new Map<number, number>();
+    const categoryTotals = new Array<number>(categories.length).fill(0);
+    const segmentMargins = new Array<number>(segments.length).fill(0);
+    const monthlyRevenue = new Array<number>(12).fill(0);
+    let masks: number[] = [];
 
-    for (let i = 0; i < orders.length; i++) {
-      const order = orders[i]!;
-      categoryTotals.set(order.category, (categoryTotals.get(order.category) ?? 0) + order.amount);
-      segmentMargins.set(order.segment, (segmentMargins.get(order.segment) ?? 0) + order.margin);
-      monthlyRevenue[order.createdMonth] += order.amount;
-      const mask = customerVisitMask.get(order.customerId) ?? 0;
-      customerVisitMask.set(order.customerId, mask | (1 << order.createdMonth));
-      if (i % 20_000 === 0 && i > 0) {
-        globalThis.reportProgress?.(1 / 3 + i / (orders.length * 3));
+    if (globalThis.nativeColumns) {
+      const columns = { category, segment, month, customer, monthBit, amount, margin };
+      const fill = (target: number[], groupBy: string, aggregate: [string, string]) => {
+        const { keys, values } = globalThis.nativeColumns!.aggregate({
+          columns,
+          groupBy: [groupBy],
+          aggregates: { total: aggregate },
+        });
+        const groupKeys = keys[groupBy] as Float64Array;
+        for (let g = 0; g < groupKeys.length; g++) {
+          target[groupKeys[g]!] = values.total![g]!;
+        }
+      };
+      fill(categoryTotals, 'category', ['sum', 'amount']);
+      fill(segmentMargins, 'segment', ['sum', 'margin']);
+      fill(monthlyRevenue, 'month', ['sum', 'amount']);
+      globalThis.reportProgress?.(2 / 3);
+      const visits = globalThis.nativeColumns.aggregate({
+        columns,
+        groupBy: ['customer'],
+        aggregates: { mask: ['or', 'monthBit'] },
+      });
+      masks = Array.from(visits.values.mask!);
+    } else {
+      const customerMasks = new Uint16Array(customerCount);
+      for (let i = 0; i < totalOrders; i++) {
+        categoryTotals[category[i]!] += amount[i]!;
+        segmentMargins[segment[i]!] += margin[i]!;
+        monthlyRevenue[month[i]!] += amount[i]!;
+        customerMasks[customer[i]!] |= monthBit[i]!;
+        if (i % 20_000 === 0 && i > 0) {
+          globalThis.reportProgress?.(1 / 3 + i / (totalOrders * 3));
+        }
       }
+      masks = Array.from(customerMasks).filter((mask) => mask !== 0);
     }
 
-    const topCategories = Array.from(categoryTotals.entries())
-      .sort((a, b) => b[1] - a[1])
-      .slice(0, 3);
+    const ranked = (names: string[], totals: number[]) => {
+      const top = globalThis.nativeSort
+        ? Array.from(globalThis.nativeSort.topK(totals, 3))
+        : totals
+            .map((_, index) => index)
+            .sort((a, b) => totals[b]! - totals[a]!)
+            .slice(0, 3);
+      return top
+        .filter((index) => totals[index]! > 0)
+        .map((index): [string, number] => [names[index]!, totals[index]!]);
+    };
 
-    const topSegments = Array.from(segmentMargins.entries())
-      .sort((a, b) => b[1] - a[1])
-      .slice(0, 3);
+    const topCategories = ranked(categories, categoryTotals);
+    const topSegments = ranked(segments, segmentMargins);
 
     const peakMonthIndex = monthlyRevenue.reduce((bestIndex, value, index, array) => {
       return value > array[bestIndex]! ? index : bestIndex;
     }, 0);
 
-    const masks = Array.from(customerVisitMask.values());
     const totalCustomers = masks.length;
     let returningCustomers = 0;
     let loyalCustomers = 0;
@@ -198,54 +342,91 @@ export const createSqliteHeavyOperationsTask = (): ThreadTask<SqliteReportResult
 
   return withThreadSource(fn, [
     '() => {',
-    "  const totalOrders = 120000;",
+    '  const totalOrders = 120000;',
     "  const categories = ['Grocery', 'Electronics', 'Home', 'Books', 'Beauty', 'Outdoors'];",
     "  const segments = ['Retail', 'Wholesale', 'Online', 'Enterprise'];",
-    '  const orders = [];',
+    '  const customerCount = 3500;',
+    '  const customer = new Uint16Array(totalOrders);',
+    '  const category = new Uint8Array(totalOrders);',
+    '  const segment = new Uint8Array(totalOrders);',
+    '  const month = new Uint8Array(totalOrders);',
+    '  const monthBit = new Uint16Array(totalOrders);',
+    '  const amount = new Float64Array(totalOrders);',
+    '  const margin = new Float64Array(totalOrders);',
     '  let seed = 42;',
     '  const nextRandom = () => {',
     '    seed = (seed * 1664525 + 1013904223) >>> 0;',
     '    return seed / 4294967295;',
     '  };',
     '  for (let i = 0; i < totalOrders; i++) {',
-    '    const orderId = i + 1;',
-    '    const customerId = Math.floor(nextRandom() * 3500);',
-    '    const category = categories[Math.floor(nextRandom() * categories.length)];',
-    '    const segment = segments[Math.floor(nextRandom() * segments.length)];',
+    '    customer[i] = Math.floor(nextRandom() * customerCount);',
+    '    category[i] = Math.floor(nextRandom() * categories.length);',
+    '    segment[i] = Math.floor(nextRandom() * segments.length);',
     '    const base = 25 + nextRandom() * 475;',
-    "    const amount = Math.round(base * (segment === 'Wholesale' ? 0.85 : 1.12) * 100) / 100;",
-    '    const margin = Math.round(amount * (0.22 + nextRandom() * 0.38) * 100) / 100;',
-    '    const createdMonth = Math.floor(nextRandom() * 12);',
-    '    orders.push({ orderId, customerId, category, amount, margin, createdMonth, segment });',
+    '    amount[i] = Math.round(base * (segment[i] === 1 ? 0.85 : 1.12) * 100) / 100;',
+    '    margin[i] = Math.round(amount[i] * (0.22 + nextRandom() * 0.38) * 100) / 100;',
+    '    month[i] = Math.floor(nextRandom() * 12);',
+    '    monthBit[i] = 1 << month[i];',
     '    if (i % 20000 === 0 && i > 0) {',
     '      globalThis.reportProgress?.(i / (totalOrders * 3));',
     '    }',
     '  }',
-    '  const categoryTotals = new Map();',
-    '  const segmentMargins = new Map();',
-    '  const monthlyRevenue = Array.from({ length: 12 }, () => 0);',
-    '  const customerVisitMask = new Map();',
-    '  for (let i = 0; i < orders.length; i++) {',
-    '    const order = orders[i];',
-    '    categoryTotals.set(order.category, (categoryTotals.get(order.category) ?? 0) + order.amount);',
-    '    segmentMargins.set(order.segment, (segmentMargins.get(order.segment) ?? 0) + order.margin);',
-    '    monthlyRevenue[order.createdMonth] += order.amount;',
-    '    const mask = customerVisitMask.get(order.customerId) ?? 0;',
-    '    customerVisitMask.set(order.customerId, mask | (1 << order.createdMonth));',
-    '    if (i % 20000 === 0 && i > 0) {',
-    '      globalThis.reportProgress?.(1 / 3 + i / (orders.length * 3));',
+    '  const categoryTotals = new Array(categories.length).fill(0);',
+    '  const segmentMargins = new Array(segments.length).fill(0);',
+    '  const monthlyRevenue = new Array(12).fill(0);',
+    '  let masks = [];',
+    '  if (globalThis.nativeColumns) {',
+    '    const columns = { category, segment, month, customer, monthBit, amount, margin };',
+    '    const fill = (target, groupBy, aggregate) => {',
+    '      const { keys, values } = globalThis.nativeColumns.aggregate({',
+    '        columns,',
+    '        groupBy: [groupBy],',
+    '        aggregates: { total: aggregate },',
+    '      });',
+    '      const groupKeys = keys[groupBy];',
+    '      for (let g = 0; g < groupKeys.length; g++) {',
+    '        target[groupKeys[g]] = values.total[g];',
+    '      }',
+    '    };',
+    "    fill(categoryTotals, 'category', ['sum', 'amount']);",
+    "    fill(segmentMargins, 'segment', ['sum', 'margin']);",
+    "    fill(monthlyRevenue, 'month', ['sum', 'amount']);",
+    '    globalThis.reportProgress?.(2 / 3);',
+    '    const visits = globalThis.nativeColumns.aggregate({',
+    '      columns,',
+    "      groupBy: ['customer'],",
+    "      aggregates: { mask: ['or', 'monthBit'] },",
+    '    });',
+    '    masks = Array.from(visits.values.mask);',
+    '  } else {',
+    '    const customerMasks = new Uint16Array(customerCount);',
+    '    for (let i = 0; i < totalOrders; i++) {',
+    '      categoryTotals[category[i]] += amount[i];',
+    '      segmentMargins[segment[i]] += margin[i];',
+    '      monthlyRevenue[month[i]] += amount[i];',
+    '      customerMasks[customer[i]] |= monthBit[i];',
+    '      if (i % 20000 === 0 && i > 0) {',
+    '        globalThis.reportProgress?.(1 / 3 + i / (totalOrders * 3));',
+    '      }',
     '    }',
+    '    masks = Array.from(customerMasks).filter((mask) => mask !== 0);',
     '  }',
-    '  const topCategories = Array.from(categoryTotals.entries())',
-    '    .sort((a, b) => b[1] - a[1])',
-    '    .slice(0, 3);',
-    '  const topSegments = Array.from(segmentMargins.entries())',
-    '    .sort((a, b) => b[1] - a[1])',
-    '    .slice(0, 3);',
+    '  const ranked = (names, totals) => {',
+    '    const top = globalThis.nativeSort',
+    '      ? Array.from(globalThis.nativeSort.topK(totals, 3))',
+    '      : totals',
+    '          .map((_, index) => index)',
+    '          .sort((a, b) => totals[b] - totals[a])',
+    '          .slice(0, 3);',
+    '    return top',
+    '      .filter((index) => totals[index] > 0)',
+    '      .map((index) => [names[index], totals[index]]);',
+    '  };',
+    '  const topCategories = ranked(categories, categoryTotals);',
+    '  const topSegments = ranked(segments, segmentMargins);',
     '  const peakMonthIndex = monthlyRevenue.reduce((bestIndex, value, index, array) => {',
     '    return value > array[bestIndex] ? index : bestIndex;',
     '  }, 0);',
-    '  const masks = Array.from(customerVisitMask.values());',
     '  const totalCustomers = masks.length;',
     '  let returningCustomers = 0;',
     '  let loyalCustomers = 0;',
@@ -271,7 +452,7 @@ export const createSqliteHeavyOperationsTask = (): ThreadTask<SqliteReportResult
     '    }',
     '  }',
     '  const formatPairs = (entries, prefix) => {',
-    "    if (entries.length === 0) {",
+    '    if (entries.length === 0) {',
     "      return '—';",
     '    }',
     '    return entries',
@@ -282,12 +463,11 @@ export const createSqliteHeavyOperationsTask = (): ThreadTask<SqliteReportResult
     '  const loyalRate = totalCustomers === 0 ? 0 : (loyalCustomers / totalCustomers) * 100;',
     '  globalThis.reportProgress?.(1);',
     '  return [',
-    "    `🏬 Categories: ${formatPairs(topCategories, '$')}`",
-    "    `🏢 Segments: ${formatPairs(topSegments, '$')}`",
-    "    `📅 Peak month: M${peakMonthIndex + 1} (${monthlyRevenue[peakMonthIndex].toFixed(0)})`",
-    "    `🔁 Repeat: ${repeatRate.toFixed(1)}% loyal: ${loyalRate.toFixed(1)}%`",
+    "    `🏬 Categories: ${formatPairs(topCategories, '$')}`,",
+    "    `🏢 Segments: ${formatPairs(topSegments, '$')}`,",
+    '    `📅 Peak month: M${peakMonthIndex + 1} (${monthlyRevenue[peakMonthIndex].toFixed(0)})`,',
+    '    `🔁 Repeat: ${repeatRate.toFixed(1)}% loyal: ${loyalRate.toFixed(1)}%`,',
     "  ].join(' | ');",
     '}',
   ]);
 };
-
@@ -1,3 +1,5 @@
+import type { PackedTable } from '../../packages/react-native-threadforge/src';
+
 export type ThreadTask<T> = (() => T) & { __threadforgeSource?: string };
 
 export const withThreadSource = <T>(fn: ThreadTask<T>, sourceLines: string[]): ThreadTask<T> => {
@@ -9,8 +11,252 @@ export const withThreadSource = <T>(fn: ThreadTask<T>, sourceLines: string[]): T
   return fn;
 };
 
+type NativeMathOptions<Out = Float64Array | Float32Array> = {
+  y?: Float64Array | Float32Array;
+  out?: Out;
+  accuracy?: 'fast' | 'high' | 'strict';
+};
+
+type NativeColumn =
+  | Float64Array
+  | Float32Array
+  | Int32Array
+  | Uint32Array
+  | Int16Array
+  | Uint16Array
+  | Int8Array
+  | Uint8Array
+  | { codes: Uint8Array | Uint16Array | Uint32Array; dictionary: string[] };
+
+type NativeNumericColumn = Exclude<NativeColumn, { codes: unknown }>;
+
+type NativeIngestOptions = {
+  // CSV only.
+  delimiter?: string;
+  header?: boolean;
+  columns?: string[];
+  types?: Record<string, 'float64' | 'float32' | 'int32' | 'string'>;
+  inferRows?: number;
+};
+type NativeIngestedTable = {
+  rows: number;
+  // Missing strings have code 0xffffffff.
+  columns: Record<string, Float64Array | Float32Array | Int32Array | { codes: Uint32Array; dictionary: string[] }>;
+};
+
+type SqliteValue = number | string | boolean | null | ArrayBuffer | Uint8Array;
+type SqliteParams = SqliteValue[] | Record<string, SqliteValue>;
+type SqliteRow = Record<string, number | string | Uint8Array | null>;
+type SqliteRunResult = { changes: number; lastInsertRowId: number };
+
+type NativeSqliteStatement = {
+  run(params?: SqliteParams): SqliteRunResult;
+  // All parameter sets in one transaction.
+  runBatch(params: SqliteParams[]): SqliteRunResult;
+  all(params?: SqliteParams): SqliteRow[];
+  get(params?: SqliteParams): SqliteRow | undefined;
+  // Streams rows: next() returns up to `count` rows (256 by default), an empty array once done.
+  iterate(params?: SqliteParams): { next(count?: number): SqliteRow[]; close(): void };
+  columns(): string[];
+  finalize(): void;
+};
+
+type NativeSqliteDatabase = {
+  readonly path: string;
+  exec(sql: string): void;
+  prepare(sql: string): NativeSqliteStatement;
+  run(sql: string, params?: SqliteParams): SqliteRunResult;
+  all(sql: string, params?: SqliteParams): SqliteRow[];
+  get(sql: string, params?: SqliteParams): SqliteRow | undefined;
+  transaction<T>(fn: () => T): T;
+  close(): void;
+};
+
+type FileData = string | ArrayBuffer | ArrayBufferView;
+
+type NativeFileReader<Item> = {
+  // Total bytes, and how many of them next() has consumed.
+  readonly size: number;
+  position(): number;
+  next(count?: number): Item;
+  close(): void;
+};
+
+type NativeIoBatch<Item> = {
+  readonly size: number;
+  done(): boolean;
+  // Blocks until every request settles; undefined if timeoutMs passes first. Throws if any failed.
+  wait(timeoutMs?: number): Item[] | undefined;
+  // Same, with an Error in place of each failed request.
+  settle(timeoutMs?: number): Array<Item | Error> | undefined;
+};
+
+type CompressionCodec = 'gzip' | 'zlib' | 'deflate' | 'lz4';
+
+type NativeCompressionStream = {
+  // Output that is ready so far; may be empty while input is buffered.
+  write(data: FileData): Uint8Array;
+  finish(): Uint8Array;
+};
+
+type HashAlgorithm = 'xxh32' | 'xxh64' | 'crc32c' | 'sha256' | 'blake3';
+
+type NativeHasher = {
+  update(data: FileData): NativeHasher;
+  // Digest of everything so far; more updates may follow.
+  digest(options?: { encoding?: 'hex' }): string;
+  digest(options: { encoding: 'bytes' }): Uint8Array;
+  reset(): void;
+};
+
 declare global {
   // ThreadForge injects a global `reportProgress` function inside worker contexts.
   // We declare it here so TypeScript understands the symbol.
   var reportProgress: ((progress: number) => void) | undefined;
+  // Vectorized reductions over typed arrays, also injected into worker contexts.
+  var nativeStats:
+    | {
+        sum(values: Float64Array | Float32Array | number[]): number;
+        moments(values: Float64Array | Float32Array | number[]): {
+          count: number;
+          mean: number;
+          variance: number;
+          sampleVariance: number;
+          stdDev: number;
+        };
+      }
+    | undefined;
+  // Fused elementwise math over typed arrays or an index range, also injected into worker contexts.
+  var nativeMath:
+    | {
+        map(expression: string, input: Float32Array, options?: NativeMathOptions<Float32Array>): Float32Array;
+        map(expression: string, input: Float64Array | number, options?: NativeMathOptions<Float64Array>): Float64Array;
+        sum(expression: string, input: Float64Array | Float32Array | number, options?: NativeMathOptions): number;
+      }
+    | undefined;
+  // Columnar filter / group-by / aggregate over typed-array columns, also injected into worker contexts.
+  var nativeColumns:
+    | {
+        aggregate(query: {
+          columns: Record<string, NativeColumn>;
+          where?: Array<[string, string, number | string]>;
+          groupBy?: string[];
+          aggregates: Record<string, 'count' | [string, string]>;
+        }): {
+          groups: number;
+          keys: Record<string, Float64Array | Array<string | null>>;
+          values: Record<string, Float64Array>;
+        };
+        encode(strings: string[]): { codes: Uint32Array; dictionary: string[] };
+        // Arrives on the UI thread as a ThreadForgeTable<Row>.
+        table<Row extends object>(columns: Record<string, NativeColumn | string[] | number[]>): PackedTable<Row>;
+        // source is a file path or the raw bytes.
+        readCsv(source: string | ArrayBuffer | ArrayBufferView, options?: NativeIngestOptions): NativeIngestedTable;
+        readNdjson(source: string | ArrayBuffer | ArrayBufferView, options?: NativeIngestOptions): NativeIngestedTable;
+      }
+    | undefined;
+  // SQLite connections opened from worker JS, also injected into worker contexts when the build links SQLite.
+  var nativeSqlite:
+    | {
+        open(name: string, options?: { readOnly?: boolean; create?: boolean }): NativeSqliteDatabase;
+      }
+    | undefined;
+  // Memory-mapped reads and atomic writes inside the app's documents and cache directories, also
+  // injected into worker contexts. Relative paths resolve against `roots.documents`.
+  var nativeFiles:
+    | {
+        readonly roots: Record<string, string>;
+        resolve(path: string): string;
+        stat(path: string): { exists: boolean; directory: boolean; size: number; modified: number };
+        // Zero-copy, copy-on-write view of the file; writes never reach it.
+        map(path: string, options?: { offset?: number; length?: number }): ArrayBuffer;
+        readText(path: string): string;
+        // next() returns up to `count` lines (1024 by default), an empty array once done.
+        lines(path: string): NativeFileReader<string[]>;
+        // next() returns the next mapped chunk (1 MiB by default), null once done.
+        chunks(path: string, chunkSize?: number): NativeFileReader<Uint8Array | null>;
+        writeFile(path: string, data: FileData): number;
+        appendFile(path: string, data: FileData): number;
+        // A fresh file only replaces the old one on commit().
+        createWriter(
+          path: string,
+          options?: { append?: boolean },
+        ): { write(data: FileData): number; commit(): number; abandon(): void };
+      }
+    | undefined;
+  // Batched reads and writes that run while the worker keeps computing (io_uring on Linux, I/O
+  // threads elsewhere), also injected into worker contexts. Paths follow nativeFiles' roots.
+  var nativeIO:
+    | {
+        backend(): 'io_uring' | 'threads';
+        read(requests: Array<string | { path: string; offset?: number; length?: number }>): NativeIoBatch<Uint8Array>;
+        read(
+          requests: Array<string | { path: string; offset?: number; length?: number }>,
+          options: { text: true },
+        ): NativeIoBatch<string>;
+        write(
+          requests: Array<{ path: string; data: FileData; mode?: 'replace' | 'append' | 'overwrite'; offset?: number }>,
+        ): NativeIoBatch<number>;
+      }
+    | undefined;
+  // gzip / zlib / raw deflate and LZ4 frames, also injected into worker contexts. Large inputs
+  // compress in parallel chunks; decompression stops past maxSize (1 GiB by default).
+  var nativeCompression:
+    | {
+        compress(data: FileData, options?: { codec?: CompressionCodec; level?: number }): Uint8Array;
+        decompress(data: FileData, options?: { codec?: CompressionCodec; maxSize?: number }): Uint8Array;
+        decompress(data: FileData, options: { codec?: CompressionCodec; maxSize?: number; text: true }): string;
+        createCompressor(options?: { codec?: CompressionCodec; level?: number }): NativeCompressionStream;
+        createDecompressor(options?: { codec?: CompressionCodec; maxSize?: number }): NativeCompressionStream;
+        compressFile(
+          source: string,
+          destination: string,
+          options?: { codec?: CompressionCodec; level?: number },
+        ): { inputBytes: number; outputBytes: number };
+        decompressFile(
+          source: string,
+          destination: string,
+          options?: { codec?: CompressionCodec; maxSize?: number },
+        ): { inputBytes: number; outputBytes: number };
+      }
+    | undefined;
+  // xxHash, CRC32C, SHA-256 and BLAKE3, also injected into worker contexts. Digests are hex
+  // strings unless { encoding: 'bytes' }; seed applies to the xxHash functions.
+  var nativeHash:
+    | {
+        hash(algorithm: HashAlgorithm, data: FileData, options?: { seed?: number; encoding?: 'hex' }): string;
+        hash(algorithm: HashAlgorithm, data: FileData, options: { seed?: number; encoding: 'bytes' }): Uint8Array;
+        hashFile(algorithm: HashAlgorithm, path: string, options?: { seed?: number; encoding?: 'hex' }): string;
+        hashFile(algorithm: HashAlgorithm, path: string, options: { seed?: number; encoding: 'bytes' }): Uint8Array;
+        createHasher(algorithm: HashAlgorithm, options?: { seed?: number }): NativeHasher;
+        implementation(algorithm: HashAlgorithm): 'sse4.2' | 'armv8-crc' | 'sha-ni' | 'armv8-sha2' | 'portable';
+      }
+    | undefined;
+  // base64, hex and UTF-8/UTF-16 codecs, also injected into worker contexts (with TextEncoder and
+  // TextDecoder when the engine lacks them). Decoders throw on malformed input.
+  var nativeEncoding:
+    | {
+        base64Encode(data: FileData, options?: { alphabet?: 'base64' | 'base64url'; omitPadding?: boolean }): string;
+        base64Decode(text: string, options?: { alphabet?: 'base64' | 'base64url' }): Uint8Array;
+        hexEncode(data: FileData): string;
+        hexDecode(text: string): Uint8Array;
+        isUtf8(data: ArrayBuffer | ArrayBufferView): boolean;
+        utf8ToUtf16(data: ArrayBuffer | ArrayBufferView): Uint16Array;
+        utf16ToUtf8(units: Uint16Array): Uint8Array;
+        implementation(): 'ssse3' | 'neon' | 'scalar';
+      }
+    | undefined;
+  // Parallel radix / merge sorts, argsort and top-K selection, also injected into worker contexts.
+  // Orders are row indices; NaN sorts last.
+  var nativeSort:
+    | {
+        sort<T extends NativeNumericColumn>(values: T, options?: { descending?: boolean }): T;
+        argsort(values: NativeNumericColumn | number[], options?: { descending?: boolean }): Uint32Array;
+        topK(values: NativeNumericColumn | number[], k: number, options?: { descending?: boolean }): Uint32Array;
+        sortBy(
+          columns: Record<string, NativeColumn | string[] | number[]>,
+          by: Array<string | [string, 'asc' | 'desc']>,
+        ): Uint32Array;
+      }
+    | undefined;
 }